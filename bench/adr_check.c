@@ -0,0 +1,115 @@
+#include <stdio.h>
+
+#include "akita_adr.h"
+#include "akita_airtime.h"
+#include "bench_support.h"
+
+static uint32_t akita_check_airtime_us(const akita_adr_setting_t *setting, size_t payload_len) {
+    akita_lora_modem_t modem = {
+        .spreading_factor = setting->spreading_factor,
+        .coding_rate = 5U,
+        .preamble_len = 8U,
+        .bandwidth_hz = setting->bandwidth_hz,
+        .crc_on = true,
+    };
+    return akita_airtime_us(&modem, payload_len);
+}
+
+static int akita_check_close_range(void) {
+    const akita_adr_setting_t base = {.spreading_factor = 12U, .bandwidth_hz = 125000U, .tx_power_dbm = 17};
+    akita_adr_t adr;
+    uint32_t slow_us;
+    uint32_t fast_us;
+    size_t index;
+
+    akita_adr_init(&adr, &base, AKITA_LORA_REGION_EU868);
+
+    /* Nothing moves until a full window of good samples has been seen. */
+    for (index = 0; index + 1U < AKITA_ADR_HISTORY_LEN; ++index) {
+        AKITA_CHECK(!akita_adr_on_feedback(&adr, 60));
+    }
+    AKITA_CHECK(akita_adr_on_feedback(&adr, 60));
+
+    /* 15 dB SNR leaves room for SF7, the widest EU868 channel and 6 dB less power. */
+    AKITA_CHECK(adr.current.spreading_factor == 7U);
+    AKITA_CHECK(adr.current.bandwidth_hz == 250000U);
+    AKITA_CHECK(adr.current.tx_power_dbm == 11);
+    AKITA_CHECK(adr.steps_faster == 1U);
+
+    slow_us = akita_check_airtime_us(&base, 40U);
+    fast_us = akita_check_airtime_us(&adr.current, 40U);
+    AKITA_CHECK(fast_us * 40U < slow_us);
+    printf("close range: SF12/125k %lu us -> SF7/250k %lu us per 40-byte frame\n",
+           (unsigned long) slow_us,
+           (unsigned long) fast_us);
+
+    /* One weak sample restores power before touching the data rate. */
+    AKITA_CHECK(akita_adr_on_feedback(&adr, -10));
+    AKITA_CHECK(adr.current.tx_power_dbm == 17);
+    AKITA_CHECK(adr.current.spreading_factor == 7U);
+    AKITA_CHECK(adr.current.bandwidth_hz == 250000U);
+    AKITA_CHECK(adr.steps_slower == 1U);
+    return 0;
+}
+
+static int akita_check_link_loss(void) {
+    const akita_adr_setting_t base = {.spreading_factor = 7U, .bandwidth_hz = 125000U, .tx_power_dbm = 17};
+    const akita_adr_setting_t fast = {.spreading_factor = 7U, .bandwidth_hz = 250000U, .tx_power_dbm = 17};
+    akita_adr_t adr;
+    uint16_t uplink;
+
+    akita_adr_init(&adr, &base, AKITA_LORA_REGION_EU868);
+    adr.current = fast;
+
+    for (uplink = 1U; uplink < AKITA_ADR_ACK_LIMIT; ++uplink) {
+        AKITA_CHECK(!akita_adr_on_uplink(&adr));
+    }
+    AKITA_CHECK(akita_adr_on_uplink(&adr));
+    AKITA_CHECK(adr.current.bandwidth_hz == 125000U);
+
+    for (uplink = 1U; uplink < AKITA_ADR_ACK_DELAY; ++uplink) {
+        AKITA_CHECK(!akita_adr_on_uplink(&adr));
+    }
+    AKITA_CHECK(akita_adr_on_uplink(&adr));
+    AKITA_CHECK(adr.current.spreading_factor == 8U);
+
+    /* Any feedback resets the link-loss counter. */
+    (void) akita_adr_on_feedback(&adr, 0);
+    AKITA_CHECK(adr.uplinks_since_feedback == 0U);
+    return 0;
+}
+
+static int akita_check_region_limits(void) {
+    const akita_adr_setting_t base = {.spreading_factor = 7U, .bandwidth_hz = 125000U, .tx_power_dbm = 14};
+    akita_adr_t adr;
+    size_t index;
+
+    akita_adr_init(&adr, &base, AKITA_LORA_REGION_US915);
+    AKITA_CHECK(adr.max_spreading_factor == 10U);
+    AKITA_CHECK(adr.max_bandwidth_hz == 500000U);
+    AKITA_CHECK(adr.max_tx_power_dbm == 14);
+
+    /* A hopeless link walks down to the slowest rate the dwell limit allows, and stops there. */
+    for (index = 0; index < 8U; ++index) {
+        (void) akita_adr_on_feedback(&adr, -80);
+    }
+    AKITA_CHECK(adr.current.spreading_factor == 10U);
+    AKITA_CHECK(adr.current.bandwidth_hz == 125000U);
+    AKITA_CHECK(adr.current.tx_power_dbm == 14);
+    AKITA_CHECK(!akita_adr_on_feedback(&adr, -80));
+
+    AKITA_CHECK(akita_adr_required_snr_qdb(7U) == -30);
+    AKITA_CHECK(akita_adr_required_snr_qdb(12U) == -80);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_close_range() != 0 ||
+        akita_check_link_loss() != 0 ||
+        akita_check_region_limits() != 0) {
+        return 1;
+    }
+
+    printf("adr checks passed\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_aggregate.h"
+#include "akita_app.h"
+#include "akita_board.h"
+#include "bench_support.h"
+
+static akita_aggregate_t g_aggregate;
+static akita_aggregate_summary_t g_summary;
+static akita_vehicle_telemetry_t g_telemetry;
+static akita_outbox_message_t g_message;
+
+static int akita_check_spike(void) {
+    const akita_aggregate_value_t *rpm = &g_summary.fields[AKITA_AGGREGATE_FIELD_OBD_RPM];
+    uint32_t index;
+
+    /* Fifty samples at 200 ms between two 10 s publishes, with one 6500 rpm spike the publishes never see. */
+    akita_aggregate_reset(&g_aggregate, 1000U);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    g_telemetry.obd.connected = true;
+    g_telemetry.system.free_heap = 150000U;
+    for (index = 0; index < 50U; ++index) {
+        g_telemetry.obd.rpm = index == 23U ? 6500.0f : (index % 2U == 0U ? 2000.0f : 2200.0f);
+        akita_aggregate_add(&g_aggregate, &g_telemetry);
+    }
+    g_telemetry.obd.rpm = 2100.0f;
+
+    akita_aggregate_summarize(&g_aggregate, 11000U, &g_summary);
+    AKITA_CHECK(g_summary.window_ms == 10000U);
+    AKITA_CHECK(g_summary.count[AKITA_AGGREGATE_GROUP_OBD] == 50U);
+    AKITA_CHECK(g_summary.count[AKITA_AGGREGATE_GROUP_GPS] == 0U);
+    AKITA_CHECK(rpm->min == 2000.0f);
+    AKITA_CHECK(rpm->max == 6500.0f);
+    AKITA_CHECK(fabsf(rpm->mean - 2186.0f) < 0.01f);
+    AKITA_CHECK(rpm->stddev > 600.0f && rpm->stddev < 650.0f);
+    return 0;
+}
+
+static int akita_check_precision(void) {
+    const akita_aggregate_value_t *heap = &g_summary.fields[AKITA_AGGREGATE_FIELD_FREE_HEAP];
+    uint32_t index;
+
+    /* Large values over a long window: a plain float sum would lose the low digits. */
+    akita_aggregate_reset(&g_aggregate, 0U);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    for (index = 0; index < 3000U; ++index) {
+        g_telemetry.system.free_heap = 180001U + (index % 3U);
+        akita_aggregate_add(&g_aggregate, &g_telemetry);
+    }
+
+    akita_aggregate_summarize(&g_aggregate, 600000U, &g_summary);
+    AKITA_CHECK(g_summary.count[AKITA_AGGREGATE_GROUP_SYSTEM] == 3000U);
+    AKITA_CHECK(fabsf(heap->mean - 180002.0f) < 0.05f);
+    AKITA_CHECK(fabsf(heap->stddev - 0.8166f) < 0.01f);
+    return 0;
+}
+
+static int akita_check_gating(void) {
+    /* GPS values without a fix and OBD values while disconnected are not aggregated. */
+    akita_aggregate_reset(&g_aggregate, 0U);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    g_telemetry.gps.fix = true;
+    g_telemetry.gps.speed_kmh = 40.0f;
+    akita_aggregate_add(&g_aggregate, &g_telemetry);
+    g_telemetry.gps.fix = false;
+    g_telemetry.gps.speed_kmh = 0.0f;
+    g_telemetry.obd.rpm = 900.0f;
+    akita_aggregate_add(&g_aggregate, &g_telemetry);
+
+    akita_aggregate_summarize(&g_aggregate, 400U, &g_summary);
+    AKITA_CHECK(g_summary.count[AKITA_AGGREGATE_GROUP_GPS] == 1U);
+    AKITA_CHECK(g_summary.count[AKITA_AGGREGATE_GROUP_OBD] == 0U);
+    AKITA_CHECK(g_summary.count[AKITA_AGGREGATE_GROUP_SYSTEM] == 2U);
+    AKITA_CHECK(g_summary.fields[AKITA_AGGREGATE_FIELD_GPS_SPEED].min == 40.0f);
+    AKITA_CHECK(g_summary.fields[AKITA_AGGREGATE_FIELD_GPS_SPEED].stddev == 0.0f);
+    AKITA_CHECK(g_summary.fields[AKITA_AGGREGATE_FIELD_OBD_RPM].max == 0.0f);
+    return 0;
+}
+
+static int akita_check_payload(void) {
+    akita_runtime_config_t config;
+    char payload[1280];
+
+    akita_check_spike();
+    akita_board_apply_defaults(&config);
+    g_message.message_class = AKITA_MESSAGE_ROUTINE;
+    g_message.event_value = NAN;
+    g_message.created_ms = 11000U;
+    g_message.telemetry = g_telemetry;
+    g_message.sample.window = g_summary;
+    AKITA_CHECK(akita_payload_write_message_json(&config, &g_message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, ",\"window\":{\"ms\":10000,\"obd\":{\"n\":50,\"rpm\":[2000.0,2186.0,6500.0],") != NULL);
+    AKITA_CHECK(strstr(payload, "\"gps\":{\"n\"") == NULL);
+    AKITA_CHECK(strstr(payload, "\"system\":{\"n\":50,") != NULL);
+    AKITA_CHECK(payload[strlen(payload) - 1U] == '}');
+
+    config.aggregate_variance = true;
+    AKITA_CHECK(akita_payload_write_message_json(&config, &g_message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, "\"rpm\":[2000.0,2186.0,6500.0,6") != NULL);
+
+    memset(&g_message.sample.window, 0, sizeof(g_message.sample.window));
+    AKITA_CHECK(akita_payload_write_message_json(&config, &g_message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, "window") == NULL);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_spike() != 0 ||
+        akita_check_precision() != 0 ||
+        akita_check_gating() != 0 ||
+        akita_check_payload() != 0) {
+        return 1;
+    }
+
+    printf("aggregate checks passed\n");
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_airtime.h"
+#include "bench_support.h"
+
+static akita_lora_modem_t akita_check_modem(uint8_t spreading_factor, uint32_t bandwidth_hz) {
+    akita_lora_modem_t modem = {
+        .spreading_factor = spreading_factor,
+        .coding_rate = 5U,
+        .preamble_len = 8U,
+        .bandwidth_hz = bandwidth_hz,
+        .crc_on = true,
+    };
+    return modem;
+}
+
+static int akita_check_time_on_air(void) {
+    akita_lora_modem_t modem = akita_check_modem(7U, 125000U);
+
+    /* Reference values from the Semtech LoRa calculator. */
+    AKITA_CHECK(akita_airtime_us(&modem, 20U) == 56576U);
+    AKITA_CHECK(!akita_airtime_low_data_rate(&modem));
+
+    modem = akita_check_modem(12U, 125000U);
+    AKITA_CHECK(akita_airtime_low_data_rate(&modem));
+    AKITA_CHECK(akita_airtime_us(&modem, 51U) == 2465792U);
+
+    modem = akita_check_modem(9U, 500000U);
+    AKITA_CHECK(!akita_airtime_low_data_rate(&modem));
+    AKITA_CHECK(akita_airtime_us(&modem, 10U) == 36096U);
+
+    /* The largest payload that still fits a 400 ms dwell limit. */
+    modem = akita_check_modem(10U, 125000U);
+    AKITA_CHECK(akita_airtime_us(&modem, akita_airtime_max_payload(&modem, 400000U)) <= 400000U);
+    AKITA_CHECK(akita_airtime_us(&modem, akita_airtime_max_payload(&modem, 400000U) + 1U) > 400000U);
+    AKITA_CHECK(akita_airtime_max_payload(&modem, 0U) == AKITA_AIRTIME_MAX_PAYLOAD_LEN);
+
+    modem.coding_rate = 4U;
+    AKITA_CHECK(akita_airtime_us(&modem, 10U) == 0U);
+    AKITA_CHECK(akita_airtime_max_payload(&modem, 400000U) == 0U);
+    return 0;
+}
+
+static int akita_check_bands(void) {
+    size_t index = 0;
+
+    AKITA_CHECK(akita_airtime_resolve_region(AKITA_LORA_REGION_AUTO, 868100000U) == AKITA_LORA_REGION_EU868);
+    AKITA_CHECK(akita_airtime_resolve_region(AKITA_LORA_REGION_AUTO, 915000000U) == AKITA_LORA_REGION_US915);
+    AKITA_CHECK(akita_airtime_resolve_region(AKITA_LORA_REGION_AUTO, 433775000U) == AKITA_LORA_REGION_UNRESTRICTED);
+    AKITA_CHECK(akita_airtime_find_band(AKITA_LORA_REGION_AUTO, 868100000U, &index)->duty_cycle_permille == 10U);
+    AKITA_CHECK(akita_airtime_find_band(AKITA_LORA_REGION_AUTO, 869525000U, &index)->duty_cycle_permille == 100U);
+    AKITA_CHECK(akita_airtime_find_band(AKITA_LORA_REGION_EU868, 868650000U, &index)->duty_cycle_permille == 1U);
+    AKITA_CHECK(akita_airtime_find_band(AKITA_LORA_REGION_US915, 915000000U, &index)->dwell_limit_us == 400000U);
+    return 0;
+}
+
+static int akita_check_duty_cycle(void) {
+    static akita_airtime_scheduler_t scheduler;
+    akita_lora_modem_t modem = akita_check_modem(12U, 125000U);
+    akita_airtime_slot_t slot;
+    uint8_t payload[51];
+    uint64_t now_ms = 3600000ULL * 24U;
+    uint32_t wait_ms = 0;
+    uint32_t sent = 0;
+
+    memset(payload, 0xA5, sizeof(payload));
+    akita_airtime_scheduler_init(&scheduler);
+    akita_airtime_scheduler_configure(&scheduler, AKITA_LORA_REGION_AUTO, 868100000U, &modem);
+    AKITA_CHECK(akita_airtime_scheduler_budget_us(&scheduler) == 36000000ULL);
+
+    /* Routine traffic may spend 70% of the 36 s hourly budget: ten 2.47 s frames. */
+    while (sent < 20U) {
+        AKITA_CHECK(akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_ROUTINE, payload, sizeof(payload), now_ms));
+        if (!akita_airtime_scheduler_next(&scheduler, now_ms, &slot, &wait_ms)) {
+            break;
+        }
+        akita_airtime_scheduler_commit(&scheduler, now_ms, slot.airtime_us);
+        ++sent;
+        now_ms += 5000U;
+    }
+    AKITA_CHECK(sent == 10U);
+    AKITA_CHECK(wait_ms > 0U && wait_ms != AKITA_AIRTIME_WAIT_NONE);
+    AKITA_CHECK(scheduler.counters.deferred == 1U);
+
+    /* A newer routine frame replaces the deferred one instead of queueing behind it. */
+    AKITA_CHECK(akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_ROUTINE, payload, 20U, now_ms));
+    AKITA_CHECK(scheduler.counters.coalesced == 1U);
+    AKITA_CHECK(scheduler.slot_count == 1U);
+
+    /* Alerts still have headroom above the routine share. */
+    AKITA_CHECK(akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_ALERT, payload, sizeof(payload), now_ms));
+    AKITA_CHECK(akita_airtime_scheduler_next(&scheduler, now_ms, &slot, &wait_ms));
+    AKITA_CHECK(slot.message_class == AKITA_MESSAGE_ALERT);
+    akita_airtime_scheduler_commit(&scheduler, now_ms, slot.airtime_us);
+
+    /* Routine frames go stale long before the window frees up. */
+    AKITA_CHECK(!akita_airtime_scheduler_next(&scheduler, now_ms + 31000U, &slot, &wait_ms));
+    AKITA_CHECK(scheduler.counters.dropped_stale == 1U);
+    AKITA_CHECK(wait_ms == AKITA_AIRTIME_WAIT_NONE);
+
+    /* An hour after the last transmission the whole budget is available again. */
+    now_ms += 3600000ULL + AKITA_AIRTIME_BUCKET_MS;
+    AKITA_CHECK(akita_airtime_scheduler_used_us(&scheduler, now_ms) == 0U);
+    AKITA_CHECK(akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_ROUTINE, payload, sizeof(payload), now_ms));
+    AKITA_CHECK(akita_airtime_scheduler_next(&scheduler, now_ms, &slot, &wait_ms));
+    return 0;
+}
+
+static int akita_check_priority_and_overflow(void) {
+    static akita_airtime_scheduler_t scheduler;
+    akita_lora_modem_t modem = akita_check_modem(7U, 125000U);
+    akita_airtime_slot_t slot;
+    uint8_t payload[16] = {0};
+    uint32_t wait_ms = 0;
+    size_t index;
+
+    akita_airtime_scheduler_init(&scheduler);
+    akita_airtime_scheduler_configure(&scheduler, AKITA_LORA_REGION_AUTO, 915000000U, &modem);
+
+    for (index = 0; index < AKITA_AIRTIME_QUEUE_SLOTS; ++index) {
+        payload[0] = (uint8_t) index;
+        AKITA_CHECK(akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_BULK, payload, sizeof(payload), 1000U));
+    }
+
+    /* A full queue evicts the oldest lower-priority frame, but never for an equal class. */
+    AKITA_CHECK(!akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_BULK, payload, sizeof(payload), 1000U));
+    payload[0] = 0xEE;
+    AKITA_CHECK(akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_EVENT, payload, sizeof(payload), 1000U));
+    AKITA_CHECK(scheduler.counters.dropped_overflow == 2U);
+
+    AKITA_CHECK(akita_airtime_scheduler_next(&scheduler, 1000U, &slot, &wait_ms));
+    AKITA_CHECK(slot.message_class == AKITA_MESSAGE_EVENT && slot.data[0] == 0xEE);
+    AKITA_CHECK(akita_airtime_scheduler_next(&scheduler, 1000U, &slot, &wait_ms));
+    AKITA_CHECK(slot.message_class == AKITA_MESSAGE_BULK && slot.data[0] == 1U);
+
+    /* US915 dwell time rules out long frames at slow data rates. */
+    modem = akita_check_modem(12U, 125000U);
+    akita_airtime_scheduler_configure(&scheduler, AKITA_LORA_REGION_US915, 915000000U, &modem);
+    AKITA_CHECK(!akita_airtime_scheduler_push(&scheduler, AKITA_MESSAGE_ALERT, payload, sizeof(payload), 1000U));
+    AKITA_CHECK(scheduler.counters.dropped_budget == 1U);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_time_on_air() != 0 ||
+        akita_check_bands() != 0 ||
+        akita_check_duty_cycle() != 0 ||
+        akita_check_priority_and_overflow() != 0) {
+        return 1;
+    }
+
+    printf("airtime checks passed\n");
+    return 0;
+}
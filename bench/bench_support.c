@@ -0,0 +1,51 @@
+#include "bench_support.h"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AKITA_BENCH_HAVE_TSC 1
+#else
+#define AKITA_BENCH_HAVE_TSC 0
+#endif
+
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+int64_t g_akita_bench_time_us;
+
+uint64_t akita_bench_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+}
+
+uint64_t akita_bench_cycles(void) {
+#if AKITA_BENCH_HAVE_TSC
+    return (uint64_t) __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+int akita_bench_has_cycle_counter(void) {
+    return AKITA_BENCH_HAVE_TSC;
+}
+
+int64_t esp_timer_get_time(void) {
+    if (g_akita_bench_time_us != 0) {
+        return g_akita_bench_time_us;
+    }
+
+    return (int64_t) (akita_bench_now_ns() / 1000ULL);
+}
+
+/* The host has no per-core counter to match, so spans are timed in nanoseconds on one "core". */
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    return (esp_cpu_cycle_count_t) akita_bench_now_ns();
+}
+
+int esp_cpu_get_core_id(void) {
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef AKITA_BENCH_SUPPORT_H
+#define AKITA_BENCH_SUPPORT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Fails the enclosing check, which returns int, with the file, line and condition on stderr. */
+#define AKITA_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)
+
+extern int64_t g_akita_bench_time_us;
+
+uint64_t akita_bench_now_ns(void);
+uint64_t akita_bench_cycles(void);
+int akita_bench_has_cycle_counter(void);
+
+#endif
@@ -0,0 +1,405 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_capture.h"
+#include "bench_support.h"
+#include "capture_player.h"
+
+#ifndef AKITA_BENCH_CORPUS_DIR
+#define AKITA_BENCH_CORPUS_DIR "corpus"
+#endif
+
+#define AKITA_CAPTURE_CHECK_FILE "capture_check.akcp"
+#define AKITA_DRIVE_START_US 5000000ULL
+#define AKITA_DRIVE_TICK_US 5000U
+#define AKITA_DRIVE_POLL_US 100000U
+#define AKITA_DRIVE_BAUD 9600U
+#define AKITA_DRIVE_BYTE_US (10000000U / AKITA_DRIVE_BAUD)
+#define AKITA_DRIVE_READ_BYTES 64U
+#define AKITA_DRIVE_EXCHANGE_US 250000U
+#define AKITA_DRIVE_REPLY_US 40000U
+#define AKITA_DRIVE_NOTIFY_BYTES 20U
+#define AKITA_DRIVE_MAX_EXCHANGES 256U
+#define AKITA_FLASH_BYTES (256U * 1024U)
+
+typedef struct {
+    char command[16];
+    char reply[128];
+} akita_exchange_t;
+
+/* Stands in for the capture partition. */
+typedef struct {
+    uint8_t bytes[AKITA_FLASH_BYTES];
+    size_t used;
+    uint32_t writes;
+} akita_flash_t;
+
+static akita_flash_t g_flash;
+static akita_exchange_t g_exchanges[AKITA_DRIVE_MAX_EXCHANGES];
+static size_t g_exchange_count;
+static uint8_t *g_gps;
+static size_t g_gps_length;
+static uint64_t *g_gps_arrival_us;
+
+static bool akita_flash_write(const void *data, size_t size, void *context) {
+    akita_flash_t *flash = context;
+
+    if (flash->used + size > sizeof(flash->bytes)) {
+        return false;
+    }
+    memcpy(flash->bytes + flash->used, data, size);
+    flash->used += size;
+    ++flash->writes;
+    return true;
+}
+
+static char *akita_read_file(const char *name, size_t *length) {
+    char path[512];
+    FILE *file;
+    char *data;
+    long size;
+
+    snprintf(path, sizeof(path), "%s/%s", AKITA_BENCH_CORPUS_DIR, name);
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = size >= 0 ? malloc((size_t) size + 1U) : NULL;
+    if (data != NULL && fread(data, 1, (size_t) size, file) != (size_t) size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    if (data != NULL) {
+        data[size] = '\0';
+        *length = (size_t) size;
+    }
+    return data;
+}
+
+/* Each second's sentences start 50 ms into it and come off the wire one byte time apart. */
+static int akita_load_gps(void) {
+    uint64_t next_us = 0;
+    int64_t second = -1;
+
+    g_gps = (uint8_t *) akita_read_file("gps_drive.nmea", &g_gps_length);
+    AKITA_CHECK(g_gps != NULL);
+    g_gps_arrival_us = malloc(g_gps_length * sizeof(uint64_t));
+    AKITA_CHECK(g_gps_arrival_us != NULL);
+    for (size_t index = 0; index < g_gps_length; ++index) {
+        if (g_gps_length - index > 6U && memcmp(g_gps + index, "$GPRMC", 6U) == 0) {
+            uint64_t burst_us = AKITA_DRIVE_START_US + (uint64_t) (++second) * 1000000ULL + 50000U;
+
+            next_us = next_us > burst_us ? next_us : burst_us;
+        }
+        g_gps_arrival_us[index] = next_us;
+        next_us += AKITA_DRIVE_BYTE_US;
+    }
+    AKITA_CHECK(second == 89);
+    return 0;
+}
+
+static int akita_load_obd(void) {
+    size_t length;
+    char *text = akita_read_file("elm327_session.txt", &length);
+    char *save = NULL;
+
+    AKITA_CHECK(text != NULL);
+    for (char *line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        char *tab = strchr(line, '\t');
+        akita_exchange_t *exchange;
+        char *dst;
+
+        if (line[0] == '#' || tab == NULL) {
+            continue;
+        }
+        AKITA_CHECK(g_exchange_count < AKITA_DRIVE_MAX_EXCHANGES);
+        *tab = '\0';
+        exchange = &g_exchanges[g_exchange_count++];
+        snprintf(exchange->command, sizeof(exchange->command), "%s", line);
+        dst = exchange->reply;
+        for (const char *src = tab + 1; *src != '\0' && dst < exchange->reply + sizeof(exchange->reply) - 1U; ++src) {
+            if (src[0] == '\\' && src[1] == 'r') {
+                *dst++ = '\r';
+                ++src;
+            } else {
+                *dst++ = *src;
+            }
+        }
+        *dst = '\0';
+    }
+    free(text);
+    AKITA_CHECK(g_exchange_count == 187U);
+    return 0;
+}
+
+static void akita_drive_record(akita_capture_player_t *live, uint8_t source, uint8_t flags, uint64_t at_us,
+                               const void *data, size_t length) {
+    akita_capture_record_t record = {
+        .source = source,
+        .flags = flags,
+        .at_us = at_us,
+        .data = (const uint8_t *) data,
+        .length = length,
+    };
+
+    akita_capture_record(source, flags, at_us, data, length);
+    akita_capture_player_feed(live, &record);
+}
+
+/*
+ * Drives both corpora the way the firmware meets them: the main loop drains the UART every 100 ms and flushes
+ * the capture, an ELM327 request goes out every 250 ms and its reply comes back in 20 byte notifications.
+ */
+static int akita_check_drive(akita_capture_player_t *live) {
+    size_t gps_read = 0;
+    size_t exchange = 0;
+    size_t reply_sent = 0;
+    uint64_t sent_us = 0;
+    uint64_t now_us;
+
+    akita_capture_player_init(live, AKITA_DRIVE_BAUD, NULL);
+    memset(&g_flash, 0, sizeof(g_flash));
+    akita_capture_start(AKITA_DRIVE_START_US, AKITA_DRIVE_BAUD);
+    for (now_us = AKITA_DRIVE_START_US; gps_read < g_gps_length || exchange < g_exchange_count; now_us += AKITA_DRIVE_TICK_US) {
+        if ((now_us - AKITA_DRIVE_START_US) % AKITA_DRIVE_POLL_US == 0U) {
+            size_t buffered = 0;
+
+            while (gps_read + buffered < g_gps_length && g_gps_arrival_us[gps_read + buffered] <= now_us) {
+                ++buffered;
+            }
+            while (buffered > 0U) {
+                size_t chunk = buffered < AKITA_DRIVE_READ_BYTES ? buffered : AKITA_DRIVE_READ_BYTES;
+
+                buffered -= chunk;
+                akita_drive_record(live, AKITA_CAPTURE_GPS_UART, 0, now_us - (uint64_t) buffered * AKITA_DRIVE_BYTE_US,
+                                   g_gps + gps_read, chunk);
+                gps_read += chunk;
+            }
+            AKITA_CHECK(akita_capture_drain(akita_flash_write, &g_flash, false));
+        }
+        if (now_us % 1000000ULL == 0U) {
+            akita_drive_record(live, AKITA_CAPTURE_GPS_PPS, 0, now_us, NULL, 0);
+        }
+
+        if (exchange < g_exchange_count && sent_us == 0U &&
+            now_us >= AKITA_DRIVE_START_US + (uint64_t) exchange * AKITA_DRIVE_EXCHANGE_US + 20000U) {
+            char request[20];
+            int length = snprintf(request, sizeof(request), "%s\r", g_exchanges[exchange].command);
+
+            akita_drive_record(live, AKITA_CAPTURE_OBD_TX, 0, now_us, request, (size_t) length);
+            sent_us = now_us;
+            reply_sent = 0;
+        } else if (sent_us != 0U && now_us >= sent_us + AKITA_DRIVE_REPLY_US) {
+            const char *reply = g_exchanges[exchange].reply;
+            size_t remaining = strlen(reply) - reply_sent;
+            size_t piece = remaining < AKITA_DRIVE_NOTIFY_BYTES ? remaining : AKITA_DRIVE_NOTIFY_BYTES;
+
+            akita_drive_record(live, AKITA_CAPTURE_OBD_RX, 0, now_us, reply + reply_sent, piece);
+            reply_sent += piece;
+            if (reply_sent == strlen(reply)) {
+                sent_us = 0;
+                ++exchange;
+            }
+        }
+    }
+
+    akita_capture_stop();
+    akita_capture_record(AKITA_CAPTURE_GPS_PPS, 0, now_us, NULL, 0);
+    AKITA_CHECK(akita_capture_drain(akita_flash_write, &g_flash, true));
+    AKITA_CHECK(akita_capture_dropped() == 0U);
+    AKITA_CHECK(akita_capture_length(g_flash.bytes, g_flash.used) == g_flash.used);
+    return 0;
+}
+
+static int akita_check_codec(void) {
+    static const uint8_t payload[300] = { 1, 2, 3 };
+    const akita_capture_record_t records[] = {
+        { AKITA_CAPTURE_GPS_UART, 0, 1000064U, payload, 64 },
+        { AKITA_CAPTURE_GPS_PPS, 0, 1000000U, NULL, 0 },
+        { AKITA_CAPTURE_OBD_RX, AKITA_CAPTURE_FLAG_FORCE, 1000000U + (1ULL << 40), payload, 300 },
+        { AKITA_CAPTURE_OBD_TX, 0, 3, payload, 5 },
+    };
+    const akita_capture_record_t bad_tag = { AKITA_CAPTURE_SOURCE_MASK, 0xF0U, 0, NULL, 0 };
+    uint8_t image[1024];
+    uint8_t scratch[128];
+    akita_capture_reader_t reader;
+    akita_capture_record_t record;
+    uint64_t last_us = 1000000U;
+    size_t used;
+    size_t ends[4];
+
+    memset(image, AKITA_CAPTURE_END, sizeof(image));
+    used = akita_capture_write_header(image, last_us, 115200U);
+    AKITA_CHECK(used == AKITA_CAPTURE_HEADER_BYTES);
+    for (size_t index = 0; index < 4U; ++index) {
+        size_t length = akita_capture_encode(&records[index], &last_us, image + used, sizeof(image) - used);
+
+        AKITA_CHECK(length > records[index].length);
+        used += length;
+        ends[index] = used;
+    }
+    /* One byte short of the tag, two one byte varints and the data. */
+    last_us = records[0].at_us;
+    AKITA_CHECK(akita_capture_encode(&records[0], &last_us, image, 64U + 2U) == 0U);
+    AKITA_CHECK(akita_capture_encode(&records[0], &last_us, scratch, 64U + 3U) == 64U + 3U);
+    AKITA_CHECK(akita_capture_encode(&bad_tag, &last_us, image, sizeof(image)) == 0U);
+
+    AKITA_CHECK(akita_capture_reader_init(&reader, image, sizeof(image)));
+    AKITA_CHECK(reader.start_us == 1000000U && reader.gps_baud == 115200U);
+    for (size_t index = 0; index < 4U; ++index) {
+        AKITA_CHECK(akita_capture_next(&reader, &record));
+        AKITA_CHECK(record.source == records[index].source && record.flags == records[index].flags);
+        AKITA_CHECK(record.at_us == records[index].at_us && record.length == records[index].length);
+        AKITA_CHECK(record.length == 0U || memcmp(record.data, records[index].data, record.length) == 0);
+    }
+    /* Erased flash after the last record ends the log. */
+    AKITA_CHECK(!akita_capture_next(&reader, &record));
+    AKITA_CHECK(akita_capture_length(image, sizeof(image)) == used);
+
+    /* A record cut short is left out; so is everything when the header is. */
+    AKITA_CHECK(akita_capture_length(image, ends[2] - 1U) == ends[1]);
+    AKITA_CHECK(akita_capture_length(image, ends[2] + 1U) == ends[2]);
+    AKITA_CHECK(akita_capture_length(image, AKITA_CAPTURE_HEADER_BYTES - 1U) == 0U);
+    image[4] = 2;
+    AKITA_CHECK(!akita_capture_reader_init(&reader, image, sizeof(image)));
+    return 0;
+}
+
+/* With nothing drained, records fill both halves and the rest are dropped and counted, never reordered. */
+static int akita_check_recorder(void) {
+    uint8_t chunk[64];
+    akita_capture_reader_t reader;
+    akita_capture_record_t record;
+    uint32_t accepted = 0;
+    uint32_t index;
+
+    memset(&g_flash, 0, sizeof(g_flash));
+    akita_capture_record(AKITA_CAPTURE_GPS_UART, 0, 1, chunk, sizeof(chunk));
+    AKITA_CHECK(!akita_capture_running());
+
+    akita_capture_start(0, 9600U);
+    for (index = 0; index < 200U; ++index) {
+        memset(chunk, (int) index, sizeof(chunk));
+        akita_capture_record(AKITA_CAPTURE_GPS_UART, 0, (uint64_t) index * 1000U, chunk, sizeof(chunk));
+    }
+    accepted = 200U - akita_capture_dropped();
+    AKITA_CHECK(akita_capture_dropped() > 0U);
+    AKITA_CHECK(accepted * (sizeof(chunk) + 4U) > AKITA_CAPTURE_BUFFER_BYTES - 2U * (sizeof(chunk) + 4U));
+
+    AKITA_CHECK(akita_capture_drain(akita_flash_write, &g_flash, false));
+    AKITA_CHECK(g_flash.writes == 1U);
+    akita_capture_record(AKITA_CAPTURE_GPS_PPS, 0, 999999U, NULL, 0);
+    AKITA_CHECK(akita_capture_drain(akita_flash_write, &g_flash, true));
+    AKITA_CHECK(g_flash.writes == 3U);
+    AKITA_CHECK(akita_capture_drain(akita_flash_write, &g_flash, true));
+    AKITA_CHECK(g_flash.writes == 3U);
+    akita_capture_stop();
+
+    AKITA_CHECK(akita_capture_reader_init(&reader, g_flash.bytes, g_flash.used));
+    for (index = 0; index < accepted; ++index) {
+        AKITA_CHECK(akita_capture_next(&reader, &record));
+        AKITA_CHECK(record.at_us == (uint64_t) index * 1000U && record.length == sizeof(chunk) && record.data[0] == index);
+    }
+    AKITA_CHECK(akita_capture_next(&reader, &record));
+    AKITA_CHECK(record.source == AKITA_CAPTURE_GPS_PPS && record.at_us == 999999U);
+    AKITA_CHECK(!akita_capture_next(&reader, &record));
+
+    /* A refused write is reported, so the store can stop recording. */
+    akita_capture_start(0, 9600U);
+    g_flash.used = sizeof(g_flash.bytes);
+    AKITA_CHECK(!akita_capture_drain(akita_flash_write, &g_flash, true));
+    akita_capture_stop();
+    return 0;
+}
+
+static int akita_check_replay_file(const akita_capture_player_t *live) {
+    akita_capture_player_t replayed;
+    akita_capture_reader_t reader;
+    akita_capture_record_t record;
+    FILE *file;
+
+    AKITA_CHECK(akita_capture_reader_init(&reader, g_flash.bytes, g_flash.used));
+    AKITA_CHECK(reader.gps_baud == AKITA_DRIVE_BAUD);
+    akita_capture_player_init(&replayed, reader.gps_baud, NULL);
+    while (akita_capture_next(&reader, &record)) {
+        akita_capture_player_feed(&replayed, &record);
+    }
+    AKITA_CHECK(replayed.records == live->records);
+    AKITA_CHECK(replayed.fixes == live->fixes && replayed.obd_samples == live->obd_samples);
+    AKITA_CHECK(replayed.digest == live->digest);
+    /* RMC and GGA each update a fix; a reply is parsed again as each of its notifications lands. */
+    AKITA_CHECK(live->fixes == 172U && live->obd_samples == 199U);
+    AKITA_CHECK(replayed.gps_bytes == g_gps_length);
+
+    /* Left in the build tree for the akita_capture_replay test. */
+    file = fopen(AKITA_CAPTURE_CHECK_FILE, "wb");
+    AKITA_CHECK(file != NULL);
+    AKITA_CHECK(fwrite(g_flash.bytes, 1, g_flash.used, file) == g_flash.used);
+    AKITA_CHECK(fclose(file) == 0);
+    return 0;
+}
+
+/* A faster replay hands over the same bytes in a shorter time, so the parsers read the same fixes. */
+static int akita_check_replay_speed(void) {
+    static const uint32_t speeds[] = { 100U, 400U };
+    akita_capture_player_t players[2];
+    uint64_t spans_us[2];
+    akita_capture_replay_t replay;
+    akita_capture_record_t record;
+    const uint64_t started_us = 2000000U;
+
+    for (size_t index = 0; index < 2U; ++index) {
+        uint64_t now_us = started_us;
+        uint64_t last_us = 0;
+
+        AKITA_CHECK(akita_capture_replay_open(&replay, AKITA_CAPTURE_CHECK_FILE, AKITA_CAPTURE_GPS_SOURCES, speeds[index],
+                                              started_us) == ESP_OK);
+        akita_capture_player_init(&players[index], replay.reader.gps_baud * speeds[index] / 100U, NULL);
+        while (!akita_capture_replay_done(&replay)) {
+            now_us += 10000U;
+            while (akita_capture_replay_next(&replay, now_us, &record)) {
+                AKITA_CHECK(record.at_us <= now_us && record.at_us + 10000U >= now_us);
+                AKITA_CHECK(record.source == AKITA_CAPTURE_GPS_UART || record.source == AKITA_CAPTURE_GPS_PPS);
+                last_us = record.at_us;
+                akita_capture_player_feed(&players[index], &record);
+            }
+        }
+        spans_us[index] = last_us - started_us;
+        akita_capture_replay_close(&replay);
+    }
+
+    AKITA_CHECK(players[0].fixes == 172U && players[1].fixes == players[0].fixes);
+    AKITA_CHECK(players[1].fix.latitude == players[0].fix.latitude && players[1].fix.longitude == players[0].fix.longitude);
+    AKITA_CHECK(players[1].fix.utc_ms == players[0].fix.utc_ms);
+    AKITA_CHECK(spans_us[0] > 89000000U && spans_us[1] >= spans_us[0] / 4U - 1U && spans_us[1] <= spans_us[0] / 4U);
+
+    AKITA_CHECK(akita_capture_replay_open(&replay, "missing.akcp", AKITA_CAPTURE_GPS_SOURCES, 100U, 0) == ESP_ERR_NOT_FOUND);
+    AKITA_CHECK(akita_capture_replay_open(&replay, AKITA_BENCH_CORPUS_DIR "/gps_drive.nmea", AKITA_CAPTURE_GPS_SOURCES, 100U,
+                                          0) == ESP_ERR_INVALID_RESPONSE);
+    return 0;
+}
+
+int main(void) {
+    static akita_capture_player_t live;
+
+    if (akita_check_codec() != 0 ||
+        akita_check_recorder() != 0 ||
+        akita_load_gps() != 0 ||
+        akita_load_obd() != 0 ||
+        akita_check_drive(&live) != 0 ||
+        akita_check_replay_file(&live) != 0 ||
+        akita_check_replay_speed() != 0) {
+        return 1;
+    }
+
+    printf("capture checks passed: %lu records, %zu bytes captured for %zu bytes of NMEA\n", (unsigned long) live.records,
+           g_flash.used, g_gps_length);
+    free(g_gps_arrival_us);
+    free(g_gps);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "capture_player.h"
+
+#include <string.h>
+
+#define AKITA_FNV_OFFSET 0xcbf29ce484222325ULL
+#define AKITA_FNV_PRIME 0x100000001b3ULL
+
+static void akita_capture_player_emit(akita_capture_player_t *player, const char *line) {
+    for (const char *cursor = line; *cursor != '\0'; ++cursor) {
+        player->digest = (player->digest ^ (uint8_t) *cursor) * AKITA_FNV_PRIME;
+    }
+    if (player->events != NULL) {
+        fputs(line, player->events);
+    }
+}
+
+void akita_capture_player_init(akita_capture_player_t *player, uint32_t gps_baud, FILE *events) {
+    memset(player, 0, sizeof(*player));
+    akita_nmea_reset(&player->parser);
+    akita_obd_session_reset(&player->session);
+    player->byte_us = gps_baud > 0U ? 10000000U / gps_baud : 0U;
+    player->digest = AKITA_FNV_OFFSET;
+    player->events = events;
+}
+
+void akita_capture_player_feed(akita_capture_player_t *player, const akita_capture_record_t *record) {
+    char line[192];
+
+    ++player->records;
+    switch (record->source) {
+    case AKITA_CAPTURE_GPS_UART:
+        player->gps_bytes += record->length;
+        akita_nmea_feed(&player->parser, record->data, record->length, record->at_us, player->byte_us);
+        akita_nmea_snapshot(&player->parser, record->at_us, player->pps_us, &player->fix);
+        if (player->fix.fix && player->fix.fix_ms != player->last_fix_ms) {
+            player->last_fix_ms = player->fix.fix_ms;
+            ++player->fixes;
+            snprintf(line, sizeof(line), "gps %llu %.6f %.6f %.1f %.2f %.1f %u %lld\n",
+                     (unsigned long long) player->fix.fix_ms, player->fix.latitude, player->fix.longitude,
+                     player->fix.altitude_m, player->fix.speed_kmh, player->fix.course_deg, player->fix.satellites,
+                     (long long) player->fix.utc_ms);
+            akita_capture_player_emit(player, line);
+        }
+        break;
+    case AKITA_CAPTURE_GPS_PPS:
+        player->pps_us = record->at_us;
+        break;
+    case AKITA_CAPTURE_OBD_TX:
+        player->obd_bytes += record->length;
+        akita_obd_session_sent(&player->session, record->at_us / 1000U);
+        break;
+    case AKITA_CAPTURE_OBD_RX:
+        player->obd_bytes += record->length;
+        if (akita_obd_session_receive(&player->session, &player->obd, (const char *) record->data, record->length,
+                                      (record->flags & AKITA_CAPTURE_FLAG_FORCE) != 0U, record->at_us / 1000U)) {
+            ++player->obd_samples;
+            snprintf(line, sizeof(line), "obd %llu %.1f %.1f %.1f\n", (unsigned long long) (record->at_us / 1000U),
+                     player->obd.rpm, player->obd.speed_kmh, player->obd.coolant_c);
+            akita_capture_player_emit(player, line);
+        }
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef AKITA_CAPTURE_PLAYER_H
+#define AKITA_CAPTURE_PLAYER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "akita_capture.h"
+#include "akita_nmea.h"
+#include "akita_obd_protocol.h"
+
+/*
+ * Feeds capture records through the NMEA parser and the ELM327 session the way the firmware hands them over,
+ * and folds every fix and OBD reading they produce into a digest, so two builds can be shown to agree.
+ */
+typedef struct {
+    akita_nmea_parser_t parser;
+    akita_obd_session_t session;
+    akita_obd_snapshot_t obd;
+    uint64_t pps_us;
+    uint64_t last_fix_ms;
+    uint32_t byte_us;
+    uint64_t digest;
+    uint32_t records;
+    uint32_t fixes;
+    uint32_t obd_samples;
+    uint64_t gps_bytes;
+    uint64_t obd_bytes;
+    akita_gps_snapshot_t fix;
+    /* Each output as a line of text, when set. */
+    FILE *events;
+} akita_capture_player_t;
+
+void akita_capture_player_init(akita_capture_player_t *player, uint32_t gps_baud, FILE *events);
+void akita_capture_player_feed(akita_capture_player_t *player, const akita_capture_record_t *record);
+
+#endif
@@ -0,0 +1,151 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_capture.h"
+#include "bench_support.h"
+#include "capture_player.h"
+
+#define AKITA_REPLAY_BUDGET_NS 300000000ULL
+#define AKITA_REPLAY_QUICK_BUDGET_NS 20000000ULL
+
+typedef struct {
+    const char *name;
+    uint32_t sources;
+} akita_replay_case_t;
+
+static const akita_replay_case_t kReplayCases[] = {
+    { "replay_gps", AKITA_CAPTURE_GPS_SOURCES },
+    { "replay_obd", AKITA_CAPTURE_OBD_SOURCES },
+};
+
+/* One pass over the records of the chosen sources, at the times they were recorded. */
+static void akita_replay_pass(const akita_capture_reader_t *capture, uint32_t sources, FILE *events,
+                              akita_capture_player_t *player) {
+    akita_capture_reader_t reader;
+    akita_capture_record_t record;
+
+    akita_capture_player_init(player, capture->gps_baud, events);
+    (void) akita_capture_reader_init(&reader, capture->data, capture->size);
+    while (akita_capture_next(&reader, &record)) {
+        if ((sources & AKITA_CAPTURE_SOURCE_BIT(record.source)) != 0U) {
+            akita_capture_player_feed(player, &record);
+        }
+    }
+}
+
+static void akita_replay_print(FILE *out, const char *path, const akita_capture_reader_t *capture, bool quick) {
+    uint64_t budget_ns = quick ? AKITA_REPLAY_QUICK_BUDGET_NS : AKITA_REPLAY_BUDGET_NS;
+    akita_capture_player_t player;
+    akita_capture_reader_t reader;
+    akita_capture_record_t record;
+    uint64_t last_us = capture->start_us;
+    size_t index;
+
+    (void) akita_capture_reader_init(&reader, capture->data, capture->size);
+    while (akita_capture_next(&reader, &record)) {
+        last_us = record.at_us > last_us ? record.at_us : last_us;
+    }
+    akita_replay_pass(capture, AKITA_CAPTURE_GPS_SOURCES | AKITA_CAPTURE_OBD_SOURCES, NULL, &player);
+
+    fprintf(out,
+            "{\n  \"suite\": \"akita_capture_replay\",\n  \"quick\": %s,\n  \"capture\": \"%s\",\n"
+            "  \"records\": %lu,\n  \"span_s\": %.3f,\n  \"fixes\": %lu,\n  \"obd_samples\": %lu,\n"
+            "  \"digest\": \"%016llx\",\n  \"cases\": [\n",
+            quick ? "true" : "false", path, (unsigned long) player.records,
+            (double) (last_us - capture->start_us) / 1e6, (unsigned long) player.fixes,
+            (unsigned long) player.obd_samples, (unsigned long long) player.digest);
+    for (index = 0; index < sizeof(kReplayCases) / sizeof(kReplayCases[0]); ++index) {
+        const akita_replay_case_t *replay_case = &kReplayCases[index];
+        uint64_t passes = 0;
+        uint64_t started_ns;
+        uint64_t elapsed_ns;
+        uint64_t bytes;
+        uint64_t ops;
+
+        akita_replay_pass(capture, replay_case->sources, NULL, &player);
+        started_ns = akita_bench_now_ns();
+        do {
+            akita_replay_pass(capture, replay_case->sources, NULL, &player);
+            ++passes;
+            elapsed_ns = akita_bench_now_ns() - started_ns;
+        } while (elapsed_ns < budget_ns);
+
+        ops = passes * (player.records > 0U ? player.records : 1U);
+        bytes = replay_case->sources == AKITA_CAPTURE_GPS_SOURCES ? player.gps_bytes : player.obd_bytes;
+        fprintf(out,
+                "    {\"name\": \"%s\", \"unit\": \"record\", \"ops\": %llu, \"ns_per_op\": %.2f, "
+                "\"bytes_per_op\": %.2f, \"digest\": \"%016llx\"}%s\n",
+                replay_case->name, (unsigned long long) ops, (double) elapsed_ns / (double) ops,
+                player.records > 0U ? (double) bytes / (double) player.records : 0.0,
+                (unsigned long long) player.digest, index + 1U < sizeof(kReplayCases) / sizeof(kReplayCases[0]) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+    akita_capture_replay_t capture;
+    akita_capture_player_t player;
+    const char *capture_path = NULL;
+    const char *events_path = NULL;
+    const char *output_path = NULL;
+    bool quick = false;
+    FILE *out = stdout;
+    FILE *events;
+    esp_err_t err;
+    int index;
+
+    for (index = 1; index < argc; ++index) {
+        if (strcmp(argv[index], "--quick") == 0) {
+            quick = true;
+        } else if (strcmp(argv[index], "--events") == 0 && index + 1 < argc) {
+            events_path = argv[++index];
+        } else if (strcmp(argv[index], "--output") == 0 && index + 1 < argc) {
+            output_path = argv[++index];
+        } else if (argv[index][0] != '-' && capture_path == NULL) {
+            capture_path = argv[index];
+        } else {
+            capture_path = NULL;
+            break;
+        }
+    }
+    if (capture_path == NULL) {
+        fprintf(stderr, "usage: %s [--quick] [--events FILE] [--output FILE] CAPTURE\n", argv[0]);
+        return 2;
+    }
+
+    err = akita_capture_replay_open(&capture, capture_path, AKITA_CAPTURE_GPS_SOURCES | AKITA_CAPTURE_OBD_SOURCES, 100U, 0U);
+    if (err != ESP_OK) {
+        fprintf(stderr, "cannot read %s as a capture (error 0x%x)\n", capture_path, (unsigned) err);
+        return 1;
+    }
+
+    if (events_path != NULL) {
+        events = strcmp(events_path, "-") == 0 ? stdout : fopen(events_path, "w");
+        if (events == NULL) {
+            fprintf(stderr, "cannot write %s\n", events_path);
+            akita_capture_replay_close(&capture);
+            return 1;
+        }
+        akita_replay_pass(&capture.reader, AKITA_CAPTURE_GPS_SOURCES | AKITA_CAPTURE_OBD_SOURCES, events, &player);
+        if (events != stdout) {
+            fclose(events);
+        }
+    }
+
+    if (output_path != NULL) {
+        out = fopen(output_path, "w");
+        if (out == NULL) {
+            fprintf(stderr, "cannot write %s\n", output_path);
+            akita_capture_replay_close(&capture);
+            return 1;
+        }
+    }
+    akita_replay_print(out, capture_path, &capture.reader, quick);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    akita_capture_replay_close(&capture);
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_app.h"
+#include "akita_board.h"
+#include "akita_clock.h"
+#include "bench_support.h"
+
+/* The node's oscillator runs 40 ppm fast and booted 5 s before the first GPS second. */
+#define AKITA_SIM_DRIFT 40e-6
+#define AKITA_SIM_BOOT_US 5000000.0
+#define AKITA_SIM_EPOCH_MS 1760000000000LL
+/* Sentences leave the receiver 80 to 180 ms after their second and are read on the 100 ms poll. */
+#define AKITA_SIM_NMEA_DELAY_US 80000.0
+#define AKITA_SIM_NMEA_JITTER_US 100000.0
+#define AKITA_SIM_POLL_US 100000.0
+#define AKITA_SIM_PPS_LATENCY_US 2.0
+#define AKITA_SIM_PPS_JITTER_US 5.0
+#define AKITA_SIM_EXPECTED_DRIFT_PPB (1e9 / (1.0 + AKITA_SIM_DRIFT) - 1e9)
+
+static uint32_t g_seed = 4242U;
+
+static double akita_random(void) {
+    g_seed = g_seed * 1664525U + 1013904223U;
+    return (double) (g_seed >> 8) / 16777216.0;
+}
+
+static uint64_t akita_mono_us(double true_s) {
+    return (uint64_t) llround(AKITA_SIM_BOOT_US + true_s * 1e6 * (1.0 + AKITA_SIM_DRIFT));
+}
+
+static double akita_true_s(uint64_t mono_us) {
+    return ((double) mono_us - AKITA_SIM_BOOT_US) / (1e6 * (1.0 + AKITA_SIM_DRIFT));
+}
+
+/* The clock's UTC at mono_us minus the true UTC, in microseconds. */
+static double akita_error_us(const akita_clock_t *clock, uint64_t mono_us) {
+    double estimate_us = (double) mono_us + (double) akita_clock_offset_us(clock, mono_us);
+
+    return estimate_us - ((double) AKITA_SIM_EPOCH_MS * 1000.0 + akita_true_s(mono_us) * 1e6);
+}
+
+/* Feeds GPS seconds [first, last), checking the clock mid-second from settle_s on; returns the worst error. */
+static double akita_feed(akita_clock_t *clock, uint32_t first, uint32_t last, bool pps, uint32_t settle_s, bool *bounded) {
+    double worst_us = 0.0;
+    uint32_t second;
+
+    for (second = first; second < last; ++second) {
+        double arrival_us = (double) akita_mono_us((double) second) +
+                            AKITA_SIM_NMEA_DELAY_US + akita_random() * AKITA_SIM_NMEA_JITTER_US;
+        uint64_t received_us = (uint64_t) (ceil(arrival_us / AKITA_SIM_POLL_US) * AKITA_SIM_POLL_US);
+        uint64_t pps_us = pps ? akita_mono_us((double) second) +
+                                (uint64_t) llround(AKITA_SIM_PPS_LATENCY_US + akita_random() * AKITA_SIM_PPS_JITTER_US)
+                              : 0U;
+        uint64_t probe_us = akita_mono_us((double) second + 0.5);
+        double error_us;
+
+        akita_clock_gps(clock, AKITA_SIM_EPOCH_MS + (int64_t) second * 1000, received_us, pps_us);
+        if (second < settle_s) {
+            continue;
+        }
+
+        error_us = fabs(akita_error_us(clock, probe_us));
+        if (error_us > worst_us) {
+            worst_us = error_us;
+        }
+        if (error_us > (double) akita_clock_error_us(clock, probe_us)) {
+            *bounded = false;
+        }
+    }
+
+    return worst_us;
+}
+
+static int akita_check_nmea(void) {
+    akita_clock_t clock;
+    bool bounded = true;
+    double worst_us;
+
+    akita_clock_init(&clock);
+    worst_us = akita_feed(&clock, 0U, 1800U, false, 120U, &bounded);
+
+    printf("nmea     worst %.1f ms over 30 min, %lu steps\n", worst_us / 1000.0, (unsigned long) clock.steps);
+    AKITA_CHECK(clock.source == AKITA_CLOCK_NMEA);
+    AKITA_CHECK(worst_us < (double) AKITA_CLOCK_NMEA_ERROR_US);
+    AKITA_CHECK(bounded);
+    AKITA_CHECK(clock.steps == 0U);
+    return 0;
+}
+
+static int akita_check_pps(void) {
+    akita_clock_t clock;
+    bool bounded = true;
+    double worst_us;
+    double holdover_us;
+    uint64_t probe_us;
+    int64_t utc_ms;
+
+    akita_clock_init(&clock);
+    worst_us = akita_feed(&clock, 0U, 600U, true, 100U, &bounded);
+
+    printf("pps      worst %.1f us over 10 min, drift %.2f ppm (true %.2f)\n", worst_us,
+           (double) clock.drift_ppb / 1000.0, AKITA_SIM_EXPECTED_DRIFT_PPB / 1000.0);
+    AKITA_CHECK(clock.source == AKITA_CLOCK_PPS);
+    AKITA_CHECK(clock.has_drift);
+    AKITA_CHECK(worst_us < 100.0);
+    AKITA_CHECK(bounded);
+    AKITA_CHECK(fabs((double) clock.drift_ppb - AKITA_SIM_EXPECTED_DRIFT_PPB) < 1000.0);
+
+    /* An hour without GPS: the drift estimate carries the clock. */
+    probe_us = akita_mono_us(600.0 + 3600.0);
+    holdover_us = fabs(akita_error_us(&clock, probe_us));
+    printf("holdover %.2f ms after 1 h (%.0f ms without drift correction), bound %.1f ms\n", holdover_us / 1000.0,
+           AKITA_SIM_DRIFT * 3600.0 * 1000.0, (double) akita_clock_error_us(&clock, probe_us) / 1000.0);
+    AKITA_CHECK(holdover_us < 5000.0);
+    AKITA_CHECK(holdover_us <= (double) akita_clock_error_us(&clock, probe_us));
+
+    /* Sentence times alone stay ignored while the holdover is still better than they are. */
+    akita_feed(&clock, 4200U, 4260U, false, 4260U, &bounded);
+    AKITA_CHECK(clock.source == AKITA_CLOCK_PPS);
+    AKITA_CHECK(akita_clock_utc_ms(&clock, probe_us, &utc_ms));
+    AKITA_CHECK(llabs(utc_ms - (AKITA_SIM_EPOCH_MS + 4200000LL)) <= 5);
+    return 0;
+}
+
+static int akita_check_step(void) {
+    akita_clock_t clock;
+    bool bounded = true;
+    uint32_t samples;
+    int64_t utc_ms;
+
+    akita_clock_init(&clock);
+    AKITA_CHECK(!akita_clock_utc_ms(&clock, 1000000U, &utc_ms));
+    AKITA_CHECK(akita_clock_error_us(&clock, 1000000U) == UINT32_MAX);
+    akita_feed(&clock, 0U, 300U, true, 300U, &bounded);
+
+    /* The same sentence time twice, e.g. from RMC and ZDA, is one sample. */
+    samples = clock.samples;
+    akita_clock_gps(&clock, AKITA_SIM_EPOCH_MS + 299000, akita_mono_us(299.3), akita_mono_us(299.0));
+    AKITA_CHECK(clock.samples == samples);
+
+    /* A receiver that jumps a whole minute is followed by a step, not a slow slew. */
+    for (uint32_t second = 300U; second < 320U; ++second) {
+        uint64_t pps_us = akita_mono_us((double) second) + 3U;
+
+        akita_clock_gps(&clock, AKITA_SIM_EPOCH_MS + (int64_t) (second + 60U) * 1000, pps_us + 150000U, pps_us);
+    }
+    AKITA_CHECK(clock.steps == 1U);
+    AKITA_CHECK(!clock.has_drift);
+    AKITA_CHECK(fabs(akita_error_us(&clock, akita_mono_us(320.0)) - 60e6) < 1000.0);
+    return 0;
+}
+
+static int akita_check_payload(void) {
+    akita_runtime_config_t config;
+    akita_outbox_message_t message;
+    char payload[1792];
+    size_t length;
+    size_t index;
+
+    akita_board_apply_defaults(&config);
+    memset(&message, 0, sizeof(message));
+    message.message_class = AKITA_MESSAGE_ROUTINE;
+    message.event_value = NAN;
+    message.created_ms = 60000U;
+    message.telemetry.gps.fix = true;
+    message.telemetry.gps.fix_ms = 59800U;
+    message.telemetry.obd.rpm_ms = 59950U;
+    message.telemetry.obd.speed_ms = 59700U;
+    message.telemetry.system.sampled_ms = 60000U;
+
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, "utc_ms") == NULL);
+    AKITA_CHECK(strstr(payload, ",\"acquired_ms\":{\"obd\":{\"rpm\":59950,\"speed_kmh\":59700},\"gps\":59800,\"system\":60000}") != NULL);
+
+    message.utc_offset_us = AKITA_SIM_EPOCH_MS * 1000 - 60000000 + 250;
+    message.utc_error_us = 42U;
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, ",\"timestamp_ms\":60000,\"utc_ms\":1760000000000,\"utc_error_us\":42,") != NULL);
+    AKITA_CHECK(strstr(payload, ",\"acquired_ms\":{\"obd\":{\"rpm\":1759999999950,\"speed_kmh\":1759999999700},"
+                                "\"gps\":1759999999800,\"system\":1760000000000}") != NULL);
+
+    /* Everything a routine sample can carry still fits the uplink buffer. */
+    snprintf(message.event_name, sizeof(message.event_name), "%s", "geofence_dwell");
+    message.event_value = -12345.67f;
+    message.telemetry.obd.coolant_ms = 59990U;
+    message.fused.valid = true;
+    message.sample.window.window_ms = UINT32_MAX;
+    for (index = 0; index < AKITA_AGGREGATE_GROUP_COUNT; ++index) {
+        message.sample.window.count[index] = UINT16_MAX;
+    }
+    message.sample.track_count = AKITA_TRACK_MAX_POINTS;
+    for (index = 0; index < AKITA_TRACK_MAX_POINTS; ++index) {
+        message.sample.track[index] = (akita_track_point_t) {.latitude_e6 = -89999999, .longitude_e6 = -179999999};
+    }
+    length = akita_payload_write_message_json(&config, &message, payload, sizeof(payload));
+    printf("payload  %zu of %zu bytes with every section\n", length, sizeof(payload));
+    AKITA_CHECK(length > 0U);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_nmea() != 0 ||
+        akita_check_pps() != 0 ||
+        akita_check_step() != 0 ||
+        akita_check_payload() != 0) {
+        return 1;
+    }
+
+    printf("clock checks passed\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_fragment.h"
+#include "bench_support.h"
+#include "fragment_reassembler.h"
+
+static uint8_t g_payload[700];
+static uint8_t g_message[AKITA_FRAGMENT_MAX_MESSAGE_LEN];
+static akita_fragment_sender_t g_sender;
+static akita_fragment_reassembler_t g_reassembler;
+
+static int akita_check_counts(void) {
+    /* Anything that fits one frame is sent as-is, without a fragment header. */
+    AKITA_CHECK(akita_fragment_count(40U, AKITA_FRAME_MAX_LEN) == 1U);
+    AKITA_CHECK(akita_fragment_count(AKITA_FRAME_MAX_LEN, AKITA_FRAME_MAX_LEN) == 1U);
+    AKITA_CHECK(akita_fragment_count(AKITA_FRAME_MAX_LEN + 1U, AKITA_FRAME_MAX_LEN) == 2U);
+    AKITA_CHECK(akita_fragment_count(700U, AKITA_FRAME_MAX_LEN) == 3U);
+    /* A 400 ms dwell limit at SF10 leaves 24 bytes per frame. */
+    AKITA_CHECK(akita_fragment_count(60U, 24U) == 4U);
+    AKITA_CHECK(akita_fragment_count(AKITA_FRAGMENT_MAX_MESSAGE_LEN + 1U, AKITA_FRAME_MAX_LEN) == 0U);
+    AKITA_CHECK(akita_fragment_count(600U, 24U) == 0U);
+    AKITA_CHECK(akita_fragment_count(60U, AKITA_FRAGMENT_HEADER_LEN) == 0U);
+    return 0;
+}
+
+static int akita_check_round_trip(void) {
+    uint8_t frames[3][AKITA_FRAME_MAX_LEN];
+    size_t lengths[3];
+    akita_message_class_t message_class = AKITA_MESSAGE_ROUTINE;
+    size_t message_len = 0;
+    size_t index;
+
+    for (index = 0; index < sizeof(g_payload); ++index) {
+        g_payload[index] = (uint8_t) (index * 7U);
+    }
+
+    akita_fragment_sender_init(&g_sender);
+    akita_fragment_reassembler_init(&g_reassembler);
+    AKITA_CHECK(akita_fragment_sender_begin(&g_sender, 0x1234U, AKITA_MESSAGE_EVENT, g_payload, sizeof(g_payload),
+                                            AKITA_FRAME_MAX_LEN, 1000U) == 3U);
+
+    for (index = 0; index < 3U; ++index) {
+        lengths[index] = akita_fragment_sender_next(&g_sender, 1000U, frames[index], sizeof(frames[index]), &message_class);
+        AKITA_CHECK(lengths[index] > AKITA_FRAGMENT_HEADER_LEN);
+        AKITA_CHECK(message_class == AKITA_MESSAGE_EVENT);
+        akita_fragment_sender_mark_sent(&g_sender, frames[index], lengths[index]);
+    }
+    AKITA_CHECK(akita_fragment_sender_next(&g_sender, 1000U, frames[0], sizeof(frames[0]), NULL) == 0U);
+    /* Even split: 234 + 234 + 232 rather than 249 + 249 + 202. */
+    AKITA_CHECK(lengths[0] == AKITA_FRAGMENT_HEADER_LEN + 234U);
+    AKITA_CHECK(lengths[2] == AKITA_FRAGMENT_HEADER_LEN + 232U);
+
+    /* Out of order and repeated fragments still reassemble exactly once. */
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[2], lengths[2], 1100U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_PENDING);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[0], lengths[0], 1200U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_PENDING);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[0], lengths[0], 1250U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_DUPLICATE);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[1], lengths[1], 1300U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_COMPLETE);
+    AKITA_CHECK(message_len == sizeof(g_payload));
+    AKITA_CHECK(memcmp(g_message, g_payload, sizeof(g_payload)) == 0);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[1], lengths[1], 1400U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_DUPLICATE);
+    AKITA_CHECK(akita_fragment_reassembler_poll(&g_reassembler, 1400U + AKITA_FRAGMENT_NACK_DELAY_MS, g_message, sizeof(g_message)) == 0U);
+    AKITA_CHECK(g_reassembler.completed == 1U);
+
+    /* Truncated and malformed fragments are rejected. */
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[0], lengths[0] - 1U, 1500U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_INVALID);
+    frames[0][4] = 0x31U;
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[0], lengths[0], 1500U, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_INVALID);
+    return 0;
+}
+
+static int akita_check_selective_retransmit(void) {
+    uint8_t frames[4][32];
+    size_t lengths[4];
+    uint8_t nack[AKITA_FRAGMENT_NACK_LEN];
+    uint8_t retransmit[32];
+    size_t retransmit_len;
+    size_t message_len = 0;
+    uint64_t now_ms = 5000U;
+    size_t index;
+
+    akita_fragment_sender_init(&g_sender);
+    akita_fragment_reassembler_init(&g_reassembler);
+    AKITA_CHECK(akita_fragment_sender_begin(&g_sender, 0xBEEFU, AKITA_MESSAGE_EVENT, g_payload, 60U, 24U, now_ms) == 4U);
+    for (index = 0; index < 4U; ++index) {
+        lengths[index] = akita_fragment_sender_next(&g_sender, now_ms, frames[index], sizeof(frames[index]), NULL);
+        AKITA_CHECK(lengths[index] > 0U && lengths[index] <= 24U);
+        akita_fragment_sender_mark_sent(&g_sender, frames[index], lengths[index]);
+    }
+
+    /* Fragments 1 and 3 are lost on the air. */
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[0], lengths[0], now_ms, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_PENDING);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frames[2], lengths[2], now_ms, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_PENDING);
+    AKITA_CHECK(akita_fragment_reassembler_poll(&g_reassembler, now_ms + 100U, nack, sizeof(nack)) == 0U);
+
+    now_ms += AKITA_FRAGMENT_NACK_DELAY_MS;
+    AKITA_CHECK(akita_fragment_reassembler_poll(&g_reassembler, now_ms, nack, sizeof(nack)) == AKITA_FRAGMENT_NACK_LEN);
+    AKITA_CHECK((nack[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_NACK);
+    AKITA_CHECK(nack[4] == 0x0AU && nack[5] == 0U);
+
+    /* Only the missing fragments go out again. */
+    AKITA_CHECK(akita_fragment_sender_on_nack(&g_sender, nack, sizeof(nack), now_ms));
+    AKITA_CHECK(g_sender.fragments_resent == 2U);
+    retransmit_len = akita_fragment_sender_next(&g_sender, now_ms, retransmit, sizeof(retransmit), NULL);
+    AKITA_CHECK(retransmit_len == lengths[1] && memcmp(retransmit, frames[1], retransmit_len) == 0);
+    akita_fragment_sender_mark_sent(&g_sender, retransmit, retransmit_len);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, retransmit, retransmit_len, now_ms, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_PENDING);
+    retransmit_len = akita_fragment_sender_next(&g_sender, now_ms, retransmit, sizeof(retransmit), NULL);
+    AKITA_CHECK(retransmit_len == lengths[3]);
+    akita_fragment_sender_mark_sent(&g_sender, retransmit, retransmit_len);
+    AKITA_CHECK(akita_fragment_sender_next(&g_sender, now_ms, retransmit, sizeof(retransmit), NULL) == 0U);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, retransmit, retransmit_len, now_ms, g_message, sizeof(g_message), &message_len) == AKITA_FRAGMENT_COMPLETE);
+    AKITA_CHECK(message_len == 60U && memcmp(g_message, g_payload, 60U) == 0);
+
+    /* A NACK for a message the sender no longer holds is ignored. */
+    AKITA_CHECK(!akita_fragment_sender_on_nack(&g_sender, nack, sizeof(nack), now_ms + AKITA_FRAGMENT_RETAIN_MS));
+    AKITA_CHECK(g_sender.nacks_ignored == 1U);
+    return 0;
+}
+
+static int akita_check_expiry(void) {
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    uint8_t nack[AKITA_FRAGMENT_NACK_LEN];
+    size_t frame_len;
+    size_t nacks = 0;
+    uint64_t now_ms = 10000U;
+
+    akita_fragment_sender_init(&g_sender);
+    akita_fragment_reassembler_init(&g_reassembler);
+    AKITA_CHECK(akita_fragment_sender_begin(&g_sender, 0x0001U, AKITA_MESSAGE_BULK, g_payload, 300U, AKITA_FRAME_MAX_LEN, now_ms) == 2U);
+    frame_len = akita_fragment_sender_next(&g_sender, now_ms, frame, sizeof(frame), NULL);
+    AKITA_CHECK(akita_fragment_reassembler_push(&g_reassembler, frame, frame_len, now_ms, g_message, sizeof(g_message), NULL) == AKITA_FRAGMENT_PENDING);
+
+    /* The receiver asks a bounded number of times, then gives up. */
+    while (now_ms < 10000U + 120000U) {
+        now_ms += 1000U;
+        if (akita_fragment_reassembler_poll(&g_reassembler, now_ms, nack, sizeof(nack)) > 0U) {
+            ++nacks;
+        }
+    }
+    AKITA_CHECK(nacks == AKITA_FRAGMENT_MAX_NACKS);
+    AKITA_CHECK(g_reassembler.expired == 1U);
+    AKITA_CHECK(!g_reassembler.slots[0].in_use);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_counts() != 0 ||
+        akita_check_round_trip() != 0 ||
+        akita_check_selective_retransmit() != 0 ||
+        akita_check_expiry() != 0) {
+        return 1;
+    }
+
+    printf("fragment checks passed\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "fragment_reassembler.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+static uint8_t akita_fragment_header(akita_frame_type_t type) {
+    return (uint8_t) ((AKITA_FRAME_VERSION << 4) | ((uint8_t) type & AKITA_FRAME_HEADER_TYPE_MASK));
+}
+
+static uint16_t akita_fragment_node_tag(const uint8_t *frame) {
+    return (uint16_t) (frame[1] | ((uint16_t) frame[2] << 8));
+}
+
+static uint16_t akita_fragment_full_mask(uint8_t count) {
+    return (uint16_t) ((1UL << count) - 1UL);
+}
+
+void akita_fragment_reassembler_init(akita_fragment_reassembler_t *reassembler) {
+    if (reassembler != NULL) {
+        memset(reassembler, 0, sizeof(*reassembler));
+    }
+}
+
+static akita_fragment_slot_t *akita_fragment_reassembler_slot(
+    akita_fragment_reassembler_t *reassembler,
+    uint16_t node_tag,
+    uint8_t message_id
+) {
+    akita_fragment_slot_t *victim = NULL;
+    size_t index;
+
+    for (index = 0; index < AKITA_FRAGMENT_REASSEMBLY_SLOTS; ++index) {
+        akita_fragment_slot_t *slot = &reassembler->slots[index];
+
+        if (slot->in_use && slot->node_tag == node_tag && slot->message_id == message_id) {
+            return slot;
+        }
+    }
+
+    /* Prefer a free slot, then the least recently active one. */
+    for (index = 0; index < AKITA_FRAGMENT_REASSEMBLY_SLOTS; ++index) {
+        akita_fragment_slot_t *slot = &reassembler->slots[index];
+
+        if (!slot->in_use) {
+            victim = slot;
+            break;
+        }
+        if (victim == NULL || slot->last_ms < victim->last_ms) {
+            victim = slot;
+        }
+    }
+
+    if (victim->in_use && victim->received_mask != akita_fragment_full_mask(victim->count)) {
+        ++reassembler->evicted;
+    }
+    memset(victim, 0, offsetof(akita_fragment_slot_t, data));
+    victim->in_use = true;
+    victim->node_tag = node_tag;
+    victim->message_id = message_id;
+    return victim;
+}
+
+akita_fragment_result_t akita_fragment_reassembler_push(
+    akita_fragment_reassembler_t *reassembler,
+    const uint8_t *frame,
+    size_t frame_len,
+    uint64_t now_ms,
+    uint8_t *message,
+    size_t message_size,
+    size_t *message_len
+) {
+    akita_fragment_slot_t *slot;
+    uint8_t index;
+    uint8_t count;
+    uint8_t chunk_len;
+    size_t data_len;
+    size_t total_len;
+
+    if (reassembler == NULL || frame == NULL || frame_len < AKITA_FRAGMENT_HEADER_LEN + 1U ||
+        (frame[0] >> 4) != AKITA_FRAME_VERSION ||
+        (frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) != (uint8_t) AKITA_FRAME_TYPE_FRAGMENT) {
+        return AKITA_FRAGMENT_INVALID;
+    }
+
+    index = (uint8_t) (frame[4] >> 4);
+    count = (uint8_t) ((frame[4] & 0x0FU) + 1U);
+    chunk_len = frame[5];
+    data_len = frame_len - AKITA_FRAGMENT_HEADER_LEN;
+    if (index >= count || chunk_len == 0U || data_len > chunk_len || (index + 1U < count && data_len != chunk_len) ||
+        (size_t) (count - 1U) * chunk_len >= AKITA_FRAGMENT_MAX_MESSAGE_LEN ||
+        (size_t) index * chunk_len + data_len > AKITA_FRAGMENT_MAX_MESSAGE_LEN) {
+        return AKITA_FRAGMENT_INVALID;
+    }
+
+    slot = akita_fragment_reassembler_slot(reassembler, akita_fragment_node_tag(frame), frame[3]);
+    if (slot->count != 0U && (slot->count != count || slot->chunk_len != chunk_len)) {
+        /* The message ID wrapped around onto a new message. */
+        memset(slot, 0, offsetof(akita_fragment_slot_t, data));
+        slot->in_use = true;
+        slot->node_tag = akita_fragment_node_tag(frame);
+        slot->message_id = frame[3];
+    }
+    if (slot->count == 0U) {
+        slot->count = count;
+        slot->chunk_len = chunk_len;
+        slot->first_ms = now_ms;
+    }
+    slot->last_ms = now_ms;
+
+    if ((slot->received_mask & (1U << index)) != 0U) {
+        return AKITA_FRAGMENT_DUPLICATE;
+    }
+
+    memcpy(&slot->data[(size_t) index * chunk_len], &frame[AKITA_FRAGMENT_HEADER_LEN], data_len);
+    slot->received_mask |= (uint16_t) (1U << index);
+    if (index + 1U == count) {
+        slot->last_len = (uint8_t) data_len;
+    }
+    if (slot->received_mask != akita_fragment_full_mask(count)) {
+        return AKITA_FRAGMENT_PENDING;
+    }
+
+    /* Completed slots stay until they expire so late repeats are reported as duplicates. */
+    total_len = (size_t) (count - 1U) * chunk_len + slot->last_len;
+    ++reassembler->completed;
+    if (message == NULL || message_size < total_len) {
+        return AKITA_FRAGMENT_INVALID;
+    }
+
+    memcpy(message, slot->data, total_len);
+    if (message_len != NULL) {
+        *message_len = total_len;
+    }
+    return AKITA_FRAGMENT_COMPLETE;
+}
+
+size_t akita_fragment_reassembler_poll(
+    akita_fragment_reassembler_t *reassembler,
+    uint64_t now_ms,
+    uint8_t *nack,
+    size_t nack_size
+) {
+    size_t index;
+
+    if (reassembler == NULL) {
+        return 0;
+    }
+
+    for (index = 0; index < AKITA_FRAGMENT_REASSEMBLY_SLOTS; ++index) {
+        akita_fragment_slot_t *slot = &reassembler->slots[index];
+        uint16_t missing;
+
+        if (!slot->in_use) {
+            continue;
+        }
+
+        missing = (uint16_t) (akita_fragment_full_mask(slot->count) & ~slot->received_mask);
+        if (now_ms - slot->last_ms >= AKITA_FRAGMENT_REASSEMBLY_TIMEOUT_MS) {
+            if (missing != 0U) {
+                ++reassembler->expired;
+            }
+            slot->in_use = false;
+            continue;
+        }
+
+        if (missing == 0U || slot->nacks_sent >= AKITA_FRAGMENT_MAX_NACKS ||
+            now_ms - slot->last_ms < AKITA_FRAGMENT_NACK_DELAY_MS ||
+            nack == NULL || nack_size < AKITA_FRAGMENT_NACK_LEN) {
+            continue;
+        }
+
+        nack[0] = akita_fragment_header(AKITA_FRAME_TYPE_NACK);
+        nack[1] = (uint8_t) (slot->node_tag & 0xFFU);
+        nack[2] = (uint8_t) (slot->node_tag >> 8);
+        nack[3] = slot->message_id;
+        nack[4] = (uint8_t) (missing & 0xFFU);
+        nack[5] = (uint8_t) (missing >> 8);
+        ++slot->nacks_sent;
+        slot->last_ms = now_ms;
+        return AKITA_FRAGMENT_NACK_LEN;
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#ifndef AKITA_FRAGMENT_REASSEMBLER_H
+#define AKITA_FRAGMENT_REASSEMBLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_fragment.h"
+
+#define AKITA_FRAGMENT_REASSEMBLY_SLOTS 4U
+#define AKITA_FRAGMENT_REASSEMBLY_TIMEOUT_MS 20000U
+#define AKITA_FRAGMENT_NACK_DELAY_MS 3000U
+#define AKITA_FRAGMENT_MAX_NACKS 3U
+
+/*
+ * The receiving end of akita_fragment.c, standing in for the bridge so the sender can be checked against it.
+ * The gateway forwards fragments as they arrive; tools/akita_reticulum_bridge.py is the reassembler in service.
+ */
+typedef enum {
+    AKITA_FRAGMENT_INVALID = 0,
+    AKITA_FRAGMENT_PENDING,
+    AKITA_FRAGMENT_DUPLICATE,
+    AKITA_FRAGMENT_COMPLETE,
+} akita_fragment_result_t;
+
+typedef struct {
+    bool in_use;
+    uint16_t node_tag;
+    uint8_t message_id;
+    uint8_t count;
+    uint8_t chunk_len;
+    uint8_t last_len;
+    uint8_t nacks_sent;
+    uint16_t received_mask;
+    uint64_t first_ms;
+    uint64_t last_ms;
+    uint8_t data[AKITA_FRAGMENT_MAX_MESSAGE_LEN];
+} akita_fragment_slot_t;
+
+typedef struct {
+    akita_fragment_slot_t slots[AKITA_FRAGMENT_REASSEMBLY_SLOTS];
+    uint32_t completed;
+    uint32_t expired;
+    uint32_t evicted;
+} akita_fragment_reassembler_t;
+
+void akita_fragment_reassembler_init(akita_fragment_reassembler_t *reassembler);
+akita_fragment_result_t akita_fragment_reassembler_push(
+    akita_fragment_reassembler_t *reassembler,
+    const uint8_t *frame,
+    size_t frame_len,
+    uint64_t now_ms,
+    uint8_t *message,
+    size_t message_size,
+    size_t *message_len
+);
+size_t akita_fragment_reassembler_poll(
+    akita_fragment_reassembler_t *reassembler,
+    uint64_t now_ms,
+    uint8_t *nack,
+    size_t nack_size
+);
+
+#endif
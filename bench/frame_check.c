@@ -0,0 +1,179 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_frame.h"
+#include "bench_support.h"
+
+/* The keyframe the bridge tests decode, in tools/test_akita_reticulum_bridge.py. */
+static const char kKeyframeHex[] =
+    "1810e200030c416b6974614361724e6f6465c0c40756e43200b001b8cfa82bc9b09848fe0a081200a802";
+/* The rule event sent right after it, in the same tests. */
+static const char kEventHex[] = "1510e20100fa01810002a4a3010b636f6f6c616e745f686f74";
+
+static akita_runtime_config_t g_config;
+static akita_vehicle_telemetry_t g_telemetry;
+
+static int akita_check_wire_ids(void) {
+    /* Released wire ids never move; old bridges decode new firmware by them. */
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_OBD_CONNECTED == 0);
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_GPS_FIX == 1);
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_CONFIG_PORTAL_READY == 2);
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_TRANSPORT_READY == 3);
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_WIFI_READY == 4);
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_LORA_READY == 5);
+    AKITA_CHECK(AKITA_FRAME_FLAG_BIT_COUNT == 6U);
+
+    AKITA_CHECK(AKITA_FRAME_FIELD_FLAGS == 0);
+    AKITA_CHECK(AKITA_FRAME_FIELD_OBD_RPM == 1);
+    AKITA_CHECK(AKITA_FRAME_FIELD_OBD_SPEED == 2);
+    AKITA_CHECK(AKITA_FRAME_FIELD_OBD_COOLANT == 3);
+    AKITA_CHECK(AKITA_FRAME_FIELD_GPS_LAT == 4);
+    AKITA_CHECK(AKITA_FRAME_FIELD_GPS_LON == 5);
+    AKITA_CHECK(AKITA_FRAME_FIELD_GPS_ALT == 6);
+    AKITA_CHECK(AKITA_FRAME_FIELD_GPS_SPEED == 7);
+    AKITA_CHECK(AKITA_FRAME_FIELD_GPS_SATS == 8);
+    AKITA_CHECK(AKITA_FRAME_FIELD_WIFI_RSSI == 9);
+    AKITA_CHECK(AKITA_FRAME_FIELD_FREE_HEAP == 10);
+    AKITA_CHECK(AKITA_FRAME_FIELD_COUNT == 11U);
+    return 0;
+}
+
+static int akita_check_keyframe_bytes(void) {
+    akita_frame_encoder_t encoder;
+    uint8_t expected[AKITA_FRAME_MAX_LEN];
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    size_t expected_len = strlen(kKeyframeHex) / 2U;
+    size_t frame_len;
+    size_t index;
+
+    for (index = 0; index < expected_len; ++index) {
+        unsigned value;
+        AKITA_CHECK(sscanf(&kKeyframeHex[index * 2U], "%2x", &value) == 1);
+        expected[index] = (uint8_t) value;
+    }
+
+    g_config.board_profile = AKITA_BOARD_HELTEC_LORA32_V2;
+    strcpy(g_config.vehicle_id, "AkitaCarNode");
+    g_telemetry.obd.connected = true;
+    g_telemetry.obd.rpm = 812.5f;
+    g_telemetry.obd.coolant_c = 88.0f;
+    g_telemetry.gps.fix = true;
+    g_telemetry.gps.latitude = 45.421532f;
+    g_telemetry.gps.longitude = -75.697189f;
+    g_telemetry.gps.altitude_m = 70.3f;
+    g_telemetry.gps.speed_kmh = 0.4f;
+    g_telemetry.gps.satellites = 9;
+    g_telemetry.system.transport_ready = true;
+    g_telemetry.system.lora_ready = true;
+    g_telemetry.system.free_heap = 148U * 1024U;
+
+    akita_frame_encoder_init(&encoder, g_config.vehicle_id, 0);
+    frame_len = akita_frame_encode(&encoder, &g_config, &g_telemetry, 123456U, frame, sizeof(frame));
+    AKITA_CHECK(frame_len == expected_len);
+    AKITA_CHECK(memcmp(frame, expected, expected_len) == 0);
+
+    /* A keyframe that does not fit is not sent cut short. */
+    akita_frame_encoder_init(&encoder, g_config.vehicle_id, 0);
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, 123456U, frame, expected_len - 1U) == 0U);
+    return 0;
+}
+
+static int akita_check_event_bytes(void) {
+    akita_frame_encoder_t encoder;
+    akita_frame_event_t event = {
+        .source = AKITA_FRAME_EVENT_RULE,
+        .action = 0,
+        .id = 2U,
+        .value = 104.5f,
+        .name = "coolant_hot",
+    };
+    uint8_t expected[AKITA_FRAME_MAX_LEN];
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    size_t expected_len = strlen(kEventHex) / 2U;
+    size_t frame_len;
+    size_t index;
+
+    for (index = 0; index < expected_len; ++index) {
+        unsigned value;
+        AKITA_CHECK(sscanf(&kEventHex[index * 2U], "%2x", &value) == 1);
+        expected[index] = (uint8_t) value;
+    }
+
+    /* An event names a keyframe, so there is nothing to send before the first one. */
+    akita_frame_encoder_init(&encoder, g_config.vehicle_id, 0);
+    AKITA_CHECK(akita_frame_encode_event(&encoder, &event, 123706U, frame, sizeof(frame)) == 0U);
+
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, 123456U, frame, sizeof(frame)) > 0U);
+    frame_len = akita_frame_encode_event(&encoder, &event, 123706U, frame, sizeof(frame));
+    AKITA_CHECK(frame_len == expected_len);
+    AKITA_CHECK(memcmp(frame, expected, expected_len) == 0);
+    AKITA_CHECK(akita_frame_encode_event(&encoder, &event, 123706U, frame, expected_len - 1U) == 0U);
+
+    /* A geofence exit without a value drops the value and keeps the fence id. */
+    event.source = AKITA_FRAME_EVENT_GEOFENCE;
+    event.action = 1U;
+    event.id = 300U;
+    event.value = NAN;
+    event.name = "geofence_exit";
+    frame_len = akita_frame_encode_event(&encoder, &event, 123456U, frame, sizeof(frame));
+    AKITA_CHECK(frame_len == 11U + strlen(event.name));
+    AKITA_CHECK(frame[3] == 2U && frame[4] == 0U && frame[5] == 0U);
+    AKITA_CHECK(frame[6] == AKITA_FRAME_EVENT_GEOFENCE && frame[7] == 1U);
+    AKITA_CHECK(frame[8] == 0xACU && frame[9] == 0x02U);
+    return 0;
+}
+
+static int akita_ack(akita_frame_encoder_t *encoder, uint8_t sequence) {
+    uint8_t ack[AKITA_FRAME_HEADER_LEN + 1U];
+    size_t ack_len = akita_frame_write_ack(encoder->node_tag, sequence, AKITA_FRAME_ACK_SNR_UNKNOWN, ack, sizeof(ack));
+
+    return ack_len > 0U && akita_frame_encoder_on_ack(encoder, ack, ack_len);
+}
+
+static int akita_check_acked_reference(void) {
+    akita_frame_encoder_t encoder;
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    uint64_t now_ms = 200000U;
+    uint8_t index;
+
+    akita_frame_encoder_init(&encoder, g_config.vehicle_id, 0);
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, now_ms, frame, sizeof(frame)) > 0U);
+    AKITA_CHECK((frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_KEYFRAME && frame[3] == 0U);
+    AKITA_CHECK(akita_ack(&encoder, 0U));
+
+    /* Until keyframe 1 is acknowledged, deltas still name keyframe 0, which the receiver is known to hold. */
+    akita_frame_encoder_request_keyframe(&encoder);
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, now_ms += 1000U, frame, sizeof(frame)) > 0U);
+    AKITA_CHECK((frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_KEYFRAME && frame[3] == 1U);
+    g_telemetry.obd.rpm = 2000.0f;
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, now_ms += 1000U, frame, sizeof(frame)) > 0U);
+    AKITA_CHECK((frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_DELTA && frame[4] == 0U);
+
+    AKITA_CHECK(akita_ack(&encoder, 1U));
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, now_ms += 1000U, frame, sizeof(frame)) > 0U);
+    AKITA_CHECK((frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_DELTA && frame[4] == 1U);
+
+    /* Once the receiver may have dropped the acknowledged keyframe from its history, deltas go against the newest. */
+    for (index = 0; index < AKITA_FRAME_KEYFRAME_HISTORY; ++index) {
+        akita_frame_encoder_request_keyframe(&encoder);
+        AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, now_ms += 1000U, frame, sizeof(frame)) > 0U);
+        AKITA_CHECK((frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_KEYFRAME);
+    }
+    AKITA_CHECK(akita_frame_encode(&encoder, &g_config, &g_telemetry, now_ms += 1000U, frame, sizeof(frame)) > 0U);
+    AKITA_CHECK((frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_DELTA);
+    AKITA_CHECK(frame[4] == (uint8_t) (frame[3] - 1U));
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_wire_ids() != 0 ||
+        akita_check_keyframe_bytes() != 0 ||
+        akita_check_event_bytes() != 0 ||
+        akita_check_acked_reference() != 0) {
+        return 1;
+    }
+
+    printf("frame checks passed\n");
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_fusion.h"
+#include "bench_support.h"
+
+#define AKITA_STEP_MS 100U
+#define AKITA_ORIGIN_LAT 45.5
+#define AKITA_ORIGIN_LON -73.56
+#define AKITA_M_PER_DEG 111320.0
+#define AKITA_PI 3.14159265358979323846
+/* The speedometer reads 4% high, as most do. */
+#define AKITA_OBD_OVERREAD 1.04
+#define AKITA_GPS_SIGMA_M 3.0
+
+#if CONFIG_AKITA_FUSION_FIXED
+#define AKITA_FUSION_MATH "fixed"
+#else
+#define AKITA_FUSION_MATH "float"
+#endif
+
+typedef struct {
+    uint32_t end_s;
+    double speed_kmh;
+    double turn_dps;
+    int gps;
+} akita_leg_t;
+
+/* Town, a long curve on the highway, a 60 s straight tunnel, out again and stop. */
+static const akita_leg_t kDrive[] = {
+    {20U, 60.0, 0.0, 1},
+    {200U, 90.0, 0.25, 1},
+    {260U, 80.0, 0.0, 0},
+    {320U, 80.0, 0.0, 1},
+    {340U, 0.0, 0.0, 1},
+};
+
+typedef struct {
+    double east_m;
+    double north_m;
+    double heading_deg;
+    double speed_kmh;
+} akita_truth_t;
+
+static akita_fusion_t g_fusion;
+static akita_fusion_output_t g_output;
+static akita_gps_snapshot_t g_gps;
+static akita_obd_snapshot_t g_obd;
+static akita_truth_t g_truth;
+static uint32_t g_seed = 4242U;
+
+static double akita_noise(double sigma) {
+    double sum = 0.0;
+    int index;
+
+    for (index = 0; index < 4; ++index) {
+        g_seed = g_seed * 1664525U + 1013904223U;
+        sum += (double) (g_seed >> 8) / 16777216.0 - 0.5;
+    }
+
+    return sum * sigma * 1.7;
+}
+
+static double akita_lon_m_per_deg(void) {
+    return AKITA_M_PER_DEG * cos(AKITA_ORIGIN_LAT * AKITA_PI / 180.0);
+}
+
+static void akita_truth_step(const akita_leg_t *leg) {
+    double dt = AKITA_STEP_MS / 1000.0;
+    double change = leg->speed_kmh - g_truth.speed_kmh;
+
+    /* Speed changes at up to 3 m/s^2. */
+    if (fabs(change) > 10.8 * dt) {
+        change = change > 0.0 ? 10.8 * dt : -10.8 * dt;
+    }
+    g_truth.speed_kmh += change;
+    g_truth.heading_deg += leg->turn_dps * dt;
+    g_truth.east_m += sin(g_truth.heading_deg * AKITA_PI / 180.0) * g_truth.speed_kmh / 3.6 * dt;
+    g_truth.north_m += cos(g_truth.heading_deg * AKITA_PI / 180.0) * g_truth.speed_kmh / 3.6 * dt;
+}
+
+static double akita_error_m(const akita_fusion_output_t *output) {
+    double north = ((double) output->latitude_e6 * 1.0e-6 - AKITA_ORIGIN_LAT) * AKITA_M_PER_DEG;
+    double east = ((double) output->longitude_e6 * 1.0e-6 - AKITA_ORIGIN_LON) * akita_lon_m_per_deg();
+
+    return hypot(north - g_truth.north_m, east - g_truth.east_m);
+}
+
+typedef struct {
+    double fused_sq;
+    double raw_sq;
+    uint32_t samples;
+    double tunnel_exit_m;
+    double recovered_m;
+    uint32_t dead_reckoned;
+} akita_replay_result_t;
+
+/* Replays the drive: GPS at 1 Hz when in view, OBD speed on every 100 ms step. */
+static int akita_replay(bool with_obd, akita_replay_result_t *result, uint64_t *elapsed_ns) {
+    uint64_t now_ms = 1000U;
+    uint64_t fix_ms = 0;
+    uint32_t step;
+    size_t leg = 0;
+
+    memset(result, 0, sizeof(*result));
+    memset(&g_truth, 0, sizeof(g_truth));
+    memset(&g_gps, 0, sizeof(g_gps));
+    memset(&g_obd, 0, sizeof(g_obd));
+    g_truth.heading_deg = 45.0;
+    g_truth.speed_kmh = 30.0;
+    akita_fusion_init(&g_fusion);
+    *elapsed_ns = 0;
+
+    for (step = 0; leg < sizeof(kDrive) / sizeof(kDrive[0]); ++step) {
+        uint64_t start_ns;
+        double raw_north = 0.0;
+        double raw_east = 0.0;
+        bool new_fix = false;
+
+        if (step * AKITA_STEP_MS >= kDrive[leg].end_s * 1000U) {
+            ++leg;
+            if (leg == sizeof(kDrive) / sizeof(kDrive[0])) {
+                break;
+            }
+        }
+
+        now_ms += AKITA_STEP_MS;
+        akita_truth_step(&kDrive[leg]);
+
+        if (kDrive[leg].gps && step % 10U == 0U) {
+            raw_north = g_truth.north_m + akita_noise(AKITA_GPS_SIGMA_M);
+            raw_east = g_truth.east_m + akita_noise(AKITA_GPS_SIGMA_M);
+            g_gps.fix = true;
+            g_gps.latitude = (float) (AKITA_ORIGIN_LAT + raw_north / AKITA_M_PER_DEG);
+            g_gps.longitude = (float) (AKITA_ORIGIN_LON + raw_east / akita_lon_m_per_deg());
+            g_gps.speed_kmh = (float) (g_truth.speed_kmh + akita_noise(0.5));
+            g_gps.course_deg = (float) fmod(g_truth.heading_deg + akita_noise(1.0) + 360.0, 360.0);
+            g_gps.satellites = 9U;
+            fix_ms = now_ms;
+            new_fix = true;
+        }
+        g_gps.fix_ms = fix_ms;
+        g_gps.age_ms = g_gps.fix ? (uint32_t) (now_ms - fix_ms) : 0U;
+        if (!kDrive[leg].gps) {
+            g_gps.fix = false;
+        }
+        g_obd.connected = with_obd;
+        g_obd.speed_kmh = with_obd ? (float) (g_truth.speed_kmh * AKITA_OBD_OVERREAD) : 0.0f;
+
+        start_ns = akita_bench_now_ns();
+        akita_fusion_step(&g_fusion, &g_gps, &g_obd, AKITA_FUSION_NO_YAW, now_ms);
+        akita_fusion_output(&g_fusion, now_ms, &g_output);
+        *elapsed_ns += akita_bench_now_ns() - start_ns;
+
+        if (g_output.dead_reckoning && g_output.valid) {
+            ++result->dead_reckoned;
+        }
+
+        /* Smoothing is scored on the highway, once the filter has settled. */
+        if (new_fix && now_ms > 60000U && kDrive[leg].end_s == 200U) {
+            result->fused_sq += akita_error_m(&g_output) * akita_error_m(&g_output);
+            result->raw_sq += (raw_north - g_truth.north_m) * (raw_north - g_truth.north_m) +
+                              (raw_east - g_truth.east_m) * (raw_east - g_truth.east_m);
+            ++result->samples;
+        }
+        if (step * AKITA_STEP_MS == 260000U - AKITA_STEP_MS) {
+            result->tunnel_exit_m = g_output.valid ? akita_error_m(&g_output) : -1.0;
+            AKITA_CHECK(g_output.dead_reckoning);
+        }
+        if (step * AKITA_STEP_MS == 270000U) {
+            result->recovered_m = akita_error_m(&g_output);
+            AKITA_CHECK(!g_output.dead_reckoning);
+        }
+    }
+
+    return 0;
+}
+
+static int akita_check_fusion(void) {
+    akita_replay_result_t result;
+    uint64_t elapsed_ns;
+    double fused_rms;
+    double raw_rms;
+
+    AKITA_CHECK(akita_replay(true, &result, &elapsed_ns) == 0);
+    fused_rms = sqrt(result.fused_sq / result.samples);
+    raw_rms = sqrt(result.raw_sq / result.samples);
+    printf("%s: %u steps, %.0f ns per step, highway rms %.2f m (raw GPS %.2f m), tunnel exit %.1f m, "
+           "10 s later %.1f m, OBD scale %.3f\n",
+           AKITA_FUSION_MATH, (unsigned) g_fusion.steps, (double) elapsed_ns / g_fusion.steps, fused_rms, raw_rms,
+           result.tunnel_exit_m, result.recovered_m, (double) AKITA_FX_TO_FLOAT(g_fusion.obd_scale));
+
+    AKITA_CHECK(fused_rms < raw_rms * 0.8);
+    /* 1.3 km underground on OBD speed alone, after the speedometer error has been learned. */
+    AKITA_CHECK(result.tunnel_exit_m >= 0.0 && result.tunnel_exit_m < 15.0);
+    AKITA_CHECK(result.recovered_m < 10.0);
+    AKITA_CHECK(result.dead_reckoned >= 550U);
+    AKITA_CHECK(fabs(AKITA_FX_TO_FLOAT(g_fusion.obd_scale) - 1.0 / AKITA_OBD_OVERREAD) < 0.01);
+    return 0;
+}
+
+static int akita_check_without_obd(void) {
+    akita_replay_result_t result;
+    uint64_t elapsed_ns;
+
+    /* GPS speed is only held for a few seconds, so the tunnel is a gap rather than a wrong position. */
+    AKITA_CHECK(akita_replay(false, &result, &elapsed_ns) == 0);
+    AKITA_CHECK(result.tunnel_exit_m < 0.0);
+    AKITA_CHECK(result.dead_reckoned <= AKITA_FUSION_COAST_MS / AKITA_STEP_MS);
+    AKITA_CHECK(result.recovered_m < 10.0);
+    return 0;
+}
+
+static int akita_check_repeated_fix(void) {
+    uint64_t now_ms = 1000U;
+    uint32_t step;
+
+    /* The reader measures age_ms against its own clock read, so it drifts a millisecond either way between polls. */
+    memset(&g_gps, 0, sizeof(g_gps));
+    memset(&g_obd, 0, sizeof(g_obd));
+    akita_fusion_init(&g_fusion);
+    g_gps.fix = true;
+    g_gps.latitude = (float) AKITA_ORIGIN_LAT;
+    g_gps.longitude = (float) AKITA_ORIGIN_LON;
+    g_gps.fix_ms = now_ms;
+    for (step = 0; step < 10U; ++step) {
+        now_ms += AKITA_STEP_MS;
+        g_gps.age_ms = (uint32_t) (now_ms - g_gps.fix_ms) + (step % 2U == 0U ? 1U : 0U);
+        akita_fusion_step(&g_fusion, &g_gps, &g_obd, AKITA_FUSION_NO_YAW, now_ms);
+    }
+    AKITA_CHECK(g_fusion.fixes == 1U);
+
+    g_gps.fix_ms = now_ms;
+    g_gps.age_ms = 0U;
+    akita_fusion_step(&g_fusion, &g_gps, &g_obd, AKITA_FUSION_NO_YAW, now_ms + AKITA_STEP_MS);
+    AKITA_CHECK(g_fusion.fixes == 2U);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_fusion() != 0 ||
+        akita_check_without_obd() != 0 ||
+        akita_check_repeated_fix() != 0) {
+        return 1;
+    }
+
+    printf("fusion checks passed (%s)\n", AKITA_FUSION_MATH);
+    return 0;
+}
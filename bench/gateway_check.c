@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_gateway.h"
+#include "bench_support.h"
+
+static akita_gateway_t g_gateway;
+
+static int akita_check_dedupe(void) {
+    const akita_link_quality_t link = {.rssi_dbm = -97, .snr_quarter_db = -22};
+    const uint8_t keyframe[] = {0x18, 0x10, 0xE2, 0x00, 0x03};
+    const uint8_t delta[] = {0x11, 0x10, 0xE2, 0x01, 0x00};
+    const uint8_t json[] = {'{', '}'};
+
+    akita_gateway_init(&g_gateway);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 1000U) == AKITA_GATEWAY_ADDED);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, delta, sizeof(delta), 1010U) == AKITA_GATEWAY_ADDED);
+
+    /* A second gateway path or a node retry inside the window is the same frame. */
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 1200U) == AKITA_GATEWAY_DUPLICATE);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 1000U + AKITA_GATEWAY_DEDUPE_MS - 1U) ==
+                AKITA_GATEWAY_DUPLICATE);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 1000U + AKITA_GATEWAY_DEDUPE_MS) ==
+                AKITA_GATEWAY_ADDED);
+
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, json, sizeof(json), 2000U) == AKITA_GATEWAY_REJECTED);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, 0U, 2000U) == AKITA_GATEWAY_REJECTED);
+    AKITA_CHECK(g_gateway.count == 3U);
+    AKITA_CHECK(g_gateway.counters.received == 3U);
+    AKITA_CHECK(g_gateway.counters.duplicates == 2U);
+    return 0;
+}
+
+static int akita_check_dedupe_pressure(void) {
+    const akita_link_quality_t link = {.rssi_dbm = -110, .snr_quarter_db = -40};
+    uint8_t frame[8] = {0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    uint32_t index;
+
+    /* More distinct frames than slots must still be accepted; old hashes are evicted, not refused. */
+    akita_gateway_init(&g_gateway);
+    for (index = 0; index < AKITA_GATEWAY_DEDUPE_SLOTS * 4U; ++index) {
+        frame[1] = (uint8_t) index;
+        frame[2] = (uint8_t) (index >> 8);
+        AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, frame, sizeof(frame), 5000U + index) == AKITA_GATEWAY_ADDED);
+        akita_gateway_clear(&g_gateway, true);
+    }
+    AKITA_CHECK(g_gateway.counters.duplicates == 0U);
+
+    /* The most recent frame is still remembered. */
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, frame, sizeof(frame), 6000U) == AKITA_GATEWAY_DUPLICATE);
+    return 0;
+}
+
+static int akita_check_failed_forward(void) {
+    const akita_link_quality_t link = {.rssi_dbm = -97, .snr_quarter_db = -22};
+    const uint8_t keyframe[] = {0x18, 0x10, 0xE2, 0x07, 0x03};
+    const uint8_t delta[] = {0x11, 0x10, 0xE2, 0x08, 0x07};
+
+    akita_gateway_init(&g_gateway);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 1000U) == AKITA_GATEWAY_ADDED);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, delta, sizeof(delta), 1010U) == AKITA_GATEWAY_ADDED);
+    akita_gateway_clear(&g_gateway, true);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, delta, sizeof(delta), 1500U) == AKITA_GATEWAY_DUPLICATE);
+
+    /* Forward fails, retransmit accepted: the bridge never saw the frame, so the node's resend must reach it. */
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 40000U) == AKITA_GATEWAY_ADDED);
+    akita_gateway_clear(&g_gateway, false);
+    AKITA_CHECK(g_gateway.counters.dropped == 1U);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 40100U) == AKITA_GATEWAY_ADDED);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, keyframe, sizeof(keyframe), 40200U) == AKITA_GATEWAY_DUPLICATE);
+    return 0;
+}
+
+static int akita_check_batch_format(void) {
+    const akita_link_quality_t near = {.rssi_dbm = -61, .snr_quarter_db = 38};
+    const akita_link_quality_t far = {.rssi_dbm = -118, .snr_quarter_db = -51};
+    const uint8_t first[] = {0x18, 0x10, 0xE2, 0x00};
+    const uint8_t second[] = {0x13, 0xAB, 0xCD, 0x07, 0x01};
+    char batch[256];
+    size_t length;
+
+    akita_gateway_init(&g_gateway);
+    AKITA_CHECK(!akita_gateway_flush_due(&g_gateway, 1000U));
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &near, first, sizeof(first), 1000U) == AKITA_GATEWAY_ADDED);
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &far, second, sizeof(second), 1300U) == AKITA_GATEWAY_ADDED);
+    AKITA_CHECK(!akita_gateway_flush_due(&g_gateway, 1000U + AKITA_GATEWAY_BATCH_WINDOW_MS - 1U));
+    AKITA_CHECK(akita_gateway_flush_due(&g_gateway, 1000U + AKITA_GATEWAY_BATCH_WINDOW_MS));
+
+    length = akita_gateway_write_batch(&g_gateway, "Gateway-1", 1500U, batch, sizeof(batch));
+    AKITA_CHECK(length == strlen(batch));
+    AKITA_CHECK(strcmp(batch,
+                       "{\"gateway\":\"Gateway-1\",\"frames\":["
+                       "{\"frame\":\"1810e200\",\"rssi\":-61,\"snr_qdb\":38,\"age_ms\":500},"
+                       "{\"frame\":\"13abcd0701\",\"rssi\":-118,\"snr_qdb\":-51,\"age_ms\":200}]}") == 0);
+    AKITA_CHECK(length <= g_gateway.batch_bytes);
+    AKITA_CHECK(akita_gateway_write_batch(&g_gateway, "Gateway-1", 1500U, batch, 40U) == 0U);
+
+    akita_gateway_clear(&g_gateway, true);
+    AKITA_CHECK(g_gateway.count == 0U);
+    AKITA_CHECK(g_gateway.counters.forwarded == 2U);
+    AKITA_CHECK(g_gateway.counters.batches == 1U);
+    return 0;
+}
+
+static int akita_check_batch_limits(void) {
+    const akita_link_quality_t link = {.rssi_dbm = -90, .snr_quarter_db = 0};
+    static char batch[AKITA_GATEWAY_BATCH_MAX_BYTES + 160U];
+    uint8_t frame[AKITA_GATEWAY_MAX_FRAME_LEN];
+    size_t index;
+
+    memset(frame, 0x5A, sizeof(frame));
+    frame[0] = 0x11;
+
+    /* Small frames fill the batch by count. */
+    akita_gateway_init(&g_gateway);
+    for (index = 0; index < AKITA_GATEWAY_BATCH_MAX_FRAMES; ++index) {
+        frame[1] = (uint8_t) index;
+        AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, frame, 12U, 100U) == AKITA_GATEWAY_ADDED);
+    }
+    AKITA_CHECK(akita_gateway_flush_due(&g_gateway, 100U));
+    frame[1] = 0xFF;
+    AKITA_CHECK(akita_gateway_accept(&g_gateway, &link, frame, 12U, 100U) == AKITA_GATEWAY_FULL);
+    AKITA_CHECK(akita_gateway_write_batch(&g_gateway, "Gateway-1", 100U, batch, sizeof(batch)) <= AKITA_GATEWAY_BATCH_MAX_BYTES);
+    akita_gateway_clear(&g_gateway, false);
+    AKITA_CHECK(g_gateway.counters.dropped == AKITA_GATEWAY_BATCH_MAX_FRAMES);
+
+    /* Full-size frames fill it by bytes, and a batch never outgrows one datagram. */
+    for (index = 0; index < AKITA_GATEWAY_BATCH_MAX_FRAMES; ++index) {
+        akita_gateway_result_t result;
+
+        frame[1] = (uint8_t) (0x80U + index);
+        result = akita_gateway_accept(&g_gateway, &link, frame, sizeof(frame), 200U);
+        if (result == AKITA_GATEWAY_FULL) {
+            break;
+        }
+        AKITA_CHECK(result == AKITA_GATEWAY_ADDED);
+    }
+    AKITA_CHECK(index > 0U && index < AKITA_GATEWAY_BATCH_MAX_FRAMES);
+    AKITA_CHECK(akita_gateway_write_batch(&g_gateway, "Gateway-1", 200U, batch, sizeof(batch)) <= AKITA_GATEWAY_BATCH_MAX_BYTES);
+    printf("batch limits: %u small frames or %u full-size frames per batch\n",
+           (unsigned) AKITA_GATEWAY_BATCH_MAX_FRAMES,
+           (unsigned) index);
+    return 0;
+}
+
+static int akita_check_downlinks(void) {
+    const char *response = "{\"bridge\":\"akita-rns-udp-v2\",\"status\":\"ok\",\"mode\":\"gateway\","
+                           "\"downlinks\":[\"1210e200ea\",\"1410E2070200\"]}";
+    uint8_t frame[16];
+
+    AKITA_CHECK(akita_gateway_downlink(response, 0U, frame, sizeof(frame)) == 5U);
+    AKITA_CHECK(frame[0] == 0x12U && frame[4] == 0xEAU);
+    AKITA_CHECK(akita_gateway_downlink(response, 1U, frame, sizeof(frame)) == 6U);
+    AKITA_CHECK(frame[0] == 0x14U && frame[2] == 0xE2U && frame[4] == 0x02U);
+    AKITA_CHECK(akita_gateway_downlink(response, 2U, frame, sizeof(frame)) == 0U);
+    AKITA_CHECK(akita_gateway_downlink(response, 1U, frame, 4U) == 0U);
+    AKITA_CHECK(akita_gateway_downlink("{\"status\":\"ok\",\"downlinks\":[]}", 0U, frame, sizeof(frame)) == 0U);
+    AKITA_CHECK(akita_gateway_downlink("{\"status\":\"ok\",\"downlinks\":[\"12z0\"]}", 0U, frame, sizeof(frame)) == 0U);
+    AKITA_CHECK(akita_gateway_downlink("{\"status\":\"ok\"}", 0U, frame, sizeof(frame)) == 0U);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_dedupe() != 0 ||
+        akita_check_dedupe_pressure() != 0 ||
+        akita_check_failed_forward() != 0 ||
+        akita_check_batch_format() != 0 ||
+        akita_check_batch_limits() != 0 ||
+        akita_check_downlinks() != 0) {
+        return 1;
+    }
+
+    printf("gateway checks passed\n");
+    return 0;
+}
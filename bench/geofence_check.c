@@ -0,0 +1,341 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_geofence.h"
+#include "bench_support.h"
+
+#define AKITA_ORIGIN_LAT 45.5
+#define AKITA_ORIGIN_LON -73.56
+#define AKITA_M_PER_DEG 111320.0
+#define AKITA_PI 3.14159265358979323846
+#define AKITA_FLEET_FENCES 500U
+/* Fleet fences are spread over a 40 x 40 km metro area. */
+#define AKITA_FLEET_AREA_M 40000.0
+#define AKITA_LOOKUPS 200000U
+#define AKITA_BUDGET_NS 50000.0
+
+typedef struct {
+    uint32_t id;
+    uint8_t flags;
+    uint16_t dwell_s;
+    size_t count;
+    double north_m[AKITA_GEOFENCE_MAX_VERTICES];
+    double east_m[AKITA_GEOFENCE_MAX_VERTICES];
+} akita_polygon_t;
+
+static akita_polygon_t g_polygons[AKITA_FLEET_FENCES];
+static uint32_t g_image[65536U / sizeof(uint32_t)];
+static akita_geofence_t g_geofence;
+static uint32_t g_seed = 777U;
+
+static double akita_random(void) {
+    g_seed = g_seed * 1664525U + 1013904223U;
+    return (double) (g_seed >> 8) / 16777216.0;
+}
+
+static double akita_noise(double sigma) {
+    double sum = 0.0;
+    int index;
+
+    for (index = 0; index < 4; ++index) {
+        sum += akita_random() - 0.5;
+    }
+
+    return sum * sigma * 1.7;
+}
+
+static int32_t akita_lat_e6(double north_m) {
+    return (int32_t) lround((AKITA_ORIGIN_LAT + north_m / AKITA_M_PER_DEG) * 1.0e6);
+}
+
+static int32_t akita_lon_e6(double east_m) {
+    return (int32_t) lround((AKITA_ORIGIN_LON + east_m / (AKITA_M_PER_DEG * cos(AKITA_ORIGIN_LAT * AKITA_PI / 180.0))) * 1.0e6);
+}
+
+/* The same layout the upload tool writes. */
+static size_t akita_pack(const akita_polygon_t *polygons, size_t count) {
+    uint8_t *image = (uint8_t *) g_image;
+    akita_geofence_header_t *header = (akita_geofence_header_t *) image;
+    akita_geofence_record_t *records = (akita_geofence_record_t *) (header + 1);
+    akita_geofence_vertex_t *vertices = (akita_geofence_vertex_t *) (records + count);
+    uint32_t vertex_count = 0;
+    size_t index;
+    size_t corner;
+
+    memset(g_image, 0, sizeof(g_image));
+    for (index = 0; index < count; ++index) {
+        const akita_polygon_t *polygon = &polygons[index];
+        akita_geofence_record_t *record = &records[index];
+        int32_t lat[AKITA_GEOFENCE_MAX_VERTICES];
+        int32_t lon[AKITA_GEOFENCE_MAX_VERTICES];
+
+        record->id = polygon->id;
+        record->flags = polygon->flags;
+        record->dwell_s = polygon->dwell_s;
+        record->first_vertex = vertex_count;
+        record->vertex_count = (uint16_t) polygon->count;
+        for (corner = 0; corner < polygon->count; ++corner) {
+            lat[corner] = akita_lat_e6(polygon->north_m[corner]);
+            lon[corner] = akita_lon_e6(polygon->east_m[corner]);
+            if (corner == 0 || lat[corner] < record->min_latitude_e6) {
+                record->min_latitude_e6 = lat[corner];
+            }
+            if (corner == 0 || lat[corner] > record->max_latitude_e6) {
+                record->max_latitude_e6 = lat[corner];
+            }
+            if (corner == 0 || lon[corner] < record->min_longitude_e6) {
+                record->min_longitude_e6 = lon[corner];
+            }
+            if (corner == 0 || lon[corner] > record->max_longitude_e6) {
+                record->max_longitude_e6 = lon[corner];
+            }
+        }
+        while (((record->max_latitude_e6 - record->min_latitude_e6) >> record->shift) > UINT16_MAX ||
+               ((record->max_longitude_e6 - record->min_longitude_e6) >> record->shift) > UINT16_MAX) {
+            ++record->shift;
+        }
+        for (corner = 0; corner < polygon->count; ++corner) {
+            vertices[vertex_count].latitude = (uint16_t) ((lat[corner] - record->min_latitude_e6) >> record->shift);
+            vertices[vertex_count].longitude = (uint16_t) ((lon[corner] - record->min_longitude_e6) >> record->shift);
+            ++vertex_count;
+        }
+    }
+
+    header->magic = AKITA_GEOFENCE_MAGIC;
+    header->version = AKITA_GEOFENCE_VERSION;
+    header->fence_count = (uint16_t) count;
+    header->vertex_count = vertex_count;
+    header->size = (uint32_t) ((uint8_t *) (vertices + vertex_count) - image);
+    header->crc32 = akita_geofence_crc32(0U, header + 1, header->size - sizeof(*header));
+    return header->size;
+}
+
+static void akita_box(akita_polygon_t *polygon, uint32_t id, double north_m, double east_m, double size_m) {
+    memset(polygon, 0, sizeof(*polygon));
+    polygon->id = id;
+    polygon->count = 4U;
+    polygon->north_m[0] = north_m;
+    polygon->east_m[0] = east_m - size_m / 2.0;
+    polygon->north_m[1] = north_m;
+    polygon->east_m[1] = east_m + size_m / 2.0;
+    polygon->north_m[2] = north_m + size_m;
+    polygon->east_m[2] = east_m + size_m / 2.0;
+    polygon->north_m[3] = north_m + size_m;
+    polygon->east_m[3] = east_m - size_m / 2.0;
+}
+
+/* Depots and customer sites of 50-400 m with 6-16 irregular corners, and a few large restricted zones. */
+static void akita_fleet(void) {
+    size_t index;
+    size_t corner;
+
+    for (index = 0; index < AKITA_FLEET_FENCES; ++index) {
+        akita_polygon_t *polygon = &g_polygons[index];
+        double north_m = (akita_random() - 0.5) * AKITA_FLEET_AREA_M;
+        double east_m = (akita_random() - 0.5) * AKITA_FLEET_AREA_M;
+        double radius_m = index % 50U == 0U ? 3000.0 : 50.0 + akita_random() * 350.0;
+
+        memset(polygon, 0, sizeof(*polygon));
+        polygon->id = 1000U + (uint32_t) index;
+        polygon->flags = index % 50U == 0U ? AKITA_GEOFENCE_FLAG_ALERT : 0U;
+        polygon->count = 6U + (size_t) (akita_random() * 11.0);
+        for (corner = 0; corner < polygon->count; ++corner) {
+            double angle = 2.0 * AKITA_PI * (double) corner / (double) polygon->count;
+            double reach = radius_m * (0.5 + akita_random() * 0.5);
+
+            polygon->north_m[corner] = north_m + reach * cos(angle);
+            polygon->east_m[corner] = east_m + reach * sin(angle);
+        }
+    }
+}
+
+static int akita_check_polygon(void) {
+    akita_polygon_t *shape = &g_polygons[0];
+    size_t size;
+
+    /* An L: the notch between the arms is inside the box but outside the fence. */
+    memset(shape, 0, sizeof(*shape));
+    shape->id = 7U;
+    shape->count = 6U;
+    shape->north_m[0] = 0.0;
+    shape->east_m[0] = 0.0;
+    shape->north_m[1] = 0.0;
+    shape->east_m[1] = 300.0;
+    shape->north_m[2] = 100.0;
+    shape->east_m[2] = 300.0;
+    shape->north_m[3] = 100.0;
+    shape->east_m[3] = 100.0;
+    shape->north_m[4] = 300.0;
+    shape->east_m[4] = 100.0;
+    shape->north_m[5] = 300.0;
+    shape->east_m[5] = 0.0;
+    size = akita_pack(g_polygons, 1U);
+    AKITA_CHECK(akita_geofence_load(&g_geofence, g_image, size) == ESP_OK);
+
+    AKITA_CHECK(akita_geofence_contains(&g_geofence, 0, akita_lat_e6(50.0), akita_lon_e6(250.0)));
+    AKITA_CHECK(akita_geofence_contains(&g_geofence, 0, akita_lat_e6(250.0), akita_lon_e6(50.0)));
+    AKITA_CHECK(!akita_geofence_contains(&g_geofence, 0, akita_lat_e6(200.0), akita_lon_e6(200.0)));
+    AKITA_CHECK(!akita_geofence_contains(&g_geofence, 0, akita_lat_e6(-10.0), akita_lon_e6(50.0)));
+    AKITA_CHECK(!akita_geofence_contains(&g_geofence, 0, akita_lat_e6(50.0), akita_lon_e6(310.0)));
+
+    /* A damaged or foreign image is refused and leaves the engine empty. */
+    ((uint8_t *) g_image)[size - 1U] ^= 0x01U;
+    AKITA_CHECK(akita_geofence_load(&g_geofence, g_image, size) == ESP_ERR_INVALID_CRC);
+    AKITA_CHECK(g_geofence.fence_count == 0U);
+    AKITA_CHECK(akita_geofence_load(&g_geofence, g_image, size - 1U) == ESP_ERR_INVALID_SIZE);
+    g_image[0] = 0xFFFFFFFFU;
+    AKITA_CHECK(akita_geofence_load(&g_geofence, g_image, size) == ESP_ERR_NOT_FOUND);
+    return 0;
+}
+
+static size_t akita_drive(const double *north_m, size_t steps, uint64_t *now_ms, akita_geofence_event_t *events,
+                          size_t max_events) {
+    size_t count = 0;
+    size_t step;
+
+    for (step = 0; step < steps; ++step) {
+        *now_ms += 1000U;
+        count += akita_geofence_update(&g_geofence, akita_lat_e6(north_m[step]), akita_lon_e6(0.0), *now_ms, events + count,
+                                       max_events - count);
+    }
+
+    return count;
+}
+
+static int akita_check_events(void) {
+    akita_geofence_event_t events[16];
+    double path[900];
+    uint64_t now_ms = 1000U;
+    size_t count;
+    size_t step;
+
+    /* A 200 m depot with a five minute dwell, and a restricted zone 1 km north of it. */
+    akita_box(&g_polygons[0], 11U, 0.0, 0.0, 200.0);
+    g_polygons[0].dwell_s = 300U;
+    akita_box(&g_polygons[1], 12U, 1000.0, 0.0, 200.0);
+    g_polygons[1].flags = AKITA_GEOFENCE_FLAG_ALERT;
+    AKITA_CHECK(akita_geofence_load(&g_geofence, g_image, akita_pack(g_polygons, 2U)) == ESP_OK);
+
+    /* In from the south at 10 m/s, then parked 5 m inside the fence with GPS wandering up to 22 m out. */
+    for (step = 0; step < 40U; ++step) {
+        path[step] = -300.0 + 10.0 * (double) step;
+    }
+    for (; step < 640U; ++step) {
+        path[step] = 5.0 + akita_noise(8.0);
+    }
+    count = akita_drive(path, 640U, &now_ms, events, 16U);
+    AKITA_CHECK(count == 2U);
+    AKITA_CHECK(events[0].type == AKITA_GEOFENCE_ENTER && events[0].fence_id == 11U && events[0].flags == 0U);
+    AKITA_CHECK(events[0].inside_ms >= AKITA_GEOFENCE_CONFIRM_MS);
+    AKITA_CHECK(events[1].type == AKITA_GEOFENCE_DWELL && events[1].fence_id == 11U);
+    AKITA_CHECK(events[1].inside_ms >= 300000U && events[1].inside_ms < 302000U);
+
+    /* Out to the south: the exit counts from the first fix outside, once it has stayed out past the margin. */
+    for (step = 0; step < 30U; ++step) {
+        path[step] = -10.0 * (double) step;
+    }
+    count = akita_drive(path, 30U, &now_ms, events, 16U);
+    AKITA_CHECK(count == 1U);
+    AKITA_CHECK(events[0].type == AKITA_GEOFENCE_EXIT && events[0].fence_id == 11U);
+    AKITA_CHECK(events[0].inside_ms > 600000U && events[0].inside_ms < 620000U);
+    AKITA_CHECK(g_geofence.visit_count == 0U);
+
+    /* A single multipath fix in the restricted zone is not an entry; driving through it is. */
+    path[0] = 1100.0;
+    path[1] = 500.0;
+    path[2] = 500.0;
+    path[3] = 500.0;
+    AKITA_CHECK(akita_drive(path, 4U, &now_ms, events, 16U) == 0U);
+    for (step = 0; step < 120U; ++step) {
+        path[step] = 800.0 + 5.0 * (double) step;
+    }
+    count = akita_drive(path, 120U, &now_ms, events, 16U);
+    AKITA_CHECK(count == 2U);
+    AKITA_CHECK(events[0].type == AKITA_GEOFENCE_ENTER && events[0].fence_id == 12U);
+    AKITA_CHECK(events[0].flags == AKITA_GEOFENCE_FLAG_ALERT);
+    AKITA_CHECK(events[1].type == AKITA_GEOFENCE_EXIT && events[1].fence_id == 12U);
+    AKITA_CHECK(strcmp(akita_geofence_event_name(events[1].type), "geofence_exit") == 0);
+    return 0;
+}
+
+static int akita_check_fleet(void) {
+    uint16_t found[AKITA_GEOFENCE_ACTIVE_MAX];
+    akita_geofence_event_t events[AKITA_GEOFENCE_ACTIVE_MAX];
+    uint64_t start_ns;
+    uint64_t indexed_ns;
+    uint64_t scan_ns;
+    uint64_t now_ms = 1000U;
+    uint32_t inside_hits = 0;
+    uint32_t index;
+    size_t size;
+
+    akita_fleet();
+    size = akita_pack(g_polygons, AKITA_FLEET_FENCES);
+    start_ns = akita_bench_now_ns();
+    AKITA_CHECK(akita_geofence_load(&g_geofence, g_image, size) == ESP_OK);
+    printf("%u fences, %u vertices in a %u byte image; %ux%u grid with %u references built in %.0f us\n",
+           (unsigned) AKITA_FLEET_FENCES, (unsigned) ((const akita_geofence_header_t *) g_image)->vertex_count,
+           (unsigned) size, (unsigned) g_geofence.grid_side, (unsigned) g_geofence.grid_side,
+           (unsigned) g_geofence.cell_start[g_geofence.grid_side * g_geofence.grid_side],
+           (double) (akita_bench_now_ns() - start_ns) / 1000.0);
+
+    /* The grid must find exactly what testing every fence finds. */
+    for (index = 0; index < 20000U; ++index) {
+        int32_t latitude_e6 = akita_lat_e6((akita_random() - 0.5) * AKITA_FLEET_AREA_M * 1.1);
+        int32_t longitude_e6 = akita_lon_e6((akita_random() - 0.5) * AKITA_FLEET_AREA_M * 1.1);
+        size_t count = akita_geofence_lookup(&g_geofence, latitude_e6, longitude_e6, found, AKITA_GEOFENCE_ACTIVE_MAX);
+        size_t expected = 0;
+        uint16_t fence;
+
+        for (fence = 0; fence < AKITA_FLEET_FENCES; ++fence) {
+            if (akita_geofence_contains(&g_geofence, fence, latitude_e6, longitude_e6)) {
+                AKITA_CHECK(expected < count && found[expected] == fence);
+                ++expected;
+            }
+        }
+        AKITA_CHECK(count == expected);
+        inside_hits += count > 0U ? 1U : 0U;
+    }
+    AKITA_CHECK(inside_hits > 100U);
+
+    g_geofence.polygon_tests = 0;
+    start_ns = akita_bench_now_ns();
+    for (index = 0; index < AKITA_LOOKUPS; ++index) {
+        now_ms += 100U;
+        akita_geofence_update(&g_geofence, akita_lat_e6((akita_random() - 0.5) * AKITA_FLEET_AREA_M),
+                              akita_lon_e6((akita_random() - 0.5) * AKITA_FLEET_AREA_M), now_ms, events,
+                              AKITA_GEOFENCE_ACTIVE_MAX);
+    }
+    indexed_ns = akita_bench_now_ns() - start_ns;
+
+    start_ns = akita_bench_now_ns();
+    for (index = 0; index < AKITA_LOOKUPS / 100U; ++index) {
+        int32_t latitude_e6 = akita_lat_e6((akita_random() - 0.5) * AKITA_FLEET_AREA_M);
+        int32_t longitude_e6 = akita_lon_e6((akita_random() - 0.5) * AKITA_FLEET_AREA_M);
+        uint16_t fence;
+
+        for (fence = 0; fence < AKITA_FLEET_FENCES; ++fence) {
+            inside_hits += akita_geofence_contains(&g_geofence, fence, latitude_e6, longitude_e6) ? 1U : 0U;
+        }
+    }
+    scan_ns = (akita_bench_now_ns() - start_ns) * 100U;
+
+    printf("update %.0f ns per fix with %.2f polygon tests (testing every fence: %.0f ns)\n",
+           (double) indexed_ns / AKITA_LOOKUPS, (double) g_geofence.polygon_tests / AKITA_LOOKUPS,
+           (double) scan_ns / AKITA_LOOKUPS);
+    AKITA_CHECK((double) indexed_ns / AKITA_LOOKUPS < AKITA_BUDGET_NS);
+    AKITA_CHECK(g_geofence.polygon_tests < AKITA_LOOKUPS * 2U);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_polygon() != 0 ||
+        akita_check_events() != 0 ||
+        akita_check_fleet() != 0) {
+        return 1;
+    }
+
+    printf("geofence checks passed\n");
+    return 0;
+}
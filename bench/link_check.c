@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_link.h"
+#include "bench_support.h"
+
+#define AKITA_WIFI_BIT (1U << AKITA_LINK_WIFI)
+
+static akita_link_scheduler_t g_scheduler;
+
+static void akita_links_up(bool wifi, bool lora) {
+    akita_link_set_up(&g_scheduler, AKITA_LINK_WIFI, wifi, 0U);
+    akita_link_set_up(&g_scheduler, AKITA_LINK_LORA, lora, 222U);
+}
+
+static int akita_check_preference(void) {
+    const size_t telemetry[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 420U, [AKITA_LINK_LORA] = 28U};
+    const size_t wifi_only[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 420U};
+
+    akita_link_scheduler_init(&g_scheduler);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, 0U, 1000U) == AKITA_LINK_NONE);
+
+    /* Full payloads go over WiFi while it is up; LoRa carries the compact frame otherwise. */
+    akita_links_up(true, true);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, 0U, 1000U) == AKITA_LINK_WIFI);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_BULK, telemetry, 0U, 1000U) == AKITA_LINK_WIFI);
+    akita_links_up(false, true);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, 0U, 1000U) == AKITA_LINK_LORA);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, wifi_only, 0U, 1000U) == AKITA_LINK_NONE);
+
+    /* Failover inside one publish: with WiFi excluded the same sample goes to LoRa. */
+    akita_links_up(true, true);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, AKITA_WIFI_BIT, 1000U) == AKITA_LINK_LORA);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, AKITA_WIFI_BIT | (1U << AKITA_LINK_LORA),
+                                  1000U) == AKITA_LINK_NONE);
+    return 0;
+}
+
+static int akita_check_priority(void) {
+    const size_t alert[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 120U, [AKITA_LINK_LORA] = 20U};
+    uint32_t index;
+
+    /* A WiFi uplink that answers slowly still carries routine data, but alerts take the faster radio. */
+    akita_link_scheduler_init(&g_scheduler);
+    akita_links_up(true, true);
+    for (index = 0; index < 64U; ++index) {
+        akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 120U, true, 1500U, 1000U + index);
+    }
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.latency_ms > 1400U);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, alert, 0U, 2000U) == AKITA_LINK_WIFI);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ALERT, alert, 0U, 2000U) == AKITA_LINK_LORA);
+    return 0;
+}
+
+static int akita_check_size(void) {
+    const size_t small[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 200U, [AKITA_LINK_LORA] = 200U};
+    const size_t large[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 2000U, [AKITA_LINK_LORA] = 2000U};
+
+    /* Make WiFi slow enough that a one-frame event prefers LoRa; a message needing ten fragments must not. */
+    akita_link_scheduler_init(&g_scheduler);
+    akita_links_up(true, true);
+    g_scheduler.links[AKITA_LINK_WIFI].stats.latency_ms = 6000U;
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_EVENT, small, 0U, 1000U) == AKITA_LINK_LORA);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_EVENT, large, 0U, 1000U) == AKITA_LINK_WIFI);
+    return 0;
+}
+
+static int akita_check_health(void) {
+    const size_t telemetry[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 420U, [AKITA_LINK_LORA] = 28U};
+    uint64_t now_ms = 10000U;
+    uint32_t index;
+
+    akita_link_scheduler_init(&g_scheduler);
+    akita_links_up(true, true);
+    akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 420U, true, 250U, now_ms);
+    AKITA_CHECK(g_scheduler.active == AKITA_LINK_WIFI);
+    AKITA_CHECK(g_scheduler.switchovers == 0U);
+
+    /* A failed publish backs the link off, so following samples go straight to LoRa. */
+    akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 420U, false, 8000U, now_ms);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, 0U, now_ms + 1000U) == AKITA_LINK_LORA);
+    akita_link_record(&g_scheduler, AKITA_LINK_LORA, 28U, true, 180U, now_ms + 1000U);
+    AKITA_CHECK(g_scheduler.active == AKITA_LINK_LORA);
+    AKITA_CHECK(g_scheduler.switchovers == 1U);
+
+    /* WiFi is probed again once the backoff expires, and each failure doubles the wait. */
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, 0U, now_ms + AKITA_LINK_BACKOFF_MIN_MS) ==
+                AKITA_LINK_WIFI);
+    now_ms += AKITA_LINK_BACKOFF_MIN_MS;
+    akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 420U, false, 8000U, now_ms);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].retry_at_ms == now_ms + 2U * AKITA_LINK_BACKOFF_MIN_MS);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.failures == 2U);
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_ROUTINE, telemetry, 0U, now_ms + 1000U) == AKITA_LINK_LORA);
+
+    for (index = 0; index < 20U; ++index) {
+        akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 420U, false, 8000U, now_ms);
+    }
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].retry_at_ms == now_ms + AKITA_LINK_BACKOFF_MAX_MS);
+
+    now_ms += AKITA_LINK_BACKOFF_MAX_MS;
+    akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 420U, true, 300U, now_ms);
+    AKITA_CHECK(g_scheduler.active == AKITA_LINK_WIFI);
+    AKITA_CHECK(g_scheduler.switchovers == 2U);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].retry_at_ms == 0U);
+    return 0;
+}
+
+static int akita_check_hysteresis(void) {
+    const size_t event[AKITA_LINK_COUNT] = {[AKITA_LINK_WIFI] = 200U, [AKITA_LINK_LORA] = 200U};
+
+    /* Close scores keep the active link instead of flapping between the two. */
+    akita_link_scheduler_init(&g_scheduler);
+    akita_links_up(true, true);
+    akita_link_record(&g_scheduler, AKITA_LINK_LORA, 200U, true, AKITA_LINK_LORA_LATENCY_MS, 1000U);
+    g_scheduler.links[AKITA_LINK_WIFI].stats.latency_ms = 2600U;
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_EVENT, event, 0U, 2000U) == AKITA_LINK_LORA);
+    g_scheduler.links[AKITA_LINK_WIFI].stats.latency_ms = 1000U;
+    AKITA_CHECK(akita_link_select(&g_scheduler, AKITA_MESSAGE_EVENT, event, 0U, 2000U) == AKITA_LINK_WIFI);
+    return 0;
+}
+
+static int akita_check_counters(void) {
+    uint32_t index;
+
+    akita_link_scheduler_init(&g_scheduler);
+    akita_links_up(true, false);
+    for (index = 0; index <= 60U; ++index) {
+        akita_link_record(&g_scheduler, AKITA_LINK_WIFI, 500U, true, 200U + index, 1000U + index * 1000U);
+    }
+
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.messages == 61U);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.bytes == 61U * 500U);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.latency_max_ms == 260U);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.latency_ms > 200U);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.latency_ms < 260U);
+    /* Sixty 500 byte messages over the 60 s window before the last one. */
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_WIFI].stats.throughput_bps == 500U);
+    AKITA_CHECK(g_scheduler.links[AKITA_LINK_LORA].stats.messages == 0U);
+    AKITA_CHECK(strcmp(akita_link_name(AKITA_LINK_LORA), "lora") == 0);
+    AKITA_CHECK(strcmp(akita_link_name(AKITA_LINK_NONE), "none") == 0);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_preference() != 0 ||
+        akita_check_priority() != 0 ||
+        akita_check_size() != 0 ||
+        akita_check_health() != 0 ||
+        akita_check_hysteresis() != 0 ||
+        akita_check_counters() != 0) {
+        return 1;
+    }
+
+    printf("link checks passed\n");
+    return 0;
+}
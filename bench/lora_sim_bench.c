@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_fragment.h"
+#include "akita_gateway.h"
+#include "akita_sx127x.h"
+#include "bench_support.h"
+#include "fragment_reassembler.h"
+#include "sx127x_sim.h"
+
+#define AKITA_SIM_MAX_NODES 9U
+#define AKITA_SIM_RX_DEPTH 16U
+/* Matches the driver task: sleep on DIO0 for up to a second, never less than a tick. */
+#define AKITA_SIM_IDLE_WAIT_US 1000000LL
+#define AKITA_SIM_MIN_WAIT_US 1000LL
+#define AKITA_SIM_SECOND_US 1000000LL
+#define AKITA_SIM_FRAME_TAG 0x11U
+#define AKITA_SIM_SEQUENCE_SLOTS 64U
+
+typedef struct {
+    akita_sim_radio_t sim;
+    akita_sx127x_t radio;
+    int64_t wake_us;
+    akita_lora_packet_t rx[AKITA_SIM_RX_DEPTH];
+    size_t rx_head;
+    size_t rx_count;
+} akita_sim_node_t;
+
+typedef struct {
+    akita_sim_channel_t channel;
+    akita_sim_node_t nodes[AKITA_SIM_MAX_NODES];
+    size_t node_count;
+    int64_t now_us;
+} akita_sim_world_t;
+
+typedef struct {
+    uint32_t offered;
+    uint32_t delivered;
+    uint64_t latency_total_us;
+    int64_t latency_max_us;
+} akita_sim_latency_t;
+
+static akita_sim_world_t g_world;
+
+static bool akita_sim_queue_rx(void *context, const akita_lora_packet_t *packet) {
+    akita_sim_node_t *node = context;
+
+    if (node->rx_count >= AKITA_SIM_RX_DEPTH) {
+        return false;
+    }
+    node->rx[(node->rx_head + node->rx_count) % AKITA_SIM_RX_DEPTH] = *packet;
+    ++node->rx_count;
+    return true;
+}
+
+static bool akita_sim_take_rx(akita_sim_node_t *node, akita_lora_packet_t *packet) {
+    if (node->rx_count == 0U) {
+        return false;
+    }
+    *packet = node->rx[node->rx_head];
+    node->rx_head = (node->rx_head + 1U) % AKITA_SIM_RX_DEPTH;
+    --node->rx_count;
+    return true;
+}
+
+static void akita_sim_config(
+    akita_runtime_config_t *config,
+    uint32_t frequency_hz,
+    akita_lora_region_t region,
+    uint8_t spreading_factor,
+    bool adr_enabled
+) {
+    memset(config, 0, sizeof(*config));
+    config->lora_frequency_hz = frequency_hz;
+    config->lora_region = region;
+    config->lora_spreading_factor = spreading_factor;
+    config->lora_bandwidth_hz = 125000U;
+    config->lora_coding_rate = 5U;
+    config->lora_tx_power_dbm = 14;
+    config->lora_adr_enabled = adr_enabled;
+}
+
+static int akita_sim_world_init(akita_sim_world_t *world, size_t node_count, uint32_t seed, uint16_t loss_permille,
+                                const akita_runtime_config_t *config) {
+    size_t index;
+
+    memset(world, 0, sizeof(*world));
+    akita_sim_channel_init(&world->channel, seed, loss_permille);
+    world->node_count = node_count;
+    for (index = 0; index < node_count; ++index) {
+        akita_sim_node_t *node = &world->nodes[index];
+
+        akita_sim_radio_attach(&world->channel, &node->sim);
+        akita_sx127x_init(&node->radio, akita_sim_transfer, &node->sim);
+        AKITA_CHECK(akita_sx127x_configure(&node->radio, config) == ESP_OK);
+        AKITA_CHECK(node->sim.registers[AKITA_SX127X_REG_OP_MODE] ==
+                    (AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_RX_CONTINUOUS));
+    }
+    return 0;
+}
+
+static void akita_sim_send(akita_sim_world_t *world, size_t node_index, akita_message_class_t message_class,
+                           const uint8_t *frame, size_t frame_len) {
+    akita_sim_node_t *node = &world->nodes[node_index];
+
+    (void) akita_airtime_scheduler_push(&node->radio.scheduler, message_class, frame, frame_len,
+                                        (uint64_t) (world->now_us / 1000LL));
+    node->wake_us = world->now_us;
+}
+
+/* Runs the channel and every driver up to the next event no later than limit_us. */
+static void akita_sim_step(akita_sim_world_t *world, int64_t limit_us) {
+    int64_t next_us = akita_sim_channel_next_event_us(&world->channel);
+    size_t index;
+
+    if (limit_us < next_us) {
+        next_us = limit_us;
+    }
+    for (index = 0; index < world->node_count; ++index) {
+        if (world->nodes[index].wake_us < next_us) {
+            next_us = world->nodes[index].wake_us;
+        }
+    }
+    if (next_us < world->now_us) {
+        next_us = world->now_us;
+    }
+
+    akita_sim_channel_advance(&world->channel, next_us);
+    world->now_us = next_us;
+    for (index = 0; index < world->node_count; ++index) {
+        akita_sim_node_t *node = &world->nodes[index];
+        int64_t wait_us;
+        uint32_t wait_ms;
+
+        if (!akita_sim_radio_dio0(&node->sim) && node->wake_us > world->now_us) {
+            continue;
+        }
+
+        wait_ms = akita_sx127x_service(&node->radio, world->now_us, akita_sim_queue_rx, node);
+        wait_us = wait_ms == AKITA_AIRTIME_WAIT_NONE ? AKITA_SIM_IDLE_WAIT_US : (int64_t) wait_ms * 1000LL;
+        if (wait_us > AKITA_SIM_IDLE_WAIT_US) {
+            wait_us = AKITA_SIM_IDLE_WAIT_US;
+        }
+        if (wait_us < AKITA_SIM_MIN_WAIT_US) {
+            wait_us = AKITA_SIM_MIN_WAIT_US;
+        }
+        node->wake_us = world->now_us + wait_us;
+    }
+}
+
+static void akita_sim_write_frame(uint8_t *frame, size_t frame_len, size_t node_index, uint16_t sequence) {
+    memset(frame, 0x5A, frame_len);
+    frame[0] = AKITA_SIM_FRAME_TAG;
+    frame[1] = (uint8_t) node_index;
+    frame[2] = (uint8_t) sequence;
+    frame[3] = (uint8_t) (sequence >> 8);
+}
+
+static void akita_sim_print_latency(const char *name, const akita_sim_latency_t *latency, double wall_ms, double sim_s) {
+    printf("%s: %lu/%lu frames delivered (%.1f%%), latency avg %.0f ms max %.0f ms, %.0f simulated s in %.1f ms\n",
+           name,
+           (unsigned long) latency->delivered,
+           (unsigned long) latency->offered,
+           latency->offered > 0U ? 100.0 * latency->delivered / latency->offered : 0.0,
+           latency->delivered > 0U ? (double) latency->latency_total_us / latency->delivered / 1000.0 : 0.0,
+           (double) latency->latency_max_us / 1000.0,
+           sim_s,
+           wall_ms);
+}
+
+static int akita_sim_telemetry_gateway(void) {
+    static akita_gateway_t gateway;
+    static int64_t enqueued_us[AKITA_SIM_MAX_NODES][AKITA_SIM_SEQUENCE_SLOTS];
+    const size_t node_count = AKITA_SIM_MAX_NODES;
+    const int64_t interval_us = 15LL * AKITA_SIM_SECOND_US;
+    const int64_t duration_us = 600LL * AKITA_SIM_SECOND_US;
+    akita_runtime_config_t config;
+    akita_sim_latency_t latency = {0};
+    akita_lora_packet_t packet;
+    int64_t next_send_us[AKITA_SIM_MAX_NODES];
+    uint16_t sequence[AKITA_SIM_MAX_NODES] = {0};
+    uint8_t frame[24];
+    uint64_t started_ns;
+    size_t index;
+
+    akita_sim_config(&config, 868100000U, AKITA_LORA_REGION_EU868, 9U, false);
+    if (akita_sim_world_init(&g_world, node_count, 0xA71CA033U, 20U, &config) != 0) {
+        return 1;
+    }
+    akita_gateway_init(&gateway);
+
+    /* Node 0 is the gateway; the others report on a fixed interval with random phase. */
+    for (index = 1; index < node_count; ++index) {
+        next_send_us[index] = (int64_t) (akita_sim_random(&g_world.channel) % (uint32_t) interval_us);
+    }
+
+    started_ns = akita_bench_now_ns();
+    while (g_world.now_us < duration_us) {
+        int64_t limit_us = duration_us;
+
+        for (index = 1; index < node_count; ++index) {
+            if (next_send_us[index] < limit_us) {
+                limit_us = next_send_us[index];
+            }
+        }
+        akita_sim_step(&g_world, limit_us);
+
+        for (index = 1; index < node_count; ++index) {
+            if (next_send_us[index] <= g_world.now_us) {
+                akita_sim_write_frame(frame, sizeof(frame), index, sequence[index]);
+                enqueued_us[index][sequence[index] % AKITA_SIM_SEQUENCE_SLOTS] = g_world.now_us;
+                akita_sim_send(&g_world, index, AKITA_MESSAGE_ROUTINE, frame, sizeof(frame));
+                ++sequence[index];
+                ++latency.offered;
+                /* Up to a second of jitter, as the telemetry loop drifts with OBD and GPS polling. */
+                next_send_us[index] += interval_us + (int64_t) (akita_sim_random(&g_world.channel) % 1000000U);
+            }
+        }
+
+        while (akita_sim_take_rx(&g_world.nodes[0], &packet)) {
+            uint64_t now_ms = (uint64_t) (g_world.now_us / 1000LL);
+            size_t sender = packet.data[1];
+            uint16_t received = (uint16_t) (packet.data[2] | (packet.data[3] << 8));
+            int64_t age_us = g_world.now_us - enqueued_us[sender][received % AKITA_SIM_SEQUENCE_SLOTS];
+
+            if (akita_gateway_accept(&gateway, &packet.link, packet.data, packet.length, now_ms) != AKITA_GATEWAY_ADDED) {
+                continue;
+            }
+            ++latency.delivered;
+            latency.latency_total_us += (uint64_t) age_us;
+            if (age_us > latency.latency_max_us) {
+                latency.latency_max_us = age_us;
+            }
+        }
+        if (akita_gateway_flush_due(&gateway, (uint64_t) (g_world.now_us / 1000LL))) {
+            akita_gateway_clear(&gateway, true);
+        }
+    }
+
+    akita_sim_print_latency("telemetry, 8 nodes to 1 gateway, SF9, 2% loss", &latency,
+                            (double) (akita_bench_now_ns() - started_ns) / 1e6, (double) duration_us / 1e6);
+    printf("  channel: %lu transmissions, %lu collisions, %lu lost; gateway: %lu batches, %.1f frames per batch\n",
+           (unsigned long) g_world.channel.transmissions,
+           (unsigned long) g_world.channel.collisions,
+           (unsigned long) g_world.channel.losses,
+           (unsigned long) gateway.counters.batches,
+           gateway.counters.batches > 0U ? (double) gateway.counters.forwarded / gateway.counters.batches : 0.0);
+
+    AKITA_CHECK(latency.offered >= (node_count - 1U) * 38U);
+    AKITA_CHECK(latency.delivered * 10U >= latency.offered * 7U);
+    AKITA_CHECK(latency.latency_max_us < AKITA_SIM_SECOND_US);
+    AKITA_CHECK(gateway.counters.duplicates == 0U);
+    return 0;
+}
+
+static int akita_sim_duty_cycle(void) {
+    const int64_t interval_us = 10LL * AKITA_SIM_SECOND_US;
+    const int64_t duration_us = 7200LL * AKITA_SIM_SECOND_US;
+    akita_runtime_config_t config;
+    akita_lora_stats_t stats;
+    akita_sim_latency_t latency = {0};
+    akita_lora_packet_t packet;
+    int64_t next_send_us = 0;
+    uint16_t sequence = 0;
+    uint8_t frame[20];
+    uint64_t started_ns;
+
+    akita_sim_config(&config, 868100000U, AKITA_LORA_REGION_EU868, 12U, false);
+    if (akita_sim_world_init(&g_world, 2U, 0xA71CA034U, 0U, &config) != 0) {
+        return 1;
+    }
+
+    started_ns = akita_bench_now_ns();
+    while (g_world.now_us < duration_us) {
+        akita_sim_step(&g_world, next_send_us < duration_us ? next_send_us : duration_us);
+        if (next_send_us <= g_world.now_us) {
+            akita_sim_write_frame(frame, sizeof(frame), 1U, sequence++);
+            akita_sim_send(&g_world, 1U, AKITA_MESSAGE_ROUTINE, frame, sizeof(frame));
+            ++latency.offered;
+            next_send_us += interval_us;
+        }
+        while (akita_sim_take_rx(&g_world.nodes[0], &packet)) {
+            ++latency.delivered;
+        }
+    }
+
+    akita_sx127x_get_stats(&g_world.nodes[1].radio, (uint64_t) (duration_us / 1000LL), &stats);
+    printf("duty cycle, SF12 every 10 s for 2 h: %lu/%lu frames on air, %lu coalesced, %lu dropped, %lu ms airtime in the last hour, %.1f ms wall\n",
+           (unsigned long) latency.delivered,
+           (unsigned long) latency.offered,
+           (unsigned long) stats.tx_coalesced,
+           (unsigned long) stats.tx_dropped,
+           (unsigned long) stats.airtime_used_ms,
+           (double) (akita_bench_now_ns() - started_ns) / 1e6);
+
+    /* EU868 g1 allows 1%: 36 s of airtime in any hour. */
+    AKITA_CHECK(stats.airtime_used_ms <= 36000U);
+    AKITA_CHECK(g_world.channel.airtime_us <= 2U * 36000000U);
+    AKITA_CHECK(latency.delivered > 0U && latency.delivered < latency.offered / 4U);
+    return 0;
+}
+
+static int akita_sim_adr_run(bool adr_enabled, uint32_t *delivered, uint64_t *airtime_us, uint8_t *spreading_factor) {
+    const int64_t interval_us = 30LL * AKITA_SIM_SECOND_US;
+    const int64_t duration_us = 3600LL * AKITA_SIM_SECOND_US;
+    akita_runtime_config_t config;
+    akita_lora_packet_t packet;
+    int64_t next_send_us = 0;
+    uint16_t sequence = 0;
+    uint8_t frame[32];
+
+    akita_sim_config(&config, 868100000U, AKITA_LORA_REGION_EU868, 12U, adr_enabled);
+    if (akita_sim_world_init(&g_world, 2U, 0xA71CA035U, 0U, &config) != 0) {
+        return 1;
+    }
+    g_world.nodes[0].sim.any_data_rate = true;
+    akita_sim_set_link(&g_world.channel, 1U, 0U, -96, 40);
+
+    *delivered = 0;
+    while (g_world.now_us < duration_us) {
+        akita_sim_step(&g_world, next_send_us < duration_us ? next_send_us : duration_us);
+        if (next_send_us <= g_world.now_us) {
+            akita_sim_write_frame(frame, sizeof(frame), 1U, sequence++);
+            akita_sim_send(&g_world, 1U, AKITA_MESSAGE_EVENT, frame, sizeof(frame));
+            next_send_us += interval_us;
+        }
+        /* The gateway ACK is modelled as an out-of-band downlink carrying the uplink SNR. */
+        while (akita_sim_take_rx(&g_world.nodes[0], &packet)) {
+            ++*delivered;
+            if (akita_sx127x_link_feedback(&g_world.nodes[1].radio, &packet.link, packet.link.snr_quarter_db)) {
+                g_world.nodes[1].wake_us = g_world.now_us;
+            }
+        }
+    }
+
+    *airtime_us = g_world.channel.airtime_us;
+    *spreading_factor = g_world.nodes[1].radio.modem.spreading_factor;
+    return 0;
+}
+
+static int akita_sim_adr(void) {
+    uint32_t fixed_delivered;
+    uint32_t adr_delivered;
+    uint64_t fixed_airtime_us;
+    uint64_t adr_airtime_us;
+    uint8_t fixed_sf;
+    uint8_t adr_sf;
+
+    if (akita_sim_adr_run(false, &fixed_delivered, &fixed_airtime_us, &fixed_sf) != 0 ||
+        akita_sim_adr_run(true, &adr_delivered, &adr_airtime_us, &adr_sf) != 0) {
+        return 1;
+    }
+
+    AKITA_CHECK(fixed_delivered > 0U && adr_delivered > 0U);
+    printf("adr, 10 dB link, 32-byte event every 30 s for 1 h: fixed SF%u %lu frames at %.0f ms each, ADR SF%u %lu frames at %.0f ms each\n",
+           fixed_sf,
+           (unsigned long) fixed_delivered,
+           (double) fixed_airtime_us / fixed_delivered / 1000.0,
+           adr_sf,
+           (unsigned long) adr_delivered,
+           (double) adr_airtime_us / adr_delivered / 1000.0);
+
+    AKITA_CHECK(fixed_sf == 12U);
+    AKITA_CHECK(adr_sf == 7U);
+    AKITA_CHECK(adr_delivered > fixed_delivered);
+    AKITA_CHECK(adr_airtime_us / adr_delivered * 4U < fixed_airtime_us / fixed_delivered);
+    return 0;
+}
+
+static void akita_sim_pump_fragments(akita_fragment_sender_t *sender, uint64_t now_ms) {
+    akita_sx127x_t *radio = &g_world.nodes[1].radio;
+    akita_message_class_t message_class;
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    size_t frame_len;
+
+    /* Same pacing as the app: keep at most two fragments waiting on the radio. */
+    while (radio->scheduler.slot_count < 2U &&
+           (frame_len = akita_fragment_sender_next(sender, now_ms, frame, sizeof(frame), &message_class)) > 0U) {
+        akita_sim_send(&g_world, 1U, message_class, frame, frame_len);
+        akita_fragment_sender_mark_sent(sender, frame, frame_len);
+    }
+}
+
+static int akita_sim_fragmentation(void) {
+    static akita_fragment_sender_t sender;
+    static akita_fragment_reassembler_t reassembler;
+    static uint8_t message[AKITA_FRAGMENT_MAX_MESSAGE_LEN];
+    const int64_t interval_us = 60LL * AKITA_SIM_SECOND_US;
+    const int64_t duration_us = 1800LL * AKITA_SIM_SECOND_US;
+    const int64_t tick_us = 250000LL;
+    akita_runtime_config_t config;
+    akita_sim_latency_t latency = {0};
+    akita_lora_packet_t packet;
+    akita_lora_stats_t stats;
+    int64_t next_send_us = 0;
+    int64_t next_tick_us = 0;
+    int64_t started_us = 0;
+    uint32_t nacks = 0;
+    uint8_t payload[120];
+    uint8_t nack[AKITA_FRAGMENT_NACK_LEN];
+    uint8_t fragments = 0;
+    size_t message_len;
+    size_t max_frame_len;
+    uint64_t started_ns;
+    size_t index;
+
+    akita_sim_config(&config, 915000000U, AKITA_LORA_REGION_US915, 10U, false);
+    if (akita_sim_world_init(&g_world, 2U, 0xA71CA036U, 100U, &config) != 0) {
+        return 1;
+    }
+    akita_fragment_sender_init(&sender);
+    akita_fragment_reassembler_init(&reassembler);
+    akita_sx127x_get_stats(&g_world.nodes[1].radio, 0U, &stats);
+    max_frame_len = stats.max_frame_len;
+    for (index = 0; index < sizeof(payload); ++index) {
+        payload[index] = (uint8_t) (index * 7U);
+    }
+
+    started_ns = akita_bench_now_ns();
+    while (g_world.now_us < duration_us) {
+        uint64_t now_ms;
+        int64_t limit_us = next_send_us < next_tick_us ? next_send_us : next_tick_us;
+
+        akita_sim_step(&g_world, limit_us < duration_us ? limit_us : duration_us);
+        now_ms = (uint64_t) (g_world.now_us / 1000LL);
+
+        if (next_send_us <= g_world.now_us && g_world.now_us + interval_us <= duration_us) {
+            payload[0] = (uint8_t) latency.offered;
+            fragments = akita_fragment_sender_begin(&sender, 0xE210U, AKITA_MESSAGE_BULK, payload, sizeof(payload),
+                                                    max_frame_len, now_ms);
+            started_us = g_world.now_us;
+            ++latency.offered;
+            next_send_us += interval_us;
+        }
+
+        while (akita_sim_take_rx(&g_world.nodes[0], &packet)) {
+            akita_fragment_result_t result = akita_fragment_reassembler_push(
+                &reassembler, packet.data, packet.length, now_ms, message, sizeof(message), &message_len);
+
+            if (result == AKITA_FRAGMENT_COMPLETE && message_len == sizeof(payload)) {
+                int64_t age_us = g_world.now_us - started_us;
+
+                ++latency.delivered;
+                latency.latency_total_us += (uint64_t) age_us;
+                if (age_us > latency.latency_max_us) {
+                    latency.latency_max_us = age_us;
+                }
+            }
+        }
+        while (akita_sim_take_rx(&g_world.nodes[1], &packet)) {
+            (void) akita_fragment_sender_on_nack(&sender, packet.data, packet.length, now_ms);
+        }
+
+        if (next_tick_us <= g_world.now_us) {
+            while (akita_fragment_reassembler_poll(&reassembler, now_ms, nack, sizeof(nack)) > 0U) {
+                akita_sim_send(&g_world, 0U, AKITA_MESSAGE_EVENT, nack, sizeof(nack));
+                ++nacks;
+            }
+            next_tick_us += tick_us;
+        }
+        akita_sim_pump_fragments(&sender, now_ms);
+    }
+
+    akita_sim_print_latency("fragmentation, 120-byte message at US915 SF10, 10% loss", &latency,
+                            (double) (akita_bench_now_ns() - started_ns) / 1e6, (double) duration_us / 1e6);
+    printf("  %u fragments of at most %u bytes per message, %lu NACKs, %lu fragments resent, %lu expired\n",
+           (unsigned) fragments,
+           (unsigned) max_frame_len,
+           (unsigned long) nacks,
+           (unsigned long) sender.fragments_resent,
+           (unsigned long) reassembler.expired);
+
+    AKITA_CHECK(max_frame_len == 24U);
+    AKITA_CHECK(fragments > 1U);
+    AKITA_CHECK(nacks > 0U && sender.fragments_resent > 0U);
+    AKITA_CHECK(latency.delivered * 10U >= latency.offered * 9U);
+    return 0;
+}
+
+int main(void) {
+    if (akita_sim_telemetry_gateway() != 0 ||
+        akita_sim_duty_cycle() != 0 ||
+        akita_sim_adr() != 0 ||
+        akita_sim_fragmentation() != 0) {
+        return 1;
+    }
+
+    printf("lora simulation checks passed\n");
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_metrics.h"
+#include "bench_support.h"
+
+/* The bench shim counts nanoseconds, so one cycle per nanosecond. */
+#define AKITA_BENCH_CYCLES_PER_US 1000U
+#define AKITA_BENCH_SPANS 1000000U
+
+static int akita_check_buckets(void) {
+    akita_metric_stats_t stats;
+
+    memset(&stats, 0, sizeof(stats));
+    akita_metric_stats_add(&stats, 0U, true, true);
+    akita_metric_stats_add(&stats, 255U, true, true);
+    akita_metric_stats_add(&stats, 256U, true, false);
+    akita_metric_stats_add(&stats, 100000U, true, true);
+    akita_metric_stats_add(&stats, UINT32_MAX, true, true);
+    akita_metric_stats_add(&stats, 5000U, false, false);
+
+    AKITA_CHECK(stats.calls == 6U);
+    AKITA_CHECK(stats.errors == 2U);
+    AKITA_CHECK(stats.count == 5U);
+    AKITA_CHECK(stats.buckets[0] == 2U);
+    AKITA_CHECK(stats.buckets[1] == 1U);
+    AKITA_CHECK(stats.buckets[9] == 1U);
+    AKITA_CHECK(stats.buckets[AKITA_METRIC_BUCKETS - 1U] == 1U);
+    AKITA_CHECK(stats.max_cycles == UINT32_MAX);
+    AKITA_CHECK(stats.total_cycles == 0ULL + 255U + 256U + 100000U + UINT32_MAX);
+    return 0;
+}
+
+static int akita_check_spans(void) {
+    akita_metric_stats_t stats[AKITA_METRIC_COUNT];
+    uint64_t started_ns;
+    double per_span_ns;
+    uint32_t index;
+
+    started_ns = akita_bench_now_ns();
+    for (index = 0; index < AKITA_BENCH_SPANS; ++index) {
+        AKITA_METRIC_BEGIN(span);
+        AKITA_METRIC_END(span, AKITA_METRIC_GPS_INGEST, (index % 10U) != 0U);
+    }
+    per_span_ns = (double) (akita_bench_now_ns() - started_ns) / AKITA_BENCH_SPANS;
+
+    {
+        AKITA_METRIC_BEGIN(span);
+        AKITA_METRIC_END(span, AKITA_METRIC_COUNT, false);
+    }
+
+    akita_metrics_snapshot(stats);
+    printf("spans    %.1f ns per begin/end pair on the host\n", per_span_ns);
+    AKITA_CHECK(stats[AKITA_METRIC_GPS_INGEST].calls == AKITA_BENCH_SPANS);
+    AKITA_CHECK(stats[AKITA_METRIC_GPS_INGEST].errors == AKITA_BENCH_SPANS / 10U);
+    AKITA_CHECK(stats[AKITA_METRIC_GPS_INGEST].count == AKITA_BENCH_SPANS);
+    AKITA_CHECK(stats[AKITA_METRIC_OBD_REQUEST].calls == 0U);
+    return 0;
+}
+
+static int akita_check_prometheus(void) {
+    akita_metric_stats_t stats[AKITA_METRIC_COUNT];
+    char buffer[3072];
+    size_t length;
+    size_t largest = 0;
+    size_t part;
+    size_t index;
+
+    memset(stats, 0, sizeof(stats));
+    for (index = 0; index < 3U; ++index) {
+        akita_metric_stats_add(&stats[AKITA_METRIC_PUBLISH_HTTP], 2000000U, true, index != 0U);
+    }
+    akita_metric_stats_add(&stats[AKITA_METRIC_PUBLISH_HTTP], 1000U, true, true);
+
+    length = akita_metrics_write_prometheus(stats, AKITA_METRIC_PUBLISH_HTTP, AKITA_BENCH_CYCLES_PER_US, buffer, sizeof(buffer));
+    AKITA_CHECK(length > 0U);
+    AKITA_CHECK(strstr(buffer, "# TYPE") == NULL);
+    AKITA_CHECK(strstr(buffer, "akita_op_duration_seconds_bucket{op=\"publish_http\",le=\"2.56e-07\"} 0\n") == buffer);
+    AKITA_CHECK(strstr(buffer, "akita_op_duration_seconds_bucket{op=\"publish_http\",le=\"1.02e-06\"} 1\n") != NULL);
+    AKITA_CHECK(strstr(buffer, "akita_op_duration_seconds_bucket{op=\"publish_http\",le=\"0.00105\"} 1\n") != NULL);
+    AKITA_CHECK(strstr(buffer, "akita_op_duration_seconds_bucket{op=\"publish_http\",le=\"0.0021\"} 4\n") != NULL);
+    AKITA_CHECK(strstr(buffer, "akita_op_duration_seconds_bucket{op=\"publish_http\",le=\"+Inf\"} 4\n"
+                               "akita_op_duration_seconds_sum{op=\"publish_http\"} 0.006001\n"
+                               "akita_op_duration_seconds_count{op=\"publish_http\"} 4\n") != NULL);
+
+    length = akita_metrics_write_prometheus(stats, 0U, AKITA_BENCH_CYCLES_PER_US, buffer, sizeof(buffer));
+    AKITA_CHECK(strstr(buffer, "# HELP akita_op_duration_seconds ") == buffer);
+    AKITA_CHECK(strstr(buffer, "# TYPE akita_op_duration_seconds histogram\n") != NULL);
+
+    length = akita_metrics_write_prometheus(stats, AKITA_METRIC_COUNT, AKITA_BENCH_CYCLES_PER_US, buffer, sizeof(buffer));
+    AKITA_CHECK(strstr(buffer, "akita_op_calls_total{op=\"publish_http\"} 4\n") != NULL);
+    AKITA_CHECK(strstr(buffer, "akita_op_errors_total{op=\"publish_http\"} 1\n") != NULL);
+    AKITA_CHECK(strstr(buffer, "akita_op_errors_total{op=\"nvs_trip_write\"} 0\n") != NULL);
+    AKITA_CHECK(akita_metrics_write_prometheus(stats, AKITA_METRIC_COUNT + 1U, AKITA_BENCH_CYCLES_PER_US, buffer, sizeof(buffer)) == 0U);
+    AKITA_CHECK(akita_metrics_write_prometheus(stats, 1U, AKITA_BENCH_CYCLES_PER_US, buffer, 100U) == 0U);
+    AKITA_CHECK(strlen(buffer) < 100U);
+
+    /* With every counter at its widest, each part still fits the portal's 3 KB response chunk. */
+    for (index = 0; index < AKITA_METRIC_COUNT; ++index) {
+        memset(&stats[index], 0xFF, sizeof(stats[index]));
+    }
+    for (part = 0; part <= AKITA_METRIC_COUNT; ++part) {
+        length = akita_metrics_write_prometheus(stats, part, 80U, buffer, sizeof(buffer));
+        AKITA_CHECK(length > 0U);
+        if (length > largest) {
+            largest = length;
+        }
+    }
+    printf("exposition largest part %zu of %zu bytes\n", largest, sizeof(buffer));
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_buckets() != 0 ||
+        akita_check_spans() != 0 ||
+        akita_check_prometheus() != 0) {
+        return 1;
+    }
+
+    printf("metrics checks passed\n");
+    return 0;
+}
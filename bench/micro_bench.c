@@ -0,0 +1,579 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_app.h"
+#include "akita_board.h"
+#include "akita_config_store.h"
+#include "akita_form.h"
+#include "akita_nmea.h"
+#include "akita_obd_protocol.h"
+#include "bench_support.h"
+
+#ifndef AKITA_BENCH_CORPUS_DIR
+#define AKITA_BENCH_CORPUS_DIR "corpus"
+#endif
+
+/* One UART event's worth of bytes at 9600 baud. */
+#define AKITA_BENCH_GPS_READ_BYTES 64U
+#define AKITA_BENCH_BYTE_US 1042U
+#define AKITA_BENCH_MAX_FIXES 128U
+#define AKITA_BENCH_MAX_EXCHANGES 256U
+#define AKITA_BENCH_MAX_FORMS 16U
+#define AKITA_BENCH_MAX_VALUES 512U
+#define AKITA_BENCH_FORM_BYTES 2048U
+#define AKITA_BENCH_PAYLOAD_BYTES 768U
+#define AKITA_BENCH_BUDGET_NS 300000000ULL
+#define AKITA_BENCH_QUICK_BUDGET_NS 20000000ULL
+#define AKITA_BENCH_STACK_PROBE_BYTES 65536U
+#define AKITA_BENCH_STACK_PATTERN 0xA5U
+
+typedef struct {
+    char command[16];
+    char reply[128];
+} akita_bench_exchange_t;
+
+typedef struct {
+    uint8_t *gps;
+    size_t gps_length;
+    size_t gps_sentences;
+    akita_bench_exchange_t exchanges[AKITA_BENCH_MAX_EXCHANGES];
+    size_t exchange_count;
+    size_t reply_bytes;
+    size_t command_bytes;
+    char forms[AKITA_BENCH_MAX_FORMS][AKITA_BENCH_FORM_BYTES];
+    size_t form_count;
+    size_t form_bytes;
+    /* Encoded values split out of the forms, the way akita_form_get_value hands them to the decoder. */
+    const char *values[AKITA_BENCH_MAX_VALUES];
+    size_t value_lengths[AKITA_BENCH_MAX_VALUES];
+    size_t value_count;
+    size_t value_bytes;
+    akita_runtime_config_t configs[AKITA_BENCH_MAX_FORMS];
+    akita_runtime_config_t payload_config;
+    akita_vehicle_telemetry_t telemetry[AKITA_BENCH_MAX_FIXES];
+    size_t telemetry_count;
+    size_t json_bytes;
+    size_t compact_bytes;
+} akita_bench_corpus_t;
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    void (*run)(void);
+    /* Operations and bytes read or written by one pass over the corpus. */
+    size_t ops;
+    size_t bytes;
+} akita_bench_case_t;
+
+#define AKITA_ARRAY_LEN(array) (sizeof(array) / sizeof((array)[0]))
+
+static akita_bench_corpus_t g_corpus;
+static volatile size_t g_sink;
+static uintptr_t g_stack_probe;
+
+static char *akita_bench_read_file(const char *dir, const char *name, size_t *length) {
+    char path[512];
+    FILE *file;
+    char *data;
+    long size;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = size >= 0 ? malloc((size_t) size + 1U) : NULL;
+    if (data == NULL || fread(data, 1, (size_t) size, file) != (size_t) size) {
+        fprintf(stderr, "cannot read %s\n", path);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    data[size] = '\0';
+    *length = (size_t) size;
+    return data;
+}
+
+/* Turns the \r written out in the ELM327 corpus back into carriage returns. */
+static void akita_bench_unescape(char *text) {
+    char *dst = text;
+
+    while (*text != '\0') {
+        if (text[0] == '\\' && text[1] == 'r') {
+            *dst++ = '\r';
+            text += 2;
+        } else {
+            *dst++ = *text++;
+        }
+    }
+    *dst = '\0';
+}
+
+static void akita_bench_config_from_form(akita_runtime_config_t *config, char *body) {
+    akita_board_apply_defaults(config);
+    (void) akita_form_apply_config(body, config);
+}
+
+static int akita_bench_load_gps(const char *dir) {
+    akita_nmea_parser_t parser;
+    akita_gps_snapshot_t snapshot;
+    size_t offset = 0;
+    size_t index;
+
+    g_corpus.gps = (uint8_t *) akita_bench_read_file(dir, "gps_drive.nmea", &g_corpus.gps_length);
+    AKITA_CHECK(g_corpus.gps != NULL);
+    for (index = 0; index < g_corpus.gps_length; ++index) {
+        g_corpus.gps_sentences += g_corpus.gps[index] == '$';
+    }
+
+    /* Feed a line at a time and keep each fix as a telemetry fixture for the payload writers. */
+    akita_nmea_reset(&parser);
+    while (offset < g_corpus.gps_length) {
+        const uint8_t *line_end = memchr(g_corpus.gps + offset, '\n', g_corpus.gps_length - offset);
+        size_t length = line_end != NULL ? (size_t) (line_end - (g_corpus.gps + offset)) + 1U : g_corpus.gps_length - offset;
+        uint64_t now_us = 1000000ULL * (g_corpus.telemetry_count + 1U);
+
+        akita_nmea_feed(&parser, g_corpus.gps + offset, length, now_us, AKITA_BENCH_BYTE_US);
+        offset += length;
+        if (length > 6U && memcmp(g_corpus.gps + offset - length + 3U, "GGA", 3U) == 0 &&
+            g_corpus.telemetry_count < AKITA_BENCH_MAX_FIXES) {
+            akita_nmea_snapshot(&parser, now_us, 0U, &snapshot);
+            if (snapshot.fix) {
+                g_corpus.telemetry[g_corpus.telemetry_count++].gps = snapshot;
+            }
+        }
+    }
+    akita_nmea_snapshot(&parser, 200000000ULL, 0U, &snapshot);
+    AKITA_CHECK(snapshot.fix);
+    AKITA_CHECK(snapshot.satellites == 9U);
+    AKITA_CHECK(snapshot.latitude > 45.41f && snapshot.latitude < 45.43f);
+    AKITA_CHECK(snapshot.longitude < -75.68f && snapshot.longitude > -75.70f);
+    /* One fixture a second once the receiver has a fix, three seconds in. */
+    AKITA_CHECK(g_corpus.telemetry_count == 87U);
+    return 0;
+}
+
+static int akita_bench_load_obd(const char *dir) {
+    akita_obd_snapshot_t snapshot;
+    char *text;
+    char *line;
+    char *save = NULL;
+    size_t length;
+    size_t parsed = 0;
+    size_t index;
+
+    text = akita_bench_read_file(dir, "elm327_session.txt", &length);
+    AKITA_CHECK(text != NULL);
+    for (line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        akita_bench_exchange_t *exchange;
+        char *tab = strchr(line, '\t');
+
+        if (line[0] == '#' || tab == NULL) {
+            continue;
+        }
+        AKITA_CHECK(g_corpus.exchange_count < AKITA_BENCH_MAX_EXCHANGES);
+        *tab = '\0';
+        exchange = &g_corpus.exchanges[g_corpus.exchange_count++];
+        snprintf(exchange->command, sizeof(exchange->command), "%s", line);
+        snprintf(exchange->reply, sizeof(exchange->reply), "%s", tab + 1);
+        akita_bench_unescape(exchange->reply);
+        g_corpus.command_bytes += strlen(exchange->command) + 1U;
+        g_corpus.reply_bytes += strlen(exchange->reply);
+    }
+    free(text);
+
+    memset(&snapshot, 0, sizeof(snapshot));
+    for (index = 0; index < g_corpus.exchange_count; ++index) {
+        char request[16];
+
+        AKITA_CHECK(akita_obd_build_request(g_corpus.exchanges[index].command, request, sizeof(request)) ==
+                    strlen(g_corpus.exchanges[index].command) + 1U);
+        if (akita_obd_parse_response(&snapshot, g_corpus.exchanges[index].reply, index + 1U)) {
+            ++parsed;
+        }
+        if (index == 6U) {
+            /* SEARCHING... before the first answer. */
+            AKITA_CHECK(snapshot.rpm == 750.0f);
+        }
+        if (strncmp(g_corpus.exchanges[index].command, "01", 2U) == 0 && index / 3U < AKITA_BENCH_MAX_FIXES) {
+            g_corpus.telemetry[index / 3U].obd = snapshot;
+        }
+    }
+    AKITA_CHECK(g_corpus.exchange_count == 187U);
+    /* Every PID answered except the five error replies. */
+    AKITA_CHECK(parsed == 176U);
+    AKITA_CHECK(snapshot.coolant_c == 90.0f);
+    return 0;
+}
+
+static int akita_bench_load_forms(const char *dir) {
+    char *text;
+    char *line;
+    char *save = NULL;
+    char scratch[192];
+    char before[AKITA_BENCH_FORM_BYTES];
+    size_t length;
+    size_t index;
+
+    text = akita_bench_read_file(dir, "config_forms.txt", &length);
+    AKITA_CHECK(text != NULL);
+    for (line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        if (line[0] == '#') {
+            continue;
+        }
+        AKITA_CHECK(g_corpus.form_count < AKITA_BENCH_MAX_FORMS && strlen(line) < AKITA_BENCH_FORM_BYTES);
+        snprintf(g_corpus.forms[g_corpus.form_count], AKITA_BENCH_FORM_BYTES, "%s", line);
+        g_corpus.form_bytes += strlen(line);
+        ++g_corpus.form_count;
+    }
+    free(text);
+    AKITA_CHECK(g_corpus.form_count == 6U);
+
+    for (index = 0; index < g_corpus.form_count; ++index) {
+        const char *cursor = g_corpus.forms[index];
+
+        while (*cursor != '\0') {
+            const char *value = strchr(cursor, '=');
+            size_t value_length;
+
+            if (value == NULL) {
+                break;
+            }
+            ++value;
+            value_length = strcspn(value, "&");
+            AKITA_CHECK(g_corpus.value_count < AKITA_BENCH_MAX_VALUES && value_length < sizeof(scratch));
+            g_corpus.values[g_corpus.value_count] = value;
+            g_corpus.value_lengths[g_corpus.value_count++] = value_length;
+            g_corpus.value_bytes += value_length;
+            cursor = value + value_length + (value[value_length] == '&');
+        }
+        akita_bench_config_from_form(&g_corpus.configs[index], g_corpus.forms[index]);
+    }
+
+    memcpy(before, g_corpus.forms[1], sizeof(before));
+    AKITA_CHECK(akita_form_get_value(g_corpus.forms[1], "wifi_password", scratch, sizeof(scratch)));
+    AKITA_CHECK(strcmp(scratch, "p@ss w0rd/100%!") == 0);
+    AKITA_CHECK(akita_form_get_value(g_corpus.forms[1], "wifi_ssid", scratch, sizeof(scratch)));
+    AKITA_CHECK(strcmp(scratch, "Depot Wi-Fi & Guests") == 0);
+    AKITA_CHECK(akita_form_get_value(g_corpus.forms[5], "telemetry_endpoint", scratch, sizeof(scratch)));
+    AKITA_CHECK(strcmp(scratch, "http://telemetry.example.net:8080/ingest?node=07&fmt=json") == 0);
+    /* The body is handed back unchanged, so later lookups still see every field. */
+    AKITA_CHECK(memcmp(before, g_corpus.forms[1], sizeof(before)) == 0);
+    AKITA_CHECK(!akita_form_get_value(g_corpus.forms[4], "obd_device_name", scratch, sizeof(scratch)));
+    AKITA_CHECK(akita_form_contains(g_corpus.forms[3], "lora_gateway_enabled"));
+    AKITA_CHECK(!akita_form_contains(g_corpus.forms[2], "enable_gps"));
+    /* "publish_on_change" must not match inside another key or a value. */
+    AKITA_CHECK(!akita_form_contains("x_publish_on_change=on&y=publish_on_change", "publish_on_change"));
+    strcpy(scratch, "a%2Bb+c%zz%4");
+    akita_form_url_decode(scratch);
+    AKITA_CHECK(strcmp(scratch, "a+b c%zz%4") == 0);
+
+    /* The corpus goes through the portal's own apply, so these are the values it would save. */
+    AKITA_CHECK(strcmp(g_corpus.configs[1].wifi_ssid, "Depot Wi-Fi & Guests") == 0);
+    AKITA_CHECK(g_corpus.configs[3].lora_gateway_enabled);
+    AKITA_CHECK(!g_corpus.configs[2].enable_gps);
+    {
+        akita_runtime_config_t config;
+        akita_runtime_config_t before_apply;
+
+        akita_board_apply_defaults(&config);
+        before_apply = config;
+        strcpy(scratch, "vehicle_id=other&reticulum_destination=xyz");
+        AKITA_CHECK(akita_form_apply_config(scratch, &config) == ESP_ERR_INVALID_ARG);
+        AKITA_CHECK(memcmp(&before_apply, &config, sizeof(config)) == 0);
+    }
+    return 0;
+}
+
+static int akita_bench_check_sanitize(void) {
+    akita_runtime_config_t config = g_corpus.configs[2];
+
+    akita_config_sanitize(&config);
+    AKITA_CHECK(config.telemetry_interval_ms == 1000U);
+    AKITA_CHECK(config.publish_heartbeat_ms == 3600000U);
+    AKITA_CHECK(config.publish_min_interval_ms == 500U);
+    AKITA_CHECK(config.publish_heading_deadband_deg == 180U);
+    AKITA_CHECK(config.track_tolerance_m == 500U);
+    AKITA_CHECK(config.gps_uart_baud == 9600U);
+    AKITA_CHECK(config.lora_frequency_hz == akita_board_get_defaults()->lora_frequency_hz);
+    AKITA_CHECK(config.lora_region == AKITA_LORA_REGION_AUTO);
+    AKITA_CHECK(config.lora_spreading_factor == 7U);
+    AKITA_CHECK(config.lora_bandwidth_hz == 125000U);
+    AKITA_CHECK(config.lora_coding_rate == 5U);
+    AKITA_CHECK(config.lora_tx_power_dbm == 17);
+    AKITA_CHECK(config.transport_mode == AKITA_TRANSPORT_NONE);
+
+    config = g_corpus.configs[4];
+    akita_config_sanitize(&config);
+    AKITA_CHECK(strcmp(config.vehicle_id, "AkitaCarNode") == 0);
+
+    /* Sanitizing is idempotent, so a saved config reads back exactly as it was written. */
+    config = g_corpus.configs[1];
+    akita_config_sanitize(&config);
+    {
+        akita_runtime_config_t again = config;
+
+        akita_config_sanitize(&again);
+        AKITA_CHECK(memcmp(&again, &config, sizeof(config)) == 0);
+    }
+    return 0;
+}
+
+static int akita_bench_check_payload(void) {
+    char json[AKITA_BENCH_PAYLOAD_BYTES];
+    char compact[AKITA_BENCH_PAYLOAD_BYTES];
+    size_t index;
+
+    akita_board_apply_defaults(&g_corpus.payload_config);
+    snprintf(g_corpus.payload_config.vehicle_id, sizeof(g_corpus.payload_config.vehicle_id), "%s", "fleet-07");
+    g_akita_bench_time_us = 1792300951000000LL;
+    for (index = 0; index < g_corpus.telemetry_count; ++index) {
+        akita_vehicle_telemetry_t *telemetry = &g_corpus.telemetry[index];
+        size_t json_length;
+        size_t compact_length;
+
+        telemetry->obd.connected = telemetry->obd.rpm_ms != 0U;
+        telemetry->system.transport_ready = true;
+        telemetry->system.lora_ready = true;
+        telemetry->system.wifi_rssi = (int8_t) -(int) (48U + index % 30U);
+        telemetry->system.free_heap = 151000U - (uint32_t) index * 8U;
+        telemetry->system.sampled_ms = telemetry->gps.fix_ms;
+
+        json_length = akita_payload_write_json(&g_corpus.payload_config, telemetry, json, sizeof(json));
+        compact_length = akita_payload_write_compact_json(&g_corpus.payload_config, telemetry, compact, sizeof(compact));
+        AKITA_CHECK(json_length > 0U && json_length == strlen(json));
+        AKITA_CHECK(compact_length > 0U && compact_length < json_length);
+        AKITA_CHECK(json[0] == '{' && json[json_length - 1U] == '}');
+        AKITA_CHECK(strstr(json, "fleet-07") != NULL);
+        g_corpus.json_bytes += json_length;
+        g_corpus.compact_bytes += compact_length;
+    }
+    return 0;
+}
+
+static void akita_bench_noop(void) {
+}
+
+static void akita_bench_nmea_feed(void) {
+    akita_nmea_parser_t parser;
+    akita_gps_snapshot_t snapshot;
+    size_t offset;
+
+    akita_nmea_reset(&parser);
+    for (offset = 0; offset < g_corpus.gps_length; offset += AKITA_BENCH_GPS_READ_BYTES) {
+        size_t length = g_corpus.gps_length - offset;
+
+        if (length > AKITA_BENCH_GPS_READ_BYTES) {
+            length = AKITA_BENCH_GPS_READ_BYTES;
+        }
+        akita_nmea_feed(&parser, g_corpus.gps + offset, length, (offset + length) * AKITA_BENCH_BYTE_US,
+                        AKITA_BENCH_BYTE_US);
+    }
+    akita_nmea_snapshot(&parser, (uint64_t) g_corpus.gps_length * AKITA_BENCH_BYTE_US, 0U, &snapshot);
+    g_sink += snapshot.satellites;
+}
+
+static void akita_bench_obd_parse(void) {
+    akita_obd_snapshot_t snapshot;
+    size_t index;
+
+    memset(&snapshot, 0, sizeof(snapshot));
+    for (index = 0; index < g_corpus.exchange_count; ++index) {
+        g_sink += akita_obd_parse_response(&snapshot, g_corpus.exchanges[index].reply, index + 1U);
+    }
+}
+
+static void akita_bench_obd_build(void) {
+    char request[16];
+    size_t index;
+
+    for (index = 0; index < g_corpus.exchange_count; ++index) {
+        g_sink += akita_obd_build_request(g_corpus.exchanges[index].command, request, sizeof(request));
+    }
+}
+
+static void akita_bench_form_decode(void) {
+    char scratch[192];
+    size_t index;
+
+    for (index = 0; index < g_corpus.value_count; ++index) {
+        memcpy(scratch, g_corpus.values[index], g_corpus.value_lengths[index]);
+        scratch[g_corpus.value_lengths[index]] = '\0';
+        akita_form_url_decode(scratch);
+        g_sink += (unsigned char) scratch[0];
+    }
+}
+
+/* The portal's POST handler applying each body to the defaults. */
+static void akita_bench_form_apply(void) {
+    akita_runtime_config_t config;
+    size_t index;
+
+    for (index = 0; index < g_corpus.form_count; ++index) {
+        akita_board_apply_defaults(&config);
+        g_sink += akita_form_apply_config(g_corpus.forms[index], &config) == ESP_OK;
+        g_sink += config.telemetry_interval_ms;
+    }
+}
+
+static void akita_bench_config_sanitize(void) {
+    akita_runtime_config_t config;
+    size_t index;
+
+    for (index = 0; index < g_corpus.form_count; ++index) {
+        config = g_corpus.configs[index];
+        akita_config_sanitize(&config);
+        g_sink += config.telemetry_interval_ms;
+    }
+}
+
+static void akita_bench_payload_json(void) {
+    char buffer[AKITA_BENCH_PAYLOAD_BYTES];
+    size_t index;
+
+    for (index = 0; index < g_corpus.telemetry_count; ++index) {
+        g_sink += akita_payload_write_json(&g_corpus.payload_config, &g_corpus.telemetry[index], buffer, sizeof(buffer));
+    }
+}
+
+static void akita_bench_payload_compact(void) {
+    char buffer[AKITA_BENCH_PAYLOAD_BYTES];
+    size_t index;
+
+    for (index = 0; index < g_corpus.telemetry_count; ++index) {
+        g_sink += akita_payload_write_compact_json(&g_corpus.payload_config, &g_corpus.telemetry[index], buffer,
+                                                   sizeof(buffer));
+    }
+}
+
+/*
+ * Stack use is the depth a case reaches below the caller: paint a region under the current frame, run the
+ * case from the same frame, then find the lowest byte that changed.
+ */
+static __attribute__((noinline)) void akita_bench_stack_paint(void) {
+    volatile uint8_t area[AKITA_BENCH_STACK_PROBE_BYTES];
+    size_t index;
+
+    for (index = 0; index < sizeof(area); ++index) {
+        area[index] = AKITA_BENCH_STACK_PATTERN;
+    }
+    g_stack_probe = (uintptr_t) area;
+}
+
+static __attribute__((noinline)) size_t akita_bench_stack_reached(void) {
+    const volatile uint8_t *probe = (const volatile uint8_t *) g_stack_probe;
+    size_t index = 0;
+
+    while (index < AKITA_BENCH_STACK_PROBE_BYTES && probe[index] == AKITA_BENCH_STACK_PATTERN) {
+        ++index;
+    }
+    return AKITA_BENCH_STACK_PROBE_BYTES - index;
+}
+
+static __attribute__((noinline)) size_t akita_bench_stack(void (*run)(void)) {
+    akita_bench_stack_paint();
+    run();
+    return akita_bench_stack_reached();
+}
+
+static int akita_bench_run(const akita_bench_case_t *cases, size_t count, bool quick, FILE *out) {
+    uint64_t budget_ns = quick ? AKITA_BENCH_QUICK_BUDGET_NS : AKITA_BENCH_BUDGET_NS;
+    size_t baseline = akita_bench_stack(akita_bench_noop);
+    size_t index;
+
+    fprintf(out, "{\n  \"suite\": \"akita_micro_bench\",\n  \"quick\": %s,\n  \"cases\": [\n", quick ? "true" : "false");
+    for (index = 0; index < count; ++index) {
+        const akita_bench_case_t *bench_case = &cases[index];
+        uint64_t passes = 0;
+        uint64_t started_ns;
+        uint64_t elapsed_ns;
+        size_t stack;
+        uint64_t ops;
+
+        stack = akita_bench_stack(bench_case->run);
+        stack = stack > baseline ? stack - baseline : 0U;
+        bench_case->run();
+        started_ns = akita_bench_now_ns();
+        do {
+            bench_case->run();
+            ++passes;
+            elapsed_ns = akita_bench_now_ns() - started_ns;
+        } while (elapsed_ns < budget_ns);
+
+        ops = passes * bench_case->ops;
+        fprintf(out,
+                "    {\"name\": \"%s\", \"unit\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.2f, "
+                "\"bytes_per_op\": %.2f, \"stack_bytes\": %zu}%s\n",
+                bench_case->name, bench_case->unit, (unsigned long long) ops, (double) elapsed_ns / (double) ops,
+                (double) bench_case->bytes / (double) bench_case->ops, stack, index + 1U < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *corpus_dir = AKITA_BENCH_CORPUS_DIR;
+    const char *output_path = NULL;
+    bool quick = false;
+    FILE *out = stdout;
+    int index;
+    int result;
+
+    for (index = 1; index < argc; ++index) {
+        if (strcmp(argv[index], "--quick") == 0) {
+            quick = true;
+        } else if (strcmp(argv[index], "--corpus") == 0 && index + 1 < argc) {
+            corpus_dir = argv[++index];
+        } else if (strcmp(argv[index], "--output") == 0 && index + 1 < argc) {
+            output_path = argv[++index];
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--corpus DIR] [--output FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (akita_bench_load_gps(corpus_dir) != 0 ||
+        akita_bench_load_obd(corpus_dir) != 0 ||
+        akita_bench_load_forms(corpus_dir) != 0 ||
+        akita_bench_check_sanitize() != 0 ||
+        akita_bench_check_payload() != 0) {
+        return 1;
+    }
+
+    {
+        const akita_bench_case_t cases[] = {
+            { "nmea_feed", "sentence", akita_bench_nmea_feed, g_corpus.gps_sentences, g_corpus.gps_length },
+            { "obd_parse_response", "reply", akita_bench_obd_parse, g_corpus.exchange_count, g_corpus.reply_bytes },
+            { "obd_build_request", "request", akita_bench_obd_build, g_corpus.exchange_count, g_corpus.command_bytes },
+            { "form_url_decode", "value", akita_bench_form_decode, g_corpus.value_count, g_corpus.value_bytes },
+            { "form_apply", "body", akita_bench_form_apply, g_corpus.form_count, g_corpus.form_bytes },
+            { "config_sanitize", "config", akita_bench_config_sanitize, g_corpus.form_count,
+              g_corpus.form_count * sizeof(akita_runtime_config_t) },
+            { "payload_json", "payload", akita_bench_payload_json, g_corpus.telemetry_count, g_corpus.json_bytes },
+            { "payload_compact_json", "payload", akita_bench_payload_compact, g_corpus.telemetry_count,
+              g_corpus.compact_bytes },
+        };
+
+        if (output_path != NULL) {
+            out = fopen(output_path, "w");
+            if (out == NULL) {
+                fprintf(stderr, "cannot write %s\n", output_path);
+                return 1;
+            }
+        }
+        result = akita_bench_run(cases, AKITA_ARRAY_LEN(cases), quick, out);
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+
+    free(g_corpus.gps);
+    return result;
+}
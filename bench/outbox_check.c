@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_outbox.h"
+#include "bench_support.h"
+
+static akita_outbox_t g_outbox;
+
+static bool akita_push(akita_message_class_t message_class, uint64_t created_ms, uint64_t deadline_ms) {
+    akita_outbox_message_t message;
+
+    memset(&message, 0, sizeof(message));
+    message.message_class = message_class;
+    message.created_ms = created_ms;
+    message.deadline_ms = deadline_ms;
+    return akita_outbox_push(&g_outbox, &message);
+}
+
+static int akita_check_strict_priority(void) {
+    akita_outbox_message_t message;
+
+    akita_outbox_init(&g_outbox);
+    AKITA_CHECK(!akita_outbox_pop(&g_outbox, 1000U, &message));
+
+    /* An alert queued behind routine and bulk backlog still goes out next. */
+    akita_push(AKITA_MESSAGE_ROUTINE, 1U, AKITA_OUTBOX_NO_DEADLINE);
+    akita_push(AKITA_MESSAGE_BULK, 2U, AKITA_OUTBOX_NO_DEADLINE);
+    akita_push(AKITA_MESSAGE_ALERT, 3U, AKITA_OUTBOX_NO_DEADLINE);
+    AKITA_CHECK(akita_outbox_pending(&g_outbox) == 3U);
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 1000U, &message));
+    AKITA_CHECK(message.message_class == AKITA_MESSAGE_ALERT);
+    AKITA_CHECK(message.created_ms == 3U);
+
+    akita_push(AKITA_MESSAGE_ALERT, 4U, AKITA_OUTBOX_NO_DEADLINE);
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 1000U, &message));
+    AKITA_CHECK(message.message_class == AKITA_MESSAGE_ALERT);
+    AKITA_CHECK(g_outbox.counters[AKITA_MESSAGE_ALERT].sent == 2U);
+    return 0;
+}
+
+static int akita_check_weighted_share(void) {
+    akita_outbox_message_t message;
+    uint32_t sent[AKITA_MESSAGE_CLASS_COUNT] = {0};
+    uint32_t index;
+
+    /* With every class backlogged, seven sends split 4:2:1 between events, routine samples and bulk data. */
+    akita_outbox_init(&g_outbox);
+    for (index = 0; index < AKITA_OUTBOX_DEPTH; ++index) {
+        akita_push(AKITA_MESSAGE_EVENT, index, AKITA_OUTBOX_NO_DEADLINE);
+        akita_push(AKITA_MESSAGE_ROUTINE, index, AKITA_OUTBOX_NO_DEADLINE);
+        akita_push(AKITA_MESSAGE_BULK, index, AKITA_OUTBOX_NO_DEADLINE);
+    }
+    for (index = 0; index < 7U; ++index) {
+        AKITA_CHECK(akita_outbox_pop(&g_outbox, 1000U, &message));
+        ++sent[message.message_class];
+    }
+    AKITA_CHECK(sent[AKITA_MESSAGE_EVENT] == 4U);
+    AKITA_CHECK(sent[AKITA_MESSAGE_ROUTINE] == 2U);
+    AKITA_CHECK(sent[AKITA_MESSAGE_BULK] == 1U);
+
+    /* Bulk data is slowest but never starves. */
+    while (akita_outbox_pop(&g_outbox, 1000U, &message)) {
+        ++sent[message.message_class];
+    }
+    AKITA_CHECK(sent[AKITA_MESSAGE_BULK] == AKITA_OUTBOX_DEPTH);
+    AKITA_CHECK(akita_outbox_pending(&g_outbox) == 0U);
+    return 0;
+}
+
+static int akita_check_deadlines(void) {
+    akita_outbox_message_t message;
+
+    akita_outbox_init(&g_outbox);
+    akita_push(AKITA_MESSAGE_ROUTINE, 0U, 2000U);
+    akita_push(AKITA_MESSAGE_ROUTINE, 1000U, 3000U);
+    akita_push(AKITA_MESSAGE_ALERT, 1000U, AKITA_OUTBOX_NO_DEADLINE);
+
+    /* After an outage the stale sample is dropped, the newer one and the alert are kept. */
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 2500U, &message));
+    AKITA_CHECK(message.message_class == AKITA_MESSAGE_ALERT);
+    AKITA_CHECK(g_outbox.counters[AKITA_MESSAGE_ROUTINE].dropped_stale == 1U);
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 2500U, &message));
+    AKITA_CHECK(message.created_ms == 1000U);
+
+    akita_push(AKITA_MESSAGE_ROUTINE, 2000U, 4000U);
+    AKITA_CHECK(!akita_outbox_pop(&g_outbox, 4001U, &message));
+    AKITA_CHECK(g_outbox.counters[AKITA_MESSAGE_ROUTINE].dropped_stale == 2U);
+    AKITA_CHECK(akita_outbox_pending(&g_outbox) == 0U);
+    return 0;
+}
+
+static int akita_check_overflow_and_requeue(void) {
+    akita_outbox_message_t message;
+    uint32_t index;
+
+    akita_outbox_init(&g_outbox);
+    for (index = 0; index < AKITA_OUTBOX_DEPTH; ++index) {
+        AKITA_CHECK(akita_push(AKITA_MESSAGE_ROUTINE, index, AKITA_OUTBOX_NO_DEADLINE));
+    }
+
+    /* A full queue keeps the newest samples. */
+    AKITA_CHECK(!akita_push(AKITA_MESSAGE_ROUTINE, 100U, AKITA_OUTBOX_NO_DEADLINE));
+    AKITA_CHECK(g_outbox.counters[AKITA_MESSAGE_ROUTINE].dropped_overflow == 1U);
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 1000U, &message));
+    AKITA_CHECK(message.created_ms == 1U);
+
+    /* A failed send goes back to the head and is retried before anything newer. */
+    akita_outbox_requeue(&g_outbox, &message);
+    AKITA_CHECK(g_outbox.counters[AKITA_MESSAGE_ROUTINE].sent == 0U);
+    AKITA_CHECK(akita_outbox_pending(&g_outbox) == AKITA_OUTBOX_DEPTH);
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 1000U, &message));
+    AKITA_CHECK(message.created_ms == 1U);
+    AKITA_CHECK(akita_outbox_pop(&g_outbox, 1000U, &message));
+    AKITA_CHECK(message.created_ms == 2U);
+    AKITA_CHECK(g_outbox.counters[AKITA_MESSAGE_ROUTINE].queued == AKITA_OUTBOX_DEPTH + 1U);
+    return 0;
+}
+
+static int akita_check_trip_lookup(void) {
+    akita_outbox_message_t message;
+    uint32_t index;
+
+    akita_outbox_init(&g_outbox);
+    memset(&message, 0, sizeof(message));
+    message.message_class = AKITA_MESSAGE_EVENT;
+    message.kind = AKITA_OUTBOX_TRIP;
+    message.trip.trip_id = 7U;
+    AKITA_CHECK(akita_outbox_push(&g_outbox, &message));
+    AKITA_CHECK(akita_outbox_holds_trip(&g_outbox, 7U));
+    AKITA_CHECK(!akita_outbox_holds_trip(&g_outbox, 8U));
+    AKITA_CHECK(!akita_outbox_holds_trip(&g_outbox, 0U));
+
+    /* Once events push it out of a full queue, the trip has to be offered again. */
+    for (index = 0; index < AKITA_OUTBOX_DEPTH; ++index) {
+        akita_push(AKITA_MESSAGE_EVENT, index, AKITA_OUTBOX_NO_DEADLINE);
+    }
+    AKITA_CHECK(!akita_outbox_holds_trip(&g_outbox, 7U));
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_strict_priority() != 0 ||
+        akita_check_weighted_share() != 0 ||
+        akita_check_deadlines() != 0 ||
+        akita_check_overflow_and_requeue() != 0 ||
+        akita_check_trip_lookup() != 0) {
+        return 1;
+    }
+
+    printf("outbox checks passed\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_app.h"
+#include "akita_board.h"
+#include "bench_support.h"
+#include "payload_snprintf_baseline.h"
+
+#define AKITA_BENCH_ITERATIONS 200000U
+
+typedef size_t (*akita_payload_writer_fn)(
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    char *buffer,
+    size_t buffer_size
+);
+
+static void akita_bench_fixture(akita_runtime_config_t *config, akita_vehicle_telemetry_t *telemetry, size_t variant) {
+    static const char *kVehicleIds[] = { "AkitaCarNode", "fleet-07", "van \"blue\"", "C:\\cars\\3" };
+
+    memset(config, 0, sizeof(*config));
+    memset(telemetry, 0, sizeof(*telemetry));
+    config->board_profile = AKITA_BOARD_HELTEC_LORA32_V2;
+    snprintf(config->vehicle_id, sizeof(config->vehicle_id), "%s", kVehicleIds[variant % 4U]);
+
+    telemetry->obd.connected = (variant % 2U) == 0U;
+    telemetry->obd.rpm = 812.25f + (float) (variant * 37U);
+    telemetry->obd.speed_kmh = (float) (variant % 130U);
+    telemetry->obd.coolant_c = variant % 5U == 0U ? -0.04f : 88.5f;
+    telemetry->gps.fix = true;
+    telemetry->gps.latitude = 45.421532f + ((float) variant * 0.000113f);
+    telemetry->gps.longitude = -75.697189f - ((float) variant * 0.000071f);
+    telemetry->gps.altitude_m = 70.3f;
+    telemetry->gps.speed_kmh = 53.8f;
+    telemetry->gps.satellites = (uint8_t) (variant % 14U);
+    telemetry->system.transport_ready = true;
+    telemetry->system.lora_ready = (variant % 3U) == 0U;
+    telemetry->system.wifi_rssi = (int8_t) -(int) (40U + variant % 50U);
+    telemetry->system.free_heap = 152345U - (uint32_t) variant;
+}
+
+static int akita_bench_check_parity(void) {
+    akita_runtime_config_t config;
+    akita_vehicle_telemetry_t telemetry;
+    char expected[768];
+    char actual[768];
+    size_t variant;
+
+    g_akita_bench_time_us = 123456789000LL;
+    for (variant = 0; variant < 64U; ++variant) {
+        akita_bench_fixture(&config, &telemetry, variant);
+        akita_payload_write_json_snprintf(&config, &telemetry, expected, sizeof(expected));
+        akita_payload_write_json(&config, &telemetry, actual, sizeof(actual));
+        if (strcmp(expected, actual) != 0) {
+            fprintf(stderr, "payload mismatch for variant %zu\n  expected %s\n  actual   %s\n", variant, expected, actual);
+            return 1;
+        }
+    }
+
+    if (akita_payload_write_json(&config, &telemetry, actual, 64U) != 0U) {
+        fprintf(stderr, "truncated payload was reported as written\n");
+        return 1;
+    }
+
+    g_akita_bench_time_us = 0;
+    return 0;
+}
+
+static void akita_bench_run(const char *name, akita_payload_writer_fn writer) {
+    akita_runtime_config_t config;
+    akita_vehicle_telemetry_t telemetry;
+    char buffer[768];
+    uint64_t total_bytes = 0;
+    uint64_t start_ns;
+    uint64_t start_cycles;
+    uint64_t elapsed_ns;
+    uint64_t elapsed_cycles;
+    unsigned iteration;
+
+    akita_bench_fixture(&config, &telemetry, 1U);
+    start_ns = akita_bench_now_ns();
+    start_cycles = akita_bench_cycles();
+    for (iteration = 0; iteration < AKITA_BENCH_ITERATIONS; ++iteration) {
+        telemetry.obd.rpm = 800.0f + (float) (iteration & 1023U);
+        total_bytes += writer(&config, &telemetry, buffer, sizeof(buffer));
+    }
+    elapsed_cycles = akita_bench_cycles() - start_cycles;
+    elapsed_ns = akita_bench_now_ns() - start_ns;
+
+    printf(
+        "%-10s %10.0f payloads/s %8.1f ns/payload %6.1f bytes/payload",
+        name,
+        (double) AKITA_BENCH_ITERATIONS * 1.0e9 / (double) elapsed_ns,
+        (double) elapsed_ns / (double) AKITA_BENCH_ITERATIONS,
+        (double) total_bytes / (double) AKITA_BENCH_ITERATIONS
+    );
+    if (akita_bench_has_cycle_counter()) {
+        printf(" %6.3f bytes/cycle", (double) total_bytes / (double) elapsed_cycles);
+    }
+    printf("\n");
+}
+
+int main(void) {
+    if (akita_bench_check_parity() != 0) {
+        return 1;
+    }
+
+    akita_bench_run("snprintf", akita_payload_write_json_snprintf);
+    akita_bench_run("writer", akita_payload_write_json);
+    return 0;
+}
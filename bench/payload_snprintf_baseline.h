@@ -0,0 +1,15 @@
+#ifndef AKITA_PAYLOAD_SNPRINTF_BASELINE_H
+#define AKITA_PAYLOAD_SNPRINTF_BASELINE_H
+
+#include <stddef.h>
+
+#include "akita_types.h"
+
+size_t akita_payload_write_json_snprintf(
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    char *buffer,
+    size_t buffer_size
+);
+
+#endif
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_board.h"
+#include "akita_publish_policy.h"
+#include "bench_support.h"
+
+/* The firmware polls sensors every 200 ms. */
+#define AKITA_STEP_MS 200U
+
+static akita_runtime_config_t g_config;
+static akita_publish_policy_t g_policy;
+static akita_vehicle_telemetry_t g_telemetry;
+static uint64_t g_now_ms;
+
+static void akita_start(bool fix, bool obd) {
+    akita_board_apply_defaults(&g_config);
+    akita_publish_policy_init(&g_policy);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    g_telemetry.gps.fix = fix;
+    g_telemetry.obd.connected = obd;
+    g_telemetry.obd.coolant_c = 90.0f;
+    g_telemetry.obd.rpm = obd ? 800.0f : 0.0f;
+    g_now_ms = 1000U;
+    akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms);
+    memset(g_policy.counts, 0, sizeof(g_policy.counts));
+}
+
+/* Drives for duration_ms, turning at turn_deg_per_s, and returns how many samples were published. */
+static uint32_t akita_drive(uint32_t duration_ms, float speed_kmh, float turn_deg_per_s) {
+    uint32_t published = 0;
+    uint32_t elapsed;
+
+    for (elapsed = 0; elapsed < duration_ms; elapsed += AKITA_STEP_MS) {
+        g_now_ms += AKITA_STEP_MS;
+        g_telemetry.gps.speed_kmh = speed_kmh;
+        g_telemetry.obd.speed_kmh = speed_kmh;
+        g_telemetry.gps.course_deg += turn_deg_per_s * (float) AKITA_STEP_MS / 1000.0f;
+        if (g_telemetry.gps.course_deg >= 360.0f) {
+            g_telemetry.gps.course_deg -= 360.0f;
+        }
+        if (akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) != AKITA_PUBLISH_SKIP) {
+            ++published;
+        }
+    }
+
+    return published;
+}
+
+static int akita_check_parked(void) {
+    /* Ten minutes parked with the engine off is ten heartbeats, not sixty fixed-interval samples. */
+    akita_start(true, false);
+    AKITA_CHECK(akita_drive(600000U, 0.0f, 0.0f) == 10U);
+    AKITA_CHECK(g_policy.counts[AKITA_PUBLISH_HEARTBEAT] == 10U);
+    return 0;
+}
+
+static int akita_check_speed_scaling(void) {
+    uint32_t highway;
+    uint32_t town;
+
+    /* A fixed spacing along the road: 250 m is every 7.5 s at 120 km/h and every 30 s at 30 km/h. */
+    akita_start(true, true);
+    highway = akita_drive(300000U, 120.0f, 0.0f);
+    AKITA_CHECK(g_policy.counts[AKITA_PUBLISH_DEADBAND] == 1U);
+    AKITA_CHECK(g_policy.counts[AKITA_PUBLISH_DISTANCE] >= 39U && g_policy.counts[AKITA_PUBLISH_DISTANCE] <= 41U);
+    AKITA_CHECK(g_policy.counts[AKITA_PUBLISH_HEADING] == 0U);
+
+    akita_start(true, true);
+    g_telemetry.gps.speed_kmh = 30.0f;
+    town = akita_drive(300000U, 30.0f, 0.0f);
+    AKITA_CHECK(town >= 10U && town <= 12U);
+    AKITA_CHECK(highway > 3U * town);
+
+    /* Without a GPS fix the distance comes from OBD speed. */
+    akita_start(false, true);
+    g_telemetry.obd.speed_kmh = 60.0f;
+    AKITA_CHECK(akita_drive(150000U, 60.0f, 0.0f) >= 9U);
+    AKITA_CHECK(g_policy.counts[AKITA_PUBLISH_DISTANCE] >= 9U);
+    return 0;
+}
+
+static int akita_check_corners(void) {
+    uint32_t straight;
+    uint32_t corner;
+
+    /* A 90 degree turn over 10 s at 40 km/h gets a point every 20 degrees; the same straight gets one. */
+    akita_start(true, true);
+    g_telemetry.gps.speed_kmh = 40.0f;
+    g_telemetry.obd.speed_kmh = 40.0f;
+    akita_drive(1000U, 40.0f, 0.0f);
+    straight = akita_drive(10000U, 40.0f, 0.0f);
+
+    akita_start(true, true);
+    g_telemetry.gps.speed_kmh = 40.0f;
+    g_telemetry.obd.speed_kmh = 40.0f;
+    akita_drive(1000U, 40.0f, 0.0f);
+    corner = akita_drive(10000U, 40.0f, 9.0f);
+    AKITA_CHECK(straight <= 1U);
+    AKITA_CHECK(g_policy.counts[AKITA_PUBLISH_HEADING] >= 4U);
+    AKITA_CHECK(corner >= straight + 4U);
+
+    /* Heading wraps through north, and course jitter while nearly stopped is ignored. */
+    akita_start(true, true);
+    g_telemetry.gps.course_deg = 350.0f;
+    g_telemetry.gps.speed_kmh = 50.0f;
+    g_telemetry.obd.speed_kmh = 50.0f;
+    g_now_ms += 1000U;
+    akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms);
+    g_telemetry.gps.course_deg = 5.0f;
+    g_now_ms += 1000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_SKIP);
+    g_telemetry.gps.course_deg = 11.0f;
+    g_now_ms += 1000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_HEADING);
+
+    akita_start(true, true);
+    g_telemetry.gps.speed_kmh = 3.0f;
+    g_telemetry.obd.speed_kmh = 3.0f;
+    g_telemetry.gps.course_deg = 180.0f;
+    g_now_ms += 2000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_SKIP);
+    return 0;
+}
+
+static int akita_check_deadbands(void) {
+    akita_start(true, true);
+
+    /* Changes inside the deadbands are held back; state changes are not. */
+    g_telemetry.obd.rpm = 1200.0f;
+    g_telemetry.obd.coolant_c = 92.0f;
+    g_now_ms += 2000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_SKIP);
+    g_telemetry.obd.coolant_c = 93.0f;
+    g_now_ms += 2000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_DEADBAND);
+    g_telemetry.obd.rpm = 1800.0f;
+    g_now_ms += 2000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_DEADBAND);
+
+    /* Never closer than the minimum interval, even when every sample changes. */
+    g_telemetry.gps.fix = false;
+    g_now_ms += 400U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_SKIP);
+    g_now_ms += 600U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_STATE);
+
+    /* A zero deadband turns that trigger off. */
+    g_config.publish_rpm_deadband = 0U;
+    g_telemetry.obd.rpm = 6000.0f;
+    g_now_ms += 2000U;
+    AKITA_CHECK(akita_publish_policy_check(&g_policy, &g_config, &g_telemetry, g_now_ms) == AKITA_PUBLISH_SKIP);
+    AKITA_CHECK(strcmp(akita_publish_reason_name(AKITA_PUBLISH_HEADING), "heading") == 0);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_parked() != 0 ||
+        akita_check_speed_scaling() != 0 ||
+        akita_check_corners() != 0 ||
+        akita_check_deadbands() != 0) {
+        return 1;
+    }
+
+    printf("publish policy checks passed\n");
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_board.h"
+#include "akita_rules.h"
+#include "bench_support.h"
+
+#define AKITA_BENCH_ITERATIONS 200000U
+
+static akita_rule_set_t g_rules;
+static akita_vehicle_telemetry_t g_telemetry;
+static akita_rule_match_t g_matches[AKITA_RULES_MAX];
+
+static size_t akita_step(uint64_t now_ms) {
+    return akita_rules_evaluate(&g_rules, &g_telemetry, now_ms, g_matches, AKITA_RULES_MAX);
+}
+
+static int akita_check_compile(void) {
+    char error[128];
+
+    AKITA_CHECK(akita_rules_compile(&g_rules, AKITA_DEFAULT_EVENT_RULES, error, sizeof(error)) == 3U);
+    AKITA_CHECK(error[0] == '\0');
+    AKITA_CHECK(strcmp(g_rules.rules[0].name, "coolant_high") == 0);
+    AKITA_CHECK(g_rules.rules[0].field == AKITA_AGGREGATE_FIELD_OBD_COOLANT);
+    AKITA_CHECK(g_rules.rules[0].message_class == AKITA_MESSAGE_ALERT);
+    AKITA_CHECK(g_rules.rules[0].clear_band == 5.0f);
+    AKITA_CHECK(g_rules.rules[1].op == AKITA_RULE_ABOVE && g_rules.rules[1].hold_ms == 1000U);
+    AKITA_CHECK(g_rules.rules[2].op == AKITA_RULE_FALLING && g_rules.rules[2].field == AKITA_AGGREGATE_FIELD_GPS_SPEED);
+
+    /* Bad rules are reported and skipped; the rest still compile. */
+    AKITA_CHECK(akita_rules_compile(&g_rules, "a=obd.boost>1; b=gps.alt_m<-10 ; c=obd.rpm>x; d=system.free_heap<20000@5000",
+                                    error, sizeof(error)) == 2U);
+    AKITA_CHECK(strstr(error, "c=obd.rpm>x") != NULL);
+    AKITA_CHECK(g_rules.rules[0].op == AKITA_RULE_BELOW && g_rules.rules[0].threshold == 10.0f);
+    AKITA_CHECK(strcmp(g_rules.rules[1].name, "d") == 0);
+    AKITA_CHECK(akita_rules_compile(&g_rules, "", error, sizeof(error)) == 0U);
+    AKITA_CHECK(akita_rules_compile(&g_rules, "a_name_that_is_too_long=obd.rpm>1", NULL, 0U) == 0U);
+    return 0;
+}
+
+static int akita_check_threshold(void) {
+    uint64_t now_ms = 1000U;
+
+    akita_rules_compile(&g_rules, AKITA_DEFAULT_EVENT_RULES, NULL, 0U);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    g_telemetry.obd.connected = true;
+    g_telemetry.obd.coolant_c = 90.0f;
+    AKITA_CHECK(akita_step(now_ms) == 0U);
+
+    /* Over-rev has to hold for a second; a short blip does not count. */
+    g_telemetry.obd.rpm = 6400.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+    g_telemetry.obd.rpm = 3000.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+    g_telemetry.obd.rpm = 6400.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+    AKITA_CHECK(akita_step(now_ms += 800U) == 0U);
+    AKITA_CHECK(akita_step(now_ms += 200U) == 1U);
+    AKITA_CHECK(g_matches[0].rule == 1U && !g_matches[0].cleared && g_matches[0].value == 6400.0f);
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+
+    /* The coolant alert fires at the limit, ignores hovering around it, and clears 5 C below. */
+    g_telemetry.obd.coolant_c = 110.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 1U);
+    AKITA_CHECK(g_matches[0].rule == 0U);
+    g_telemetry.obd.coolant_c = 108.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+    g_telemetry.obd.coolant_c = 111.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+    g_telemetry.obd.coolant_c = 104.5f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 1U);
+    AKITA_CHECK(g_matches[0].rule == 0U && g_matches[0].cleared);
+
+    /* Losing the adapter resets OBD rules silently. */
+    g_telemetry.obd.coolant_c = 115.0f;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 1U);
+    g_telemetry.obd.connected = false;
+    AKITA_CHECK(akita_step(now_ms += 200U) == 0U);
+    AKITA_CHECK(!g_rules.state[0].active);
+    return 0;
+}
+
+static int akita_check_rate(void) {
+    static const float kSpeeds[] = {80.0f, 80.0f, 78.0f, 70.0f, 55.0f, 40.0f, 40.0f, 40.0f};
+    uint64_t now_ms = 5000U;
+    size_t second;
+    size_t poll;
+    size_t fired = 0;
+
+    akita_rules_compile(&g_rules, AKITA_DEFAULT_EVENT_RULES, NULL, 0U);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    g_telemetry.gps.fix = true;
+
+    /* A 1 Hz GPS read by the 5 Hz poll: braking from 70 to 55 km/h in a second is 15 km/h/s. */
+    for (second = 0; second < sizeof(kSpeeds) / sizeof(kSpeeds[0]); ++second) {
+        g_telemetry.gps.speed_kmh = kSpeeds[second];
+        for (poll = 0; poll < 5U; ++poll) {
+            size_t count = akita_step(now_ms += 200U);
+
+            if (count > 0U) {
+                AKITA_CHECK(g_matches[0].rule == 2U);
+                AKITA_CHECK(g_matches[0].value <= -14.0f && g_matches[0].value > -16.0f);
+                AKITA_CHECK(second == 4U && poll == 0U);
+                ++fired;
+            }
+        }
+    }
+    AKITA_CHECK(fired == 1U);
+    AKITA_CHECK(g_rules.rate[AKITA_AGGREGATE_FIELD_GPS_SPEED] == 0.0f);
+    return 0;
+}
+
+static void akita_bench_evaluate(void) {
+    uint64_t start_ns;
+    uint64_t elapsed_ns;
+    uint64_t now_ms = 0;
+    uint32_t index;
+    size_t matches = 0;
+
+    akita_rules_compile(&g_rules, AKITA_DEFAULT_EVENT_RULES ";idle=obd.rpm<600@30000;climb=gps.alt_m+2;heap=system.free_heap<20000",
+                        NULL, 0U);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    g_telemetry.obd.connected = true;
+    g_telemetry.gps.fix = true;
+    g_telemetry.system.free_heap = 150000U;
+
+    start_ns = akita_bench_now_ns();
+    for (index = 0; index < AKITA_BENCH_ITERATIONS; ++index) {
+        g_telemetry.obd.rpm = (float) (800U + (index % 64U) * 90U);
+        g_telemetry.gps.speed_kmh = (float) (index % 97U);
+        matches += akita_step(now_ms += 200U);
+    }
+    elapsed_ns = akita_bench_now_ns() - start_ns;
+
+    printf("%u rules: %.1f ns per sample (%zu matches)\n", (unsigned) g_rules.count,
+           (double) elapsed_ns / (double) AKITA_BENCH_ITERATIONS, matches);
+}
+
+int main(void) {
+    if (akita_check_compile() != 0 ||
+        akita_check_threshold() != 0 ||
+        akita_check_rate() != 0) {
+        return 1;
+    }
+
+    akita_bench_evaluate();
+    printf("rule checks passed\n");
+    return 0;
+}
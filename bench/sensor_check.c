@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_elm327_sim.h"
+#include "akita_nmea.h"
+#include "akita_obd_protocol.h"
+#include "bench_support.h"
+
+#define AKITA_BENCH_BYTE_US 1042U
+#define AKITA_BENCH_LATENCY_MS 40U
+#define AKITA_BENCH_STEP_MS 10U
+
+/* Appends a sentence with its checksum and line ending. */
+static size_t akita_nmea_line(char *buffer, size_t buffer_size, const char *body) {
+    unsigned checksum = 0;
+    const char *cursor;
+
+    for (cursor = body; *cursor != '\0'; ++cursor) {
+        checksum ^= (unsigned char) *cursor;
+    }
+    return (size_t) snprintf(buffer, buffer_size, "$%s*%02X\r\n", body, checksum);
+}
+
+static int akita_check_nmea(void) {
+    akita_nmea_parser_t parser;
+    akita_gps_snapshot_t snapshot;
+    char stream[256];
+    size_t length;
+    size_t split;
+    size_t rmc_end;
+
+    akita_nmea_reset(&parser);
+    length = akita_nmea_line(stream, sizeof(stream), "GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230326,,");
+    length += akita_nmea_line(stream + length, sizeof(stream) - length, "GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    /* The start of the next sentence arrives in the same read as the end of this one. */
+    memcpy(stream + length, "$GPGSV,3", 8U);
+    length += 8U;
+
+    /* Split the read mid-sentence; each line is dated by the bytes that came after it. */
+    split = 20U;
+    akita_nmea_feed(&parser, (const uint8_t *) stream, split, 500000U, AKITA_BENCH_BYTE_US);
+    akita_nmea_feed(&parser, (const uint8_t *) stream + split, length - split, 1000000U, AKITA_BENCH_BYTE_US);
+    akita_nmea_snapshot(&parser, 1200000U, 0U, &snapshot);
+
+    AKITA_CHECK(snapshot.fix);
+    AKITA_CHECK(snapshot.latitude > 48.117f && snapshot.latitude < 48.118f);
+    AKITA_CHECK(snapshot.longitude > 11.516f && snapshot.longitude < 11.517f);
+    AKITA_CHECK(snapshot.satellites == 8U);
+    AKITA_CHECK(snapshot.speed_kmh > 41.4f && snapshot.speed_kmh < 41.5f);
+    AKITA_CHECK(snapshot.utc_ms == 1774269319000LL);
+    /* The RMC line ended before the whole GGA line and the 8 bytes of GSV arrived. */
+    rmc_end = (size_t) (strchr(stream, '\n') - stream);
+    AKITA_CHECK(snapshot.utc_received_us == 1000000U - (uint64_t) (length - 1U - rmc_end) * AKITA_BENCH_BYTE_US);
+    AKITA_CHECK(snapshot.fix_ms == (1000000U - 8U * AKITA_BENCH_BYTE_US) / 1000U);
+    AKITA_CHECK(snapshot.age_ms == 1200U - snapshot.fix_ms);
+
+    /* A corrupted checksum is dropped and the fix stands. */
+    length = akita_nmea_line(stream, sizeof(stream), "GPRMC,123520.00,V,,,,,,,230326,,");
+    stream[length - 4U] = stream[length - 4U] == '0' ? '1' : '0';
+    akita_nmea_feed(&parser, (const uint8_t *) stream, length, 2000000U, AKITA_BENCH_BYTE_US);
+    akita_nmea_snapshot(&parser, 2000000U, 0U, &snapshot);
+    AKITA_CHECK(snapshot.fix);
+
+    /* A date with a non-digit in it does not set the clock, even when the arithmetic lands on a valid day. */
+    length = akita_nmea_line(stream, sizeof(stream), "GPRMC,123521.00,A,4807.038,N,01131.000,E,022.4,084.4,1:0326,,");
+    akita_nmea_feed(&parser, (const uint8_t *) stream, length, 3000000U, AKITA_BENCH_BYTE_US);
+    akita_nmea_snapshot(&parser, 3000000U, 0U, &snapshot);
+    AKITA_CHECK(snapshot.utc_ms == 1774269319000LL);
+    return 0;
+}
+
+/* Runs a session against the simulated adapter until until_ms, answering after the simulated latency. */
+static void akita_drive_session(akita_obd_session_t *session, akita_obd_snapshot_t *snapshot, uint64_t from_ms,
+                                uint64_t until_ms, bool answer) {
+    char request[16];
+    char reply[64];
+    size_t reply_length = 0;
+    uint64_t reply_ms = 0;
+    uint64_t now_ms;
+
+    for (now_ms = from_ms; now_ms <= until_ms; now_ms += AKITA_BENCH_STEP_MS) {
+        if (session->pending && reply_length > 0U && now_ms >= reply_ms) {
+            (void) akita_obd_session_receive(session, snapshot, reply, reply_length, false, now_ms);
+            reply_length = 0;
+        }
+        (void) akita_obd_session_check_timeout(session, now_ms);
+        if (akita_obd_session_due(session, now_ms) &&
+            akita_obd_build_request(akita_obd_session_command(session), request, sizeof(request)) > 0U) {
+            reply_length = answer ? akita_elm327_sim_answer(request, now_ms, reply, sizeof(reply)) : 0U;
+            reply_ms = now_ms + AKITA_BENCH_LATENCY_MS;
+            akita_obd_session_sent(session, now_ms);
+        }
+    }
+}
+
+static int akita_check_obd_session(void) {
+    akita_obd_session_t session;
+    akita_obd_snapshot_t snapshot;
+
+    memset(&session, 0, sizeof(session));
+    memset(&snapshot, 0, sizeof(snapshot));
+    akita_obd_session_start(&session, 1U);
+    AKITA_CHECK(strcmp(akita_obd_session_command(&session), "ATZ") == 0);
+
+    /* 40 s into the drive the simulated car cruises at 100 km/h with a warming engine. */
+    akita_drive_session(&session, &snapshot, 1U, 40000U, true);
+    AKITA_CHECK(session.init_index == 6U);
+    AKITA_CHECK(session.retries == 0U);
+    AKITA_CHECK(snapshot.speed_kmh == 100.0f);
+    AKITA_CHECK(snapshot.rpm == 3300.0f);
+    AKITA_CHECK(snapshot.coolant_c == 29.0f);
+    AKITA_CHECK(snapshot.rpm_ms > 39000U && snapshot.speed_ms > 39000U && snapshot.coolant_ms > 39000U);
+    AKITA_CHECK(session.last_sample_ms > 39500U);
+
+    /* At the end of the drive the car idles. */
+    akita_drive_session(&session, &snapshot, 40010U, 89000U, true);
+    AKITA_CHECK(snapshot.speed_kmh == 0.0f);
+    AKITA_CHECK(snapshot.rpm == 800.0f);
+    return 0;
+}
+
+static int akita_check_obd_errors(void) {
+    akita_obd_session_t session;
+    akita_obd_snapshot_t snapshot;
+    const char *command;
+
+    memset(&session, 0, sizeof(session));
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    /* An adapter that never answers: each setup command is given up on after the timeout. */
+    akita_obd_session_start(&session, 1U);
+    akita_drive_session(&session, &snapshot, 1U, 6U * (AKITA_OBD_RESPONSE_TIMEOUT_MS + AKITA_OBD_INIT_DELAY_MS), false);
+    AKITA_CHECK(session.init_index == 6U);
+    command = akita_obd_session_command(&session);
+    AKITA_CHECK(strcmp(command, "010C") == 0);
+
+    /* A telemetry PID is retried before the session moves on. */
+    akita_drive_session(&session, &snapshot, 6U * (AKITA_OBD_RESPONSE_TIMEOUT_MS + AKITA_OBD_INIT_DELAY_MS) + 10U,
+                        6U * (AKITA_OBD_RESPONSE_TIMEOUT_MS + AKITA_OBD_INIT_DELAY_MS) + 3U * (AKITA_OBD_RESPONSE_TIMEOUT_MS + 250U),
+                        false);
+    AKITA_CHECK(strcmp(akita_obd_session_command(&session), "010C") == 0);
+    AKITA_CHECK(session.retries == AKITA_OBD_MAX_COMMAND_RETRIES);
+
+    /* An error answer ends the command without a reading, even split across notifications. */
+    akita_obd_session_start(&session, 100000U);
+    session.init_index = 6U;
+    akita_obd_session_sent(&session, 100000U);
+    AKITA_CHECK(!akita_obd_session_receive(&session, &snapshot, "NO ", 3U, false, 100010U));
+    AKITA_CHECK(session.pending);
+    AKITA_CHECK(!akita_obd_session_receive(&session, &snapshot, "DATA\r", 5U, false, 100020U));
+    AKITA_CHECK(!session.pending);
+    AKITA_CHECK(strcmp(akita_obd_session_command(&session), "010D") == 0);
+    AKITA_CHECK(session.next_command_ms == 100020U + AKITA_OBD_PID_DELAY_MS);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_nmea() != 0 ||
+        akita_check_obd_session() != 0 ||
+        akita_check_obd_errors() != 0) {
+        return 1;
+    }
+
+    printf("sensor checks passed\n");
+    return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef AKITA_BENCH_ESP_CHECK_H
+#define AKITA_BENCH_ESP_CHECK_H
+
+#include "esp_err.h"
+
+#define ESP_RETURN_ON_ERROR(x, log_tag, ...) \
+    do { \
+        esp_err_t akita_bench_err_rc_ = (x); \
+        (void) (log_tag); \
+        if (akita_bench_err_rc_ != ESP_OK) { \
+            return akita_bench_err_rc_; \
+        } \
+    } while (0)
+
+#define ESP_ERROR_CHECK_WITHOUT_ABORT(x) ((void) (x))
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef AKITA_BENCH_ESP_CPU_H
+#define AKITA_BENCH_ESP_CPU_H
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+int esp_cpu_get_core_id(void);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef AKITA_BENCH_ESP_LOG_H
+#define AKITA_BENCH_ESP_LOG_H
+
+/* Host runs are measured, not read; driver log lines are compiled out. */
+#define AKITA_BENCH_LOG_DISCARD(tag, ...) \
+    do { \
+        (void) (tag); \
+    } while (0)
+
+#define ESP_LOGE(tag, ...) AKITA_BENCH_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) AKITA_BENCH_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) AKITA_BENCH_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) AKITA_BENCH_LOG_DISCARD(tag, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef AKITA_BENCH_FREERTOS_H
+#define AKITA_BENCH_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFFU)
+
+#endif
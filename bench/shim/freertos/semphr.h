@@ -0,0 +1,25 @@
+#ifndef AKITA_BENCH_SEMPHR_H
+#define AKITA_BENCH_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+/* Host benches are single-threaded, so a mutex only has to exist. */
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    static int mutex;
+    return &mutex;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    (void) semaphore;
+    (void) ticks;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    (void) semaphore;
+    return pdTRUE;
+}
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef AKITA_BENCH_SDKCONFIG_H
+#define AKITA_BENCH_SDKCONFIG_H
+
+#define CONFIG_AKITA_BOARD_HELTEC_LORA32_V2 1
+#define CONFIG_AKITA_ENABLE_CONFIG_PORTAL 1
+
+#endif
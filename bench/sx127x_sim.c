@@ -0,0 +1,303 @@
+#include "sx127x_sim.h"
+
+#include <string.h>
+
+#include "akita_airtime.h"
+#include "akita_sx127x.h"
+
+#define AKITA_SIM_DEFAULT_RSSI_DBM (-100)
+#define AKITA_SIM_DEFAULT_SNR_QDB 20
+
+/* RegModemConfig1 bandwidth codes from the SX1276 datasheet. */
+static const uint32_t kSimBandwidthHz[] = {
+    7800U, 10400U, 15600U, 20800U, 31250U, 41700U, 62500U, 125000U, 250000U, 500000U,
+};
+
+static void akita_sim_modem_from_registers(const akita_sim_radio_t *radio, akita_lora_modem_t *modem) {
+    uint8_t config_1 = radio->registers[AKITA_SX127X_REG_MODEM_CONFIG_1];
+    uint8_t config_2 = radio->registers[AKITA_SX127X_REG_MODEM_CONFIG_2];
+    uint8_t bandwidth_code = (uint8_t) (config_1 >> 4);
+
+    memset(modem, 0, sizeof(*modem));
+    modem->spreading_factor = (uint8_t) (config_2 >> 4);
+    modem->coding_rate = (uint8_t) (((config_1 >> 1) & 0x07U) + 4U);
+    modem->implicit_header = (config_1 & 0x01U) != 0U;
+    modem->crc_on = (config_2 & 0x04U) != 0U;
+    modem->preamble_len = (uint16_t) ((radio->registers[AKITA_SX127X_REG_PREAMBLE_MSB] << 8) |
+                                      radio->registers[AKITA_SX127X_REG_PREAMBLE_LSB]);
+    modem->bandwidth_hz = bandwidth_code < sizeof(kSimBandwidthHz) / sizeof(kSimBandwidthHz[0]) ? kSimBandwidthHz[bandwidth_code] : 0U;
+}
+
+static uint32_t akita_sim_frf(const akita_sim_radio_t *radio) {
+    return ((uint32_t) radio->registers[AKITA_SX127X_REG_FRF_MSB] << 16) |
+           ((uint32_t) radio->registers[AKITA_SX127X_REG_FRF_MID] << 8) |
+           radio->registers[AKITA_SX127X_REG_FRF_LSB];
+}
+
+static uint8_t akita_sim_mode(const akita_sim_radio_t *radio) {
+    return (uint8_t) (radio->registers[AKITA_SX127X_REG_OP_MODE] & AKITA_SX127X_MODE_MASK);
+}
+
+uint32_t akita_sim_random(akita_sim_channel_t *channel) {
+    uint32_t value = channel->rng_state;
+
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+    channel->rng_state = value;
+    return value;
+}
+
+void akita_sim_channel_init(akita_sim_channel_t *channel, uint32_t seed, uint16_t loss_permille) {
+    size_t from;
+    size_t to;
+
+    memset(channel, 0, sizeof(*channel));
+    channel->rng_state = seed != 0U ? seed : 1U;
+    channel->loss_permille = loss_permille;
+    for (from = 0; from < AKITA_SIM_MAX_RADIOS; ++from) {
+        for (to = 0; to < AKITA_SIM_MAX_RADIOS; ++to) {
+            channel->links[from][to].rssi_dbm = AKITA_SIM_DEFAULT_RSSI_DBM;
+            channel->links[from][to].snr_quarter_db = AKITA_SIM_DEFAULT_SNR_QDB;
+        }
+    }
+}
+
+void akita_sim_radio_attach(akita_sim_channel_t *channel, akita_sim_radio_t *radio) {
+    memset(radio, 0, sizeof(*radio));
+    radio->channel = channel;
+    radio->index = (uint8_t) channel->radio_count;
+    radio->registers[AKITA_SX127X_REG_OP_MODE] = AKITA_SX127X_MODE_STDBY;
+    radio->registers[AKITA_SX127X_REG_VERSION] = AKITA_SX127X_EXPECTED_VERSION;
+    radio->registers[AKITA_SX127X_REG_MODEM_CONFIG_1] = 0x72;
+    radio->registers[AKITA_SX127X_REG_MODEM_CONFIG_2] = 0x70;
+    radio->registers[AKITA_SX127X_REG_PREAMBLE_LSB] = 0x08;
+    channel->radios[channel->radio_count++] = radio;
+}
+
+void akita_sim_set_link(akita_sim_channel_t *channel, uint8_t from, uint8_t to, int16_t rssi_dbm, int8_t snr_quarter_db) {
+    channel->links[from][to].rssi_dbm = rssi_dbm;
+    channel->links[from][to].snr_quarter_db = snr_quarter_db;
+}
+
+static void akita_sim_start_tx(akita_sim_radio_t *radio) {
+    akita_sim_channel_t *channel = radio->channel;
+    akita_sim_transmission_t *transmission = &channel->history[channel->history_next];
+    akita_lora_modem_t modem;
+    uint8_t base = radio->registers[AKITA_SX127X_REG_FIFO_TX_BASE_ADDR];
+    uint8_t length = radio->registers[AKITA_SX127X_REG_PAYLOAD_LENGTH];
+    size_t index;
+
+    akita_sim_modem_from_registers(radio, &modem);
+    channel->history_next = (channel->history_next + 1U) % AKITA_SIM_HISTORY;
+
+    memset(transmission, 0, sizeof(*transmission));
+    transmission->pending = true;
+    transmission->sender = radio->index;
+    transmission->start_us = channel->now_us;
+    transmission->end_us = channel->now_us + (int64_t) akita_airtime_us(&modem, length);
+    transmission->frf = akita_sim_frf(radio);
+    transmission->spreading_factor = modem.spreading_factor;
+    transmission->bandwidth_hz = modem.bandwidth_hz;
+    transmission->length = length;
+    for (index = 0; index < length; ++index) {
+        transmission->data[index] = radio->fifo[(uint8_t) (base + index)];
+    }
+
+    radio->tx_end_us = transmission->end_us;
+    ++channel->transmissions;
+    channel->airtime_us += (uint64_t) (transmission->end_us - transmission->start_us);
+}
+
+static void akita_sim_write_register(akita_sim_radio_t *radio, uint8_t address, uint8_t value) {
+    switch (address) {
+        case AKITA_SX127X_REG_IRQ_FLAGS:
+            /* Flags clear by writing ones. */
+            radio->registers[address] = (uint8_t) (radio->registers[address] & (uint8_t) ~value);
+            break;
+        case AKITA_SX127X_REG_VERSION:
+            break;
+        case AKITA_SX127X_REG_OP_MODE:
+            radio->registers[address] = value;
+            if ((value & AKITA_SX127X_MODE_MASK) == AKITA_SX127X_MODE_TX) {
+                akita_sim_start_tx(radio);
+            }
+            break;
+        default:
+            radio->registers[address] = value;
+            break;
+    }
+}
+
+esp_err_t akita_sim_transfer(void *context, const uint8_t *tx_data, uint8_t *rx_data, size_t byte_count) {
+    akita_sim_radio_t *radio = context;
+    uint8_t address;
+    bool write;
+    size_t index;
+
+    if (radio == NULL || tx_data == NULL || byte_count < 2U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    address = (uint8_t) (tx_data[0] & 0x7FU);
+    write = (tx_data[0] & 0x80U) != 0U;
+    if (rx_data != NULL) {
+        rx_data[0] = 0;
+    }
+
+    for (index = 1; index < byte_count; ++index) {
+        if (address == AKITA_SX127X_REG_FIFO) {
+            uint8_t pointer = radio->registers[AKITA_SX127X_REG_FIFO_ADDR_PTR];
+
+            if (write) {
+                radio->fifo[pointer] = tx_data[index];
+            } else if (rx_data != NULL) {
+                rx_data[index] = radio->fifo[pointer];
+            }
+            radio->registers[AKITA_SX127X_REG_FIFO_ADDR_PTR] = (uint8_t) (pointer + 1U);
+            continue;
+        }
+
+        /* Register bursts auto-increment the address. */
+        if (write) {
+            akita_sim_write_register(radio, (uint8_t) ((address + index - 1U) & 0x7FU), tx_data[index]);
+        } else if (rx_data != NULL) {
+            rx_data[index] = radio->registers[(address + index - 1U) & 0x7FU];
+        }
+    }
+
+    return ESP_OK;
+}
+
+static bool akita_sim_overlaps(const akita_sim_transmission_t *a, const akita_sim_transmission_t *b) {
+    return a->start_us < b->end_us && b->start_us < a->end_us;
+}
+
+static void akita_sim_receive(akita_sim_channel_t *channel, akita_sim_radio_t *radio, const akita_sim_transmission_t *transmission) {
+    const akita_link_quality_t *link = &channel->links[transmission->sender][radio->index];
+    akita_lora_modem_t modem;
+    bool collided = false;
+    uint8_t base;
+    size_t index;
+    int16_t rssi_register;
+
+    if (akita_sim_mode(radio) != AKITA_SX127X_MODE_RX_CONTINUOUS || akita_sim_frf(radio) != transmission->frf) {
+        return;
+    }
+
+    akita_sim_modem_from_registers(radio, &modem);
+    if (!radio->any_data_rate &&
+        (modem.spreading_factor != transmission->spreading_factor || modem.bandwidth_hz != transmission->bandwidth_hz)) {
+        return;
+    }
+
+    for (index = 0; index < AKITA_SIM_HISTORY; ++index) {
+        const akita_sim_transmission_t *other = &channel->history[index];
+
+        if (other == transmission || other->end_us == 0 || other->frf != transmission->frf ||
+            !akita_sim_overlaps(other, transmission)) {
+            continue;
+        }
+        /* Half duplex: a radio that keyed up during the packet never heard it. */
+        if (other->sender == radio->index) {
+            return;
+        }
+        if ((link->rssi_dbm - channel->links[other->sender][radio->index].rssi_dbm) * 4 < AKITA_SIM_CAPTURE_QDB) {
+            collided = true;
+        }
+    }
+
+    if (collided) {
+        radio->registers[AKITA_SX127X_REG_IRQ_FLAGS] |= AKITA_SX127X_IRQ_RX_DONE | AKITA_SX127X_IRQ_PAYLOAD_CRC_ERROR;
+        ++radio->rx_collisions;
+        ++channel->collisions;
+        return;
+    }
+
+    if (akita_sim_random(channel) % 1000U < channel->loss_permille) {
+        ++radio->rx_lost;
+        ++channel->losses;
+        return;
+    }
+
+    base = radio->registers[AKITA_SX127X_REG_FIFO_RX_BASE_ADDR];
+    for (index = 0; index < transmission->length; ++index) {
+        radio->fifo[(uint8_t) (base + index)] = transmission->data[index];
+    }
+
+    /* Stored so the driver's RSSI correction for negative SNR lands back on the link RSSI. */
+    rssi_register = (int16_t) (link->rssi_dbm -
+                               (link->snr_quarter_db < 0 ? link->snr_quarter_db / 4 : 0) -
+                               (transmission->frf >= (uint32_t) (AKITA_SX127X_LF_LIMIT_HZ / AKITA_SX127X_FREQUENCY_STEP_HZ) ?
+                                    AKITA_SX127X_RSSI_OFFSET_HF : AKITA_SX127X_RSSI_OFFSET_LF));
+    radio->registers[AKITA_SX127X_REG_FIFO_RX_CURRENT_ADDR] = base;
+    radio->registers[AKITA_SX127X_REG_RX_NB_BYTES] = transmission->length;
+    radio->registers[AKITA_SX127X_REG_PKT_SNR_VALUE] = (uint8_t) link->snr_quarter_db;
+    radio->registers[AKITA_SX127X_REG_PKT_RSSI_VALUE] = (uint8_t) (rssi_register < 0 ? 0 : rssi_register > 255 ? 255 : rssi_register);
+    radio->registers[AKITA_SX127X_REG_IRQ_FLAGS] |= AKITA_SX127X_IRQ_RX_DONE;
+    ++radio->rx_frames;
+    ++channel->deliveries;
+}
+
+static void akita_sim_complete(akita_sim_channel_t *channel, akita_sim_transmission_t *transmission) {
+    akita_sim_radio_t *sender = channel->radios[transmission->sender];
+    size_t index;
+
+    transmission->pending = false;
+    sender->registers[AKITA_SX127X_REG_IRQ_FLAGS] |= AKITA_SX127X_IRQ_TX_DONE;
+    sender->registers[AKITA_SX127X_REG_OP_MODE] =
+        (uint8_t) ((sender->registers[AKITA_SX127X_REG_OP_MODE] & (uint8_t) ~AKITA_SX127X_MODE_MASK) | AKITA_SX127X_MODE_STDBY);
+    ++sender->tx_frames;
+
+    for (index = 0; index < channel->radio_count; ++index) {
+        if (index != transmission->sender) {
+            akita_sim_receive(channel, channel->radios[index], transmission);
+        }
+    }
+}
+
+int64_t akita_sim_channel_next_event_us(const akita_sim_channel_t *channel) {
+    int64_t next = INT64_MAX;
+    size_t index;
+
+    for (index = 0; index < AKITA_SIM_HISTORY; ++index) {
+        if (channel->history[index].pending && channel->history[index].end_us < next) {
+            next = channel->history[index].end_us;
+        }
+    }
+    return next;
+}
+
+void akita_sim_channel_advance(akita_sim_channel_t *channel, int64_t now_us) {
+    while (true) {
+        akita_sim_transmission_t *earliest = NULL;
+        size_t index;
+
+        for (index = 0; index < AKITA_SIM_HISTORY; ++index) {
+            akita_sim_transmission_t *transmission = &channel->history[index];
+
+            if (transmission->pending && transmission->end_us <= now_us &&
+                (earliest == NULL || transmission->end_us < earliest->end_us)) {
+                earliest = transmission;
+            }
+        }
+        if (earliest == NULL) {
+            break;
+        }
+
+        channel->now_us = earliest->end_us;
+        akita_sim_complete(channel, earliest);
+    }
+
+    channel->now_us = now_us;
+}
+
+bool akita_sim_radio_dio0(const akita_sim_radio_t *radio) {
+    uint8_t mapping = (uint8_t) (radio->registers[AKITA_SX127X_REG_DIO_MAPPING_1] & 0xC0U);
+    uint8_t flags = radio->registers[AKITA_SX127X_REG_IRQ_FLAGS];
+
+    if (mapping == AKITA_SX127X_DIO0_TX_DONE) {
+        return (flags & AKITA_SX127X_IRQ_TX_DONE) != 0U;
+    }
+    return (flags & AKITA_SX127X_IRQ_RX_DONE) != 0U;
+}
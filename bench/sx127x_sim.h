@@ -0,0 +1,69 @@
+#ifndef AKITA_SX127X_SIM_H
+#define AKITA_SX127X_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+#include "esp_err.h"
+
+#define AKITA_SIM_MAX_RADIOS 16U
+#define AKITA_SIM_HISTORY 64U
+/* A receiver locks onto the stronger of two overlapping packets if it is this much louder. */
+#define AKITA_SIM_CAPTURE_QDB 24
+
+typedef struct akita_sim_channel akita_sim_channel_t;
+
+typedef struct {
+    akita_sim_channel_t *channel;
+    uint8_t index;
+    uint8_t registers[0x80];
+    uint8_t fifo[256];
+    /* Demodulates every spreading factor and bandwidth, like a multi-SF gateway. */
+    bool any_data_rate;
+    int64_t tx_end_us;
+    uint32_t tx_frames;
+    uint32_t rx_frames;
+    uint32_t rx_collisions;
+    uint32_t rx_lost;
+} akita_sim_radio_t;
+
+typedef struct {
+    bool pending;
+    uint8_t sender;
+    int64_t start_us;
+    int64_t end_us;
+    uint32_t frf;
+    uint8_t spreading_factor;
+    uint32_t bandwidth_hz;
+    uint8_t length;
+    uint8_t data[255];
+} akita_sim_transmission_t;
+
+struct akita_sim_channel {
+    int64_t now_us;
+    uint32_t rng_state;
+    uint16_t loss_permille;
+    akita_link_quality_t links[AKITA_SIM_MAX_RADIOS][AKITA_SIM_MAX_RADIOS];
+    akita_sim_radio_t *radios[AKITA_SIM_MAX_RADIOS];
+    size_t radio_count;
+    akita_sim_transmission_t history[AKITA_SIM_HISTORY];
+    size_t history_next;
+    uint32_t transmissions;
+    uint32_t deliveries;
+    uint32_t collisions;
+    uint32_t losses;
+    uint64_t airtime_us;
+};
+
+void akita_sim_channel_init(akita_sim_channel_t *channel, uint32_t seed, uint16_t loss_permille);
+void akita_sim_radio_attach(akita_sim_channel_t *channel, akita_sim_radio_t *radio);
+void akita_sim_set_link(akita_sim_channel_t *channel, uint8_t from, uint8_t to, int16_t rssi_dbm, int8_t snr_quarter_db);
+esp_err_t akita_sim_transfer(void *context, const uint8_t *tx_data, uint8_t *rx_data, size_t byte_count);
+void akita_sim_channel_advance(akita_sim_channel_t *channel, int64_t now_us);
+int64_t akita_sim_channel_next_event_us(const akita_sim_channel_t *channel);
+bool akita_sim_radio_dio0(const akita_sim_radio_t *radio);
+uint32_t akita_sim_random(akita_sim_channel_t *channel);
+
+#endif
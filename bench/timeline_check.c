@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_metrics.h"
+#include "akita_timeline.h"
+#include "bench_support.h"
+
+#define AKITA_BENCH_EVENTS 1000000U
+#define AKITA_BENCH_DUMP_BYTES 32768U
+
+typedef struct {
+    uint8_t bytes[AKITA_BENCH_DUMP_BYTES];
+    size_t used;
+} akita_dump_buffer_t;
+
+typedef struct {
+    uint16_t cores;
+    uint32_t cycles_per_us;
+    uint32_t events_per_core;
+    uint16_t names;
+    char first_name[32];
+    char first_metric[32];
+    uint32_t count;
+    akita_timeline_event_t events[AKITA_TIMELINE_EVENTS];
+} akita_dump_t;
+
+static akita_dump_buffer_t g_dump_buffer;
+static akita_dump_t g_dump;
+
+static bool akita_dump_write(const void *data, size_t size, void *context) {
+    akita_dump_buffer_t *buffer = context;
+
+    if (buffer->used + size > sizeof(buffer->bytes)) {
+        return false;
+    }
+    memcpy(buffer->bytes + buffer->used, data, size);
+    buffer->used += size;
+    return true;
+}
+
+static uint16_t akita_get_u16(const uint8_t *in) {
+    return (uint16_t) (in[0] | (in[1] << 8));
+}
+
+static uint32_t akita_get_u32(const uint8_t *in) {
+    return (uint32_t) akita_get_u16(in) | ((uint32_t) akita_get_u16(in + 2) << 16);
+}
+
+/* Reads a dump back the way the host converter does. */
+static int akita_dump(akita_dump_t *dump) {
+    const uint8_t *in = g_dump_buffer.bytes;
+    uint16_t tasks;
+    uint16_t name;
+
+    g_dump_buffer.used = 0;
+    memset(dump, 0, sizeof(*dump));
+    AKITA_CHECK(akita_timeline_dump(akita_dump_write, &g_dump_buffer));
+    AKITA_CHECK(g_dump_buffer.used >= 20U);
+    AKITA_CHECK(memcmp(in, AKITA_TIMELINE_MAGIC, 4U) == 0);
+    AKITA_CHECK(akita_get_u16(in + 4) == AKITA_TIMELINE_VERSION);
+    dump->cores = akita_get_u16(in + 6);
+    dump->cycles_per_us = akita_get_u32(in + 8);
+    dump->events_per_core = akita_get_u32(in + 12);
+    dump->names = akita_get_u16(in + 16);
+    tasks = akita_get_u16(in + 18);
+    in += 20;
+
+    for (name = 0; name < dump->names; ++name) {
+        if (name == 0U) {
+            memcpy(dump->first_name, in + 1, in[0]);
+        } else if (name == AKITA_TIMELINE_NAME_COUNT) {
+            memcpy(dump->first_metric, in + 1, in[0]);
+        }
+        in += 1U + in[0];
+    }
+    for (name = 0; name < tasks; ++name) {
+        in += 5U + in[4];
+    }
+
+    AKITA_CHECK(dump->cores == 1U);
+    AKITA_CHECK(akita_get_u16(in) == 0U);
+    dump->count = akita_get_u32(in + 4);
+    in += 8;
+    AKITA_CHECK(dump->count <= AKITA_TIMELINE_EVENTS);
+    memcpy(dump->events, in, dump->count * sizeof(akita_timeline_event_t));
+    in += dump->count * sizeof(akita_timeline_event_t);
+    AKITA_CHECK((size_t) (in - g_dump_buffer.bytes) == g_dump_buffer.used);
+    return 0;
+}
+
+static int akita_check_record(void) {
+    uint32_t index;
+
+    akita_timeline_rearm();
+    akita_timeline_record(AKITA_TIMELINE_BEGIN, AKITA_TIMELINE_MAIN_POLL, 0);
+    akita_timeline_record(AKITA_TIMELINE_COUNTER, AKITA_TIMELINE_OUTBOX_DEPTH, 3);
+    akita_timeline_record(AKITA_TIMELINE_INSTANT, AKITA_TIMELINE_WIFI_EVENT, -8);
+    {
+        AKITA_METRIC_BEGIN(span);
+        AKITA_METRIC_END(span, AKITA_METRIC_PAYLOAD_ENCODE, true);
+    }
+    akita_timeline_record(AKITA_TIMELINE_END, AKITA_TIMELINE_MAIN_POLL, 0);
+
+    if (akita_dump(&g_dump) != 0) {
+        return 1;
+    }
+    AKITA_CHECK(g_dump.cycles_per_us == 1000U);
+    AKITA_CHECK(g_dump.events_per_core == AKITA_TIMELINE_EVENTS);
+    AKITA_CHECK(g_dump.names == AKITA_TIMELINE_NAME_COUNT + AKITA_METRIC_COUNT);
+    AKITA_CHECK(strcmp(g_dump.first_name, "main_poll") == 0);
+    AKITA_CHECK(strcmp(g_dump.first_metric, "gps_ingest") == 0);
+    AKITA_CHECK(g_dump.count == 6U);
+    AKITA_CHECK(g_dump.events[0].type == AKITA_TIMELINE_SYNC);
+    AKITA_CHECK(g_dump.events[1].type == AKITA_TIMELINE_BEGIN && g_dump.events[1].name == AKITA_TIMELINE_MAIN_POLL);
+    AKITA_CHECK(g_dump.events[2].type == AKITA_TIMELINE_COUNTER && g_dump.events[2].value == 3);
+    AKITA_CHECK(g_dump.events[3].type == AKITA_TIMELINE_INSTANT && g_dump.events[3].value == -8);
+    AKITA_CHECK(g_dump.events[4].type == AKITA_TIMELINE_COMPLETE);
+    AKITA_CHECK(g_dump.events[4].name == AKITA_TIMELINE_METRIC(AKITA_METRIC_PAYLOAD_ENCODE));
+    AKITA_CHECK(g_dump.events[4].value >= 0);
+    AKITA_CHECK(g_dump.events[5].type == AKITA_TIMELINE_END);
+    for (index = 2; index < g_dump.count; ++index) {
+        AKITA_CHECK((int32_t) (g_dump.events[index].cycles - g_dump.events[index - 1U].cycles) >= 0);
+    }
+    return 0;
+}
+
+static int akita_check_wrap(void) {
+    uint32_t syncs = 0;
+    uint32_t first_sync = AKITA_TIMELINE_EVENTS;
+    uint32_t index;
+
+    akita_timeline_rearm();
+    for (index = 0; index < 3U * AKITA_TIMELINE_EVENTS + 5U; ++index) {
+        akita_timeline_record(AKITA_TIMELINE_COUNTER, AKITA_TIMELINE_OUTBOX_DEPTH, (int32_t) index);
+    }
+
+    if (akita_dump(&g_dump) != 0) {
+        return 1;
+    }
+    AKITA_CHECK(g_dump.count == AKITA_TIMELINE_EVENTS);
+    for (index = 0; index < g_dump.count; ++index) {
+        if (g_dump.events[index].type == AKITA_TIMELINE_SYNC) {
+            ++syncs;
+            if (first_sync == AKITA_TIMELINE_EVENTS) {
+                first_sync = index;
+            }
+        }
+    }
+    /* Whatever the ring kept starts within one sync interval of a sync point. */
+    AKITA_CHECK(first_sync < AKITA_TIMELINE_SYNC_SLOTS);
+    AKITA_CHECK(syncs == AKITA_TIMELINE_EVENTS / AKITA_TIMELINE_SYNC_SLOTS);
+    AKITA_CHECK(g_dump.events[g_dump.count - 1U].value == (int32_t) (3U * AKITA_TIMELINE_EVENTS + 4U));
+    return 0;
+}
+
+static int akita_check_trigger(void) {
+    uint32_t after = 0;
+    uint32_t trigger = AKITA_TIMELINE_EVENTS;
+    uint32_t index;
+
+    akita_timeline_rearm();
+    for (index = 0; index < 40U; ++index) {
+        akita_timeline_record(AKITA_TIMELINE_INSTANT, AKITA_TIMELINE_WIFI_EVENT, (int32_t) index);
+    }
+    AKITA_CHECK(akita_timeline_state() == AKITA_TIMELINE_RUNNING);
+    akita_timeline_trigger(AKITA_TIMELINE_MAIN_STALL, 250);
+    AKITA_CHECK(akita_timeline_state() == AKITA_TIMELINE_TRIGGERED);
+    for (index = 0; index < AKITA_TIMELINE_EVENTS; ++index) {
+        akita_timeline_record(AKITA_TIMELINE_COUNTER, AKITA_TIMELINE_OUTBOX_DEPTH, (int32_t) index);
+    }
+    AKITA_CHECK(akita_timeline_state() == AKITA_TIMELINE_FROZEN);
+
+    if (akita_dump(&g_dump) != 0) {
+        return 1;
+    }
+    for (index = 0; index < g_dump.count; ++index) {
+        if ((g_dump.events[index].flags & AKITA_TIMELINE_FLAG_TRIGGER) != 0U) {
+            trigger = index;
+        } else if (trigger != AKITA_TIMELINE_EVENTS && g_dump.events[index].type != AKITA_TIMELINE_SYNC) {
+            ++after;
+        }
+    }
+    /* The lead-up is kept, and the trigger plus what follows it fills a quarter of the ring. */
+    AKITA_CHECK(trigger < g_dump.count);
+    AKITA_CHECK(g_dump.events[trigger].name == AKITA_TIMELINE_MAIN_STALL && g_dump.events[trigger].value == 250);
+    AKITA_CHECK(g_dump.events[1].name == AKITA_TIMELINE_WIFI_EVENT && g_dump.events[1].value == 0);
+    AKITA_CHECK(after + 1U == AKITA_TIMELINE_EVENTS / 4U);
+
+    /* A second trigger while frozen does not restart anything. */
+    akita_timeline_trigger(AKITA_TIMELINE_MANUAL_TRIGGER, 0);
+    AKITA_CHECK(akita_timeline_state() == AKITA_TIMELINE_FROZEN);
+
+    akita_timeline_rearm();
+    AKITA_CHECK(akita_timeline_state() == AKITA_TIMELINE_RUNNING);
+    if (akita_dump(&g_dump) != 0) {
+        return 1;
+    }
+    AKITA_CHECK(g_dump.count == 0U);
+    return 0;
+}
+
+static int akita_check_cost(void) {
+    uint64_t started_ns;
+    double per_event_ns;
+    uint32_t index;
+
+    akita_timeline_rearm();
+    started_ns = akita_bench_now_ns();
+    for (index = 0; index < AKITA_BENCH_EVENTS; ++index) {
+        akita_timeline_record(AKITA_TIMELINE_COUNTER, AKITA_TIMELINE_OUTBOX_DEPTH, (int32_t) index);
+    }
+    per_event_ns = (double) (akita_bench_now_ns() - started_ns) / AKITA_BENCH_EVENTS;
+
+    printf("events   %.1f ns per event on the host\n", per_event_ns);
+    AKITA_CHECK(per_event_ns < 1000.0);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_record() != 0 ||
+        akita_check_wrap() != 0 ||
+        akita_check_trigger() != 0 ||
+        akita_check_cost() != 0) {
+        return 1;
+    }
+
+    printf("timeline checks passed\n");
+    return 0;
+}
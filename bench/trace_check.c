@@ -0,0 +1,131 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_app.h"
+#include "akita_board.h"
+#include "akita_trace.h"
+#include "bench_support.h"
+
+static int akita_check_histogram(void) {
+    akita_trace_histogram_t histogram;
+    uint32_t value;
+
+    memset(&histogram, 0, sizeof(histogram));
+    akita_trace_histogram_add(&histogram, 0U);
+    akita_trace_histogram_add(&histogram, 15U);
+    akita_trace_histogram_add(&histogram, 16U);
+    akita_trace_histogram_add(&histogram, 1000U);
+    akita_trace_histogram_add(&histogram, 1ULL << 40);
+    AKITA_CHECK(histogram.buckets[0] == 2U);
+    AKITA_CHECK(histogram.buckets[1] == 1U);
+    AKITA_CHECK(histogram.buckets[6] == 1U);
+    AKITA_CHECK(histogram.buckets[AKITA_TRACE_BUCKETS - 1U] == 1U);
+    AKITA_CHECK(histogram.max_us == UINT32_MAX);
+
+    /* 1 ms to 100 ms in even steps: each percentile lands in its bucket and never over the true value by 2x. */
+    memset(&histogram, 0, sizeof(histogram));
+    for (value = 1000U; value <= 100000U; value += 1000U) {
+        akita_trace_histogram_add(&histogram, value);
+    }
+    printf("percentiles p50 %lu us, p90 %lu us, p99 %lu us, max %lu us\n",
+           (unsigned long) akita_trace_histogram_percentile(&histogram, 50U),
+           (unsigned long) akita_trace_histogram_percentile(&histogram, 90U),
+           (unsigned long) akita_trace_histogram_percentile(&histogram, 99U),
+           (unsigned long) histogram.max_us);
+    AKITA_CHECK(akita_trace_histogram_percentile(&histogram, 50U) >= 50000U);
+    AKITA_CHECK(akita_trace_histogram_percentile(&histogram, 50U) < 100000U);
+    AKITA_CHECK(akita_trace_histogram_percentile(&histogram, 90U) >= 90000U);
+    AKITA_CHECK(akita_trace_histogram_percentile(&histogram, 99U) == 100000U);
+    AKITA_CHECK(histogram.total_us / histogram.count == 50500U);
+    return 0;
+}
+
+static int akita_check_record(void) {
+    akita_trace_stats_t stats;
+    akita_trace_t trace;
+    char json[2048];
+    size_t length;
+
+    memset(&stats, 0, sizeof(stats));
+    akita_trace_begin(&trace, 7U, 1000000U, 1040000U);
+    akita_trace_mark(&trace, AKITA_TRACE_ENCODE, 1240000U);
+    akita_trace_mark(&trace, AKITA_TRACE_TRANSMIT, 1241000U);
+    akita_trace_mark(&trace, AKITA_TRACE_ACKED, 1300000U);
+    akita_trace_record(&stats, &trace);
+
+    /* A failed send never reaches the ack, so only the stages it finished are counted. */
+    akita_trace_begin(&trace, 8U, 0U, 2000000U);
+    AKITA_CHECK(trace.at_us[AKITA_TRACE_ACQUIRED] == 2000000U);
+    akita_trace_mark(&trace, AKITA_TRACE_ENCODE, 2000100U);
+    akita_trace_record(&stats, &trace);
+
+    AKITA_CHECK(stats.traces == 2U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_SAMPLE].count == 2U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_SAMPLE].max_us == 40000U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_QUEUE].max_us == 200000U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_ENCODE].count == 1U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_TRANSMIT].max_us == 59000U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_TOTAL].count == 1U);
+    AKITA_CHECK(stats.stages[AKITA_TRACE_STAGE_TOTAL].max_us == 300000U);
+
+    length = akita_trace_write_json(&stats, json, sizeof(json));
+    printf("status   %zu bytes: %s\n", length, json);
+    AKITA_CHECK(length > 0U);
+    AKITA_CHECK(strstr(json, "{\"traces\":2,\"sample\":{\"n\":2,\"mean_us\":20000,") == json);
+    AKITA_CHECK(strstr(json, ",\"total\":{\"n\":1,\"mean_us\":300000,\"p50_us\":300000,\"p90_us\":300000,"
+                             "\"p99_us\":300000,\"max_us\":300000,\"buckets\":[0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1]}}") != NULL);
+    AKITA_CHECK(akita_trace_write_json(&stats, json, 64U) == 0U);
+    AKITA_CHECK(strlen(json) < 64U);
+
+    /* Every stage full and spread over all buckets still fits the status buffer. */
+    for (size_t stage = 0; stage < AKITA_TRACE_STAGE_COUNT; ++stage) {
+        for (size_t bucket = 0; bucket < AKITA_TRACE_BUCKETS; ++bucket) {
+            stats.stages[stage].buckets[bucket] = UINT32_MAX;
+        }
+        stats.stages[stage].count = UINT32_MAX;
+        stats.stages[stage].max_us = UINT32_MAX;
+    }
+    stats.traces = UINT32_MAX;
+    length = akita_trace_write_json(&stats, json, sizeof(json));
+    printf("status   %zu of %zu bytes when full\n", length, sizeof(json));
+    AKITA_CHECK(length > 0U);
+    return 0;
+}
+
+static int akita_check_payload(void) {
+    akita_runtime_config_t config;
+    akita_outbox_message_t message;
+    char payload[1792];
+
+    akita_board_apply_defaults(&config);
+    memset(&message, 0, sizeof(message));
+    message.message_class = AKITA_MESSAGE_ROUTINE;
+    message.event_value = NAN;
+    message.created_ms = 60000U;
+
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, "\"trace\"") == NULL);
+
+    akita_trace_begin(&message.trace, 3U, 59950000U, 60000000U);
+    akita_trace_mark(&message.trace, AKITA_TRACE_ENCODE, 60180000U);
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, ",\"trace\":{\"id\":3,\"acquired_ms\":59950,\"queued_ms\":60000,\"encoded_ms\":60180}") != NULL);
+
+    message.utc_offset_us = 1760000000000000LL - 60000000LL;
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, ",\"trace\":{\"id\":3,\"acquired_ms\":1759999999950,\"queued_ms\":1760000000000,"
+                                "\"encoded_ms\":1760000000180}") != NULL);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_histogram() != 0 ||
+        akita_check_record() != 0 ||
+        akita_check_payload() != 0) {
+        return 1;
+    }
+
+    printf("trace checks passed\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_app.h"
+#include "akita_board.h"
+#include "akita_track.h"
+#include "bench_support.h"
+
+#define AKITA_TRACK_FIXES_MAX 20000U
+#define AKITA_TRACK_KEPT_MAX 4096U
+#define AKITA_TRACK_TOLERANCE_M 10U
+/* Microdegree rounding and the Q16 scale, on top of the configured tolerance. */
+#define AKITA_TRACK_SLACK_M 0.5
+#define AKITA_EARTH_M_PER_DEG 111320.0
+#define AKITA_PI 3.14159265358979323846
+
+typedef struct {
+    float latitude;
+    float longitude;
+    uint64_t timestamp_ms;
+} akita_fix_t;
+
+static akita_fix_t g_fixes[AKITA_TRACK_FIXES_MAX];
+static akita_track_point_t g_kept[AKITA_TRACK_KEPT_MAX];
+static akita_track_t g_track;
+static uint32_t g_seed = 12345U;
+
+/* Roughly normal GPS noise in metres, repeatable across runs. */
+static double akita_noise(double sigma_m) {
+    double sum = 0.0;
+    int index;
+
+    for (index = 0; index < 4; ++index) {
+        g_seed = g_seed * 1664525U + 1013904223U;
+        sum += (double) (g_seed >> 8) / 16777216.0 - 0.5;
+    }
+
+    return sum * sigma_m * 1.7;
+}
+
+static void akita_fix_at(akita_fix_t *fix, double north_m, double east_m, double sigma_m, uint64_t timestamp_ms) {
+    const double origin_lat = 45.5;
+    const double origin_lon = -73.56;
+
+    north_m += akita_noise(sigma_m);
+    east_m += akita_noise(sigma_m);
+    fix->latitude = (float) (origin_lat + north_m / AKITA_EARTH_M_PER_DEG);
+    fix->longitude = (float) (origin_lon + east_m / (AKITA_EARTH_M_PER_DEG * cos(origin_lat * AKITA_PI / 180.0)));
+    fix->timestamp_ms = timestamp_ms;
+}
+
+/* A city grid at 10 Hz: 40 km/h blocks of 300 m with a right or left turn at each corner. */
+static size_t akita_record_city(void) {
+    double north = 0.0;
+    double east = 0.0;
+    double heading = 0.0;
+    size_t count = 0;
+    uint32_t block;
+
+    for (block = 0; block < 40U && count < AKITA_TRACK_FIXES_MAX; ++block) {
+        double travelled;
+
+        for (travelled = 0.0; travelled < 300.0 && count < AKITA_TRACK_FIXES_MAX; travelled += 40.0 / 36.0) {
+            north += cos(heading) * 40.0 / 36.0;
+            east += sin(heading) * 40.0 / 36.0;
+            akita_fix_at(&g_fixes[count], north, east, 1.5, (uint64_t) count * 100U);
+            ++count;
+        }
+        heading += (block % 3U == 0U ? -AKITA_PI : AKITA_PI) / 2.0;
+    }
+
+    return count;
+}
+
+/* A highway at 10 Hz: 110 km/h through long straights and 1 km radius curves. */
+static size_t akita_record_highway(void) {
+    double north = 0.0;
+    double east = 0.0;
+    double heading = 0.3;
+    double step = 110.0 / 36.0;
+    size_t count;
+
+    for (count = 0; count < 12000U; ++count) {
+        if ((count / 1500U) % 2U == 1U) {
+            heading += step / 1000.0;
+        }
+        north += cos(heading) * step;
+        east += sin(heading) * step;
+        akita_fix_at(&g_fixes[count], north, east, 1.5, (uint64_t) count * 100U);
+    }
+
+    return count;
+}
+
+/* Parked for an hour at 1 Hz with the usual wander of a receiver under a roof. */
+static size_t akita_record_parked(void) {
+    size_t count;
+
+    for (count = 0; count < 3600U; ++count) {
+        akita_fix_at(&g_fixes[count], 0.0, 0.0, 3.0, (uint64_t) count * 1000U);
+    }
+
+    return count;
+}
+
+static double akita_point_x(int32_t longitude_e6) {
+    return (double) longitude_e6 * 1.0e-6 * AKITA_EARTH_M_PER_DEG * cos(45.5 * AKITA_PI / 180.0);
+}
+
+static double akita_point_y(int32_t latitude_e6) {
+    return (double) latitude_e6 * 1.0e-6 * AKITA_EARTH_M_PER_DEG;
+}
+
+static double akita_segment_distance(const akita_track_point_t *a, const akita_track_point_t *b, const akita_fix_t *fix) {
+    double ax = akita_point_x(a->longitude_e6);
+    double ay = akita_point_y(a->latitude_e6);
+    double bx = akita_point_x(b->longitude_e6) - ax;
+    double by = akita_point_y(b->latitude_e6) - ay;
+    double px = akita_point_x((int32_t) lroundf(fix->longitude * 1.0e6f)) - ax;
+    double py = akita_point_y((int32_t) lroundf(fix->latitude * 1.0e6f)) - ay;
+    double length_sq = bx * bx + by * by;
+    double t = length_sq > 0.0 ? (px * bx + py * by) / length_sq : 0.0;
+
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    return hypot(px - t * bx, py - t * by);
+}
+
+/* Feeds a recording through the simplifier, draining it the way routine samples do, and checks the error bound. */
+static int akita_check_recording(const char *name, size_t count, double min_ratio) {
+    size_t kept = 0;
+    size_t fix;
+    size_t segment = 0;
+    double worst_m = 0.0;
+    uint64_t start_ns;
+    uint64_t elapsed_ns;
+
+    akita_track_init(&g_track, AKITA_TRACK_TOLERANCE_M);
+    start_ns = akita_bench_now_ns();
+    for (fix = 0; fix < count; ++fix) {
+        akita_track_add(&g_track, (int32_t) lroundf(g_fixes[fix].latitude * 1.0e6f),
+                        (int32_t) lroundf(g_fixes[fix].longitude * 1.0e6f), g_fixes[fix].timestamp_ms);
+        if (g_track.count == AKITA_TRACK_MAX_POINTS) {
+            kept += akita_track_take(&g_track, &g_kept[kept], AKITA_TRACK_KEPT_MAX - kept);
+        }
+    }
+    elapsed_ns = akita_bench_now_ns() - start_ns;
+    kept += akita_track_take(&g_track, &g_kept[kept], AKITA_TRACK_KEPT_MAX - kept);
+
+    AKITA_CHECK(kept >= 1U);
+    AKITA_CHECK(g_track.overflowed == 0U);
+    AKITA_CHECK(g_kept[0].timestamp_ms == g_fixes[0].timestamp_ms);
+
+    /* Every fix up to the last kept point lies within tolerance of the segment that replaced it. */
+    for (fix = 0; fix < count && g_fixes[fix].timestamp_ms <= g_kept[kept - 1U].timestamp_ms; ++fix) {
+        double distance_m;
+
+        while (segment + 1U < kept && g_kept[segment + 1U].timestamp_ms < g_fixes[fix].timestamp_ms) {
+            ++segment;
+        }
+        distance_m = segment + 1U < kept ? akita_segment_distance(&g_kept[segment], &g_kept[segment + 1U], &g_fixes[fix])
+                                         : akita_segment_distance(&g_kept[segment], &g_kept[segment], &g_fixes[fix]);
+        if (distance_m > worst_m) {
+            worst_m = distance_m;
+        }
+    }
+
+    printf("%-8s %5zu fixes -> %4zu points (%.1f:1), worst %.2f m, %.0f ns per fix\n", name, count, kept,
+           (double) count / (double) kept, worst_m, (double) elapsed_ns / (double) count);
+    AKITA_CHECK(worst_m <= AKITA_TRACK_TOLERANCE_M + AKITA_TRACK_SLACK_M);
+    AKITA_CHECK((double) count / (double) kept >= min_ratio);
+    return 0;
+}
+
+static int akita_check_payload(void) {
+    akita_runtime_config_t config;
+    akita_outbox_message_t message;
+    char payload[1792];
+
+    akita_board_apply_defaults(&config);
+    memset(&message, 0, sizeof(message));
+    message.message_class = AKITA_MESSAGE_ROUTINE;
+    message.event_value = NAN;
+    message.created_ms = 60000U;
+    message.sample.track_count = 2U;
+    message.sample.track[0] = (akita_track_point_t) {.latitude_e6 = 45500001, .longitude_e6 = -73560000, .timestamp_ms = 20000U};
+    message.sample.track[1] = (akita_track_point_t) {.latitude_e6 = -450, .longitude_e6 = 7, .timestamp_ms = 59500U};
+
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, ",\"track\":[[45.500001,-73.560000,40000],[-0.000450,0.000007,500]]}") != NULL);
+
+    message.sample.track_count = 0U;
+    AKITA_CHECK(akita_payload_write_message_json(&config, &message, payload, sizeof(payload)) > 0U);
+    AKITA_CHECK(strstr(payload, "track") == NULL);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_recording("city", akita_record_city(), 30.0) != 0 ||
+        akita_check_recording("highway", akita_record_highway(), 30.0) != 0 ||
+        akita_check_recording("parked", akita_record_parked(), 20.0) != 0 ||
+        akita_check_payload() != 0) {
+        return 1;
+    }
+
+    printf("track checks passed\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_app.h"
+#include "akita_board.h"
+#include "akita_trip.h"
+#include "bench_support.h"
+
+#define AKITA_TRIP_STEP_MS 200U
+
+static akita_trip_tracker_t g_tracker;
+static akita_vehicle_telemetry_t g_telemetry;
+static akita_trip_record_t g_record;
+static uint64_t g_now_ms;
+
+static void akita_drive(float rpm, float speed_kmh) {
+    g_telemetry.obd.connected = rpm > 0.0f;
+    g_telemetry.obd.rpm = rpm;
+    g_telemetry.obd.speed_kmh = speed_kmh;
+}
+
+/* Runs the tracker at the main task poll rate and returns the last event it reported. */
+static akita_trip_event_t akita_run(uint32_t duration_ms) {
+    akita_trip_event_t last = AKITA_TRIP_NONE;
+    uint32_t elapsed;
+
+    for (elapsed = 0; elapsed < duration_ms; elapsed += AKITA_TRIP_STEP_MS) {
+        akita_trip_event_t event;
+
+        g_now_ms += AKITA_TRIP_STEP_MS;
+        event = akita_trip_update(&g_tracker, &g_telemetry, g_now_ms, &g_record);
+        if (event != AKITA_TRIP_NONE) {
+            last = event;
+        }
+    }
+
+    return last;
+}
+
+static void akita_reset(uint32_t next_id) {
+    akita_trip_init(&g_tracker, next_id);
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+    memset(&g_record, 0, sizeof(g_record));
+    g_now_ms = 100000U;
+}
+
+static int akita_check_blip(void) {
+    /* Ignition on for a few seconds, or a car rolling past, is not a trip. */
+    akita_reset(1U);
+    akita_drive(800.0f, 0.0f);
+    AKITA_CHECK(akita_run(5000U) == AKITA_TRIP_NONE);
+    akita_drive(0.0f, 0.0f);
+    AKITA_CHECK(akita_run(AKITA_TRIP_STOP_MS + 1000U) == AKITA_TRIP_NONE);
+    AKITA_CHECK(!g_tracker.active);
+    AKITA_CHECK(g_tracker.next_id == 1U);
+    return 0;
+}
+
+static int akita_check_trip(void) {
+    const uint64_t start_ms = 100000U + AKITA_TRIP_STEP_MS;
+
+    akita_reset(7U);
+    g_telemetry.gps.fix = true;
+    g_telemetry.gps.latitude = 45.500000f;
+    g_telemetry.gps.longitude = -73.560000f;
+
+    /* Two minutes idling, ten at 72 km/h and 2000 rpm, one at 3000 rpm and 108 km/h, then parked. */
+    akita_drive(800.0f, 0.0f);
+    AKITA_CHECK(akita_run(120000U) == AKITA_TRIP_STARTED);
+    AKITA_CHECK(g_tracker.active);
+    AKITA_CHECK(g_tracker.record.trip_id == 7U);
+    AKITA_CHECK(g_tracker.record.start_ms == start_ms);
+
+    g_telemetry.gps.speed_kmh = 72.0f;
+    akita_drive(2000.0f, 72.0f);
+    AKITA_CHECK(akita_run(600000U) == AKITA_TRIP_NONE);
+    g_telemetry.gps.speed_kmh = 108.0f;
+    g_telemetry.gps.latitude = 45.600000f;
+    akita_drive(3000.0f, 108.0f);
+    AKITA_CHECK(akita_run(60000U) == AKITA_TRIP_NONE);
+
+    /* A short engine-off stop, like a fuel stop, stays inside the trip. */
+    g_telemetry.gps.speed_kmh = 0.0f;
+    akita_drive(0.0f, 0.0f);
+    AKITA_CHECK(akita_run(AKITA_TRIP_STOP_MS - 1000U) == AKITA_TRIP_NONE);
+    AKITA_CHECK(g_tracker.active);
+    AKITA_CHECK(akita_run(2000U) == AKITA_TRIP_ENDED);
+    AKITA_CHECK(!g_tracker.active);
+
+    AKITA_CHECK(g_record.trip_id == 7U);
+    AKITA_CHECK(g_record.start_ms == start_ms);
+    AKITA_CHECK(g_record.duration_ms == 780000U - AKITA_TRIP_STEP_MS);
+    /* 12 km at 72 km/h plus 1.8 km at 108 km/h. */
+    AKITA_CHECK(g_record.distance_m >= 13790U && g_record.distance_m <= 13810U);
+    AKITA_CHECK(g_record.max_speed_kmh == 108.0f);
+    AKITA_CHECK(g_record.idle_ms >= 119000U && g_record.idle_ms <= 120000U);
+    AKITA_CHECK(g_record.rpm_band_ms[0] == g_record.idle_ms);
+    AKITA_CHECK(g_record.rpm_band_ms[1] == 600000U);
+    AKITA_CHECK(g_record.rpm_band_ms[2] == 60000U);
+    AKITA_CHECK(g_record.rpm_band_ms[3] == 0U && g_record.rpm_band_ms[4] == 0U);
+    AKITA_CHECK(g_record.has_start_fix && g_record.has_end_fix);
+    AKITA_CHECK(g_record.start_latitude == 45.5f);
+    AKITA_CHECK(g_record.end_latitude == 45.6f);
+    AKITA_CHECK(g_tracker.next_id == 8U);
+    return 0;
+}
+
+static int akita_check_gap(void) {
+    /* A stalled poll is not integrated as minutes at the last known speed. */
+    akita_reset(1U);
+    akita_drive(2000.0f, 50.0f);
+    AKITA_CHECK(akita_run(20000U) == AKITA_TRIP_STARTED);
+    g_now_ms += 60000U;
+    AKITA_CHECK(akita_run(AKITA_TRIP_STEP_MS) == AKITA_TRIP_NONE);
+    akita_trip_snapshot(&g_tracker, &g_record);
+    AKITA_CHECK(g_record.distance_m < 300U);
+    AKITA_CHECK(!g_record.has_start_fix);
+    return 0;
+}
+
+static int akita_check_payload(void) {
+    akita_runtime_config_t config;
+    char buffer[512];
+    size_t length;
+
+    akita_board_apply_defaults(&config);
+    snprintf(config.vehicle_id, sizeof(config.vehicle_id), "%s", "van-7");
+    memset(&g_record, 0, sizeof(g_record));
+    g_record.trip_id = 3U;
+    g_record.start_ms = 5000U;
+    g_record.duration_ms = 600000U;
+    g_record.distance_m = 8123U;
+    g_record.max_speed_kmh = 88.25f;
+    g_record.idle_ms = 45000U;
+    g_record.rpm_band_ms[0] = 45000U;
+    g_record.rpm_band_ms[1] = 555000U;
+    g_record.has_end_fix = true;
+    g_record.end_latitude = 45.5f;
+    g_record.end_longitude = -73.5f;
+    g_record.flags = AKITA_TRIP_FLAG_TRUNCATED;
+
+    length = akita_payload_write_trip_json(&config, &g_record, 700000U, buffer, sizeof(buffer));
+    AKITA_CHECK(length == strlen(buffer));
+    AKITA_CHECK(strstr(buffer, "{\"node_id\":\"van-7\",\"timestamp_ms\":700000,") == buffer);
+    AKITA_CHECK(strstr(buffer,
+                       ",\"event\":\"trip\",\"trip\":{\"id\":3,\"start_ms\":5000,\"duration_ms\":600000,"
+                       "\"distance_m\":8123,\"max_speed_kmh\":88.2,\"idle_ms\":45000,"
+                       "\"rpm_band_ms\":[45000,555000,0,0,0],\"end\":[45.500000,-73.500000],\"truncated\":true}}") != NULL);
+    AKITA_CHECK(strstr(buffer, "\"start\":") == NULL);
+    AKITA_CHECK(akita_payload_write_trip_json(&config, &g_record, 700000U, buffer, 64U) == 0U);
+
+    /* A record from before a reset carries only its UTC times; its uptime belongs to the earlier boot. */
+    g_record.flags = AKITA_TRIP_FLAG_TRUNCATED | AKITA_TRIP_FLAG_EARLIER_BOOT;
+    g_record.start_utc_ms = 1767225600000LL;
+    g_record.end_utc_ms = 1767226200000LL;
+    length = akita_payload_write_trip_json(&config, &g_record, 700000U, buffer, sizeof(buffer));
+    AKITA_CHECK(length == strlen(buffer));
+    AKITA_CHECK(strstr(buffer, "\"trip\":{\"id\":3,\"start_utc_ms\":1767225600000,\"end_utc_ms\":1767226200000,"
+                               "\"duration_ms\":600000,") != NULL);
+    AKITA_CHECK(strstr(buffer, "\"start_ms\":") == NULL);
+    return 0;
+}
+
+int main(void) {
+    if (akita_check_blip() != 0 ||
+        akita_check_trip() != 0 ||
+        akita_check_gap() != 0 ||
+        akita_check_payload() != 0) {
+        return 1;
+    }
+
+    printf("trip checks passed\n");
+    return 0;
+}
@@ -3,12 +3,16 @@
 
 #include "akita_types.h"
 
+/* Coolant alert at 110 C clearing below 105 C, over-rev held for 1 s, and braking harder than 14 km/h per second. */
+#define AKITA_DEFAULT_EVENT_RULES "coolant_high=obd.coolant_c>110~5!;over_rev=obd.rpm>6000@1000;harsh_brake=gps.speed_kmh-14"
+
 typedef struct {
     akita_board_profile_t profile;
     const char *name;
     int32_t status_led_pin;
     int32_t gps_tx_pin;
     int32_t gps_rx_pin;
+    int32_t gps_pps_pin;
     int32_t lora_sck_pin;
     int32_t lora_miso_pin;
     int32_t lora_mosi_pin;
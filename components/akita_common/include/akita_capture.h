@@ -0,0 +1,111 @@
+#ifndef AKITA_CAPTURE_H
+#define AKITA_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_AKITA_CAPTURE_BUFFER_BYTES
+#define AKITA_CAPTURE_BUFFER_BYTES CONFIG_AKITA_CAPTURE_BUFFER_BYTES
+#else
+#define AKITA_CAPTURE_BUFFER_BYTES 4096
+#endif
+
+#define AKITA_CAPTURE_MAGIC "AKCP"
+#define AKITA_CAPTURE_VERSION 1U
+/* The magic, the version, a reserved half word, the uptime in microseconds recording started and the GPS baud rate. */
+#define AKITA_CAPTURE_HEADER_BYTES 20U
+/*
+ * Each record is a tag byte, the source in the low nibble and flags above it, then the microseconds since the
+ * previous record as a zigzag varint, the length as a varint and the bytes as they arrived. A tag of 0xFF is
+ * erased flash and ends the log.
+ */
+#define AKITA_CAPTURE_END 0xFFU
+#define AKITA_CAPTURE_SOURCE_MASK 0x0FU
+/* On an OBD reply: the link stopped waiting for the rest of it. */
+#define AKITA_CAPTURE_FLAG_FORCE 0x10U
+
+typedef enum {
+    /* One UART read, stamped with the latest its last byte can have arrived. */
+    AKITA_CAPTURE_GPS_UART = 1,
+    AKITA_CAPTURE_GPS_PPS,
+    AKITA_CAPTURE_OBD_TX,
+    /* One BLE notification or characteristic read. */
+    AKITA_CAPTURE_OBD_RX,
+} akita_capture_source_t;
+
+#define AKITA_CAPTURE_SOURCE_BIT(source) (1U << (source))
+#define AKITA_CAPTURE_GPS_SOURCES (AKITA_CAPTURE_SOURCE_BIT(AKITA_CAPTURE_GPS_UART) | AKITA_CAPTURE_SOURCE_BIT(AKITA_CAPTURE_GPS_PPS))
+#define AKITA_CAPTURE_OBD_SOURCES (AKITA_CAPTURE_SOURCE_BIT(AKITA_CAPTURE_OBD_TX) | AKITA_CAPTURE_SOURCE_BIT(AKITA_CAPTURE_OBD_RX))
+
+typedef struct {
+    uint8_t source;
+    uint8_t flags;
+    uint64_t at_us;
+    const uint8_t *data;
+    size_t length;
+} akita_capture_record_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t offset;
+    uint64_t at_us;
+    uint64_t start_us;
+    uint32_t gps_baud;
+} akita_capture_reader_t;
+
+/*
+ * Plays a log back against local uptime: records come out when they are due at speed_percent of the recorded
+ * rate, their times moved to match. The log is held in memory and freed by akita_capture_replay_close.
+ */
+typedef struct {
+    uint8_t *owned;
+    akita_capture_reader_t reader;
+    akita_capture_record_t next;
+    bool has_next;
+    uint32_t sources;
+    uint32_t speed_percent;
+    uint64_t first_us;
+    uint64_t started_us;
+} akita_capture_replay_t;
+
+/* Receives encoded log bytes piece by piece; returning false stops it. */
+typedef bool (*akita_capture_write_t)(const void *data, size_t size, void *context);
+
+#if CONFIG_AKITA_CAPTURE
+#define AKITA_CAPTURE(source, flags, at_us, data, length) akita_capture_record((source), (flags), (at_us), (data), (length))
+#else
+#define AKITA_CAPTURE(source, flags, at_us, data, length) ((void) 0)
+#endif
+
+size_t akita_capture_write_header(uint8_t *out, uint64_t start_us, uint32_t gps_baud);
+/* Encodes a record after the one at *last_us and advances it; returns the length, 0 if it does not fit. */
+size_t akita_capture_encode(const akita_capture_record_t *record, uint64_t *last_us, uint8_t *out, size_t size);
+bool akita_capture_reader_init(akita_capture_reader_t *reader, const uint8_t *data, size_t size);
+/* Returns false at the end of the log or at a record cut short. */
+bool akita_capture_next(akita_capture_reader_t *reader, akita_capture_record_t *record);
+/* Bytes from the start of the log to the end of its last whole record, 0 if it has no header. */
+size_t akita_capture_length(const uint8_t *data, size_t size);
+
+/* Records go into one half of a double buffer while the other is drained. */
+void akita_capture_start(uint64_t start_us, uint32_t gps_baud);
+void akita_capture_stop(void);
+bool akita_capture_running(void);
+void akita_capture_record(uint8_t source, uint8_t flags, uint64_t at_us, const void *data, size_t length);
+/* Writes out a full half, and with all the one being filled too; false if write refused the bytes. */
+bool akita_capture_drain(akita_capture_write_t write, void *context, bool all);
+/* Records lost because both halves were full. */
+uint32_t akita_capture_dropped(void);
+
+esp_err_t akita_capture_replay_open(akita_capture_replay_t *replay, const char *path, uint32_t sources,
+                                    uint32_t speed_percent, uint64_t now_us);
+/* Returns the next record of the chosen sources due by now_us; false if none is due or the log has ended. */
+bool akita_capture_replay_next(akita_capture_replay_t *replay, uint64_t now_us, akita_capture_record_t *record);
+bool akita_capture_replay_done(const akita_capture_replay_t *replay);
+void akita_capture_replay_close(akita_capture_replay_t *replay);
+
+#endif
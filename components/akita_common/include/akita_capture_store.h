@@ -0,0 +1,22 @@
+#ifndef AKITA_CAPTURE_STORE_H
+#define AKITA_CAPTURE_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_capture.h"
+#include "esp_err.h"
+
+/* Creates the store lock; called once at boot, before the portal or the main loop can reach the store. */
+esp_err_t akita_capture_store_init(void);
+/* Erases the capture partition and starts recording into it. */
+esp_err_t akita_capture_store_start(uint32_t gps_baud);
+/* Starts recording only if the partition holds no capture, so one survives a reboot until it is replaced. */
+esp_err_t akita_capture_store_start_if_empty(uint32_t gps_baud);
+/* Writes full buffers to flash; called from the main loop. Stops recording once the partition is full. */
+void akita_capture_store_flush(void);
+void akita_capture_store_stop(void);
+/* Streams the capture in the partition, up to what has reached flash. */
+esp_err_t akita_capture_store_read(akita_capture_write_t write, void *context);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef AKITA_CYCLES_H
+#define AKITA_CYCLES_H
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+
+/* The linux target has no cycle counter; nanoseconds stand in for cycles, as they do in the host bench. */
+#define AKITA_CYCLES_LINUX_PER_US 1000U
+
+static inline uint32_t akita_cycles_now(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec);
+}
+
+static inline int akita_cycles_core(void) {
+    return 0;
+}
+#else
+#include "esp_cpu.h"
+
+static inline uint32_t akita_cycles_now(void) {
+    return (uint32_t) esp_cpu_get_cycle_count();
+}
+
+static inline int akita_cycles_core(void) {
+    return esp_cpu_get_core_id();
+}
+#endif
+
+#endif
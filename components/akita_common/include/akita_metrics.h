@@ -0,0 +1,82 @@
+#ifndef AKITA_METRICS_H
+#define AKITA_METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+/* Bucket k counts spans below 2^(k + 8) CPU cycles, about 1 us to 9 s at 240 MHz; the last one takes the rest. */
+#define AKITA_METRIC_BUCKETS 24U
+#define AKITA_METRIC_BUCKET_SHIFT 8U
+
+typedef enum {
+    AKITA_METRIC_GPS_INGEST = 0,
+    AKITA_METRIC_OBD_REQUEST,
+    AKITA_METRIC_OBD_RESPONSE,
+    AKITA_METRIC_PAYLOAD_ENCODE,
+    AKITA_METRIC_FRAME_ENCODE,
+    AKITA_METRIC_PUBLISH_HTTP,
+    AKITA_METRIC_PUBLISH_UDP,
+    AKITA_METRIC_PUBLISH_RNS_UDP,
+    AKITA_METRIC_PUBLISH_LORA,
+    AKITA_METRIC_NVS_CONFIG_READ,
+    AKITA_METRIC_NVS_CONFIG_WRITE,
+    AKITA_METRIC_NVS_TRIP_READ,
+    AKITA_METRIC_NVS_TRIP_WRITE,
+    AKITA_METRIC_COUNT,
+} akita_metric_t;
+
+typedef struct {
+    uint32_t cycles;
+    int core;
+} akita_metric_span_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t errors;
+    /* Timed spans; a span whose task moved to the other core is counted as a call but not timed. */
+    uint32_t count;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t buckets[AKITA_METRIC_BUCKETS];
+} akita_metric_stats_t;
+
+/*
+ * AKITA_METRIC_BEGIN(span) declares a span at the current cycle count and AKITA_METRIC_END(span, metric, ok)
+ * records it. With metrics turned off in menuconfig both expand to nothing and ok is not evaluated.
+ */
+#if CONFIG_AKITA_METRICS
+#include "akita_cycles.h"
+
+static inline akita_metric_span_t akita_metric_begin(void) {
+    akita_metric_span_t span = {.cycles = akita_cycles_now(), .core = akita_cycles_core()};
+
+    return span;
+}
+
+#define AKITA_METRIC_BEGIN(span) akita_metric_span_t span = akita_metric_begin()
+#define AKITA_METRIC_END(span, metric, ok) akita_metric_end(&(span), (metric), (ok))
+#else
+#define AKITA_METRIC_BEGIN(span) ((void) 0)
+#define AKITA_METRIC_END(span, metric, ok) ((void) 0)
+#endif
+
+void akita_metric_end(const akita_metric_span_t *span, akita_metric_t metric, bool ok);
+void akita_metric_stats_add(akita_metric_stats_t *stats, uint32_t cycles, bool timed, bool ok);
+void akita_metrics_snapshot(akita_metric_stats_t stats[AKITA_METRIC_COUNT]);
+const char *akita_metric_name(akita_metric_t metric);
+/*
+ * Writes part `part` of the Prometheus text exposition: one part per metric for the duration histograms, then
+ * one with the call and error counters. Returns its length, or 0 past the last part or when it does not fit.
+ */
+size_t akita_metrics_write_prometheus(
+    const akita_metric_stats_t stats[AKITA_METRIC_COUNT],
+    size_t part,
+    uint32_t cycles_per_us,
+    char *buffer,
+    size_t buffer_size
+);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef AKITA_TELEMETRY_SCHEMA_H
+#define AKITA_TELEMETRY_SCHEMA_H
+
+#include "akita_types.h"
+
+/*
+ * Single source of truth for telemetry fields. The JSON, compact JSON and
+ * binary frame encoders expand these lists at compile time, and
+ * tools/akita_schema_gen.py turns them into the bridge decoder spec.
+ *
+ * X(group, id, name, short_key, type, decimals, frame, member)
+ *   group      OBD, GPS or SYSTEM
+ *   id         suffix for generated enum names
+ *   name       key in the full JSON payload
+ *   short_key  key in the compact JSON payload, "" to omit it there
+ *   type       BOOL, FIXED, UINT or INT
+ *   decimals   fractional digits written for FIXED fields
+ *   frame      binary frame wire id and quantization: FLAG(bit), RAW(index),
+ *              SCALE(index, n) or DIV(index, n)
+ *   member     source member of akita_vehicle_telemetry_t
+ *
+ * Frame wire ids are fixed once released, so a field can be added to any
+ * group without moving the others on the air: a new FLAG field takes the
+ * next unused flag bit and any other field the next unused frame field
+ * index. Index 0 is the flags field. A removed field's id is never reused.
+ */
+#define AKITA_TELEMETRY_OBD_FIELDS(X) \
+    X(OBD, OBD_CONNECTED, "connected", "c", BOOL, 0, FLAG(0), obd.connected) \
+    X(OBD, OBD_RPM, "rpm", "r", FIXED, 1, SCALE(1, 4), obd.rpm) \
+    X(OBD, OBD_SPEED, "speed_kmh", "s", FIXED, 1, SCALE(2, 1), obd.speed_kmh) \
+    X(OBD, OBD_COOLANT, "coolant_c", "k", FIXED, 1, SCALE(3, 1), obd.coolant_c)
+
+#define AKITA_TELEMETRY_GPS_FIELDS(X) \
+    X(GPS, GPS_FIX, "fix", "f", BOOL, 0, FLAG(1), gps.fix) \
+    X(GPS, GPS_LAT, "lat", "la", FIXED, 6, SCALE(4, 1000000), gps.latitude) \
+    X(GPS, GPS_LON, "lon", "lo", FIXED, 6, SCALE(5, 1000000), gps.longitude) \
+    X(GPS, GPS_ALT, "alt_m", "", FIXED, 1, SCALE(6, 10), gps.altitude_m) \
+    X(GPS, GPS_SPEED, "speed_kmh", "v", FIXED, 1, SCALE(7, 10), gps.speed_kmh) \
+    X(GPS, GPS_SATS, "sats", "s", UINT, 0, RAW(8), gps.satellites)
+
+#define AKITA_TELEMETRY_SYSTEM_FIELDS(X) \
+    X(SYSTEM, CONFIG_PORTAL_READY, "config_portal_ready", "", BOOL, 0, FLAG(2), system.config_portal_ready) \
+    X(SYSTEM, TRANSPORT_READY, "transport_ready", "", BOOL, 0, FLAG(3), system.transport_ready) \
+    X(SYSTEM, WIFI_READY, "wifi_ready", "", BOOL, 0, FLAG(4), system.wifi_ready) \
+    X(SYSTEM, LORA_READY, "lora_ready", "", BOOL, 0, FLAG(5), system.lora_ready) \
+    X(SYSTEM, WIFI_RSSI, "wifi_rssi", "q", INT, 0, RAW(9), system.wifi_rssi) \
+    X(SYSTEM, FREE_HEAP, "free_heap", "h", UINT, 0, DIV(10, 1024), system.free_heap)
+
+#define AKITA_TELEMETRY_FIELDS(X) \
+    AKITA_TELEMETRY_OBD_FIELDS(X) \
+    AKITA_TELEMETRY_GPS_FIELDS(X) \
+    AKITA_TELEMETRY_SYSTEM_FIELDS(X)
+
+/*
+ * Splits a frame column into (kind, wire, param) so users can dispatch with
+ * AKITA_TELEMETRY_FRAME_DISPATCH(PREFIX_, id, member, frame), which expands
+ * to PREFIX_FLAG / PREFIX_RAW / PREFIX_SCALE / PREFIX_DIV
+ * (id, member, wire, param).
+ */
+#define AKITA_TELEMETRY_FRAME_FLAG(wire) FLAG, wire, 1
+#define AKITA_TELEMETRY_FRAME_RAW(wire) RAW, wire, 1
+#define AKITA_TELEMETRY_FRAME_SCALE(wire, param) SCALE, wire, param
+#define AKITA_TELEMETRY_FRAME_DIV(wire, param) DIV, wire, param
+
+#define AKITA_TELEMETRY_FRAME_DISPATCH(prefix, id, member, frame) \
+    AKITA_TELEMETRY_FRAME_DISPATCH_(prefix, id, member, AKITA_TELEMETRY_FRAME_##frame)
+#define AKITA_TELEMETRY_FRAME_DISPATCH_(prefix, id, member, spec) \
+    AKITA_TELEMETRY_FRAME_DISPATCH__(prefix, id, member, spec)
+#define AKITA_TELEMETRY_FRAME_DISPATCH__(prefix, id, member, kind, wire, param) \
+    prefix##kind(id, member, wire, param)
+
+#endif
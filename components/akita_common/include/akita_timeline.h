@@ -0,0 +1,104 @@
+#ifndef AKITA_TIMELINE_H
+#define AKITA_TIMELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_metrics.h"
+#include "sdkconfig.h"
+
+#if defined(ESP_PLATFORM) && !CONFIG_IDF_TARGET_LINUX
+#include "soc/soc_caps.h"
+#define AKITA_TIMELINE_CORES SOC_CPU_CORES_NUM
+#else
+#define AKITA_TIMELINE_CORES 1
+#endif
+
+#ifdef CONFIG_AKITA_TIMELINE_EVENTS
+#define AKITA_TIMELINE_EVENTS CONFIG_AKITA_TIMELINE_EVENTS
+#else
+#define AKITA_TIMELINE_EVENTS 512
+#endif
+
+/* A ring gets a sync point at least once a second and every 64 slots, so events can be placed in uptime. */
+#define AKITA_TIMELINE_SYNC_MS 1000U
+#define AKITA_TIMELINE_SYNC_SLOTS 64U
+#define AKITA_TIMELINE_MAGIC "AKTL"
+#define AKITA_TIMELINE_VERSION 1U
+/* A dump is the header, the event names, the task names, then each core's events oldest first. */
+#define AKITA_TIMELINE_FLAG_TRIGGER 0x01U
+
+typedef enum {
+    AKITA_TIMELINE_BEGIN = 0,
+    AKITA_TIMELINE_END,
+    /* cycles is when the span began and value how many cycles it took. */
+    AKITA_TIMELINE_COMPLETE,
+    AKITA_TIMELINE_INSTANT,
+    AKITA_TIMELINE_COUNTER,
+    /* value and task hold the low and high halves of the uptime in microseconds at cycles. */
+    AKITA_TIMELINE_SYNC,
+} akita_timeline_type_t;
+
+typedef enum {
+    AKITA_TIMELINE_MAIN_POLL = 0,
+    AKITA_TIMELINE_UPLINK_DRAIN,
+    AKITA_TIMELINE_WIFI_EVENT,
+    AKITA_TIMELINE_OUTBOX_DEPTH,
+    AKITA_TIMELINE_OUTBOX_DROP,
+    AKITA_TIMELINE_MAIN_STALL,
+    AKITA_TIMELINE_MANUAL_TRIGGER,
+    AKITA_TIMELINE_NAME_COUNT,
+} akita_timeline_name_t;
+
+/* The hot-path metrics share the timeline, named after their operation. */
+#define AKITA_TIMELINE_METRIC(metric) ((uint16_t) (AKITA_TIMELINE_NAME_COUNT + (metric)))
+#define AKITA_TIMELINE_NAMES (AKITA_TIMELINE_NAME_COUNT + AKITA_METRIC_COUNT)
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t task;
+    int32_t value;
+    uint16_t name;
+    uint8_t type;
+    uint8_t flags;
+} akita_timeline_event_t;
+
+typedef enum {
+    AKITA_TIMELINE_RUNNING = 0,
+    /* Still recording the events after a trigger, then frozen until rearmed. */
+    AKITA_TIMELINE_TRIGGERED,
+    AKITA_TIMELINE_FROZEN,
+} akita_timeline_state_t;
+
+/* Receives the dump piece by piece; returning false stops it. */
+typedef bool (*akita_timeline_write_t)(const void *data, size_t size, void *context);
+
+#if CONFIG_AKITA_TIMELINE
+#define AKITA_TIMELINE_SPAN_BEGIN(name) akita_timeline_record(AKITA_TIMELINE_BEGIN, (name), 0)
+#define AKITA_TIMELINE_SPAN_END(name) akita_timeline_record(AKITA_TIMELINE_END, (name), 0)
+#define AKITA_TIMELINE_INSTANT(name, value) akita_timeline_record(AKITA_TIMELINE_INSTANT, (name), (value))
+#define AKITA_TIMELINE_COUNTER(name, value) akita_timeline_record(AKITA_TIMELINE_COUNTER, (name), (value))
+#define AKITA_TIMELINE_TRIGGER(name, value) akita_timeline_trigger((name), (value))
+#else
+#define AKITA_TIMELINE_SPAN_BEGIN(name) ((void) 0)
+#define AKITA_TIMELINE_SPAN_END(name) ((void) 0)
+#define AKITA_TIMELINE_INSTANT(name, value) ((void) 0)
+#define AKITA_TIMELINE_COUNTER(name, value) ((void) 0)
+#define AKITA_TIMELINE_TRIGGER(name, value) ((void) 0)
+#endif
+
+void akita_timeline_record(akita_timeline_type_t type, uint16_t name, int32_t value);
+void akita_timeline_complete(uint16_t name, uint32_t start_cycles, uint32_t cycles);
+/* Marks the anomaly and freezes the rings once another quarter of a ring has been recorded after it. */
+void akita_timeline_trigger(uint16_t name, int32_t value);
+/* Clears the rings and starts recording again. */
+void akita_timeline_rearm(void);
+akita_timeline_state_t akita_timeline_state(void);
+const char *akita_timeline_name(uint16_t name);
+/* Recording pauses while the dump runs, unless the rings are already frozen. */
+bool akita_timeline_dump(akita_timeline_write_t write, void *context);
+/* Prints the dump to the console as hex lines between akita-timeline begin and end markers. */
+void akita_timeline_print(void);
+
+#endif
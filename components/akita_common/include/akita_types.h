@@ -19,16 +19,44 @@ typedef enum {
     AKITA_TRANSPORT_NONE = 0,
     AKITA_TRANSPORT_WIFI,
     AKITA_TRANSPORT_LORA,
+    AKITA_TRANSPORT_AUTO,
 } akita_transport_mode_t;
 
+typedef enum {
+    AKITA_LORA_REGION_AUTO = 0,
+    AKITA_LORA_REGION_UNRESTRICTED,
+    AKITA_LORA_REGION_EU868,
+    AKITA_LORA_REGION_US915,
+} akita_lora_region_t;
+
+typedef enum {
+    AKITA_MESSAGE_ALERT = 0,
+    AKITA_MESSAGE_EVENT,
+    AKITA_MESSAGE_ROUTINE,
+    AKITA_MESSAGE_BULK,
+    AKITA_MESSAGE_CLASS_COUNT,
+} akita_message_class_t;
+
+typedef struct {
+    int16_t rssi_dbm;
+    int8_t snr_quarter_db;
+} akita_link_quality_t;
+
 typedef struct {
     bool fix;
     float latitude;
     float longitude;
     float altitude_m;
     float speed_kmh;
+    float course_deg;
     uint8_t satellites;
     uint32_t age_ms;
+    /* Uptime when the position was read, 0 before the first fix. */
+    uint64_t fix_ms;
+    /* Latest RMC or ZDA time as Unix milliseconds, the uptime in microseconds it was read, and the last PPS edge. */
+    int64_t utc_ms;
+    uint64_t utc_received_us;
+    uint64_t pps_us;
 } akita_gps_snapshot_t;
 
 typedef struct {
@@ -37,6 +65,10 @@ typedef struct {
     float speed_kmh;
     float coolant_c;
     uint32_t age_ms;
+    /* Uptime when each PID was last answered, 0 if it has not been. */
+    uint64_t rpm_ms;
+    uint64_t speed_ms;
+    uint64_t coolant_ms;
 } akita_obd_snapshot_t;
 
 typedef struct {
@@ -46,6 +78,7 @@ typedef struct {
     bool transport_ready;
     int8_t wifi_rssi;
     uint32_t free_heap;
+    uint64_t sampled_ms;
 } akita_system_snapshot_t;
 
 typedef struct {
@@ -77,6 +110,27 @@ typedef struct {
     int32_t lora_dio0_pin;
     uint32_t lora_frequency_hz;
     uint16_t config_http_port;
+    akita_lora_region_t lora_region;
+    uint32_t lora_bandwidth_hz;
+    uint8_t lora_spreading_factor;
+    uint8_t lora_coding_rate;
+    int8_t lora_tx_power_dbm;
+    bool lora_adr_enabled;
+    bool lora_gateway_enabled;
+    bool publish_on_change;
+    uint32_t publish_min_interval_ms;
+    uint32_t publish_heartbeat_ms;
+    uint16_t publish_distance_m;
+    uint16_t publish_rpm_deadband;
+    uint8_t publish_speed_deadband_kmh;
+    uint8_t publish_coolant_deadband_c;
+    uint8_t publish_heading_deadband_deg;
+    bool aggregate_window;
+    bool aggregate_variance;
+    char event_rules[160];
+    uint16_t track_tolerance_m;
+    bool fusion_enabled;
+    int32_t gps_pps_pin;
 } akita_runtime_config_t;
 
 typedef struct {
@@ -12,6 +12,7 @@ static const akita_board_defaults_t kBoardDefaults[] = {
         .status_led_pin = AKITA_INVALID_PIN,
         .gps_tx_pin = AKITA_INVALID_PIN,
         .gps_rx_pin = AKITA_INVALID_PIN,
+        .gps_pps_pin = AKITA_INVALID_PIN,
         .lora_sck_pin = AKITA_INVALID_PIN,
         .lora_miso_pin = AKITA_INVALID_PIN,
         .lora_mosi_pin = AKITA_INVALID_PIN,
@@ -27,6 +28,7 @@ static const akita_board_defaults_t kBoardDefaults[] = {
         .status_led_pin = AKITA_INVALID_PIN,
         .gps_tx_pin = AKITA_INVALID_PIN,
         .gps_rx_pin = AKITA_INVALID_PIN,
+        .gps_pps_pin = AKITA_INVALID_PIN,
         .lora_sck_pin = AKITA_INVALID_PIN,
         .lora_miso_pin = AKITA_INVALID_PIN,
         .lora_mosi_pin = AKITA_INVALID_PIN,
@@ -42,6 +44,7 @@ static const akita_board_defaults_t kBoardDefaults[] = {
         .status_led_pin = AKITA_INVALID_PIN,
         .gps_tx_pin = AKITA_INVALID_PIN,
         .gps_rx_pin = AKITA_INVALID_PIN,
+        .gps_pps_pin = AKITA_INVALID_PIN,
         .lora_sck_pin = AKITA_INVALID_PIN,
         .lora_miso_pin = AKITA_INVALID_PIN,
         .lora_mosi_pin = AKITA_INVALID_PIN,
@@ -57,6 +60,7 @@ static const akita_board_defaults_t kBoardDefaults[] = {
         .status_led_pin = 25,
         .gps_tx_pin = 12,
         .gps_rx_pin = 34,
+        .gps_pps_pin = AKITA_INVALID_PIN,
         .lora_sck_pin = 5,
         .lora_miso_pin = 19,
         .lora_mosi_pin = 27,
@@ -136,4 +140,26 @@ void akita_board_apply_defaults(akita_runtime_config_t *config) {
     config->lora_dio0_pin = defaults->lora_dio0_pin;
     config->lora_frequency_hz = defaults->lora_frequency_hz;
     config->config_http_port = 80U;
+    config->lora_region = AKITA_LORA_REGION_AUTO;
+    config->lora_bandwidth_hz = 125000U;
+    config->lora_spreading_factor = 7U;
+    config->lora_coding_rate = 5U;
+    config->lora_tx_power_dbm = 17;
+    config->publish_on_change = true;
+    config->publish_min_interval_ms = 1000U;
+    config->publish_heartbeat_ms = 60000U;
+    config->publish_distance_m = 250U;
+    config->publish_rpm_deadband = 500U;
+    config->publish_speed_deadband_kmh = 10U;
+    config->publish_coolant_deadband_c = 3U;
+    config->publish_heading_deadband_deg = 20U;
+    config->aggregate_window = true;
+    snprintf(config->event_rules, sizeof(config->event_rules), "%s", AKITA_DEFAULT_EVENT_RULES);
+    config->track_tolerance_m = 10U;
+    config->fusion_enabled = true;
+    config->gps_pps_pin = defaults->gps_pps_pin;
+#if CONFIG_IDF_TARGET_LINUX
+    config->transport_mode = AKITA_TRANSPORT_WIFI;
+    snprintf(config->telemetry_endpoint, sizeof(config->telemetry_endpoint), "%s", CONFIG_AKITA_LINUX_ENDPOINT);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "akita_capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+
+static portMUX_TYPE g_capture_mux = portMUX_INITIALIZER_UNLOCKED;
+#define AKITA_CAPTURE_LOCK() portENTER_CRITICAL(&g_capture_mux)
+#define AKITA_CAPTURE_UNLOCK() portEXIT_CRITICAL(&g_capture_mux)
+#else
+#define AKITA_CAPTURE_LOCK() ((void) 0)
+#define AKITA_CAPTURE_UNLOCK() ((void) 0)
+#endif
+
+#define AKITA_CAPTURE_HALF_BYTES (AKITA_CAPTURE_BUFFER_BYTES / 2U)
+
+_Static_assert(AKITA_CAPTURE_HALF_BYTES >= 256U, "capture buffer must hold a few records per half");
+
+/*
+ * The recorder fills the active half; once a record does not fit it moves to the other half if that has been
+ * written out, and drops the record otherwise. A full half is left alone until drain has written it.
+ */
+typedef struct {
+    uint8_t bytes[AKITA_CAPTURE_HALF_BYTES];
+    size_t used;
+    bool full;
+} akita_capture_half_t;
+
+static akita_capture_half_t g_halves[2];
+static uint32_t g_active;
+static uint64_t g_last_us;
+static uint32_t g_dropped;
+static volatile bool g_running;
+
+static void akita_capture_put_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t) (value >> 8);
+}
+
+static void akita_capture_put_u32(uint8_t *out, uint32_t value) {
+    akita_capture_put_u16(out, (uint16_t) value);
+    akita_capture_put_u16(out + 2, (uint16_t) (value >> 16));
+}
+
+static uint32_t akita_capture_get_u32(const uint8_t *in) {
+    return (uint32_t) in[0] | ((uint32_t) in[1] << 8) | ((uint32_t) in[2] << 16) | ((uint32_t) in[3] << 24);
+}
+
+static size_t akita_capture_put_varint(uint8_t *out, uint64_t value) {
+    size_t length = 0;
+
+    while (value >= 0x80U) {
+        out[length++] = (uint8_t) (value | 0x80U);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t) value;
+    return length;
+}
+
+static bool akita_capture_get_varint(akita_capture_reader_t *reader, uint64_t *value) {
+    uint64_t result = 0;
+    uint8_t byte;
+
+    for (uint32_t shift = 0; shift < 64U; shift += 7U) {
+        if (reader->offset >= reader->size) {
+            return false;
+        }
+        byte = reader->data[reader->offset++];
+        result |= (uint64_t) (byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0U) {
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t akita_capture_write_header(uint8_t *out, uint64_t start_us, uint32_t gps_baud) {
+    memcpy(out, AKITA_CAPTURE_MAGIC, 4);
+    akita_capture_put_u16(out + 4, AKITA_CAPTURE_VERSION);
+    akita_capture_put_u16(out + 6, 0);
+    akita_capture_put_u32(out + 8, (uint32_t) start_us);
+    akita_capture_put_u32(out + 12, (uint32_t) (start_us >> 32));
+    akita_capture_put_u32(out + 16, gps_baud);
+    return AKITA_CAPTURE_HEADER_BYTES;
+}
+
+size_t akita_capture_encode(const akita_capture_record_t *record, uint64_t *last_us, uint8_t *out, size_t size) {
+    uint8_t prefix[1 + 10 + 10];
+    int64_t delta = (int64_t) (record->at_us - *last_us);
+    size_t length = 0;
+
+    prefix[length++] = (uint8_t) ((record->source & AKITA_CAPTURE_SOURCE_MASK) | (record->flags & ~AKITA_CAPTURE_SOURCE_MASK));
+    length += akita_capture_put_varint(prefix + length, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+    length += akita_capture_put_varint(prefix + length, record->length);
+    if (prefix[0] == AKITA_CAPTURE_END || length + record->length > size) {
+        return 0;
+    }
+
+    memcpy(out, prefix, length);
+    if (record->length > 0U) {
+        memcpy(out + length, record->data, record->length);
+    }
+    *last_us = record->at_us;
+    return length + record->length;
+}
+
+bool akita_capture_reader_init(akita_capture_reader_t *reader, const uint8_t *data, size_t size) {
+    memset(reader, 0, sizeof(*reader));
+    if (data == NULL || size < AKITA_CAPTURE_HEADER_BYTES || memcmp(data, AKITA_CAPTURE_MAGIC, 4) != 0 ||
+        (data[4] | (data[5] << 8)) != AKITA_CAPTURE_VERSION) {
+        return false;
+    }
+
+    reader->data = data;
+    reader->size = size;
+    reader->offset = AKITA_CAPTURE_HEADER_BYTES;
+    reader->start_us = akita_capture_get_u32(data + 8) | ((uint64_t) akita_capture_get_u32(data + 12) << 32);
+    reader->at_us = reader->start_us;
+    reader->gps_baud = akita_capture_get_u32(data + 16);
+    return true;
+}
+
+bool akita_capture_next(akita_capture_reader_t *reader, akita_capture_record_t *record) {
+    size_t offset = reader->offset;
+    uint64_t zigzag;
+    uint64_t length;
+    uint8_t tag;
+
+    if (offset >= reader->size || reader->data[offset] == AKITA_CAPTURE_END) {
+        return false;
+    }
+
+    tag = reader->data[reader->offset++];
+    if (!akita_capture_get_varint(reader, &zigzag) || !akita_capture_get_varint(reader, &length) ||
+        length > reader->size - reader->offset) {
+        reader->offset = offset;
+        return false;
+    }
+
+    reader->at_us += (uint64_t) ((int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1U));
+    record->source = tag & AKITA_CAPTURE_SOURCE_MASK;
+    record->flags = tag & (uint8_t) ~AKITA_CAPTURE_SOURCE_MASK;
+    record->at_us = reader->at_us;
+    record->data = reader->data + reader->offset;
+    record->length = (size_t) length;
+    reader->offset += (size_t) length;
+    return true;
+}
+
+size_t akita_capture_length(const uint8_t *data, size_t size) {
+    akita_capture_reader_t reader;
+    akita_capture_record_t record;
+
+    if (!akita_capture_reader_init(&reader, data, size)) {
+        return 0;
+    }
+    while (akita_capture_next(&reader, &record)) {
+    }
+    return reader.offset;
+}
+
+void akita_capture_start(uint64_t start_us, uint32_t gps_baud) {
+    AKITA_CAPTURE_LOCK();
+    memset(g_halves, 0, sizeof(g_halves));
+    g_active = 0;
+    g_halves[0].used = akita_capture_write_header(g_halves[0].bytes, start_us, gps_baud);
+    g_last_us = start_us;
+    g_dropped = 0;
+    g_running = true;
+    AKITA_CAPTURE_UNLOCK();
+}
+
+void akita_capture_stop(void) {
+    g_running = false;
+}
+
+bool akita_capture_running(void) {
+    return g_running;
+}
+
+void akita_capture_record(uint8_t source, uint8_t flags, uint64_t at_us, const void *data, size_t length) {
+    akita_capture_record_t record = {
+        .source = source,
+        .flags = flags,
+        .at_us = at_us,
+        .data = (const uint8_t *) data,
+        .length = length,
+    };
+    akita_capture_half_t *half;
+    size_t written = 0;
+
+    if (!g_running) {
+        return;
+    }
+
+    AKITA_CAPTURE_LOCK();
+    half = &g_halves[g_active];
+    if (!half->full) {
+        written = akita_capture_encode(&record, &g_last_us, half->bytes + half->used, sizeof(half->bytes) - half->used);
+    }
+    if (written == 0U && half->used > 0U) {
+        half->full = true;
+        if (g_halves[g_active ^ 1U].used == 0U) {
+            g_active ^= 1U;
+            half = &g_halves[g_active];
+            written = akita_capture_encode(&record, &g_last_us, half->bytes, sizeof(half->bytes));
+        }
+    }
+    if (written > 0U) {
+        half->used += written;
+    } else {
+        ++g_dropped;
+    }
+    AKITA_CAPTURE_UNLOCK();
+}
+
+static bool akita_capture_write_half(akita_capture_half_t *half, akita_capture_write_t write, void *context) {
+    bool ok = half->used == 0U || write(half->bytes, half->used, context);
+
+    AKITA_CAPTURE_LOCK();
+    half->used = 0;
+    half->full = false;
+    AKITA_CAPTURE_UNLOCK();
+    return ok;
+}
+
+bool akita_capture_drain(akita_capture_write_t write, void *context, bool all) {
+    akita_capture_half_t *half;
+    bool ok = true;
+
+    AKITA_CAPTURE_LOCK();
+    half = &g_halves[g_active ^ 1U];
+    AKITA_CAPTURE_UNLOCK();
+    if (half->full) {
+        ok = akita_capture_write_half(half, write, context);
+    }
+    if (!all || !ok) {
+        return ok;
+    }
+
+    AKITA_CAPTURE_LOCK();
+    half = &g_halves[g_active];
+    half->full = half->used > 0U;
+    g_active ^= 1U;
+    AKITA_CAPTURE_UNLOCK();
+    return !half->full || akita_capture_write_half(half, write, context);
+}
+
+uint32_t akita_capture_dropped(void) {
+    return g_dropped;
+}
+
+static void akita_capture_replay_advance(akita_capture_replay_t *replay) {
+    do {
+        replay->has_next = akita_capture_next(&replay->reader, &replay->next);
+    } while (replay->has_next && (replay->sources & AKITA_CAPTURE_SOURCE_BIT(replay->next.source)) == 0U);
+}
+
+esp_err_t akita_capture_replay_open(akita_capture_replay_t *replay, const char *path, uint32_t sources,
+                                    uint32_t speed_percent, uint64_t now_us) {
+    FILE *file;
+    long size;
+
+    memset(replay, 0, sizeof(*replay));
+    if (path == NULL || speed_percent == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return ESP_FAIL;
+    }
+    replay->owned = malloc(size > 0 ? (size_t) size : 1U);
+    if (replay->owned == NULL) {
+        fclose(file);
+        return ESP_ERR_NO_MEM;
+    }
+    if (fread(replay->owned, 1, (size_t) size, file) != (size_t) size) {
+        fclose(file);
+        akita_capture_replay_close(replay);
+        return ESP_FAIL;
+    }
+    fclose(file);
+
+    if (!akita_capture_reader_init(&replay->reader, replay->owned, (size_t) size)) {
+        akita_capture_replay_close(replay);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    replay->sources = sources;
+    replay->speed_percent = speed_percent;
+    /* Every source replays against the moment recording started, so separate replays stay in step. */
+    replay->first_us = replay->reader.start_us;
+    replay->started_us = now_us;
+    akita_capture_replay_advance(replay);
+    return ESP_OK;
+}
+
+bool akita_capture_replay_next(akita_capture_replay_t *replay, uint64_t now_us, akita_capture_record_t *record) {
+    int64_t offset_us;
+    uint64_t due_us;
+
+    if (!replay->has_next) {
+        return false;
+    }
+
+    offset_us = (int64_t) (replay->next.at_us - replay->first_us) * 100 / (int64_t) replay->speed_percent;
+    due_us = offset_us < 0 ? replay->started_us : replay->started_us + (uint64_t) offset_us;
+    if (due_us > now_us) {
+        return false;
+    }
+
+    *record = replay->next;
+    record->at_us = due_us;
+    akita_capture_replay_advance(replay);
+    return true;
+}
+
+bool akita_capture_replay_done(const akita_capture_replay_t *replay) {
+    return !replay->has_next;
+}
+
+void akita_capture_replay_close(akita_capture_replay_t *replay) {
+    free(replay->owned);
+    memset(replay, 0, sizeof(*replay));
+}
@@ -0,0 +1,198 @@
+#include "akita_capture_store.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define AKITA_CAPTURE_PARTITION_SUBTYPE 0x41
+#define AKITA_CAPTURE_ERASE_BLOCK 4096U
+#define AKITA_CAPTURE_READ_CHUNK 1024U
+
+static const char *TAG = "akita_capture";
+static const char *AKITA_CAPTURE_PARTITION = "capture";
+static SemaphoreHandle_t g_store_lock;
+/* Bytes of the running capture in flash, and how far the partition has been erased ahead of them. */
+static size_t g_written;
+static size_t g_erased;
+
+static const esp_partition_t *akita_capture_partition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t) AKITA_CAPTURE_PARTITION_SUBTYPE,
+                                    AKITA_CAPTURE_PARTITION);
+}
+
+static void akita_capture_store_lock(void) {
+    if (g_store_lock != NULL) {
+        xSemaphoreTake(g_store_lock, portMAX_DELAY);
+    }
+}
+
+static void akita_capture_store_unlock(void) {
+    if (g_store_lock != NULL) {
+        xSemaphoreGive(g_store_lock);
+    }
+}
+
+/* Erases a sector at a time as the log grows, always past its end so the byte after it reads as erased. */
+static bool akita_capture_store_append(const void *data, size_t size, void *context) {
+    const esp_partition_t *partition = (const esp_partition_t *) context;
+    size_t needed = g_written + size + 1U;
+    size_t end;
+
+    if (g_written + size > partition->size) {
+        return false;
+    }
+    if (needed > partition->size) {
+        needed = partition->size;
+    }
+    if (needed > g_erased) {
+        end = (needed + AKITA_CAPTURE_ERASE_BLOCK - 1U) / AKITA_CAPTURE_ERASE_BLOCK * AKITA_CAPTURE_ERASE_BLOCK;
+        if (esp_partition_erase_range(partition, g_erased, end - g_erased) != ESP_OK) {
+            return false;
+        }
+        g_erased = end;
+    }
+    if (esp_partition_write(partition, g_written, data, size) != ESP_OK) {
+        return false;
+    }
+
+    g_written += size;
+    return true;
+}
+
+static esp_err_t akita_capture_store_begin(const esp_partition_t *partition, uint32_t gps_baud) {
+    akita_capture_stop();
+    g_written = 0;
+    g_erased = 0;
+    akita_capture_start((uint64_t) esp_timer_get_time(), gps_baud);
+    /* The header goes out at once, so the partition holds a capture even if nothing is recorded. */
+    if (!akita_capture_drain(akita_capture_store_append, (void *) partition, true)) {
+        akita_capture_stop();
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Capturing GPS and OBD streams to the %s partition", AKITA_CAPTURE_PARTITION);
+    return ESP_OK;
+}
+
+esp_err_t akita_capture_store_init(void) {
+    if (g_store_lock == NULL) {
+        g_store_lock = xSemaphoreCreateMutex();
+    }
+
+    return g_store_lock != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t akita_capture_store_start(uint32_t gps_baud) {
+    const esp_partition_t *partition = akita_capture_partition();
+    esp_err_t err;
+
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    akita_capture_store_lock();
+    err = akita_capture_store_begin(partition, gps_baud);
+    akita_capture_store_unlock();
+    return err;
+}
+
+esp_err_t akita_capture_store_start_if_empty(uint32_t gps_baud) {
+    const esp_partition_t *partition = akita_capture_partition();
+    char magic[4];
+    esp_err_t err = ESP_OK;
+
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    akita_capture_store_lock();
+    if (esp_partition_read(partition, 0, magic, sizeof(magic)) == ESP_OK &&
+        memcmp(magic, AKITA_CAPTURE_MAGIC, sizeof(magic)) == 0) {
+        ESP_LOGI(TAG, "Keeping the capture in flash; start a new one from the portal");
+    } else {
+        err = akita_capture_store_begin(partition, gps_baud);
+    }
+    akita_capture_store_unlock();
+    return err;
+}
+
+void akita_capture_store_flush(void) {
+    const esp_partition_t *partition;
+
+    /* A download or a start holds the lock for a while; the other buffer half covers a skipped flush. */
+    if (!akita_capture_running() || g_store_lock == NULL || xSemaphoreTake(g_store_lock, 0) != pdTRUE) {
+        return;
+    }
+
+    partition = akita_capture_partition();
+    if (partition != NULL && akita_capture_running() &&
+        !akita_capture_drain(akita_capture_store_append, (void *) partition, false)) {
+        akita_capture_stop();
+        ESP_LOGW(TAG, "Capture partition full after %u bytes, recording stopped", (unsigned) g_written);
+    }
+    akita_capture_store_unlock();
+}
+
+void akita_capture_store_stop(void) {
+    const esp_partition_t *partition = akita_capture_partition();
+
+    if (partition == NULL) {
+        return;
+    }
+
+    akita_capture_store_lock();
+    if (akita_capture_running()) {
+        akita_capture_stop();
+        if (!akita_capture_drain(akita_capture_store_append, (void *) partition, true)) {
+            ESP_LOGW(TAG, "Capture partition full, the last records were lost");
+        }
+        ESP_LOGI(TAG, "Capture stopped: %u bytes, %lu records dropped", (unsigned) g_written,
+                 (unsigned long) akita_capture_dropped());
+    }
+    akita_capture_store_unlock();
+}
+
+esp_err_t akita_capture_store_read(akita_capture_write_t write, void *context) {
+    const esp_partition_t *partition = akita_capture_partition();
+    esp_partition_mmap_handle_t handle;
+    const void *image;
+    size_t limit;
+    size_t length;
+    esp_err_t err;
+
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* While recording, only what has been flushed is whole; later writes land past it. */
+    akita_capture_store_lock();
+    limit = akita_capture_running() ? g_written : partition->size;
+    akita_capture_store_unlock();
+
+    err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &image, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    length = akita_capture_length((const uint8_t *) image, limit);
+    if (length == 0U) {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    for (size_t offset = 0; err == ESP_OK && offset < length; offset += AKITA_CAPTURE_READ_CHUNK) {
+        size_t chunk = length - offset < AKITA_CAPTURE_READ_CHUNK ? length - offset : AKITA_CAPTURE_READ_CHUNK;
+
+        if (!write((const uint8_t *) image + offset, chunk, context)) {
+            err = ESP_FAIL;
+        }
+    }
+
+    esp_partition_munmap(handle);
+    return err;
+}
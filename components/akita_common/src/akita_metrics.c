@@ -0,0 +1,188 @@
+#include "akita_metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "akita_timeline.h"
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+
+static portMUX_TYPE g_metrics_mux = portMUX_INITIALIZER_UNLOCKED;
+#define AKITA_METRICS_LOCK() portENTER_CRITICAL(&g_metrics_mux)
+#define AKITA_METRICS_UNLOCK() portEXIT_CRITICAL(&g_metrics_mux)
+#else
+#define AKITA_METRICS_LOCK() ((void) 0)
+#define AKITA_METRICS_UNLOCK() ((void) 0)
+#endif
+
+static akita_metric_stats_t g_metrics[AKITA_METRIC_COUNT];
+
+void akita_metric_stats_add(akita_metric_stats_t *stats, uint32_t cycles, bool timed, bool ok) {
+    uint32_t bucket = 0;
+    uint32_t value = cycles >> AKITA_METRIC_BUCKET_SHIFT;
+
+    ++stats->calls;
+    if (!ok) {
+        ++stats->errors;
+    }
+    if (!timed) {
+        return;
+    }
+
+    while (value != 0U && bucket < AKITA_METRIC_BUCKETS - 1U) {
+        value >>= 1;
+        ++bucket;
+    }
+
+    ++stats->count;
+    ++stats->buckets[bucket];
+    stats->total_cycles += cycles;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+}
+
+#if CONFIG_AKITA_METRICS
+void akita_metric_end(const akita_metric_span_t *span, akita_metric_t metric, bool ok) {
+    /* Each core has its own cycle counter, so only a span that began and ended on one core is timed. */
+    uint32_t cycles = akita_cycles_now() - span->cycles;
+    bool timed = akita_cycles_core() == span->core;
+
+    if (metric >= AKITA_METRIC_COUNT) {
+        return;
+    }
+
+    AKITA_METRICS_LOCK();
+    akita_metric_stats_add(&g_metrics[metric], cycles, timed, ok);
+    AKITA_METRICS_UNLOCK();
+#if CONFIG_AKITA_TIMELINE
+    if (timed) {
+        akita_timeline_complete(AKITA_TIMELINE_METRIC(metric), span->cycles, cycles);
+    }
+#endif
+}
+#endif
+
+void akita_metrics_snapshot(akita_metric_stats_t stats[AKITA_METRIC_COUNT]) {
+    AKITA_METRICS_LOCK();
+    memcpy(stats, g_metrics, sizeof(g_metrics));
+    AKITA_METRICS_UNLOCK();
+}
+
+const char *akita_metric_name(akita_metric_t metric) {
+    switch (metric) {
+        case AKITA_METRIC_GPS_INGEST:
+            return "gps_ingest";
+        case AKITA_METRIC_OBD_REQUEST:
+            return "obd_request";
+        case AKITA_METRIC_OBD_RESPONSE:
+            return "obd_response";
+        case AKITA_METRIC_PAYLOAD_ENCODE:
+            return "payload_encode";
+        case AKITA_METRIC_FRAME_ENCODE:
+            return "frame_encode";
+        case AKITA_METRIC_PUBLISH_HTTP:
+            return "publish_http";
+        case AKITA_METRIC_PUBLISH_UDP:
+            return "publish_udp";
+        case AKITA_METRIC_PUBLISH_RNS_UDP:
+            return "publish_rns_udp";
+        case AKITA_METRIC_PUBLISH_LORA:
+            return "publish_lora";
+        case AKITA_METRIC_NVS_CONFIG_READ:
+            return "nvs_config_read";
+        case AKITA_METRIC_NVS_CONFIG_WRITE:
+            return "nvs_config_write";
+        case AKITA_METRIC_NVS_TRIP_READ:
+            return "nvs_trip_read";
+        case AKITA_METRIC_NVS_TRIP_WRITE:
+            return "nvs_trip_write";
+        default:
+            return "unknown";
+    }
+}
+
+static bool akita_metrics_append(char *buffer, size_t buffer_size, size_t *used, const char *format, ...) {
+    va_list args;
+    int written;
+
+    if (*used >= buffer_size) {
+        return false;
+    }
+
+    va_start(args, format);
+    written = vsnprintf(buffer + *used, buffer_size - *used, format, args);
+    va_end(args);
+    if (written < 0 || (size_t) written >= buffer_size - *used) {
+        *used = buffer_size;
+        return false;
+    }
+
+    *used += (size_t) written;
+    return true;
+}
+
+size_t akita_metrics_write_prometheus(
+    const akita_metric_stats_t stats[AKITA_METRIC_COUNT],
+    size_t part,
+    uint32_t cycles_per_us,
+    char *buffer,
+    size_t buffer_size
+) {
+    double cycles_per_s = (double) (cycles_per_us > 0U ? cycles_per_us : 1U) * 1e6;
+    size_t used = 0;
+    size_t index;
+
+    if (stats == NULL || buffer == NULL || buffer_size == 0U || part > AKITA_METRIC_COUNT) {
+        return 0;
+    }
+
+    if (part < AKITA_METRIC_COUNT) {
+        const akita_metric_stats_t *metric = &stats[part];
+        const char *name = akita_metric_name((akita_metric_t) part);
+        uint64_t cumulative = 0;
+
+        if (part == 0U) {
+            akita_metrics_append(buffer, buffer_size, &used,
+                                 "# HELP akita_op_duration_seconds Time spent in an instrumented operation.\n"
+                                 "# TYPE akita_op_duration_seconds histogram\n");
+        }
+        for (index = 0; index + 1U < AKITA_METRIC_BUCKETS; ++index) {
+            cumulative += metric->buckets[index];
+            akita_metrics_append(buffer, buffer_size, &used, "akita_op_duration_seconds_bucket{op=\"%s\",le=\"%.3g\"} %llu\n",
+                                 name, (double) (1ULL << (index + AKITA_METRIC_BUCKET_SHIFT)) / cycles_per_s,
+                                 (unsigned long long) cumulative);
+        }
+        akita_metrics_append(buffer, buffer_size, &used,
+                             "akita_op_duration_seconds_bucket{op=\"%s\",le=\"+Inf\"} %lu\n"
+                             "akita_op_duration_seconds_sum{op=\"%s\"} %.9g\n"
+                             "akita_op_duration_seconds_count{op=\"%s\"} %lu\n",
+                             name, (unsigned long) metric->count,
+                             name, (double) metric->total_cycles / cycles_per_s,
+                             name, (unsigned long) metric->count);
+    } else {
+        akita_metrics_append(buffer, buffer_size, &used,
+                             "# HELP akita_op_calls_total Calls of an instrumented operation.\n"
+                             "# TYPE akita_op_calls_total counter\n");
+        for (index = 0; index < AKITA_METRIC_COUNT; ++index) {
+            akita_metrics_append(buffer, buffer_size, &used, "akita_op_calls_total{op=\"%s\"} %lu\n",
+                                 akita_metric_name((akita_metric_t) index), (unsigned long) stats[index].calls);
+        }
+        akita_metrics_append(buffer, buffer_size, &used,
+                             "# HELP akita_op_errors_total Calls of an instrumented operation that failed.\n"
+                             "# TYPE akita_op_errors_total counter\n");
+        for (index = 0; index < AKITA_METRIC_COUNT; ++index) {
+            akita_metrics_append(buffer, buffer_size, &used, "akita_op_errors_total{op=\"%s\"} %lu\n",
+                                 akita_metric_name((akita_metric_t) index), (unsigned long) stats[index].errors);
+        }
+    }
+
+    if (used >= buffer_size) {
+        buffer[buffer_size - 1U] = '\0';
+        return 0;
+    }
+
+    return used;
+}
@@ -0,0 +1,314 @@
+#include "akita_timeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_cycles.h"
+#include "esp_timer.h"
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define AKITA_TIMELINE_TICK() ((uint32_t) xTaskGetTickCount())
+#define AKITA_TIMELINE_SYNC_TICKS ((uint32_t) pdMS_TO_TICKS(AKITA_TIMELINE_SYNC_MS))
+#define AKITA_TIMELINE_TASK() ((uint32_t) (uintptr_t) xTaskGetCurrentTaskHandle())
+#define AKITA_TIMELINE_YIELD() vTaskDelay(1)
+#if CONFIG_IDF_TARGET_LINUX
+#define AKITA_TIMELINE_CYCLES_PER_US() AKITA_CYCLES_LINUX_PER_US
+#else
+#include "esp_rom_sys.h"
+#define AKITA_TIMELINE_CYCLES_PER_US() esp_rom_get_cpu_ticks_per_us()
+#endif
+#else
+/* Host builds have one task, and the bench cycle counter counts nanoseconds. */
+#define AKITA_TIMELINE_TICK() ((uint32_t) (esp_timer_get_time() / 1000))
+#define AKITA_TIMELINE_SYNC_TICKS AKITA_TIMELINE_SYNC_MS
+#define AKITA_TIMELINE_TASK() 0U
+#define AKITA_TIMELINE_CYCLES_PER_US() 1000U
+#define AKITA_TIMELINE_YIELD() ((void) 0)
+#endif
+
+#define AKITA_TIMELINE_MASK (AKITA_TIMELINE_EVENTS - 1U)
+#define AKITA_TIMELINE_PRINT_BYTES 48U
+
+_Static_assert((AKITA_TIMELINE_EVENTS & AKITA_TIMELINE_MASK) == 0, "timeline ring size must be a power of two");
+_Static_assert(sizeof(akita_timeline_event_t) == 16, "timeline events are 16 bytes on the wire");
+
+/*
+ * One ring per core, written by whatever runs on that core. A slot is claimed with an atomic add, so an
+ * interrupting task never shares one; a task moved to the other core between the two is rare and only
+ * lands one event in the other ring.
+ */
+typedef struct {
+    akita_timeline_event_t events[AKITA_TIMELINE_EVENTS];
+    uint32_t head;
+    uint32_t sync_tick;
+} akita_timeline_ring_t;
+
+typedef struct {
+    char line[AKITA_TIMELINE_PRINT_BYTES * 2U + 1U];
+    size_t used;
+} akita_timeline_printer_t;
+
+static akita_timeline_ring_t g_rings[AKITA_TIMELINE_CORES];
+static volatile uint32_t g_state;
+static uint32_t g_remaining;
+static volatile bool g_paused;
+
+static akita_timeline_event_t *akita_timeline_claim(uint32_t cycles) {
+    akita_timeline_ring_t *ring;
+    akita_timeline_event_t *sync;
+    uint64_t now_us;
+    uint32_t index;
+    uint32_t tick;
+
+    if (g_state == AKITA_TIMELINE_FROZEN || g_paused) {
+        return NULL;
+    }
+    if (g_state == AKITA_TIMELINE_TRIGGERED && __atomic_sub_fetch(&g_remaining, 1U, __ATOMIC_RELAXED) == 0U) {
+        g_state = AKITA_TIMELINE_FROZEN;
+    }
+
+    ring = &g_rings[akita_cycles_core() % AKITA_TIMELINE_CORES];
+    tick = AKITA_TIMELINE_TICK();
+    index = __atomic_fetch_add(&ring->head, 1U, __ATOMIC_RELAXED);
+    if ((index % AKITA_TIMELINE_SYNC_SLOTS) == 0U || tick - ring->sync_tick >= AKITA_TIMELINE_SYNC_TICKS) {
+        now_us = (uint64_t) esp_timer_get_time();
+        ring->sync_tick = tick;
+        sync = &ring->events[index & AKITA_TIMELINE_MASK];
+        sync->cycles = cycles;
+        sync->task = (uint32_t) (now_us >> 32);
+        sync->value = (int32_t) (uint32_t) now_us;
+        sync->name = 0;
+        sync->type = AKITA_TIMELINE_SYNC;
+        sync->flags = 0;
+        index = __atomic_fetch_add(&ring->head, 1U, __ATOMIC_RELAXED);
+    }
+
+    return &ring->events[index & AKITA_TIMELINE_MASK];
+}
+
+static void akita_timeline_put(uint32_t cycles, akita_timeline_type_t type, uint16_t name, int32_t value, uint8_t flags) {
+    akita_timeline_event_t *event = akita_timeline_claim(cycles);
+
+    if (event == NULL) {
+        return;
+    }
+
+    event->cycles = cycles;
+    event->task = AKITA_TIMELINE_TASK();
+    event->value = value;
+    event->name = name;
+    event->type = (uint8_t) type;
+    event->flags = flags;
+}
+
+void akita_timeline_record(akita_timeline_type_t type, uint16_t name, int32_t value) {
+    akita_timeline_put(akita_cycles_now(), type, name, value, 0U);
+}
+
+void akita_timeline_complete(uint16_t name, uint32_t start_cycles, uint32_t cycles) {
+    akita_timeline_put(start_cycles, AKITA_TIMELINE_COMPLETE, name, (int32_t) cycles, 0U);
+}
+
+void akita_timeline_trigger(uint16_t name, int32_t value) {
+    /* Two triggers racing on both cores only restart the countdown. */
+    if (g_state == AKITA_TIMELINE_RUNNING) {
+        g_remaining = AKITA_TIMELINE_EVENTS / 4U;
+        g_state = AKITA_TIMELINE_TRIGGERED;
+    }
+
+    akita_timeline_put(akita_cycles_now(), AKITA_TIMELINE_INSTANT, name, value, AKITA_TIMELINE_FLAG_TRIGGER);
+}
+
+void akita_timeline_rearm(void) {
+    g_paused = true;
+    memset(g_rings, 0, sizeof(g_rings));
+    g_state = AKITA_TIMELINE_RUNNING;
+    g_paused = false;
+}
+
+akita_timeline_state_t akita_timeline_state(void) {
+    return (akita_timeline_state_t) g_state;
+}
+
+const char *akita_timeline_name(uint16_t name) {
+    if (name >= AKITA_TIMELINE_NAME_COUNT) {
+        return akita_metric_name((akita_metric_t) (name - AKITA_TIMELINE_NAME_COUNT));
+    }
+
+    switch ((akita_timeline_name_t) name) {
+        case AKITA_TIMELINE_MAIN_POLL:
+            return "main_poll";
+        case AKITA_TIMELINE_UPLINK_DRAIN:
+            return "uplink_drain";
+        case AKITA_TIMELINE_WIFI_EVENT:
+            return "wifi_event";
+        case AKITA_TIMELINE_OUTBOX_DEPTH:
+            return "outbox_depth";
+        case AKITA_TIMELINE_OUTBOX_DROP:
+            return "outbox_drop";
+        case AKITA_TIMELINE_MAIN_STALL:
+            return "main_stall";
+        case AKITA_TIMELINE_MANUAL_TRIGGER:
+            return "manual_trigger";
+        default:
+            return "unknown";
+    }
+}
+
+static size_t akita_timeline_put_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t) (value >> 8);
+    return 2U;
+}
+
+static size_t akita_timeline_put_u32(uint8_t *out, uint32_t value) {
+    akita_timeline_put_u16(out, (uint16_t) value);
+    akita_timeline_put_u16(out + 2, (uint16_t) (value >> 16));
+    return 4U;
+}
+
+static bool akita_timeline_write_name(akita_timeline_write_t write, void *context, uint32_t prefix, bool with_prefix, const char *name) {
+    uint8_t record[5 + 255];
+    size_t used = 0;
+    size_t length = strlen(name) > 255U ? 255U : strlen(name);
+
+    if (with_prefix) {
+        used += akita_timeline_put_u32(record, prefix);
+    }
+    record[used++] = (uint8_t) length;
+    memcpy(record + used, name, length);
+    return write(record, used + length, context);
+}
+
+static bool akita_timeline_write_tasks(akita_timeline_write_t write, void *context, bool count_only, uint16_t *count) {
+#if defined(ESP_PLATFORM) && CONFIG_FREERTOS_USE_TRACE_FACILITY
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4U;
+    TaskStatus_t *tasks = calloc(capacity, sizeof(*tasks));
+    UBaseType_t found;
+    UBaseType_t index;
+    bool ok = true;
+
+    if (tasks == NULL) {
+        *count = 0;
+        return true;
+    }
+
+    found = uxTaskGetSystemState(tasks, capacity, NULL);
+    if (count_only) {
+        *count = (uint16_t) found;
+    } else {
+        for (index = 0; index < found && index < *count && ok; ++index) {
+            ok = akita_timeline_write_name(write, context, (uint32_t) (uintptr_t) tasks[index].xHandle, true, tasks[index].pcTaskName);
+        }
+        /* A task that started between counting and writing is left out; one that ended leaves a blank. */
+        for (; index < *count && ok; ++index) {
+            ok = akita_timeline_write_name(write, context, 0U, true, "");
+        }
+    }
+    free(tasks);
+    return ok;
+#else
+    (void) write;
+    (void) context;
+    (void) count_only;
+    *count = 0;
+    return true;
+#endif
+}
+
+bool akita_timeline_dump(akita_timeline_write_t write, void *context) {
+    uint8_t header[20];
+    uint8_t core_header[8];
+    uint16_t tasks = 0;
+    size_t used = 0;
+    size_t core;
+    uint16_t name;
+    bool ok;
+
+    if (write == NULL) {
+        return false;
+    }
+
+    g_paused = g_state != AKITA_TIMELINE_FROZEN;
+    akita_timeline_write_tasks(write, context, true, &tasks);
+
+    memcpy(header, AKITA_TIMELINE_MAGIC, 4U);
+    used = 4U;
+    used += akita_timeline_put_u16(header + used, AKITA_TIMELINE_VERSION);
+    used += akita_timeline_put_u16(header + used, AKITA_TIMELINE_CORES);
+    used += akita_timeline_put_u32(header + used, AKITA_TIMELINE_CYCLES_PER_US());
+    used += akita_timeline_put_u32(header + used, AKITA_TIMELINE_EVENTS);
+    used += akita_timeline_put_u16(header + used, AKITA_TIMELINE_NAMES);
+    used += akita_timeline_put_u16(header + used, tasks);
+    ok = write(header, used, context);
+
+    for (name = 0; name < AKITA_TIMELINE_NAMES && ok; ++name) {
+        ok = akita_timeline_write_name(write, context, 0U, false, akita_timeline_name(name));
+    }
+    if (ok) {
+        ok = akita_timeline_write_tasks(write, context, false, &tasks);
+    }
+
+    for (core = 0; core < AKITA_TIMELINE_CORES && ok; ++core) {
+        const akita_timeline_ring_t *ring = &g_rings[core];
+        uint32_t head = ring->head;
+        uint32_t count = head < AKITA_TIMELINE_EVENTS ? head : AKITA_TIMELINE_EVENTS;
+        uint32_t first = (head - count) & AKITA_TIMELINE_MASK;
+        uint32_t run = count < AKITA_TIMELINE_EVENTS - first ? count : AKITA_TIMELINE_EVENTS - first;
+
+        akita_timeline_put_u16(core_header, (uint16_t) core);
+        akita_timeline_put_u16(core_header + 2, 0U);
+        akita_timeline_put_u32(core_header + 4, count);
+        ok = write(core_header, sizeof(core_header), context);
+        if (ok && run > 0U) {
+            ok = write(&ring->events[first], run * sizeof(akita_timeline_event_t), context);
+        }
+        if (ok && count > run) {
+            ok = write(&ring->events[0], (count - run) * sizeof(akita_timeline_event_t), context);
+        }
+    }
+
+    g_paused = false;
+    return ok;
+}
+
+static void akita_timeline_print_line(akita_timeline_printer_t *printer) {
+    printer->line[printer->used] = '\0';
+    printf("akita-timeline: %s\n", printer->line);
+    printer->used = 0;
+    /* The console blocks while its FIFO drains; give the idle task a turn between lines. */
+    AKITA_TIMELINE_YIELD();
+}
+
+static bool akita_timeline_print_write(const void *data, size_t size, void *context) {
+    static const char kHex[] = "0123456789abcdef";
+    akita_timeline_printer_t *printer = context;
+    const uint8_t *bytes = data;
+    size_t index;
+
+    for (index = 0; index < size; ++index) {
+        printer->line[printer->used++] = kHex[bytes[index] >> 4];
+        printer->line[printer->used++] = kHex[bytes[index] & 0x0F];
+        if (printer->used == sizeof(printer->line) - 1U) {
+            akita_timeline_print_line(printer);
+        }
+    }
+
+    return true;
+}
+
+void akita_timeline_print(void) {
+    akita_timeline_printer_t printer = {.used = 0};
+
+    printf("akita-timeline: begin\n");
+    akita_timeline_dump(akita_timeline_print_write, &printer);
+    if (printer.used > 0U) {
+        akita_timeline_print_line(&printer);
+    }
+    printf("akita-timeline: end\n");
+    fflush(stdout);
+}
@@ -2,14 +2,21 @@
 #define AKITA_CONFIG_UI_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "akita_types.h"
 #include "esp_err.h"
 
 typedef esp_err_t (*akita_config_apply_callback_t)(const akita_runtime_config_t *config, void *context);
+/* Receives an uploaded geofence image piece by piece; the piece ending at total is the last. */
+typedef esp_err_t (*akita_config_upload_callback_t)(size_t offset, const void *data, size_t size, size_t total, void *context);
+/* Writes a JSON object for the "latency" member of GET /api/status; returns its length, 0 to leave it out. */
+typedef size_t (*akita_config_status_callback_t)(char *buffer, size_t buffer_size, void *context);
 
 esp_err_t akita_config_ui_start(akita_runtime_config_t *config);
 void akita_config_ui_set_apply_callback(akita_config_apply_callback_t callback, void *context);
+void akita_config_ui_set_geofence_callback(akita_config_upload_callback_t callback, void *context);
+void akita_config_ui_set_status_callback(akita_config_status_callback_t callback, void *context);
 bool akita_config_ui_is_running(void);
 
 #endif
\ No newline at end of file
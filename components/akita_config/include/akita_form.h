@@ -0,0 +1,18 @@
+#ifndef AKITA_FORM_H
+#define AKITA_FORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "akita_types.h"
+#include "esp_err.h"
+
+/* application/x-www-form-urlencoded bodies as the portal posts them. */
+void akita_form_url_decode(char *text);
+bool akita_form_contains(const char *body, const char *key);
+/* Copies the decoded value of key to output; body is left as it was passed in. */
+bool akita_form_get_value(char *body, const char *key, char *output, size_t output_size);
+/* Applies a portal post to config; ESP_ERR_INVALID_ARG leaves config untouched. Does not sanitize or save. */
+esp_err_t akita_form_apply_config(char *body, akita_runtime_config_t *config);
+
+#endif
@@ -4,7 +4,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "akita_airtime.h"
 #include "akita_board.h"
+#include "akita_metrics.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
@@ -59,6 +61,7 @@ void akita_config_sanitize(akita_runtime_config_t *config) {
     akita_config_terminate_string(config->obd_characteristic_uuid, sizeof(config->obd_characteristic_uuid));
     akita_config_terminate_string(config->reticulum_destination, sizeof(config->reticulum_destination));
     akita_config_terminate_string(config->telemetry_endpoint, sizeof(config->telemetry_endpoint));
+    akita_config_terminate_string(config->event_rules, sizeof(config->event_rules));
 
     if (config->vehicle_id[0] == '\0') {
         snprintf(config->vehicle_id, sizeof(config->vehicle_id), "%s", "AkitaCarNode");
@@ -70,6 +73,26 @@ void akita_config_sanitize(akita_runtime_config_t *config) {
         config->telemetry_interval_ms = 600000U;
     }
 
+    if (config->publish_heartbeat_ms < 1000U) {
+        config->publish_heartbeat_ms = 1000U;
+    } else if (config->publish_heartbeat_ms > 3600000U) {
+        config->publish_heartbeat_ms = 3600000U;
+    }
+
+    if (config->publish_min_interval_ms < 500U) {
+        config->publish_min_interval_ms = 500U;
+    } else if (config->publish_min_interval_ms > config->publish_heartbeat_ms) {
+        config->publish_min_interval_ms = config->publish_heartbeat_ms;
+    }
+
+    if (config->publish_heading_deadband_deg > 180U) {
+        config->publish_heading_deadband_deg = 180U;
+    }
+
+    if (config->track_tolerance_m > 500U) {
+        config->track_tolerance_m = 500U;
+    }
+
     if (config->gps_uart_baud < 1200U || config->gps_uart_baud > 921600U) {
         config->gps_uart_baud = 9600U;
     }
@@ -82,11 +105,33 @@ void akita_config_sanitize(akita_runtime_config_t *config) {
         config->lora_frequency_hz = defaults->lora_frequency_hz;
     }
 
+    if (config->lora_region > AKITA_LORA_REGION_US915) {
+        config->lora_region = AKITA_LORA_REGION_AUTO;
+    }
+
+    if (config->lora_spreading_factor < 7U || config->lora_spreading_factor > 12U) {
+        config->lora_spreading_factor = 7U;
+    }
+
+    if (!akita_airtime_bandwidth_code(config->lora_bandwidth_hz, NULL)) {
+        config->lora_bandwidth_hz = 125000U;
+    }
+
+    if (config->lora_coding_rate < 5U || config->lora_coding_rate > 8U) {
+        config->lora_coding_rate = 5U;
+    }
+
+    if (config->lora_tx_power_dbm < 2) {
+        config->lora_tx_power_dbm = 2;
+    } else if (config->lora_tx_power_dbm > 17) {
+        config->lora_tx_power_dbm = 17;
+    }
+
     if (config->config_http_port == 0U) {
         config->config_http_port = 80U;
     }
 
-    if (config->transport_mode > AKITA_TRANSPORT_LORA) {
+    if (config->transport_mode > AKITA_TRANSPORT_AUTO) {
         config->transport_mode = defaults->has_lora ? AKITA_TRANSPORT_LORA : AKITA_TRANSPORT_WIFI;
     }
 
@@ -99,6 +144,7 @@ void akita_config_sanitize(akita_runtime_config_t *config) {
         config->board_profile = defaults->profile;
         config->gps_tx_pin = defaults->gps_tx_pin;
         config->gps_rx_pin = defaults->gps_rx_pin;
+        config->gps_pps_pin = defaults->gps_pps_pin;
         config->status_led_pin = defaults->status_led_pin;
         config->lora_sck_pin = defaults->lora_sck_pin;
         config->lora_miso_pin = defaults->lora_miso_pin;
@@ -145,7 +191,9 @@ esp_err_t akita_config_load(akita_runtime_config_t *config) {
         return ESP_ERR_NO_MEM;
     }
 
+    AKITA_METRIC_BEGIN(span);
     err = nvs_get_blob(handle, AKITA_CONFIG_KEY, raw, &blob_size);
+    AKITA_METRIC_END(span, AKITA_METRIC_NVS_CONFIG_READ, err == ESP_OK);
     nvs_close(handle);
     if (err != ESP_OK) {
         free(raw);
@@ -182,10 +230,12 @@ esp_err_t akita_config_save(const akita_runtime_config_t *config) {
         return err;
     }
 
+    AKITA_METRIC_BEGIN(span);
     err = nvs_set_blob(handle, AKITA_CONFIG_KEY, &sanitized, sizeof(sanitized));
     if (err == ESP_OK) {
         err = nvs_commit(handle);
     }
+    AKITA_METRIC_END(span, AKITA_METRIC_NVS_CONFIG_WRITE, err == ESP_OK);
 
     nvs_close(handle);
     return err;
@@ -1,18 +1,27 @@
 #include "akita_config_ui.h"
 
-#include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "akita_airtime.h"
 #include "akita_board.h"
+#include "akita_capture_store.h"
 #include "akita_config_store.h"
+#include "akita_form.h"
+#include "akita_metrics.h"
+#include "akita_timeline.h"
 #include "akita_transport.h"
 #include "esp_event.h"
+#include "esp_heap_caps.h"
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_rom_sys.h"
 #include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "sdkconfig.h"
 
 static const char *TAG = "akita_config_ui";
@@ -22,6 +31,12 @@ static bool g_wifi_started;
 static bool g_http_running;
 static akita_config_apply_callback_t g_apply_callback;
 static void *g_apply_callback_context;
+static akita_config_upload_callback_t g_geofence_callback;
+static void *g_geofence_callback_context;
+static akita_config_status_callback_t g_status_callback;
+static void *g_status_callback_context;
+/* The HTTP server runs one handler at a time, so the handlers that answer in chunks can share this. */
+static char g_response_chunk[3072];
 
 static const char kConfigPage[] =
 "<!doctype html>\n"
@@ -68,13 +83,36 @@ static const char kConfigPage[] =
 "          <label>Telemetry interval (ms)<input name=\"telemetry_interval_ms\" type=\"number\" min=\"1000\" max=\"600000\"></label>\n"
 "        </section>\n"
 "        <section class=\"panel\">\n"
+"          <h2>Publish Policy</h2>\n"
+"          <label class=\"checkbox\"><input type=\"checkbox\" name=\"publish_on_change\">Publish on change instead of every telemetry interval</label>\n"
+"          <label>Minimum interval (ms)<input name=\"publish_min_interval_ms\" type=\"number\" min=\"500\" max=\"3600000\"></label>\n"
+"          <label>Heartbeat interval (ms)<input name=\"publish_heartbeat_ms\" type=\"number\" min=\"1000\" max=\"3600000\"></label>\n"
+"          <label>Distance between points (m, 0 = off)<input name=\"publish_distance_m\" type=\"number\" min=\"0\" max=\"65535\"></label>\n"
+"          <label>Heading change (degrees, 0 = off)<input name=\"publish_heading_deadband_deg\" type=\"number\" min=\"0\" max=\"180\"></label>\n"
+"          <label>Speed change (km/h, 0 = off)<input name=\"publish_speed_deadband_kmh\" type=\"number\" min=\"0\" max=\"255\"></label>\n"
+"          <label>RPM change (0 = off)<input name=\"publish_rpm_deadband\" type=\"number\" min=\"0\" max=\"65535\"></label>\n"
+"          <label>Coolant change (C, 0 = off)<input name=\"publish_coolant_deadband_c\" type=\"number\" min=\"0\" max=\"255\"></label>\n"
+"          <label class=\"checkbox\"><input type=\"checkbox\" name=\"aggregate_window\">Send min / mean / max of every field since the last sample</label>\n"
+"          <label class=\"checkbox\"><input type=\"checkbox\" name=\"aggregate_variance\">Include the standard deviation</label>\n"
+"          <label>Track tolerance between samples (m, 0 = off)<input name=\"track_tolerance_m\" type=\"number\" min=\"0\" max=\"500\"></label>\n"
+"          <label class=\"checkbox\"><input type=\"checkbox\" name=\"fusion_enabled\">Fuse GPS with OBD speed and dead-reckon through GPS outages</label>\n"
+"          <label>Event rules<input name=\"event_rules\" maxlength=\"159\" placeholder=\"name=obd.rpm>6000@1000; name=gps.speed_kmh-14\"></label>\n"
+"        </section>\n"
+"        <section class=\"panel\">\n"
 "          <h2>Uplink</h2>\n"
-"          <label>Transport<select name=\"transport_mode\"><option value=\"wifi\">WiFi uplink</option><option value=\"lora\">LoRa uplink</option><option value=\"none\">Local only</option></select></label>\n"
+"          <label>Transport<select name=\"transport_mode\"><option value=\"wifi\">WiFi uplink</option><option value=\"lora\">LoRa uplink</option><option value=\"auto\">WiFi with LoRa failover</option><option value=\"none\">Local only</option></select></label>\n"
 "          <label>WiFi SSID<input name=\"wifi_ssid\" maxlength=\"32\"></label>\n"
 "          <label>WiFi password<input name=\"wifi_password\" type=\"password\" maxlength=\"63\" placeholder=\"leave blank to keep current password\"></label>\n"
 "          <label>Telemetry endpoint<input name=\"telemetry_endpoint\" maxlength=\"95\" placeholder=\"http(s)://host/path, udp://host:port, rns+udp://host:port\"></label>\n"
 "          <label>Reticulum destination<input name=\"reticulum_destination\" maxlength=\"63\" placeholder=\"32 hex chars, or leave empty to broadcast\"></label>\n"
 "          <label>LoRa frequency (Hz)<input name=\"lora_frequency_hz\" type=\"number\" min=\"137000000\" max=\"1020000000\"></label>\n"
+"          <label>LoRa region<select name=\"lora_region\"><option value=\"auto\">Auto from frequency</option><option value=\"eu868\">EU868 duty cycle</option><option value=\"us915\">US915 dwell time</option><option value=\"unrestricted\">Unrestricted</option></select></label>\n"
+"          <label>LoRa spreading factor<input name=\"lora_spreading_factor\" type=\"number\" min=\"7\" max=\"12\"></label>\n"
+"          <label>LoRa bandwidth (Hz)<select name=\"lora_bandwidth_hz\"><option value=\"62500\">62500</option><option value=\"125000\">125000</option><option value=\"250000\">250000</option><option value=\"500000\">500000</option></select></label>\n"
+"          <label>LoRa coding rate (4/x)<input name=\"lora_coding_rate\" type=\"number\" min=\"5\" max=\"8\"></label>\n"
+"          <label>LoRa TX power (dBm)<input name=\"lora_tx_power_dbm\" type=\"number\" min=\"2\" max=\"17\"></label>\n"
+"          <label class=\"checkbox\"><input type=\"checkbox\" name=\"lora_adr_enabled\">Adapt data rate from ACK link margin (multi-SF receiver only)</label>\n"
+"          <label class=\"checkbox\"><input type=\"checkbox\" name=\"lora_gateway_enabled\">Relay LoRa frames from other nodes to the endpoint (WiFi mode)</label>\n"
 "        </section>\n"
 "        <section class=\"panel\">\n"
 "          <h2>Vehicle I/O</h2>\n"
@@ -84,6 +122,7 @@ static const char kConfigPage[] =
 "          <label>OBD characteristic UUID<input name=\"obd_characteristic_uuid\" maxlength=\"39\" placeholder=\"0000ffe1-0000-1000-8000-00805f9b34fb\"></label>\n"
 "          <label>GPS UART RX pin<input name=\"gps_rx_pin\" type=\"number\"></label>\n"
 "          <label>GPS UART TX pin<input name=\"gps_tx_pin\" type=\"number\"></label>\n"
+"          <label>GPS PPS pin (-1 = none)<input name=\"gps_pps_pin\" type=\"number\"></label>\n"
 "          <label>GPS baud<input name=\"gps_uart_baud\" type=\"number\" min=\"1200\" max=\"921600\"></label>\n"
 "          <label class=\"checkbox\"><input type=\"checkbox\" name=\"enable_gps\">Enable GPS reader</label>\n"
 "        </section>\n"
@@ -93,6 +132,14 @@ static const char kConfigPage[] =
 "          <label>WiFi uplink<input name=\"wifi_status_connected\" disabled></label>\n"
 "          <label>WiFi RSSI<input name=\"wifi_status_rssi\" disabled></label>\n"
 "          <label>LoRa radio ready<input name=\"lora_status_ready\" disabled></label>\n"
+"          <label>LoRa airtime last hour (ms used / left)<input name=\"lora_status_airtime\" disabled></label>\n"
+"          <label>LoRa frames deferred / dropped<input name=\"lora_status_scheduler\" disabled></label>\n"
+"          <label>LoRa data rate<input name=\"lora_status_rate\" disabled></label>\n"
+"          <label>LoRa last RX (RSSI / SNR)<input name=\"lora_status_link\" disabled></label>\n"
+"          <label>LoRa gateway (forwarded / duplicates / dropped)<input name=\"gateway_status_counts\" disabled></label>\n"
+"          <label>Active uplink (switchovers)<input name=\"link_status_active\" disabled></label>\n"
+"          <label>WiFi link (sent / failed / latency ms / B/s)<input name=\"link_status_wifi\" disabled></label>\n"
+"          <label>LoRa link (sent / failed / latency ms / B/s)<input name=\"link_status_lora\" disabled></label>\n"
 "          <label>Reticulum bridge ready<input name=\"bridge_status_ready\" disabled></label>\n"
 "          <label>Reticulum bridge mode<input name=\"bridge_status_mode\" disabled></label>\n"
 "          <label>Reticulum last error<input name=\"bridge_status_error\" disabled></label>\n"
@@ -120,6 +167,13 @@ static const char kConfigPage[] =
 "        setFieldValue('wifi_status_connected', data.wifi_connected ? 'yes' : 'no');\n"
 "        setFieldValue('wifi_status_rssi', (data.wifi_rssi === undefined || data.wifi_rssi === null) ? '' : String(data.wifi_rssi));\n"
 "        setFieldValue('lora_status_ready', data.lora_ready ? 'yes' : 'no');\n"
+"        setFieldValue('lora_status_airtime', data.lora_airtime_used_ms + ' / ' + data.lora_airtime_remaining_ms + ' (' + (data.lora_duty_cycle_permille / 10) + '% duty)');\n"
+"        setFieldValue('lora_status_scheduler', data.lora_tx_deferred + ' / ' + data.lora_tx_dropped);\n"
+"        setFieldValue('lora_status_rate', 'SF' + data.lora_spreading_factor + ' / ' + (data.lora_bandwidth_hz / 1000) + ' kHz / ' + data.lora_tx_power_dbm + ' dBm' + (data.lora_adr_enabled ? ' (ADR)' : ''));\n"
+"        setFieldValue('lora_status_link', data.lora_rssi_dbm + ' dBm / ' + (data.lora_snr_quarter_db / 4) + ' dB');\n"
+"        setFieldValue('gateway_status_counts', data.gateway_enabled ? data.gateway_forwarded + ' / ' + data.gateway_duplicates + ' / ' + data.gateway_dropped : 'off');\n"
+"        setFieldValue('link_status_active', data.active_link + ' (' + data.link_switchovers + ')');\n"
+"        ['wifi', 'lora'].forEach(name => { const link = data.links[name]; setFieldValue('link_status_' + name, (link.up ? '' : 'down, ') + link.messages + ' / ' + link.failures + ' / ' + link.latency_ms + ' / ' + link.throughput_bps); });\n"
 "        setFieldValue('bridge_status_ready', data.bridge_ready ? 'yes' : 'no');\n"
 "        setFieldValue('bridge_status_mode', data.bridge_mode || 'inactive');\n"
 "        setFieldValue('bridge_status_error', data.bridge_last_error || '');\n"
@@ -128,6 +182,14 @@ static const char kConfigPage[] =
 "        setFieldValue('wifi_status_connected', 'unknown');\n"
 "        setFieldValue('wifi_status_rssi', 'unknown');\n"
 "        setFieldValue('lora_status_ready', 'unknown');\n"
+"        setFieldValue('lora_status_airtime', 'unknown');\n"
+"        setFieldValue('lora_status_scheduler', 'unknown');\n"
+"        setFieldValue('lora_status_rate', 'unknown');\n"
+"        setFieldValue('lora_status_link', 'unknown');\n"
+"        setFieldValue('gateway_status_counts', 'unknown');\n"
+"        setFieldValue('link_status_active', 'unknown');\n"
+"        setFieldValue('link_status_wifi', 'unknown');\n"
+"        setFieldValue('link_status_lora', 'unknown');\n"
 "        setFieldValue('bridge_status_ready', 'unknown');\n"
 "        setFieldValue('bridge_status_mode', 'unknown');\n"
 "        setFieldValue('bridge_status_error', 'status fetch failed');\n"
@@ -152,113 +214,6 @@ static const char kConfigPage[] =
 "</body>\n"
 "</html>\n";
 
-static void akita_copy_string(char *destination, size_t destination_size, const char *source) {
-    if (destination == NULL || destination_size == 0) {
-        return;
-    }
-
-    snprintf(destination, destination_size, "%s", source != NULL ? source : "");
-}
-
-static void akita_url_decode(char *text) {
-    char *src = text;
-    char *dst = text;
-
-    while (src != NULL && *src != '\0') {
-        if (*src == '+' ) {
-            *dst++ = ' ';
-            ++src;
-        } else if (*src == '%' && isxdigit((unsigned char) src[1]) && isxdigit((unsigned char) src[2])) {
-            char scratch[3] = { src[1], src[2], '\0' };
-            *dst++ = (char) strtol(scratch, NULL, 16);
-            src += 3;
-        } else {
-            *dst++ = *src++;
-        }
-    }
-
-    *dst = '\0';
-}
-
-static bool akita_form_contains(const char *body, const char *key) {
-    size_t key_len;
-    const char *cursor;
-
-    if (body == NULL || key == NULL) {
-        return false;
-    }
-
-    key_len = strlen(key);
-    cursor = body;
-    while ((cursor = strstr(cursor, key)) != NULL) {
-        if ((cursor == body || cursor[-1] == '&') && cursor[key_len] == '=') {
-            return true;
-        }
-        cursor += key_len;
-    }
-
-    return false;
-}
-
-static bool akita_form_get_value(char *body, const char *key, char *output, size_t output_size) {
-    size_t key_len;
-    char *cursor;
-
-    if (body == NULL || key == NULL || output == NULL || output_size == 0) {
-        return false;
-    }
-
-    key_len = strlen(key);
-    cursor = body;
-    while (cursor != NULL && *cursor != '\0') {
-        char *segment_end = strchr(cursor, '&');
-        if (segment_end != NULL) {
-            *segment_end = '\0';
-        }
-
-        if ((strncmp(cursor, key, key_len) == 0) && cursor[key_len] == '=') {
-            akita_copy_string(output, output_size, cursor + key_len + 1);
-            akita_url_decode(output);
-            if (segment_end != NULL) {
-                *segment_end = '&';
-            }
-            return true;
-        }
-
-        if (segment_end != NULL) {
-            *segment_end = '&';
-            cursor = segment_end + 1;
-        } else {
-            cursor = NULL;
-        }
-    }
-
-    output[0] = '\0';
-    return false;
-}
-
-static bool akita_hex_string_is_valid(const char *text) {
-    size_t length;
-    size_t index;
-
-    if (text == NULL || text[0] == '\0') {
-        return true;
-    }
-
-    length = strlen(text);
-    if ((length % 2U) != 0U || length > 64U) {
-        return false;
-    }
-
-    for (index = 0; index < length; ++index) {
-        if (!isxdigit((unsigned char) text[index])) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
 static void akita_json_escape(const char *input, char *output, size_t output_size) {
     size_t used = 0;
 
@@ -292,7 +247,8 @@ static esp_err_t akita_config_json_handler(httpd_req_t *request) {
     char obd_name[96];
     char obd_service_uuid[64];
     char obd_characteristic_uuid[64];
-    char response[1280];
+    char event_rules[320];
+    char response[2560];
 
     akita_config_lock();
     akita_json_escape(g_runtime_config->vehicle_id, vehicle_id, sizeof(vehicle_id));
@@ -302,6 +258,7 @@ static esp_err_t akita_config_json_handler(httpd_req_t *request) {
     akita_json_escape(g_runtime_config->obd_device_name, obd_name, sizeof(obd_name));
     akita_json_escape(g_runtime_config->obd_service_uuid, obd_service_uuid, sizeof(obd_service_uuid));
     akita_json_escape(g_runtime_config->obd_characteristic_uuid, obd_characteristic_uuid, sizeof(obd_characteristic_uuid));
+    akita_json_escape(g_runtime_config->event_rules, event_rules, sizeof(event_rules));
 
     snprintf(
         response,
@@ -310,12 +267,18 @@ static esp_err_t akita_config_json_handler(httpd_req_t *request) {
         "\"wifi_ssid\":\"%s\",\"wifi_password_configured\":%s,\"telemetry_endpoint\":\"%s\","
         "\"reticulum_destination\":\"%s\",\"obd_device_name\":\"%s\","
         "\"use_obd_uuid\":%s,\"obd_service_uuid\":\"%s\",\"obd_characteristic_uuid\":\"%s\","
-        "\"telemetry_interval_ms\":%lu,\"gps_rx_pin\":%ld,\"gps_tx_pin\":%ld,\"gps_uart_baud\":%lu,"
-        "\"enable_gps\":%s,\"lora_frequency_hz\":%lu}",
+        "\"telemetry_interval_ms\":%lu,\"gps_rx_pin\":%ld,\"gps_tx_pin\":%ld,\"gps_pps_pin\":%ld,\"gps_uart_baud\":%lu,"
+        "\"enable_gps\":%s,\"lora_frequency_hz\":%lu,\"lora_region\":\"%s\",\"lora_spreading_factor\":%u,"
+        "\"lora_bandwidth_hz\":%lu,\"lora_coding_rate\":%u,\"lora_tx_power_dbm\":%d,\"lora_adr_enabled\":%s,"
+        "\"lora_gateway_enabled\":%s,\"publish_on_change\":%s,\"publish_min_interval_ms\":%lu,"
+        "\"publish_heartbeat_ms\":%lu,\"publish_distance_m\":%u,\"publish_heading_deadband_deg\":%u,"
+        "\"publish_speed_deadband_kmh\":%u,\"publish_rpm_deadband\":%u,\"publish_coolant_deadband_c\":%u,"
+        "\"aggregate_window\":%s,\"aggregate_variance\":%s,\"track_tolerance_m\":%u,\"fusion_enabled\":%s,\"event_rules\":\"%s\"}",
         vehicle_id,
         akita_board_get_name(g_runtime_config->board_profile),
         (g_runtime_config->transport_mode == AKITA_TRANSPORT_LORA) ? "lora" :
-        (g_runtime_config->transport_mode == AKITA_TRANSPORT_WIFI) ? "wifi" : "none",
+        (g_runtime_config->transport_mode == AKITA_TRANSPORT_WIFI) ? "wifi" :
+        (g_runtime_config->transport_mode == AKITA_TRANSPORT_AUTO) ? "auto" : "none",
         wifi_ssid,
         g_runtime_config->wifi_password[0] != '\0' ? "true" : "false",
         endpoint,
@@ -327,9 +290,30 @@ static esp_err_t akita_config_json_handler(httpd_req_t *request) {
         (unsigned long) g_runtime_config->telemetry_interval_ms,
         (long) g_runtime_config->gps_rx_pin,
         (long) g_runtime_config->gps_tx_pin,
+        (long) g_runtime_config->gps_pps_pin,
         (unsigned long) g_runtime_config->gps_uart_baud,
         g_runtime_config->enable_gps ? "true" : "false",
-        (unsigned long) g_runtime_config->lora_frequency_hz
+        (unsigned long) g_runtime_config->lora_frequency_hz,
+        akita_airtime_region_name(g_runtime_config->lora_region),
+        (unsigned) g_runtime_config->lora_spreading_factor,
+        (unsigned long) g_runtime_config->lora_bandwidth_hz,
+        (unsigned) g_runtime_config->lora_coding_rate,
+        (int) g_runtime_config->lora_tx_power_dbm,
+        g_runtime_config->lora_adr_enabled ? "true" : "false",
+        g_runtime_config->lora_gateway_enabled ? "true" : "false",
+        g_runtime_config->publish_on_change ? "true" : "false",
+        (unsigned long) g_runtime_config->publish_min_interval_ms,
+        (unsigned long) g_runtime_config->publish_heartbeat_ms,
+        (unsigned) g_runtime_config->publish_distance_m,
+        (unsigned) g_runtime_config->publish_heading_deadband_deg,
+        (unsigned) g_runtime_config->publish_speed_deadband_kmh,
+        (unsigned) g_runtime_config->publish_rpm_deadband,
+        (unsigned) g_runtime_config->publish_coolant_deadband_c,
+        g_runtime_config->aggregate_window ? "true" : "false",
+        g_runtime_config->aggregate_variance ? "true" : "false",
+        (unsigned) g_runtime_config->track_tolerance_m,
+        g_runtime_config->fusion_enabled ? "true" : "false",
+        event_rules
     );
     akita_config_unlock();
 
@@ -341,9 +325,32 @@ static esp_err_t akita_status_json_handler(httpd_req_t *request) {
     akita_transport_status_t transport_status = {0};
     char bridge_mode[32];
     char bridge_last_error[128];
-    char response[384];
+    char links[AKITA_LINK_COUNT][160];
+    char response[1536];
+    size_t response_len;
+    size_t latency_len;
+    size_t index;
+    esp_err_t err;
 
     akita_transport_get_status(&transport_status);
+    for (index = 0; index < AKITA_LINK_COUNT; ++index) {
+        const akita_link_stats_t *link = &transport_status.links[index];
+
+        snprintf(
+            links[index],
+            sizeof(links[index]),
+            "\"%s\":{\"up\":%s,\"messages\":%lu,\"bytes\":%lu,\"failures\":%lu,\"latency_ms\":%lu,"
+            "\"latency_max_ms\":%lu,\"throughput_bps\":%lu}",
+            akita_link_name((akita_link_id_t) index),
+            link->up ? "true" : "false",
+            (unsigned long) link->messages,
+            (unsigned long) link->bytes,
+            (unsigned long) link->failures,
+            (unsigned long) link->latency_ms,
+            (unsigned long) link->latency_max_ms,
+            (unsigned long) link->throughput_bps
+        );
+    }
     akita_json_escape(transport_status.bridge_mode, bridge_mode, sizeof(bridge_mode));
     akita_json_escape(transport_status.bridge_last_error, bridge_last_error, sizeof(bridge_last_error));
 
@@ -351,23 +358,281 @@ static esp_err_t akita_status_json_handler(httpd_req_t *request) {
         response,
         sizeof(response),
         "{\"transport_ready\":%s,\"wifi_connected\":%s,\"wifi_rssi\":%d,\"lora_ready\":%s,"
+        "\"lora_airtime_used_ms\":%lu,\"lora_airtime_remaining_ms\":%lu,\"lora_duty_cycle_permille\":%u,"
+        "\"lora_tx_deferred\":%lu,\"lora_tx_dropped\":%lu,"
+        "\"lora_spreading_factor\":%u,\"lora_bandwidth_hz\":%lu,\"lora_tx_power_dbm\":%d,\"lora_adr_enabled\":%s,"
+        "\"lora_rssi_dbm\":%d,\"lora_snr_quarter_db\":%d,"
+        "\"gateway_enabled\":%s,\"gateway_forwarded\":%lu,\"gateway_duplicates\":%lu,\"gateway_dropped\":%lu,"
+        "\"gateway_downlinks\":%lu,"
+        "\"active_link\":\"%s\",\"link_switchovers\":%lu,\"links\":{%s,%s},"
         "\"bridge_ready\":%s,\"bridge_mode\":\"%s\",\"bridge_last_error\":\"%s\"}",
         transport_status.transport_ready ? "true" : "false",
         transport_status.wifi_connected ? "true" : "false",
         (int) transport_status.wifi_rssi,
         transport_status.lora_ready ? "true" : "false",
+        (unsigned long) transport_status.lora_airtime_used_ms,
+        (unsigned long) transport_status.lora_airtime_remaining_ms,
+        (unsigned) transport_status.lora_duty_cycle_permille,
+        (unsigned long) transport_status.lora_tx_deferred,
+        (unsigned long) transport_status.lora_tx_dropped,
+        (unsigned) transport_status.lora_spreading_factor,
+        (unsigned long) transport_status.lora_bandwidth_hz,
+        (int) transport_status.lora_tx_power_dbm,
+        transport_status.lora_adr_enabled ? "true" : "false",
+        (int) transport_status.lora_last_link.rssi_dbm,
+        (int) transport_status.lora_last_link.snr_quarter_db,
+        transport_status.gateway_enabled ? "true" : "false",
+        (unsigned long) transport_status.gateway_forwarded,
+        (unsigned long) transport_status.gateway_duplicates,
+        (unsigned long) transport_status.gateway_dropped,
+        (unsigned long) transport_status.gateway_downlinks,
+        akita_link_name(transport_status.active_link),
+        (unsigned long) transport_status.link_switchovers,
+        links[AKITA_LINK_WIFI],
+        links[AKITA_LINK_LORA],
         transport_status.bridge_ready ? "true" : "false",
         bridge_mode,
         bridge_last_error
     );
 
     httpd_resp_set_type(request, "application/json");
-    return httpd_resp_send(request, response, HTTPD_RESP_USE_STRLEN);
+    latency_len = g_status_callback != NULL
+                      ? g_status_callback(g_response_chunk, sizeof(g_response_chunk), g_status_callback_context)
+                      : 0U;
+    response_len = strlen(response);
+    if (latency_len == 0U || response_len == 0U || response[response_len - 1U] != '}') {
+        return httpd_resp_send(request, response, HTTPD_RESP_USE_STRLEN);
+    }
+
+    /* The latency histograms do not fit the stack buffer, so they follow it as a second chunk. */
+    err = httpd_resp_send_chunk(request, response, (ssize_t) (response_len - 1U));
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(request, ",\"latency\":", HTTPD_RESP_USE_STRLEN);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(request, g_response_chunk, (ssize_t) latency_len);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(request, "}", 1);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(request, NULL, 0);
+    }
+    return err;
+}
+
+typedef struct {
+    httpd_req_t *request;
+    size_t used;
+    esp_err_t err;
+} akita_chunk_writer_t;
+
+static void akita_chunk_flush(akita_chunk_writer_t *writer) {
+    if (writer->err == ESP_OK && writer->used > 0U) {
+        writer->err = httpd_resp_send_chunk(writer->request, g_response_chunk, (ssize_t) writer->used);
+    }
+    writer->used = 0;
+}
+
+/* Appends a line, sending what is buffered first when it does not fit; a line longer than the buffer is dropped. */
+static void akita_chunk_printf(akita_chunk_writer_t *writer, const char *format, ...) {
+    va_list args;
+    int written;
+
+    va_start(args, format);
+    written = vsnprintf(g_response_chunk + writer->used, sizeof(g_response_chunk) - writer->used, format, args);
+    va_end(args);
+    if (written >= 0 && (size_t) written < sizeof(g_response_chunk) - writer->used) {
+        writer->used += (size_t) written;
+        return;
+    }
+
+    akita_chunk_flush(writer);
+    va_start(args, format);
+    written = vsnprintf(g_response_chunk, sizeof(g_response_chunk), format, args);
+    va_end(args);
+    writer->used = written >= 0 && (size_t) written < sizeof(g_response_chunk) ? (size_t) written : 0U;
+}
+
+static void akita_metrics_write_tasks(akita_chunk_writer_t *writer) {
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    TaskStatus_t *tasks;
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4U;
+    UBaseType_t count;
+    uint32_t total_runtime = 0;
+    UBaseType_t index;
+
+    tasks = calloc(capacity, sizeof(*tasks));
+    if (tasks == NULL) {
+        return;
+    }
+    count = uxTaskGetSystemState(tasks, capacity, &total_runtime);
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    /* The run time counter is in microseconds and 32 bits wide, so it wraps about every 71 minutes. */
+    akita_chunk_printf(writer,
+                       "# HELP akita_task_cpu_seconds_total CPU time a FreeRTOS task has run for.\n"
+                       "# TYPE akita_task_cpu_seconds_total counter\n");
+    for (index = 0; index < count; ++index) {
+        akita_chunk_printf(writer, "akita_task_cpu_seconds_total{task=\"%s\"} %.6f\n", tasks[index].pcTaskName,
+                           (double) tasks[index].ulRunTimeCounter / 1e6);
+    }
+#endif
+    akita_chunk_printf(writer,
+                       "# HELP akita_task_stack_free_min_bytes Least free stack a FreeRTOS task has had.\n"
+                       "# TYPE akita_task_stack_free_min_bytes gauge\n");
+    for (index = 0; index < count; ++index) {
+        akita_chunk_printf(writer, "akita_task_stack_free_min_bytes{task=\"%s\"} %lu\n", tasks[index].pcTaskName,
+                           (unsigned long) (tasks[index].usStackHighWaterMark * sizeof(StackType_t)));
+    }
+    free(tasks);
+#else
+    (void) writer;
+#endif
+}
+
+static void akita_metrics_write_ops(akita_chunk_writer_t *writer) {
+#if CONFIG_AKITA_METRICS
+    akita_metric_stats_t *stats;
+    uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    size_t part;
+    size_t length;
+
+    stats = malloc(sizeof(*stats) * AKITA_METRIC_COUNT);
+    if (stats == NULL) {
+        return;
+    }
+    akita_metrics_snapshot(stats);
+
+    for (part = 0; part <= AKITA_METRIC_COUNT && writer->err == ESP_OK; ++part) {
+        length = akita_metrics_write_prometheus(stats, part, cycles_per_us, g_response_chunk + writer->used,
+                                                sizeof(g_response_chunk) - writer->used);
+        if (length == 0U) {
+            akita_chunk_flush(writer);
+            length = akita_metrics_write_prometheus(stats, part, cycles_per_us, g_response_chunk, sizeof(g_response_chunk));
+        }
+        writer->used += length;
+    }
+    free(stats);
+#else
+    (void) writer;
+#endif
+}
+
+static esp_err_t akita_metrics_handler(httpd_req_t *request) {
+    akita_chunk_writer_t writer = {.request = request, .used = 0, .err = ESP_OK};
+
+    httpd_resp_set_type(request, "text/plain; version=0.0.4");
+    akita_metrics_write_ops(&writer);
+    akita_chunk_printf(&writer,
+                       "# HELP akita_heap_free_bytes Free 8 bit capable heap.\n"
+                       "# TYPE akita_heap_free_bytes gauge\n"
+                       "akita_heap_free_bytes %lu\n"
+                       "# HELP akita_heap_free_min_bytes Least free 8 bit capable heap since boot.\n"
+                       "# TYPE akita_heap_free_min_bytes gauge\n"
+                       "akita_heap_free_min_bytes %lu\n",
+                       (unsigned long) heap_caps_get_free_size(MALLOC_CAP_8BIT),
+                       (unsigned long) heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    akita_metrics_write_tasks(&writer);
+    akita_chunk_flush(&writer);
+    if (writer.err != ESP_OK) {
+        return writer.err;
+    }
+
+    return httpd_resp_send_chunk(request, NULL, 0);
+}
+
+#if CONFIG_AKITA_TIMELINE
+static bool akita_trace_write_chunk(const void *data, size_t size, void *context) {
+    return httpd_resp_send_chunk((httpd_req_t *) context, data, (ssize_t) size) == ESP_OK;
+}
+
+static esp_err_t akita_trace_get_handler(httpd_req_t *request) {
+    httpd_resp_set_type(request, "application/octet-stream");
+    httpd_resp_set_hdr(request, "Content-Disposition", "attachment; filename=\"akita-timeline.bin\"");
+    if (!akita_timeline_dump(akita_trace_write_chunk, request)) {
+        return ESP_FAIL;
+    }
+
+    return httpd_resp_send_chunk(request, NULL, 0);
+}
+
+static esp_err_t akita_trace_post_handler(httpd_req_t *request) {
+    char query[64];
+    char action[16];
+
+    if (httpd_req_get_url_query_str(request, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "action", action, sizeof(action)) != ESP_OK) {
+        return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Expected ?action=arm or ?action=trigger");
+    }
+
+    httpd_resp_set_type(request, "text/plain");
+    if (strcmp(action, "arm") == 0) {
+        akita_timeline_rearm();
+        return httpd_resp_sendstr(request, "Timeline recording.");
+    }
+    if (strcmp(action, "trigger") == 0) {
+        AKITA_TIMELINE_TRIGGER(AKITA_TIMELINE_MANUAL_TRIGGER, 0);
+        return httpd_resp_sendstr(request, "Timeline freezes shortly.");
+    }
+
+    return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Expected ?action=arm or ?action=trigger");
+}
+#endif
+
+#if CONFIG_AKITA_CAPTURE
+static bool akita_capture_write_chunk(const void *data, size_t size, void *context) {
+    return httpd_resp_send_chunk((httpd_req_t *) context, data, (ssize_t) size) == ESP_OK;
+}
+
+static esp_err_t akita_capture_get_handler(httpd_req_t *request) {
+    esp_err_t err;
+
+    httpd_resp_set_type(request, "application/octet-stream");
+    httpd_resp_set_hdr(request, "Content-Disposition", "attachment; filename=\"akita-capture.bin\"");
+    err = akita_capture_store_read(akita_capture_write_chunk, request);
+    if (err == ESP_ERR_NOT_FOUND) {
+        return httpd_resp_send_err(request, HTTPD_404_NOT_FOUND, "No capture recorded");
+    }
+    if (err != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    return httpd_resp_send_chunk(request, NULL, 0);
+}
+
+static esp_err_t akita_capture_post_handler(httpd_req_t *request) {
+    char query[64];
+    char action[16];
+    char response[96];
+    esp_err_t err;
+
+    if (httpd_req_get_url_query_str(request, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "action", action, sizeof(action)) != ESP_OK) {
+        return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Expected ?action=start or ?action=stop");
+    }
+
+    httpd_resp_set_type(request, "text/plain");
+    if (strcmp(action, "start") == 0) {
+        err = akita_capture_store_start(g_runtime_config->gps_uart_baud);
+        if (err != ESP_OK) {
+            snprintf(response, sizeof(response), "Capture not started: %s", esp_err_to_name(err));
+            return httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, response);
+        }
+        return httpd_resp_sendstr(request, "Capture recording.");
+    }
+    if (strcmp(action, "stop") == 0) {
+        akita_capture_store_stop();
+        snprintf(response, sizeof(response), "Capture stopped; %lu records dropped.", (unsigned long) akita_capture_dropped());
+        return httpd_resp_sendstr(request, response);
+    }
+
+    return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Expected ?action=start or ?action=stop");
 }
+#endif
 
 static esp_err_t akita_config_post_handler(httpd_req_t *request) {
     char body[2048];
-    char scratch[128];
     char response[192];
     esp_err_t save_err;
     esp_err_t apply_err = ESP_OK;
@@ -392,61 +657,10 @@ static esp_err_t akita_config_post_handler(httpd_req_t *request) {
     body[received] = '\0';
 
     akita_config_lock();
-    if (akita_form_get_value(body, "vehicle_id", scratch, sizeof(scratch))) {
-        akita_copy_string(g_runtime_config->vehicle_id, sizeof(g_runtime_config->vehicle_id), scratch);
-    }
-    if (akita_form_get_value(body, "wifi_ssid", scratch, sizeof(scratch))) {
-        akita_copy_string(g_runtime_config->wifi_ssid, sizeof(g_runtime_config->wifi_ssid), scratch);
-    }
-    if (akita_form_get_value(body, "wifi_password", scratch, sizeof(scratch)) && scratch[0] != '\0') {
-        akita_copy_string(g_runtime_config->wifi_password, sizeof(g_runtime_config->wifi_password), scratch);
-    }
-    if (akita_form_get_value(body, "telemetry_endpoint", scratch, sizeof(scratch))) {
-        akita_copy_string(g_runtime_config->telemetry_endpoint, sizeof(g_runtime_config->telemetry_endpoint), scratch);
-    }
-    if (akita_form_get_value(body, "reticulum_destination", scratch, sizeof(scratch))) {
-        if (!akita_hex_string_is_valid(scratch)) {
-            akita_config_unlock();
-            return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Reticulum destination must be hexadecimal");
-        }
-        akita_copy_string(g_runtime_config->reticulum_destination, sizeof(g_runtime_config->reticulum_destination), scratch);
-    }
-    if (akita_form_get_value(body, "obd_device_name", scratch, sizeof(scratch))) {
-        akita_copy_string(g_runtime_config->obd_device_name, sizeof(g_runtime_config->obd_device_name), scratch);
+    if (akita_form_apply_config(body, g_runtime_config) != ESP_OK) {
+        akita_config_unlock();
+        return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Reticulum destination must be hexadecimal");
     }
-    if (akita_form_get_value(body, "obd_service_uuid", scratch, sizeof(scratch))) {
-        akita_copy_string(g_runtime_config->obd_service_uuid, sizeof(g_runtime_config->obd_service_uuid), scratch);
-    }
-    if (akita_form_get_value(body, "obd_characteristic_uuid", scratch, sizeof(scratch))) {
-        akita_copy_string(g_runtime_config->obd_characteristic_uuid, sizeof(g_runtime_config->obd_characteristic_uuid), scratch);
-    }
-    if (akita_form_get_value(body, "telemetry_interval_ms", scratch, sizeof(scratch))) {
-        g_runtime_config->telemetry_interval_ms = (uint32_t) strtoul(scratch, NULL, 10);
-    }
-    if (akita_form_get_value(body, "gps_rx_pin", scratch, sizeof(scratch))) {
-        g_runtime_config->gps_rx_pin = (int32_t) strtol(scratch, NULL, 10);
-    }
-    if (akita_form_get_value(body, "gps_tx_pin", scratch, sizeof(scratch))) {
-        g_runtime_config->gps_tx_pin = (int32_t) strtol(scratch, NULL, 10);
-    }
-    if (akita_form_get_value(body, "gps_uart_baud", scratch, sizeof(scratch))) {
-        g_runtime_config->gps_uart_baud = (uint32_t) strtoul(scratch, NULL, 10);
-    }
-    if (akita_form_get_value(body, "lora_frequency_hz", scratch, sizeof(scratch))) {
-        g_runtime_config->lora_frequency_hz = (uint32_t) strtoul(scratch, NULL, 10);
-    }
-    if (akita_form_get_value(body, "transport_mode", scratch, sizeof(scratch))) {
-        if (strcmp(scratch, "lora") == 0) {
-            g_runtime_config->transport_mode = AKITA_TRANSPORT_LORA;
-        } else if (strcmp(scratch, "wifi") == 0) {
-            g_runtime_config->transport_mode = AKITA_TRANSPORT_WIFI;
-        } else {
-            g_runtime_config->transport_mode = AKITA_TRANSPORT_NONE;
-        }
-    }
-
-    g_runtime_config->enable_gps = akita_form_contains(body, "enable_gps");
-    g_runtime_config->use_obd_uuid = akita_form_contains(body, "use_obd_uuid");
     akita_config_sanitize(g_runtime_config);
     save_err = akita_config_save(g_runtime_config);
     akita_config_unlock();
@@ -470,6 +684,41 @@ static esp_err_t akita_config_post_handler(httpd_req_t *request) {
     return httpd_resp_sendstr(request, response);
 }
 
+static esp_err_t akita_geofence_post_handler(httpd_req_t *request) {
+    char chunk[1024];
+    char response[96];
+    size_t total;
+    size_t offset = 0;
+    esp_err_t err = ESP_OK;
+
+    if (g_geofence_callback == NULL) {
+        return httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "Geofences are not available");
+    }
+    if (request->content_len <= 0) {
+        return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Geofence image missing");
+    }
+
+    /* The image is larger than the handler stack, so it is passed on a chunk at a time. */
+    total = (size_t) request->content_len;
+    while (offset < total && err == ESP_OK) {
+        int received = httpd_req_recv(request, chunk, total - offset < sizeof(chunk) ? total - offset : sizeof(chunk));
+
+        if (received <= 0) {
+            return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, "Geofence image truncated");
+        }
+        err = g_geofence_callback(offset, chunk, (size_t) received, total, g_geofence_callback_context);
+        offset += (size_t) received;
+    }
+
+    if (err != ESP_OK) {
+        snprintf(response, sizeof(response), "Geofence image rejected: %s", esp_err_to_name(err));
+        return httpd_resp_send_err(request, HTTPD_400_BAD_REQUEST, response);
+    }
+
+    httpd_resp_set_type(request, "text/plain");
+    return httpd_resp_sendstr(request, "Geofences saved and loaded.");
+}
+
 static esp_err_t akita_config_ui_start_wifi(const akita_runtime_config_t *config) {
     wifi_init_config_t init_config = WIFI_INIT_CONFIG_DEFAULT();
     wifi_config_t wifi_config = { 0 };
@@ -562,6 +811,46 @@ esp_err_t akita_config_ui_start(akita_runtime_config_t *config) {
         .handler = akita_status_json_handler,
         .user_ctx = NULL,
     };
+    httpd_uri_t api_geofence_uri = {
+        .uri = "/api/geofences",
+        .method = HTTP_POST,
+        .handler = akita_geofence_post_handler,
+        .user_ctx = NULL,
+    };
+    httpd_uri_t metrics_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = akita_metrics_handler,
+        .user_ctx = NULL,
+    };
+#if CONFIG_AKITA_TIMELINE
+    httpd_uri_t api_trace_get_uri = {
+        .uri = "/api/trace",
+        .method = HTTP_GET,
+        .handler = akita_trace_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_uri_t api_trace_post_uri = {
+        .uri = "/api/trace",
+        .method = HTTP_POST,
+        .handler = akita_trace_post_handler,
+        .user_ctx = NULL,
+    };
+#endif
+#if CONFIG_AKITA_CAPTURE
+    httpd_uri_t api_capture_get_uri = {
+        .uri = "/api/capture",
+        .method = HTTP_GET,
+        .handler = akita_capture_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_uri_t api_capture_post_uri = {
+        .uri = "/api/capture",
+        .method = HTTP_POST,
+        .handler = akita_capture_post_handler,
+        .user_ctx = NULL,
+    };
+#endif
 
     if (config == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -578,6 +867,10 @@ esp_err_t akita_config_ui_start(akita_runtime_config_t *config) {
     }
 
     server_config.server_port = config->config_http_port;
+    /* The config handlers keep the JSON response and the form body on the stack. */
+    server_config.stack_size = 8192;
+    /* The default of eight handlers runs out once the trace and capture endpoints are built in. */
+    server_config.max_uri_handlers = 12;
     err = httpd_start(&g_httpd_handle, &server_config);
     if (err != ESP_OK) {
         return err;
@@ -593,6 +886,28 @@ esp_err_t akita_config_ui_start(akita_runtime_config_t *config) {
     if (err == ESP_OK) {
         err = httpd_register_uri_handler(g_httpd_handle, &api_status_uri);
     }
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(g_httpd_handle, &api_geofence_uri);
+    }
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(g_httpd_handle, &metrics_uri);
+    }
+#if CONFIG_AKITA_TIMELINE
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(g_httpd_handle, &api_trace_get_uri);
+    }
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(g_httpd_handle, &api_trace_post_uri);
+    }
+#endif
+#if CONFIG_AKITA_CAPTURE
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(g_httpd_handle, &api_capture_get_uri);
+    }
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(g_httpd_handle, &api_capture_post_uri);
+    }
+#endif
     if (err != ESP_OK) {
         httpd_stop(g_httpd_handle);
         g_httpd_handle = NULL;
@@ -608,6 +923,16 @@ void akita_config_ui_set_apply_callback(akita_config_apply_callback_t callback,
     g_apply_callback_context = context;
 }
 
+void akita_config_ui_set_geofence_callback(akita_config_upload_callback_t callback, void *context) {
+    g_geofence_callback = callback;
+    g_geofence_callback_context = context;
+}
+
+void akita_config_ui_set_status_callback(akita_config_status_callback_t callback, void *context) {
+    g_status_callback = callback;
+    g_status_callback_context = context;
+}
+
 bool akita_config_ui_is_running(void) {
     return g_http_running;
 }
\ No newline at end of file
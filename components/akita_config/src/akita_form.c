@@ -0,0 +1,237 @@
+#include "akita_form.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void akita_form_url_decode(char *text) {
+    char *src = text;
+    char *dst = text;
+
+    while (src != NULL && *src != '\0') {
+        if (*src == '+') {
+            *dst++ = ' ';
+            ++src;
+        } else if (*src == '%' && isxdigit((unsigned char) src[1]) && isxdigit((unsigned char) src[2])) {
+            char scratch[3] = { src[1], src[2], '\0' };
+            *dst++ = (char) strtol(scratch, NULL, 16);
+            src += 3;
+        } else {
+            *dst++ = *src++;
+        }
+    }
+
+    *dst = '\0';
+}
+
+bool akita_form_contains(const char *body, const char *key) {
+    size_t key_len;
+    const char *cursor;
+
+    if (body == NULL || key == NULL) {
+        return false;
+    }
+
+    key_len = strlen(key);
+    cursor = body;
+    while ((cursor = strstr(cursor, key)) != NULL) {
+        if ((cursor == body || cursor[-1] == '&') && cursor[key_len] == '=') {
+            return true;
+        }
+        cursor += key_len;
+    }
+
+    return false;
+}
+
+bool akita_form_get_value(char *body, const char *key, char *output, size_t output_size) {
+    size_t key_len;
+    char *cursor;
+
+    if (body == NULL || key == NULL || output == NULL || output_size == 0) {
+        return false;
+    }
+
+    key_len = strlen(key);
+    cursor = body;
+    while (cursor != NULL && *cursor != '\0') {
+        char *segment_end = strchr(cursor, '&');
+        if (segment_end != NULL) {
+            *segment_end = '\0';
+        }
+
+        if ((strncmp(cursor, key, key_len) == 0) && cursor[key_len] == '=') {
+            snprintf(output, output_size, "%s", cursor + key_len + 1);
+            akita_form_url_decode(output);
+            if (segment_end != NULL) {
+                *segment_end = '&';
+            }
+            return true;
+        }
+
+        if (segment_end != NULL) {
+            *segment_end = '&';
+            cursor = segment_end + 1;
+        } else {
+            cursor = NULL;
+        }
+    }
+
+    output[0] = '\0';
+    return false;
+}
+
+static void akita_form_copy(char *destination, size_t destination_size, const char *source) {
+    size_t length = strlen(source);
+
+    if (length >= destination_size) {
+        length = destination_size - 1U;
+    }
+    memcpy(destination, source, length);
+    destination[length] = '\0';
+}
+
+static bool akita_form_hex_is_valid(const char *text) {
+    size_t length;
+    size_t index;
+
+    if (text == NULL || text[0] == '\0') {
+        return true;
+    }
+
+    length = strlen(text);
+    if ((length % 2U) != 0U || length > 64U) {
+        return false;
+    }
+
+    for (index = 0; index < length; ++index) {
+        if (!isxdigit((unsigned char) text[index])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+esp_err_t akita_form_apply_config(char *body, akita_runtime_config_t *config) {
+    char scratch[192];
+
+    /* Rejected before anything is applied, so a bad post leaves the config as it was. */
+    if (akita_form_get_value(body, "reticulum_destination", scratch, sizeof(scratch)) && !akita_form_hex_is_valid(scratch)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (akita_form_get_value(body, "vehicle_id", scratch, sizeof(scratch))) {
+        akita_form_copy(config->vehicle_id, sizeof(config->vehicle_id), scratch);
+    }
+    if (akita_form_get_value(body, "wifi_ssid", scratch, sizeof(scratch))) {
+        akita_form_copy(config->wifi_ssid, sizeof(config->wifi_ssid), scratch);
+    }
+    if (akita_form_get_value(body, "wifi_password", scratch, sizeof(scratch)) && scratch[0] != '\0') {
+        akita_form_copy(config->wifi_password, sizeof(config->wifi_password), scratch);
+    }
+    if (akita_form_get_value(body, "telemetry_endpoint", scratch, sizeof(scratch))) {
+        akita_form_copy(config->telemetry_endpoint, sizeof(config->telemetry_endpoint), scratch);
+    }
+    if (akita_form_get_value(body, "reticulum_destination", scratch, sizeof(scratch))) {
+        akita_form_copy(config->reticulum_destination, sizeof(config->reticulum_destination), scratch);
+    }
+    if (akita_form_get_value(body, "obd_device_name", scratch, sizeof(scratch))) {
+        akita_form_copy(config->obd_device_name, sizeof(config->obd_device_name), scratch);
+    }
+    if (akita_form_get_value(body, "obd_service_uuid", scratch, sizeof(scratch))) {
+        akita_form_copy(config->obd_service_uuid, sizeof(config->obd_service_uuid), scratch);
+    }
+    if (akita_form_get_value(body, "obd_characteristic_uuid", scratch, sizeof(scratch))) {
+        akita_form_copy(config->obd_characteristic_uuid, sizeof(config->obd_characteristic_uuid), scratch);
+    }
+    if (akita_form_get_value(body, "telemetry_interval_ms", scratch, sizeof(scratch))) {
+        config->telemetry_interval_ms = (uint32_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_min_interval_ms", scratch, sizeof(scratch))) {
+        config->publish_min_interval_ms = (uint32_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_heartbeat_ms", scratch, sizeof(scratch))) {
+        config->publish_heartbeat_ms = (uint32_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_distance_m", scratch, sizeof(scratch))) {
+        config->publish_distance_m = (uint16_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_heading_deadband_deg", scratch, sizeof(scratch))) {
+        config->publish_heading_deadband_deg = (uint8_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_speed_deadband_kmh", scratch, sizeof(scratch))) {
+        config->publish_speed_deadband_kmh = (uint8_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_rpm_deadband", scratch, sizeof(scratch))) {
+        config->publish_rpm_deadband = (uint16_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "publish_coolant_deadband_c", scratch, sizeof(scratch))) {
+        config->publish_coolant_deadband_c = (uint8_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "track_tolerance_m", scratch, sizeof(scratch))) {
+        config->track_tolerance_m = (uint16_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "event_rules", scratch, sizeof(scratch))) {
+        akita_form_copy(config->event_rules, sizeof(config->event_rules), scratch);
+    }
+    if (akita_form_get_value(body, "gps_rx_pin", scratch, sizeof(scratch))) {
+        config->gps_rx_pin = (int32_t) strtol(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "gps_tx_pin", scratch, sizeof(scratch))) {
+        config->gps_tx_pin = (int32_t) strtol(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "gps_pps_pin", scratch, sizeof(scratch))) {
+        config->gps_pps_pin = (int32_t) strtol(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "gps_uart_baud", scratch, sizeof(scratch))) {
+        config->gps_uart_baud = (uint32_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "lora_frequency_hz", scratch, sizeof(scratch))) {
+        config->lora_frequency_hz = (uint32_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "lora_region", scratch, sizeof(scratch))) {
+        if (strcmp(scratch, "eu868") == 0) {
+            config->lora_region = AKITA_LORA_REGION_EU868;
+        } else if (strcmp(scratch, "us915") == 0) {
+            config->lora_region = AKITA_LORA_REGION_US915;
+        } else if (strcmp(scratch, "unrestricted") == 0) {
+            config->lora_region = AKITA_LORA_REGION_UNRESTRICTED;
+        } else {
+            config->lora_region = AKITA_LORA_REGION_AUTO;
+        }
+    }
+    if (akita_form_get_value(body, "lora_spreading_factor", scratch, sizeof(scratch))) {
+        config->lora_spreading_factor = (uint8_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "lora_bandwidth_hz", scratch, sizeof(scratch))) {
+        config->lora_bandwidth_hz = (uint32_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "lora_coding_rate", scratch, sizeof(scratch))) {
+        config->lora_coding_rate = (uint8_t) strtoul(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "lora_tx_power_dbm", scratch, sizeof(scratch))) {
+        config->lora_tx_power_dbm = (int8_t) strtol(scratch, NULL, 10);
+    }
+    if (akita_form_get_value(body, "transport_mode", scratch, sizeof(scratch))) {
+        if (strcmp(scratch, "lora") == 0) {
+            config->transport_mode = AKITA_TRANSPORT_LORA;
+        } else if (strcmp(scratch, "wifi") == 0) {
+            config->transport_mode = AKITA_TRANSPORT_WIFI;
+        } else if (strcmp(scratch, "auto") == 0) {
+            config->transport_mode = AKITA_TRANSPORT_AUTO;
+        } else {
+            config->transport_mode = AKITA_TRANSPORT_NONE;
+        }
+    }
+
+    config->enable_gps = akita_form_contains(body, "enable_gps");
+    config->lora_adr_enabled = akita_form_contains(body, "lora_adr_enabled");
+    config->lora_gateway_enabled = akita_form_contains(body, "lora_gateway_enabled");
+    config->publish_on_change = akita_form_contains(body, "publish_on_change");
+    config->aggregate_window = akita_form_contains(body, "aggregate_window");
+    config->aggregate_variance = akita_form_contains(body, "aggregate_variance");
+    config->fusion_enabled = akita_form_contains(body, "fusion_enabled");
+    config->use_obd_uuid = akita_form_contains(body, "use_obd_uuid");
+    return ESP_OK;
+}
@@ -0,0 +1,27 @@
+#include "akita_config_ui.h"
+
+/* The portal needs the SoftAP and the ESP HTTP server; on the Linux target configuration comes from NVS only. */
+
+esp_err_t akita_config_ui_start(akita_runtime_config_t *config) {
+    (void) config;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void akita_config_ui_set_apply_callback(akita_config_apply_callback_t callback, void *context) {
+    (void) callback;
+    (void) context;
+}
+
+void akita_config_ui_set_geofence_callback(akita_config_upload_callback_t callback, void *context) {
+    (void) callback;
+    (void) context;
+}
+
+void akita_config_ui_set_status_callback(akita_config_status_callback_t callback, void *context) {
+    (void) callback;
+    (void) context;
+}
+
+bool akita_config_ui_is_running(void) {
+    return false;
+}
@@ -0,0 +1,61 @@
+#ifndef AKITA_AGGREGATE_H
+#define AKITA_AGGREGATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_telemetry_schema.h"
+#include "akita_types.h"
+
+/* Every numeric schema field is aggregated; flags are not. */
+#define AKITA_AGGREGATE_ENUM_BOOL(id)
+#define AKITA_AGGREGATE_ENUM_FIXED(id) AKITA_AGGREGATE_FIELD_##id,
+#define AKITA_AGGREGATE_ENUM_UINT(id) AKITA_AGGREGATE_FIELD_##id,
+#define AKITA_AGGREGATE_ENUM_INT(id) AKITA_AGGREGATE_FIELD_##id,
+#define AKITA_AGGREGATE_ENUM(group, id, name, short_key, type, decimals, frame, member) AKITA_AGGREGATE_ENUM_##type(id)
+
+typedef enum {
+    AKITA_TELEMETRY_FIELDS(AKITA_AGGREGATE_ENUM)
+    AKITA_AGGREGATE_FIELD_COUNT,
+} akita_aggregate_field_id_t;
+
+typedef enum {
+    AKITA_AGGREGATE_GROUP_OBD = 0,
+    AKITA_AGGREGATE_GROUP_GPS,
+    AKITA_AGGREGATE_GROUP_SYSTEM,
+    AKITA_AGGREGATE_GROUP_COUNT,
+} akita_aggregate_group_t;
+
+typedef struct {
+    /* First sample of the window; sums are kept relative to it so float accumulators stay precise. */
+    float shift;
+    float min;
+    float max;
+    float sum;
+    float sum_sq;
+} akita_aggregate_field_t;
+
+typedef struct {
+    uint64_t start_ms;
+    uint32_t count[AKITA_AGGREGATE_GROUP_COUNT];
+    akita_aggregate_field_t fields[AKITA_AGGREGATE_FIELD_COUNT];
+} akita_aggregate_t;
+
+typedef struct {
+    float min;
+    float mean;
+    float max;
+    float stddev;
+} akita_aggregate_value_t;
+
+typedef struct {
+    uint32_t window_ms;
+    uint16_t count[AKITA_AGGREGATE_GROUP_COUNT];
+    akita_aggregate_value_t fields[AKITA_AGGREGATE_FIELD_COUNT];
+} akita_aggregate_summary_t;
+
+void akita_aggregate_reset(akita_aggregate_t *aggregate, uint64_t now_ms);
+void akita_aggregate_add(akita_aggregate_t *aggregate, const akita_vehicle_telemetry_t *telemetry);
+void akita_aggregate_summarize(const akita_aggregate_t *aggregate, uint64_t now_ms, akita_aggregate_summary_t *summary);
+
+#endif
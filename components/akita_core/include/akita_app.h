@@ -2,7 +2,10 @@
 #define AKITA_APP_H
 
 #include <stddef.h>
+#include <stdint.h>
 
+#include "akita_outbox.h"
+#include "akita_trip.h"
 #include "akita_types.h"
 #include "esp_err.h"
 
@@ -15,6 +18,19 @@ size_t akita_payload_write_json(
     char *buffer,
     size_t buffer_size
 );
+size_t akita_payload_write_message_json(
+    const akita_runtime_config_t *config,
+    const akita_outbox_message_t *message,
+    char *buffer,
+    size_t buffer_size
+);
+size_t akita_payload_write_trip_json(
+    const akita_runtime_config_t *config,
+    const akita_trip_record_t *trip,
+    uint64_t timestamp_ms,
+    char *buffer,
+    size_t buffer_size
+);
 size_t akita_payload_write_compact_json(
     const akita_runtime_config_t *config,
     const akita_vehicle_telemetry_t *telemetry,
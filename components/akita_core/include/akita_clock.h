@@ -0,0 +1,61 @@
+#ifndef AKITA_CLOCK_H
+#define AKITA_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* GPS times per offset estimate; the least delayed one in each window is used. */
+#define AKITA_CLOCK_NMEA_WINDOW 16U
+#define AKITA_CLOCK_PPS_WINDOW 4U
+/* PPS estimates this far apart give the oscillator drift. NMEA arrival times, read on the 100 ms poll, are too coarse for it. */
+#define AKITA_CLOCK_RATE_SPAN_US 64000000ULL
+/* A disagreement larger than this steps the clock instead of slewing it. */
+#define AKITA_CLOCK_STEP_US 500000
+#define AKITA_CLOCK_MAX_DRIFT_PPB 500000
+/* Error at the last correction: receiver output latency plus the poll for NMEA, interrupt latency for PPS. */
+#define AKITA_CLOCK_NMEA_ERROR_US 200000U
+#define AKITA_CLOCK_PPS_ERROR_US 50U
+/* How fast the error grows between corrections, with and without a drift estimate. */
+#define AKITA_CLOCK_HOLDOVER_PPB 5000U
+#define AKITA_CLOCK_FREE_RUN_PPB 50000U
+
+typedef enum {
+    AKITA_CLOCK_NONE = 0,
+    AKITA_CLOCK_NMEA,
+    AKITA_CLOCK_PPS,
+} akita_clock_source_t;
+
+typedef struct {
+    akita_clock_source_t source;
+    /* UTC minus monotonic time at ref_us, in microseconds, and how fast that changes. */
+    int64_t offset_us;
+    uint64_t ref_us;
+    int32_t drift_ppb;
+    bool has_drift;
+    /* Earlier PPS estimate the drift is measured against. */
+    int64_t anchor_offset_us;
+    uint64_t anchor_us;
+    int64_t last_utc_ms;
+    akita_clock_source_t window_source;
+    uint8_t window_count;
+    int64_t window_score_us;
+    int64_t window_offset_us;
+    uint64_t window_at_us;
+    uint32_t samples;
+    uint32_t steps;
+} akita_clock_t;
+
+void akita_clock_init(akita_clock_t *clock);
+/*
+ * One GPS time: utc_ms from an RMC or ZDA sentence read at received_us. pps_us is the last PPS edge,
+ * 0 without one; an edge in the second before a whole-second sentence marks the start of that second.
+ */
+void akita_clock_gps(akita_clock_t *clock, int64_t utc_ms, uint64_t received_us, uint64_t pps_us);
+bool akita_clock_is_set(const akita_clock_t *clock);
+/* UTC minus monotonic time at mono_us; 0 while the clock is not set. */
+int64_t akita_clock_offset_us(const akita_clock_t *clock, uint64_t mono_us);
+bool akita_clock_utc_ms(const akita_clock_t *clock, uint64_t mono_us, int64_t *utc_ms);
+uint32_t akita_clock_error_us(const akita_clock_t *clock, uint64_t mono_us);
+const char *akita_clock_source_name(akita_clock_source_t source);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef AKITA_FRAGMENT_H
+#define AKITA_FRAGMENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_frame.h"
+#include "akita_types.h"
+
+#define AKITA_FRAGMENT_HEADER_LEN (AKITA_FRAME_HEADER_LEN + 2U)
+#define AKITA_FRAGMENT_NACK_LEN (AKITA_FRAME_HEADER_LEN + 2U)
+#define AKITA_FRAGMENT_MAX_COUNT 16U
+#define AKITA_FRAGMENT_MAX_MESSAGE_LEN 1024U
+#define AKITA_FRAGMENT_RETAIN_MESSAGES 2U
+#define AKITA_FRAGMENT_RETAIN_MS 30000U
+
+typedef struct {
+    bool in_use;
+    uint16_t node_tag;
+    uint8_t message_id;
+    uint8_t count;
+    uint8_t chunk_len;
+    akita_message_class_t message_class;
+    uint16_t pending_mask;
+    uint16_t length;
+    uint64_t created_ms;
+    uint8_t data[AKITA_FRAGMENT_MAX_MESSAGE_LEN];
+} akita_fragment_message_t;
+
+typedef struct {
+    akita_fragment_message_t messages[AKITA_FRAGMENT_RETAIN_MESSAGES];
+    uint8_t next_message_id;
+    uint8_t next_slot;
+    uint32_t nacks_accepted;
+    uint32_t nacks_ignored;
+    uint32_t fragments_resent;
+} akita_fragment_sender_t;
+
+size_t akita_fragment_count(size_t payload_len, size_t max_frame_len);
+
+void akita_fragment_sender_init(akita_fragment_sender_t *sender);
+uint8_t akita_fragment_sender_begin(
+    akita_fragment_sender_t *sender,
+    uint16_t node_tag,
+    akita_message_class_t message_class,
+    const uint8_t *payload,
+    size_t payload_len,
+    size_t max_frame_len,
+    uint64_t now_ms
+);
+size_t akita_fragment_sender_next(
+    akita_fragment_sender_t *sender,
+    uint64_t now_ms,
+    uint8_t *buffer,
+    size_t buffer_size,
+    akita_message_class_t *message_class
+);
+void akita_fragment_sender_mark_sent(akita_fragment_sender_t *sender, const uint8_t *frame, size_t frame_len);
+bool akita_fragment_sender_on_nack(akita_fragment_sender_t *sender, const uint8_t *frame, size_t frame_len, uint64_t now_ms);
+
+#endif
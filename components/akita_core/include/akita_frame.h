@@ -0,0 +1,156 @@
+#ifndef AKITA_FRAME_H
+#define AKITA_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_telemetry_schema.h"
+#include "akita_types.h"
+
+#define AKITA_FRAME_VERSION 1U
+#define AKITA_FRAME_MAX_LEN 255U
+#define AKITA_FRAME_HEADER_LEN 4U
+#define AKITA_FRAME_DEFAULT_KEYFRAME_INTERVAL 12U
+#define AKITA_FRAME_ACK_GRACE_FRAMES 3U
+/* Keyframes a receiver keeps per node, so a delta may still name one this many keyframes back. */
+#define AKITA_FRAME_KEYFRAME_HISTORY 4U
+#define AKITA_FRAME_ACK_SNR_UNKNOWN INT8_MIN
+
+#define AKITA_FRAME_HEADER_TYPE_MASK 0x07U
+#define AKITA_FRAME_HEADER_ACK_REQUEST 0x08U
+
+typedef enum {
+    AKITA_FRAME_TYPE_KEYFRAME = 0,
+    AKITA_FRAME_TYPE_DELTA,
+    AKITA_FRAME_TYPE_ACK,
+    AKITA_FRAME_TYPE_FRAGMENT,
+    AKITA_FRAME_TYPE_NACK,
+    AKITA_FRAME_TYPE_EVENT,
+} akita_frame_type_t;
+
+#define AKITA_FRAME_EVENT_HAS_VALUE 0x80U
+#define AKITA_FRAME_EVENT_NAME_MAX_LEN 31U
+
+typedef enum {
+    AKITA_FRAME_EVENT_NODE = 0,
+    AKITA_FRAME_EVENT_RULE,
+    AKITA_FRAME_EVENT_GEOFENCE,
+} akita_frame_event_source_t;
+
+/* What an event frame says happened; the telemetry around it is the keyframe it names. */
+typedef struct {
+    akita_frame_event_source_t source;
+    /* Rules: 0 fired, 1 cleared. Geofences: the akita_geofence_event_type_t. */
+    uint8_t action;
+    /* 1-based rule index or fence id; 0 for node events. */
+    uint32_t id;
+    /* Reading that fired a rule, or seconds inside a fence; NAN when there is none. */
+    float value;
+    const char *name;
+} akita_frame_event_t;
+
+#define AKITA_FRAME_FLAG_BIT_ENTRY_FLAG(id, member, wire, param) AKITA_FRAME_FLAG_BIT_##id = (wire),
+#define AKITA_FRAME_FLAG_BIT_ENTRY_RAW(id, member, wire, param)
+#define AKITA_FRAME_FLAG_BIT_ENTRY_SCALE(id, member, wire, param)
+#define AKITA_FRAME_FLAG_BIT_ENTRY_DIV(id, member, wire, param)
+#define AKITA_FRAME_FLAG_BIT_ENTRY(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_FLAG_BIT_ENTRY_, id, member, frame)
+
+typedef enum {
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_FLAG_BIT_ENTRY)
+} akita_frame_flag_bit_t;
+
+#define AKITA_FRAME_FIELD_ENTRY_FLAG(id, member, wire, param)
+#define AKITA_FRAME_FIELD_ENTRY_RAW(id, member, wire, param) AKITA_FRAME_FIELD_##id = (wire),
+#define AKITA_FRAME_FIELD_ENTRY_SCALE(id, member, wire, param) AKITA_FRAME_FIELD_##id = (wire),
+#define AKITA_FRAME_FIELD_ENTRY_DIV(id, member, wire, param) AKITA_FRAME_FIELD_##id = (wire),
+#define AKITA_FRAME_FIELD_ENTRY(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_FIELD_ENTRY_, id, member, frame)
+
+typedef enum {
+    AKITA_FRAME_FIELD_FLAGS = 0,
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_FIELD_ENTRY)
+} akita_frame_field_t;
+
+/* Each wire id sizes one member, so these unions are as large as the highest flag bit or field index plus one. */
+#define AKITA_FRAME_FLAG_SPAN_FLAG(id, member, wire, param) uint8_t id[(wire) + 1];
+#define AKITA_FRAME_FLAG_SPAN_RAW(id, member, wire, param)
+#define AKITA_FRAME_FLAG_SPAN_SCALE(id, member, wire, param)
+#define AKITA_FRAME_FLAG_SPAN_DIV(id, member, wire, param)
+#define AKITA_FRAME_FLAG_SPAN(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_FLAG_SPAN_, id, member, frame)
+#define AKITA_FRAME_FIELD_SPAN_FLAG(id, member, wire, param)
+#define AKITA_FRAME_FIELD_SPAN_RAW(id, member, wire, param) uint8_t id[(wire) + 1];
+#define AKITA_FRAME_FIELD_SPAN_SCALE(id, member, wire, param) uint8_t id[(wire) + 1];
+#define AKITA_FRAME_FIELD_SPAN_DIV(id, member, wire, param) uint8_t id[(wire) + 1];
+#define AKITA_FRAME_FIELD_SPAN(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_FIELD_SPAN_, id, member, frame)
+
+union akita_frame_flag_span {
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_FLAG_SPAN)
+};
+
+union akita_frame_field_span {
+    uint8_t FLAGS[1];
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_FIELD_SPAN)
+};
+
+#define AKITA_FRAME_FLAG_BIT_COUNT sizeof(union akita_frame_flag_span)
+#define AKITA_FRAME_FIELD_COUNT sizeof(union akita_frame_field_span)
+
+typedef struct {
+    bool valid;
+    uint8_t sequence;
+    uint64_t timestamp_ms;
+    int32_t values[AKITA_FRAME_FIELD_COUNT];
+} akita_frame_state_t;
+
+/*
+ * Deltas are built against the last keyframe the receiver acknowledged, so a lost keyframe does not take the
+ * deltas after it down too. Until an ACK is seen, or once the acknowledged keyframe is older than the receiver's
+ * keyframe history, they fall back to the newest keyframe and an unacknowledged one is resent after the grace frames.
+ */
+typedef struct {
+    akita_frame_state_t reference;
+    akita_frame_state_t acked;
+    uint16_t node_tag;
+    uint8_t next_sequence;
+    uint8_t keyframe_interval;
+    uint8_t frames_since_keyframe;
+    uint8_t keyframes_since_ack;
+    bool reference_acked;
+    bool acks_seen;
+    bool keyframe_requested;
+} akita_frame_encoder_t;
+
+uint16_t akita_frame_node_tag(const char *vehicle_id);
+void akita_frame_encoder_init(akita_frame_encoder_t *encoder, const char *vehicle_id, uint8_t keyframe_interval);
+void akita_frame_encoder_request_keyframe(akita_frame_encoder_t *encoder);
+bool akita_frame_encoder_on_ack(akita_frame_encoder_t *encoder, const uint8_t *frame, size_t frame_len);
+size_t akita_frame_encode(
+    akita_frame_encoder_t *encoder,
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t timestamp_ms,
+    uint8_t *buffer,
+    size_t buffer_size
+);
+/* Returns 0 until a keyframe has been encoded, since the event frame names the newest one. */
+size_t akita_frame_encode_event(
+    akita_frame_encoder_t *encoder,
+    const akita_frame_event_t *event,
+    uint64_t timestamp_ms,
+    uint8_t *buffer,
+    size_t buffer_size
+);
+int8_t akita_frame_ack_uplink_snr(const uint8_t *frame, size_t frame_len);
+size_t akita_frame_write_ack(
+    uint16_t node_tag,
+    uint8_t sequence,
+    int8_t uplink_snr_quarter_db,
+    uint8_t *buffer,
+    size_t buffer_size
+);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef AKITA_FUSION_H
+#define AKITA_FUSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+#include "sdkconfig.h"
+
+/* Yaw rate argument when there is no gyro. */
+#define AKITA_FUSION_NO_YAW INT32_MIN
+/* GPS fixes older than this are treated as an outage. */
+#define AKITA_FUSION_FIX_STALE_MS 2500U
+/* Without OBD speed, the last GPS speed is held this long into an outage. */
+#define AKITA_FUSION_COAST_MS 5000U
+#define AKITA_FUSION_MAX_SIGMA_M 120
+
+/*
+ * Filter arithmetic is float, or Q16.16 on targets without an FPU. Positions are
+ * metres east and north of an origin that moves with the vehicle, so Q16.16 keeps
+ * centimetre resolution without overflowing.
+ */
+#if CONFIG_AKITA_FUSION_FIXED
+typedef int32_t akita_fx_t;
+typedef int64_t akita_fx_wide_t;
+#define AKITA_FX(value) ((akita_fx_t) ((value) * 65536.0))
+#define AKITA_FX_INT(value) ((akita_fx_t) ((value) * 65536))
+#define AKITA_FX_MUL(a, b) ((akita_fx_t) (((akita_fx_wide_t) (a) * (b)) / 65536))
+#define AKITA_FX_DIV(a, b) ((akita_fx_t) (((akita_fx_wide_t) (a) * 65536) / (b)))
+#define AKITA_FX_SQ_WIDE(a) (((akita_fx_wide_t) (a) * (a)) / 65536)
+#define AKITA_FX_FROM_FLOAT(value) ((akita_fx_t) lroundf((value) * 65536.0f))
+#define AKITA_FX_TO_FLOAT(value) ((float) (value) / 65536.0f)
+#else
+typedef float akita_fx_t;
+typedef float akita_fx_wide_t;
+#define AKITA_FX(value) ((akita_fx_t) (value))
+#define AKITA_FX_INT(value) ((akita_fx_t) (value))
+#define AKITA_FX_MUL(a, b) ((a) * (b))
+#define AKITA_FX_DIV(a, b) ((a) / (b))
+#define AKITA_FX_SQ_WIDE(a) ((a) * (a))
+#define AKITA_FX_FROM_FLOAT(value) (value)
+#define AKITA_FX_TO_FLOAT(value) (value)
+#endif
+
+typedef struct {
+    bool valid;
+    /* No GPS fix went into this position for AKITA_FUSION_FIX_STALE_MS or more. */
+    bool dead_reckoning;
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    float speed_kmh;
+    float heading_deg;
+    /* One standard deviation of the position estimate. */
+    float sigma_m;
+    uint32_t outage_ms;
+} akita_fusion_output_t;
+
+typedef struct {
+    bool has_origin;
+    bool has_heading;
+    int32_t origin_latitude_e6;
+    int32_t origin_longitude_e6;
+    /* Metres per microdegree at the origin. */
+    akita_fx_t lat_scale;
+    akita_fx_t lon_scale;
+    akita_fx_t east_m;
+    akita_fx_t north_m;
+    akita_fx_t variance_m2;
+    akita_fx_t speed_mps;
+    /* GPS speed over OBD speed, learned while both are available. */
+    akita_fx_t obd_scale;
+    /* Binary angle: 65536 is a full turn, clockwise from north. */
+    uint16_t heading;
+    uint8_t rejected;
+    uint64_t last_step_ms;
+    uint64_t last_fix_ms;
+    uint64_t last_speed_ms;
+    uint32_t fixes;
+    uint32_t steps;
+} akita_fusion_t;
+
+void akita_fusion_init(akita_fusion_t *fusion);
+void akita_fusion_step(
+    akita_fusion_t *fusion,
+    const akita_gps_snapshot_t *gps,
+    const akita_obd_snapshot_t *obd,
+    int32_t yaw_rate_mdps,
+    uint64_t now_ms
+);
+void akita_fusion_output(const akita_fusion_t *fusion, uint64_t now_ms, akita_fusion_output_t *output);
+
+#endif
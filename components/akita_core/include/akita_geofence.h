@@ -0,0 +1,119 @@
+#ifndef AKITA_GEOFENCE_H
+#define AKITA_GEOFENCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define AKITA_GEOFENCE_MAGIC 0x46474B41U /* "AKGF" */
+#define AKITA_GEOFENCE_VERSION 1U
+#define AKITA_GEOFENCE_MAX_FENCES 1024U
+#define AKITA_GEOFENCE_MAX_VERTICES 64U
+/* Grid index: at most 64 x 64 cells, and this many fence references across all of them. */
+#define AKITA_GEOFENCE_GRID_MAX_SIDE 64U
+#define AKITA_GEOFENCE_INDEX_MAX 4096U
+/* Fences the vehicle is in, or entering, at one time. */
+#define AKITA_GEOFENCE_ACTIVE_MAX 16U
+/* A change of side has to hold this long before it is reported. */
+#define AKITA_GEOFENCE_CONFIRM_MS 3000U
+/* An exit also needs the position this far outside the polygon, so GPS jitter on the boundary is not a visit. */
+#define AKITA_GEOFENCE_EXIT_MARGIN_M 25U
+
+/* Raises events as alerts rather than events, e.g. for a restricted zone. */
+#define AKITA_GEOFENCE_FLAG_ALERT 0x01U
+
+/* Image layout, little endian: header, fence records, then vertices. */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t fence_count;
+    uint32_t vertex_count;
+    /* Whole image in bytes, header included. */
+    uint32_t size;
+    /* CRC-32 (IEEE) of everything after the header. */
+    uint32_t crc32;
+    uint32_t reserved;
+} akita_geofence_header_t;
+
+typedef struct {
+    uint32_t id;
+    int32_t min_latitude_e6;
+    int32_t min_longitude_e6;
+    int32_t max_latitude_e6;
+    int32_t max_longitude_e6;
+    uint32_t first_vertex;
+    uint16_t vertex_count;
+    /* Seconds inside before a dwell event, 0 for none. */
+    uint16_t dwell_s;
+    uint8_t flags;
+    /* Vertex offsets from the box minimum are in units of 2^shift microdegrees. */
+    uint8_t shift;
+    uint16_t reserved;
+} akita_geofence_record_t;
+
+typedef struct {
+    uint16_t latitude;
+    uint16_t longitude;
+} akita_geofence_vertex_t;
+
+typedef enum {
+    AKITA_GEOFENCE_ENTER = 0,
+    AKITA_GEOFENCE_EXIT,
+    AKITA_GEOFENCE_DWELL,
+} akita_geofence_event_type_t;
+
+typedef struct {
+    akita_geofence_event_type_t type;
+    uint32_t fence_id;
+    uint8_t flags;
+    /* Time since the position was first inside; for an exit, the length of the whole visit. */
+    uint32_t inside_ms;
+} akita_geofence_event_t;
+
+typedef enum {
+    AKITA_GEOFENCE_ENTERING = 0,
+    AKITA_GEOFENCE_INSIDE,
+} akita_geofence_state_t;
+
+typedef struct {
+    uint16_t fence;
+    akita_geofence_state_t state;
+    bool dwell_sent;
+    uint64_t entered_ms;
+    /* Set while the position is outside, from the first fix that was. */
+    bool crossing;
+    uint64_t crossed_ms;
+} akita_geofence_visit_t;
+
+typedef struct {
+    const akita_geofence_record_t *fences;
+    const akita_geofence_vertex_t *vertices;
+    uint16_t fence_count;
+    int32_t grid_latitude_e6;
+    int32_t grid_longitude_e6;
+    uint32_t cell_latitude_e6;
+    uint32_t cell_longitude_e6;
+    uint8_t grid_side;
+    uint16_t cell_start[AKITA_GEOFENCE_GRID_MAX_SIDE * AKITA_GEOFENCE_GRID_MAX_SIDE + 1U];
+    uint16_t cell_fences[AKITA_GEOFENCE_INDEX_MAX];
+    uint8_t visit_count;
+    akita_geofence_visit_t visits[AKITA_GEOFENCE_ACTIVE_MAX];
+    uint32_t evaluations;
+    uint32_t polygon_tests;
+} akita_geofence_t;
+
+void akita_geofence_init(akita_geofence_t *geofence);
+/* Checks and indexes an image; the image is referenced, not copied, so it has to outlive the engine's use of it. */
+esp_err_t akita_geofence_load(akita_geofence_t *geofence, const void *image, size_t size);
+bool akita_geofence_contains(const akita_geofence_t *geofence, uint16_t fence, int32_t latitude_e6, int32_t longitude_e6);
+/* Indexes of the fences containing the point, by way of the grid cell it falls in. */
+size_t akita_geofence_lookup(akita_geofence_t *geofence, int32_t latitude_e6, int32_t longitude_e6, uint16_t *fences,
+                             size_t max_fences);
+size_t akita_geofence_update(akita_geofence_t *geofence, int32_t latitude_e6, int32_t longitude_e6, uint64_t now_ms,
+                             akita_geofence_event_t *events, size_t max_events);
+const char *akita_geofence_event_name(akita_geofence_event_type_t type);
+uint32_t akita_geofence_crc32(uint32_t crc, const void *data, size_t size);
+
+#endif
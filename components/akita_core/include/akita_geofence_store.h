@@ -0,0 +1,14 @@
+#ifndef AKITA_GEOFENCE_STORE_H
+#define AKITA_GEOFENCE_STORE_H
+
+#include <stddef.h>
+
+#include "esp_err.h"
+
+/* Maps the geofence partition; the image stays in flash and is read through the cache. */
+esp_err_t akita_geofence_store_map(const void **image, size_t *size);
+void akita_geofence_store_unmap(void);
+/* Writes one piece of a new image; the piece at offset 0 erases as much of the partition as total needs. */
+esp_err_t akita_geofence_store_write(size_t offset, const void *data, size_t size, size_t total);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef AKITA_OUTBOX_H
+#define AKITA_OUTBOX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_aggregate.h"
+#include "akita_fusion.h"
+#include "akita_geofence.h"
+#include "akita_trace.h"
+#include "akita_track.h"
+#include "akita_trip.h"
+#include "akita_types.h"
+
+#define AKITA_OUTBOX_DEPTH 8U
+#define AKITA_OUTBOX_NO_DEADLINE 0U
+#define AKITA_OUTBOX_EVENT_NAME_LEN 24U
+
+typedef enum {
+    AKITA_OUTBOX_SAMPLE = 0,
+    AKITA_OUTBOX_GEOFENCE,
+    AKITA_OUTBOX_TRIP,
+} akita_outbox_kind_t;
+
+typedef struct {
+    /* Aggregates since the previous routine sample; window_ms is 0 when there are none. */
+    akita_aggregate_summary_t window;
+    /* Fixes kept by the track simplifier since the previous routine sample, oldest first. */
+    uint8_t track_count;
+    akita_track_point_t track[AKITA_TRACK_MAX_POINTS];
+} akita_outbox_sample_t;
+
+typedef struct {
+    akita_message_class_t message_class;
+    /* Which member of the union at the end is set. */
+    akita_outbox_kind_t kind;
+    /* Names the alert or event; empty for a routine sample. */
+    char event_name[AKITA_OUTBOX_EVENT_NAME_LEN];
+    /* Reading that triggered a rule, NAN when there is none. */
+    float event_value;
+    /* 1-based index of the rule behind the event, 0 when no rule is; cleared when it stopped matching. */
+    uint8_t event_rule;
+    bool event_cleared;
+    uint64_t created_ms;
+    uint64_t deadline_ms;
+    /* UTC minus uptime when queued, in microseconds, and how far off that may be; the offset is 0 until GPS sets the clock. */
+    int64_t utc_offset_us;
+    uint32_t utc_error_us;
+    /* Where the message has been, from the newest sensor reading in it to the uplink accepting it. */
+    akita_trace_t trace;
+    akita_vehicle_telemetry_t telemetry;
+    /* Filtered position when it was queued; valid is false when fusion is off or has no estimate. */
+    akita_fusion_output_t fused;
+    /* Only one of these is ever sent, so a slot is sized by the largest rather than by all three. */
+    union {
+        akita_outbox_sample_t sample;
+        /* The fence behind a geofence event. */
+        akita_geofence_event_t geofence;
+        /* A finished trip record. */
+        akita_trip_record_t trip;
+    };
+} akita_outbox_message_t;
+
+typedef struct {
+    akita_outbox_message_t slots[AKITA_OUTBOX_DEPTH];
+    uint8_t head;
+    uint8_t count;
+    uint8_t credit;
+} akita_outbox_queue_t;
+
+typedef struct {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t dropped_stale;
+    uint32_t dropped_overflow;
+} akita_outbox_counters_t;
+
+typedef struct {
+    akita_outbox_queue_t queues[AKITA_MESSAGE_CLASS_COUNT];
+    akita_message_class_t turn;
+    akita_outbox_counters_t counters[AKITA_MESSAGE_CLASS_COUNT];
+} akita_outbox_t;
+
+void akita_outbox_init(akita_outbox_t *outbox);
+bool akita_outbox_push(akita_outbox_t *outbox, const akita_outbox_message_t *message);
+bool akita_outbox_pop(akita_outbox_t *outbox, uint64_t now_ms, akita_outbox_message_t *message);
+void akita_outbox_requeue(akita_outbox_t *outbox, const akita_outbox_message_t *message);
+size_t akita_outbox_pending(const akita_outbox_t *outbox);
+/* True while a record of this trip is waiting in any queue. */
+bool akita_outbox_holds_trip(const akita_outbox_t *outbox, uint32_t trip_id);
+
+#endif
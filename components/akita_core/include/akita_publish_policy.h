@@ -0,0 +1,41 @@
+#ifndef AKITA_PUBLISH_POLICY_H
+#define AKITA_PUBLISH_POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+/* GPS course is noise below this speed, so heading changes are ignored. */
+#define AKITA_PUBLISH_HEADING_MIN_SPEED_KMH 8.0f
+
+typedef enum {
+    AKITA_PUBLISH_SKIP = 0,
+    AKITA_PUBLISH_FIRST,
+    AKITA_PUBLISH_HEARTBEAT,
+    AKITA_PUBLISH_STATE,
+    AKITA_PUBLISH_DEADBAND,
+    AKITA_PUBLISH_DISTANCE,
+    AKITA_PUBLISH_HEADING,
+    AKITA_PUBLISH_REASON_COUNT,
+} akita_publish_reason_t;
+
+typedef struct {
+    bool published;
+    uint64_t last_publish_ms;
+    uint64_t last_check_ms;
+    float travelled_m;
+    akita_vehicle_telemetry_t last;
+    uint32_t counts[AKITA_PUBLISH_REASON_COUNT];
+} akita_publish_policy_t;
+
+void akita_publish_policy_init(akita_publish_policy_t *policy);
+akita_publish_reason_t akita_publish_policy_check(
+    akita_publish_policy_t *policy,
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t now_ms
+);
+const char *akita_publish_reason_name(akita_publish_reason_t reason);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef AKITA_RULES_H
+#define AKITA_RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_aggregate.h"
+#include "akita_types.h"
+
+#define AKITA_RULES_MAX 8U
+#define AKITA_RULE_NAME_LEN 16U
+/* A field that has not changed for this long has a rate of zero. */
+#define AKITA_RULE_RATE_STALE_MS 2000U
+
+typedef enum {
+    AKITA_RULE_ABOVE = 0,
+    AKITA_RULE_BELOW,
+    AKITA_RULE_RISING,
+    AKITA_RULE_FALLING,
+} akita_rule_op_t;
+
+typedef struct {
+    char name[AKITA_RULE_NAME_LEN];
+    uint8_t field;
+    uint8_t op;
+    uint8_t message_class;
+    uint16_t hold_ms;
+    /* Rate rules compare per-second change. BELOW thresholds are stored negated, and BELOW and FALLING negate their input, so every rule is one compare. */
+    float threshold;
+    float clear_band;
+} akita_rule_t;
+
+typedef struct {
+    bool pending;
+    bool active;
+    uint64_t since_ms;
+} akita_rule_state_t;
+
+typedef struct {
+    uint8_t rule;
+    bool cleared;
+    float value;
+} akita_rule_match_t;
+
+typedef struct {
+    akita_rule_t rules[AKITA_RULES_MAX];
+    akita_rule_state_t state[AKITA_RULES_MAX];
+    uint8_t count;
+    uint32_t valid_fields;
+    float value[AKITA_AGGREGATE_FIELD_COUNT];
+    float rate[AKITA_AGGREGATE_FIELD_COUNT];
+    uint64_t changed_ms[AKITA_AGGREGATE_FIELD_COUNT];
+} akita_rule_set_t;
+
+size_t akita_rules_compile(akita_rule_set_t *set, const char *source, char *error, size_t error_size);
+size_t akita_rules_evaluate(
+    akita_rule_set_t *set,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t now_ms,
+    akita_rule_match_t *matches,
+    size_t max_matches
+);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef AKITA_TRACE_H
+#define AKITA_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bucket k counts latencies below 2^(k + 4) us, 16 us to 134 s; the last one also takes anything longer. */
+#define AKITA_TRACE_BUCKETS 24U
+#define AKITA_TRACE_BUCKET_SHIFT 4U
+
+/* Points a sample passes on its way out, in order. */
+typedef enum {
+    AKITA_TRACE_ACQUIRED = 0,
+    AKITA_TRACE_QUEUED,
+    AKITA_TRACE_ENCODE,
+    AKITA_TRACE_TRANSMIT,
+    AKITA_TRACE_ACKED,
+    AKITA_TRACE_POINT_COUNT,
+} akita_trace_point_t;
+
+/* Stage k runs from point k to point k + 1; total runs from acquisition to ack. */
+typedef enum {
+    AKITA_TRACE_STAGE_SAMPLE = 0,
+    AKITA_TRACE_STAGE_QUEUE,
+    AKITA_TRACE_STAGE_ENCODE,
+    AKITA_TRACE_STAGE_TRANSMIT,
+    AKITA_TRACE_STAGE_TOTAL,
+    AKITA_TRACE_STAGE_COUNT,
+} akita_trace_stage_t;
+
+typedef struct {
+    uint32_t id;
+    /* Uptime in microseconds at each point, 0 until it is reached. */
+    uint64_t at_us[AKITA_TRACE_POINT_COUNT];
+} akita_trace_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[AKITA_TRACE_BUCKETS];
+} akita_trace_histogram_t;
+
+typedef struct {
+    uint32_t traces;
+    akita_trace_histogram_t stages[AKITA_TRACE_STAGE_COUNT];
+} akita_trace_stats_t;
+
+void akita_trace_begin(akita_trace_t *trace, uint32_t id, uint64_t acquired_us, uint64_t queued_us);
+void akita_trace_mark(akita_trace_t *trace, akita_trace_point_t point, uint64_t at_us);
+/* Adds every stage the trace has both ends of. */
+void akita_trace_record(akita_trace_stats_t *stats, const akita_trace_t *trace);
+void akita_trace_histogram_add(akita_trace_histogram_t *histogram, uint64_t latency_us);
+/* Upper bound of the bucket holding the given percentile, capped at the largest value seen. */
+uint32_t akita_trace_histogram_percentile(const akita_trace_histogram_t *histogram, uint8_t percent);
+const char *akita_trace_stage_name(akita_trace_stage_t stage);
+/* {"traces":N,"<stage>":{"n":..,"mean_us":..,"p50_us":..,"p90_us":..,"p99_us":..,"max_us":..,"buckets":[..]},..} */
+size_t akita_trace_write_json(const akita_trace_stats_t *stats, char *buffer, size_t buffer_size);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef AKITA_TRACK_H
+#define AKITA_TRACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fixes since the last kept point that a new segment is checked against. */
+#define AKITA_TRACK_WINDOW 64U
+#define AKITA_TRACK_MAX_POINTS 16U
+/* Keeps the squared distances in the segment test inside 64 bits. */
+#define AKITA_TRACK_MAX_SEGMENT_M 2000U
+#define AKITA_TRACK_MAX_TOLERANCE_M 500U
+
+typedef struct {
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    uint64_t timestamp_ms;
+} akita_track_point_t;
+
+typedef struct {
+    akita_track_point_t point;
+    /* Offset from the anchor in decimetres, east and north. */
+    int32_t x_dm;
+    int32_t y_dm;
+} akita_track_window_entry_t;
+
+typedef struct {
+    uint32_t tolerance_dm;
+    bool has_anchor;
+    akita_track_point_t anchor;
+    /* Decimetres per microdegree of longitude at the anchor, Q16. */
+    int32_t lon_scale_q16;
+    uint8_t window_count;
+    akita_track_window_entry_t window[AKITA_TRACK_WINDOW];
+    uint8_t count;
+    akita_track_point_t points[AKITA_TRACK_MAX_POINTS];
+    uint32_t fixes;
+    uint32_t kept;
+    uint32_t overflowed;
+} akita_track_t;
+
+void akita_track_init(akita_track_t *track, uint16_t tolerance_m);
+bool akita_track_add(akita_track_t *track, int32_t latitude_e6, int32_t longitude_e6, uint64_t timestamp_ms);
+size_t akita_track_take(akita_track_t *track, akita_track_point_t *points, size_t max_points);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef AKITA_TRIP_H
+#define AKITA_TRIP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+/* Activity must last this long to start a trip, and stop for this long to end it. */
+#define AKITA_TRIP_START_MS 10000U
+#define AKITA_TRIP_STOP_MS 180000U
+#define AKITA_TRIP_MOVING_KMH 5.0f
+#define AKITA_TRIP_IDLE_KMH 2.0f
+#define AKITA_TRIP_ENGINE_RPM 400.0f
+/* Longer gaps between updates (a stalled task, a reset) are not integrated. */
+#define AKITA_TRIP_MAX_STEP_MS 5000U
+#define AKITA_TRIP_RPM_BANDS 5U
+/* The node reset mid-trip; the record ends at its last checkpoint. */
+#define AKITA_TRIP_FLAG_TRUNCATED 0x01U
+/* Recorded before the last reset, so start_ms counts uptime of an earlier boot. */
+#define AKITA_TRIP_FLAG_EARLIER_BOOT 0x02U
+
+typedef enum {
+    AKITA_TRIP_NONE = 0,
+    AKITA_TRIP_STARTED,
+    AKITA_TRIP_ENDED,
+} akita_trip_event_t;
+
+typedef struct {
+    uint32_t trip_id;
+    uint64_t start_ms;
+    /* Unix milliseconds at the start and at the last activity, 0 if the clock was not set during the trip. */
+    int64_t start_utc_ms;
+    int64_t end_utc_ms;
+    uint32_t duration_ms;
+    uint32_t distance_m;
+    uint32_t idle_ms;
+    /* Engine time below 1500, 2500, 3500 and 4500 rpm, and above. */
+    uint32_t rpm_band_ms[AKITA_TRIP_RPM_BANDS];
+    float max_speed_kmh;
+    uint8_t flags;
+    bool has_start_fix;
+    bool has_end_fix;
+    float start_latitude;
+    float start_longitude;
+    float end_latitude;
+    float end_longitude;
+} akita_trip_record_t;
+
+typedef struct {
+    bool candidate;
+    bool active;
+    uint32_t next_id;
+    uint64_t last_ms;
+    uint64_t last_active_ms;
+    float distance_m;
+    akita_trip_record_t record;
+} akita_trip_tracker_t;
+
+void akita_trip_init(akita_trip_tracker_t *tracker, uint32_t next_id);
+akita_trip_event_t akita_trip_update(
+    akita_trip_tracker_t *tracker,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t now_ms,
+    akita_trip_record_t *finished
+);
+void akita_trip_snapshot(const akita_trip_tracker_t *tracker, akita_trip_record_t *record);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef AKITA_TRIP_STORE_H
+#define AKITA_TRIP_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_trip.h"
+#include "esp_err.h"
+
+#define AKITA_TRIP_STORE_VERSION 2U
+#define AKITA_TRIP_STORE_PENDING_MAX 4U
+
+/* Everything about trips that has to survive a reset, kept as one NVS blob. */
+typedef struct {
+    uint32_t version;
+    uint32_t next_id;
+    bool has_active;
+    uint8_t pending_count;
+    /* Checkpoint of the trip in progress, closed as a truncated record if the node resets. */
+    akita_trip_record_t active;
+    /* Finished trips that no uplink has accepted yet, oldest first. */
+    akita_trip_record_t pending[AKITA_TRIP_STORE_PENDING_MAX];
+} akita_trip_store_t;
+
+esp_err_t akita_trip_store_load(akita_trip_store_t *store);
+esp_err_t akita_trip_store_save(const akita_trip_store_t *store);
+void akita_trip_store_add_pending(akita_trip_store_t *store, const akita_trip_record_t *record);
+bool akita_trip_store_remove_pending(akita_trip_store_t *store, uint32_t trip_id);
+
+#endif
@@ -0,0 +1,116 @@
+#include "akita_aggregate.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Per-field update with no data-dependent branches; group validity is checked once per sample. */
+#define AKITA_AGGREGATE_UPDATE_BOOL(id, member)
+#define AKITA_AGGREGATE_UPDATE_VALUE(id, member) \
+    akita_aggregate_update(&aggregate->fields[AKITA_AGGREGATE_FIELD_##id], (float) telemetry->member);
+#define AKITA_AGGREGATE_UPDATE_FIXED AKITA_AGGREGATE_UPDATE_VALUE
+#define AKITA_AGGREGATE_UPDATE_UINT AKITA_AGGREGATE_UPDATE_VALUE
+#define AKITA_AGGREGATE_UPDATE_INT AKITA_AGGREGATE_UPDATE_VALUE
+#define AKITA_AGGREGATE_UPDATE(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_AGGREGATE_UPDATE_##type(id, member)
+
+#define AKITA_AGGREGATE_SHIFT_BOOL(id, member)
+#define AKITA_AGGREGATE_SHIFT_VALUE(id, member) \
+    aggregate->fields[AKITA_AGGREGATE_FIELD_##id].shift = (float) telemetry->member;
+#define AKITA_AGGREGATE_SHIFT_FIXED AKITA_AGGREGATE_SHIFT_VALUE
+#define AKITA_AGGREGATE_SHIFT_UINT AKITA_AGGREGATE_SHIFT_VALUE
+#define AKITA_AGGREGATE_SHIFT_INT AKITA_AGGREGATE_SHIFT_VALUE
+#define AKITA_AGGREGATE_SHIFT(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_AGGREGATE_SHIFT_##type(id, member)
+
+#define AKITA_AGGREGATE_MAP_BOOL(id, group)
+#define AKITA_AGGREGATE_MAP_VALUE(id, group) [AKITA_AGGREGATE_FIELD_##id] = AKITA_AGGREGATE_GROUP_##group,
+#define AKITA_AGGREGATE_MAP_FIXED AKITA_AGGREGATE_MAP_VALUE
+#define AKITA_AGGREGATE_MAP_UINT AKITA_AGGREGATE_MAP_VALUE
+#define AKITA_AGGREGATE_MAP_INT AKITA_AGGREGATE_MAP_VALUE
+#define AKITA_AGGREGATE_MAP(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_AGGREGATE_MAP_##type(id, group)
+
+static const uint8_t kAggregateFieldGroup[AKITA_AGGREGATE_FIELD_COUNT] = {
+    AKITA_TELEMETRY_FIELDS(AKITA_AGGREGATE_MAP)
+};
+
+static inline void akita_aggregate_update(akita_aggregate_field_t *field, float value) {
+    float offset = value - field->shift;
+
+    field->min = fminf(field->min, value);
+    field->max = fmaxf(field->max, value);
+    field->sum += offset;
+    field->sum_sq += offset * offset;
+}
+
+void akita_aggregate_reset(akita_aggregate_t *aggregate, uint64_t now_ms) {
+    size_t index;
+
+    memset(aggregate, 0, sizeof(*aggregate));
+    aggregate->start_ms = now_ms;
+    for (index = 0; index < AKITA_AGGREGATE_FIELD_COUNT; ++index) {
+        aggregate->fields[index].min = INFINITY;
+        aggregate->fields[index].max = -INFINITY;
+    }
+}
+
+void akita_aggregate_add(akita_aggregate_t *aggregate, const akita_vehicle_telemetry_t *telemetry) {
+    if (aggregate == NULL || telemetry == NULL) {
+        return;
+    }
+
+    /* OBD values are only real while the adapter is connected, GPS values only with a fix. */
+    if (telemetry->obd.connected) {
+        if (aggregate->count[AKITA_AGGREGATE_GROUP_OBD] == 0U) {
+            AKITA_TELEMETRY_OBD_FIELDS(AKITA_AGGREGATE_SHIFT)
+        }
+        AKITA_TELEMETRY_OBD_FIELDS(AKITA_AGGREGATE_UPDATE)
+        ++aggregate->count[AKITA_AGGREGATE_GROUP_OBD];
+    }
+
+    if (telemetry->gps.fix) {
+        if (aggregate->count[AKITA_AGGREGATE_GROUP_GPS] == 0U) {
+            AKITA_TELEMETRY_GPS_FIELDS(AKITA_AGGREGATE_SHIFT)
+        }
+        AKITA_TELEMETRY_GPS_FIELDS(AKITA_AGGREGATE_UPDATE)
+        ++aggregate->count[AKITA_AGGREGATE_GROUP_GPS];
+    }
+
+    if (aggregate->count[AKITA_AGGREGATE_GROUP_SYSTEM] == 0U) {
+        AKITA_TELEMETRY_SYSTEM_FIELDS(AKITA_AGGREGATE_SHIFT)
+    }
+    AKITA_TELEMETRY_SYSTEM_FIELDS(AKITA_AGGREGATE_UPDATE)
+    ++aggregate->count[AKITA_AGGREGATE_GROUP_SYSTEM];
+}
+
+void akita_aggregate_summarize(const akita_aggregate_t *aggregate, uint64_t now_ms, akita_aggregate_summary_t *summary) {
+    size_t index;
+
+    if (aggregate == NULL || summary == NULL) {
+        return;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    summary->window_ms = (uint32_t) (now_ms - aggregate->start_ms);
+    for (index = 0; index < AKITA_AGGREGATE_GROUP_COUNT; ++index) {
+        summary->count[index] = (uint16_t) (aggregate->count[index] > UINT16_MAX ? UINT16_MAX : aggregate->count[index]);
+    }
+
+    for (index = 0; index < AKITA_AGGREGATE_FIELD_COUNT; ++index) {
+        const akita_aggregate_field_t *field = &aggregate->fields[index];
+        uint32_t count = aggregate->count[kAggregateFieldGroup[index]];
+        float mean_offset;
+        float variance;
+
+        if (count == 0U) {
+            continue;
+        }
+
+        mean_offset = field->sum / (float) count;
+        variance = count > 1U ? (field->sum_sq - field->sum * mean_offset) / (float) (count - 1U) : 0.0f;
+        summary->fields[index].min = field->min;
+        summary->fields[index].max = field->max;
+        summary->fields[index].mean = field->shift + mean_offset;
+        summary->fields[index].stddev = sqrtf(fmaxf(variance, 0.0f));
+    }
+}
@@ -1,29 +1,115 @@
 #include "akita_app.h"
 
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "akita_board.h"
+#include "akita_capture_store.h"
+#include "akita_clock.h"
 #include "akita_config_store.h"
 #include "akita_config_ui.h"
+#include "akita_fragment.h"
+#include "akita_fusion.h"
+#include "akita_frame.h"
+#include "akita_geofence.h"
+#include "akita_geofence_store.h"
 #include "akita_gps.h"
+#include "akita_metrics.h"
 #include "akita_obd.h"
+#include "akita_outbox.h"
+#include "akita_publish_policy.h"
+#include "akita_rules.h"
+#include "akita_timeline.h"
+#include "akita_trace.h"
+#include "akita_track.h"
 #include "akita_transport.h"
-#include "driver/gpio.h"
-#include "esp_heap_caps.h"
+#include "akita_trip.h"
+#include "akita_trip_store.h"
 #include "esp_log.h"
-#include "esp_task_wdt.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "nvs.h"
+#include "sdkconfig.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_task_wdt.h"
+#endif
+
+#define AKITA_APP_FRAGMENT_TX_WINDOW 2U
+/* Size the link scheduler assumes for a LoRa frame before the first one is encoded. */
+#define AKITA_APP_LORA_FRAME_ESTIMATE_LEN 32U
+#define AKITA_APP_UPLINK_TASK_STACK_SIZE 8192
+#define AKITA_APP_UPLINK_TASK_PRIORITY 5
+#define AKITA_APP_UPLINK_IDLE_MS 200U
+#define AKITA_APP_UPLINK_RETRY_MS 1000U
+#define AKITA_APP_ROUTINE_DEADLINE_INTERVALS 2U
+#define AKITA_APP_EVENT_DEADLINE_MS 60000U
+/* Sensor poll, and so the rate of the fused position stream. */
+#define AKITA_APP_POLL_MS 100U
+/* How often a trip in progress is checkpointed, and how often undelivered trip records are offered again. */
+#define AKITA_APP_TRIP_CHECKPOINT_MS 60000U
+#define AKITA_APP_TRIP_RETRY_MS 300000U
 
 static const char *TAG = "akita_app";
 static akita_runtime_config_t g_runtime_config;
 static akita_vehicle_telemetry_t g_telemetry;
 static bool g_led_ready;
 static uint64_t g_led_off_at_ms;
+static akita_frame_encoder_t g_frame_encoder;
+static akita_fragment_sender_t g_fragment_sender;
+static uint32_t g_lora_tx_dropped;
+static size_t g_lora_frame_len = AKITA_APP_LORA_FRAME_ESTIMATE_LEN;
+static akita_link_id_t g_telemetry_link = AKITA_LINK_NONE;
+static akita_outbox_t g_outbox;
+static SemaphoreHandle_t g_outbox_lock;
+static akita_trace_stats_t g_trace_stats;
+static uint32_t g_trace_id;
+#if CONFIG_AKITA_TIMELINE_CONSOLE_DUMP
+static bool g_timeline_printed;
+#endif
+static TaskHandle_t g_uplink_task;
+static bool g_obd_connected;
+static akita_rule_set_t g_rules;
+static char g_rules_source[sizeof(((akita_runtime_config_t *) 0)->event_rules)];
+/* Only the uplink task encodes payloads, so the JSON buffer stays off its stack. */
+static char g_payload[1792];
+static akita_publish_policy_t g_publish_policy;
+static akita_aggregate_t g_window;
+static akita_aggregate_summary_t g_window_summary;
+static akita_clock_t g_clock;
+static akita_fusion_t g_fusion;
+static akita_fusion_output_t g_fused;
+static akita_geofence_t g_geofence;
+static SemaphoreHandle_t g_geofence_lock;
+static uint64_t g_geofence_fix_ms;
+static akita_track_t g_track;
+static uint16_t g_track_tolerance_m;
+static uint64_t g_track_fix_ms;
+static akita_trip_tracker_t g_trip;
+static akita_trip_store_t g_trip_store;
+static SemaphoreHandle_t g_trip_lock;
+static uint64_t g_trip_checkpoint_ms;
+static uint64_t g_trip_retry_ms;
+static bool g_trip_lora_only_logged;
+/* Trip record the uplink task has taken from the outbox and not yet delivered or put back, 0 for none. */
+static uint32_t g_trip_sending;
+
+static void akita_status_led_set(uint32_t level) {
+#if CONFIG_IDF_TARGET_LINUX
+    (void) level;
+#else
+    gpio_set_level((gpio_num_t) g_runtime_config.status_led_pin, level);
+#endif
+}
 
 static void akita_status_led_init(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    g_led_ready = false;
+#else
     if (g_runtime_config.status_led_pin < 0) {
         g_led_ready = false;
         return;
@@ -31,9 +117,10 @@ static void akita_status_led_init(void) {
 
     gpio_reset_pin((gpio_num_t) g_runtime_config.status_led_pin);
     gpio_set_direction((gpio_num_t) g_runtime_config.status_led_pin, GPIO_MODE_OUTPUT);
-    gpio_set_level((gpio_num_t) g_runtime_config.status_led_pin, 0);
+    akita_status_led_set(0);
     g_led_ready = true;
     g_led_off_at_ms = 0;
+#endif
 }
 
 static void akita_status_led_pulse(void) {
@@ -41,7 +128,7 @@ static void akita_status_led_pulse(void) {
         return;
     }
 
-    gpio_set_level((gpio_num_t) g_runtime_config.status_led_pin, 1);
+    akita_status_led_set(1);
     g_led_off_at_ms = (uint64_t) (esp_timer_get_time() / 1000ULL) + 40ULL;
 }
 
@@ -51,7 +138,7 @@ static void akita_status_led_service(uint64_t now_ms) {
     }
 
     if (now_ms >= g_led_off_at_ms) {
-        gpio_set_level((gpio_num_t) g_runtime_config.status_led_pin, 0);
+        akita_status_led_set(0);
         g_led_off_at_ms = 0;
     }
 }
@@ -98,66 +185,867 @@ static void akita_refresh_system_snapshot(const akita_runtime_config_t *config)
     g_telemetry.system.wifi_ready = transport_status.wifi_connected || g_telemetry.system.config_portal_ready;
     g_telemetry.system.lora_ready = transport_status.lora_ready;
     g_telemetry.system.wifi_rssi = transport_status.wifi_rssi;
+#if !CONFIG_IDF_TARGET_LINUX
     g_telemetry.system.free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#endif
+    g_telemetry.system.sampled_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
     (void) config;
 }
 
+static void akita_send_lora_fragments(const akita_runtime_config_t *config, uint64_t now_ms) {
+    akita_transport_status_t transport_status;
+    akita_message_class_t message_class;
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    uint32_t backlog;
+    size_t frame_len;
+
+    /* Feed fragments a few at a time so they never overflow the radio queue. */
+    akita_transport_get_status(&transport_status);
+    backlog = transport_status.lora_tx_backlog;
+    while (backlog < AKITA_APP_FRAGMENT_TX_WINDOW) {
+        frame_len = akita_fragment_sender_next(&g_fragment_sender, now_ms, frame, sizeof(frame), &message_class);
+        if (frame_len == 0U || akita_transport_publish_frame(config, message_class, frame, frame_len) != ESP_OK) {
+            break;
+        }
+
+        akita_fragment_sender_mark_sent(&g_fragment_sender, frame, frame_len);
+        ++backlog;
+    }
+}
+
+static void akita_service_lora_frames(const akita_runtime_config_t *config, uint64_t now_ms) {
+    akita_link_quality_t link;
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    size_t frame_len;
+
+    if (g_frame_encoder.keyframe_interval == 0U ||
+        g_frame_encoder.node_tag != akita_frame_node_tag(config->vehicle_id)) {
+        akita_frame_encoder_init(&g_frame_encoder, config->vehicle_id, AKITA_FRAME_DEFAULT_KEYFRAME_INTERVAL);
+        akita_fragment_sender_init(&g_fragment_sender);
+    }
+
+    while ((frame_len = akita_transport_take_frame(frame, sizeof(frame), &link)) > 0U) {
+        if (akita_frame_encoder_on_ack(&g_frame_encoder, frame, frame_len)) {
+            akita_transport_report_link(&link, akita_frame_ack_uplink_snr(frame, frame_len));
+        } else if (akita_fragment_sender_on_nack(&g_fragment_sender, frame, frame_len, now_ms)) {
+            ESP_LOGI(TAG, "Resending LoRa fragments 0x%04x of message %u", (unsigned) (frame[4] | (frame[5] << 8)), (unsigned) frame[3]);
+        }
+    }
+
+    akita_send_lora_fragments(config, now_ms);
+}
+
+static esp_err_t akita_publish_lora_message(
+    const akita_runtime_config_t *config,
+    akita_message_class_t message_class,
+    const uint8_t *payload,
+    size_t payload_len,
+    size_t max_frame_len,
+    uint64_t now_ms
+) {
+    if (payload_len <= max_frame_len) {
+        return akita_transport_publish_frame(config, message_class, payload, payload_len);
+    }
+
+    /* Fragments of one message must not coalesce with each other in the airtime scheduler. */
+    if (message_class == AKITA_MESSAGE_ROUTINE) {
+        message_class = AKITA_MESSAGE_BULK;
+    }
+    if (akita_fragment_sender_begin(&g_fragment_sender, g_frame_encoder.node_tag, message_class, payload, payload_len,
+                                    max_frame_len, now_ms) == 0U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    akita_send_lora_fragments(config, now_ms);
+    return ESP_OK;
+}
+
+static esp_err_t akita_publish_lora_frame(
+    const akita_runtime_config_t *config,
+    const akita_outbox_message_t *message,
+    uint64_t now_ms
+) {
+    akita_transport_status_t transport_status;
+    akita_message_class_t message_class;
+    akita_frame_event_t event;
+    uint8_t frame[AKITA_FRAME_MAX_LEN];
+    size_t frame_len;
+    esp_err_t err;
+
+    /* A frame dropped by the airtime scheduler may have been the delta reference. */
+    akita_transport_get_status(&transport_status);
+    if (transport_status.lora_tx_dropped != g_lora_tx_dropped) {
+        g_lora_tx_dropped = transport_status.lora_tx_dropped;
+        akita_frame_encoder_request_keyframe(&g_frame_encoder);
+    }
+
+    /* Alerts and events must decode on their own, even if the receiver missed the last delta. */
+    if (message->message_class != AKITA_MESSAGE_ROUTINE) {
+        akita_frame_encoder_request_keyframe(&g_frame_encoder);
+    }
+
+    AKITA_METRIC_BEGIN(span);
+    frame_len = akita_frame_encode(&g_frame_encoder, config, &message->telemetry, message->created_ms, frame, sizeof(frame));
+    AKITA_METRIC_END(span, AKITA_METRIC_FRAME_ENCODE, frame_len > 0U);
+    if (frame_len == 0U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    g_lora_frame_len = frame_len;
+
+    message_class = message->message_class;
+    if (message_class == AKITA_MESSAGE_ROUTINE) {
+        message_class = (frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == AKITA_FRAME_TYPE_KEYFRAME ? AKITA_MESSAGE_EVENT
+                                                                                              : AKITA_MESSAGE_ROUTINE;
+    }
+    err = akita_publish_lora_message(
+        config,
+        message_class,
+        frame,
+        frame_len,
+        transport_status.lora_max_frame_len > 0U ? transport_status.lora_max_frame_len : AKITA_FRAME_MAX_LEN,
+        now_ms
+    );
+    if (err != ESP_OK) {
+        akita_frame_encoder_request_keyframe(&g_frame_encoder);
+        ESP_LOGW(TAG, "LoRa frame publish failed (%s); next frame will be a keyframe", esp_err_to_name(err));
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, frame, frame_len, ESP_LOG_DEBUG);
+        return err;
+    }
+
+    /* The keyframe above carries the readings; the event frame after it says what happened. */
+    if (message->event_name[0] == '\0') {
+        return ESP_OK;
+    }
+    event.name = message->event_name;
+    if (message->kind == AKITA_OUTBOX_GEOFENCE) {
+        event.source = AKITA_FRAME_EVENT_GEOFENCE;
+        event.action = (uint8_t) message->geofence.type;
+        event.id = message->geofence.fence_id;
+        event.value = (float) message->geofence.inside_ms / 1000.0f;
+    } else {
+        event.source = message->event_rule > 0U ? AKITA_FRAME_EVENT_RULE : AKITA_FRAME_EVENT_NODE;
+        event.action = message->event_cleared ? 1U : 0U;
+        event.id = message->event_rule;
+        event.value = message->event_value;
+    }
+    frame_len = akita_frame_encode_event(&g_frame_encoder, &event, message->created_ms, frame, sizeof(frame));
+    if (frame_len == 0U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return akita_publish_lora_message(
+        config,
+        message->message_class,
+        frame,
+        frame_len,
+        transport_status.lora_max_frame_len > 0U ? transport_status.lora_max_frame_len : AKITA_FRAME_MAX_LEN,
+        now_ms
+    );
+}
+
+static esp_err_t akita_publish_auto(
+    const akita_runtime_config_t *config,
+    const akita_outbox_message_t *message,
+    const char *payload,
+    size_t payload_len,
+    uint64_t now_ms
+) {
+    size_t link_payload_len[AKITA_LINK_COUNT] = {0};
+    akita_link_id_t link;
+    uint8_t tried = 0;
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+
+    /* The LoRa frame only carries telemetry, so a trip record waits for WiFi. */
+    link_payload_len[AKITA_LINK_WIFI] = payload_len;
+    link_payload_len[AKITA_LINK_LORA] = message->kind == AKITA_OUTBOX_TRIP ? 0U : g_lora_frame_len;
+    if (message->kind == AKITA_OUTBOX_TRIP) {
+        err = ESP_ERR_NOT_SUPPORTED;
+    }
+
+    /* A failed link is excluded and the same sample goes out on the next one, so a switchover leaves no gap. */
+    while ((link = akita_transport_select_link(config, message->message_class, link_payload_len, tried)) != AKITA_LINK_NONE) {
+        if (link == AKITA_LINK_LORA) {
+            /* The receiver has not seen a LoRa frame while telemetry went over WiFi, so the delta reference is stale. */
+            if (g_telemetry_link != AKITA_LINK_LORA) {
+                akita_frame_encoder_request_keyframe(&g_frame_encoder);
+            }
+            err = akita_publish_lora_frame(config, message, now_ms);
+        } else {
+            err = akita_transport_publish(config, payload);
+        }
+
+        if (err == ESP_OK) {
+            g_telemetry_link = link;
+            return ESP_OK;
+        }
+
+        tried |= (uint8_t) (1U << link);
+    }
+
+    return err;
+}
+
+static esp_err_t akita_publish_message(
+    const akita_runtime_config_t *config,
+    akita_outbox_message_t *message,
+    uint64_t now_ms
+) {
+    size_t payload_len;
+    esp_err_t err;
+
+    akita_trace_mark(&message->trace, AKITA_TRACE_ENCODE, (uint64_t) esp_timer_get_time());
+    if (config->transport_mode == AKITA_TRANSPORT_LORA) {
+        if (message->kind == AKITA_OUTBOX_TRIP) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        akita_trace_mark(&message->trace, AKITA_TRACE_TRANSMIT, (uint64_t) esp_timer_get_time());
+        return akita_publish_lora_frame(config, message, now_ms);
+    }
+
+    AKITA_METRIC_BEGIN(span);
+    payload_len = akita_payload_write_message_json(config, message, g_payload, sizeof(g_payload));
+    AKITA_METRIC_END(span, AKITA_METRIC_PAYLOAD_ENCODE, payload_len > 0U);
+    if (payload_len == 0U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    akita_trace_mark(&message->trace, AKITA_TRACE_TRANSMIT, (uint64_t) esp_timer_get_time());
+    err = config->transport_mode == AKITA_TRANSPORT_AUTO
+              ? akita_publish_auto(config, message, g_payload, payload_len, now_ms)
+              : akita_transport_publish(config, g_payload);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry publish failed (%s); keeping a local copy", esp_err_to_name(err));
+        ESP_LOGI(TAG, "%s", g_payload);
+    }
+
+    return err;
+}
+
+/* The newest sensor reading in the sample, which is what its latency is measured from. */
+static uint64_t akita_newest_reading_ms(const akita_vehicle_telemetry_t *telemetry) {
+    uint64_t newest_ms = telemetry->gps.fix_ms;
+
+    if (telemetry->obd.rpm_ms > newest_ms) {
+        newest_ms = telemetry->obd.rpm_ms;
+    }
+    if (telemetry->obd.speed_ms > newest_ms) {
+        newest_ms = telemetry->obd.speed_ms;
+    }
+    if (telemetry->obd.coolant_ms > newest_ms) {
+        newest_ms = telemetry->obd.coolant_ms;
+    }
+
+    return newest_ms;
+}
+
+static void akita_push_message(akita_outbox_message_t *message) {
+    uint64_t created_us = message->created_ms * 1000ULL;
+    bool queued;
+    size_t pending;
+
+    message->utc_offset_us = akita_clock_offset_us(&g_clock, created_us);
+    message->utc_error_us = akita_clock_error_us(&g_clock, created_us);
+    if (++g_trace_id == 0U) {
+        g_trace_id = 1U;
+    }
+    akita_trace_begin(&message->trace, g_trace_id, akita_newest_reading_ms(&message->telemetry) * 1000ULL,
+                      (uint64_t) esp_timer_get_time());
+
+    xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+    queued = akita_outbox_push(&g_outbox, message);
+    pending = akita_outbox_pending(&g_outbox);
+    xSemaphoreGive(g_outbox_lock);
+
+    AKITA_TIMELINE_COUNTER(AKITA_TIMELINE_OUTBOX_DEPTH, (int32_t) pending);
+    (void) pending;
+    if (!queued) {
+        AKITA_TIMELINE_INSTANT(AKITA_TIMELINE_OUTBOX_DROP, (int32_t) message->message_class);
+        ESP_LOGW(TAG, "Uplink queue for class %d is full; dropped its oldest message", (int) message->message_class);
+    }
+    if (g_uplink_task != NULL) {
+        xTaskNotifyGive(g_uplink_task);
+    }
+}
+
+static void akita_queue_message(
+    akita_message_class_t message_class,
+    const char *event_name,
+    float event_value,
+    const akita_rule_match_t *match,
+    const akita_aggregate_summary_t *window,
+    uint64_t now_ms,
+    uint64_t deadline_ms
+) {
+    akita_outbox_message_t message = {
+        .message_class = message_class,
+        .event_value = event_value,
+        .created_ms = now_ms,
+        .deadline_ms = deadline_ms,
+        .telemetry = g_telemetry,
+        .fused = g_fused,
+    };
+
+    if (event_name != NULL) {
+        snprintf(message.event_name, sizeof(message.event_name), "%s", event_name);
+    }
+    if (match != NULL) {
+        message.event_rule = (uint8_t) (match->rule + 1U);
+        message.event_cleared = match->cleared;
+    }
+    if (window != NULL) {
+        message.sample.window = *window;
+    }
+    /* Routine samples carry the path since the previous one; the sample itself is its newest point. */
+    if (message_class == AKITA_MESSAGE_ROUTINE) {
+        message.sample.track_count = (uint8_t) akita_track_take(&g_track, message.sample.track, AKITA_TRACK_MAX_POINTS);
+    }
+
+    akita_push_message(&message);
+}
+
+static void akita_queue_trip(const akita_trip_record_t *trip, uint64_t now_ms) {
+    akita_outbox_message_t message = {
+        .message_class = AKITA_MESSAGE_EVENT,
+        .kind = AKITA_OUTBOX_TRIP,
+        .event_name = "trip",
+        .event_value = NAN,
+        .created_ms = now_ms,
+        .deadline_ms = AKITA_OUTBOX_NO_DEADLINE,
+        .telemetry = g_telemetry,
+        .trip = *trip,
+    };
+
+    akita_push_message(&message);
+}
+
+static void akita_queue_geofence(const akita_geofence_event_t *event, uint64_t now_ms) {
+    bool alert = (event->flags & AKITA_GEOFENCE_FLAG_ALERT) != 0U;
+    akita_outbox_message_t message = {
+        .message_class = alert ? AKITA_MESSAGE_ALERT : AKITA_MESSAGE_EVENT,
+        .kind = AKITA_OUTBOX_GEOFENCE,
+        .event_value = NAN,
+        .created_ms = now_ms,
+        .deadline_ms = alert ? AKITA_OUTBOX_NO_DEADLINE : now_ms + AKITA_APP_EVENT_DEADLINE_MS,
+        .telemetry = g_telemetry,
+        .fused = g_fused,
+        .geofence = *event,
+    };
+
+    snprintf(message.event_name, sizeof(message.event_name), "%s", akita_geofence_event_name(event->type));
+    akita_push_message(&message);
+}
+
+static void akita_update_clock(void) {
+    akita_clock_source_t source = g_clock.source;
+
+    akita_clock_gps(&g_clock, g_telemetry.gps.utc_ms, g_telemetry.gps.utc_received_us, g_telemetry.gps.pps_us);
+    if (g_clock.source != source) {
+        ESP_LOGI(TAG, "Clock set from GPS %s time", akita_clock_source_name(g_clock.source));
+    }
+}
+
+static void akita_check_events(const akita_runtime_config_t *config, uint64_t now_ms) {
+    const akita_obd_snapshot_t *obd = &g_telemetry.obd;
+    akita_rule_match_t matches[AKITA_RULES_MAX];
+    char error[128];
+    char event_name[AKITA_OUTBOX_EVENT_NAME_LEN];
+    size_t match_count;
+    size_t index;
+
+    if (obd->connected != g_obd_connected) {
+        g_obd_connected = obd->connected;
+        akita_queue_message(AKITA_MESSAGE_EVENT, obd->connected ? "obd_connected" : "obd_lost", NAN, NULL, NULL, now_ms,
+                            now_ms + AKITA_APP_EVENT_DEADLINE_MS);
+    }
+
+    /* Rules are compiled once per edit, so each poll only walks the rule table. */
+    if (strcmp(config->event_rules, g_rules_source) != 0) {
+        akita_rules_compile(&g_rules, config->event_rules, error, sizeof(error));
+        snprintf(g_rules_source, sizeof(g_rules_source), "%s", config->event_rules);
+        if (error[0] != '\0') {
+            ESP_LOGW(TAG, "Event rule skipped: %s", error);
+        }
+        ESP_LOGI(TAG, "%u event rules active", (unsigned) g_rules.count);
+    }
+
+    match_count = akita_rules_evaluate(&g_rules, &g_telemetry, now_ms, matches, AKITA_RULES_MAX);
+    for (index = 0; index < match_count; ++index) {
+        const akita_rule_t *rule = &g_rules.rules[matches[index].rule];
+
+        if (matches[index].cleared) {
+            snprintf(event_name, sizeof(event_name), "%s_clear", rule->name);
+            akita_queue_message(AKITA_MESSAGE_EVENT, event_name, matches[index].value, &matches[index], NULL, now_ms,
+                                now_ms + AKITA_APP_EVENT_DEADLINE_MS);
+            continue;
+        }
+
+        ESP_LOGW(TAG, "Event %s at %.2f", rule->name, (double) matches[index].value);
+        akita_queue_message((akita_message_class_t) rule->message_class, rule->name, matches[index].value, &matches[index],
+                            NULL, now_ms,
+                            rule->message_class == AKITA_MESSAGE_ALERT ? AKITA_OUTBOX_NO_DEADLINE
+                                                                       : now_ms + AKITA_APP_EVENT_DEADLINE_MS);
+    }
+}
+
+static esp_err_t akita_geofence_open(void) {
+    const void *image;
+    size_t size;
+    esp_err_t err = akita_geofence_store_map(&image, &size);
+
+    if (err == ESP_OK) {
+        err = akita_geofence_load(&g_geofence, image, size);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "%u geofences loaded", (unsigned) g_geofence.fence_count);
+    } else {
+        akita_geofence_store_unmap();
+    }
+
+    return err;
+}
+
+static esp_err_t akita_geofence_upload(size_t offset, const void *data, size_t size, size_t total, void *context) {
+    esp_err_t err;
+    (void) context;
+
+    /* Fences are not evaluated while the partition is rewritten; the new image is checked before it is used. */
+    if (offset == 0U) {
+        xSemaphoreTake(g_geofence_lock, portMAX_DELAY);
+        akita_geofence_init(&g_geofence);
+        akita_geofence_store_unmap();
+        xSemaphoreGive(g_geofence_lock);
+    }
+
+    err = akita_geofence_store_write(offset, data, size, total);
+    if (err != ESP_OK || offset + size < total) {
+        return err;
+    }
+
+    xSemaphoreTake(g_geofence_lock, portMAX_DELAY);
+    err = akita_geofence_open();
+    xSemaphoreGive(g_geofence_lock);
+    return err;
+}
+
+static void akita_check_geofences(uint64_t now_ms) {
+    const akita_gps_snapshot_t *gps = &g_telemetry.gps;
+    akita_geofence_event_t events[AKITA_GEOFENCE_ACTIVE_MAX];
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    size_t count;
+    size_t index;
+
+    if (g_fused.valid) {
+        latitude_e6 = g_fused.latitude_e6;
+        longitude_e6 = g_fused.longitude_e6;
+    } else {
+        if (!gps->fix || gps->fix_ms == g_geofence_fix_ms) {
+            return;
+        }
+        g_geofence_fix_ms = gps->fix_ms;
+        latitude_e6 = (int32_t) lroundf(gps->latitude * 1.0e6f);
+        longitude_e6 = (int32_t) lroundf(gps->longitude * 1.0e6f);
+    }
+
+    xSemaphoreTake(g_geofence_lock, portMAX_DELAY);
+    count = akita_geofence_update(&g_geofence, latitude_e6, longitude_e6, now_ms, events, AKITA_GEOFENCE_ACTIVE_MAX);
+    xSemaphoreGive(g_geofence_lock);
+
+    for (index = 0; index < count; ++index) {
+        ESP_LOGI(TAG, "%s %lu", akita_geofence_event_name(events[index].type), (unsigned long) events[index].fence_id);
+        akita_queue_geofence(&events[index], now_ms);
+    }
+}
+
+static void akita_save_trips(void) {
+    esp_err_t err = akita_trip_store_save(&g_trip_store);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Unable to persist trip records: %s", esp_err_to_name(err));
+    }
+}
+
+/* Uptime stamps mean nothing after a reset, so a record takes UTC times once the clock can give them. */
+static void akita_trip_stamp_utc(akita_trip_record_t *record) {
+    int64_t utc_ms;
+
+    if (record->start_utc_ms == 0 && akita_clock_utc_ms(&g_clock, record->start_ms * 1000ULL, &utc_ms)) {
+        record->start_utc_ms = utc_ms;
+    }
+    if (akita_clock_utc_ms(&g_clock, (record->start_ms + record->duration_ms) * 1000ULL, &utc_ms)) {
+        record->end_utc_ms = utc_ms;
+    }
+}
+
+/* No LoRa frame carries a trip record, so on a LoRa-only node they stay stored until the transport mode changes. */
+static bool akita_trips_sendable(const akita_runtime_config_t *config) {
+    if (config->transport_mode != AKITA_TRANSPORT_LORA) {
+        return true;
+    }
+
+    if (!g_trip_lora_only_logged) {
+        g_trip_lora_only_logged = true;
+        ESP_LOGW(TAG, "Trip records are kept on the node until a WiFi transport is configured");
+    }
+    return false;
+}
+
+/* Offers again only the stored trips that are neither waiting in the outbox nor being sent, that is, whose send failed. */
+static void akita_queue_pending_trips(const akita_runtime_config_t *config, uint64_t now_ms) {
+    akita_trip_record_t pending[AKITA_TRIP_STORE_PENDING_MAX];
+    bool queued[AKITA_TRIP_STORE_PENDING_MAX];
+    uint8_t count;
+    uint8_t index;
+
+    g_trip_retry_ms = now_ms;
+    if (!akita_trips_sendable(config)) {
+        return;
+    }
+
+    xSemaphoreTake(g_trip_lock, portMAX_DELAY);
+    count = g_trip_store.pending_count;
+    memcpy(pending, g_trip_store.pending, sizeof(pending[0]) * count);
+    xSemaphoreGive(g_trip_lock);
+
+    xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+    for (index = 0; index < count; ++index) {
+        queued[index] = pending[index].trip_id == g_trip_sending || akita_outbox_holds_trip(&g_outbox, pending[index].trip_id);
+    }
+    xSemaphoreGive(g_outbox_lock);
+
+    for (index = 0; index < count; ++index) {
+        if (!queued[index]) {
+            akita_queue_trip(&pending[index], now_ms);
+        }
+    }
+}
+
+static void akita_trip_delivered(uint32_t trip_id) {
+    xSemaphoreTake(g_trip_lock, portMAX_DELAY);
+    if (akita_trip_store_remove_pending(&g_trip_store, trip_id)) {
+        akita_save_trips();
+    }
+    xSemaphoreGive(g_trip_lock);
+}
+
+static void akita_check_trip(const akita_runtime_config_t *config, uint64_t now_ms) {
+    akita_trip_record_t finished;
+    akita_trip_event_t event = akita_trip_update(&g_trip, &g_telemetry, now_ms, &finished);
+    uint8_t pending_count;
+
+    if (event == AKITA_TRIP_STARTED) {
+        ESP_LOGI(TAG, "Trip %lu started", (unsigned long) g_trip.record.trip_id);
+        akita_queue_message(AKITA_MESSAGE_EVENT, "trip_start", NAN, NULL, NULL, now_ms, now_ms + AKITA_APP_EVENT_DEADLINE_MS);
+    }
+
+    if (event == AKITA_TRIP_ENDED) {
+        ESP_LOGI(TAG, "Trip %lu ended: %lu m in %lu s", (unsigned long) finished.trip_id,
+                 (unsigned long) finished.distance_m, (unsigned long) (finished.duration_ms / 1000U));
+        akita_trip_stamp_utc(&finished);
+        xSemaphoreTake(g_trip_lock, portMAX_DELAY);
+        g_trip_store.has_active = false;
+        akita_trip_store_add_pending(&g_trip_store, &finished);
+        akita_save_trips();
+        xSemaphoreGive(g_trip_lock);
+        if (akita_trips_sendable(config)) {
+            akita_queue_trip(&finished, now_ms);
+        }
+        return;
+    }
+
+    /* The start writes next_id, so a reset never reuses a trip id. */
+    if (g_trip.active && (event == AKITA_TRIP_STARTED || now_ms - g_trip_checkpoint_ms >= AKITA_APP_TRIP_CHECKPOINT_MS)) {
+        xSemaphoreTake(g_trip_lock, portMAX_DELAY);
+        g_trip_store.next_id = g_trip.next_id;
+        g_trip_store.has_active = true;
+        akita_trip_snapshot(&g_trip, &g_trip_store.active);
+        akita_trip_stamp_utc(&g_trip_store.active);
+        akita_save_trips();
+        xSemaphoreGive(g_trip_lock);
+        g_trip_checkpoint_ms = now_ms;
+    }
+
+    xSemaphoreTake(g_trip_lock, portMAX_DELAY);
+    pending_count = g_trip_store.pending_count;
+    xSemaphoreGive(g_trip_lock);
+    if (pending_count > 0U && now_ms - g_trip_retry_ms >= AKITA_APP_TRIP_RETRY_MS) {
+        akita_queue_pending_trips(config, now_ms);
+    }
+}
+
+static void akita_trip_restore(const akita_runtime_config_t *config, uint64_t now_ms) {
+    esp_err_t err;
+    uint8_t index;
+
+    xSemaphoreTake(g_trip_lock, portMAX_DELAY);
+    err = akita_trip_store_load(&g_trip_store);
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "Trip records unreadable (%s); starting fresh", esp_err_to_name(err));
+    }
+
+    /* The node reset mid-trip: what was checkpointed is still worth a record. */
+    if (g_trip_store.has_active) {
+        g_trip_store.active.flags |= AKITA_TRIP_FLAG_TRUNCATED;
+        akita_trip_store_add_pending(&g_trip_store, &g_trip_store.active);
+        g_trip_store.has_active = false;
+    }
+    for (index = 0; index < g_trip_store.pending_count; ++index) {
+        g_trip_store.pending[index].flags |= AKITA_TRIP_FLAG_EARLIER_BOOT;
+    }
+    if (g_trip_store.pending_count > 0U) {
+        akita_save_trips();
+    }
+    akita_trip_init(&g_trip, g_trip_store.next_id);
+    xSemaphoreGive(g_trip_lock);
+
+    akita_queue_pending_trips(config, now_ms);
+}
+
+static uint32_t akita_drain_outbox(const akita_runtime_config_t *config) {
+    akita_outbox_message_t message;
+    uint32_t dropped_before;
+    uint32_t dropped;
+    size_t index;
+    esp_err_t err;
+    bool popped;
+
+    while (true) {
+        uint64_t now_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
+
+        dropped_before = 0;
+        dropped = 0;
+        xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+        for (index = 0; index < AKITA_MESSAGE_CLASS_COUNT; ++index) {
+            dropped_before += g_outbox.counters[index].dropped_stale;
+        }
+        popped = akita_outbox_pop(&g_outbox, now_ms, &message);
+        g_trip_sending = popped && message.kind == AKITA_OUTBOX_TRIP ? message.trip.trip_id : 0U;
+        for (index = 0; index < AKITA_MESSAGE_CLASS_COUNT; ++index) {
+            dropped += g_outbox.counters[index].dropped_stale;
+        }
+        xSemaphoreGive(g_outbox_lock);
+
+        if (dropped != dropped_before) {
+            ESP_LOGW(TAG, "Uplink is congested; dropped %lu stale messages", (unsigned long) (dropped - dropped_before));
+        }
+        if (!popped) {
+            return AKITA_APP_UPLINK_IDLE_MS;
+        }
+
+        err = akita_publish_message(config, &message, now_ms);
+        if (err == ESP_OK) {
+            akita_trace_mark(&message.trace, AKITA_TRACE_ACKED, (uint64_t) esp_timer_get_time());
+            xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+            akita_trace_record(&g_trace_stats, &message.trace);
+            xSemaphoreGive(g_outbox_lock);
+            if (message.kind == AKITA_OUTBOX_TRIP) {
+                akita_trip_delivered(message.trip.trip_id);
+            }
+            xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+            g_trip_sending = 0U;
+            xSemaphoreGive(g_outbox_lock);
+            akita_status_led_pulse();
+            continue;
+        }
+
+        /* These fail the same way every time; anything else may clear, so the message goes back until its deadline. */
+        if (err != ESP_ERR_NOT_SUPPORTED && err != ESP_ERR_INVALID_SIZE && err != ESP_ERR_INVALID_ARG) {
+            xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+            akita_outbox_requeue(&g_outbox, &message);
+            g_trip_sending = 0U;
+            xSemaphoreGive(g_outbox_lock);
+            return AKITA_APP_UPLINK_RETRY_MS;
+        }
+
+        xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+        g_trip_sending = 0U;
+        xSemaphoreGive(g_outbox_lock);
+    }
+}
+
+static size_t akita_write_latency_status(char *buffer, size_t buffer_size, void *context) {
+    akita_trace_stats_t stats;
+    (void) context;
+
+    if (g_outbox_lock == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTake(g_outbox_lock, portMAX_DELAY);
+    stats = g_trace_stats;
+    xSemaphoreGive(g_outbox_lock);
+    return akita_trace_write_json(&stats, buffer, buffer_size);
+}
+
+static void akita_uplink_task(void *arg) {
+    uint32_t wait_ms;
+    (void) arg;
+
+    while (true) {
+        uint64_t now_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
+        akita_runtime_config_t config;
+
+        akita_config_lock();
+        config = g_runtime_config;
+        akita_config_unlock();
+
+        akita_transport_poll(&config);
+        if (config.transport_mode == AKITA_TRANSPORT_LORA || config.transport_mode == AKITA_TRANSPORT_AUTO) {
+            akita_service_lora_frames(&config, now_ms);
+        }
+
+        AKITA_TIMELINE_SPAN_BEGIN(AKITA_TIMELINE_UPLINK_DRAIN);
+        wait_ms = akita_drain_outbox(&config);
+        AKITA_TIMELINE_SPAN_END(AKITA_TIMELINE_UPLINK_DRAIN);
+        akita_status_led_service((uint64_t) (esp_timer_get_time() / 1000ULL));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+    }
+}
+
+static void akita_track_fix(const akita_runtime_config_t *config, uint64_t now_ms) {
+    const akita_gps_snapshot_t *gps = &g_telemetry.gps;
+
+    if (config->track_tolerance_m != g_track_tolerance_m) {
+        akita_track_init(&g_track, config->track_tolerance_m);
+        g_track_tolerance_m = config->track_tolerance_m;
+    }
+
+    if (config->track_tolerance_m == 0U) {
+        return;
+    }
+
+    /* The fused stream carries the path through GPS outages; the simplifier drops the steps a straight road does not need. */
+    if (g_fused.valid) {
+        akita_track_add(&g_track, g_fused.latitude_e6, g_fused.longitude_e6, now_ms);
+        return;
+    }
+
+    /* The GPS is polled faster than it reports, so only a new fix goes to the simplifier. */
+    if (!gps->fix || gps->fix_ms == g_track_fix_ms) {
+        return;
+    }
+
+    g_track_fix_ms = gps->fix_ms;
+    akita_track_add(&g_track, (int32_t) lroundf(gps->latitude * 1.0e6f), (int32_t) lroundf(gps->longitude * 1.0e6f), gps->fix_ms);
+}
+
+static bool akita_sample_due(const akita_runtime_config_t *config, uint64_t now_ms, uint64_t last_sample_ms) {
+    akita_publish_reason_t reason;
+
+    if (g_track.count == AKITA_TRACK_MAX_POINTS) {
+        return true;
+    }
+
+    if (!config->publish_on_change) {
+        return (now_ms - last_sample_ms) >= config->telemetry_interval_ms;
+    }
+
+    reason = akita_publish_policy_check(&g_publish_policy, config, &g_telemetry, now_ms);
+    if (reason != AKITA_PUBLISH_SKIP) {
+        ESP_LOGD(TAG, "Publishing sample (%s)", akita_publish_reason_name(reason));
+    }
+
+    return reason != AKITA_PUBLISH_SKIP;
+}
+
+#if CONFIG_AKITA_TIMELINE
+static void akita_timeline_console_task(void *arg) {
+    (void) arg;
+
+    akita_timeline_print();
+    vTaskDelete(NULL);
+}
+#endif
+
+/* A poll that overran its whole period is the anomaly the timeline is kept for. */
+static void akita_watch_timeline(uint64_t started_us) {
+#if CONFIG_AKITA_TIMELINE
+    uint64_t elapsed_ms = ((uint64_t) esp_timer_get_time() - started_us) / 1000ULL;
+
+    if (elapsed_ms > AKITA_APP_POLL_MS) {
+        ESP_LOGW(TAG, "Main poll took %llu ms; freezing the timeline", (unsigned long long) elapsed_ms);
+        AKITA_TIMELINE_TRIGGER(AKITA_TIMELINE_MAIN_STALL, (int32_t) elapsed_ms);
+    }
+#if CONFIG_AKITA_TIMELINE_CONSOLE_DUMP
+    if (akita_timeline_state() != AKITA_TIMELINE_FROZEN) {
+        g_timeline_printed = false;
+    } else if (!g_timeline_printed) {
+        g_timeline_printed = true;
+        if (xTaskCreate(akita_timeline_console_task, "akita_timeline", 4096, NULL, 1, NULL) != pdPASS) {
+            ESP_LOGW(TAG, "Timeline console dump task could not start");
+        }
+    }
+#endif
+#else
+    (void) started_us;
+#endif
+}
+
 static void akita_main_task(void *arg) {
-    char payload[768];
-    uint64_t last_publish_ms = 0;
+    uint64_t last_sample_ms = 0;
+#if !CONFIG_IDF_TARGET_LINUX
     bool watchdog_attached = false;
+#endif
     (void) arg;
 
+#if !CONFIG_IDF_TARGET_LINUX
     if (esp_task_wdt_add(NULL) == ESP_OK) {
         watchdog_attached = true;
     } else {
         ESP_LOGW(TAG, "Task watchdog subscription failed; continuing without it");
     }
+#endif
 
     while (true) {
-        uint64_t now_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
+        uint64_t started_us = (uint64_t) esp_timer_get_time();
+        uint64_t now_ms = started_us / 1000ULL;
         akita_runtime_config_t config;
-        esp_err_t publish_status;
-        size_t payload_len;
 
+#if !CONFIG_IDF_TARGET_LINUX
         if (watchdog_attached) {
             esp_task_wdt_reset();
         }
+#endif
+        AKITA_TIMELINE_SPAN_BEGIN(AKITA_TIMELINE_MAIN_POLL);
 
         akita_config_lock();
         config = g_runtime_config;
         akita_config_unlock();
 
         akita_gps_poll(&g_telemetry.gps);
+        akita_update_clock();
         akita_obd_poll(&g_telemetry.obd);
-        akita_transport_poll(&config);
         akita_refresh_system_snapshot(&config);
-        akita_status_led_service(now_ms);
-
-        if ((now_ms - last_publish_ms) >= config.telemetry_interval_ms) {
-            if (config.transport_mode == AKITA_TRANSPORT_LORA) {
-                payload_len = akita_payload_write_compact_json(&config, &g_telemetry, payload, 256);
-            } else {
-                payload_len = akita_payload_write_json(&config, &g_telemetry, payload, sizeof(payload));
-            }
+        if (config.fusion_enabled) {
+            akita_fusion_step(&g_fusion, &g_telemetry.gps, &g_telemetry.obd, AKITA_FUSION_NO_YAW, now_ms);
+            akita_fusion_output(&g_fusion, now_ms, &g_fused);
+        } else {
+            g_fused.valid = false;
+        }
+        akita_track_fix(&config, now_ms);
+        akita_check_events(&config, now_ms);
+        akita_check_geofences(now_ms);
+        akita_check_trip(&config, now_ms);
+        if (config.aggregate_window) {
+            akita_aggregate_add(&g_window, &g_telemetry);
+        }
 
-            if (payload_len > 0) {
-                publish_status = akita_transport_publish(&config, payload);
-                if (publish_status != ESP_OK) {
-                    ESP_LOGW(
-                        TAG,
-                        "Telemetry publish failed (%s); keeping a local copy",
-                        esp_err_to_name(publish_status)
-                    );
-                    ESP_LOGI(TAG, "%s", payload);
-                } else {
-                    akita_status_led_pulse();
-                }
-            }
-            last_publish_ms = now_ms;
+        /* A routine sample is worth sending for two intervals; after that a newer one has replaced it. */
+        if (akita_sample_due(&config, now_ms, last_sample_ms)) {
+            akita_aggregate_summarize(&g_window, now_ms, &g_window_summary);
+            akita_queue_message(AKITA_MESSAGE_ROUTINE, NULL, NAN, NULL, config.aggregate_window ? &g_window_summary : NULL,
+                                now_ms, now_ms + (uint64_t) config.telemetry_interval_ms * AKITA_APP_ROUTINE_DEADLINE_INTERVALS);
+            akita_aggregate_reset(&g_window, now_ms);
+            last_sample_ms = now_ms;
         }
+        AKITA_TIMELINE_SPAN_END(AKITA_TIMELINE_MAIN_POLL);
+        akita_watch_timeline(started_us);
+#if CONFIG_AKITA_CAPTURE
+        /* Outside the timed poll: a sector erase now and then is the capture's cost, not a stall. */
+        akita_capture_store_flush();
+#endif
 
-        vTaskDelay(pdMS_TO_TICKS(200));
+        vTaskDelay(pdMS_TO_TICKS(AKITA_APP_POLL_MS));
     }
 }
 
@@ -185,14 +1073,38 @@ esp_err_t akita_app_start(void) {
     ESP_LOGI(TAG, "Board profile: %s", akita_board_get_name(g_runtime_config.board_profile));
     akita_status_led_init();
 
+    g_geofence_lock = xSemaphoreCreateMutex();
+    if (g_geofence_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+#if CONFIG_AKITA_CAPTURE
+    err = akita_capture_store_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+#endif
+    err = akita_geofence_open();
+    if (err != ESP_OK && err != ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "Geofences not loaded: %s", esp_err_to_name(err));
+    }
+
     if (g_runtime_config.enable_config_ap) {
         akita_config_ui_set_apply_callback(akita_apply_runtime_config, NULL);
+        akita_config_ui_set_geofence_callback(akita_geofence_upload, NULL);
+        akita_config_ui_set_status_callback(akita_write_latency_status, NULL);
         err = akita_config_ui_start(&g_runtime_config);
-        if (err != ESP_OK) {
+        if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
             ESP_LOGE(TAG, "Config UI start failed: %s", esp_err_to_name(err));
         }
     }
 
+#if CONFIG_AKITA_CAPTURE_AT_BOOT
+    err = akita_capture_store_start_if_empty(g_runtime_config.gps_uart_baud);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Capture not started: %s", esp_err_to_name(err));
+    }
+#endif
+
     err = akita_gps_init(&g_runtime_config);
     if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
         ESP_LOGW(TAG, "GPS init failed: %s", esp_err_to_name(err));
@@ -208,6 +1120,23 @@ esp_err_t akita_app_start(void) {
         ESP_LOGW(TAG, "Transport init failed: %s", esp_err_to_name(err));
     }
 
+    akita_outbox_init(&g_outbox);
+    akita_publish_policy_init(&g_publish_policy);
+    akita_clock_init(&g_clock);
+    akita_fusion_init(&g_fusion);
+    akita_aggregate_reset(&g_window, (uint64_t) (esp_timer_get_time() / 1000ULL));
+    g_outbox_lock = xSemaphoreCreateMutex();
+    g_trip_lock = xSemaphoreCreateMutex();
+    if (g_outbox_lock == NULL || g_trip_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    akita_trip_restore(&g_runtime_config, (uint64_t) (esp_timer_get_time() / 1000ULL));
+
+    if (xTaskCreate(akita_uplink_task, "akita_uplink", AKITA_APP_UPLINK_TASK_STACK_SIZE, NULL,
+                    AKITA_APP_UPLINK_TASK_PRIORITY, &g_uplink_task) != pdPASS) {
+        return ESP_FAIL;
+    }
+
     if (xTaskCreate(akita_main_task, "akita_main_task", 8192, NULL, 5, NULL) != pdPASS) {
         return ESP_FAIL;
     }
@@ -0,0 +1,154 @@
+#include "akita_clock.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void akita_clock_init(akita_clock_t *clock) {
+    memset(clock, 0, sizeof(*clock));
+}
+
+static int64_t akita_clock_predict(const akita_clock_t *clock, uint64_t mono_us) {
+    int64_t elapsed_us = (int64_t) (mono_us - clock->ref_us);
+
+    return clock->offset_us + elapsed_us * clock->drift_ppb / 1000000000LL;
+}
+
+static void akita_clock_step(akita_clock_t *clock, akita_clock_source_t source, int64_t offset_us, uint64_t at_us) {
+    if (clock->source != AKITA_CLOCK_NONE) {
+        ++clock->steps;
+    }
+    clock->source = source;
+    clock->offset_us = offset_us;
+    clock->ref_us = at_us;
+    clock->anchor_offset_us = offset_us;
+    clock->anchor_us = at_us;
+}
+
+static void akita_clock_correct(akita_clock_t *clock, akita_clock_source_t source, int64_t offset_us, uint64_t at_us) {
+    int64_t predicted_us;
+    int64_t residual_us;
+
+    if (clock->source != source) {
+        akita_clock_step(clock, source, offset_us, at_us);
+        return;
+    }
+
+    predicted_us = akita_clock_predict(clock, at_us);
+    residual_us = offset_us - predicted_us;
+    if (llabs(residual_us) > AKITA_CLOCK_STEP_US) {
+        clock->drift_ppb = 0;
+        clock->has_drift = false;
+        akita_clock_step(clock, source, offset_us, at_us);
+        return;
+    }
+
+    clock->offset_us = predicted_us + residual_us / (source == AKITA_CLOCK_PPS ? 2 : 4);
+    clock->ref_us = at_us;
+
+    if (source == AKITA_CLOCK_PPS && at_us - clock->anchor_us >= AKITA_CLOCK_RATE_SPAN_US) {
+        int64_t rate_ppb = (offset_us - clock->anchor_offset_us) * 1000000000LL / (int64_t) (at_us - clock->anchor_us);
+
+        if (clock->has_drift) {
+            rate_ppb = clock->drift_ppb + (rate_ppb - clock->drift_ppb) / 4;
+        }
+        if (rate_ppb > AKITA_CLOCK_MAX_DRIFT_PPB) {
+            rate_ppb = AKITA_CLOCK_MAX_DRIFT_PPB;
+        } else if (rate_ppb < -AKITA_CLOCK_MAX_DRIFT_PPB) {
+            rate_ppb = -AKITA_CLOCK_MAX_DRIFT_PPB;
+        }
+        clock->drift_ppb = (int32_t) rate_ppb;
+        clock->has_drift = true;
+        clock->anchor_offset_us = offset_us;
+        clock->anchor_us = at_us;
+    }
+}
+
+void akita_clock_gps(akita_clock_t *clock, int64_t utc_ms, uint64_t received_us, uint64_t pps_us) {
+    akita_clock_source_t source = AKITA_CLOCK_NMEA;
+    uint64_t at_us = received_us;
+    int64_t offset_us;
+    int64_t score_us;
+
+    if (utc_ms <= 0 || utc_ms == clock->last_utc_ms) {
+        return;
+    }
+    clock->last_utc_ms = utc_ms;
+    ++clock->samples;
+
+    if (pps_us != 0U && pps_us <= received_us && received_us - pps_us < 1000000U && utc_ms % 1000 == 0) {
+        source = AKITA_CLOCK_PPS;
+        at_us = pps_us;
+    } else if (clock->source == AKITA_CLOCK_PPS &&
+               akita_clock_error_us(clock, received_us) < AKITA_CLOCK_NMEA_ERROR_US) {
+        /* Holding over on the PPS drift estimate still beats the sentence arrival time. */
+        return;
+    }
+
+    offset_us = utc_ms * 1000 - (int64_t) at_us;
+    if (clock->source == AKITA_CLOCK_NONE) {
+        akita_clock_step(clock, source, offset_us, at_us);
+    }
+
+    /* Late timestamps only ever make the offset smaller, so the largest one after drift is the best. */
+    score_us = offset_us - akita_clock_predict(clock, at_us);
+    if (clock->window_count == 0U || clock->window_source != source) {
+        clock->window_source = source;
+        clock->window_count = 0U;
+        clock->window_score_us = score_us;
+        clock->window_offset_us = offset_us;
+        clock->window_at_us = at_us;
+    } else if (score_us > clock->window_score_us) {
+        clock->window_score_us = score_us;
+        clock->window_offset_us = offset_us;
+        clock->window_at_us = at_us;
+    }
+
+    ++clock->window_count;
+    if (clock->window_count >= (source == AKITA_CLOCK_PPS ? AKITA_CLOCK_PPS_WINDOW : AKITA_CLOCK_NMEA_WINDOW)) {
+        akita_clock_correct(clock, source, clock->window_offset_us, clock->window_at_us);
+        clock->window_count = 0U;
+    }
+}
+
+bool akita_clock_is_set(const akita_clock_t *clock) {
+    return clock->source != AKITA_CLOCK_NONE;
+}
+
+int64_t akita_clock_offset_us(const akita_clock_t *clock, uint64_t mono_us) {
+    return akita_clock_is_set(clock) ? akita_clock_predict(clock, mono_us) : 0;
+}
+
+bool akita_clock_utc_ms(const akita_clock_t *clock, uint64_t mono_us, int64_t *utc_ms) {
+    if (!akita_clock_is_set(clock)) {
+        return false;
+    }
+
+    *utc_ms = ((int64_t) mono_us + akita_clock_predict(clock, mono_us)) / 1000;
+    return true;
+}
+
+uint32_t akita_clock_error_us(const akita_clock_t *clock, uint64_t mono_us) {
+    uint64_t elapsed_us;
+    uint64_t error_us;
+
+    if (!akita_clock_is_set(clock)) {
+        return UINT32_MAX;
+    }
+
+    elapsed_us = mono_us > clock->ref_us ? mono_us - clock->ref_us : clock->ref_us - mono_us;
+    error_us = clock->source == AKITA_CLOCK_PPS ? AKITA_CLOCK_PPS_ERROR_US : AKITA_CLOCK_NMEA_ERROR_US;
+    error_us += elapsed_us * (clock->has_drift ? AKITA_CLOCK_HOLDOVER_PPB : AKITA_CLOCK_FREE_RUN_PPB) / 1000000000ULL;
+    return error_us > UINT32_MAX ? UINT32_MAX : (uint32_t) error_us;
+}
+
+const char *akita_clock_source_name(akita_clock_source_t source) {
+    switch (source) {
+        case AKITA_CLOCK_NMEA:
+            return "nmea";
+        case AKITA_CLOCK_PPS:
+            return "pps";
+        case AKITA_CLOCK_NONE:
+        default:
+            return "none";
+    }
+}
@@ -0,0 +1,218 @@
+#include "akita_fragment.h"
+
+#include <string.h>
+
+static uint8_t akita_fragment_header(akita_frame_type_t type) {
+    return (uint8_t) ((AKITA_FRAME_VERSION << 4) | ((uint8_t) type & AKITA_FRAME_HEADER_TYPE_MASK));
+}
+
+static bool akita_fragment_is_type(const uint8_t *frame, size_t frame_len, akita_frame_type_t type, size_t min_len) {
+    return frame != NULL && frame_len >= min_len &&
+           (frame[0] >> 4) == AKITA_FRAME_VERSION &&
+           (frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) == (uint8_t) type;
+}
+
+static uint16_t akita_fragment_node_tag(const uint8_t *frame) {
+    return (uint16_t) (frame[1] | ((uint16_t) frame[2] << 8));
+}
+
+static uint16_t akita_fragment_full_mask(uint8_t count) {
+    return (uint16_t) ((1UL << count) - 1UL);
+}
+
+static size_t akita_fragment_capacity(size_t max_frame_len) {
+    if (max_frame_len > AKITA_FRAME_MAX_LEN) {
+        max_frame_len = AKITA_FRAME_MAX_LEN;
+    }
+
+    return max_frame_len > AKITA_FRAGMENT_HEADER_LEN ? max_frame_len - AKITA_FRAGMENT_HEADER_LEN : 0U;
+}
+
+size_t akita_fragment_count(size_t payload_len, size_t max_frame_len) {
+    size_t capacity = akita_fragment_capacity(max_frame_len);
+    size_t count;
+
+    if (payload_len == 0U) {
+        return 0;
+    }
+    if (payload_len <= max_frame_len && payload_len <= AKITA_FRAME_MAX_LEN) {
+        return 1;
+    }
+    if (capacity == 0U || payload_len > AKITA_FRAGMENT_MAX_MESSAGE_LEN) {
+        return 0;
+    }
+
+    count = (payload_len + capacity - 1U) / capacity;
+    return count <= AKITA_FRAGMENT_MAX_COUNT ? count : 0U;
+}
+
+void akita_fragment_sender_init(akita_fragment_sender_t *sender) {
+    if (sender != NULL) {
+        memset(sender, 0, sizeof(*sender));
+    }
+}
+
+uint8_t akita_fragment_sender_begin(
+    akita_fragment_sender_t *sender,
+    uint16_t node_tag,
+    akita_message_class_t message_class,
+    const uint8_t *payload,
+    size_t payload_len,
+    size_t max_frame_len,
+    uint64_t now_ms
+) {
+    akita_fragment_message_t *message;
+    size_t capacity = akita_fragment_capacity(max_frame_len);
+    size_t count;
+
+    if (sender == NULL || payload == NULL || payload_len == 0U || capacity == 0U ||
+        payload_len > AKITA_FRAGMENT_MAX_MESSAGE_LEN) {
+        return 0;
+    }
+
+    count = (payload_len + capacity - 1U) / capacity;
+    if (count > AKITA_FRAGMENT_MAX_COUNT) {
+        return 0;
+    }
+
+    /* Spread the payload evenly so the last fragment is not a runt. */
+    message = &sender->messages[sender->next_slot];
+    sender->next_slot = (uint8_t) ((sender->next_slot + 1U) % AKITA_FRAGMENT_RETAIN_MESSAGES);
+    memset(message, 0, sizeof(*message));
+    message->in_use = true;
+    message->node_tag = node_tag;
+    message->message_id = sender->next_message_id++;
+    message->count = (uint8_t) count;
+    message->chunk_len = (uint8_t) ((payload_len + count - 1U) / count);
+    message->message_class = message_class;
+    message->pending_mask = akita_fragment_full_mask(message->count);
+    message->length = (uint16_t) payload_len;
+    message->created_ms = now_ms;
+    memcpy(message->data, payload, payload_len);
+    return message->count;
+}
+
+static akita_fragment_message_t *akita_fragment_sender_find(
+    akita_fragment_sender_t *sender,
+    uint16_t node_tag,
+    uint8_t message_id,
+    uint64_t now_ms
+) {
+    size_t index;
+
+    for (index = 0; index < AKITA_FRAGMENT_RETAIN_MESSAGES; ++index) {
+        akita_fragment_message_t *message = &sender->messages[index];
+
+        if (message->in_use && now_ms - message->created_ms >= AKITA_FRAGMENT_RETAIN_MS) {
+            message->in_use = false;
+        }
+        if (message->in_use && message->node_tag == node_tag && message->message_id == message_id) {
+            return message;
+        }
+    }
+
+    return NULL;
+}
+
+size_t akita_fragment_sender_next(
+    akita_fragment_sender_t *sender,
+    uint64_t now_ms,
+    uint8_t *buffer,
+    size_t buffer_size,
+    akita_message_class_t *message_class
+) {
+    akita_fragment_message_t *oldest = NULL;
+    size_t offset;
+    size_t length;
+    uint8_t fragment = 0;
+    size_t index;
+
+    if (sender == NULL || buffer == NULL) {
+        return 0;
+    }
+
+    for (index = 0; index < AKITA_FRAGMENT_RETAIN_MESSAGES; ++index) {
+        akita_fragment_message_t *message = &sender->messages[index];
+
+        if (message->in_use && now_ms - message->created_ms >= AKITA_FRAGMENT_RETAIN_MS) {
+            message->in_use = false;
+        }
+        if (message->in_use && message->pending_mask != 0U &&
+            (oldest == NULL || message->created_ms < oldest->created_ms)) {
+            oldest = message;
+        }
+    }
+
+    if (oldest == NULL) {
+        return 0;
+    }
+
+    while ((oldest->pending_mask & (1U << fragment)) == 0U) {
+        ++fragment;
+    }
+
+    offset = (size_t) fragment * oldest->chunk_len;
+    length = oldest->length - offset;
+    if (length > oldest->chunk_len) {
+        length = oldest->chunk_len;
+    }
+    if (buffer_size < AKITA_FRAGMENT_HEADER_LEN + length) {
+        return 0;
+    }
+
+    buffer[0] = akita_fragment_header(AKITA_FRAME_TYPE_FRAGMENT);
+    buffer[1] = (uint8_t) (oldest->node_tag & 0xFFU);
+    buffer[2] = (uint8_t) (oldest->node_tag >> 8);
+    buffer[3] = oldest->message_id;
+    buffer[4] = (uint8_t) ((fragment << 4) | (oldest->count - 1U));
+    buffer[5] = oldest->chunk_len;
+    memcpy(&buffer[AKITA_FRAGMENT_HEADER_LEN], &oldest->data[offset], length);
+    if (message_class != NULL) {
+        *message_class = oldest->message_class;
+    }
+    return AKITA_FRAGMENT_HEADER_LEN + length;
+}
+
+void akita_fragment_sender_mark_sent(akita_fragment_sender_t *sender, const uint8_t *frame, size_t frame_len) {
+    size_t index;
+
+    if (sender == NULL || !akita_fragment_is_type(frame, frame_len, AKITA_FRAME_TYPE_FRAGMENT, AKITA_FRAGMENT_HEADER_LEN)) {
+        return;
+    }
+
+    for (index = 0; index < AKITA_FRAGMENT_RETAIN_MESSAGES; ++index) {
+        akita_fragment_message_t *message = &sender->messages[index];
+
+        if (message->in_use && message->node_tag == akita_fragment_node_tag(frame) && message->message_id == frame[3]) {
+            message->pending_mask &= (uint16_t) ~(1U << (frame[4] >> 4));
+            return;
+        }
+    }
+}
+
+bool akita_fragment_sender_on_nack(akita_fragment_sender_t *sender, const uint8_t *frame, size_t frame_len, uint64_t now_ms) {
+    akita_fragment_message_t *message;
+    uint16_t missing;
+    uint8_t bit;
+
+    if (sender == NULL || !akita_fragment_is_type(frame, frame_len, AKITA_FRAME_TYPE_NACK, AKITA_FRAGMENT_NACK_LEN)) {
+        return false;
+    }
+
+    message = akita_fragment_sender_find(sender, akita_fragment_node_tag(frame), frame[3], now_ms);
+    if (message == NULL) {
+        ++sender->nacks_ignored;
+        return false;
+    }
+
+    missing = (uint16_t) (frame[4] | ((uint16_t) frame[5] << 8));
+    missing &= akita_fragment_full_mask(message->count);
+    for (bit = 0; bit < message->count; ++bit) {
+        if ((missing & (1U << bit)) != 0U && (message->pending_mask & (1U << bit)) == 0U) {
+            ++sender->fragments_resent;
+        }
+    }
+    message->pending_mask |= missing;
+    ++sender->nacks_accepted;
+    return true;
+}
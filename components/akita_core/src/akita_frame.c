@@ -0,0 +1,380 @@
+#include "akita_frame.h"
+
+#include <string.h>
+
+#define AKITA_FRAME_VEHICLE_ID_MAX_LEN 31U
+
+#define AKITA_FRAME_QUANTIZE_FLAG(id, member, wire, param) \
+    if (telemetry->member) { \
+        flags |= (int32_t) (1UL << AKITA_FRAME_FLAG_BIT_##id); \
+    }
+#define AKITA_FRAME_QUANTIZE_RAW(id, member, wire, param) \
+    values[AKITA_FRAME_FIELD_##id] = (int32_t) telemetry->member;
+#define AKITA_FRAME_QUANTIZE_SCALE(id, member, wire, param) \
+    values[AKITA_FRAME_FIELD_##id] = akita_frame_scale(telemetry->member, (double) (param));
+#define AKITA_FRAME_QUANTIZE_DIV(id, member, wire, param) \
+    values[AKITA_FRAME_FIELD_##id] = (int32_t) (telemetry->member / (param));
+#define AKITA_FRAME_QUANTIZE(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_QUANTIZE_, id, member, frame)
+
+#define AKITA_FRAME_FIELD_CASE_FLAG(id, member, wire, param)
+#define AKITA_FRAME_FIELD_CASE_RAW(id, member, wire, param) case AKITA_FRAME_FIELD_##id:
+#define AKITA_FRAME_FIELD_CASE_SCALE(id, member, wire, param) case AKITA_FRAME_FIELD_##id:
+#define AKITA_FRAME_FIELD_CASE_DIV(id, member, wire, param) case AKITA_FRAME_FIELD_##id:
+#define AKITA_FRAME_FIELD_CASE(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_FIELD_CASE_, id, member, frame)
+#define AKITA_FRAME_FLAG_CASE_FLAG(id, member, wire, param) case AKITA_FRAME_FLAG_BIT_##id:
+#define AKITA_FRAME_FLAG_CASE_RAW(id, member, wire, param)
+#define AKITA_FRAME_FLAG_CASE_SCALE(id, member, wire, param)
+#define AKITA_FRAME_FLAG_CASE_DIV(id, member, wire, param)
+#define AKITA_FRAME_FLAG_CASE(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_TELEMETRY_FRAME_DISPATCH(AKITA_FRAME_FLAG_CASE_, id, member, frame)
+
+_Static_assert(AKITA_FRAME_FIELD_COUNT <= 32U, "delta frames carry a 32-bit changed-field mask");
+_Static_assert(AKITA_FRAME_FLAG_BIT_COUNT <= 31U, "flags travel as one positive int32 field");
+
+/* Never called: two fields given the same wire id become duplicate case labels, which do not compile. */
+static inline void akita_frame_check_wire_ids(int field, int flag_bit) {
+    switch (field) {
+    case AKITA_FRAME_FIELD_FLAGS:
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_FIELD_CASE)
+        break;
+    }
+    switch (flag_bit) {
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_FLAG_CASE)
+        break;
+    }
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t used;
+    bool overflow;
+} akita_frame_writer_t;
+
+static void akita_frame_put_byte(akita_frame_writer_t *writer, uint8_t value) {
+    if (writer->used >= writer->size) {
+        writer->overflow = true;
+        return;
+    }
+
+    writer->data[writer->used++] = value;
+}
+
+static void akita_frame_put_varint(akita_frame_writer_t *writer, uint64_t value) {
+    while (value >= 0x80U) {
+        akita_frame_put_byte(writer, (uint8_t) (value | 0x80U));
+        value >>= 7;
+    }
+    akita_frame_put_byte(writer, (uint8_t) value);
+}
+
+static uint64_t akita_frame_zigzag(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static uint8_t akita_frame_header(akita_frame_type_t type, bool ack_request) {
+    return (uint8_t) ((AKITA_FRAME_VERSION << 4) |
+                      (ack_request ? AKITA_FRAME_HEADER_ACK_REQUEST : 0U) |
+                      ((uint8_t) type & AKITA_FRAME_HEADER_TYPE_MASK));
+}
+
+static int32_t akita_frame_scale(float value, double scale) {
+    double scaled = (double) value * scale;
+
+    if (scaled != scaled) {
+        return 0;
+    }
+    if (scaled >= 2147483647.0) {
+        return INT32_MAX;
+    }
+    if (scaled <= -2147483648.0) {
+        return INT32_MIN;
+    }
+
+    return (int32_t) (scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5);
+}
+
+static void akita_frame_quantize(const akita_vehicle_telemetry_t *telemetry, int32_t *values) {
+    int32_t flags = 0;
+
+    AKITA_TELEMETRY_FIELDS(AKITA_FRAME_QUANTIZE)
+    values[AKITA_FRAME_FIELD_FLAGS] = flags;
+}
+
+static const akita_frame_state_t *akita_frame_delta_base(const akita_frame_encoder_t *encoder) {
+    if (encoder->acks_seen && encoder->acked.valid && encoder->keyframes_since_ack < AKITA_FRAME_KEYFRAME_HISTORY) {
+        return &encoder->acked;
+    }
+
+    return &encoder->reference;
+}
+
+static bool akita_frame_needs_keyframe(const akita_frame_encoder_t *encoder, uint64_t timestamp_ms) {
+    if (!encoder->reference.valid || encoder->keyframe_requested) {
+        return true;
+    }
+
+    if (timestamp_ms < akita_frame_delta_base(encoder)->timestamp_ms) {
+        return true;
+    }
+
+    if ((uint32_t) encoder->frames_since_keyframe + 1U >= encoder->keyframe_interval) {
+        return true;
+    }
+
+    return encoder->acks_seen &&
+           !encoder->reference_acked &&
+           encoder->frames_since_keyframe >= AKITA_FRAME_ACK_GRACE_FRAMES;
+}
+
+static size_t akita_frame_write_keyframe(
+    const akita_frame_encoder_t *encoder,
+    const akita_runtime_config_t *config,
+    const akita_frame_state_t *current,
+    uint8_t *buffer,
+    size_t buffer_size
+) {
+    akita_frame_writer_t writer = { .data = buffer, .size = buffer_size };
+    size_t id_len = strlen(config->vehicle_id);
+    size_t index;
+
+    if (id_len > AKITA_FRAME_VEHICLE_ID_MAX_LEN) {
+        id_len = AKITA_FRAME_VEHICLE_ID_MAX_LEN;
+    }
+
+    akita_frame_put_byte(&writer, akita_frame_header(AKITA_FRAME_TYPE_KEYFRAME, true));
+    akita_frame_put_byte(&writer, (uint8_t) (encoder->node_tag & 0xFFU));
+    akita_frame_put_byte(&writer, (uint8_t) (encoder->node_tag >> 8));
+    akita_frame_put_byte(&writer, current->sequence);
+    akita_frame_put_byte(&writer, (uint8_t) config->board_profile);
+    akita_frame_put_byte(&writer, (uint8_t) id_len);
+    for (index = 0; index < id_len; ++index) {
+        akita_frame_put_byte(&writer, (uint8_t) config->vehicle_id[index]);
+    }
+    akita_frame_put_varint(&writer, current->timestamp_ms);
+    for (index = 0; index < AKITA_FRAME_FIELD_COUNT; ++index) {
+        akita_frame_put_varint(&writer, akita_frame_zigzag(current->values[index]));
+    }
+
+    return writer.overflow ? 0U : writer.used;
+}
+
+static size_t akita_frame_write_delta(
+    const akita_frame_encoder_t *encoder,
+    const akita_frame_state_t *current,
+    uint8_t *buffer,
+    size_t buffer_size
+) {
+    akita_frame_writer_t writer = { .data = buffer, .size = buffer_size };
+    const akita_frame_state_t *reference = akita_frame_delta_base(encoder);
+    uint32_t mask = 0;
+    size_t index;
+
+    for (index = 0; index < AKITA_FRAME_FIELD_COUNT; ++index) {
+        if (current->values[index] != reference->values[index]) {
+            mask |= 1UL << index;
+        }
+    }
+
+    akita_frame_put_byte(&writer, akita_frame_header(AKITA_FRAME_TYPE_DELTA, false));
+    akita_frame_put_byte(&writer, (uint8_t) (encoder->node_tag & 0xFFU));
+    akita_frame_put_byte(&writer, (uint8_t) (encoder->node_tag >> 8));
+    akita_frame_put_byte(&writer, current->sequence);
+    akita_frame_put_byte(&writer, reference->sequence);
+    akita_frame_put_varint(&writer, mask);
+    akita_frame_put_varint(&writer, current->timestamp_ms - reference->timestamp_ms);
+    for (index = 0; index < AKITA_FRAME_FIELD_COUNT; ++index) {
+        if ((mask & (1UL << index)) != 0U) {
+            int64_t delta = (int64_t) current->values[index] - (int64_t) reference->values[index];
+            akita_frame_put_varint(&writer, akita_frame_zigzag(delta));
+        }
+    }
+
+    return writer.overflow ? 0U : writer.used;
+}
+
+uint16_t akita_frame_node_tag(const char *vehicle_id) {
+    uint32_t hash = 2166136261UL;
+    const char *cursor = vehicle_id != NULL ? vehicle_id : "";
+
+    while (*cursor != '\0') {
+        hash ^= (uint8_t) *cursor++;
+        hash *= 16777619UL;
+    }
+
+    return (uint16_t) ((hash >> 16) ^ (hash & 0xFFFFU));
+}
+
+void akita_frame_encoder_init(akita_frame_encoder_t *encoder, const char *vehicle_id, uint8_t keyframe_interval) {
+    if (encoder == NULL) {
+        return;
+    }
+
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->node_tag = akita_frame_node_tag(vehicle_id);
+    encoder->keyframe_interval = keyframe_interval > 0U ? keyframe_interval : AKITA_FRAME_DEFAULT_KEYFRAME_INTERVAL;
+}
+
+void akita_frame_encoder_request_keyframe(akita_frame_encoder_t *encoder) {
+    if (encoder != NULL) {
+        encoder->keyframe_requested = true;
+    }
+}
+
+bool akita_frame_encoder_on_ack(akita_frame_encoder_t *encoder, const uint8_t *frame, size_t frame_len) {
+    uint16_t node_tag;
+
+    if (encoder == NULL || frame == NULL || frame_len < AKITA_FRAME_HEADER_LEN) {
+        return false;
+    }
+
+    if ((frame[0] >> 4) != AKITA_FRAME_VERSION ||
+        (frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) != AKITA_FRAME_TYPE_ACK) {
+        return false;
+    }
+
+    node_tag = (uint16_t) (frame[1] | ((uint16_t) frame[2] << 8));
+    if (node_tag != encoder->node_tag) {
+        return false;
+    }
+
+    encoder->acks_seen = true;
+    if (encoder->reference.valid && frame[3] == encoder->reference.sequence) {
+        encoder->reference_acked = true;
+        encoder->acked = encoder->reference;
+        encoder->keyframes_since_ack = 0;
+    }
+
+    return true;
+}
+
+size_t akita_frame_encode(
+    akita_frame_encoder_t *encoder,
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t timestamp_ms,
+    uint8_t *buffer,
+    size_t buffer_size
+) {
+    akita_frame_state_t current;
+    size_t used = 0;
+
+    if (encoder == NULL || config == NULL || telemetry == NULL || buffer == NULL || buffer_size < AKITA_FRAME_HEADER_LEN) {
+        return 0;
+    }
+
+    memset(&current, 0, sizeof(current));
+    current.valid = true;
+    current.sequence = encoder->next_sequence;
+    current.timestamp_ms = timestamp_ms;
+    akita_frame_quantize(telemetry, current.values);
+
+    if (!akita_frame_needs_keyframe(encoder, timestamp_ms)) {
+        used = akita_frame_write_delta(encoder, &current, buffer, buffer_size);
+        if (used > 0U) {
+            ++encoder->frames_since_keyframe;
+        }
+    }
+
+    if (used == 0U) {
+        used = akita_frame_write_keyframe(encoder, config, &current, buffer, buffer_size);
+        if (used == 0U) {
+            return 0;
+        }
+
+        encoder->reference = current;
+        encoder->reference_acked = false;
+        if (encoder->keyframes_since_ack < AKITA_FRAME_KEYFRAME_HISTORY) {
+            ++encoder->keyframes_since_ack;
+        }
+        encoder->keyframe_requested = false;
+        encoder->frames_since_keyframe = 0;
+    }
+
+    ++encoder->next_sequence;
+    return used;
+}
+
+size_t akita_frame_encode_event(
+    akita_frame_encoder_t *encoder,
+    const akita_frame_event_t *event,
+    uint64_t timestamp_ms,
+    uint8_t *buffer,
+    size_t buffer_size
+) {
+    akita_frame_writer_t writer = { .data = buffer, .size = buffer_size };
+    const char *name;
+    bool has_value;
+    size_t name_len;
+    size_t index;
+
+    if (encoder == NULL || event == NULL || buffer == NULL || !encoder->reference.valid) {
+        return 0;
+    }
+
+    name = event->name != NULL ? event->name : "";
+    name_len = strlen(name);
+    if (name_len > AKITA_FRAME_EVENT_NAME_MAX_LEN) {
+        name_len = AKITA_FRAME_EVENT_NAME_MAX_LEN;
+    }
+    has_value = event->value == event->value;
+
+    akita_frame_put_byte(&writer, akita_frame_header(AKITA_FRAME_TYPE_EVENT, false));
+    akita_frame_put_byte(&writer, (uint8_t) (encoder->node_tag & 0xFFU));
+    akita_frame_put_byte(&writer, (uint8_t) (encoder->node_tag >> 8));
+    akita_frame_put_byte(&writer, encoder->next_sequence);
+    akita_frame_put_byte(&writer, encoder->reference.sequence);
+    akita_frame_put_varint(&writer, timestamp_ms > encoder->reference.timestamp_ms
+                                        ? timestamp_ms - encoder->reference.timestamp_ms
+                                        : 0U);
+    akita_frame_put_byte(&writer, (uint8_t) ((uint8_t) event->source | (has_value ? AKITA_FRAME_EVENT_HAS_VALUE : 0U)));
+    akita_frame_put_byte(&writer, event->action);
+    akita_frame_put_varint(&writer, event->id);
+    if (has_value) {
+        akita_frame_put_varint(&writer, akita_frame_zigzag(akita_frame_scale(event->value, 100.0)));
+    }
+    akita_frame_put_byte(&writer, (uint8_t) name_len);
+    for (index = 0; index < name_len; ++index) {
+        akita_frame_put_byte(&writer, (uint8_t) name[index]);
+    }
+    if (writer.overflow) {
+        return 0;
+    }
+
+    ++encoder->next_sequence;
+    return writer.used;
+}
+
+int8_t akita_frame_ack_uplink_snr(const uint8_t *frame, size_t frame_len) {
+    if (frame == NULL || frame_len <= AKITA_FRAME_HEADER_LEN ||
+        (frame[0] & AKITA_FRAME_HEADER_TYPE_MASK) != AKITA_FRAME_TYPE_ACK) {
+        return AKITA_FRAME_ACK_SNR_UNKNOWN;
+    }
+
+    return (int8_t) frame[AKITA_FRAME_HEADER_LEN];
+}
+
+size_t akita_frame_write_ack(
+    uint16_t node_tag,
+    uint8_t sequence,
+    int8_t uplink_snr_quarter_db,
+    uint8_t *buffer,
+    size_t buffer_size
+) {
+    size_t length = uplink_snr_quarter_db == AKITA_FRAME_ACK_SNR_UNKNOWN ? AKITA_FRAME_HEADER_LEN : AKITA_FRAME_HEADER_LEN + 1U;
+
+    if (buffer == NULL || buffer_size < length) {
+        return 0;
+    }
+
+    buffer[0] = akita_frame_header(AKITA_FRAME_TYPE_ACK, false);
+    buffer[1] = (uint8_t) (node_tag & 0xFFU);
+    buffer[2] = (uint8_t) (node_tag >> 8);
+    buffer[3] = sequence;
+    if (length > AKITA_FRAME_HEADER_LEN) {
+        buffer[AKITA_FRAME_HEADER_LEN] = (uint8_t) uplink_snr_quarter_db;
+    }
+    return length;
+}
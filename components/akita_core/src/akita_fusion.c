@@ -0,0 +1,257 @@
+#include "akita_fusion.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AKITA_FUSION_LAT_M_PER_UDEG 0.11132
+#define AKITA_FUSION_RECENTRE_M 2048
+/* Further than this from the origin, a fix restarts the filter instead of overflowing Q16.16. */
+#define AKITA_FUSION_MAX_OFFSET_UDEG 200000
+#define AKITA_FUSION_MAX_STEP_MS 1000U
+#define AKITA_FUSION_GPS_VARIANCE_M2 16
+#define AKITA_FUSION_COURSE_MIN_KMH 10.0f
+#define AKITA_FUSION_SCALE_MIN_KMH 20.0f
+/* Consecutive fixes outside the gate before the filter gives up on its own estimate. */
+#define AKITA_FUSION_REJECT_LIMIT 3U
+#define AKITA_FUSION_DEG_TO_RAD 0.017453292519943f
+
+#if CONFIG_AKITA_FUSION_FIXED
+/* sin(i * pi / 128) in Q16.16, a quarter wave. */
+static const int32_t kSinQuarter[65] = {
+    0, 1608, 3216, 4821, 6424, 8022, 9616, 11204, 12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+    25080, 26558, 28020, 29466, 30893, 32303, 33692, 35062, 36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190,
+    46341, 47464, 48559, 49624, 50660, 51665, 52639, 53581, 54491, 55368, 56212, 57022, 57798, 58538, 59244, 59914,
+    60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944, 64277, 64571, 64827, 65043, 65220, 65358, 65457, 65516,
+    65536,
+};
+#endif
+
+static akita_fx_t akita_fusion_sin(uint16_t angle) {
+#if CONFIG_AKITA_FUSION_FIXED
+    uint16_t offset = angle & 0x3FFFU;
+    uint16_t index;
+    int32_t value;
+
+    if ((angle & 0x4000U) != 0U) {
+        offset = (uint16_t) (0x4000U - offset);
+    }
+
+    index = offset >> 8;
+    value = kSinQuarter[index];
+    if (index < 64U) {
+        value += ((kSinQuarter[index + 1U] - value) * (int32_t) (offset & 0xFFU)) / 256;
+    }
+
+    return (angle & 0x8000U) != 0U ? -value : value;
+#else
+    return sinf((float) angle * (6.283185307f / 65536.0f));
+#endif
+}
+
+static akita_fx_t akita_fusion_abs(akita_fx_t value) {
+    return value < 0 ? -value : value;
+}
+
+static akita_fx_t akita_fusion_gps_variance(const akita_gps_snapshot_t *gps) {
+    /* Few satellites usually means a poor geometry; trust the fix less. */
+    if (gps->satellites > 0U && gps->satellites < 6U) {
+        return AKITA_FX_INT(AKITA_FUSION_GPS_VARIANCE_M2 * 4);
+    }
+
+    return AKITA_FX_INT(AKITA_FUSION_GPS_VARIANCE_M2);
+}
+
+static void akita_fusion_set_origin(akita_fusion_t *fusion, int32_t latitude_e6, int32_t longitude_e6) {
+    fusion->origin_latitude_e6 = latitude_e6;
+    fusion->origin_longitude_e6 = longitude_e6;
+    fusion->lat_scale = AKITA_FX(AKITA_FUSION_LAT_M_PER_UDEG);
+    /* Once per origin move, so a soft-float cosine costs nothing per step. */
+    fusion->lon_scale = AKITA_FX_FROM_FLOAT((float) AKITA_FUSION_LAT_M_PER_UDEG *
+                                            cosf((float) latitude_e6 * 1.0e-6f * AKITA_FUSION_DEG_TO_RAD));
+}
+
+static void akita_fusion_reset(akita_fusion_t *fusion, const akita_gps_snapshot_t *gps, int32_t latitude_e6,
+                               int32_t longitude_e6, uint64_t fix_ms) {
+    akita_fusion_set_origin(fusion, latitude_e6, longitude_e6);
+    fusion->east_m = 0;
+    fusion->north_m = 0;
+    fusion->variance_m2 = akita_fusion_gps_variance(gps);
+    fusion->last_fix_ms = fix_ms;
+    fusion->rejected = 0;
+    fusion->has_origin = true;
+}
+
+/* Moves the origin under the vehicle, keeping the fraction of a microdegree the move cannot represent. */
+static void akita_fusion_recentre(akita_fusion_t *fusion) {
+    int32_t dlat;
+    int32_t dlon;
+
+    if (akita_fusion_abs(fusion->east_m) < AKITA_FX_INT(AKITA_FUSION_RECENTRE_M) &&
+        akita_fusion_abs(fusion->north_m) < AKITA_FX_INT(AKITA_FUSION_RECENTRE_M)) {
+        return;
+    }
+
+    dlat = (int32_t) (fusion->north_m / fusion->lat_scale);
+    dlon = (int32_t) (fusion->east_m / fusion->lon_scale);
+    fusion->north_m -= (akita_fx_t) ((akita_fx_wide_t) dlat * fusion->lat_scale);
+    fusion->east_m -= (akita_fx_t) ((akita_fx_wide_t) dlon * fusion->lon_scale);
+    akita_fusion_set_origin(fusion, fusion->origin_latitude_e6 + dlat, fusion->origin_longitude_e6 + dlon);
+}
+
+static void akita_fusion_correct(
+    akita_fusion_t *fusion,
+    const akita_gps_snapshot_t *gps,
+    bool has_yaw,
+    uint64_t fix_ms
+) {
+    int32_t latitude_e6 = (int32_t) lroundf(gps->latitude * 1.0e6f);
+    int32_t longitude_e6 = (int32_t) lroundf(gps->longitude * 1.0e6f);
+    int32_t dlat = latitude_e6 - fusion->origin_latitude_e6;
+    int32_t dlon = longitude_e6 - fusion->origin_longitude_e6;
+    akita_fx_t variance = akita_fusion_gps_variance(gps);
+    akita_fx_t north_error;
+    akita_fx_t east_error;
+    akita_fx_t gain;
+
+    fusion->last_fix_ms = fix_ms;
+    ++fusion->fixes;
+
+    /* Course over ground is only meaningful while moving; without a gyro it is the only heading source. */
+    if (gps->speed_kmh >= AKITA_FUSION_COURSE_MIN_KMH && isfinite(gps->course_deg)) {
+        uint16_t course = (uint16_t) (int32_t) lroundf(gps->course_deg * (65536.0f / 360.0f));
+
+        if (!fusion->has_heading) {
+            fusion->heading = course;
+            fusion->has_heading = true;
+        } else {
+            fusion->heading = (uint16_t) (fusion->heading + (int16_t) (course - fusion->heading) / (has_yaw ? 8 : 2));
+        }
+    }
+
+    if (abs(dlat) > AKITA_FUSION_MAX_OFFSET_UDEG || abs(dlon) > AKITA_FUSION_MAX_OFFSET_UDEG) {
+        akita_fusion_reset(fusion, gps, latitude_e6, longitude_e6, fix_ms);
+        return;
+    }
+
+    north_error = (akita_fx_t) ((akita_fx_wide_t) dlat * fusion->lat_scale) - fusion->north_m;
+    east_error = (akita_fx_t) ((akita_fx_wide_t) dlon * fusion->lon_scale) - fusion->east_m;
+
+    /* A fix five standard deviations off is a multipath jump; several in a row mean the estimate is what is wrong. */
+    if (AKITA_FX_SQ_WIDE(north_error) + AKITA_FX_SQ_WIDE(east_error) >
+        (akita_fx_wide_t) (fusion->variance_m2 + variance) * 25) {
+        if (++fusion->rejected >= AKITA_FUSION_REJECT_LIMIT) {
+            akita_fusion_reset(fusion, gps, latitude_e6, longitude_e6, fix_ms);
+        }
+        return;
+    }
+
+    fusion->rejected = 0;
+    gain = AKITA_FX_DIV(fusion->variance_m2, fusion->variance_m2 + variance);
+    fusion->north_m += AKITA_FX_MUL(gain, north_error);
+    fusion->east_m += AKITA_FX_MUL(gain, east_error);
+    fusion->variance_m2 = AKITA_FX_MUL(AKITA_FX_INT(1) - gain, fusion->variance_m2);
+}
+
+void akita_fusion_init(akita_fusion_t *fusion) {
+    memset(fusion, 0, sizeof(*fusion));
+    fusion->obd_scale = AKITA_FX_INT(1);
+}
+
+void akita_fusion_step(
+    akita_fusion_t *fusion,
+    const akita_gps_snapshot_t *gps,
+    const akita_obd_snapshot_t *obd,
+    int32_t yaw_rate_mdps,
+    uint64_t now_ms
+) {
+    bool fix_fresh;
+    bool new_fix;
+    uint64_t fix_ms;
+    uint32_t step_ms;
+    akita_fx_t dt;
+    akita_fx_t travelled;
+    akita_fx_t process;
+
+    if (fusion == NULL || gps == NULL || obd == NULL) {
+        return;
+    }
+
+    step_ms = fusion->last_step_ms != 0U && now_ms > fusion->last_step_ms ? (uint32_t) (now_ms - fusion->last_step_ms) : 0U;
+    if (step_ms > AKITA_FUSION_MAX_STEP_MS) {
+        step_ms = AKITA_FUSION_MAX_STEP_MS;
+    }
+    fusion->last_step_ms = now_ms;
+    ++fusion->steps;
+
+    /* The reader's own fix time, not one rebuilt from age_ms, so a fix polled twice is applied once. */
+    fix_ms = gps->fix_ms;
+    fix_fresh = gps->fix && fix_ms != 0U && gps->age_ms < AKITA_FUSION_FIX_STALE_MS;
+    new_fix = fix_fresh && fix_ms != fusion->last_fix_ms;
+
+    if (!fusion->has_origin) {
+        if (new_fix) {
+            akita_fusion_reset(fusion, gps, (int32_t) lroundf(gps->latitude * 1.0e6f),
+                               (int32_t) lroundf(gps->longitude * 1.0e6f), fix_ms);
+            fusion->speed_mps = AKITA_FX_FROM_FLOAT(gps->speed_kmh / 3.6f);
+            fusion->last_speed_ms = now_ms;
+            ++fusion->fixes;
+        }
+        return;
+    }
+
+    /* OBD speed arrives between fixes and through tunnels; its speedometer error is learned from GPS. */
+    if (obd->connected) {
+        if (new_fix && gps->speed_kmh >= AKITA_FUSION_SCALE_MIN_KMH && obd->speed_kmh >= AKITA_FUSION_SCALE_MIN_KMH) {
+            fusion->obd_scale += (AKITA_FX_FROM_FLOAT(gps->speed_kmh / obd->speed_kmh) - fusion->obd_scale) / 64;
+        }
+        fusion->speed_mps = AKITA_FX_MUL(AKITA_FX_FROM_FLOAT(obd->speed_kmh / 3.6f), fusion->obd_scale);
+        fusion->last_speed_ms = now_ms;
+    } else if (fix_fresh) {
+        fusion->speed_mps = AKITA_FX_FROM_FLOAT(gps->speed_kmh / 3.6f);
+        fusion->last_speed_ms = now_ms;
+    } else if (now_ms - fusion->last_speed_ms > AKITA_FUSION_COAST_MS) {
+        fusion->speed_mps = 0;
+    }
+
+    if (yaw_rate_mdps != AKITA_FUSION_NO_YAW) {
+        fusion->heading = (uint16_t) (fusion->heading + (int32_t) (((int64_t) yaw_rate_mdps * step_ms * 65536) / 360000000));
+    }
+
+    /* Predict: move along the heading, and grow the uncertainty faster at speed, where a heading error costs more. */
+    dt = AKITA_FX_DIV(AKITA_FX_INT(step_ms), AKITA_FX_INT(1000));
+    travelled = AKITA_FX_MUL(fusion->speed_mps, dt);
+    if (fusion->has_heading) {
+        fusion->east_m += AKITA_FX_MUL(travelled, akita_fusion_sin(fusion->heading));
+        fusion->north_m += AKITA_FX_MUL(travelled, akita_fusion_sin((uint16_t) (fusion->heading + 0x4000U)));
+    }
+    process = AKITA_FX(0.5) + AKITA_FX_MUL(AKITA_FX_MUL(fusion->speed_mps, fusion->speed_mps), AKITA_FX(0.01));
+    fusion->variance_m2 += AKITA_FX_MUL(process, dt);
+    if (fusion->variance_m2 > AKITA_FX_INT(AKITA_FUSION_MAX_SIGMA_M * AKITA_FUSION_MAX_SIGMA_M)) {
+        fusion->variance_m2 = AKITA_FX_INT(AKITA_FUSION_MAX_SIGMA_M * AKITA_FUSION_MAX_SIGMA_M);
+    }
+
+    if (new_fix) {
+        akita_fusion_correct(fusion, gps, yaw_rate_mdps != AKITA_FUSION_NO_YAW, fix_ms);
+    }
+
+    akita_fusion_recentre(fusion);
+}
+
+void akita_fusion_output(const akita_fusion_t *fusion, uint64_t now_ms, akita_fusion_output_t *output) {
+    memset(output, 0, sizeof(*output));
+    if (fusion == NULL || !fusion->has_origin) {
+        return;
+    }
+
+    output->outage_ms = now_ms > fusion->last_fix_ms ? (uint32_t) (now_ms - fusion->last_fix_ms) : 0U;
+    output->dead_reckoning = output->outage_ms >= AKITA_FUSION_FIX_STALE_MS;
+    output->latitude_e6 = fusion->origin_latitude_e6 + (int32_t) (fusion->north_m / fusion->lat_scale);
+    output->longitude_e6 = fusion->origin_longitude_e6 + (int32_t) (fusion->east_m / fusion->lon_scale);
+    output->speed_kmh = AKITA_FX_TO_FLOAT(fusion->speed_mps) * 3.6f;
+    output->heading_deg = (float) fusion->heading * (360.0f / 65536.0f);
+    output->sigma_m = sqrtf(AKITA_FX_TO_FLOAT(fusion->variance_m2));
+    /* Without a speed source the position stops being an estimate and becomes a guess. */
+    output->valid = output->sigma_m < (float) AKITA_FUSION_MAX_SIGMA_M &&
+                    now_ms - fusion->last_speed_ms <= AKITA_FUSION_COAST_MS;
+}
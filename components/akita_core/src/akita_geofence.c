@@ -0,0 +1,405 @@
+#include "akita_geofence.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Metres per microdegree of latitude. */
+#define AKITA_GEOFENCE_M_PER_E6 0.11132f
+
+void akita_geofence_init(akita_geofence_t *geofence) {
+    memset(geofence, 0, sizeof(*geofence));
+}
+
+uint32_t akita_geofence_crc32(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    size_t index;
+    int bit;
+
+    /* Bitwise rather than table driven; it only runs when an image is loaded. */
+    crc = ~crc;
+    for (index = 0; index < size; ++index) {
+        crc ^= bytes[index];
+        for (bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+
+    return ~crc;
+}
+
+static bool akita_geofence_record_is_valid(const akita_geofence_record_t *record, uint32_t vertex_count) {
+    if (record->vertex_count < 3U || record->vertex_count > AKITA_GEOFENCE_MAX_VERTICES ||
+        record->first_vertex > vertex_count || vertex_count - record->first_vertex < record->vertex_count) {
+        return false;
+    }
+    if (record->min_latitude_e6 > record->max_latitude_e6 || record->min_longitude_e6 > record->max_longitude_e6 ||
+        record->min_latitude_e6 < -90000000 || record->max_latitude_e6 > 90000000 ||
+        record->min_longitude_e6 < -180000000 || record->max_longitude_e6 > 180000000 || record->shift > 15U) {
+        return false;
+    }
+
+    return (((int64_t) record->max_latitude_e6 - record->min_latitude_e6) >> record->shift) <= UINT16_MAX &&
+           (((int64_t) record->max_longitude_e6 - record->min_longitude_e6) >> record->shift) <= UINT16_MAX;
+}
+
+static void akita_geofence_cells(const akita_geofence_t *geofence, const akita_geofence_record_t *record,
+                                 uint32_t *row_first, uint32_t *row_last, uint32_t *col_first, uint32_t *col_last) {
+    *row_first = (uint32_t) (record->min_latitude_e6 - geofence->grid_latitude_e6) / geofence->cell_latitude_e6;
+    *row_last = (uint32_t) (record->max_latitude_e6 - geofence->grid_latitude_e6) / geofence->cell_latitude_e6;
+    *col_first = (uint32_t) (record->min_longitude_e6 - geofence->grid_longitude_e6) / geofence->cell_longitude_e6;
+    *col_last = (uint32_t) (record->max_longitude_e6 - geofence->grid_longitude_e6) / geofence->cell_longitude_e6;
+}
+
+static uint32_t akita_geofence_set_grid(akita_geofence_t *geofence, uint32_t side, int32_t max_latitude_e6,
+                                        int32_t max_longitude_e6) {
+    uint32_t references = 0;
+    uint32_t row_first;
+    uint32_t row_last;
+    uint32_t col_first;
+    uint32_t col_last;
+    uint16_t fence;
+
+    geofence->grid_side = (uint8_t) side;
+    geofence->cell_latitude_e6 = (uint32_t) (((int64_t) max_latitude_e6 - geofence->grid_latitude_e6) / side + 1);
+    geofence->cell_longitude_e6 = (uint32_t) (((int64_t) max_longitude_e6 - geofence->grid_longitude_e6) / side + 1);
+
+    for (fence = 0; fence < geofence->fence_count; ++fence) {
+        akita_geofence_cells(geofence, &geofence->fences[fence], &row_first, &row_last, &col_first, &col_last);
+        references += (row_last - row_first + 1U) * (col_last - col_first + 1U);
+    }
+
+    return references;
+}
+
+static void akita_geofence_build_index(akita_geofence_t *geofence) {
+    int32_t max_latitude_e6 = geofence->fences[0].max_latitude_e6;
+    int32_t max_longitude_e6 = geofence->fences[0].max_longitude_e6;
+    uint32_t side = 1U;
+    uint32_t cells;
+    uint32_t cell;
+    uint32_t row;
+    uint32_t col;
+    uint32_t row_first;
+    uint32_t row_last;
+    uint32_t col_first;
+    uint32_t col_last;
+    uint16_t fence;
+
+    geofence->grid_latitude_e6 = geofence->fences[0].min_latitude_e6;
+    geofence->grid_longitude_e6 = geofence->fences[0].min_longitude_e6;
+    for (fence = 1; fence < geofence->fence_count; ++fence) {
+        const akita_geofence_record_t *record = &geofence->fences[fence];
+
+        geofence->grid_latitude_e6 = record->min_latitude_e6 < geofence->grid_latitude_e6 ? record->min_latitude_e6
+                                                                                         : geofence->grid_latitude_e6;
+        geofence->grid_longitude_e6 = record->min_longitude_e6 < geofence->grid_longitude_e6 ? record->min_longitude_e6
+                                                                                            : geofence->grid_longitude_e6;
+        max_latitude_e6 = record->max_latitude_e6 > max_latitude_e6 ? record->max_latitude_e6 : max_latitude_e6;
+        max_longitude_e6 = record->max_longitude_e6 > max_longitude_e6 ? record->max_longitude_e6 : max_longitude_e6;
+    }
+
+    /* About four cells per fence, fewer when large fences would spill over the reference budget. */
+    while (side * side < 4U * geofence->fence_count && side < AKITA_GEOFENCE_GRID_MAX_SIDE) {
+        side *= 2U;
+    }
+    while (side > 1U && akita_geofence_set_grid(geofence, side, max_latitude_e6, max_longitude_e6) > AKITA_GEOFENCE_INDEX_MAX) {
+        side /= 2U;
+    }
+    akita_geofence_set_grid(geofence, side, max_latitude_e6, max_longitude_e6);
+
+    /* Counting sort: per-cell counts, running totals, then each fence is placed walking back from the cell end. */
+    cells = side * side;
+    memset(geofence->cell_start, 0, sizeof(geofence->cell_start[0]) * (cells + 1U));
+    for (fence = 0; fence < geofence->fence_count; ++fence) {
+        akita_geofence_cells(geofence, &geofence->fences[fence], &row_first, &row_last, &col_first, &col_last);
+        for (row = row_first; row <= row_last; ++row) {
+            for (col = col_first; col <= col_last; ++col) {
+                ++geofence->cell_start[row * side + col];
+            }
+        }
+    }
+    for (cell = 1; cell < cells; ++cell) {
+        geofence->cell_start[cell] = (uint16_t) (geofence->cell_start[cell] + geofence->cell_start[cell - 1U]);
+    }
+    geofence->cell_start[cells] = geofence->cell_start[cells - 1U];
+    for (fence = geofence->fence_count; fence-- > 0;) {
+        akita_geofence_cells(geofence, &geofence->fences[fence], &row_first, &row_last, &col_first, &col_last);
+        for (row = row_first; row <= row_last; ++row) {
+            for (col = col_first; col <= col_last; ++col) {
+                geofence->cell_fences[--geofence->cell_start[row * side + col]] = fence;
+            }
+        }
+    }
+}
+
+esp_err_t akita_geofence_load(akita_geofence_t *geofence, const void *image, size_t size) {
+    const akita_geofence_header_t *header = (const akita_geofence_header_t *) image;
+    size_t expected;
+    uint16_t fence;
+
+    if (geofence == NULL || image == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    akita_geofence_init(geofence);
+    if (size < sizeof(*header) || header->magic != AKITA_GEOFENCE_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header->version != AKITA_GEOFENCE_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    expected = sizeof(*header) + (size_t) header->fence_count * sizeof(akita_geofence_record_t) +
+               (size_t) header->vertex_count * sizeof(akita_geofence_vertex_t);
+    if (header->fence_count > AKITA_GEOFENCE_MAX_FENCES ||
+        header->vertex_count > (uint32_t) AKITA_GEOFENCE_MAX_FENCES * AKITA_GEOFENCE_MAX_VERTICES ||
+        header->size != expected || header->size > size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (akita_geofence_crc32(0U, header + 1, header->size - sizeof(*header)) != header->crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    geofence->fences = (const akita_geofence_record_t *) (header + 1);
+    geofence->vertices = (const akita_geofence_vertex_t *) (geofence->fences + header->fence_count);
+    for (fence = 0; fence < header->fence_count; ++fence) {
+        if (!akita_geofence_record_is_valid(&geofence->fences[fence], header->vertex_count)) {
+            geofence->fences = NULL;
+            geofence->vertices = NULL;
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    geofence->fence_count = header->fence_count;
+    if (geofence->fence_count > 0U) {
+        akita_geofence_build_index(geofence);
+    }
+
+    return ESP_OK;
+}
+
+static bool akita_geofence_in_box(const akita_geofence_record_t *record, int32_t latitude_e6, int32_t longitude_e6) {
+    return latitude_e6 >= record->min_latitude_e6 && latitude_e6 <= record->max_latitude_e6 &&
+           longitude_e6 >= record->min_longitude_e6 && longitude_e6 <= record->max_longitude_e6;
+}
+
+bool akita_geofence_contains(const akita_geofence_t *geofence, uint16_t fence, int32_t latitude_e6, int32_t longitude_e6) {
+    const akita_geofence_record_t *record = &geofence->fences[fence];
+    const akita_geofence_vertex_t *vertices = &geofence->vertices[record->first_vertex];
+    int64_t y = (int64_t) latitude_e6 - record->min_latitude_e6;
+    int64_t x = (int64_t) longitude_e6 - record->min_longitude_e6;
+    int64_t previous_y;
+    int64_t previous_x;
+    bool inside = false;
+    uint16_t index;
+
+    if (!akita_geofence_in_box(record, latitude_e6, longitude_e6)) {
+        return false;
+    }
+
+    /* Crossing number on the ray toward +x, kept in integers so a fix on an edge always lands the same way. */
+    previous_y = (int64_t) vertices[record->vertex_count - 1U].latitude << record->shift;
+    previous_x = (int64_t) vertices[record->vertex_count - 1U].longitude << record->shift;
+    for (index = 0; index < record->vertex_count; ++index) {
+        int64_t vertex_y = (int64_t) vertices[index].latitude << record->shift;
+        int64_t vertex_x = (int64_t) vertices[index].longitude << record->shift;
+
+        if ((vertex_y > y) != (previous_y > y)) {
+            int64_t lhs = (x - vertex_x) * (previous_y - vertex_y);
+            int64_t rhs = (previous_x - vertex_x) * (y - vertex_y);
+
+            if (previous_y > vertex_y ? lhs < rhs : lhs > rhs) {
+                inside = !inside;
+            }
+        }
+        previous_y = vertex_y;
+        previous_x = vertex_x;
+    }
+
+    return inside;
+}
+
+/* Only asked about a fence the vehicle is leaving, so the float math stays off the per-fix path. */
+static bool akita_geofence_near(const akita_geofence_t *geofence, uint16_t fence, int32_t latitude_e6, int32_t longitude_e6,
+                                float margin_m) {
+    const akita_geofence_record_t *record = &geofence->fences[fence];
+    const akita_geofence_vertex_t *vertices = &geofence->vertices[record->first_vertex];
+    float lon_scale = AKITA_GEOFENCE_M_PER_E6 * cosf((float) latitude_e6 * 1.745329252e-8f);
+    float y = (float) ((int64_t) latitude_e6 - record->min_latitude_e6) * AKITA_GEOFENCE_M_PER_E6;
+    float x = (float) ((int64_t) longitude_e6 - record->min_longitude_e6) * lon_scale;
+    float previous_y = (float) ((int64_t) vertices[record->vertex_count - 1U].latitude << record->shift) * AKITA_GEOFENCE_M_PER_E6;
+    float previous_x = (float) ((int64_t) vertices[record->vertex_count - 1U].longitude << record->shift) * lon_scale;
+    uint16_t index;
+
+    for (index = 0; index < record->vertex_count; ++index) {
+        float vertex_y = (float) ((int64_t) vertices[index].latitude << record->shift) * AKITA_GEOFENCE_M_PER_E6;
+        float vertex_x = (float) ((int64_t) vertices[index].longitude << record->shift) * lon_scale;
+        float edge_x = vertex_x - previous_x;
+        float edge_y = vertex_y - previous_y;
+        float length_sq = edge_x * edge_x + edge_y * edge_y;
+        float t = length_sq > 0.0f ? ((x - previous_x) * edge_x + (y - previous_y) * edge_y) / length_sq : 0.0f;
+        float dx;
+        float dy;
+
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        dx = x - (previous_x + t * edge_x);
+        dy = y - (previous_y + t * edge_y);
+        if (dx * dx + dy * dy <= margin_m * margin_m) {
+            return true;
+        }
+        previous_y = vertex_y;
+        previous_x = vertex_x;
+    }
+
+    return false;
+}
+
+static void akita_geofence_emit(akita_geofence_event_t *events, size_t max_events, size_t *count,
+                                akita_geofence_event_type_t type, const akita_geofence_record_t *record, uint64_t inside_ms) {
+    if (*count >= max_events) {
+        return;
+    }
+
+    events[*count].type = type;
+    events[*count].fence_id = record->id;
+    events[*count].flags = record->flags;
+    events[*count].inside_ms = (uint32_t) inside_ms;
+    ++*count;
+}
+
+static uint8_t akita_geofence_find_visit(const akita_geofence_t *geofence, uint16_t fence) {
+    uint8_t visit;
+
+    for (visit = 0; visit < geofence->visit_count; ++visit) {
+        if (geofence->visits[visit].fence == fence) {
+            break;
+        }
+    }
+
+    return visit;
+}
+
+size_t akita_geofence_lookup(akita_geofence_t *geofence, int32_t latitude_e6, int32_t longitude_e6, uint16_t *fences,
+                             size_t max_fences) {
+    uint32_t row;
+    uint32_t col;
+    uint32_t cell;
+    uint16_t entry;
+    size_t count = 0;
+
+    if (geofence == NULL || geofence->fence_count == 0U || latitude_e6 < geofence->grid_latitude_e6 ||
+        longitude_e6 < geofence->grid_longitude_e6) {
+        return 0;
+    }
+
+    row = (uint32_t) (((int64_t) latitude_e6 - geofence->grid_latitude_e6) / geofence->cell_latitude_e6);
+    col = (uint32_t) (((int64_t) longitude_e6 - geofence->grid_longitude_e6) / geofence->cell_longitude_e6);
+    if (row >= geofence->grid_side || col >= geofence->grid_side) {
+        return 0;
+    }
+
+    cell = row * geofence->grid_side + col;
+    for (entry = geofence->cell_start[cell]; entry < geofence->cell_start[cell + 1U] && count < max_fences; ++entry) {
+        uint16_t fence = geofence->cell_fences[entry];
+
+        if (!akita_geofence_in_box(&geofence->fences[fence], latitude_e6, longitude_e6)) {
+            continue;
+        }
+        ++geofence->polygon_tests;
+        if (akita_geofence_contains(geofence, fence, latitude_e6, longitude_e6)) {
+            fences[count++] = fence;
+        }
+    }
+
+    return count;
+}
+
+size_t akita_geofence_update(akita_geofence_t *geofence, int32_t latitude_e6, int32_t longitude_e6, uint64_t now_ms,
+                             akita_geofence_event_t *events, size_t max_events) {
+    bool seen[AKITA_GEOFENCE_ACTIVE_MAX] = {false};
+    uint16_t inside[AKITA_GEOFENCE_ACTIVE_MAX];
+    size_t inside_count;
+    size_t count = 0;
+    size_t index;
+    uint8_t visit;
+
+    if (geofence == NULL || geofence->fence_count == 0U) {
+        return 0;
+    }
+
+    ++geofence->evaluations;
+    inside_count = akita_geofence_lookup(geofence, latitude_e6, longitude_e6, inside, AKITA_GEOFENCE_ACTIVE_MAX);
+    for (index = 0; index < inside_count; ++index) {
+        visit = akita_geofence_find_visit(geofence, inside[index]);
+        if (visit == geofence->visit_count) {
+            /* Overlapping fences past the active limit are not tracked until one of the others is left. */
+            if (visit == AKITA_GEOFENCE_ACTIVE_MAX) {
+                continue;
+            }
+            memset(&geofence->visits[visit], 0, sizeof(geofence->visits[visit]));
+            geofence->visits[visit].fence = inside[index];
+            geofence->visits[visit].state = AKITA_GEOFENCE_ENTERING;
+            geofence->visits[visit].entered_ms = now_ms;
+            ++geofence->visit_count;
+        }
+        seen[visit] = true;
+    }
+
+    visit = 0;
+    while (visit < geofence->visit_count) {
+        akita_geofence_visit_t *current = &geofence->visits[visit];
+        const akita_geofence_record_t *record = &geofence->fences[current->fence];
+        bool leave = false;
+
+        if (current->state == AKITA_GEOFENCE_ENTERING) {
+            if (!seen[visit]) {
+                leave = true;
+            } else if (now_ms - current->entered_ms >= AKITA_GEOFENCE_CONFIRM_MS) {
+                current->state = AKITA_GEOFENCE_INSIDE;
+                akita_geofence_emit(events, max_events, &count, AKITA_GEOFENCE_ENTER, record, now_ms - current->entered_ms);
+            }
+        } else if (seen[visit] ||
+                   akita_geofence_near(geofence, current->fence, latitude_e6, longitude_e6, AKITA_GEOFENCE_EXIT_MARGIN_M)) {
+            current->crossing = false;
+            if (record->dwell_s != 0U && !current->dwell_sent &&
+                now_ms - current->entered_ms >= (uint64_t) record->dwell_s * 1000U) {
+                current->dwell_sent = true;
+                akita_geofence_emit(events, max_events, &count, AKITA_GEOFENCE_DWELL, record, now_ms - current->entered_ms);
+            }
+        } else {
+            if (!current->crossing) {
+                current->crossing = true;
+                current->crossed_ms = now_ms;
+            }
+            if (now_ms - current->crossed_ms >= AKITA_GEOFENCE_CONFIRM_MS) {
+                akita_geofence_emit(events, max_events, &count, AKITA_GEOFENCE_EXIT, record,
+                                    current->crossed_ms - current->entered_ms);
+                leave = true;
+            }
+        }
+
+        if (!leave) {
+            ++visit;
+            continue;
+        }
+
+        --geofence->visit_count;
+        geofence->visits[visit] = geofence->visits[geofence->visit_count];
+        seen[visit] = seen[geofence->visit_count];
+    }
+
+    return count;
+}
+
+const char *akita_geofence_event_name(akita_geofence_event_type_t type) {
+    switch (type) {
+        case AKITA_GEOFENCE_ENTER:
+            return "geofence_enter";
+        case AKITA_GEOFENCE_EXIT:
+            return "geofence_exit";
+        case AKITA_GEOFENCE_DWELL:
+            return "geofence_dwell";
+        default:
+            return "geofence";
+    }
+}
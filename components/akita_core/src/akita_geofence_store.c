@@ -0,0 +1,72 @@
+#include "akita_geofence_store.h"
+
+#include <stdbool.h>
+
+#include "esp_partition.h"
+
+#define AKITA_GEOFENCE_PARTITION_SUBTYPE 0x40
+#define AKITA_GEOFENCE_ERASE_BLOCK 4096U
+
+static const char *AKITA_GEOFENCE_PARTITION = "geofence";
+static esp_partition_mmap_handle_t g_mmap_handle;
+static bool g_mapped;
+
+static const esp_partition_t *akita_geofence_partition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t) AKITA_GEOFENCE_PARTITION_SUBTYPE,
+                                    AKITA_GEOFENCE_PARTITION);
+}
+
+esp_err_t akita_geofence_store_map(const void **image, size_t *size) {
+    const esp_partition_t *partition = akita_geofence_partition();
+    esp_err_t err;
+
+    if (image == NULL || size == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    akita_geofence_store_unmap();
+    err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, image, &g_mmap_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    g_mapped = true;
+    *size = partition->size;
+    return ESP_OK;
+}
+
+void akita_geofence_store_unmap(void) {
+    if (g_mapped) {
+        esp_partition_munmap(g_mmap_handle);
+        g_mapped = false;
+    }
+}
+
+esp_err_t akita_geofence_store_write(size_t offset, const void *data, size_t size, size_t total) {
+    const esp_partition_t *partition = akita_geofence_partition();
+    esp_err_t err;
+
+    if (data == NULL || offset + size > total) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (total > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (offset == 0U) {
+        err = esp_partition_erase_range(partition, 0,
+                                        (total + AKITA_GEOFENCE_ERASE_BLOCK - 1U) / AKITA_GEOFENCE_ERASE_BLOCK *
+                                            AKITA_GEOFENCE_ERASE_BLOCK);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return esp_partition_write(partition, offset, data, size);
+}
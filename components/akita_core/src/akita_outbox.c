@@ -0,0 +1,159 @@
+#include "akita_outbox.h"
+
+#include <string.h>
+
+/* Alerts bypass these; the other classes share the uplink in this ratio while they all have backlog. */
+static const uint8_t AKITA_OUTBOX_WEIGHTS[AKITA_MESSAGE_CLASS_COUNT] = {
+    [AKITA_MESSAGE_ALERT] = 0U,
+    [AKITA_MESSAGE_EVENT] = 4U,
+    [AKITA_MESSAGE_ROUTINE] = 2U,
+    [AKITA_MESSAGE_BULK] = 1U,
+};
+
+void akita_outbox_init(akita_outbox_t *outbox) {
+    memset(outbox, 0, sizeof(*outbox));
+    outbox->turn = AKITA_MESSAGE_EVENT;
+    outbox->queues[AKITA_MESSAGE_EVENT].credit = AKITA_OUTBOX_WEIGHTS[AKITA_MESSAGE_EVENT];
+}
+
+static void akita_outbox_take(akita_outbox_t *outbox, akita_message_class_t message_class, akita_outbox_message_t *message) {
+    akita_outbox_queue_t *queue = &outbox->queues[message_class];
+
+    if (message != NULL) {
+        *message = queue->slots[queue->head];
+    }
+    queue->head = (uint8_t) ((queue->head + 1U) % AKITA_OUTBOX_DEPTH);
+    --queue->count;
+}
+
+bool akita_outbox_push(akita_outbox_t *outbox, const akita_outbox_message_t *message) {
+    akita_outbox_queue_t *queue;
+    bool displaced = false;
+
+    if (outbox == NULL || message == NULL || message->message_class >= AKITA_MESSAGE_CLASS_COUNT) {
+        return false;
+    }
+
+    /* A full queue loses its oldest message; the newest sample or alert is the one worth sending. */
+    queue = &outbox->queues[message->message_class];
+    if (queue->count == AKITA_OUTBOX_DEPTH) {
+        akita_outbox_take(outbox, message->message_class, NULL);
+        ++outbox->counters[message->message_class].dropped_overflow;
+        displaced = true;
+    }
+
+    queue->slots[(queue->head + queue->count) % AKITA_OUTBOX_DEPTH] = *message;
+    ++queue->count;
+    ++outbox->counters[message->message_class].queued;
+    return !displaced;
+}
+
+static void akita_outbox_expire(akita_outbox_t *outbox, uint64_t now_ms) {
+    akita_message_class_t message_class;
+
+    for (message_class = AKITA_MESSAGE_ALERT; message_class < AKITA_MESSAGE_CLASS_COUNT; ++message_class) {
+        akita_outbox_queue_t *queue = &outbox->queues[message_class];
+
+        while (queue->count > 0U && queue->slots[queue->head].deadline_ms != AKITA_OUTBOX_NO_DEADLINE &&
+               now_ms > queue->slots[queue->head].deadline_ms) {
+            akita_outbox_take(outbox, message_class, NULL);
+            ++outbox->counters[message_class].dropped_stale;
+        }
+    }
+}
+
+bool akita_outbox_pop(akita_outbox_t *outbox, uint64_t now_ms, akita_outbox_message_t *message) {
+    akita_outbox_queue_t *queue;
+    size_t visited;
+
+    if (outbox == NULL || message == NULL) {
+        return false;
+    }
+
+    akita_outbox_expire(outbox, now_ms);
+
+    if (outbox->queues[AKITA_MESSAGE_ALERT].count > 0U) {
+        akita_outbox_take(outbox, AKITA_MESSAGE_ALERT, message);
+        ++outbox->counters[AKITA_MESSAGE_ALERT].sent;
+        return true;
+    }
+
+    /* Weighted round robin: the class whose turn it is sends until its credit or backlog runs out. */
+    for (visited = 0; visited < AKITA_MESSAGE_CLASS_COUNT; ++visited) {
+        queue = &outbox->queues[outbox->turn];
+        if (queue->count > 0U && queue->credit > 0U) {
+            --queue->credit;
+            akita_outbox_take(outbox, outbox->turn, message);
+            ++outbox->counters[outbox->turn].sent;
+            return true;
+        }
+
+        queue->credit = 0;
+        outbox->turn = outbox->turn == AKITA_MESSAGE_BULK ? AKITA_MESSAGE_EVENT
+                                                          : (akita_message_class_t) (outbox->turn + 1);
+        outbox->queues[outbox->turn].credit = AKITA_OUTBOX_WEIGHTS[outbox->turn];
+    }
+
+    return false;
+}
+
+void akita_outbox_requeue(akita_outbox_t *outbox, const akita_outbox_message_t *message) {
+    akita_outbox_queue_t *queue;
+
+    if (outbox == NULL || message == NULL || message->message_class >= AKITA_MESSAGE_CLASS_COUNT) {
+        return;
+    }
+
+    queue = &outbox->queues[message->message_class];
+    --outbox->counters[message->message_class].sent;
+    if (queue->count == AKITA_OUTBOX_DEPTH) {
+        ++outbox->counters[message->message_class].dropped_overflow;
+        return;
+    }
+
+    /* Back at the head, and the send it was charged for is refunded. */
+    queue->head = (uint8_t) ((queue->head + AKITA_OUTBOX_DEPTH - 1U) % AKITA_OUTBOX_DEPTH);
+    queue->slots[queue->head] = *message;
+    ++queue->count;
+    if (message->message_class == outbox->turn && queue->credit < AKITA_OUTBOX_WEIGHTS[message->message_class]) {
+        ++queue->credit;
+    }
+}
+
+size_t akita_outbox_pending(const akita_outbox_t *outbox) {
+    size_t pending = 0;
+    size_t index;
+
+    if (outbox == NULL) {
+        return 0;
+    }
+
+    for (index = 0; index < AKITA_MESSAGE_CLASS_COUNT; ++index) {
+        pending += outbox->queues[index].count;
+    }
+
+    return pending;
+}
+
+bool akita_outbox_holds_trip(const akita_outbox_t *outbox, uint32_t trip_id) {
+    size_t message_class;
+    size_t index;
+
+    if (outbox == NULL || trip_id == 0U) {
+        return false;
+    }
+
+    for (message_class = 0; message_class < AKITA_MESSAGE_CLASS_COUNT; ++message_class) {
+        const akita_outbox_queue_t *queue = &outbox->queues[message_class];
+
+        for (index = 0; index < queue->count; ++index) {
+            const akita_outbox_message_t *message = &queue->slots[(queue->head + index) % AKITA_OUTBOX_DEPTH];
+
+            if (message->kind == AKITA_OUTBOX_TRIP && message->trip.trip_id == trip_id) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -1,183 +1,619 @@
 #include "akita_app.h"
 
-#include <inttypes.h>
-#include <stdarg.h>
-#include <stdio.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "akita_board.h"
+#include "akita_telemetry_schema.h"
 #include "esp_timer.h"
 
-static size_t akita_append_text(char *buffer, size_t buffer_size, size_t used, const char *text) {
-    size_t remaining;
-    int written;
+#define AKITA_JSON_LITERAL(writer, text) akita_json_put_raw((writer), (text), sizeof(text) - 1U)
 
-    if (used >= buffer_size) {
-        return used;
+typedef struct {
+    char *data;
+    size_t size;
+    size_t used;
+    bool overflow;
+} akita_json_writer_t;
+
+/* 0 = copy as-is, 'u' = \u00XX escape, anything else = two-character escape. */
+static const char kJsonEscape[128] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+#define AKITA_JSON_PUT_BOOL(writer, value, decimals) akita_json_put_bool((writer), (value))
+#define AKITA_JSON_PUT_FIXED(writer, value, decimals) akita_json_put_fixed((writer), (value), (decimals))
+#define AKITA_JSON_PUT_UINT(writer, value, decimals) akita_json_put_u64((writer), (value))
+#define AKITA_JSON_PUT_INT(writer, value, decimals) akita_json_put_i32((writer), (value))
+
+#define AKITA_COMPACT_PUT_BOOL(writer, value, decimals) akita_json_put_char((writer), (value) ? '1' : '0')
+#define AKITA_COMPACT_PUT_FIXED AKITA_JSON_PUT_FIXED
+#define AKITA_COMPACT_PUT_UINT AKITA_JSON_PUT_UINT
+#define AKITA_COMPACT_PUT_INT AKITA_JSON_PUT_INT
+
+#define AKITA_JSON_FIELD(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_JSON_LITERAL(&writer, "\"" name "\":"); \
+    AKITA_JSON_PUT_##type(&writer, telemetry->member, decimals); \
+    akita_json_put_char(&writer, ',');
+
+#define AKITA_COMPACT_FIELD(group, id, name, short_key, type, decimals, frame, member) \
+    if (sizeof(short_key) > 1U) { \
+        AKITA_JSON_LITERAL(&writer, "\"" short_key "\":"); \
+        AKITA_COMPACT_PUT_##type(&writer, telemetry->member, decimals); \
+        akita_json_put_char(&writer, ','); \
     }
 
-    remaining = buffer_size - used;
-    written = snprintf(buffer + used, remaining, "%s", text);
-    if (written < 0) {
-        return used;
+/* Window aggregates: [min, mean, max] or [min, mean, max, stddev]; counts and means get at least one decimal. */
+#define AKITA_WINDOW_PUT_BOOL(id, name, decimals)
+#define AKITA_WINDOW_PUT_VALUE(id, name, decimals) \
+    AKITA_JSON_LITERAL(&writer, "\"" name "\":["); \
+    akita_json_put_window_value(&writer, &window->fields[AKITA_AGGREGATE_FIELD_##id], (decimals), config->aggregate_variance);
+#define AKITA_WINDOW_PUT_FIXED AKITA_WINDOW_PUT_VALUE
+#define AKITA_WINDOW_PUT_UINT(id, name, decimals) AKITA_WINDOW_PUT_VALUE(id, name, 1U)
+#define AKITA_WINDOW_PUT_INT(id, name, decimals) AKITA_WINDOW_PUT_VALUE(id, name, 1U)
+#define AKITA_WINDOW_FIELD(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_WINDOW_PUT_##type(id, name, decimals)
+
+/* Magnitudes from here up are written as null. */
+#define AKITA_JSON_FIXED_LIMIT 1000000000000ULL
+
+static const uint32_t kPow10[] = { 1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL };
+
+static void akita_json_writer_init(akita_json_writer_t *writer, char *buffer, size_t buffer_size) {
+    writer->data = buffer;
+    writer->size = buffer_size;
+    writer->used = 0;
+    writer->overflow = false;
+}
+
+static void akita_json_put_raw(akita_json_writer_t *writer, const char *text, size_t length) {
+    if (writer->overflow || length >= (writer->size - writer->used)) {
+        writer->overflow = true;
+        return;
+    }
+
+    memcpy(writer->data + writer->used, text, length);
+    writer->used += length;
+}
+
+static void akita_json_put_char(akita_json_writer_t *writer, char value) {
+    akita_json_put_raw(writer, &value, 1U);
+}
+
+static void akita_json_put_bool(akita_json_writer_t *writer, bool value) {
+    if (value) {
+        AKITA_JSON_LITERAL(writer, "true");
+    } else {
+        AKITA_JSON_LITERAL(writer, "false");
     }
+}
+
+static void akita_json_put_u64(akita_json_writer_t *writer, uint64_t value) {
+    char scratch[20];
+    size_t index = sizeof(scratch);
+
+    do {
+        scratch[--index] = (char) ('0' + (value % 10U));
+        value /= 10U;
+    } while (value != 0U);
+
+    akita_json_put_raw(writer, scratch + index, sizeof(scratch) - index);
+}
 
-    if ((size_t) written >= remaining) {
-        return buffer_size;
+static void akita_json_put_i32(akita_json_writer_t *writer, int32_t value) {
+    if (value < 0) {
+        akita_json_put_char(writer, '-');
+        akita_json_put_u64(writer, (uint64_t) (-(int64_t) value));
+        return;
     }
 
-    return used + (size_t) written;
+    akita_json_put_u64(writer, (uint64_t) value);
 }
 
-static size_t akita_append_format(char *buffer, size_t buffer_size, size_t used, const char *format, ...) {
-    va_list args;
-    size_t remaining;
-    int written;
+/*
+ * Matches printf("%.Nf") for finite floats without floating point: the 24-bit mantissa scaled by at most 1e6
+ * fits in 64 bits, so the shift by the exponent finds ties exactly and they round to even.
+ */
+static void akita_json_put_fixed(akita_json_writer_t *writer, float value, uint8_t decimals) {
+    uint32_t bits;
+    uint32_t mantissa;
+    int32_t exponent;
+    uint64_t units;
+    uint32_t divisor;
+    uint32_t remainder;
+    char scratch[6];
+    size_t index;
 
-    if (used >= buffer_size) {
-        return used;
+    memcpy(&bits, &value, sizeof(bits));
+    exponent = (int32_t) ((bits >> 23) & 0xFFU);
+    mantissa = bits & 0x7FFFFFU;
+    if (exponent == 0xFF) {
+        AKITA_JSON_LITERAL(writer, "null");
+        return;
     }
+    if (exponent == 0) {
+        exponent = 1;
+    } else {
+        mantissa |= 1UL << 23;
+    }
+    /* value is mantissa * 2^exponent from here on. */
+    exponent -= 150;
+
+    divisor = kPow10[decimals];
+    if (exponent >= 0) {
+        uint64_t whole;
 
-    remaining = buffer_size - used;
-    va_start(args, format);
-    written = vsnprintf(buffer + used, remaining, format, args);
-    va_end(args);
+        /* 2^24 * 2^16 is past 10^12, the largest magnitude written. */
+        if (exponent > 16) {
+            AKITA_JSON_LITERAL(writer, "null");
+            return;
+        }
+        whole = (uint64_t) mantissa << exponent;
+        if (whole >= AKITA_JSON_FIXED_LIMIT) {
+            AKITA_JSON_LITERAL(writer, "null");
+            return;
+        }
+        units = whole * divisor;
+    } else if (exponent > -63) {
+        uint32_t shift = (uint32_t) -exponent;
+        uint64_t scaled = (uint64_t) mantissa * divisor;
+        uint64_t fraction = scaled & ((1ULL << shift) - 1U);
+        uint64_t half = 1ULL << (shift - 1U);
 
-    if (written < 0) {
-        return used;
+        units = scaled >> shift;
+        if (fraction > half || (fraction == half && (units & 1U) != 0U)) {
+            ++units;
+        }
+    } else {
+        units = 0;
+    }
+
+    if ((bits >> 31) != 0U) {
+        akita_json_put_char(writer, '-');
+    }
+
+    akita_json_put_u64(writer, units / divisor);
+    if (decimals == 0U) {
+        return;
     }
 
-    if ((size_t) written >= remaining) {
-        return buffer_size;
+    remainder = (uint32_t) (units % divisor);
+    for (index = decimals; index > 0U; --index) {
+        scratch[index - 1U] = (char) ('0' + (remainder % 10U));
+        remainder /= 10U;
     }
 
-    return used + (size_t) written;
+    akita_json_put_char(writer, '.');
+    akita_json_put_raw(writer, scratch, decimals);
 }
 
-static size_t akita_append_json_string(char *buffer, size_t buffer_size, size_t used, const char *text) {
+static void akita_json_put_string(akita_json_writer_t *writer, const char *text) {
     const char *cursor = text != NULL ? text : "";
+    const char *run = cursor;
+    char escape[6] = { '\\', 'u', '0', '0', '0', '0' };
+
+    akita_json_put_char(writer, '"');
+    while (*cursor != '\0') {
+        unsigned char value = (unsigned char) *cursor;
+        char replacement = value < 128U ? kJsonEscape[value] : 0;
+
+        if (replacement == 0) {
+            ++cursor;
+            continue;
+        }
 
-    used = akita_append_text(buffer, buffer_size, used, "\"");
-    while (*cursor != '\0' && used < buffer_size) {
-        if (*cursor == '"' || *cursor == '\\') {
-            used = akita_append_format(buffer, buffer_size, used, "\\%c", *cursor);
-        } else if ((unsigned char) *cursor < 32U) {
-            used = akita_append_format(buffer, buffer_size, used, "\\u%04x", (unsigned char) *cursor);
+        akita_json_put_raw(writer, run, (size_t) (cursor - run));
+        if (replacement == 'u') {
+            escape[4] = kHexDigits[value >> 4];
+            escape[5] = kHexDigits[value & 0x0FU];
+            akita_json_put_raw(writer, escape, sizeof(escape));
         } else {
-            char scratch[2] = { *cursor, '\0' };
-            used = akita_append_text(buffer, buffer_size, used, scratch);
+            char pair[2] = { '\\', replacement };
+            akita_json_put_raw(writer, pair, sizeof(pair));
         }
-        ++cursor;
+        run = ++cursor;
     }
-    used = akita_append_text(buffer, buffer_size, used, "\"");
+    akita_json_put_raw(writer, run, (size_t) (cursor - run));
+    akita_json_put_char(writer, '"');
+}
 
-    return used;
+static void akita_json_put_window_value(
+    akita_json_writer_t *writer,
+    const akita_aggregate_value_t *value,
+    uint8_t decimals,
+    bool with_stddev
+) {
+    akita_json_put_fixed(writer, value->min, decimals);
+    akita_json_put_char(writer, ',');
+    akita_json_put_fixed(writer, value->mean, decimals);
+    akita_json_put_char(writer, ',');
+    akita_json_put_fixed(writer, value->max, decimals);
+    if (with_stddev) {
+        akita_json_put_char(writer, ',');
+        akita_json_put_fixed(writer, value->stddev, decimals);
+    }
+    AKITA_JSON_LITERAL(writer, "],");
 }
 
-size_t akita_payload_write_json(
+static void akita_json_close_object(akita_json_writer_t *writer) {
+    if (!writer->overflow && writer->used > 0U && writer->data[writer->used - 1U] == ',') {
+        writer->data[writer->used - 1U] = '}';
+        return;
+    }
+
+    akita_json_put_char(writer, '}');
+}
+
+static size_t akita_json_finish(akita_json_writer_t *writer) {
+    if (writer->overflow) {
+        writer->data[writer->size - 1U] = '\0';
+        return 0;
+    }
+
+    writer->data[writer->used] = '\0';
+    return writer->used;
+}
+
+/* Microdegrees as decimal degrees, without going through a float. */
+static void akita_json_put_e6(akita_json_writer_t *writer, int32_t value) {
+    uint64_t magnitude = value < 0 ? (uint64_t) (-(int64_t) value) : (uint64_t) value;
+    uint32_t remainder = (uint32_t) (magnitude % 1000000U);
+    char scratch[7];
+    size_t index;
+
+    if (value < 0) {
+        akita_json_put_char(writer, '-');
+    }
+    akita_json_put_u64(writer, magnitude / 1000000U);
+    scratch[0] = '.';
+    for (index = 6; index > 0U; --index) {
+        scratch[index] = (char) ('0' + (remainder % 10U));
+        remainder /= 10U;
+    }
+    akita_json_put_raw(writer, scratch, sizeof(scratch));
+}
+
+static void akita_json_put_fused(akita_json_writer_t *writer, const akita_fusion_output_t *fused) {
+    AKITA_JSON_LITERAL(writer, ",\"fused\":{\"lat\":");
+    akita_json_put_e6(writer, fused->latitude_e6);
+    AKITA_JSON_LITERAL(writer, ",\"lon\":");
+    akita_json_put_e6(writer, fused->longitude_e6);
+    AKITA_JSON_LITERAL(writer, ",\"speed_kmh\":");
+    akita_json_put_fixed(writer, fused->speed_kmh, 1U);
+    AKITA_JSON_LITERAL(writer, ",\"heading_deg\":");
+    akita_json_put_fixed(writer, fused->heading_deg, 1U);
+    AKITA_JSON_LITERAL(writer, ",\"sigma_m\":");
+    akita_json_put_fixed(writer, fused->sigma_m, 1U);
+    if (fused->dead_reckoning) {
+        AKITA_JSON_LITERAL(writer, ",\"outage_ms\":");
+        akita_json_put_u64(writer, fused->outage_ms);
+    }
+    akita_json_put_char(writer, '}');
+}
+
+static void akita_json_put_track(akita_json_writer_t *writer, const akita_outbox_message_t *message) {
+    uint8_t index;
+
+    AKITA_JSON_LITERAL(writer, ",\"track\":[");
+    for (index = 0; index < message->sample.track_count; ++index) {
+        const akita_track_point_t *point = &message->sample.track[index];
+
+        if (index > 0U) {
+            akita_json_put_char(writer, ',');
+        }
+        akita_json_put_char(writer, '[');
+        akita_json_put_e6(writer, point->latitude_e6);
+        akita_json_put_char(writer, ',');
+        akita_json_put_e6(writer, point->longitude_e6);
+        akita_json_put_char(writer, ',');
+        akita_json_put_u64(writer, message->created_ms - point->timestamp_ms);
+        akita_json_put_char(writer, ']');
+    }
+    akita_json_put_char(writer, ']');
+}
+
+/* An uptime stamp as Unix milliseconds once the clock is set, otherwise as it is. */
+static void akita_json_put_time(akita_json_writer_t *writer, const akita_outbox_message_t *message, uint64_t uptime_ms) {
+    if (message->utc_offset_us != 0) {
+        akita_json_put_u64(writer, (uint64_t) (((int64_t) uptime_ms * 1000 + message->utc_offset_us) / 1000));
+    } else {
+        akita_json_put_u64(writer, uptime_ms);
+    }
+}
+
+static void akita_json_put_acquired(akita_json_writer_t *writer, const akita_outbox_message_t *message) {
+    const akita_vehicle_telemetry_t *telemetry = &message->telemetry;
+    const akita_obd_snapshot_t *obd = &telemetry->obd;
+
+    AKITA_JSON_LITERAL(writer, ",\"acquired_ms\":{");
+    if (obd->rpm_ms != 0U || obd->speed_ms != 0U || obd->coolant_ms != 0U) {
+        AKITA_JSON_LITERAL(writer, "\"obd\":{");
+        if (obd->rpm_ms != 0U) {
+            AKITA_JSON_LITERAL(writer, "\"rpm\":");
+            akita_json_put_time(writer, message, obd->rpm_ms);
+            akita_json_put_char(writer, ',');
+        }
+        if (obd->speed_ms != 0U) {
+            AKITA_JSON_LITERAL(writer, "\"speed_kmh\":");
+            akita_json_put_time(writer, message, obd->speed_ms);
+            akita_json_put_char(writer, ',');
+        }
+        if (obd->coolant_ms != 0U) {
+            AKITA_JSON_LITERAL(writer, "\"coolant_c\":");
+            akita_json_put_time(writer, message, obd->coolant_ms);
+            akita_json_put_char(writer, ',');
+        }
+        akita_json_close_object(writer);
+        akita_json_put_char(writer, ',');
+    }
+    if (telemetry->gps.fix_ms != 0U) {
+        AKITA_JSON_LITERAL(writer, "\"gps\":");
+        akita_json_put_time(writer, message, telemetry->gps.fix_ms);
+        akita_json_put_char(writer, ',');
+    }
+    if (telemetry->system.sampled_ms != 0U) {
+        AKITA_JSON_LITERAL(writer, "\"system\":");
+        akita_json_put_time(writer, message, telemetry->system.sampled_ms);
+        akita_json_put_char(writer, ',');
+    }
+    akita_json_close_object(writer);
+}
+
+/* The stages before serialization; the bridge adds its own, and the node keeps the rest in its status histograms. */
+static void akita_json_put_trace(akita_json_writer_t *writer, const akita_outbox_message_t *message) {
+    const akita_trace_t *trace = &message->trace;
+
+    AKITA_JSON_LITERAL(writer, ",\"trace\":{\"id\":");
+    akita_json_put_u64(writer, trace->id);
+    AKITA_JSON_LITERAL(writer, ",\"acquired_ms\":");
+    akita_json_put_time(writer, message, trace->at_us[AKITA_TRACE_ACQUIRED] / 1000U);
+    AKITA_JSON_LITERAL(writer, ",\"queued_ms\":");
+    akita_json_put_time(writer, message, trace->at_us[AKITA_TRACE_QUEUED] / 1000U);
+    AKITA_JSON_LITERAL(writer, ",\"encoded_ms\":");
+    akita_json_put_time(writer, message, trace->at_us[AKITA_TRACE_ENCODE] / 1000U);
+    akita_json_put_char(writer, '}');
+}
+
+static size_t akita_payload_write_sample(
     const akita_runtime_config_t *config,
     const akita_vehicle_telemetry_t *telemetry,
+    uint64_t timestamp_ms,
+    const akita_outbox_message_t *message,
     char *buffer,
     size_t buffer_size
 ) {
-    size_t used = 0;
-    uint64_t timestamp_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
+    const akita_aggregate_summary_t *window =
+        message != NULL && message->kind == AKITA_OUTBOX_SAMPLE ? &message->sample.window : NULL;
+    akita_json_writer_t writer;
 
     if (buffer == NULL || buffer_size == 0 || config == NULL || telemetry == NULL) {
         return 0;
     }
 
-    buffer[0] = '\0';
-    used = akita_append_text(buffer, buffer_size, used, "{");
-    used = akita_append_text(buffer, buffer_size, used, "\"node_id\":");
-    used = akita_append_json_string(buffer, buffer_size, used, config->vehicle_id);
-    used = akita_append_format(buffer, buffer_size, used, ",\"timestamp_ms\":%" PRIu64, timestamp_ms);
-    used = akita_append_text(buffer, buffer_size, used, ",\"board\":");
-    used = akita_append_json_string(buffer, buffer_size, used, akita_board_get_name(config->board_profile));
-    used = akita_append_text(buffer, buffer_size, used, ",\"obd\":{");
-    used = akita_append_format(buffer, buffer_size, used, "\"connected\":%s", telemetry->obd.connected ? "true" : "false");
-    used = akita_append_format(buffer, buffer_size, used, ",\"rpm\":%.1f", telemetry->obd.rpm);
-    used = akita_append_format(buffer, buffer_size, used, ",\"speed_kmh\":%.1f", telemetry->obd.speed_kmh);
-    used = akita_append_format(buffer, buffer_size, used, ",\"coolant_c\":%.1f", telemetry->obd.coolant_c);
-    used = akita_append_text(buffer, buffer_size, used, "}");
-    used = akita_append_text(buffer, buffer_size, used, ",\"gps\":{");
-    used = akita_append_format(buffer, buffer_size, used, "\"fix\":%s", telemetry->gps.fix ? "true" : "false");
-    used = akita_append_format(buffer, buffer_size, used, ",\"lat\":%.6f", telemetry->gps.latitude);
-    used = akita_append_format(buffer, buffer_size, used, ",\"lon\":%.6f", telemetry->gps.longitude);
-    used = akita_append_format(buffer, buffer_size, used, ",\"alt_m\":%.1f", telemetry->gps.altitude_m);
-    used = akita_append_format(buffer, buffer_size, used, ",\"speed_kmh\":%.1f", telemetry->gps.speed_kmh);
-    used = akita_append_format(buffer, buffer_size, used, ",\"sats\":%u", telemetry->gps.satellites);
-    used = akita_append_text(buffer, buffer_size, used, "}");
-    used = akita_append_text(buffer, buffer_size, used, ",\"system\":{");
-    used = akita_append_format(buffer, buffer_size, used, "\"config_portal_ready\":%s", telemetry->system.config_portal_ready ? "true" : "false");
-    used = akita_append_format(buffer, buffer_size, used, ",\"transport_ready\":%s", telemetry->system.transport_ready ? "true" : "false");
-    used = akita_append_format(buffer, buffer_size, used, ",\"wifi_ready\":%s", telemetry->system.wifi_ready ? "true" : "false");
-    used = akita_append_format(buffer, buffer_size, used, ",\"lora_ready\":%s", telemetry->system.lora_ready ? "true" : "false");
-    used = akita_append_format(buffer, buffer_size, used, ",\"wifi_rssi\":%d", (int) telemetry->system.wifi_rssi);
-    used = akita_append_format(buffer, buffer_size, used, ",\"free_heap\":%lu", (unsigned long) telemetry->system.free_heap);
-    used = akita_append_text(buffer, buffer_size, used, "}");
-    used = akita_append_text(buffer, buffer_size, used, "}");
-
-    if (used >= buffer_size) {
-        buffer[buffer_size - 1] = '\0';
+    akita_json_writer_init(&writer, buffer, buffer_size);
+    AKITA_JSON_LITERAL(&writer, "{\"node_id\":");
+    akita_json_put_string(&writer, config->vehicle_id);
+    AKITA_JSON_LITERAL(&writer, ",\"timestamp_ms\":");
+    akita_json_put_u64(&writer, timestamp_ms);
+    if (message != NULL && message->utc_offset_us != 0) {
+        AKITA_JSON_LITERAL(&writer, ",\"utc_ms\":");
+        akita_json_put_time(&writer, message, timestamp_ms);
+        AKITA_JSON_LITERAL(&writer, ",\"utc_error_us\":");
+        akita_json_put_u64(&writer, message->utc_error_us);
+    }
+    AKITA_JSON_LITERAL(&writer, ",\"board\":");
+    akita_json_put_string(&writer, akita_board_get_name(config->board_profile));
+    if (message != NULL && message->event_name[0] != '\0') {
+        AKITA_JSON_LITERAL(&writer, ",\"event\":");
+        akita_json_put_string(&writer, message->event_name);
+        if (isfinite(message->event_value)) {
+            AKITA_JSON_LITERAL(&writer, ",\"event_value\":");
+            akita_json_put_fixed(&writer, message->event_value, 2U);
+        }
+    }
+    if (message != NULL && message->kind == AKITA_OUTBOX_GEOFENCE) {
+        AKITA_JSON_LITERAL(&writer, ",\"geofence\":{\"id\":");
+        akita_json_put_u64(&writer, message->geofence.fence_id);
+        AKITA_JSON_LITERAL(&writer, ",\"inside_ms\":");
+        akita_json_put_u64(&writer, message->geofence.inside_ms);
+        akita_json_put_char(&writer, '}');
+    }
+    AKITA_JSON_LITERAL(&writer, ",\"obd\":{");
+    AKITA_TELEMETRY_OBD_FIELDS(AKITA_JSON_FIELD)
+    akita_json_close_object(&writer);
+    AKITA_JSON_LITERAL(&writer, ",\"gps\":{");
+    AKITA_TELEMETRY_GPS_FIELDS(AKITA_JSON_FIELD)
+    akita_json_close_object(&writer);
+    AKITA_JSON_LITERAL(&writer, ",\"system\":{");
+    AKITA_TELEMETRY_SYSTEM_FIELDS(AKITA_JSON_FIELD)
+    akita_json_close_object(&writer);
+    if (message != NULL) {
+        akita_json_put_acquired(&writer, message);
+    }
+    if (message != NULL && message->trace.id != 0U) {
+        akita_json_put_trace(&writer, message);
+    }
+    if (message != NULL && message->fused.valid) {
+        akita_json_put_fused(&writer, &message->fused);
+    }
+    if (window != NULL && window->window_ms > 0U) {
+        AKITA_JSON_LITERAL(&writer, ",\"window\":{\"ms\":");
+        akita_json_put_u64(&writer, window->window_ms);
+        if (window->count[AKITA_AGGREGATE_GROUP_OBD] > 0U) {
+            AKITA_JSON_LITERAL(&writer, ",\"obd\":{\"n\":");
+            akita_json_put_u64(&writer, window->count[AKITA_AGGREGATE_GROUP_OBD]);
+            akita_json_put_char(&writer, ',');
+            AKITA_TELEMETRY_OBD_FIELDS(AKITA_WINDOW_FIELD)
+            akita_json_close_object(&writer);
+        }
+        if (window->count[AKITA_AGGREGATE_GROUP_GPS] > 0U) {
+            AKITA_JSON_LITERAL(&writer, ",\"gps\":{\"n\":");
+            akita_json_put_u64(&writer, window->count[AKITA_AGGREGATE_GROUP_GPS]);
+            akita_json_put_char(&writer, ',');
+            AKITA_TELEMETRY_GPS_FIELDS(AKITA_WINDOW_FIELD)
+            akita_json_close_object(&writer);
+        }
+        if (window->count[AKITA_AGGREGATE_GROUP_SYSTEM] > 0U) {
+            AKITA_JSON_LITERAL(&writer, ",\"system\":{\"n\":");
+            akita_json_put_u64(&writer, window->count[AKITA_AGGREGATE_GROUP_SYSTEM]);
+            akita_json_put_char(&writer, ',');
+            AKITA_TELEMETRY_SYSTEM_FIELDS(AKITA_WINDOW_FIELD)
+            akita_json_close_object(&writer);
+        }
+        akita_json_put_char(&writer, '}');
+    }
+    if (message != NULL && message->kind == AKITA_OUTBOX_SAMPLE && message->sample.track_count > 0U) {
+        akita_json_put_track(&writer, message);
+    }
+    akita_json_put_char(&writer, '}');
+
+    return akita_json_finish(&writer);
+}
+
+size_t akita_payload_write_message_json(
+    const akita_runtime_config_t *config,
+    const akita_outbox_message_t *message,
+    char *buffer,
+    size_t buffer_size
+) {
+    if (message == NULL) {
         return 0;
     }
 
-    return used;
+    if (message->kind == AKITA_OUTBOX_TRIP) {
+        return akita_payload_write_trip_json(config, &message->trip, message->created_ms, buffer, buffer_size);
+    }
+
+    return akita_payload_write_sample(config, &message->telemetry, message->created_ms, message, buffer, buffer_size);
 }
 
-size_t akita_payload_write_compact_json(
+size_t akita_payload_write_trip_json(
     const akita_runtime_config_t *config,
-    const akita_vehicle_telemetry_t *telemetry,
+    const akita_trip_record_t *trip,
+    uint64_t timestamp_ms,
     char *buffer,
     size_t buffer_size
 ) {
-    size_t used = 0;
-    uint64_t timestamp_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
+    akita_json_writer_t writer;
+    size_t index;
 
-    if (buffer == NULL || buffer_size == 0 || config == NULL || telemetry == NULL) {
+    if (buffer == NULL || buffer_size == 0 || config == NULL || trip == NULL) {
         return 0;
     }
 
-    buffer[0] = '\0';
-    used = akita_append_text(buffer, buffer_size, used, "{");
-    used = akita_append_text(buffer, buffer_size, used, "\"n\":");
-    used = akita_append_json_string(buffer, buffer_size, used, config->vehicle_id);
-    used = akita_append_format(buffer, buffer_size, used, ",\"t\":%" PRIu64, timestamp_ms);
-    used = akita_append_format(
-        buffer,
-        buffer_size,
-        used,
-        ",\"o\":{\"c\":%u,\"r\":%.1f,\"s\":%.1f,\"k\":%.1f}",
-        telemetry->obd.connected ? 1U : 0U,
-        telemetry->obd.rpm,
-        telemetry->obd.speed_kmh,
-        telemetry->obd.coolant_c
-    );
-    used = akita_append_format(
-        buffer,
-        buffer_size,
-        used,
-        ",\"g\":{\"f\":%u,\"la\":%.6f,\"lo\":%.6f,\"v\":%.1f,\"s\":%u}",
-        telemetry->gps.fix ? 1U : 0U,
-        telemetry->gps.latitude,
-        telemetry->gps.longitude,
-        telemetry->gps.speed_kmh,
-        telemetry->gps.satellites
-    );
-    used = akita_append_format(
+    akita_json_writer_init(&writer, buffer, buffer_size);
+    AKITA_JSON_LITERAL(&writer, "{\"node_id\":");
+    akita_json_put_string(&writer, config->vehicle_id);
+    AKITA_JSON_LITERAL(&writer, ",\"timestamp_ms\":");
+    akita_json_put_u64(&writer, timestamp_ms);
+    AKITA_JSON_LITERAL(&writer, ",\"board\":");
+    akita_json_put_string(&writer, akita_board_get_name(config->board_profile));
+    AKITA_JSON_LITERAL(&writer, ",\"event\":\"trip\",\"trip\":{\"id\":");
+    akita_json_put_u64(&writer, trip->trip_id);
+    if ((trip->flags & AKITA_TRIP_FLAG_EARLIER_BOOT) == 0U) {
+        AKITA_JSON_LITERAL(&writer, ",\"start_ms\":");
+        akita_json_put_u64(&writer, trip->start_ms);
+    }
+    if (trip->start_utc_ms != 0) {
+        AKITA_JSON_LITERAL(&writer, ",\"start_utc_ms\":");
+        akita_json_put_u64(&writer, (uint64_t) trip->start_utc_ms);
+    }
+    if (trip->end_utc_ms != 0) {
+        AKITA_JSON_LITERAL(&writer, ",\"end_utc_ms\":");
+        akita_json_put_u64(&writer, (uint64_t) trip->end_utc_ms);
+    }
+    AKITA_JSON_LITERAL(&writer, ",\"duration_ms\":");
+    akita_json_put_u64(&writer, trip->duration_ms);
+    AKITA_JSON_LITERAL(&writer, ",\"distance_m\":");
+    akita_json_put_u64(&writer, trip->distance_m);
+    AKITA_JSON_LITERAL(&writer, ",\"max_speed_kmh\":");
+    akita_json_put_fixed(&writer, trip->max_speed_kmh, 1U);
+    AKITA_JSON_LITERAL(&writer, ",\"idle_ms\":");
+    akita_json_put_u64(&writer, trip->idle_ms);
+    AKITA_JSON_LITERAL(&writer, ",\"rpm_band_ms\":[");
+    for (index = 0; index < AKITA_TRIP_RPM_BANDS; ++index) {
+        if (index > 0U) {
+            akita_json_put_char(&writer, ',');
+        }
+        akita_json_put_u64(&writer, trip->rpm_band_ms[index]);
+    }
+    akita_json_put_char(&writer, ']');
+    if (trip->has_start_fix) {
+        AKITA_JSON_LITERAL(&writer, ",\"start\":[");
+        akita_json_put_fixed(&writer, trip->start_latitude, 6U);
+        akita_json_put_char(&writer, ',');
+        akita_json_put_fixed(&writer, trip->start_longitude, 6U);
+        akita_json_put_char(&writer, ']');
+    }
+    if (trip->has_end_fix) {
+        AKITA_JSON_LITERAL(&writer, ",\"end\":[");
+        akita_json_put_fixed(&writer, trip->end_latitude, 6U);
+        akita_json_put_char(&writer, ',');
+        akita_json_put_fixed(&writer, trip->end_longitude, 6U);
+        akita_json_put_char(&writer, ']');
+    }
+    if ((trip->flags & AKITA_TRIP_FLAG_TRUNCATED) != 0U) {
+        AKITA_JSON_LITERAL(&writer, ",\"truncated\":true");
+    }
+    AKITA_JSON_LITERAL(&writer, "}}");
+
+    return akita_json_finish(&writer);
+}
+
+size_t akita_payload_write_json(
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    char *buffer,
+    size_t buffer_size
+) {
+    return akita_payload_write_sample(
+        config,
+        telemetry,
+        (uint64_t) (esp_timer_get_time() / 1000ULL),
+        NULL,
         buffer,
-        buffer_size,
-        used,
-        ",\"h\":%lu,\"q\":%d}",
-        (unsigned long) telemetry->system.free_heap,
-        (int) telemetry->system.wifi_rssi
+        buffer_size
     );
+}
+
+size_t akita_payload_write_compact_json(
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    char *buffer,
+    size_t buffer_size
+) {
+    akita_json_writer_t writer;
+    uint64_t timestamp_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
 
-    if (used >= buffer_size) {
-        buffer[buffer_size - 1] = '\0';
+    if (buffer == NULL || buffer_size == 0 || config == NULL || telemetry == NULL) {
         return 0;
     }
 
-    return used;
-}
\ No newline at end of file
+    akita_json_writer_init(&writer, buffer, buffer_size);
+    AKITA_JSON_LITERAL(&writer, "{\"n\":");
+    akita_json_put_string(&writer, config->vehicle_id);
+    AKITA_JSON_LITERAL(&writer, ",\"t\":");
+    akita_json_put_u64(&writer, timestamp_ms);
+    AKITA_JSON_LITERAL(&writer, ",\"o\":{");
+    AKITA_TELEMETRY_OBD_FIELDS(AKITA_COMPACT_FIELD)
+    akita_json_close_object(&writer);
+    AKITA_JSON_LITERAL(&writer, ",\"g\":{");
+    AKITA_TELEMETRY_GPS_FIELDS(AKITA_COMPACT_FIELD)
+    akita_json_close_object(&writer);
+    akita_json_put_char(&writer, ',');
+    AKITA_TELEMETRY_SYSTEM_FIELDS(AKITA_COMPACT_FIELD)
+    akita_json_close_object(&writer);
+
+    return akita_json_finish(&writer);
+}
@@ -0,0 +1,124 @@
+#include "akita_publish_policy.h"
+
+#include <math.h>
+#include <string.h>
+
+void akita_publish_policy_init(akita_publish_policy_t *policy) {
+    memset(policy, 0, sizeof(*policy));
+}
+
+static float akita_publish_speed_kmh(const akita_vehicle_telemetry_t *telemetry) {
+    if (telemetry->gps.fix) {
+        return telemetry->gps.speed_kmh;
+    }
+
+    return telemetry->obd.connected ? telemetry->obd.speed_kmh : 0.0f;
+}
+
+static float akita_publish_heading_delta(float from_deg, float to_deg) {
+    float delta = fabsf(to_deg - from_deg);
+
+    while (delta >= 360.0f) {
+        delta -= 360.0f;
+    }
+
+    return delta > 180.0f ? 360.0f - delta : delta;
+}
+
+static bool akita_publish_outside(float last, float now, uint32_t deadband) {
+    return deadband > 0U && fabsf(now - last) >= (float) deadband;
+}
+
+static akita_publish_reason_t akita_publish_policy_evaluate(
+    const akita_publish_policy_t *policy,
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t elapsed_ms
+) {
+    const akita_vehicle_telemetry_t *last = &policy->last;
+    float speed_kmh = akita_publish_speed_kmh(telemetry);
+
+    if (!policy->published) {
+        return AKITA_PUBLISH_FIRST;
+    }
+    if (elapsed_ms < config->publish_min_interval_ms) {
+        return AKITA_PUBLISH_SKIP;
+    }
+    if (elapsed_ms >= config->publish_heartbeat_ms) {
+        return AKITA_PUBLISH_HEARTBEAT;
+    }
+
+    if (telemetry->gps.fix != last->gps.fix || telemetry->obd.connected != last->obd.connected) {
+        return AKITA_PUBLISH_STATE;
+    }
+
+    if (akita_publish_outside(akita_publish_speed_kmh(last), speed_kmh, config->publish_speed_deadband_kmh) ||
+        (telemetry->obd.connected &&
+         (akita_publish_outside(last->obd.rpm, telemetry->obd.rpm, config->publish_rpm_deadband) ||
+          akita_publish_outside(last->obd.coolant_c, telemetry->obd.coolant_c, config->publish_coolant_deadband_c)))) {
+        return AKITA_PUBLISH_DEADBAND;
+    }
+
+    /* Distance makes the rate follow speed: a fixed spacing along the road instead of a fixed period. */
+    if (config->publish_distance_m > 0U && policy->travelled_m >= (float) config->publish_distance_m) {
+        return AKITA_PUBLISH_DISTANCE;
+    }
+
+    if (config->publish_heading_deadband_deg > 0U && telemetry->gps.fix &&
+        speed_kmh >= AKITA_PUBLISH_HEADING_MIN_SPEED_KMH &&
+        akita_publish_heading_delta(last->gps.course_deg, telemetry->gps.course_deg) >=
+            (float) config->publish_heading_deadband_deg) {
+        return AKITA_PUBLISH_HEADING;
+    }
+
+    return AKITA_PUBLISH_SKIP;
+}
+
+akita_publish_reason_t akita_publish_policy_check(
+    akita_publish_policy_t *policy,
+    const akita_runtime_config_t *config,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t now_ms
+) {
+    akita_publish_reason_t reason;
+
+    if (policy == NULL || config == NULL || telemetry == NULL) {
+        return AKITA_PUBLISH_SKIP;
+    }
+
+    /* Integrating speed covers both GPS and OBD-only vehicles and does not pick up position jitter while parked. */
+    if (policy->published && now_ms > policy->last_check_ms) {
+        policy->travelled_m += akita_publish_speed_kmh(telemetry) / 3.6f * (float) (now_ms - policy->last_check_ms) / 1000.0f;
+    }
+    policy->last_check_ms = now_ms;
+
+    reason = akita_publish_policy_evaluate(policy, config, telemetry, now_ms - policy->last_publish_ms);
+    ++policy->counts[reason];
+    if (reason != AKITA_PUBLISH_SKIP) {
+        policy->published = true;
+        policy->last_publish_ms = now_ms;
+        policy->travelled_m = 0.0f;
+        policy->last = *telemetry;
+    }
+
+    return reason;
+}
+
+const char *akita_publish_reason_name(akita_publish_reason_t reason) {
+    switch (reason) {
+        case AKITA_PUBLISH_FIRST:
+            return "first";
+        case AKITA_PUBLISH_HEARTBEAT:
+            return "heartbeat";
+        case AKITA_PUBLISH_STATE:
+            return "state";
+        case AKITA_PUBLISH_DEADBAND:
+            return "deadband";
+        case AKITA_PUBLISH_DISTANCE:
+            return "distance";
+        case AKITA_PUBLISH_HEADING:
+            return "heading";
+        default:
+            return "skip";
+    }
+}
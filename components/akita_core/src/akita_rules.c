@@ -0,0 +1,245 @@
+#include "akita_rules.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct {
+    const char *group;
+    const char *name;
+    uint8_t field;
+} akita_rule_field_name_t;
+
+#define AKITA_RULE_NAME_BOOL(group, id, name)
+#define AKITA_RULE_NAME_VALUE(group, id, name) {#group, name, AKITA_AGGREGATE_FIELD_##id},
+#define AKITA_RULE_NAME_FIXED AKITA_RULE_NAME_VALUE
+#define AKITA_RULE_NAME_UINT AKITA_RULE_NAME_VALUE
+#define AKITA_RULE_NAME_INT AKITA_RULE_NAME_VALUE
+#define AKITA_RULE_NAME(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_RULE_NAME_##type(group, id, name)
+
+#define AKITA_RULE_LOAD_BOOL(id, member)
+#define AKITA_RULE_LOAD_VALUE(id, member) \
+    current[AKITA_AGGREGATE_FIELD_##id] = (float) telemetry->member; \
+    valid |= 1UL << AKITA_AGGREGATE_FIELD_##id;
+#define AKITA_RULE_LOAD_FIXED AKITA_RULE_LOAD_VALUE
+#define AKITA_RULE_LOAD_UINT AKITA_RULE_LOAD_VALUE
+#define AKITA_RULE_LOAD_INT AKITA_RULE_LOAD_VALUE
+#define AKITA_RULE_LOAD(group, id, name, short_key, type, decimals, frame, member) \
+    AKITA_RULE_LOAD_##type(id, member)
+
+static const akita_rule_field_name_t kRuleFields[] = {
+    AKITA_TELEMETRY_FIELDS(AKITA_RULE_NAME)
+};
+
+_Static_assert(AKITA_AGGREGATE_FIELD_COUNT <= 32, "rule field mask is 32 bits");
+
+static bool akita_rules_find_field(const char *text, size_t length, uint8_t *field) {
+    size_t index;
+
+    for (index = 0; index < sizeof(kRuleFields) / sizeof(kRuleFields[0]); ++index) {
+        size_t group_len = strlen(kRuleFields[index].group);
+        size_t name_len = strlen(kRuleFields[index].name);
+
+        if (length == group_len + 1U + name_len && strncasecmp(text, kRuleFields[index].group, group_len) == 0 &&
+            text[group_len] == '.' && strncmp(text + group_len + 1U, kRuleFields[index].name, name_len) == 0) {
+            *field = kRuleFields[index].field;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* One rule: name=group.field{>,<,+,-}value[~clear_band][@hold_ms][!] */
+static bool akita_rules_parse(const char *text, size_t length, akita_rule_t *rule, char *error, size_t error_size) {
+    char scratch[96];
+    const char *equals;
+    char *op;
+    char *cursor;
+    float value;
+
+    if (length >= sizeof(scratch)) {
+        snprintf(error, error_size, "rule too long");
+        return false;
+    }
+    memcpy(scratch, text, length);
+    scratch[length] = '\0';
+    memset(rule, 0, sizeof(*rule));
+    rule->message_class = AKITA_MESSAGE_EVENT;
+
+    equals = strchr(scratch, '=');
+    if (equals == NULL || equals == scratch || (size_t) (equals - scratch) >= AKITA_RULE_NAME_LEN) {
+        snprintf(error, error_size, "'%s': expected name=field", scratch);
+        return false;
+    }
+    memcpy(rule->name, scratch, (size_t) (equals - scratch));
+
+    op = strpbrk(equals + 1, "<>+-");
+    if (op == NULL || !akita_rules_find_field(equals + 1, (size_t) (op - equals - 1), &rule->field)) {
+        snprintf(error, error_size, "'%s': unknown field", scratch);
+        return false;
+    }
+
+    rule->op = *op == '>' ? AKITA_RULE_ABOVE : *op == '<' ? AKITA_RULE_BELOW : *op == '+' ? AKITA_RULE_RISING : AKITA_RULE_FALLING;
+    value = strtof(op + 1, &cursor);
+    if (cursor == op + 1) {
+        snprintf(error, error_size, "'%s': missing threshold", scratch);
+        return false;
+    }
+
+    while (*cursor != '\0') {
+        char *end = cursor + 1;
+
+        if (*cursor == '~') {
+            rule->clear_band = strtof(cursor + 1, &end);
+        } else if (*cursor == '@') {
+            unsigned long hold_ms = strtoul(cursor + 1, &end, 10);
+            rule->hold_ms = (uint16_t) (hold_ms > UINT16_MAX ? UINT16_MAX : hold_ms);
+        } else if (*cursor == '!') {
+            rule->message_class = AKITA_MESSAGE_ALERT;
+        } else if (*cursor != ' ') {
+            snprintf(error, error_size, "'%s': unexpected '%c'", scratch, *cursor);
+            return false;
+        }
+        cursor = end;
+    }
+
+    /* Stored so that "sign * input >= threshold" is the trigger test for every operator. */
+    rule->threshold = rule->op == AKITA_RULE_BELOW ? -value : value;
+    return true;
+}
+
+size_t akita_rules_compile(akita_rule_set_t *set, const char *source, char *error, size_t error_size) {
+    const char *cursor = source;
+    char ignored[1];
+
+    if (set == NULL) {
+        return 0;
+    }
+    if (error == NULL || error_size == 0U) {
+        error = ignored;
+        error_size = sizeof(ignored);
+    }
+
+    memset(set, 0, sizeof(*set));
+    error[0] = '\0';
+    while (cursor != NULL && *cursor != '\0' && set->count < AKITA_RULES_MAX) {
+        const char *end = strchr(cursor, ';');
+        size_t length = end != NULL ? (size_t) (end - cursor) : strlen(cursor);
+
+        while (length > 0U && *cursor == ' ') {
+            ++cursor;
+            --length;
+        }
+        /* A bad rule is reported and skipped so the others still run. */
+        if (length > 0U && akita_rules_parse(cursor, length, &set->rules[set->count], error, error_size)) {
+            ++set->count;
+        }
+        cursor = end != NULL ? end + 1 : NULL;
+    }
+
+    return set->count;
+}
+
+static void akita_rules_update_inputs(akita_rule_set_t *set, const akita_vehicle_telemetry_t *telemetry, uint64_t now_ms) {
+    float current[AKITA_AGGREGATE_FIELD_COUNT] = {0};
+    uint32_t valid = 0;
+    size_t index;
+
+    if (telemetry->obd.connected) {
+        AKITA_TELEMETRY_OBD_FIELDS(AKITA_RULE_LOAD)
+    }
+    if (telemetry->gps.fix) {
+        AKITA_TELEMETRY_GPS_FIELDS(AKITA_RULE_LOAD)
+    }
+    AKITA_TELEMETRY_SYSTEM_FIELDS(AKITA_RULE_LOAD)
+
+    /*
+     * Rates are taken between successive distinct readings, so a 1 Hz GPS seen by a 5 Hz poll
+     * gives its real slope instead of a spike followed by zeros.
+     */
+    for (index = 0; index < AKITA_AGGREGATE_FIELD_COUNT; ++index) {
+        bool was_valid = (set->valid_fields & (1UL << index)) != 0U;
+
+        if ((valid & (1UL << index)) == 0U) {
+            set->rate[index] = 0.0f;
+            continue;
+        }
+
+        if (!was_valid) {
+            set->rate[index] = 0.0f;
+            set->value[index] = current[index];
+            set->changed_ms[index] = now_ms;
+        } else if (current[index] != set->value[index]) {
+            set->rate[index] = now_ms > set->changed_ms[index]
+                                   ? (current[index] - set->value[index]) * 1000.0f / (float) (now_ms - set->changed_ms[index])
+                                   : 0.0f;
+            set->value[index] = current[index];
+            set->changed_ms[index] = now_ms;
+        } else if (now_ms - set->changed_ms[index] >= AKITA_RULE_RATE_STALE_MS) {
+            set->rate[index] = 0.0f;
+        }
+    }
+
+    set->valid_fields = valid;
+}
+
+size_t akita_rules_evaluate(
+    akita_rule_set_t *set,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t now_ms,
+    akita_rule_match_t *matches,
+    size_t max_matches
+) {
+    size_t match_count = 0;
+    uint8_t index;
+
+    if (set == NULL || telemetry == NULL) {
+        return 0;
+    }
+
+    akita_rules_update_inputs(set, telemetry, now_ms);
+    for (index = 0; index < set->count; ++index) {
+        const akita_rule_t *rule = &set->rules[index];
+        akita_rule_state_t *state = &set->state[index];
+        float input = rule->op >= AKITA_RULE_RISING ? set->rate[rule->field] : set->value[rule->field];
+        float signed_input = (rule->op & 1U) != 0U ? -input : input;
+
+        /* A rule on a field that went invalid (OBD lost, GPS fix lost) resets without an event. */
+        if ((set->valid_fields & (1UL << rule->field)) == 0U) {
+            state->pending = false;
+            state->active = false;
+            continue;
+        }
+
+        if (state->active) {
+            if (signed_input < rule->threshold - rule->clear_band) {
+                state->active = false;
+                if (rule->message_class == AKITA_MESSAGE_ALERT && match_count < max_matches) {
+                    matches[match_count++] = (akita_rule_match_t) {.rule = index, .cleared = true, .value = input};
+                }
+            }
+            continue;
+        }
+
+        if (signed_input < rule->threshold) {
+            state->pending = false;
+            continue;
+        }
+        if (!state->pending) {
+            state->pending = true;
+            state->since_ms = now_ms;
+        }
+        if (now_ms - state->since_ms >= rule->hold_ms) {
+            state->pending = false;
+            state->active = true;
+            if (match_count < max_matches) {
+                matches[match_count++] = (akita_rule_match_t) {.rule = index, .cleared = false, .value = input};
+            }
+        }
+    }
+
+    return match_count;
+}
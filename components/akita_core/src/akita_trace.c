@@ -0,0 +1,162 @@
+#include "akita_trace.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+void akita_trace_begin(akita_trace_t *trace, uint32_t id, uint64_t acquired_us, uint64_t queued_us) {
+    memset(trace, 0, sizeof(*trace));
+    trace->id = id;
+    /* A sample without a sensor reading starts when it was queued. */
+    trace->at_us[AKITA_TRACE_ACQUIRED] = acquired_us != 0U && acquired_us <= queued_us ? acquired_us : queued_us;
+    trace->at_us[AKITA_TRACE_QUEUED] = queued_us;
+}
+
+void akita_trace_mark(akita_trace_t *trace, akita_trace_point_t point, uint64_t at_us) {
+    if (point < AKITA_TRACE_POINT_COUNT) {
+        trace->at_us[point] = at_us;
+    }
+}
+
+void akita_trace_histogram_add(akita_trace_histogram_t *histogram, uint64_t latency_us) {
+    uint32_t bucket = 0;
+    uint64_t value = latency_us >> AKITA_TRACE_BUCKET_SHIFT;
+
+    while (value != 0U && bucket < AKITA_TRACE_BUCKETS - 1U) {
+        value >>= 1;
+        ++bucket;
+    }
+
+    ++histogram->count;
+    ++histogram->buckets[bucket];
+    histogram->total_us += latency_us;
+    if (latency_us > histogram->max_us) {
+        histogram->max_us = latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t) latency_us;
+    }
+}
+
+void akita_trace_record(akita_trace_stats_t *stats, const akita_trace_t *trace) {
+    size_t stage;
+
+    ++stats->traces;
+    for (stage = 0; stage < AKITA_TRACE_STAGE_TOTAL; ++stage) {
+        uint64_t start_us = trace->at_us[stage];
+        uint64_t end_us = trace->at_us[stage + 1U];
+
+        if (start_us != 0U && end_us >= start_us) {
+            akita_trace_histogram_add(&stats->stages[stage], end_us - start_us);
+        }
+    }
+
+    if (trace->at_us[AKITA_TRACE_ACKED] >= trace->at_us[AKITA_TRACE_ACQUIRED] && trace->at_us[AKITA_TRACE_ACQUIRED] != 0U) {
+        akita_trace_histogram_add(&stats->stages[AKITA_TRACE_STAGE_TOTAL],
+                                  trace->at_us[AKITA_TRACE_ACKED] - trace->at_us[AKITA_TRACE_ACQUIRED]);
+    }
+}
+
+uint32_t akita_trace_histogram_percentile(const akita_trace_histogram_t *histogram, uint8_t percent) {
+    uint64_t target;
+    uint64_t seen = 0;
+    size_t bucket;
+
+    if (histogram->count == 0U) {
+        return 0;
+    }
+
+    target = ((uint64_t) histogram->count * percent + 99U) / 100U;
+    for (bucket = 0; bucket < AKITA_TRACE_BUCKETS; ++bucket) {
+        seen += histogram->buckets[bucket];
+        if (seen >= target && seen > 0U) {
+            uint64_t upper_us = 1ULL << (bucket + AKITA_TRACE_BUCKET_SHIFT);
+
+            return upper_us < histogram->max_us ? (uint32_t) upper_us : histogram->max_us;
+        }
+    }
+
+    return histogram->max_us;
+}
+
+const char *akita_trace_stage_name(akita_trace_stage_t stage) {
+    switch (stage) {
+        case AKITA_TRACE_STAGE_SAMPLE:
+            return "sample";
+        case AKITA_TRACE_STAGE_QUEUE:
+            return "queue";
+        case AKITA_TRACE_STAGE_ENCODE:
+            return "encode";
+        case AKITA_TRACE_STAGE_TRANSMIT:
+            return "transmit";
+        case AKITA_TRACE_STAGE_TOTAL:
+            return "total";
+        default:
+            return "unknown";
+    }
+}
+
+static bool akita_trace_append(char *buffer, size_t buffer_size, size_t *used, const char *format, ...) {
+    va_list args;
+    int written;
+
+    if (*used >= buffer_size) {
+        return false;
+    }
+
+    va_start(args, format);
+    written = vsnprintf(buffer + *used, buffer_size - *used, format, args);
+    va_end(args);
+    if (written < 0 || (size_t) written >= buffer_size - *used) {
+        *used = buffer_size;
+        return false;
+    }
+
+    *used += (size_t) written;
+    return true;
+}
+
+size_t akita_trace_write_json(const akita_trace_stats_t *stats, char *buffer, size_t buffer_size) {
+    size_t used = 0;
+    size_t stage;
+
+    if (buffer == NULL || buffer_size == 0U || stats == NULL) {
+        return 0;
+    }
+
+    akita_trace_append(buffer, buffer_size, &used, "{\"traces\":%lu", (unsigned long) stats->traces);
+    for (stage = 0; stage < AKITA_TRACE_STAGE_COUNT; ++stage) {
+        const akita_trace_histogram_t *histogram = &stats->stages[stage];
+        size_t last = AKITA_TRACE_BUCKETS;
+        size_t bucket;
+
+        /* Trailing empty buckets are left out; the array still starts at the 16 us bucket. */
+        while (last > 0U && histogram->buckets[last - 1U] == 0U) {
+            --last;
+        }
+
+        akita_trace_append(
+            buffer,
+            buffer_size,
+            &used,
+            ",\"%s\":{\"n\":%lu,\"mean_us\":%lu,\"p50_us\":%lu,\"p90_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu,\"buckets\":[",
+            akita_trace_stage_name((akita_trace_stage_t) stage),
+            (unsigned long) histogram->count,
+            (unsigned long) (histogram->count > 0U ? histogram->total_us / histogram->count : 0U),
+            (unsigned long) akita_trace_histogram_percentile(histogram, 50U),
+            (unsigned long) akita_trace_histogram_percentile(histogram, 90U),
+            (unsigned long) akita_trace_histogram_percentile(histogram, 99U),
+            (unsigned long) histogram->max_us
+        );
+        for (bucket = 0; bucket < last; ++bucket) {
+            akita_trace_append(buffer, buffer_size, &used, bucket == 0U ? "%lu" : ",%lu",
+                               (unsigned long) histogram->buckets[bucket]);
+        }
+        akita_trace_append(buffer, buffer_size, &used, "]}");
+    }
+
+    if (!akita_trace_append(buffer, buffer_size, &used, "}")) {
+        buffer[buffer_size - 1U] = '\0';
+        return 0;
+    }
+
+    return used;
+}
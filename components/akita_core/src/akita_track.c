@@ -0,0 +1,144 @@
+#include "akita_track.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 0.11132 m per microdegree of latitude, in decimetres, Q16. */
+#define AKITA_TRACK_LAT_SCALE_Q16 72956
+#define AKITA_TRACK_MAX_SEGMENT_DM ((int64_t) AKITA_TRACK_MAX_SEGMENT_M * 10)
+
+void akita_track_init(akita_track_t *track, uint16_t tolerance_m) {
+    memset(track, 0, sizeof(*track));
+    if (tolerance_m > AKITA_TRACK_MAX_TOLERANCE_M) {
+        tolerance_m = AKITA_TRACK_MAX_TOLERANCE_M;
+    }
+    track->tolerance_dm = (uint32_t) tolerance_m * 10U;
+}
+
+static void akita_track_keep(akita_track_t *track, const akita_track_point_t *point) {
+    /* The app publishes before this fills; if it still does, the oldest kept point goes. */
+    if (track->count == AKITA_TRACK_MAX_POINTS) {
+        memmove(&track->points[0], &track->points[1], sizeof(track->points[0]) * (AKITA_TRACK_MAX_POINTS - 1U));
+        --track->count;
+        ++track->overflowed;
+    }
+
+    track->points[track->count++] = *point;
+    ++track->kept;
+}
+
+static void akita_track_set_anchor(akita_track_t *track, const akita_track_point_t *point) {
+    /* The only floating point step, once per kept point rather than per fix. */
+    track->anchor = *point;
+    track->lon_scale_q16 = (int32_t) lroundf(AKITA_TRACK_LAT_SCALE_Q16 * cosf((float) point->latitude_e6 * 1.745329252e-8f));
+    track->has_anchor = true;
+    track->window_count = 0;
+}
+
+static void akita_track_project(const akita_track_t *track, akita_track_window_entry_t *entry) {
+    int64_t dlat = (int64_t) entry->point.latitude_e6 - track->anchor.latitude_e6;
+    int64_t dlon = (int64_t) entry->point.longitude_e6 - track->anchor.longitude_e6;
+
+    entry->x_dm = (int32_t) ((dlon * track->lon_scale_q16) / 65536);
+    entry->y_dm = (int32_t) ((dlat * AKITA_TRACK_LAT_SCALE_Q16) / 65536);
+}
+
+static bool akita_track_in_reach(const akita_track_window_entry_t *entry) {
+    return llabs(entry->x_dm) <= AKITA_TRACK_MAX_SEGMENT_DM && llabs(entry->y_dm) <= AKITA_TRACK_MAX_SEGMENT_DM;
+}
+
+/* True when the point is farther than the tolerance from the segment anchor -> (bx, by). */
+static bool akita_track_deviates(const akita_track_window_entry_t *entry, int64_t bx, int64_t by, uint64_t tolerance_sq) {
+    int64_t px = entry->x_dm;
+    int64_t py = entry->y_dm;
+    int64_t dot = px * bx + py * by;
+    int64_t length_sq = bx * bx + by * by;
+    int64_t cross;
+
+    if (dot <= 0) {
+        return (uint64_t) (px * px + py * py) > tolerance_sq;
+    }
+    if (dot >= length_sq) {
+        return (uint64_t) ((px - bx) * (px - bx) + (py - by) * (py - by)) > tolerance_sq;
+    }
+
+    cross = px * by - py * bx;
+    return (uint64_t) (cross * cross) > tolerance_sq * (uint64_t) length_sq;
+}
+
+bool akita_track_add(akita_track_t *track, int32_t latitude_e6, int32_t longitude_e6, uint64_t timestamp_ms) {
+    akita_track_window_entry_t entry = {
+        .point = {
+            .latitude_e6 = latitude_e6,
+            .longitude_e6 = longitude_e6,
+            .timestamp_ms = timestamp_ms,
+        },
+    };
+    const akita_track_point_t *newest;
+    uint64_t tolerance_sq;
+    bool split = false;
+    uint8_t index;
+
+    if (track == NULL) {
+        return false;
+    }
+
+    ++track->fixes;
+    if (!track->has_anchor) {
+        akita_track_set_anchor(track, &entry.point);
+        akita_track_keep(track, &entry.point);
+        return true;
+    }
+
+    /* A parked receiver repeats the same fix; it adds nothing to the path. */
+    newest = track->window_count > 0U ? &track->window[track->window_count - 1U].point : &track->anchor;
+    if (entry.point.latitude_e6 == newest->latitude_e6 && entry.point.longitude_e6 == newest->longitude_e6) {
+        return false;
+    }
+
+    akita_track_project(track, &entry);
+    split = track->window_count == AKITA_TRACK_WINDOW || !akita_track_in_reach(&entry);
+
+    /* Opening window: the segment to the new fix must pass within tolerance of every fix it would replace. */
+    tolerance_sq = (uint64_t) track->tolerance_dm * track->tolerance_dm;
+    for (index = 0; !split && index < track->window_count; ++index) {
+        split = akita_track_deviates(&track->window[index], entry.x_dm, entry.y_dm, tolerance_sq);
+    }
+
+    if (!split) {
+        track->window[track->window_count++] = entry;
+        return false;
+    }
+
+    /* The previous fix ends the last segment that stayed within tolerance and anchors the next one. */
+    if (track->window_count > 0U) {
+        akita_track_point_t corner = track->window[track->window_count - 1U].point;
+
+        akita_track_keep(track, &corner);
+        akita_track_set_anchor(track, &corner);
+        akita_track_project(track, &entry);
+        if (akita_track_in_reach(&entry)) {
+            track->window[track->window_count++] = entry;
+            return true;
+        }
+    }
+
+    /* A fix more than a segment past the last kept point, such as a jump after a lost fix, is kept as is. */
+    akita_track_keep(track, &entry.point);
+    akita_track_set_anchor(track, &entry.point);
+    return true;
+}
+
+size_t akita_track_take(akita_track_t *track, akita_track_point_t *points, size_t max_points) {
+    size_t count;
+
+    if (track == NULL || points == NULL) {
+        return 0;
+    }
+
+    count = track->count < max_points ? track->count : max_points;
+    memcpy(points, track->points, sizeof(points[0]) * count);
+    track->count = 0;
+    return count;
+}
@@ -0,0 +1,129 @@
+#include "akita_trip.h"
+
+#include <string.h>
+
+static const float kRpmBandEdges[AKITA_TRIP_RPM_BANDS - 1U] = {1500.0f, 2500.0f, 3500.0f, 4500.0f};
+
+void akita_trip_init(akita_trip_tracker_t *tracker, uint32_t next_id) {
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->next_id = next_id == 0U ? 1U : next_id;
+}
+
+static float akita_trip_speed_kmh(const akita_vehicle_telemetry_t *telemetry) {
+    if (telemetry->gps.fix) {
+        return telemetry->gps.speed_kmh;
+    }
+
+    return telemetry->obd.connected ? telemetry->obd.speed_kmh : 0.0f;
+}
+
+static void akita_trip_begin(akita_trip_tracker_t *tracker, uint64_t now_ms) {
+    memset(&tracker->record, 0, sizeof(tracker->record));
+    tracker->record.start_ms = now_ms;
+    tracker->distance_m = 0.0f;
+    tracker->candidate = true;
+    tracker->last_active_ms = now_ms;
+}
+
+static void akita_trip_accumulate(
+    akita_trip_tracker_t *tracker,
+    const akita_vehicle_telemetry_t *telemetry,
+    float speed_kmh,
+    uint32_t step_ms
+) {
+    akita_trip_record_t *record = &tracker->record;
+    bool engine_on = telemetry->obd.connected && telemetry->obd.rpm >= AKITA_TRIP_ENGINE_RPM;
+    uint32_t band = 0;
+
+    tracker->distance_m += speed_kmh / 3.6f * (float) step_ms / 1000.0f;
+    if (speed_kmh > record->max_speed_kmh) {
+        record->max_speed_kmh = speed_kmh;
+    }
+
+    if (engine_on) {
+        while (band < AKITA_TRIP_RPM_BANDS - 1U && telemetry->obd.rpm >= kRpmBandEdges[band]) {
+            ++band;
+        }
+        record->rpm_band_ms[band] += step_ms;
+        if (speed_kmh < AKITA_TRIP_IDLE_KMH) {
+            record->idle_ms += step_ms;
+        }
+    }
+
+    if (telemetry->gps.fix) {
+        if (!record->has_start_fix) {
+            record->has_start_fix = true;
+            record->start_latitude = telemetry->gps.latitude;
+            record->start_longitude = telemetry->gps.longitude;
+        }
+        record->has_end_fix = true;
+        record->end_latitude = telemetry->gps.latitude;
+        record->end_longitude = telemetry->gps.longitude;
+    }
+}
+
+void akita_trip_snapshot(const akita_trip_tracker_t *tracker, akita_trip_record_t *record) {
+    *record = tracker->record;
+    record->duration_ms = (uint32_t) (tracker->last_active_ms - tracker->record.start_ms);
+    record->distance_m = (uint32_t) (tracker->distance_m + 0.5f);
+}
+
+akita_trip_event_t akita_trip_update(
+    akita_trip_tracker_t *tracker,
+    const akita_vehicle_telemetry_t *telemetry,
+    uint64_t now_ms,
+    akita_trip_record_t *finished
+) {
+    float speed_kmh;
+    bool engine_on;
+    bool active;
+    uint32_t step_ms;
+
+    if (tracker == NULL || telemetry == NULL) {
+        return AKITA_TRIP_NONE;
+    }
+
+    speed_kmh = akita_trip_speed_kmh(telemetry);
+    engine_on = telemetry->obd.connected && telemetry->obd.rpm >= AKITA_TRIP_ENGINE_RPM;
+    active = engine_on || speed_kmh >= AKITA_TRIP_MOVING_KMH;
+    step_ms = tracker->last_ms != 0U && now_ms > tracker->last_ms ? (uint32_t) (now_ms - tracker->last_ms) : 0U;
+    if (step_ms > AKITA_TRIP_MAX_STEP_MS) {
+        step_ms = 0U;
+    }
+    tracker->last_ms = now_ms;
+
+    if (!tracker->candidate && !tracker->active) {
+        if (active) {
+            akita_trip_begin(tracker, now_ms);
+        }
+        return AKITA_TRIP_NONE;
+    }
+
+    if (active) {
+        tracker->last_active_ms = now_ms;
+        akita_trip_accumulate(tracker, telemetry, speed_kmh, step_ms);
+    }
+
+    /* A few seconds of ignition or a car rolling past the antenna is not a trip. */
+    if (tracker->candidate) {
+        if (!active) {
+            tracker->candidate = false;
+        } else if (now_ms - tracker->record.start_ms >= AKITA_TRIP_START_MS) {
+            tracker->candidate = false;
+            tracker->active = true;
+            tracker->record.trip_id = tracker->next_id++;
+            return AKITA_TRIP_STARTED;
+        }
+        return AKITA_TRIP_NONE;
+    }
+
+    if (active || now_ms - tracker->last_active_ms < AKITA_TRIP_STOP_MS) {
+        return AKITA_TRIP_NONE;
+    }
+
+    tracker->active = false;
+    if (finished != NULL) {
+        akita_trip_snapshot(tracker, finished);
+    }
+    return AKITA_TRIP_ENDED;
+}
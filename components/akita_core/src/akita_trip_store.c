@@ -0,0 +1,102 @@
+#include "akita_trip_store.h"
+
+#include <string.h>
+
+#include "akita_metrics.h"
+#include "nvs.h"
+
+static const char *AKITA_TRIP_NAMESPACE = "akita_trip";
+static const char *AKITA_TRIP_KEY = "trips";
+
+esp_err_t akita_trip_store_load(akita_trip_store_t *store) {
+    nvs_handle_t handle;
+    size_t blob_size = sizeof(*store);
+    esp_err_t err;
+
+    if (store == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(store, 0, sizeof(*store));
+    store->version = AKITA_TRIP_STORE_VERSION;
+    store->next_id = 1U;
+
+    err = nvs_open(AKITA_TRIP_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    AKITA_METRIC_BEGIN(span);
+    err = nvs_get_blob(handle, AKITA_TRIP_KEY, store, &blob_size);
+    AKITA_METRIC_END(span, AKITA_METRIC_NVS_TRIP_READ, err == ESP_OK);
+    nvs_close(handle);
+    if (err == ESP_OK && (blob_size != sizeof(*store) || store->version != AKITA_TRIP_STORE_VERSION)) {
+        err = ESP_ERR_INVALID_VERSION;
+    }
+    if (err != ESP_OK) {
+        memset(store, 0, sizeof(*store));
+        store->version = AKITA_TRIP_STORE_VERSION;
+        store->next_id = 1U;
+        return err;
+    }
+
+    if (store->pending_count > AKITA_TRIP_STORE_PENDING_MAX) {
+        store->pending_count = AKITA_TRIP_STORE_PENDING_MAX;
+    }
+    if (store->next_id == 0U) {
+        store->next_id = 1U;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t akita_trip_store_save(const akita_trip_store_t *store) {
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    if (store == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    err = nvs_open(AKITA_TRIP_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    AKITA_METRIC_BEGIN(span);
+    err = nvs_set_blob(handle, AKITA_TRIP_KEY, store, sizeof(*store));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    AKITA_METRIC_END(span, AKITA_METRIC_NVS_TRIP_WRITE, err == ESP_OK);
+
+    nvs_close(handle);
+    return err;
+}
+
+void akita_trip_store_add_pending(akita_trip_store_t *store, const akita_trip_record_t *record) {
+    /* With no uplink for longer than four trips, the oldest record gives way. */
+    if (store->pending_count == AKITA_TRIP_STORE_PENDING_MAX) {
+        memmove(&store->pending[0], &store->pending[1], sizeof(store->pending[0]) * (AKITA_TRIP_STORE_PENDING_MAX - 1U));
+        --store->pending_count;
+    }
+
+    store->pending[store->pending_count++] = *record;
+}
+
+bool akita_trip_store_remove_pending(akita_trip_store_t *store, uint32_t trip_id) {
+    uint8_t index;
+
+    for (index = 0; index < store->pending_count; ++index) {
+        if (store->pending[index].trip_id != trip_id) {
+            continue;
+        }
+
+        memmove(&store->pending[index], &store->pending[index + 1U],
+                sizeof(store->pending[0]) * (size_t) (store->pending_count - index - 1U));
+        --store->pending_count;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,31 @@
+#ifndef AKITA_NMEA_H
+#define AKITA_NMEA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+#define AKITA_NMEA_SENTENCE_MAX_LEN 128U
+
+typedef struct {
+    char sentence[AKITA_NMEA_SENTENCE_MAX_LEN];
+    size_t sentence_len;
+    bool sentence_overflow;
+    /* Latest time the sentence being parsed can have been received, in uptime microseconds. */
+    uint64_t sentence_us;
+    uint64_t last_fix_ms;
+    akita_gps_snapshot_t fix;
+} akita_nmea_parser_t;
+
+void akita_nmea_reset(akita_nmea_parser_t *parser);
+/*
+ * Parses received bytes. last_byte_us is the latest the final byte can have arrived and byte_us the time one
+ * byte takes on the wire, so each line is dated by how many bytes came after it.
+ */
+void akita_nmea_feed(akita_nmea_parser_t *parser, const uint8_t *data, size_t length, uint64_t last_byte_us, uint32_t byte_us);
+/* Copies the fix out with its age at now_us; pps_us is the last PPS edge, 0 without one. */
+void akita_nmea_snapshot(akita_nmea_parser_t *parser, uint64_t now_us, uint64_t pps_us, akita_gps_snapshot_t *snapshot);
+
+#endif
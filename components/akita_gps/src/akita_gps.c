@@ -1,12 +1,14 @@
 #include "akita_gps.h"
 
-#include <ctype.h>
 #include <stdbool.h>
-#include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
+#include "akita_capture.h"
+#include "akita_metrics.h"
+#include "akita_nmea.h"
+#include "driver/gpio.h"
 #include "driver/uart.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -15,14 +17,20 @@
 static const char *TAG = "akita_gps";
 static bool g_gps_ready;
 static bool g_uart_driver_ready;
-static bool g_sentence_overflow;
 static uart_port_t g_uart_port;
-static char g_sentence[128];
-static size_t g_sentence_len;
-static akita_gps_snapshot_t g_latest_fix;
-static uint64_t g_last_fix_ms;
+static akita_nmea_parser_t g_parser;
+static uint32_t g_byte_us;
+static int32_t g_pps_pin = AKITA_INVALID_PIN;
+static volatile uint64_t g_pps_us;
+static uint64_t g_captured_pps_us;
 static SemaphoreHandle_t g_gps_lock;
 
+/* Only stamps the edge; the GPIO ISR service is not installed with ESP_INTR_FLAG_IRAM, so this stays in flash. */
+static void akita_gps_pps_isr(void *arg) {
+    (void) arg;
+    g_pps_us = (uint64_t) esp_timer_get_time();
+}
+
 static esp_err_t akita_gps_ensure_lock(void) {
     if (g_gps_lock == NULL) {
         g_gps_lock = xSemaphoreCreateMutex();
@@ -35,17 +43,18 @@ static esp_err_t akita_gps_ensure_lock(void) {
 }
 
 static void akita_gps_reset_parser_state(void) {
-    memset(&g_latest_fix, 0, sizeof(g_latest_fix));
-    memset(g_sentence, 0, sizeof(g_sentence));
-    g_sentence_len = 0;
-    g_sentence_overflow = false;
-    g_last_fix_ms = 0;
+    akita_nmea_reset(&g_parser);
+    g_pps_us = 0;
 }
 
 static void akita_gps_stop_locked(void) {
     esp_err_t err;
 
     g_gps_ready = false;
+    if (g_pps_pin != AKITA_INVALID_PIN) {
+        gpio_isr_handler_remove((gpio_num_t) g_pps_pin);
+        g_pps_pin = AKITA_INVALID_PIN;
+    }
     if (g_uart_driver_ready) {
         err = uart_driver_delete(g_uart_port);
         if (err != ESP_OK) {
@@ -57,130 +66,35 @@ static void akita_gps_stop_locked(void) {
     akita_gps_reset_parser_state();
 }
 
-static bool akita_nmea_checksum_ok(const char *sentence) {
-    const char *star;
-    unsigned expected;
-    unsigned calculated = 0;
-    const char *cursor;
-
-    if (sentence == NULL || sentence[0] != '$') {
-        return false;
-    }
-
-    star = strrchr(sentence, '*');
-    if (star == NULL || !isxdigit((unsigned char) star[1]) || !isxdigit((unsigned char) star[2])) {
-        return true;
-    }
-
-    expected = (unsigned) strtoul(star + 1, NULL, 16);
-    for (cursor = sentence + 1; cursor < star; ++cursor) {
-        calculated ^= (unsigned char) *cursor;
-    }
-
-    return calculated == expected;
-}
-
-static bool akita_nmea_is_type(const char *sentence, const char *type) {
-    return sentence != NULL &&
-           type != NULL &&
-           sentence[0] == '$' &&
-           strlen(sentence) >= 6U &&
-           strncmp(sentence + 3, type, 3) == 0;
-}
-
-static float akita_nmea_to_decimal(const char *text, char hemisphere) {
-    double raw;
-    int degrees;
-    double minutes;
-    double decimal;
-
-    if (text == NULL || text[0] == '\0') {
-        return 0.0f;
-    }
-
-    raw = atof(text);
-    degrees = (int) (raw / 100.0);
-    minutes = raw - ((double) degrees * 100.0);
-    decimal = (double) degrees + (minutes / 60.0);
-
-    if (hemisphere == 'S' || hemisphere == 'W') {
-        decimal = -decimal;
-    }
-
-    return (float) decimal;
-}
-
-static size_t akita_split_csv(char *text, char *tokens[], size_t max_tokens) {
-    size_t count = 0;
-    char *cursor = text;
-
-    if (text == NULL || tokens == NULL || max_tokens == 0) {
-        return 0;
-    }
-
-    tokens[count++] = cursor;
-    while (*cursor != '\0' && count < max_tokens) {
-        if (*cursor == ',') {
-            *cursor = '\0';
-            tokens[count++] = cursor + 1;
-        }
-        ++cursor;
-    }
-
-    return count;
-}
-
-static void akita_gps_parse_gga(char *sentence) {
-    char *tokens[16] = { 0 };
-    size_t count = akita_split_csv(sentence, tokens, 16);
-
-    if (count < 10 || tokens[2][0] == '\0' || tokens[4][0] == '\0') {
-        return;
-    }
+static void akita_gps_attach_pps(int32_t pin) {
+    gpio_config_t io_config = { 0 };
+    esp_err_t err;
 
-    if (tokens[6][0] == '0' || tokens[6][0] == '\0') {
-        g_latest_fix.fix = false;
+    if (pin < 0 || pin >= GPIO_NUM_MAX) {
         return;
     }
 
-    g_latest_fix.fix = true;
-    g_latest_fix.latitude = akita_nmea_to_decimal(tokens[2], tokens[3][0]);
-    g_latest_fix.longitude = akita_nmea_to_decimal(tokens[4], tokens[5][0]);
-    g_latest_fix.satellites = (uint8_t) atoi(tokens[7]);
-    g_latest_fix.altitude_m = (float) atof(tokens[9]);
-    g_last_fix_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
-}
-
-static void akita_gps_parse_rmc(char *sentence) {
-    char *tokens[16] = { 0 };
-    size_t count = akita_split_csv(sentence, tokens, 16);
-
-    if (count < 8 || tokens[3][0] == '\0' || tokens[5][0] == '\0') {
-        return;
+    io_config.pin_bit_mask = 1ULL << (uint32_t) pin;
+    io_config.mode = GPIO_MODE_INPUT;
+    io_config.intr_type = GPIO_INTR_POSEDGE;
+    err = gpio_config(&io_config);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;
+        }
     }
-
-    if (tokens[2][0] != 'A') {
-        g_latest_fix.fix = false;
-        return;
+    if (err == ESP_OK) {
+        err = gpio_isr_handler_add((gpio_num_t) pin, akita_gps_pps_isr, NULL);
     }
 
-    g_latest_fix.fix = true;
-    g_latest_fix.latitude = akita_nmea_to_decimal(tokens[3], tokens[4][0]);
-    g_latest_fix.longitude = akita_nmea_to_decimal(tokens[5], tokens[6][0]);
-    g_latest_fix.speed_kmh = (float) atof(tokens[7]) * 1.852f;
-    g_last_fix_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
-}
-
-static void akita_gps_process_sentence(char *sentence) {
-    if (!akita_nmea_checksum_ok(sentence)) {
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "GPS PPS on pin %ld unavailable (%s); timing from NMEA only", (long) pin, esp_err_to_name(err));
         return;
     }
 
-    if (akita_nmea_is_type(sentence, "GGA")) {
-        akita_gps_parse_gga(sentence);
-    } else if (akita_nmea_is_type(sentence, "RMC")) {
-        akita_gps_parse_rmc(sentence);
-    }
+    g_pps_pin = pin;
+    ESP_LOGI(TAG, "GPS PPS capture on pin %ld", (long) pin);
 }
 
 esp_err_t akita_gps_init(const akita_runtime_config_t *config) {
@@ -233,6 +147,9 @@ esp_err_t akita_gps_init(const akita_runtime_config_t *config) {
         return err;
     }
 
+    /* Ten bits per byte on the wire, for dating sentences by their place in the receive buffer. */
+    g_byte_us = 10000000U / config->gps_uart_baud;
+    akita_gps_attach_pps(config->gps_pps_pin);
     g_gps_ready = true;
     ESP_LOGI(
         TAG,
@@ -247,9 +164,11 @@ esp_err_t akita_gps_init(const akita_runtime_config_t *config) {
 
 void akita_gps_poll(akita_gps_snapshot_t *snapshot) {
     uint8_t rx_buffer[64];
+    size_t buffered = 0;
     int bytes_read;
-    int index;
-    uint64_t now_ms;
+    uint64_t now_us;
+    uint64_t last_byte_us;
+    uint64_t pps_us;
     esp_err_t err;
 
     if (snapshot == NULL) {
@@ -270,36 +189,42 @@ void akita_gps_poll(akita_gps_snapshot_t *snapshot) {
         return;
     }
 
-    bytes_read = uart_read_bytes(g_uart_port, rx_buffer, sizeof(rx_buffer), 0);
-    if (bytes_read < 0) {
-        *snapshot = g_latest_fix;
-        xSemaphoreGive(g_gps_lock);
-        return;
-    }
-
-    for (index = 0; index < bytes_read; ++index) {
-        char current = (char) rx_buffer[index];
-        if (current == '\n') {
-            g_sentence[g_sentence_len] = '\0';
-            if (!g_sentence_overflow && g_sentence_len > 6) {
-                akita_gps_process_sentence(g_sentence);
-            }
-            g_sentence_len = 0;
-            g_sentence_overflow = false;
-        } else if (current != '\r') {
-            if (g_sentence_len < (sizeof(g_sentence) - 1)) {
-                g_sentence[g_sentence_len++] = current;
-            } else {
-                g_sentence_overflow = true;
-            }
+    /*
+     * Drain what was buffered at now_us. A line ending with n bytes behind it arrived at least n byte
+     * times earlier, so that is the latest it can have been received.
+     */
+    AKITA_METRIC_BEGIN(span);
+    if (uart_get_buffered_data_len(g_uart_port, &buffered) != ESP_OK) {
+        buffered = 0;
+    }
+    now_us = (uint64_t) esp_timer_get_time();
+    while (buffered > 0U) {
+        bytes_read = uart_read_bytes(
+            g_uart_port,
+            rx_buffer,
+            buffered < sizeof(rx_buffer) ? buffered : sizeof(rx_buffer),
+            0
+        );
+        if (bytes_read <= 0) {
+            break;
         }
+
+        buffered = (size_t) bytes_read < buffered ? buffered - (size_t) bytes_read : 0U;
+        last_byte_us = now_us - (uint64_t) buffered * g_byte_us;
+        AKITA_CAPTURE(AKITA_CAPTURE_GPS_UART, 0, last_byte_us, rx_buffer, (size_t) bytes_read);
+        akita_nmea_feed(&g_parser, rx_buffer, (size_t) bytes_read, last_byte_us, g_byte_us);
     }
+    AKITA_METRIC_END(span, AKITA_METRIC_GPS_INGEST, true);
 
-    now_ms = (uint64_t) (esp_timer_get_time() / 1000ULL);
-    if (g_latest_fix.fix && g_last_fix_ms > 0U) {
-        g_latest_fix.age_ms = (uint32_t) (now_ms - g_last_fix_ms);
+    /* The ISR can land between the two halves of a 64 bit read. */
+    do {
+        pps_us = g_pps_us;
+    } while (pps_us != g_pps_us);
+    if (pps_us != g_captured_pps_us) {
+        AKITA_CAPTURE(AKITA_CAPTURE_GPS_PPS, 0, pps_us, NULL, 0);
+        g_captured_pps_us = pps_us;
     }
 
-    *snapshot = g_latest_fix;
+    akita_nmea_snapshot(&g_parser, now_us, pps_us, snapshot);
     xSemaphoreGive(g_gps_lock);
 }
@@ -0,0 +1,262 @@
+#include "akita_nmea.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool akita_nmea_checksum_ok(const char *sentence) {
+    const char *star;
+    unsigned expected;
+    unsigned calculated = 0;
+    const char *cursor;
+
+    if (sentence == NULL || sentence[0] != '$') {
+        return false;
+    }
+
+    star = strrchr(sentence, '*');
+    if (star == NULL || !isxdigit((unsigned char) star[1]) || !isxdigit((unsigned char) star[2])) {
+        return true;
+    }
+
+    expected = (unsigned) strtoul(star + 1, NULL, 16);
+    for (cursor = sentence + 1; cursor < star; ++cursor) {
+        calculated ^= (unsigned char) *cursor;
+    }
+
+    return calculated == expected;
+}
+
+static bool akita_nmea_is_type(const char *sentence, const char *type) {
+    return sentence != NULL &&
+           type != NULL &&
+           sentence[0] == '$' &&
+           strlen(sentence) >= 6U &&
+           strncmp(sentence + 3, type, 3) == 0;
+}
+
+static float akita_nmea_to_decimal(const char *text, char hemisphere) {
+    double raw;
+    int degrees;
+    double minutes;
+    double decimal;
+
+    if (text == NULL || text[0] == '\0') {
+        return 0.0f;
+    }
+
+    raw = atof(text);
+    degrees = (int) (raw / 100.0);
+    minutes = raw - ((double) degrees * 100.0);
+    decimal = (double) degrees + (minutes / 60.0);
+
+    if (hemisphere == 'S' || hemisphere == 'W') {
+        decimal = -decimal;
+    }
+
+    return (float) decimal;
+}
+
+static size_t akita_split_csv(char *text, char *tokens[], size_t max_tokens) {
+    size_t count = 0;
+    char *cursor = text;
+
+    if (text == NULL || tokens == NULL || max_tokens == 0) {
+        return 0;
+    }
+
+    tokens[count++] = cursor;
+    while (*cursor != '\0' && count < max_tokens) {
+        if (*cursor == ',') {
+            *cursor = '\0';
+            tokens[count++] = cursor + 1;
+        }
+        ++cursor;
+    }
+
+    return count;
+}
+
+/* Days from 1970-01-01 to a proleptic Gregorian date. */
+static int64_t akita_days_from_civil(int year, unsigned month, unsigned day) {
+    int era;
+    unsigned year_of_era;
+    unsigned day_of_year;
+    unsigned day_of_era;
+
+    year -= month <= 2U ? 1 : 0;
+    era = (year >= 0 ? year : year - 399) / 400;
+    year_of_era = (unsigned) (year - era * 400);
+    day_of_year = (153U * (month > 2U ? month - 3U : month + 9U) + 2U) / 5U + day - 1U;
+    day_of_era = year_of_era * 365U + year_of_era / 4U - year_of_era / 100U + day_of_year;
+    return (int64_t) era * 146097 + (int64_t) day_of_era - 719468;
+}
+
+static bool akita_nmea_digits(const char *text, size_t count) {
+    size_t index;
+
+    for (index = 0; index < count; ++index) {
+        if (!isdigit((unsigned char) text[index])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* hhmmss.sss and a date as Unix milliseconds; 0 if either does not parse. */
+static int64_t akita_nmea_to_utc_ms(const char *time, int year, unsigned month, unsigned day) {
+    double seconds;
+    unsigned hours;
+    unsigned minutes;
+
+    if (time == NULL || strlen(time) < 6U || year < 2000 || month < 1U || month > 12U || day < 1U || day > 31U) {
+        return 0;
+    }
+    if (!akita_nmea_digits(time, 6U)) {
+        return 0;
+    }
+
+    hours = (unsigned) ((time[0] - '0') * 10 + (time[1] - '0'));
+    minutes = (unsigned) ((time[2] - '0') * 10 + (time[3] - '0'));
+    seconds = atof(time + 4);
+    if (hours > 23U || minutes > 59U || seconds < 0.0 || seconds >= 61.0) {
+        return 0;
+    }
+
+    return ((akita_days_from_civil(year, month, day) * 86400 + hours * 3600 + minutes * 60) * 1000) +
+           (int64_t) (seconds * 1000.0 + 0.5);
+}
+
+static void akita_nmea_set_utc(akita_nmea_parser_t *parser, int64_t utc_ms) {
+    if (utc_ms > 0) {
+        parser->fix.utc_ms = utc_ms;
+        parser->fix.utc_received_us = parser->sentence_us;
+    }
+}
+
+static void akita_nmea_parse_gga(akita_nmea_parser_t *parser, char *sentence) {
+    char *tokens[16] = { 0 };
+    size_t count = akita_split_csv(sentence, tokens, 16);
+
+    if (count < 10 || tokens[2][0] == '\0' || tokens[4][0] == '\0') {
+        return;
+    }
+
+    if (tokens[6][0] == '0' || tokens[6][0] == '\0') {
+        parser->fix.fix = false;
+        return;
+    }
+
+    parser->fix.fix = true;
+    parser->fix.latitude = akita_nmea_to_decimal(tokens[2], tokens[3][0]);
+    parser->fix.longitude = akita_nmea_to_decimal(tokens[4], tokens[5][0]);
+    parser->fix.satellites = (uint8_t) atoi(tokens[7]);
+    parser->fix.altitude_m = (float) atof(tokens[9]);
+    parser->last_fix_ms = parser->sentence_us / 1000ULL;
+}
+
+static void akita_nmea_parse_rmc(akita_nmea_parser_t *parser, char *sentence) {
+    char *tokens[16] = { 0 };
+    size_t count = akita_split_csv(sentence, tokens, 16);
+
+    if (count < 8 || tokens[3][0] == '\0' || tokens[5][0] == '\0') {
+        return;
+    }
+
+    if (tokens[2][0] != 'A') {
+        parser->fix.fix = false;
+        return;
+    }
+
+    parser->fix.fix = true;
+    parser->fix.latitude = akita_nmea_to_decimal(tokens[3], tokens[4][0]);
+    parser->fix.longitude = akita_nmea_to_decimal(tokens[5], tokens[6][0]);
+    parser->fix.speed_kmh = (float) atof(tokens[7]) * 1.852f;
+    /* Receivers leave the course empty while stationary; keep the last one instead of snapping to north. */
+    if (count > 8 && tokens[8][0] != '\0') {
+        parser->fix.course_deg = (float) atof(tokens[8]);
+    }
+    parser->last_fix_ms = parser->sentence_us / 1000ULL;
+
+    if (count > 9 && strlen(tokens[9]) == 6U && akita_nmea_digits(tokens[9], 6U)) {
+        const char *date = tokens[9];
+
+        akita_nmea_set_utc(parser, akita_nmea_to_utc_ms(
+            tokens[1],
+            2000 + (date[4] - '0') * 10 + (date[5] - '0'),
+            (unsigned) ((date[2] - '0') * 10 + (date[3] - '0')),
+            (unsigned) ((date[0] - '0') * 10 + (date[1] - '0'))
+        ));
+    }
+}
+
+static void akita_nmea_parse_zda(akita_nmea_parser_t *parser, char *sentence) {
+    char *tokens[8] = { 0 };
+    size_t count = akita_split_csv(sentence, tokens, 8);
+
+    /* ZDA has no validity flag; before a fix the time may come from the receiver's RTC. */
+    if (count < 5 || !parser->fix.fix) {
+        return;
+    }
+
+    akita_nmea_set_utc(parser, akita_nmea_to_utc_ms(
+        tokens[1],
+        atoi(tokens[4]),
+        (unsigned) atoi(tokens[3]),
+        (unsigned) atoi(tokens[2])
+    ));
+}
+
+static void akita_nmea_process_sentence(akita_nmea_parser_t *parser, char *sentence) {
+    if (!akita_nmea_checksum_ok(sentence)) {
+        return;
+    }
+
+    if (akita_nmea_is_type(sentence, "GGA")) {
+        akita_nmea_parse_gga(parser, sentence);
+    } else if (akita_nmea_is_type(sentence, "RMC")) {
+        akita_nmea_parse_rmc(parser, sentence);
+    } else if (akita_nmea_is_type(sentence, "ZDA")) {
+        akita_nmea_parse_zda(parser, sentence);
+    }
+}
+
+void akita_nmea_reset(akita_nmea_parser_t *parser) {
+    memset(parser, 0, sizeof(*parser));
+}
+
+void akita_nmea_feed(akita_nmea_parser_t *parser, const uint8_t *data, size_t length, uint64_t last_byte_us, uint32_t byte_us) {
+    size_t index;
+
+    for (index = 0; index < length; ++index) {
+        char current = (char) data[index];
+
+        if (current == '\n') {
+            parser->sentence[parser->sentence_len] = '\0';
+            parser->sentence_us = last_byte_us - (uint64_t) (length - 1U - index) * byte_us;
+            if (!parser->sentence_overflow && parser->sentence_len > 6U) {
+                akita_nmea_process_sentence(parser, parser->sentence);
+            }
+            parser->sentence_len = 0;
+            parser->sentence_overflow = false;
+        } else if (current != '\r') {
+            if (parser->sentence_len < (sizeof(parser->sentence) - 1U)) {
+                parser->sentence[parser->sentence_len++] = current;
+            } else {
+                parser->sentence_overflow = true;
+            }
+        }
+    }
+}
+
+void akita_nmea_snapshot(akita_nmea_parser_t *parser, uint64_t now_us, uint64_t pps_us, akita_gps_snapshot_t *snapshot) {
+    uint64_t now_ms = now_us / 1000ULL;
+
+    if (parser->fix.fix && parser->last_fix_ms > 0U) {
+        parser->fix.age_ms = (uint32_t) (now_ms - parser->last_fix_ms);
+    }
+    parser->fix.fix_ms = parser->last_fix_ms;
+    parser->fix.pps_us = pps_us;
+    *snapshot = parser->fix;
+}
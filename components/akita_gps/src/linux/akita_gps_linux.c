@@ -0,0 +1,167 @@
+#include "akita_gps.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "akita_capture.h"
+#include "akita_metrics.h"
+#include "akita_nmea.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+/* What a UART receive buffer holds before it overruns; a replay that falls further behind skips ahead. */
+#define AKITA_GPS_LINUX_BACKLOG_BYTES 2048U
+
+static const char *TAG = "akita_gps";
+static int g_gps_fd = -1;
+/* A regular file is replayed at the configured baud rate and starts over at its end. */
+static bool g_gps_replay;
+static uint64_t g_replay_us;
+static uint32_t g_byte_us;
+static akita_nmea_parser_t g_parser;
+/* A capture replays its UART reads and PPS edges at their recorded times instead. */
+static akita_capture_replay_t g_capture;
+static bool g_capture_replay;
+static uint64_t g_pps_us;
+
+static void akita_gps_close(void) {
+    if (g_gps_fd >= 0) {
+        close(g_gps_fd);
+        g_gps_fd = -1;
+    }
+    if (g_capture_replay) {
+        akita_capture_replay_close(&g_capture);
+        g_capture_replay = false;
+    }
+    g_pps_us = 0;
+    akita_nmea_reset(&g_parser);
+}
+
+static esp_err_t akita_gps_open_capture(const akita_runtime_config_t *config) {
+    uint32_t baud;
+    esp_err_t err;
+
+    err = akita_capture_replay_open(&g_capture, CONFIG_AKITA_LINUX_CAPTURE_PATH, AKITA_CAPTURE_GPS_SOURCES,
+                                    CONFIG_AKITA_LINUX_REPLAY_SPEED, (uint64_t) esp_timer_get_time());
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Capture %s: %s", CONFIG_AKITA_LINUX_CAPTURE_PATH, esp_err_to_name(err));
+        return err;
+    }
+
+    /* Bytes were dated at the recorded baud rate; a faster replay shrinks their spacing with everything else. */
+    baud = g_capture.reader.gps_baud != 0U ? g_capture.reader.gps_baud : config->gps_uart_baud;
+    g_byte_us = (uint32_t) (10000000ULL * 100U / ((uint64_t) baud * CONFIG_AKITA_LINUX_REPLAY_SPEED));
+    g_capture_replay = true;
+    ESP_LOGI(TAG, "GPS replaying capture %s at %d%%", CONFIG_AKITA_LINUX_CAPTURE_PATH, CONFIG_AKITA_LINUX_REPLAY_SPEED);
+    return ESP_OK;
+}
+
+esp_err_t akita_gps_init(const akita_runtime_config_t *config) {
+    struct stat info;
+
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    akita_gps_close();
+    if (config->enable_gps && CONFIG_AKITA_LINUX_CAPTURE_PATH[0] != '\0') {
+        return akita_gps_open_capture(config);
+    }
+    if (!config->enable_gps || CONFIG_AKITA_LINUX_GPS_PATH[0] == '\0') {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    g_gps_fd = open(CONFIG_AKITA_LINUX_GPS_PATH, O_RDONLY | O_NONBLOCK | O_NOCTTY);
+    if (g_gps_fd < 0) {
+        ESP_LOGW(TAG, "GPS source %s: %s", CONFIG_AKITA_LINUX_GPS_PATH, strerror(errno));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    g_gps_replay = fstat(g_gps_fd, &info) == 0 && S_ISREG(info.st_mode);
+    g_byte_us = 10000000U / config->gps_uart_baud;
+    g_replay_us = (uint64_t) esp_timer_get_time();
+    ESP_LOGI(TAG, "GPS %s %s at %lu baud", g_gps_replay ? "replaying" : "reading", CONFIG_AKITA_LINUX_GPS_PATH,
+             (unsigned long) config->gps_uart_baud);
+    return ESP_OK;
+}
+
+/* Reads the bytes a UART at the configured baud rate would have received since the last poll. */
+static void akita_gps_replay(uint64_t now_us) {
+    uint8_t rx_buffer[64];
+    uint64_t due;
+    ssize_t bytes_read;
+
+    due = (now_us - g_replay_us) / g_byte_us;
+    if (due > AKITA_GPS_LINUX_BACKLOG_BYTES) {
+        g_replay_us = now_us - (uint64_t) AKITA_GPS_LINUX_BACKLOG_BYTES * g_byte_us;
+        due = AKITA_GPS_LINUX_BACKLOG_BYTES;
+    }
+
+    while (due > 0U) {
+        bytes_read = read(g_gps_fd, rx_buffer, due < sizeof(rx_buffer) ? (size_t) due : sizeof(rx_buffer));
+        if (bytes_read == 0) {
+            if (lseek(g_gps_fd, 0, SEEK_SET) != 0) {
+                break;
+            }
+            continue;
+        }
+        if (bytes_read < 0) {
+            break;
+        }
+
+        due -= (uint64_t) bytes_read;
+        g_replay_us += (uint64_t) bytes_read * g_byte_us;
+        AKITA_CAPTURE(AKITA_CAPTURE_GPS_UART, 0, g_replay_us, rx_buffer, (size_t) bytes_read);
+        akita_nmea_feed(&g_parser, rx_buffer, (size_t) bytes_read, g_replay_us, g_byte_us);
+    }
+}
+
+static void akita_gps_replay_capture(uint64_t now_us) {
+    akita_capture_record_t record;
+
+    while (akita_capture_replay_next(&g_capture, now_us, &record)) {
+        if (record.source == AKITA_CAPTURE_GPS_PPS) {
+            g_pps_us = record.at_us;
+        } else {
+            akita_nmea_feed(&g_parser, record.data, record.length, record.at_us, g_byte_us);
+        }
+        if (akita_capture_replay_done(&g_capture)) {
+            ESP_LOGI(TAG, "GPS capture replay finished");
+        }
+    }
+}
+
+void akita_gps_poll(akita_gps_snapshot_t *snapshot) {
+    uint8_t rx_buffer[64];
+    ssize_t bytes_read;
+    uint64_t now_us;
+
+    if (snapshot == NULL) {
+        return;
+    }
+    if (g_gps_fd < 0 && !g_capture_replay) {
+        memset(snapshot, 0, sizeof(*snapshot));
+        return;
+    }
+
+    AKITA_METRIC_BEGIN(span);
+    now_us = (uint64_t) esp_timer_get_time();
+    if (g_capture_replay) {
+        akita_gps_replay_capture(now_us);
+    } else if (g_gps_replay) {
+        akita_gps_replay(now_us);
+    } else {
+        /* A pty or FIFO has no receive-time hint, so whatever is waiting is dated now. */
+        while ((bytes_read = read(g_gps_fd, rx_buffer, sizeof(rx_buffer))) > 0) {
+            AKITA_CAPTURE(AKITA_CAPTURE_GPS_UART, 0, now_us, rx_buffer, (size_t) bytes_read);
+            akita_nmea_feed(&g_parser, rx_buffer, (size_t) bytes_read, now_us, 0U);
+        }
+    }
+    AKITA_METRIC_END(span, AKITA_METRIC_GPS_INGEST, true);
+
+    akita_nmea_snapshot(&g_parser, now_us, g_pps_us, snapshot);
+}
@@ -0,0 +1,14 @@
+#ifndef AKITA_ELM327_SIM_H
+#define AKITA_ELM327_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A stand-in ELM327 for builds without a vehicle: answers the setup commands and the telemetry PIDs the
+ * session sends, with a repeating drive of idle, pull-away, cruise and stop over 90 seconds and a coolant
+ * temperature that warms up over the first five minutes. elapsed_ms is time since the adapter powered on.
+ */
+size_t akita_elm327_sim_answer(const char *request, uint64_t elapsed_ms, char *buffer, size_t buffer_size);
+
+#endif
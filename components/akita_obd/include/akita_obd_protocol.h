@@ -0,0 +1,59 @@
+#ifndef AKITA_OBD_PROTOCOL_H
+#define AKITA_OBD_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+#define AKITA_OBD_RX_BUFFER_SIZE 256U
+#define AKITA_OBD_RESPONSE_TIMEOUT_MS 4000U
+#define AKITA_OBD_INIT_DELAY_MS 250U
+#define AKITA_OBD_PID_DELAY_MS 125U
+#define AKITA_OBD_MAX_COMMAND_RETRIES 3U
+
+/*
+ * The ELM327 conversation without the link under it: the adapter setup commands once, then the telemetry
+ * PIDs in turn, one outstanding at a time. The link sends what akita_obd_session_command names when it is
+ * due and hands every piece of reply to akita_obd_session_receive.
+ */
+typedef struct {
+    size_t init_index;
+    size_t pid_index;
+    bool pending;
+    uint8_t retries;
+    /* Uptime when the next command may go out; 0 until the session starts. */
+    uint64_t next_command_ms;
+    uint64_t command_started_ms;
+    uint64_t last_sample_ms;
+    size_t rx_length;
+    char rx[AKITA_OBD_RX_BUFFER_SIZE];
+} akita_obd_session_t;
+
+void akita_obd_session_reset(akita_obd_session_t *session);
+/* Begins the setup commands, the first one due at now_ms. */
+void akita_obd_session_start(akita_obd_session_t *session, uint64_t now_ms);
+const char *akita_obd_session_command(const akita_obd_session_t *session);
+bool akita_obd_session_due(const akita_obd_session_t *session, uint64_t now_ms);
+void akita_obd_session_sent(akita_obd_session_t *session, uint64_t now_ms);
+/* Drops the outstanding command and sends it again after delay_ms. */
+void akita_obd_session_retry(akita_obd_session_t *session, uint64_t now_ms, uint32_t delay_ms);
+/* Moves on to the next command, if one is outstanding. */
+void akita_obd_session_complete(akita_obd_session_t *session, uint64_t now_ms);
+/* Retries a telemetry PID or gives up on a setup command that went unanswered; returns true if it did. */
+bool akita_obd_session_check_timeout(akita_obd_session_t *session, uint64_t now_ms);
+/* Adds reply text and applies any PID in it to snapshot; returns true if a reading was updated. */
+bool akita_obd_session_receive(
+    akita_obd_session_t *session,
+    akita_obd_snapshot_t *snapshot,
+    const char *text,
+    size_t length,
+    bool force_complete,
+    uint64_t now_ms
+);
+
+size_t akita_obd_build_request(const char *pid, char *buffer, size_t buffer_size);
+bool akita_obd_parse_response(akita_obd_snapshot_t *snapshot, const char *response, uint64_t now_ms);
+
+#endif
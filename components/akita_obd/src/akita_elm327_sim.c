@@ -0,0 +1,81 @@
+#include "akita_elm327_sim.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#define AKITA_ELM327_DRIVE_PERIOD_MS 90000U
+#define AKITA_ELM327_WARMUP_MS 300000U
+
+static uint32_t akita_elm327_speed_kmh(uint64_t elapsed_ms) {
+    uint32_t phase_ms = (uint32_t) (elapsed_ms % AKITA_ELM327_DRIVE_PERIOD_MS);
+
+    if (phase_ms < 10000U) {
+        return 0;
+    }
+    if (phase_ms < 30000U) {
+        return (phase_ms - 10000U) / 200U;
+    }
+    if (phase_ms < 70000U) {
+        return 100U;
+    }
+    if (phase_ms < 85000U) {
+        return 100U - ((phase_ms - 70000U) * 100U / 15000U);
+    }
+    return 0;
+}
+
+static int akita_elm327_format(const char *request, uint64_t elapsed_ms, char *buffer, size_t buffer_size) {
+    uint32_t speed_kmh = akita_elm327_speed_kmh(elapsed_ms);
+    uint32_t rpm_quarters;
+    uint32_t coolant_c;
+
+    if (strcasecmp(request, "ATZ") == 0) {
+        return snprintf(buffer, buffer_size, "\r\rELM327 v1.5\r\r>");
+    }
+    if (strncasecmp(request, "AT", 2) == 0) {
+        return snprintf(buffer, buffer_size, "OK\r\r>");
+    }
+    if (strcasecmp(request, "010C") == 0) {
+        /* Idle at 800 rpm, 25 rpm per km/h in gear; the PID carries quarter-rpm. */
+        rpm_quarters = (800U + (speed_kmh * 25U)) * 4U;
+        return snprintf(buffer, buffer_size, "41 0C %02X %02X\r\r>",
+                        (unsigned int) ((rpm_quarters >> 8) & 0xFFU), (unsigned int) (rpm_quarters & 0xFFU));
+    }
+    if (strcasecmp(request, "010D") == 0) {
+        return snprintf(buffer, buffer_size, "41 0D %02X\r\r>", (unsigned int) speed_kmh);
+    }
+    if (strcasecmp(request, "0105") == 0) {
+        coolant_c = elapsed_ms >= AKITA_ELM327_WARMUP_MS
+            ? 90U
+            : 20U + (uint32_t) ((elapsed_ms * 70U) / AKITA_ELM327_WARMUP_MS);
+        return snprintf(buffer, buffer_size, "41 05 %02X\r\r>", (unsigned int) (coolant_c + 40U));
+    }
+    if (strncmp(request, "01", 2) == 0) {
+        return snprintf(buffer, buffer_size, "NO DATA\r\r>");
+    }
+    return snprintf(buffer, buffer_size, "?\r\r>");
+}
+
+size_t akita_elm327_sim_answer(const char *request, uint64_t elapsed_ms, char *buffer, size_t buffer_size) {
+    char command[16];
+    size_t length = 0;
+    int written;
+
+    if (request == NULL || buffer == NULL || buffer_size == 0U) {
+        return 0;
+    }
+
+    while (request[length] != '\0' && request[length] != '\r' && length < (sizeof(command) - 1U)) {
+        command[length] = request[length];
+        ++length;
+    }
+    command[length] = '\0';
+
+    written = akita_elm327_format(command, elapsed_ms, buffer, buffer_size);
+    if (written < 0 || (size_t) written >= buffer_size) {
+        return 0;
+    }
+
+    return (size_t) written;
+}
@@ -7,6 +7,9 @@
 #include <string.h>
 #include <strings.h>
 
+#include "akita_capture.h"
+#include "akita_metrics.h"
+#include "akita_obd_protocol.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -21,16 +24,10 @@
 #include "nimble/nimble_port.h"
 #include "nimble/nimble_port_freertos.h"
 
-#define AKITA_ARRAY_LEN(array) (sizeof(array) / sizeof((array)[0]))
 #define AKITA_UUID_STRING_LENGTH 37U
-#define AKITA_OBD_RX_BUFFER_SIZE 256U
 #define AKITA_OBD_CONN_HANDLE_NONE UINT16_MAX
 #define AKITA_OBD_CONNECT_TIMEOUT_MS 30000
-#define AKITA_OBD_RESPONSE_TIMEOUT_MS 4000U
-#define AKITA_OBD_INIT_DELAY_MS 250U
-#define AKITA_OBD_PID_DELAY_MS 125U
 #define AKITA_OBD_READ_DELAY_MS 80U
-#define AKITA_OBD_MAX_COMMAND_RETRIES 3U
 
 static const char *TAG = "akita_obd";
 
@@ -40,21 +37,6 @@ static const char *kNusServiceUuid = "6e400001-b5a3-f393-e0a9-e50e24dcca9e";
 static const char *kNusWriteUuid = "6e400002-b5a3-f393-e0a9-e50e24dcca9e";
 static const char *kNusNotifyUuid = "6e400003-b5a3-f393-e0a9-e50e24dcca9e";
 
-static const char *kInitCommands[] = {
-    "ATZ",
-    "ATE0",
-    "ATL0",
-    "ATS0",
-    "ATH0",
-    "ATSP0",
-};
-
-static const char *kTelemetryCommands[] = {
-    "010C",
-    "010D",
-    "0105",
-};
-
 typedef enum {
     AKITA_OBD_PROFILE_UNKNOWN = 0,
     AKITA_OBD_PROFILE_ELM327_SERIAL,
@@ -69,7 +51,6 @@ static bool g_scan_active;
 static bool g_connecting;
 static bool g_connect_after_scan;
 static bool g_obd_ready;
-static bool g_pending_response;
 static bool g_read_in_flight;
 static bool g_use_read_fallback;
 static bool g_notifications_enabled;
@@ -84,17 +65,10 @@ static uint16_t g_cccd_handle;
 static uint8_t g_write_properties;
 static uint8_t g_notify_properties;
 static akita_obd_profile_t g_profile;
-static size_t g_init_command_index;
-static size_t g_pid_command_index;
-static uint64_t g_last_sample_ms;
-static uint64_t g_next_command_at_ms;
-static uint64_t g_command_started_ms;
 static uint64_t g_read_due_ms;
 static char g_target_service_uuid[AKITA_UUID_STRING_LENGTH];
 static char g_target_characteristic_uuid[AKITA_UUID_STRING_LENGTH];
-static char g_rx_buffer[AKITA_OBD_RX_BUFFER_SIZE];
-static size_t g_rx_length;
-static uint8_t g_command_retries;
+static akita_obd_session_t g_session;
 static SemaphoreHandle_t g_obd_lock;
 
 static void akita_obd_host_task(void *param);
@@ -132,43 +106,6 @@ static void akita_obd_unlock(void) {
     }
 }
 
-static bool akita_text_contains_ci(const char *haystack, const char *needle) {
-    size_t haystack_len;
-    size_t needle_len;
-    size_t index;
-
-    if (haystack == NULL || needle == NULL || needle[0] == '\0') {
-        return false;
-    }
-
-    haystack_len = strlen(haystack);
-    needle_len = strlen(needle);
-    if (needle_len > haystack_len) {
-        return false;
-    }
-
-    for (index = 0; index <= (haystack_len - needle_len); ++index) {
-        size_t offset;
-        bool matched = true;
-        for (offset = 0; offset < needle_len; ++offset) {
-            if (tolower((unsigned char) haystack[index + offset]) != tolower((unsigned char) needle[offset])) {
-                matched = false;
-                break;
-            }
-        }
-        if (matched) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-static void akita_clear_response_buffer(void) {
-    g_rx_length = 0;
-    g_rx_buffer[0] = '\0';
-}
-
 static void akita_obd_stop_link_activity(void) {
     int rc;
 
@@ -192,7 +129,6 @@ static void akita_reset_link_state(void) {
     g_connecting = false;
     g_connect_after_scan = false;
     g_obd_ready = false;
-    g_pending_response = false;
     g_read_in_flight = false;
     g_use_read_fallback = false;
     g_notifications_enabled = false;
@@ -205,14 +141,9 @@ static void akita_reset_link_state(void) {
     g_write_properties = 0;
     g_notify_properties = 0;
     g_profile = AKITA_OBD_PROFILE_UNKNOWN;
-    g_init_command_index = 0;
-    g_pid_command_index = 0;
-    g_next_command_at_ms = 0;
-    g_command_started_ms = 0;
     g_read_due_ms = 0;
-    g_command_retries = 0;
     g_obd_state.connected = false;
-    akita_clear_response_buffer();
+    akita_obd_session_reset(&g_session);
 }
 
 static void akita_uuid_to_string(const ble_uuid_t *uuid, char *buffer, size_t buffer_size) {
@@ -441,78 +372,29 @@ static bool akita_should_connect(const struct ble_gap_disc_desc *disc) {
     return false;
 }
 
-static const char *akita_current_command(void) {
-    if (g_init_command_index < AKITA_ARRAY_LEN(kInitCommands)) {
-        return kInitCommands[g_init_command_index];
-    }
-
-    return kTelemetryCommands[g_pid_command_index % AKITA_ARRAY_LEN(kTelemetryCommands)];
-}
-
 static void akita_schedule_retry(uint32_t delay_ms) {
-    g_pending_response = false;
     g_read_in_flight = false;
     g_read_due_ms = 0;
-    g_command_started_ms = 0;
-    akita_clear_response_buffer();
-    g_next_command_at_ms = akita_now_ms() + delay_ms;
+    akita_obd_session_retry(&g_session, akita_now_ms(), delay_ms);
 }
 
 static void akita_complete_pending_command(void) {
-    bool init_phase;
-
-    if (!g_pending_response) {
-        return;
-    }
-
-    init_phase = g_init_command_index < AKITA_ARRAY_LEN(kInitCommands);
-    if (init_phase) {
-        ++g_init_command_index;
-    } else {
-        g_pid_command_index = (g_pid_command_index + 1U) % AKITA_ARRAY_LEN(kTelemetryCommands);
-    }
-
-    g_pending_response = false;
     g_read_in_flight = false;
     g_read_due_ms = 0;
-    g_command_started_ms = 0;
-    g_command_retries = 0;
-    akita_clear_response_buffer();
-    g_next_command_at_ms = akita_now_ms() + (init_phase ? AKITA_OBD_INIT_DELAY_MS : AKITA_OBD_PID_DELAY_MS);
+    akita_obd_session_complete(&g_session, akita_now_ms());
 }
 
 static void akita_process_response_text(const char *text, size_t length, bool force_complete) {
-    size_t available;
-    size_t copy_length = 0;
-    bool parsed = false;
-    bool has_prompt = false;
-
-    if (text != NULL && length > 0U) {
-        available = (sizeof(g_rx_buffer) - 1U) - g_rx_length;
-        copy_length = length < available ? length : available;
-        if (copy_length > 0U) {
-            memcpy(g_rx_buffer + g_rx_length, text, copy_length);
-            g_rx_length += copy_length;
-            g_rx_buffer[g_rx_length] = '\0';
-        }
-        has_prompt = memchr(text, '>', length) != NULL;
-    }
+    uint64_t now_ms = akita_now_ms();
 
-    if (g_rx_length > 0U) {
-        parsed = akita_obd_apply_response(&g_obd_state, g_rx_buffer);
-        if (strchr(g_rx_buffer, '>') != NULL) {
-            has_prompt = true;
-        }
-        if (akita_text_contains_ci(g_rx_buffer, "NO DATA") ||
-            akita_text_contains_ci(g_rx_buffer, "UNABLE") ||
-            akita_text_contains_ci(g_rx_buffer, "STOPPED") ||
-            strchr(g_rx_buffer, '?') != NULL) {
-            force_complete = true;
-        }
-    }
+    AKITA_CAPTURE(AKITA_CAPTURE_OBD_RX, force_complete ? AKITA_CAPTURE_FLAG_FORCE : 0U, now_ms * 1000U, text, length);
+    akita_obd_lock();
+    (void) akita_obd_session_receive(&g_session, &g_obd_state, text, length, force_complete, now_ms);
+    akita_obd_unlock();
 
-    if ((parsed || has_prompt || force_complete) && g_pending_response) {
-        akita_complete_pending_command();
+    if (!g_session.pending) {
+        g_read_in_flight = false;
+        g_read_due_ms = 0;
     }
 }
 
@@ -537,14 +419,9 @@ static void akita_complete_link_setup(void) {
         return;
     }
 
-    g_init_command_index = 0;
-    g_pid_command_index = 0;
-    g_pending_response = false;
     g_read_in_flight = false;
     g_read_due_ms = 0;
-    g_command_started_ms = 0;
-    akita_clear_response_buffer();
-    g_next_command_at_ms = akita_now_ms();
+    akita_obd_session_start(&g_session, akita_now_ms());
 
     ESP_LOGI(TAG, "OBD adapter ready over BLE (%s)",
              g_profile == AKITA_OBD_PROFILE_NUS ? "NUS" : "serial characteristic");
@@ -893,17 +770,13 @@ static int akita_obd_on_read_complete(uint16_t conn_handle, const struct ble_gat
 
     g_read_in_flight = false;
     if (error->status != 0U || attr == NULL || attr->om == NULL) {
-        if (g_pending_response) {
-            akita_complete_pending_command();
-        }
+        akita_complete_pending_command();
         return 0;
     }
 
     rc = ble_hs_mbuf_to_flat(attr->om, payload, sizeof(payload) - 1U, &copied_length);
     if (rc != 0) {
-        if (g_pending_response) {
-            akita_complete_pending_command();
-        }
+        akita_complete_pending_command();
         return 0;
     }
 
@@ -997,11 +870,6 @@ static void akita_obd_host_task(void *param) {
     nimble_port_freertos_deinit();
 }
 
-static uint8_t akita_hex_u8(const char *text) {
-    char scratch[3] = { text[0], text[1], '\0' };
-    return (uint8_t) strtoul(scratch, NULL, 16);
-}
-
 esp_err_t akita_obd_init(const akita_runtime_config_t *config) {
     bool host_synced;
 
@@ -1056,19 +924,14 @@ void akita_obd_poll(akita_obd_snapshot_t *snapshot) {
         (void) akita_start_scan();
     }
 
-    if (g_pending_response && g_command_started_ms > 0U &&
-        (now_ms - g_command_started_ms) >= AKITA_OBD_RESPONSE_TIMEOUT_MS) {
-        bool init_phase = g_init_command_index < AKITA_ARRAY_LEN(kInitCommands);
-        ESP_LOGW(TAG, "Timed out waiting for OBD response to %s", akita_current_command());
-        if (!init_phase && g_command_retries < AKITA_OBD_MAX_COMMAND_RETRIES) {
-            ++g_command_retries;
-            akita_schedule_retry(250U);
-        } else {
-            akita_complete_pending_command();
-        }
+    command = akita_obd_session_command(&g_session);
+    if (akita_obd_session_check_timeout(&g_session, now_ms)) {
+        ESP_LOGW(TAG, "Timed out waiting for OBD response to %s", command);
+        g_read_in_flight = false;
+        g_read_due_ms = 0;
     }
 
-    if (g_pending_response && g_use_read_fallback && !g_read_in_flight && g_read_due_ms > 0U && now_ms >= g_read_due_ms) {
+    if (g_session.pending && g_use_read_fallback && !g_read_in_flight && g_read_due_ms > 0U && now_ms >= g_read_due_ms) {
         rc = ble_gattc_read(g_conn_handle, g_notify_handle, akita_obd_on_read_complete, NULL);
         if (rc == 0) {
             g_read_in_flight = true;
@@ -1079,100 +942,42 @@ void akita_obd_poll(akita_obd_snapshot_t *snapshot) {
         }
     }
 
-    if (g_obd_ready && !g_pending_response && g_next_command_at_ms > 0U && now_ms >= g_next_command_at_ms) {
-        command = akita_current_command();
+    if (g_obd_ready && akita_obd_session_due(&g_session, now_ms)) {
+        AKITA_METRIC_BEGIN(span);
+        command = akita_obd_session_command(&g_session);
         request_length = akita_obd_build_request(command, request, sizeof(request));
         if (request_length == 0U) {
             akita_schedule_retry(500U);
         } else if ((g_write_properties & BLE_GATT_CHR_PROP_WRITE_NO_RSP) != 0U) {
             rc = ble_gattc_write_no_rsp_flat(g_conn_handle, g_write_handle, request, request_length);
+            AKITA_METRIC_END(span, AKITA_METRIC_OBD_REQUEST, rc == 0);
             if (rc != 0) {
                 ESP_LOGW(TAG, "OBD write without response failed: %d", rc);
                 akita_schedule_retry(500U);
             } else {
-                g_pending_response = true;
-                g_command_started_ms = now_ms;
+                AKITA_CAPTURE(AKITA_CAPTURE_OBD_TX, 0, now_ms * 1000U, request, request_length);
+                akita_obd_session_sent(&g_session, now_ms);
                 g_read_due_ms = g_use_read_fallback ? (now_ms + AKITA_OBD_READ_DELAY_MS) : 0U;
-                akita_clear_response_buffer();
             }
         } else {
             rc = ble_gattc_write_flat(g_conn_handle, g_write_handle, request, request_length,
                                       akita_obd_on_write_complete, (void *) "command");
+            AKITA_METRIC_END(span, AKITA_METRIC_OBD_REQUEST, rc == 0);
             if (rc != 0) {
                 ESP_LOGW(TAG, "OBD write failed: %d", rc);
                 akita_schedule_retry(500U);
             } else {
-                g_pending_response = true;
-                g_command_started_ms = now_ms;
-                akita_clear_response_buffer();
+                AKITA_CAPTURE(AKITA_CAPTURE_OBD_TX, 0, now_ms * 1000U, request, request_length);
+                akita_obd_session_sent(&g_session, now_ms);
             }
         }
     }
 
-    if (g_last_sample_ms > 0U) {
-        g_obd_state.age_ms = (uint32_t) (now_ms - g_last_sample_ms);
-    }
-
     akita_obd_lock();
+    if (g_session.last_sample_ms > 0U) {
+        g_obd_state.age_ms = (uint32_t) (now_ms - g_session.last_sample_ms);
+    }
     g_obd_state.connected = g_conn_handle != AKITA_OBD_CONN_HANDLE_NONE;
     *snapshot = g_obd_state;
     akita_obd_unlock();
 }
-
-size_t akita_obd_build_request(const char *pid, char *buffer, size_t buffer_size) {
-    int written;
-
-    if (buffer == NULL || buffer_size == 0 || pid == NULL) {
-        return 0;
-    }
-
-    written = snprintf(buffer, buffer_size, "%s\r", pid);
-    if (written < 0 || (size_t) written >= buffer_size) {
-        return 0;
-    }
-
-    return (size_t) written;
-}
-
-bool akita_obd_apply_response(akita_obd_snapshot_t *snapshot, const char *response) {
-    char cleaned[AKITA_OBD_RX_BUFFER_SIZE];
-    const char *frame;
-    size_t in_index = 0;
-    size_t out_index = 0;
-
-    if (snapshot == NULL || response == NULL) {
-        return false;
-    }
-
-    while (response[in_index] != '\0' && out_index < (sizeof(cleaned) - 1U)) {
-        if (response[in_index] != ' ' && response[in_index] != '>' && response[in_index] != '\r' && response[in_index] != '\n') {
-            cleaned[out_index++] = (char) toupper((unsigned char) response[in_index]);
-        }
-        ++in_index;
-    }
-    cleaned[out_index] = '\0';
-
-    frame = strstr(cleaned, "410C");
-    if (frame != NULL && strlen(frame) >= 8U) {
-        snapshot->rpm = (float) (((akita_hex_u8(frame + 4) * 256U) + akita_hex_u8(frame + 6)) / 4.0f);
-    } else {
-        frame = strstr(cleaned, "410D");
-        if (frame != NULL && strlen(frame) >= 6U) {
-            snapshot->speed_kmh = (float) akita_hex_u8(frame + 4);
-        } else {
-            frame = strstr(cleaned, "4105");
-            if (frame != NULL && strlen(frame) >= 6U) {
-                snapshot->coolant_c = (float) akita_hex_u8(frame + 4) - 40.0f;
-            } else {
-                return false;
-            }
-        }
-    }
-
-    snapshot->connected = g_conn_handle != AKITA_OBD_CONN_HANDLE_NONE;
-    akita_obd_lock();
-    g_obd_state = *snapshot;
-    g_last_sample_ms = akita_now_ms();
-    akita_obd_unlock();
-    return true;
-}
\ No newline at end of file
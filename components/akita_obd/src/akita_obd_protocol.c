@@ -0,0 +1,248 @@
+#include "akita_obd_protocol.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akita_metrics.h"
+
+#define AKITA_ARRAY_LEN(array) (sizeof(array) / sizeof((array)[0]))
+
+static const char *kInitCommands[] = {
+    "ATZ",
+    "ATE0",
+    "ATL0",
+    "ATS0",
+    "ATH0",
+    "ATSP0",
+};
+
+static const char *kTelemetryCommands[] = {
+    "010C",
+    "010D",
+    "0105",
+};
+
+static bool akita_text_contains_ci(const char *haystack, const char *needle) {
+    size_t haystack_len;
+    size_t needle_len;
+    size_t index;
+
+    if (haystack == NULL || needle == NULL || needle[0] == '\0') {
+        return false;
+    }
+
+    haystack_len = strlen(haystack);
+    needle_len = strlen(needle);
+    if (needle_len > haystack_len) {
+        return false;
+    }
+
+    for (index = 0; index <= (haystack_len - needle_len); ++index) {
+        size_t offset;
+        bool matched = true;
+        for (offset = 0; offset < needle_len; ++offset) {
+            if (tolower((unsigned char) haystack[index + offset]) != tolower((unsigned char) needle[offset])) {
+                matched = false;
+                break;
+            }
+        }
+        if (matched) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void akita_obd_session_clear_rx(akita_obd_session_t *session) {
+    session->rx_length = 0;
+    session->rx[0] = '\0';
+}
+
+void akita_obd_session_reset(akita_obd_session_t *session) {
+    uint64_t last_sample_ms = session->last_sample_ms;
+
+    memset(session, 0, sizeof(*session));
+    session->last_sample_ms = last_sample_ms;
+}
+
+void akita_obd_session_start(akita_obd_session_t *session, uint64_t now_ms) {
+    akita_obd_session_reset(session);
+    session->next_command_ms = now_ms;
+}
+
+const char *akita_obd_session_command(const akita_obd_session_t *session) {
+    if (session->init_index < AKITA_ARRAY_LEN(kInitCommands)) {
+        return kInitCommands[session->init_index];
+    }
+
+    return kTelemetryCommands[session->pid_index % AKITA_ARRAY_LEN(kTelemetryCommands)];
+}
+
+bool akita_obd_session_due(const akita_obd_session_t *session, uint64_t now_ms) {
+    return !session->pending && session->next_command_ms > 0U && now_ms >= session->next_command_ms;
+}
+
+void akita_obd_session_sent(akita_obd_session_t *session, uint64_t now_ms) {
+    session->pending = true;
+    session->command_started_ms = now_ms;
+    akita_obd_session_clear_rx(session);
+}
+
+void akita_obd_session_retry(akita_obd_session_t *session, uint64_t now_ms, uint32_t delay_ms) {
+    session->pending = false;
+    session->command_started_ms = 0;
+    akita_obd_session_clear_rx(session);
+    session->next_command_ms = now_ms + delay_ms;
+}
+
+void akita_obd_session_complete(akita_obd_session_t *session, uint64_t now_ms) {
+    bool init_phase;
+
+    if (!session->pending) {
+        return;
+    }
+
+    init_phase = session->init_index < AKITA_ARRAY_LEN(kInitCommands);
+    if (init_phase) {
+        ++session->init_index;
+    } else {
+        session->pid_index = (session->pid_index + 1U) % AKITA_ARRAY_LEN(kTelemetryCommands);
+    }
+
+    session->pending = false;
+    session->command_started_ms = 0;
+    session->retries = 0;
+    akita_obd_session_clear_rx(session);
+    session->next_command_ms = now_ms + (init_phase ? AKITA_OBD_INIT_DELAY_MS : AKITA_OBD_PID_DELAY_MS);
+}
+
+bool akita_obd_session_check_timeout(akita_obd_session_t *session, uint64_t now_ms) {
+    if (!session->pending || session->command_started_ms == 0U ||
+        (now_ms - session->command_started_ms) < AKITA_OBD_RESPONSE_TIMEOUT_MS) {
+        return false;
+    }
+
+    if (session->init_index >= AKITA_ARRAY_LEN(kInitCommands) && session->retries < AKITA_OBD_MAX_COMMAND_RETRIES) {
+        ++session->retries;
+        akita_obd_session_retry(session, now_ms, 250U);
+    } else {
+        akita_obd_session_complete(session, now_ms);
+    }
+
+    return true;
+}
+
+bool akita_obd_session_receive(
+    akita_obd_session_t *session,
+    akita_obd_snapshot_t *snapshot,
+    const char *text,
+    size_t length,
+    bool force_complete,
+    uint64_t now_ms
+) {
+    size_t available;
+    size_t copy_length = 0;
+    bool parsed = false;
+    bool has_prompt = false;
+
+    if (text != NULL && length > 0U) {
+        available = (sizeof(session->rx) - 1U) - session->rx_length;
+        copy_length = length < available ? length : available;
+        if (copy_length > 0U) {
+            memcpy(session->rx + session->rx_length, text, copy_length);
+            session->rx_length += copy_length;
+            session->rx[session->rx_length] = '\0';
+        }
+        has_prompt = memchr(text, '>', length) != NULL;
+    }
+
+    AKITA_METRIC_BEGIN(span);
+    if (session->rx_length > 0U) {
+        parsed = akita_obd_parse_response(snapshot, session->rx, now_ms);
+        if (strchr(session->rx, '>') != NULL) {
+            has_prompt = true;
+        }
+        if (akita_text_contains_ci(session->rx, "NO DATA") ||
+            akita_text_contains_ci(session->rx, "UNABLE") ||
+            akita_text_contains_ci(session->rx, "STOPPED") ||
+            strchr(session->rx, '?') != NULL) {
+            force_complete = true;
+        }
+    }
+    /* NO DATA, UNABLE TO CONNECT, STOPPED and ? are the adapter's error answers. */
+    AKITA_METRIC_END(span, AKITA_METRIC_OBD_RESPONSE, !force_complete || parsed);
+
+    if (parsed) {
+        session->last_sample_ms = now_ms;
+    }
+    if (parsed || has_prompt || force_complete) {
+        akita_obd_session_complete(session, now_ms);
+    }
+
+    return parsed;
+}
+
+static uint8_t akita_hex_u8(const char *text) {
+    char scratch[3] = { text[0], text[1], '\0' };
+    return (uint8_t) strtoul(scratch, NULL, 16);
+}
+
+size_t akita_obd_build_request(const char *pid, char *buffer, size_t buffer_size) {
+    int written;
+
+    if (buffer == NULL || buffer_size == 0 || pid == NULL) {
+        return 0;
+    }
+
+    written = snprintf(buffer, buffer_size, "%s\r", pid);
+    if (written < 0 || (size_t) written >= buffer_size) {
+        return 0;
+    }
+
+    return (size_t) written;
+}
+
+bool akita_obd_parse_response(akita_obd_snapshot_t *snapshot, const char *response, uint64_t now_ms) {
+    char cleaned[AKITA_OBD_RX_BUFFER_SIZE];
+    const char *frame;
+    size_t in_index = 0;
+    size_t out_index = 0;
+
+    if (snapshot == NULL || response == NULL) {
+        return false;
+    }
+
+    while (response[in_index] != '\0' && out_index < (sizeof(cleaned) - 1U)) {
+        if (response[in_index] != ' ' && response[in_index] != '>' && response[in_index] != '\r' && response[in_index] != '\n') {
+            cleaned[out_index++] = (char) toupper((unsigned char) response[in_index]);
+        }
+        ++in_index;
+    }
+    cleaned[out_index] = '\0';
+
+    frame = strstr(cleaned, "410C");
+    if (frame != NULL && strlen(frame) >= 8U) {
+        snapshot->rpm = (float) (((akita_hex_u8(frame + 4) * 256U) + akita_hex_u8(frame + 6)) / 4.0f);
+        snapshot->rpm_ms = now_ms;
+        return true;
+    }
+
+    frame = strstr(cleaned, "410D");
+    if (frame != NULL && strlen(frame) >= 6U) {
+        snapshot->speed_kmh = (float) akita_hex_u8(frame + 4);
+        snapshot->speed_ms = now_ms;
+        return true;
+    }
+
+    frame = strstr(cleaned, "4105");
+    if (frame != NULL && strlen(frame) >= 6U) {
+        snapshot->coolant_c = (float) akita_hex_u8(frame + 4) - 40.0f;
+        snapshot->coolant_ms = now_ms;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,122 @@
+#include "akita_obd.h"
+
+#include <string.h>
+
+#include "akita_capture.h"
+#include "akita_elm327_sim.h"
+#include "akita_metrics.h"
+#include "akita_obd_protocol.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "akita_obd";
+static akita_obd_snapshot_t g_obd_state;
+static akita_obd_session_t g_session;
+static uint64_t g_started_ms;
+/* The simulated adapter's answer to the outstanding command, delivered once the configured latency passes. */
+static char g_answer[64];
+static size_t g_answer_length;
+static uint64_t g_answer_due_ms;
+/* A capture replays the recorded requests and replies in place of the simulated adapter. */
+static akita_capture_replay_t g_capture;
+static bool g_capture_replay;
+
+static uint64_t akita_now_ms(void) {
+    return (uint64_t) (esp_timer_get_time() / 1000ULL);
+}
+
+esp_err_t akita_obd_init(const akita_runtime_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(&g_obd_state, 0, sizeof(g_obd_state));
+    memset(&g_session, 0, sizeof(g_session));
+    g_started_ms = akita_now_ms();
+    g_answer_length = 0;
+    if (g_capture_replay) {
+        akita_capture_replay_close(&g_capture);
+        g_capture_replay = false;
+    }
+
+    if (CONFIG_AKITA_LINUX_CAPTURE_PATH[0] != '\0') {
+        esp_err_t err = akita_capture_replay_open(&g_capture, CONFIG_AKITA_LINUX_CAPTURE_PATH, AKITA_CAPTURE_OBD_SOURCES,
+                                                  CONFIG_AKITA_LINUX_REPLAY_SPEED, (uint64_t) esp_timer_get_time());
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Capture %s: %s", CONFIG_AKITA_LINUX_CAPTURE_PATH, esp_err_to_name(err));
+            return err;
+        }
+
+        g_capture_replay = true;
+        g_obd_state.connected = true;
+        ESP_LOGI(TAG, "OBD replaying capture %s at %d%%", CONFIG_AKITA_LINUX_CAPTURE_PATH, CONFIG_AKITA_LINUX_REPLAY_SPEED);
+        return ESP_OK;
+    }
+
+    g_obd_state.connected = true;
+    akita_obd_session_start(&g_session, g_started_ms);
+    ESP_LOGI(TAG, "OBD adapter simulated with %u ms latency", (unsigned int) CONFIG_AKITA_LINUX_OBD_LATENCY_MS);
+    return ESP_OK;
+}
+
+/* Requests and replies go through the session as the link handed them over, so it parses what the car sent. */
+static void akita_obd_replay_capture(uint64_t now_ms) {
+    akita_capture_record_t record;
+
+    while (akita_capture_replay_next(&g_capture, now_ms * 1000U, &record)) {
+        if (record.source == AKITA_CAPTURE_OBD_TX) {
+            akita_obd_session_sent(&g_session, record.at_us / 1000U);
+        } else {
+            (void) akita_obd_session_receive(&g_session, &g_obd_state, (const char *) record.data, record.length,
+                                             (record.flags & AKITA_CAPTURE_FLAG_FORCE) != 0U, record.at_us / 1000U);
+        }
+        if (akita_capture_replay_done(&g_capture)) {
+            ESP_LOGI(TAG, "OBD capture replay finished");
+        }
+    }
+}
+
+void akita_obd_poll(akita_obd_snapshot_t *snapshot) {
+    uint64_t now_ms = akita_now_ms();
+    const char *command;
+    char request[16];
+    size_t request_length;
+
+    if (snapshot == NULL) {
+        return;
+    }
+
+    if (g_capture_replay) {
+        akita_obd_replay_capture(now_ms);
+    } else if (g_session.pending && g_answer_length > 0U && now_ms >= g_answer_due_ms) {
+        AKITA_CAPTURE(AKITA_CAPTURE_OBD_RX, 0, now_ms * 1000U, g_answer, g_answer_length);
+        (void) akita_obd_session_receive(&g_session, &g_obd_state, g_answer, g_answer_length, false, now_ms);
+        g_answer_length = 0;
+    }
+
+    command = akita_obd_session_command(&g_session);
+    if (akita_obd_session_check_timeout(&g_session, now_ms)) {
+        ESP_LOGW(TAG, "Timed out waiting for OBD response to %s", command);
+    }
+
+    if (!g_capture_replay && akita_obd_session_due(&g_session, now_ms)) {
+        AKITA_METRIC_BEGIN(span);
+        command = akita_obd_session_command(&g_session);
+        request_length = akita_obd_build_request(command, request, sizeof(request));
+        g_answer_length = akita_elm327_sim_answer(request, now_ms - g_started_ms, g_answer, sizeof(g_answer));
+        AKITA_METRIC_END(span, AKITA_METRIC_OBD_REQUEST, request_length > 0U);
+        if (request_length == 0U) {
+            akita_obd_session_retry(&g_session, now_ms, 500U);
+        } else {
+            AKITA_CAPTURE(AKITA_CAPTURE_OBD_TX, 0, now_ms * 1000U, request, request_length);
+            akita_obd_session_sent(&g_session, now_ms);
+            g_answer_due_ms = now_ms + CONFIG_AKITA_LINUX_OBD_LATENCY_MS;
+        }
+    }
+
+    if (g_session.last_sample_ms > 0U) {
+        g_obd_state.age_ms = (uint32_t) (now_ms - g_session.last_sample_ms);
+    }
+    *snapshot = g_obd_state;
+}
@@ -0,0 +1,41 @@
+#ifndef AKITA_ADR_H
+#define AKITA_ADR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+#define AKITA_ADR_HISTORY_LEN 4U
+#define AKITA_ADR_INSTALLATION_MARGIN_QDB 40
+#define AKITA_ADR_HYSTERESIS_QDB 8
+#define AKITA_ADR_POWER_STEP_DBM 3
+#define AKITA_ADR_MIN_TX_POWER_DBM 2
+#define AKITA_ADR_ACK_LIMIT 16U
+#define AKITA_ADR_ACK_DELAY 4U
+
+typedef struct {
+    uint8_t spreading_factor;
+    uint32_t bandwidth_hz;
+    int8_t tx_power_dbm;
+} akita_adr_setting_t;
+
+typedef struct {
+    akita_adr_setting_t current;
+    uint32_t base_bandwidth_hz;
+    uint32_t max_bandwidth_hz;
+    uint8_t max_spreading_factor;
+    int8_t max_tx_power_dbm;
+    int16_t snr_history_qdb[AKITA_ADR_HISTORY_LEN];
+    uint8_t history_count;
+    uint16_t uplinks_since_feedback;
+    uint32_t steps_faster;
+    uint32_t steps_slower;
+} akita_adr_t;
+
+void akita_adr_init(akita_adr_t *adr, const akita_adr_setting_t *base, akita_lora_region_t region);
+int16_t akita_adr_required_snr_qdb(uint8_t spreading_factor);
+bool akita_adr_on_feedback(akita_adr_t *adr, int8_t snr_quarter_db);
+bool akita_adr_on_uplink(akita_adr_t *adr);
+
+#endif
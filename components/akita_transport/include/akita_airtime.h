@@ -0,0 +1,105 @@
+#ifndef AKITA_AIRTIME_H
+#define AKITA_AIRTIME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+#define AKITA_AIRTIME_MAX_PAYLOAD_LEN 255U
+#define AKITA_AIRTIME_QUEUE_SLOTS 6U
+#define AKITA_AIRTIME_MAX_BANDS 7U
+#define AKITA_AIRTIME_BUCKET_MS 60000U
+/* One bucket more than an hour so a bucket only expires once all of it is an hour old. */
+#define AKITA_AIRTIME_WINDOW_BUCKETS 61U
+#define AKITA_AIRTIME_UNRESTRICTED_PERMILLE 1000U
+#define AKITA_AIRTIME_WAIT_NONE UINT32_MAX
+
+typedef struct {
+    uint8_t spreading_factor;
+    uint8_t coding_rate;
+    uint16_t preamble_len;
+    uint32_t bandwidth_hz;
+    bool crc_on;
+    bool implicit_header;
+} akita_lora_modem_t;
+
+typedef struct {
+    uint32_t low_hz;
+    uint32_t high_hz;
+    uint16_t duty_cycle_permille;
+    uint32_t dwell_limit_us;
+} akita_airtime_band_t;
+
+typedef struct {
+    uint32_t bucket_us[AKITA_AIRTIME_WINDOW_BUCKETS];
+    uint64_t head_bucket;
+    uint64_t used_us;
+} akita_airtime_window_t;
+
+typedef struct {
+    akita_message_class_t message_class;
+    bool deferred;
+    uint8_t length;
+    uint32_t airtime_us;
+    uint64_t enqueued_ms;
+    uint8_t data[AKITA_AIRTIME_MAX_PAYLOAD_LEN];
+} akita_airtime_slot_t;
+
+typedef struct {
+    uint32_t deferred;
+    uint32_t coalesced;
+    uint32_t dropped_budget;
+    uint32_t dropped_overflow;
+    uint32_t dropped_stale;
+} akita_airtime_counters_t;
+
+typedef struct {
+    akita_lora_modem_t modem;
+    akita_lora_region_t region;
+    const akita_airtime_band_t *band;
+    size_t band_index;
+    akita_airtime_window_t windows[AKITA_AIRTIME_MAX_BANDS];
+    akita_airtime_slot_t slots[AKITA_AIRTIME_QUEUE_SLOTS];
+    size_t slot_count;
+    uint64_t total_airtime_us;
+    akita_airtime_counters_t counters;
+} akita_airtime_scheduler_t;
+
+bool akita_airtime_bandwidth_code(uint32_t bandwidth_hz, uint8_t *code);
+void akita_airtime_modem_from_config(const akita_runtime_config_t *config, akita_lora_modem_t *modem);
+uint32_t akita_airtime_symbol_us(const akita_lora_modem_t *modem);
+bool akita_airtime_low_data_rate(const akita_lora_modem_t *modem);
+uint32_t akita_airtime_us(const akita_lora_modem_t *modem, size_t payload_len);
+size_t akita_airtime_max_payload(const akita_lora_modem_t *modem, uint32_t limit_us);
+
+akita_lora_region_t akita_airtime_resolve_region(akita_lora_region_t region, uint32_t frequency_hz);
+const akita_airtime_band_t *akita_airtime_find_band(akita_lora_region_t region, uint32_t frequency_hz, size_t *band_index);
+const char *akita_airtime_region_name(akita_lora_region_t region);
+
+void akita_airtime_scheduler_init(akita_airtime_scheduler_t *scheduler);
+void akita_airtime_scheduler_configure(
+    akita_airtime_scheduler_t *scheduler,
+    akita_lora_region_t region,
+    uint32_t frequency_hz,
+    const akita_lora_modem_t *modem
+);
+bool akita_airtime_scheduler_push(
+    akita_airtime_scheduler_t *scheduler,
+    akita_message_class_t message_class,
+    const uint8_t *payload,
+    size_t payload_len,
+    uint64_t now_ms
+);
+bool akita_airtime_scheduler_next(
+    akita_airtime_scheduler_t *scheduler,
+    uint64_t now_ms,
+    akita_airtime_slot_t *slot,
+    uint32_t *wait_ms
+);
+void akita_airtime_scheduler_commit(akita_airtime_scheduler_t *scheduler, uint64_t now_ms, uint32_t airtime_us);
+uint64_t akita_airtime_scheduler_used_us(akita_airtime_scheduler_t *scheduler, uint64_t now_ms);
+uint64_t akita_airtime_scheduler_budget_us(const akita_airtime_scheduler_t *scheduler);
+
+#endif
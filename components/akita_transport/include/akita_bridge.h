@@ -0,0 +1,45 @@
+#ifndef AKITA_BRIDGE_H
+#define AKITA_BRIDGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+#include "esp_err.h"
+
+#define AKITA_BRIDGE_RNS_RESPONSE_MAX_LEN 256
+
+typedef enum {
+    AKITA_TRANSPORT_ENDPOINT_NONE = 0,
+    AKITA_TRANSPORT_ENDPOINT_HTTP,
+    AKITA_TRANSPORT_ENDPOINT_UDP,
+    AKITA_TRANSPORT_ENDPOINT_RNS_UDP,
+    AKITA_TRANSPORT_ENDPOINT_LORA,
+} akita_transport_endpoint_t;
+
+/* The socket side of the IP uplinks, shared by the WiFi transport and the Linux-target one. */
+akita_transport_endpoint_t akita_bridge_endpoint_type(const char *endpoint);
+esp_err_t akita_bridge_parse_host_port(
+    const char *endpoint,
+    const char *scheme,
+    char *host,
+    size_t host_size,
+    char *port,
+    size_t port_size
+);
+void akita_bridge_json_escape(const char *input, char *output, size_t output_size);
+bool akita_bridge_json_extract_string(const char *json, const char *key, char *output, size_t output_size);
+esp_err_t akita_bridge_publish_udp(const char *endpoint, const char *payload);
+/* Sends one request to the Reticulum bridge and waits for its reply; payload NULL sends a bare kind such as ping. */
+esp_err_t akita_bridge_exchange_rns(
+    const akita_runtime_config_t *config,
+    const char *kind,
+    const char *payload,
+    uint32_t sequence,
+    char *response,
+    size_t response_size
+);
+bool akita_bridge_rns_response_ok(const char *response);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef AKITA_GATEWAY_H
+#define AKITA_GATEWAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+#define AKITA_GATEWAY_MAX_FRAME_LEN 255U
+#define AKITA_GATEWAY_DEDUPE_SLOTS 64U
+#define AKITA_GATEWAY_DEDUPE_PROBES 8U
+#define AKITA_GATEWAY_DEDUPE_MS 30000U
+#define AKITA_GATEWAY_BATCH_MAX_FRAMES 12U
+/* Keeps a batch, with its bridge envelope, inside one unfragmented UDP datagram. */
+#define AKITA_GATEWAY_BATCH_MAX_BYTES 1200U
+#define AKITA_GATEWAY_BATCH_WINDOW_MS 500U
+
+typedef enum {
+    AKITA_GATEWAY_ADDED = 0,
+    AKITA_GATEWAY_DUPLICATE,
+    AKITA_GATEWAY_FULL,
+    AKITA_GATEWAY_REJECTED,
+} akita_gateway_result_t;
+
+typedef struct {
+    uint32_t hash;
+    uint64_t seen_ms;
+} akita_gateway_seen_t;
+
+typedef struct {
+    akita_link_quality_t link;
+    uint64_t received_ms;
+    uint8_t length;
+    uint8_t data[AKITA_GATEWAY_MAX_FRAME_LEN];
+} akita_gateway_entry_t;
+
+typedef struct {
+    uint32_t received;
+    uint32_t duplicates;
+    uint32_t forwarded;
+    uint32_t dropped;
+    uint32_t batches;
+    uint32_t downlinks;
+} akita_gateway_counters_t;
+
+typedef struct {
+    akita_gateway_seen_t seen[AKITA_GATEWAY_DEDUPE_SLOTS];
+    akita_gateway_entry_t entries[AKITA_GATEWAY_BATCH_MAX_FRAMES];
+    size_t count;
+    size_t batch_bytes;
+    akita_gateway_counters_t counters;
+} akita_gateway_t;
+
+void akita_gateway_init(akita_gateway_t *gateway);
+akita_gateway_result_t akita_gateway_accept(
+    akita_gateway_t *gateway,
+    const akita_link_quality_t *link,
+    const uint8_t *frame,
+    size_t frame_len,
+    uint64_t now_ms
+);
+bool akita_gateway_flush_due(const akita_gateway_t *gateway, uint64_t now_ms);
+size_t akita_gateway_write_batch(
+    const akita_gateway_t *gateway,
+    const char *escaped_gateway_id,
+    uint64_t now_ms,
+    char *buffer,
+    size_t buffer_size
+);
+void akita_gateway_clear(akita_gateway_t *gateway, bool forwarded);
+size_t akita_gateway_downlink(const char *response, size_t index, uint8_t *frame, size_t frame_size);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef AKITA_LINK_H
+#define AKITA_LINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+
+#define AKITA_LINK_LATENCY_EWMA_SHIFT 3U
+/* Another link must score this much better before traffic moves off the active one. */
+#define AKITA_LINK_SWITCH_MARGIN_PERCENT 25U
+#define AKITA_LINK_BACKOFF_MIN_MS 2000U
+#define AKITA_LINK_BACKOFF_MAX_MS 60000U
+#define AKITA_LINK_THROUGHPUT_WINDOW_MS 60000U
+
+/* Cost is in milliseconds of latency the scheduler would trade to avoid it. */
+#define AKITA_LINK_WIFI_COST_PER_MESSAGE 0U
+#define AKITA_LINK_WIFI_COST_PER_KB 10U
+#define AKITA_LINK_WIFI_LATENCY_MS 300U
+#define AKITA_LINK_LORA_COST_PER_MESSAGE 2000U
+#define AKITA_LINK_LORA_COST_PER_KB 20000U
+#define AKITA_LINK_LORA_LATENCY_MS 400U
+
+typedef enum {
+    AKITA_LINK_WIFI = 0,
+    AKITA_LINK_LORA,
+    AKITA_LINK_COUNT,
+} akita_link_id_t;
+
+#define AKITA_LINK_NONE AKITA_LINK_COUNT
+
+typedef struct {
+    bool up;
+    uint32_t messages;
+    uint32_t bytes;
+    uint32_t failures;
+    uint32_t latency_ms;
+    uint32_t latency_max_ms;
+    uint32_t throughput_bps;
+} akita_link_stats_t;
+
+typedef struct {
+    uint32_t cost_per_message;
+    uint32_t cost_per_kb;
+    size_t max_payload_len;
+    uint8_t consecutive_failures;
+    uint64_t retry_at_ms;
+    uint64_t window_start_ms;
+    uint32_t window_bytes;
+    akita_link_stats_t stats;
+} akita_link_state_t;
+
+typedef struct {
+    akita_link_state_t links[AKITA_LINK_COUNT];
+    akita_link_id_t active;
+    uint32_t switchovers;
+} akita_link_scheduler_t;
+
+void akita_link_scheduler_init(akita_link_scheduler_t *scheduler);
+void akita_link_set_up(akita_link_scheduler_t *scheduler, akita_link_id_t link, bool up, size_t max_payload_len);
+akita_link_id_t akita_link_select(
+    const akita_link_scheduler_t *scheduler,
+    akita_message_class_t message_class,
+    const size_t payload_len[AKITA_LINK_COUNT],
+    uint8_t exclude_mask,
+    uint64_t now_ms
+);
+void akita_link_record(
+    akita_link_scheduler_t *scheduler,
+    akita_link_id_t link,
+    size_t payload_len,
+    bool delivered,
+    uint32_t latency_ms,
+    uint64_t now_ms
+);
+const char *akita_link_name(akita_link_id_t link);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef AKITA_LORA_H
+#define AKITA_LORA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_types.h"
+#include "esp_err.h"
+
+#define AKITA_LORA_MAX_PAYLOAD_LEN 255U
+#define AKITA_LORA_SNR_UNKNOWN INT8_MIN
+
+typedef struct {
+    akita_link_quality_t link;
+    uint8_t length;
+    uint8_t data[AKITA_LORA_MAX_PAYLOAD_LEN];
+} akita_lora_packet_t;
+
+typedef struct {
+    uint32_t tx_queued;
+    uint32_t tx_done;
+    uint32_t tx_dropped;
+    uint32_t tx_errors;
+    uint32_t tx_timeouts;
+    uint32_t rx_frames;
+    uint32_t rx_crc_errors;
+    uint32_t rx_dropped;
+    uint32_t tx_deferred;
+    uint32_t tx_coalesced;
+    uint32_t tx_backlog;
+    uint8_t max_frame_len;
+    uint32_t airtime_used_ms;
+    uint32_t airtime_remaining_ms;
+    uint32_t airtime_total_ms;
+    uint16_t duty_cycle_permille;
+    akita_lora_region_t region;
+    uint8_t spreading_factor;
+    uint32_t bandwidth_hz;
+    int8_t tx_power_dbm;
+    akita_link_quality_t last_link;
+    uint32_t adr_steps_faster;
+    uint32_t adr_steps_slower;
+    bool adr_enabled;
+    bool irq_driven;
+} akita_lora_stats_t;
+
+esp_err_t akita_lora_start(const akita_runtime_config_t *config);
+void akita_lora_stop(void);
+bool akita_lora_ready(void);
+esp_err_t akita_lora_send(akita_message_class_t message_class, const uint8_t *payload, size_t payload_len);
+bool akita_lora_receive(akita_lora_packet_t *packet);
+void akita_lora_link_feedback(const akita_link_quality_t *downlink, int8_t uplink_snr_quarter_db);
+void akita_lora_get_stats(akita_lora_stats_t *stats);
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef AKITA_SX127X_H
+#define AKITA_SX127X_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akita_adr.h"
+#include "akita_airtime.h"
+#include "akita_lora.h"
+#include "akita_types.h"
+#include "esp_err.h"
+
+#define AKITA_SX127X_TX_GRACE_MS 2000
+
+#define AKITA_SX127X_REG_FIFO 0x00
+#define AKITA_SX127X_REG_OP_MODE 0x01
+#define AKITA_SX127X_REG_FRF_MSB 0x06
+#define AKITA_SX127X_REG_FRF_MID 0x07
+#define AKITA_SX127X_REG_FRF_LSB 0x08
+#define AKITA_SX127X_REG_PA_CONFIG 0x09
+#define AKITA_SX127X_REG_OCP 0x0B
+#define AKITA_SX127X_REG_LNA 0x0C
+#define AKITA_SX127X_REG_FIFO_ADDR_PTR 0x0D
+#define AKITA_SX127X_REG_FIFO_TX_BASE_ADDR 0x0E
+#define AKITA_SX127X_REG_FIFO_RX_BASE_ADDR 0x0F
+#define AKITA_SX127X_REG_FIFO_RX_CURRENT_ADDR 0x10
+#define AKITA_SX127X_REG_IRQ_FLAGS 0x12
+#define AKITA_SX127X_REG_RX_NB_BYTES 0x13
+#define AKITA_SX127X_REG_PKT_SNR_VALUE 0x19
+#define AKITA_SX127X_REG_PKT_RSSI_VALUE 0x1A
+#define AKITA_SX127X_REG_MODEM_CONFIG_1 0x1D
+#define AKITA_SX127X_REG_MODEM_CONFIG_2 0x1E
+#define AKITA_SX127X_REG_PREAMBLE_MSB 0x20
+#define AKITA_SX127X_REG_PREAMBLE_LSB 0x21
+#define AKITA_SX127X_REG_PAYLOAD_LENGTH 0x22
+#define AKITA_SX127X_REG_MODEM_CONFIG_3 0x26
+#define AKITA_SX127X_REG_DETECTION_OPTIMIZE 0x31
+#define AKITA_SX127X_REG_DETECTION_THRESHOLD 0x37
+#define AKITA_SX127X_REG_SYNC_WORD 0x39
+#define AKITA_SX127X_REG_DIO_MAPPING_1 0x40
+#define AKITA_SX127X_REG_VERSION 0x42
+#define AKITA_SX127X_REG_PA_DAC 0x4D
+
+#define AKITA_SX127X_MODE_LONG_RANGE 0x80
+#define AKITA_SX127X_MODE_MASK 0x07
+#define AKITA_SX127X_MODE_SLEEP 0x00
+#define AKITA_SX127X_MODE_STDBY 0x01
+#define AKITA_SX127X_MODE_TX 0x03
+#define AKITA_SX127X_MODE_RX_CONTINUOUS 0x05
+
+#define AKITA_SX127X_IRQ_TX_DONE 0x08
+#define AKITA_SX127X_IRQ_PAYLOAD_CRC_ERROR 0x20
+#define AKITA_SX127X_IRQ_RX_DONE 0x40
+#define AKITA_SX127X_DIO0_RX_DONE 0x00
+#define AKITA_SX127X_DIO0_TX_DONE 0x40
+#define AKITA_SX127X_EXPECTED_VERSION 0x12
+#define AKITA_SX127X_FREQUENCY_STEP_HZ 61.03515625
+#define AKITA_SX127X_RSSI_OFFSET_HF (-157)
+#define AKITA_SX127X_RSSI_OFFSET_LF (-164)
+#define AKITA_SX127X_LF_LIMIT_HZ 525000000U
+
+/* One SPI transaction: tx_data[0] is the register address, bit 7 set for a write. */
+typedef esp_err_t (*akita_sx127x_transfer_t)(void *context, const uint8_t *tx_data, uint8_t *rx_data, size_t byte_count);
+typedef bool (*akita_sx127x_receive_t)(void *context, const akita_lora_packet_t *packet);
+
+typedef struct {
+    /* First, so the burst buffers stay word aligned for SPI DMA. */
+    uint8_t burst_tx[AKITA_LORA_MAX_PAYLOAD_LEN + 1U];
+    uint8_t burst_rx[AKITA_LORA_MAX_PAYLOAD_LEN + 1U];
+    akita_sx127x_transfer_t transfer;
+    void *context;
+    bool tx_busy;
+    int64_t tx_deadline_us;
+    uint32_t frequency_hz;
+    akita_lora_region_t region;
+    akita_lora_modem_t modem;
+    int8_t tx_power_dbm;
+    akita_airtime_scheduler_t scheduler;
+    akita_adr_t adr;
+    bool adr_enabled;
+    bool modem_pending;
+    akita_link_quality_t last_link;
+    akita_lora_stats_t stats;
+} akita_sx127x_t;
+
+void akita_sx127x_init(akita_sx127x_t *radio, akita_sx127x_transfer_t transfer, void *context);
+esp_err_t akita_sx127x_configure(akita_sx127x_t *radio, const akita_runtime_config_t *config);
+void akita_sx127x_release(akita_sx127x_t *radio);
+uint32_t akita_sx127x_service(akita_sx127x_t *radio, int64_t now_us, akita_sx127x_receive_t on_receive, void *context);
+bool akita_sx127x_link_feedback(akita_sx127x_t *radio, const akita_link_quality_t *downlink, int8_t uplink_snr_quarter_db);
+void akita_sx127x_get_stats(akita_sx127x_t *radio, uint64_t now_ms, akita_lora_stats_t *stats);
+
+#endif
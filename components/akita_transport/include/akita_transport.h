@@ -2,7 +2,10 @@
 #define AKITA_TRANSPORT_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "akita_link.h"
 #include "akita_types.h"
 #include "esp_err.h"
 
@@ -12,12 +15,46 @@ typedef struct {
 	bool lora_ready;
 	bool wifi_connected;
 	int8_t wifi_rssi;
+	uint32_t lora_airtime_used_ms;
+	uint32_t lora_airtime_remaining_ms;
+	uint32_t lora_tx_deferred;
+	uint32_t lora_tx_dropped;
+	uint32_t lora_tx_backlog;
+	uint8_t lora_max_frame_len;
+	uint16_t lora_duty_cycle_permille;
+	uint8_t lora_spreading_factor;
+	uint32_t lora_bandwidth_hz;
+	int8_t lora_tx_power_dbm;
+	akita_link_quality_t lora_last_link;
+	bool lora_adr_enabled;
+	bool gateway_enabled;
+	uint32_t gateway_forwarded;
+	uint32_t gateway_duplicates;
+	uint32_t gateway_dropped;
+	uint32_t gateway_downlinks;
+	akita_link_id_t active_link;
+	uint32_t link_switchovers;
+	akita_link_stats_t links[AKITA_LINK_COUNT];
 	char bridge_mode[16];
 	char bridge_last_error[64];
 } akita_transport_status_t;
 
 esp_err_t akita_transport_init(const akita_runtime_config_t *config);
 esp_err_t akita_transport_publish(const akita_runtime_config_t *config, const char *payload);
+esp_err_t akita_transport_publish_frame(
+	const akita_runtime_config_t *config,
+	akita_message_class_t message_class,
+	const uint8_t *frame,
+	size_t frame_len
+);
+akita_link_id_t akita_transport_select_link(
+	const akita_runtime_config_t *config,
+	akita_message_class_t message_class,
+	const size_t payload_len[AKITA_LINK_COUNT],
+	uint8_t exclude_mask
+);
+size_t akita_transport_take_frame(uint8_t *buffer, size_t buffer_size, akita_link_quality_t *link);
+void akita_transport_report_link(const akita_link_quality_t *link, int8_t uplink_snr_quarter_db);
 void akita_transport_poll(const akita_runtime_config_t *config);
 bool akita_transport_ready(void);
 void akita_transport_get_status(akita_transport_status_t *status);
@@ -0,0 +1,189 @@
+#include "akita_adr.h"
+
+#include <string.h>
+
+/* Each bandwidth doubling raises the noise floor by about 3 dB. */
+#define AKITA_ADR_BANDWIDTH_STEP_QDB 12
+
+static int16_t akita_adr_bandwidth_double(uint32_t bandwidth_hz, uint32_t *doubled_hz) {
+    switch (bandwidth_hz) {
+        case 62500U:
+        case 125000U:
+        case 250000U:
+            *doubled_hz = bandwidth_hz * 2U;
+            return AKITA_ADR_BANDWIDTH_STEP_QDB;
+        default:
+            return 0;
+    }
+}
+
+int16_t akita_adr_required_snr_qdb(uint8_t spreading_factor) {
+    /* SX127x demodulator floor: -7.5 dB at SF7, 2.5 dB lower per SF step. */
+    if (spreading_factor < 7U) {
+        spreading_factor = 7U;
+    } else if (spreading_factor > 12U) {
+        spreading_factor = 12U;
+    }
+
+    return (int16_t) (-30 - (10 * ((int16_t) spreading_factor - 7)));
+}
+
+static bool akita_adr_step_faster(const akita_adr_t *adr, akita_adr_setting_t *setting, int16_t *cost_qdb) {
+    uint32_t doubled_hz = 0;
+    int16_t cost;
+
+    if (setting->spreading_factor > 7U) {
+        *cost_qdb = (int16_t) (akita_adr_required_snr_qdb((uint8_t) (setting->spreading_factor - 1U)) -
+                               akita_adr_required_snr_qdb(setting->spreading_factor));
+        --setting->spreading_factor;
+        return true;
+    }
+
+    cost = akita_adr_bandwidth_double(setting->bandwidth_hz, &doubled_hz);
+    if (cost > 0 && doubled_hz <= adr->max_bandwidth_hz) {
+        *cost_qdb = cost;
+        setting->bandwidth_hz = doubled_hz;
+        return true;
+    }
+
+    if (setting->tx_power_dbm - AKITA_ADR_POWER_STEP_DBM >= AKITA_ADR_MIN_TX_POWER_DBM) {
+        *cost_qdb = AKITA_ADR_POWER_STEP_DBM * 4;
+        setting->tx_power_dbm = (int8_t) (setting->tx_power_dbm - AKITA_ADR_POWER_STEP_DBM);
+        return true;
+    }
+
+    return false;
+}
+
+static bool akita_adr_step_slower(const akita_adr_t *adr, akita_adr_setting_t *setting, int16_t *gain_qdb) {
+    if (setting->tx_power_dbm < adr->max_tx_power_dbm) {
+        int8_t raised = (int8_t) (setting->tx_power_dbm + AKITA_ADR_POWER_STEP_DBM);
+
+        if (raised > adr->max_tx_power_dbm) {
+            raised = adr->max_tx_power_dbm;
+        }
+        *gain_qdb = (int16_t) ((raised - setting->tx_power_dbm) * 4);
+        setting->tx_power_dbm = raised;
+        return true;
+    }
+
+    if (setting->bandwidth_hz > adr->base_bandwidth_hz) {
+        *gain_qdb = AKITA_ADR_BANDWIDTH_STEP_QDB;
+        setting->bandwidth_hz /= 2U;
+        return true;
+    }
+
+    if (setting->spreading_factor < adr->max_spreading_factor) {
+        *gain_qdb = (int16_t) (akita_adr_required_snr_qdb(setting->spreading_factor) -
+                               akita_adr_required_snr_qdb((uint8_t) (setting->spreading_factor + 1U)));
+        ++setting->spreading_factor;
+        return true;
+    }
+
+    return false;
+}
+
+static int16_t akita_adr_margin_qdb(const akita_adr_t *adr, int16_t snr_qdb) {
+    return (int16_t) (snr_qdb - akita_adr_required_snr_qdb(adr->current.spreading_factor) - AKITA_ADR_INSTALLATION_MARGIN_QDB);
+}
+
+void akita_adr_init(akita_adr_t *adr, const akita_adr_setting_t *base, akita_lora_region_t region) {
+    if (adr == NULL || base == NULL) {
+        return;
+    }
+
+    memset(adr, 0, sizeof(*adr));
+    adr->current = *base;
+    adr->base_bandwidth_hz = base->bandwidth_hz;
+    adr->max_tx_power_dbm = base->tx_power_dbm;
+    /* US915 dwell time rules out SF11/SF12 at 125 kHz; EU868 channels stop at 250 kHz. */
+    adr->max_spreading_factor = region == AKITA_LORA_REGION_US915 ? 10U : 12U;
+    adr->max_bandwidth_hz = region == AKITA_LORA_REGION_EU868 ? 250000U : 500000U;
+    if (adr->max_bandwidth_hz < base->bandwidth_hz) {
+        adr->max_bandwidth_hz = base->bandwidth_hz;
+    }
+    if (adr->max_spreading_factor < base->spreading_factor) {
+        adr->max_spreading_factor = base->spreading_factor;
+    }
+}
+
+bool akita_adr_on_feedback(akita_adr_t *adr, int8_t snr_quarter_db) {
+    akita_adr_setting_t candidate;
+    int32_t sum = 0;
+    int16_t margin;
+    int16_t step;
+    bool changed = false;
+    uint8_t index;
+
+    if (adr == NULL) {
+        return false;
+    }
+
+    adr->uplinks_since_feedback = 0;
+    margin = akita_adr_margin_qdb(adr, snr_quarter_db);
+
+    /* Back off on the first weak sample; speed up only on a full window of good ones. */
+    if (margin < 0) {
+        while (margin < 0 && akita_adr_step_slower(adr, &adr->current, &step)) {
+            margin = (int16_t) (margin + step);
+            changed = true;
+        }
+        if (changed) {
+            ++adr->steps_slower;
+        }
+        adr->history_count = 0;
+        return changed;
+    }
+
+    memmove(&adr->snr_history_qdb[1], &adr->snr_history_qdb[0], (AKITA_ADR_HISTORY_LEN - 1U) * sizeof(adr->snr_history_qdb[0]));
+    adr->snr_history_qdb[0] = snr_quarter_db;
+    if (adr->history_count < AKITA_ADR_HISTORY_LEN) {
+        ++adr->history_count;
+    }
+    if (adr->history_count < AKITA_ADR_HISTORY_LEN) {
+        return false;
+    }
+
+    for (index = 0; index < AKITA_ADR_HISTORY_LEN; ++index) {
+        sum += adr->snr_history_qdb[index];
+    }
+    margin = akita_adr_margin_qdb(adr, (int16_t) (sum / (int32_t) AKITA_ADR_HISTORY_LEN));
+
+    candidate = adr->current;
+    while (akita_adr_step_faster(adr, &candidate, &step) && margin - step >= AKITA_ADR_HYSTERESIS_QDB) {
+        margin = (int16_t) (margin - step);
+        adr->current = candidate;
+        changed = true;
+    }
+
+    if (changed) {
+        ++adr->steps_faster;
+        adr->history_count = 0;
+    }
+    return changed;
+}
+
+bool akita_adr_on_uplink(akita_adr_t *adr) {
+    int16_t step;
+
+    if (adr == NULL) {
+        return false;
+    }
+
+    if (adr->uplinks_since_feedback < UINT16_MAX) {
+        ++adr->uplinks_since_feedback;
+    }
+
+    if (adr->uplinks_since_feedback < AKITA_ADR_ACK_LIMIT ||
+        ((adr->uplinks_since_feedback - AKITA_ADR_ACK_LIMIT) % AKITA_ADR_ACK_DELAY) != 0U) {
+        return false;
+    }
+
+    adr->history_count = 0;
+    if (!akita_adr_step_slower(adr, &adr->current, &step)) {
+        return false;
+    }
+
+    ++adr->steps_slower;
+    return true;
+}
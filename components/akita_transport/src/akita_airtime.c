@@ -0,0 +1,422 @@
+#include "akita_airtime.h"
+
+#include <string.h>
+
+#define AKITA_AIRTIME_LDRO_SYMBOL_US 16000U
+#define AKITA_AIRTIME_DEFAULT_PREAMBLE_LEN 8U
+
+static const uint32_t kBandwidthHz[] = {
+    7800U, 10400U, 15600U, 20800U, 31250U, 41700U, 62500U, 125000U, 250000U, 500000U,
+};
+
+/* ETSI EN 300 220 sub-bands used by EU868 LoRa deployments. */
+static const akita_airtime_band_t kEu868Bands[] = {
+    { 863000000U, 865000000U, 1U, 0U },
+    { 865000000U, 868000000U, 10U, 0U },
+    { 868000000U, 868600000U, 10U, 0U },
+    { 868700000U, 869200000U, 1U, 0U },
+    { 869400000U, 869650000U, 100U, 0U },
+    { 869700000U, 870000000U, 10U, 0U },
+};
+
+/* Gaps between EU868 sub-bands, and frequencies outside them, get the strictest limit. */
+static const akita_airtime_band_t kEu868Fallback = { 863000000U, 870000000U, 1U, 0U };
+static const akita_airtime_band_t kUs915Band = { 902000000U, 928000000U, AKITA_AIRTIME_UNRESTRICTED_PERMILLE, 400000U };
+static const akita_airtime_band_t kUnrestrictedBand = { 0U, UINT32_MAX, AKITA_AIRTIME_UNRESTRICTED_PERMILLE, 0U };
+
+/* Lower classes may only spend part of the budget so alerts always find headroom. */
+static const uint8_t kClassBudgetPercent[AKITA_MESSAGE_CLASS_COUNT] = { 100U, 90U, 70U, 50U };
+static const uint32_t kClassMaxAgeMs[AKITA_MESSAGE_CLASS_COUNT] = { 60000U, 60000U, 30000U, 120000U };
+
+bool akita_airtime_bandwidth_code(uint32_t bandwidth_hz, uint8_t *code) {
+    size_t index;
+
+    for (index = 0; index < sizeof(kBandwidthHz) / sizeof(kBandwidthHz[0]); ++index) {
+        if (kBandwidthHz[index] == bandwidth_hz) {
+            if (code != NULL) {
+                *code = (uint8_t) index;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void akita_airtime_modem_from_config(const akita_runtime_config_t *config, akita_lora_modem_t *modem) {
+    if (config == NULL || modem == NULL) {
+        return;
+    }
+
+    memset(modem, 0, sizeof(*modem));
+    modem->spreading_factor = config->lora_spreading_factor;
+    modem->coding_rate = config->lora_coding_rate;
+    modem->bandwidth_hz = config->lora_bandwidth_hz;
+    modem->preamble_len = AKITA_AIRTIME_DEFAULT_PREAMBLE_LEN;
+    modem->crc_on = true;
+}
+
+uint32_t akita_airtime_symbol_us(const akita_lora_modem_t *modem) {
+    if (modem == NULL || modem->bandwidth_hz == 0U || modem->spreading_factor > 12U) {
+        return 0;
+    }
+
+    return (uint32_t) ((((uint64_t) 1U << modem->spreading_factor) * 1000000ULL) / modem->bandwidth_hz);
+}
+
+bool akita_airtime_low_data_rate(const akita_lora_modem_t *modem) {
+    return akita_airtime_symbol_us(modem) > AKITA_AIRTIME_LDRO_SYMBOL_US;
+}
+
+/* Semtech AN1200.13 time-on-air, kept in quarter symbols so it stays in integer math. */
+uint32_t akita_airtime_us(const akita_lora_modem_t *modem, size_t payload_len) {
+    int32_t numerator;
+    int32_t denominator;
+    uint32_t payload_symbols = 8U;
+    uint64_t quarter_symbols;
+
+    if (modem == NULL || modem->bandwidth_hz == 0U || modem->spreading_factor < 6U || modem->spreading_factor > 12U ||
+        modem->coding_rate < 5U || modem->coding_rate > 8U) {
+        return 0;
+    }
+
+    numerator = (8 * (int32_t) payload_len) - (4 * (int32_t) modem->spreading_factor) + 28 +
+                (modem->crc_on ? 16 : 0) - (modem->implicit_header ? 20 : 0);
+    denominator = 4 * ((int32_t) modem->spreading_factor - (akita_airtime_low_data_rate(modem) ? 2 : 0));
+    if (numerator > 0) {
+        payload_symbols += (uint32_t) ((numerator + denominator - 1) / denominator) * modem->coding_rate;
+    }
+
+    quarter_symbols = (4ULL * modem->preamble_len) + 17ULL + (4ULL * payload_symbols);
+    return (uint32_t) ((quarter_symbols * ((uint64_t) 1U << modem->spreading_factor) * 1000000ULL) /
+                       (4ULL * modem->bandwidth_hz));
+}
+
+size_t akita_airtime_max_payload(const akita_lora_modem_t *modem, uint32_t limit_us) {
+    size_t low = 0;
+    size_t high = AKITA_AIRTIME_MAX_PAYLOAD_LEN;
+
+    if (limit_us == 0U) {
+        return AKITA_AIRTIME_MAX_PAYLOAD_LEN;
+    }
+
+    while (low < high) {
+        size_t middle = (low + high + 1U) / 2U;
+        uint32_t airtime_us = akita_airtime_us(modem, middle);
+
+        if (airtime_us > 0U && airtime_us <= limit_us) {
+            low = middle;
+        } else {
+            high = middle - 1U;
+        }
+    }
+
+    return low;
+}
+
+akita_lora_region_t akita_airtime_resolve_region(akita_lora_region_t region, uint32_t frequency_hz) {
+    if (region != AKITA_LORA_REGION_AUTO) {
+        return region;
+    }
+
+    if (frequency_hz >= kEu868Fallback.low_hz && frequency_hz < kEu868Fallback.high_hz) {
+        return AKITA_LORA_REGION_EU868;
+    }
+    if (frequency_hz >= kUs915Band.low_hz && frequency_hz < kUs915Band.high_hz) {
+        return AKITA_LORA_REGION_US915;
+    }
+    return AKITA_LORA_REGION_UNRESTRICTED;
+}
+
+const akita_airtime_band_t *akita_airtime_find_band(akita_lora_region_t region, uint32_t frequency_hz, size_t *band_index) {
+    const akita_airtime_band_t *band = &kUnrestrictedBand;
+    size_t index = 0;
+
+    switch (akita_airtime_resolve_region(region, frequency_hz)) {
+        case AKITA_LORA_REGION_EU868:
+            for (index = 0; index < sizeof(kEu868Bands) / sizeof(kEu868Bands[0]); ++index) {
+                if (frequency_hz >= kEu868Bands[index].low_hz && frequency_hz < kEu868Bands[index].high_hz) {
+                    break;
+                }
+            }
+            band = index < sizeof(kEu868Bands) / sizeof(kEu868Bands[0]) ? &kEu868Bands[index] : &kEu868Fallback;
+            break;
+        case AKITA_LORA_REGION_US915:
+            band = &kUs915Band;
+            break;
+        default:
+            break;
+    }
+
+    if (band_index != NULL) {
+        *band_index = index;
+    }
+    return band;
+}
+
+const char *akita_airtime_region_name(akita_lora_region_t region) {
+    switch (region) {
+        case AKITA_LORA_REGION_AUTO:
+            return "auto";
+        case AKITA_LORA_REGION_EU868:
+            return "eu868";
+        case AKITA_LORA_REGION_US915:
+            return "us915";
+        case AKITA_LORA_REGION_UNRESTRICTED:
+        default:
+            return "unrestricted";
+    }
+}
+
+static void akita_airtime_window_advance(akita_airtime_window_t *window, uint64_t now_ms) {
+    uint64_t bucket = now_ms / AKITA_AIRTIME_BUCKET_MS;
+
+    if (bucket <= window->head_bucket) {
+        return;
+    }
+
+    if (bucket - window->head_bucket >= AKITA_AIRTIME_WINDOW_BUCKETS) {
+        memset(window->bucket_us, 0, sizeof(window->bucket_us));
+        window->used_us = 0;
+        window->head_bucket = bucket;
+        return;
+    }
+
+    while (window->head_bucket < bucket) {
+        uint32_t *slot = &window->bucket_us[++window->head_bucket % AKITA_AIRTIME_WINDOW_BUCKETS];
+        window->used_us -= *slot;
+        *slot = 0;
+    }
+}
+
+static akita_airtime_window_t *akita_airtime_current_window(akita_airtime_scheduler_t *scheduler, uint64_t now_ms) {
+    akita_airtime_window_t *window = &scheduler->windows[scheduler->band_index];
+
+    akita_airtime_window_advance(window, now_ms);
+    return window;
+}
+
+uint64_t akita_airtime_scheduler_budget_us(const akita_airtime_scheduler_t *scheduler) {
+    if (scheduler == NULL || scheduler->band == NULL) {
+        return 0;
+    }
+
+    return (uint64_t) scheduler->band->duty_cycle_permille * 3600000ULL;
+}
+
+/* Returns false when the frame can never fit this class's share of the budget. */
+static bool akita_airtime_admit_wait(
+    akita_airtime_scheduler_t *scheduler,
+    const akita_airtime_slot_t *slot,
+    uint64_t now_ms,
+    uint32_t *wait_ms
+) {
+    akita_airtime_window_t *window = akita_airtime_current_window(scheduler, now_ms);
+    uint64_t limit_us = (akita_airtime_scheduler_budget_us(scheduler) * kClassBudgetPercent[slot->message_class]) / 100U;
+    uint64_t used_us = window->used_us;
+    uint64_t step;
+
+    *wait_ms = 0;
+    if (scheduler->band->duty_cycle_permille >= AKITA_AIRTIME_UNRESTRICTED_PERMILLE) {
+        return true;
+    }
+    if (slot->airtime_us > limit_us) {
+        return false;
+    }
+
+    for (step = 0; step <= AKITA_AIRTIME_WINDOW_BUCKETS; ++step) {
+        if (step > 0U) {
+            used_us -= window->bucket_us[(window->head_bucket + step) % AKITA_AIRTIME_WINDOW_BUCKETS];
+        }
+        if (used_us + slot->airtime_us <= limit_us) {
+            *wait_ms = step == 0U ? 0U : (uint32_t) (((window->head_bucket + step) * AKITA_AIRTIME_BUCKET_MS) - now_ms);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void akita_airtime_remove_slot(akita_airtime_scheduler_t *scheduler, size_t index) {
+    --scheduler->slot_count;
+    memmove(
+        &scheduler->slots[index],
+        &scheduler->slots[index + 1U],
+        (scheduler->slot_count - index) * sizeof(scheduler->slots[0])
+    );
+}
+
+void akita_airtime_scheduler_init(akita_airtime_scheduler_t *scheduler) {
+    if (scheduler == NULL) {
+        return;
+    }
+
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->region = AKITA_LORA_REGION_UNRESTRICTED;
+    scheduler->band = &kUnrestrictedBand;
+}
+
+void akita_airtime_scheduler_configure(
+    akita_airtime_scheduler_t *scheduler,
+    akita_lora_region_t region,
+    uint32_t frequency_hz,
+    const akita_lora_modem_t *modem
+) {
+    akita_lora_region_t resolved;
+    size_t index;
+
+    if (scheduler == NULL || modem == NULL) {
+        return;
+    }
+
+    resolved = akita_airtime_resolve_region(region, frequency_hz);
+    if (resolved != scheduler->region) {
+        memset(scheduler->windows, 0, sizeof(scheduler->windows));
+        scheduler->region = resolved;
+    }
+
+    scheduler->band = akita_airtime_find_band(resolved, frequency_hz, &scheduler->band_index);
+    scheduler->modem = *modem;
+    for (index = 0; index < scheduler->slot_count; ++index) {
+        scheduler->slots[index].airtime_us = akita_airtime_us(modem, scheduler->slots[index].length);
+    }
+}
+
+bool akita_airtime_scheduler_push(
+    akita_airtime_scheduler_t *scheduler,
+    akita_message_class_t message_class,
+    const uint8_t *payload,
+    size_t payload_len,
+    uint64_t now_ms
+) {
+    akita_airtime_slot_t *slot = NULL;
+    uint32_t airtime_us;
+    size_t index;
+
+    if (scheduler == NULL || payload == NULL || payload_len == 0U || payload_len > AKITA_AIRTIME_MAX_PAYLOAD_LEN ||
+        message_class >= AKITA_MESSAGE_CLASS_COUNT) {
+        return false;
+    }
+
+    airtime_us = akita_airtime_us(&scheduler->modem, payload_len);
+    if (scheduler->band->dwell_limit_us > 0U && airtime_us > scheduler->band->dwell_limit_us) {
+        ++scheduler->counters.dropped_budget;
+        return false;
+    }
+
+    if (message_class == AKITA_MESSAGE_ROUTINE) {
+        for (index = 0; index < scheduler->slot_count; ++index) {
+            if (scheduler->slots[index].message_class == message_class) {
+                slot = &scheduler->slots[index];
+                ++scheduler->counters.coalesced;
+                break;
+            }
+        }
+    }
+
+    if (slot == NULL && scheduler->slot_count == AKITA_AIRTIME_QUEUE_SLOTS) {
+        size_t victim = 0;
+
+        for (index = 1; index < scheduler->slot_count; ++index) {
+            if (scheduler->slots[index].message_class > scheduler->slots[victim].message_class) {
+                victim = index;
+            }
+        }
+
+        ++scheduler->counters.dropped_overflow;
+        if (scheduler->slots[victim].message_class <= message_class) {
+            return false;
+        }
+        akita_airtime_remove_slot(scheduler, victim);
+    }
+
+    if (slot == NULL) {
+        slot = &scheduler->slots[scheduler->slot_count++];
+    }
+
+    slot->message_class = message_class;
+    slot->deferred = false;
+    slot->length = (uint8_t) payload_len;
+    slot->airtime_us = airtime_us;
+    slot->enqueued_ms = now_ms;
+    memcpy(slot->data, payload, payload_len);
+    return true;
+}
+
+bool akita_airtime_scheduler_next(
+    akita_airtime_scheduler_t *scheduler,
+    uint64_t now_ms,
+    akita_airtime_slot_t *slot,
+    uint32_t *wait_ms
+) {
+    size_t best = AKITA_AIRTIME_QUEUE_SLOTS;
+    uint32_t shortest = AKITA_AIRTIME_WAIT_NONE;
+    size_t index = 0;
+
+    if (scheduler == NULL || slot == NULL || wait_ms == NULL) {
+        return false;
+    }
+
+    while (index < scheduler->slot_count) {
+        akita_airtime_slot_t *candidate = &scheduler->slots[index];
+        uint32_t wait = 0;
+
+        if (now_ms - candidate->enqueued_ms > kClassMaxAgeMs[candidate->message_class]) {
+            ++scheduler->counters.dropped_stale;
+            akita_airtime_remove_slot(scheduler, index);
+            continue;
+        }
+
+        if (!akita_airtime_admit_wait(scheduler, candidate, now_ms, &wait)) {
+            ++scheduler->counters.dropped_budget;
+            akita_airtime_remove_slot(scheduler, index);
+            continue;
+        }
+
+        if (wait == 0U) {
+            if (best == AKITA_AIRTIME_QUEUE_SLOTS || candidate->message_class < scheduler->slots[best].message_class) {
+                best = index;
+            }
+        } else {
+            if (!candidate->deferred) {
+                candidate->deferred = true;
+                ++scheduler->counters.deferred;
+            }
+            if (wait < shortest) {
+                shortest = wait;
+            }
+        }
+        ++index;
+    }
+
+    if (best != AKITA_AIRTIME_QUEUE_SLOTS) {
+        *slot = scheduler->slots[best];
+        akita_airtime_remove_slot(scheduler, best);
+        *wait_ms = 0;
+        return true;
+    }
+
+    *wait_ms = shortest;
+    return false;
+}
+
+void akita_airtime_scheduler_commit(akita_airtime_scheduler_t *scheduler, uint64_t now_ms, uint32_t airtime_us) {
+    akita_airtime_window_t *window;
+
+    if (scheduler == NULL) {
+        return;
+    }
+
+    window = akita_airtime_current_window(scheduler, now_ms);
+    window->bucket_us[window->head_bucket % AKITA_AIRTIME_WINDOW_BUCKETS] += airtime_us;
+    window->used_us += airtime_us;
+    scheduler->total_airtime_us += airtime_us;
+}
+
+uint64_t akita_airtime_scheduler_used_us(akita_airtime_scheduler_t *scheduler, uint64_t now_ms) {
+    if (scheduler == NULL) {
+        return 0;
+    }
+
+    return akita_airtime_current_window(scheduler, now_ms)->used_us;
+}
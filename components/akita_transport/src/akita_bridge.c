@@ -0,0 +1,353 @@
+#include "akita_bridge.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <netdb.h>
+#include <sys/socket.h>
+#else
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+#endif
+
+#define AKITA_BRIDGE_HOST_MAX_LEN 80
+#define AKITA_BRIDGE_PORT_MAX_LEN 8
+#define AKITA_BRIDGE_RNS_PROTOCOL "akita-rns-udp-v2"
+#define AKITA_BRIDGE_RNS_TIMEOUT_MS 12000
+
+akita_transport_endpoint_t akita_bridge_endpoint_type(const char *endpoint) {
+    if (endpoint == NULL || endpoint[0] == '\0') {
+        return AKITA_TRANSPORT_ENDPOINT_NONE;
+    }
+
+    if (strncasecmp(endpoint, "rns+udp://", 10) == 0) {
+        return AKITA_TRANSPORT_ENDPOINT_RNS_UDP;
+    }
+
+    if (strncasecmp(endpoint, "http://", 7) == 0 || strncasecmp(endpoint, "https://", 8) == 0) {
+        return AKITA_TRANSPORT_ENDPOINT_HTTP;
+    }
+
+    if (strncasecmp(endpoint, "udp://", 6) == 0) {
+        return AKITA_TRANSPORT_ENDPOINT_UDP;
+    }
+
+    return AKITA_TRANSPORT_ENDPOINT_NONE;
+}
+
+esp_err_t akita_bridge_parse_host_port(
+    const char *endpoint,
+    const char *scheme,
+    char *host,
+    size_t host_size,
+    char *port,
+    size_t port_size
+) {
+    const char *host_start;
+    const char *host_end;
+    const char *port_start;
+    const char *port_end;
+    size_t host_length;
+    size_t port_length;
+
+    size_t scheme_len;
+
+    if (endpoint == NULL || scheme == NULL || host == NULL || port == NULL ||
+        host_size == 0U || port_size == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    scheme_len = strlen(scheme);
+    if (strncasecmp(endpoint, scheme, scheme_len) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_start = endpoint + scheme_len;
+    port_start = strrchr(host_start, ':');
+    if (port_start == NULL || port_start == host_start) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_end = port_start;
+    port_start += 1;
+    port_end = endpoint + strlen(endpoint);
+
+    host_length = (size_t) (host_end - host_start);
+    port_length = (size_t) (port_end - port_start);
+    if (host_length == 0U || host_length >= host_size || port_length == 0U || port_length >= port_size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(host, host_start, host_length);
+    host[host_length] = '\0';
+    memcpy(port, port_start, port_length);
+    port[port_length] = '\0';
+    return ESP_OK;
+}
+
+void akita_bridge_json_escape(const char *input, char *output, size_t output_size) {
+    size_t used = 0;
+
+    if (output == NULL || output_size == 0U) {
+        return;
+    }
+
+    while (input != NULL && *input != '\0' && (used + 1U) < output_size) {
+        if ((*input == '"' || *input == '\\') && (used + 2U) < output_size) {
+            output[used++] = '\\';
+            output[used++] = *input;
+        } else if (*input == '\n' && (used + 2U) < output_size) {
+            output[used++] = '\\';
+            output[used++] = 'n';
+        } else if (*input == '\r' && (used + 2U) < output_size) {
+            output[used++] = '\\';
+            output[used++] = 'r';
+        } else if (*input == '\t' && (used + 2U) < output_size) {
+            output[used++] = '\\';
+            output[used++] = 't';
+        } else {
+            output[used++] = *input;
+        }
+
+        ++input;
+    }
+
+    output[used] = '\0';
+}
+
+bool akita_bridge_json_extract_string(const char *json, const char *key, char *output, size_t output_size) {
+    char pattern[32];
+    const char *cursor;
+    size_t used = 0;
+
+    if (json == NULL || key == NULL || output == NULL || output_size == 0U) {
+        return false;
+    }
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+    cursor = strstr(json, pattern);
+    if (cursor == NULL) {
+        output[0] = '\0';
+        return false;
+    }
+
+    cursor += strlen(pattern);
+    while (*cursor != '\0' && *cursor != '"' && (used + 1U) < output_size) {
+        if (*cursor == '\\' && cursor[1] != '\0') {
+            ++cursor;
+        }
+
+        output[used++] = *cursor++;
+    }
+
+    output[used] = '\0';
+    return used > 0U;
+}
+
+static esp_err_t akita_bridge_publish_datagram(
+    const char *host,
+    const char *port,
+    const char *payload,
+    size_t payload_len
+) {
+    struct addrinfo hints = {0};
+    struct addrinfo *result = NULL;
+    int socket_fd = -1;
+    int sent_bytes;
+
+    if (host == NULL || port == NULL || payload == NULL || payload_len == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, port, &hints, &result) != 0 || result == NULL) {
+        return ESP_FAIL;
+    }
+
+    socket_fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (socket_fd < 0) {
+        freeaddrinfo(result);
+        return ESP_FAIL;
+    }
+
+    sent_bytes = (int) sendto(socket_fd, payload, payload_len, 0, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    close(socket_fd);
+    if (sent_bytes < 0 || (size_t) sent_bytes != payload_len) {
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t akita_bridge_exchange_datagram(
+    const char *host,
+    const char *port,
+    const char *payload,
+    size_t payload_len,
+    char *response,
+    size_t response_size
+) {
+    struct addrinfo hints = {0};
+    struct addrinfo *result = NULL;
+    struct timeval timeout = {
+        .tv_sec = AKITA_BRIDGE_RNS_TIMEOUT_MS / 1000,
+        .tv_usec = (AKITA_BRIDGE_RNS_TIMEOUT_MS % 1000) * 1000,
+    };
+    int socket_fd = -1;
+    int received_bytes;
+    int sent_bytes;
+
+    if (host == NULL || port == NULL || payload == NULL || payload_len == 0U ||
+        response == NULL || response_size < 2U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, port, &hints, &result) != 0 || result == NULL) {
+        return ESP_FAIL;
+    }
+
+    socket_fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (socket_fd < 0) {
+        freeaddrinfo(result);
+        return ESP_FAIL;
+    }
+
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) {
+        freeaddrinfo(result);
+        close(socket_fd);
+        return ESP_FAIL;
+    }
+
+    if (connect(socket_fd, result->ai_addr, result->ai_addrlen) != 0) {
+        freeaddrinfo(result);
+        close(socket_fd);
+        return ESP_FAIL;
+    }
+
+    sent_bytes = (int) send(socket_fd, payload, payload_len, 0);
+    if (sent_bytes < 0 || (size_t) sent_bytes != payload_len) {
+        freeaddrinfo(result);
+        close(socket_fd);
+        return ESP_FAIL;
+    }
+
+    received_bytes = (int) recv(socket_fd, response, response_size - 1U, 0);
+    freeaddrinfo(result);
+    close(socket_fd);
+    if (received_bytes <= 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    response[received_bytes] = '\0';
+    return ESP_OK;
+}
+
+bool akita_bridge_rns_response_ok(const char *response) {
+    return response != NULL && strstr(response, "\"status\":\"ok\"") != NULL;
+}
+
+esp_err_t akita_bridge_exchange_rns(
+    const akita_runtime_config_t *config,
+    const char *kind,
+    const char *payload,
+    uint32_t sequence,
+    char *response,
+    size_t response_size
+) {
+    char host[AKITA_BRIDGE_HOST_MAX_LEN];
+    char port[AKITA_BRIDGE_PORT_MAX_LEN];
+    char escaped_vehicle_id[80];
+    char escaped_destination[160];
+    char *request = NULL;
+    int written;
+    size_t request_size;
+    esp_err_t err;
+
+    if (config == NULL || kind == NULL || response == NULL || response_size < 2U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    err = akita_bridge_parse_host_port(
+        config->telemetry_endpoint,
+        "rns+udp://",
+        host,
+        sizeof(host),
+        port,
+        sizeof(port)
+    );
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    akita_bridge_json_escape(config->vehicle_id, escaped_vehicle_id, sizeof(escaped_vehicle_id));
+
+    if (payload == NULL) {
+        request_size = strlen(AKITA_BRIDGE_RNS_PROTOCOL) + strlen(kind) + strlen(escaped_vehicle_id) + 96U;
+        request = malloc(request_size);
+        if (request == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        written = snprintf(
+            request,
+            request_size,
+            "{\"bridge\":\"%s\",\"kind\":\"%s\",\"sequence\":%lu,\"vehicle_id\":\"%s\"}",
+            AKITA_BRIDGE_RNS_PROTOCOL,
+            kind,
+            (unsigned long) sequence,
+            escaped_vehicle_id
+        );
+    } else {
+        akita_bridge_json_escape(config->reticulum_destination, escaped_destination, sizeof(escaped_destination));
+        request_size = strlen(AKITA_BRIDGE_RNS_PROTOCOL) + strlen(kind) + strlen(escaped_vehicle_id) +
+                       strlen(escaped_destination) + strlen(payload) + 128U;
+        request = malloc(request_size);
+        if (request == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        written = snprintf(
+            request,
+            request_size,
+            "{\"bridge\":\"%s\",\"kind\":\"%s\",\"sequence\":%lu,\"vehicle_id\":\"%s\",\"destination\":\"%s\",\"payload\":%s}",
+            AKITA_BRIDGE_RNS_PROTOCOL,
+            kind,
+            (unsigned long) sequence,
+            escaped_vehicle_id,
+            escaped_destination,
+            payload
+        );
+    }
+
+    if (written < 0 || (size_t) written >= request_size) {
+        free(request);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    err = akita_bridge_exchange_datagram(host, port, request, (size_t) written, response, response_size);
+    free(request);
+    return err;
+}
+
+esp_err_t akita_bridge_publish_udp(const char *endpoint, const char *payload) {
+    char host[AKITA_BRIDGE_HOST_MAX_LEN];
+    char port[AKITA_BRIDGE_PORT_MAX_LEN];
+    esp_err_t err;
+
+    err = akita_bridge_parse_host_port(endpoint, "udp://", host, sizeof(host), port, sizeof(port));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    return akita_bridge_publish_datagram(host, port, payload, strlen(payload));
+}
@@ -0,0 +1,257 @@
+#include "akita_gateway.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Worst case per entry: hex frame plus {"frame":"","rssi":-128,"snr_qdb":-128,"age_ms":4294967295}, */
+#define AKITA_GATEWAY_ENTRY_OVERHEAD 60U
+#define AKITA_GATEWAY_BATCH_OVERHEAD 64U
+
+static uint32_t akita_gateway_hash(const uint8_t *frame, size_t frame_len) {
+    uint32_t hash = 2166136261UL;
+    size_t index;
+
+    for (index = 0; index < frame_len; ++index) {
+        hash ^= frame[index];
+        hash *= 16777619UL;
+    }
+
+    /* Zero marks an empty dedupe slot. */
+    return hash != 0U ? hash : 1U;
+}
+
+static bool akita_gateway_remember(akita_gateway_t *gateway, uint32_t hash, uint64_t now_ms) {
+    akita_gateway_seen_t *victim = NULL;
+    bool victim_live = true;
+    size_t probe;
+
+    /* Reuse the first expired slot in the probe window, else the oldest live one. */
+    for (probe = 0; probe < AKITA_GATEWAY_DEDUPE_PROBES; ++probe) {
+        akita_gateway_seen_t *slot = &gateway->seen[(hash + probe) % AKITA_GATEWAY_DEDUPE_SLOTS];
+        bool live = slot->hash != 0U && now_ms - slot->seen_ms < AKITA_GATEWAY_DEDUPE_MS;
+
+        if (live && slot->hash == hash) {
+            return true;
+        }
+        if (!live && victim_live) {
+            victim = slot;
+            victim_live = false;
+        } else if (live && victim_live && (victim == NULL || slot->seen_ms < victim->seen_ms)) {
+            victim = slot;
+        }
+    }
+
+    victim->hash = hash;
+    victim->seen_ms = now_ms;
+    return false;
+}
+
+static void akita_gateway_forget(akita_gateway_t *gateway, uint32_t hash) {
+    size_t probe;
+
+    for (probe = 0; probe < AKITA_GATEWAY_DEDUPE_PROBES; ++probe) {
+        akita_gateway_seen_t *slot = &gateway->seen[(hash + probe) % AKITA_GATEWAY_DEDUPE_SLOTS];
+
+        if (slot->hash == hash) {
+            slot->hash = 0;
+            return;
+        }
+    }
+}
+
+void akita_gateway_init(akita_gateway_t *gateway) {
+    if (gateway != NULL) {
+        memset(gateway, 0, sizeof(*gateway));
+        gateway->batch_bytes = AKITA_GATEWAY_BATCH_OVERHEAD;
+    }
+}
+
+akita_gateway_result_t akita_gateway_accept(
+    akita_gateway_t *gateway,
+    const akita_link_quality_t *link,
+    const uint8_t *frame,
+    size_t frame_len,
+    uint64_t now_ms
+) {
+    akita_gateway_entry_t *entry;
+    size_t entry_bytes = (frame_len * 2U) + AKITA_GATEWAY_ENTRY_OVERHEAD;
+    uint32_t hash;
+
+    if (gateway == NULL || link == NULL || frame == NULL || frame_len == 0U || frame_len > AKITA_GATEWAY_MAX_FRAME_LEN) {
+        return AKITA_GATEWAY_REJECTED;
+    }
+
+    /* Only binary frames are forwarded; JSON text over LoRa predates the frame format. */
+    if (frame[0] == '{') {
+        return AKITA_GATEWAY_REJECTED;
+    }
+
+    if (gateway->count >= AKITA_GATEWAY_BATCH_MAX_FRAMES ||
+        (gateway->count > 0U && gateway->batch_bytes + entry_bytes > AKITA_GATEWAY_BATCH_MAX_BYTES)) {
+        return AKITA_GATEWAY_FULL;
+    }
+
+    hash = akita_gateway_hash(frame, frame_len);
+    if (akita_gateway_remember(gateway, hash, now_ms)) {
+        ++gateway->counters.duplicates;
+        return AKITA_GATEWAY_DUPLICATE;
+    }
+
+    entry = &gateway->entries[gateway->count++];
+    entry->link = *link;
+    entry->received_ms = now_ms;
+    entry->length = (uint8_t) frame_len;
+    memcpy(entry->data, frame, frame_len);
+    gateway->batch_bytes += entry_bytes;
+    ++gateway->counters.received;
+    return AKITA_GATEWAY_ADDED;
+}
+
+bool akita_gateway_flush_due(const akita_gateway_t *gateway, uint64_t now_ms) {
+    if (gateway == NULL || gateway->count == 0U) {
+        return false;
+    }
+
+    return gateway->count >= AKITA_GATEWAY_BATCH_MAX_FRAMES ||
+           now_ms - gateway->entries[0].received_ms >= AKITA_GATEWAY_BATCH_WINDOW_MS;
+}
+
+size_t akita_gateway_write_batch(
+    const akita_gateway_t *gateway,
+    const char *escaped_gateway_id,
+    uint64_t now_ms,
+    char *buffer,
+    size_t buffer_size
+) {
+    static const char hex_digits[] = "0123456789abcdef";
+    size_t used;
+    size_t index;
+    int written;
+
+    if (gateway == NULL || buffer == NULL || buffer_size == 0U) {
+        return 0;
+    }
+
+    written = snprintf(buffer, buffer_size, "{\"gateway\":\"%s\",\"frames\":[", escaped_gateway_id != NULL ? escaped_gateway_id : "");
+    if (written < 0 || (size_t) written >= buffer_size) {
+        return 0;
+    }
+    used = (size_t) written;
+
+    for (index = 0; index < gateway->count; ++index) {
+        const akita_gateway_entry_t *entry = &gateway->entries[index];
+        size_t byte;
+
+        written = snprintf(&buffer[used], buffer_size - used, "%s{\"frame\":\"", index > 0U ? "," : "");
+        if (written < 0 || (size_t) written >= buffer_size - used ||
+            used + (size_t) written + (entry->length * 2U) >= buffer_size) {
+            return 0;
+        }
+        used += (size_t) written;
+        for (byte = 0; byte < entry->length; ++byte) {
+            buffer[used++] = hex_digits[entry->data[byte] >> 4];
+            buffer[used++] = hex_digits[entry->data[byte] & 0x0FU];
+        }
+
+        written = snprintf(
+            &buffer[used],
+            buffer_size - used,
+            "\",\"rssi\":%d,\"snr_qdb\":%d,\"age_ms\":%lu}",
+            (int) entry->link.rssi_dbm,
+            (int) entry->link.snr_quarter_db,
+            (unsigned long) (now_ms - entry->received_ms)
+        );
+        if (written < 0 || (size_t) written >= buffer_size - used) {
+            return 0;
+        }
+        used += (size_t) written;
+    }
+
+    if (used + 3U > buffer_size) {
+        return 0;
+    }
+    buffer[used++] = ']';
+    buffer[used++] = '}';
+    buffer[used] = '\0';
+    return used;
+}
+
+void akita_gateway_clear(akita_gateway_t *gateway, bool forwarded) {
+    if (gateway == NULL || gateway->count == 0U) {
+        return;
+    }
+
+    if (forwarded) {
+        gateway->counters.forwarded += (uint32_t) gateway->count;
+        ++gateway->counters.batches;
+    } else {
+        size_t index;
+
+        /* The bridge never saw these, so a retransmission must not be dropped as a duplicate. */
+        for (index = 0; index < gateway->count; ++index) {
+            akita_gateway_forget(gateway, akita_gateway_hash(gateway->entries[index].data, gateway->entries[index].length));
+        }
+        gateway->counters.dropped += (uint32_t) gateway->count;
+    }
+    gateway->count = 0;
+    gateway->batch_bytes = AKITA_GATEWAY_BATCH_OVERHEAD;
+}
+
+static int akita_gateway_hex_value(char digit) {
+    if (digit >= '0' && digit <= '9') {
+        return digit - '0';
+    }
+    if (digit >= 'a' && digit <= 'f') {
+        return digit - 'a' + 10;
+    }
+    if (digit >= 'A' && digit <= 'F') {
+        return digit - 'A' + 10;
+    }
+    return -1;
+}
+
+size_t akita_gateway_downlink(const char *response, size_t index, uint8_t *frame, size_t frame_size) {
+    const char *position;
+    size_t length = 0;
+
+    if (response == NULL || frame == NULL) {
+        return 0;
+    }
+
+    position = strstr(response, "\"downlinks\":[");
+    if (position == NULL) {
+        return 0;
+    }
+    position += 13;
+
+    /* Skip to the requested element; downlinks are plain hex strings. */
+    while (true) {
+        while (*position == ' ' || *position == ',') {
+            ++position;
+        }
+        if (*position != '"') {
+            return 0;
+        }
+        if (index == 0U) {
+            break;
+        }
+        position = strchr(position + 1, '"');
+        if (position == NULL) {
+            return 0;
+        }
+        ++position;
+        --index;
+    }
+
+    for (++position; position[0] != '"'; position += 2) {
+        int high = akita_gateway_hex_value(position[0]);
+        int low = high >= 0 ? akita_gateway_hex_value(position[1]) : -1;
+
+        if (low < 0 || length >= frame_size) {
+            return 0;
+        }
+        frame[length++] = (uint8_t) ((high << 4) | low);
+    }
+
+    return length;
+}
@@ -0,0 +1,187 @@
+#include "akita_link.h"
+
+#include <string.h>
+
+typedef struct {
+    uint8_t latency;
+    uint8_t cost;
+} akita_link_weight_t;
+
+/* Alerts take the fastest link whatever it costs; bulk data waits for the cheap one. */
+static const akita_link_weight_t AKITA_LINK_CLASS_WEIGHTS[AKITA_MESSAGE_CLASS_COUNT] = {
+    [AKITA_MESSAGE_ALERT] = {.latency = 4U, .cost = 0U},
+    [AKITA_MESSAGE_EVENT] = {.latency = 2U, .cost = 1U},
+    [AKITA_MESSAGE_ROUTINE] = {.latency = 1U, .cost = 1U},
+    [AKITA_MESSAGE_BULK] = {.latency = 1U, .cost = 4U},
+};
+
+void akita_link_scheduler_init(akita_link_scheduler_t *scheduler) {
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->links[AKITA_LINK_WIFI].cost_per_message = AKITA_LINK_WIFI_COST_PER_MESSAGE;
+    scheduler->links[AKITA_LINK_WIFI].cost_per_kb = AKITA_LINK_WIFI_COST_PER_KB;
+    scheduler->links[AKITA_LINK_WIFI].stats.latency_ms = AKITA_LINK_WIFI_LATENCY_MS;
+    scheduler->links[AKITA_LINK_LORA].cost_per_message = AKITA_LINK_LORA_COST_PER_MESSAGE;
+    scheduler->links[AKITA_LINK_LORA].cost_per_kb = AKITA_LINK_LORA_COST_PER_KB;
+    scheduler->links[AKITA_LINK_LORA].stats.latency_ms = AKITA_LINK_LORA_LATENCY_MS;
+    scheduler->active = AKITA_LINK_NONE;
+}
+
+void akita_link_set_up(akita_link_scheduler_t *scheduler, akita_link_id_t link, bool up, size_t max_payload_len) {
+    if (link >= AKITA_LINK_COUNT) {
+        return;
+    }
+
+    scheduler->links[link].stats.up = up;
+    scheduler->links[link].max_payload_len = max_payload_len;
+}
+
+static bool akita_link_usable(
+    const akita_link_scheduler_t *scheduler,
+    akita_link_id_t link,
+    const size_t payload_len[AKITA_LINK_COUNT],
+    uint8_t exclude_mask,
+    uint64_t now_ms
+) {
+    const akita_link_state_t *state = &scheduler->links[link];
+
+    return state->stats.up && payload_len[link] > 0U && (exclude_mask & (1U << link)) == 0U &&
+           now_ms >= state->retry_at_ms;
+}
+
+static uint64_t akita_link_score(const akita_link_state_t *state, akita_message_class_t message_class, size_t payload_len) {
+    const akita_link_weight_t *weight = &AKITA_LINK_CLASS_WEIGHTS[message_class];
+    uint64_t pieces = 1U;
+    uint64_t cost;
+
+    /* A message larger than one frame goes out as fragments, each paying the per-message cost and latency. */
+    if (state->max_payload_len > 0U && payload_len > state->max_payload_len) {
+        pieces = (payload_len + state->max_payload_len - 1U) / state->max_payload_len;
+    }
+
+    cost = pieces * state->cost_per_message + ((uint64_t) state->cost_per_kb * payload_len) / 1024U;
+    return (uint64_t) weight->latency * state->stats.latency_ms * pieces + (uint64_t) weight->cost * cost;
+}
+
+akita_link_id_t akita_link_select(
+    const akita_link_scheduler_t *scheduler,
+    akita_message_class_t message_class,
+    const size_t payload_len[AKITA_LINK_COUNT],
+    uint8_t exclude_mask,
+    uint64_t now_ms
+) {
+    akita_link_id_t best = AKITA_LINK_NONE;
+    uint64_t best_score = UINT64_MAX;
+    uint64_t active_score;
+    akita_link_id_t link;
+
+    if (scheduler == NULL || payload_len == NULL) {
+        return AKITA_LINK_NONE;
+    }
+
+    if (message_class >= AKITA_MESSAGE_CLASS_COUNT) {
+        message_class = AKITA_MESSAGE_ROUTINE;
+    }
+
+    for (link = AKITA_LINK_WIFI; link < AKITA_LINK_COUNT; ++link) {
+        uint64_t score;
+
+        if (!akita_link_usable(scheduler, link, payload_len, exclude_mask, now_ms)) {
+            continue;
+        }
+
+        score = akita_link_score(&scheduler->links[link], message_class, payload_len[link]);
+        if (score < best_score) {
+            best = link;
+            best_score = score;
+        }
+    }
+
+    if (best == AKITA_LINK_NONE || best == scheduler->active || scheduler->active >= AKITA_LINK_COUNT ||
+        !akita_link_usable(scheduler, scheduler->active, payload_len, exclude_mask, now_ms)) {
+        return best;
+    }
+
+    active_score = akita_link_score(&scheduler->links[scheduler->active], message_class, payload_len[scheduler->active]);
+    if (best_score * 100U > active_score * (100U - AKITA_LINK_SWITCH_MARGIN_PERCENT)) {
+        return scheduler->active;
+    }
+
+    return best;
+}
+
+void akita_link_record(
+    akita_link_scheduler_t *scheduler,
+    akita_link_id_t link,
+    size_t payload_len,
+    bool delivered,
+    uint32_t latency_ms,
+    uint64_t now_ms
+) {
+    akita_link_state_t *state;
+    uint32_t backoff_ms;
+    uint64_t elapsed_ms;
+    uint8_t index;
+
+    if (scheduler == NULL || link >= AKITA_LINK_COUNT) {
+        return;
+    }
+
+    state = &scheduler->links[link];
+    if (state->window_start_ms == 0U) {
+        state->window_start_ms = now_ms;
+    }
+
+    elapsed_ms = now_ms - state->window_start_ms;
+    if (elapsed_ms >= AKITA_LINK_THROUGHPUT_WINDOW_MS) {
+        state->stats.throughput_bps = (uint32_t) (((uint64_t) state->window_bytes * 1000U) / elapsed_ms);
+        state->window_bytes = 0;
+        state->window_start_ms = now_ms;
+    }
+
+    if (!delivered) {
+        ++state->stats.failures;
+        if (state->consecutive_failures < UINT8_MAX) {
+            ++state->consecutive_failures;
+        }
+
+        backoff_ms = AKITA_LINK_BACKOFF_MIN_MS;
+        for (index = 1U; index < state->consecutive_failures && backoff_ms < AKITA_LINK_BACKOFF_MAX_MS; ++index) {
+            backoff_ms *= 2U;
+        }
+        if (backoff_ms > AKITA_LINK_BACKOFF_MAX_MS) {
+            backoff_ms = AKITA_LINK_BACKOFF_MAX_MS;
+        }
+        state->retry_at_ms = now_ms + backoff_ms;
+        return;
+    }
+
+    ++state->stats.messages;
+    state->stats.bytes += (uint32_t) payload_len;
+    state->window_bytes += (uint32_t) payload_len;
+    state->stats.latency_ms = (uint32_t) ((int32_t) state->stats.latency_ms +
+                                          ((int32_t) latency_ms - (int32_t) state->stats.latency_ms) /
+                                              (int32_t) (1U << AKITA_LINK_LATENCY_EWMA_SHIFT));
+    if (latency_ms > state->stats.latency_max_ms) {
+        state->stats.latency_max_ms = latency_ms;
+    }
+    state->consecutive_failures = 0;
+    state->retry_at_ms = 0;
+
+    if (scheduler->active != link) {
+        if (scheduler->active < AKITA_LINK_COUNT) {
+            ++scheduler->switchovers;
+        }
+        scheduler->active = link;
+    }
+}
+
+const char *akita_link_name(akita_link_id_t link) {
+    switch (link) {
+        case AKITA_LINK_WIFI:
+            return "wifi";
+        case AKITA_LINK_LORA:
+            return "lora";
+        default:
+            return "none";
+    }
+}
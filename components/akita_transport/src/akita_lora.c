@@ -0,0 +1,371 @@
+#include "akita_lora.h"
+
+#include <string.h>
+
+#include "akita_sx127x.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define AKITA_LORA_SPI_HOST SPI2_HOST
+#define AKITA_LORA_SPI_CLOCK_HZ (8 * 1000 * 1000)
+#define AKITA_LORA_TX_QUEUE_DEPTH 4
+#define AKITA_LORA_RX_QUEUE_DEPTH 16
+#define AKITA_LORA_TASK_STACK_SIZE 3072
+#define AKITA_LORA_TASK_PRIORITY 6
+#define AKITA_LORA_IRQ_IDLE_WAIT_MS 1000
+#define AKITA_LORA_POLL_INTERVAL_MS 10
+
+typedef struct {
+    akita_message_class_t message_class;
+    akita_lora_packet_t packet;
+} akita_lora_tx_request_t;
+
+static const char *TAG = "akita_lora";
+
+static spi_device_handle_t g_lora_spi;
+static bool g_lora_spi_bus_initialized;
+static bool g_lora_ready;
+static int32_t g_lora_dio0_pin = AKITA_INVALID_PIN;
+static TaskHandle_t g_lora_task;
+static QueueHandle_t g_lora_tx_queue;
+static QueueHandle_t g_lora_rx_queue;
+static SemaphoreHandle_t g_lora_lock;
+static DMA_ATTR akita_sx127x_t g_lora_radio;
+
+static bool akita_lora_pin_is_valid(int32_t pin) {
+    return pin >= 0 && pin < GPIO_NUM_MAX;
+}
+
+/* The GPIO ISR service is not installed with ESP_INTR_FLAG_IRAM, so this runs only with the cache on and stays in flash. */
+static void akita_lora_dio0_isr(void *arg) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    (void) arg;
+
+    if (g_lora_task != NULL) {
+        vTaskNotifyGiveFromISR(g_lora_task, &higher_priority_task_woken);
+    }
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static esp_err_t akita_lora_transfer(void *context, const uint8_t *tx_data, uint8_t *rx_data, size_t byte_count) {
+    spi_transaction_t transaction = {0};
+    esp_err_t err;
+    size_t index;
+    (void) context;
+
+    if (g_lora_spi == NULL || tx_data == NULL || byte_count == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (byte_count > 4U) {
+        transaction.length = byte_count * 8U;
+        transaction.tx_buffer = tx_data;
+        transaction.rx_buffer = rx_data;
+        return spi_device_polling_transmit(g_lora_spi, &transaction);
+    }
+
+    transaction.flags = SPI_TRANS_USE_TXDATA;
+    if (rx_data != NULL) {
+        transaction.flags |= SPI_TRANS_USE_RXDATA;
+    }
+    transaction.length = byte_count * 8U;
+    for (index = 0; index < byte_count; ++index) {
+        transaction.tx_data[index] = tx_data[index];
+    }
+    err = spi_device_polling_transmit(g_lora_spi, &transaction);
+    if (err == ESP_OK && rx_data != NULL) {
+        for (index = 0; index < byte_count; ++index) {
+            rx_data[index] = transaction.rx_data[index];
+        }
+    }
+    return err;
+}
+
+static bool akita_lora_queue_rx(void *context, const akita_lora_packet_t *packet) {
+    (void) context;
+    return xQueueSend(g_lora_rx_queue, packet, 0) == pdTRUE;
+}
+
+static uint32_t akita_lora_service(void) {
+    akita_lora_tx_request_t request;
+    int64_t now_us = esp_timer_get_time();
+
+    while (xQueueReceive(g_lora_tx_queue, &request, 0) == pdTRUE) {
+        (void) akita_airtime_scheduler_push(
+            &g_lora_radio.scheduler,
+            request.message_class,
+            request.packet.data,
+            request.packet.length,
+            (uint64_t) (now_us / 1000LL)
+        );
+    }
+
+    return akita_sx127x_service(&g_lora_radio, now_us, akita_lora_queue_rx, NULL);
+}
+
+static void akita_lora_task(void *arg) {
+    uint32_t scheduled_ms = AKITA_AIRTIME_WAIT_NONE;
+    (void) arg;
+
+    while (true) {
+        uint32_t wait_ms = akita_lora_pin_is_valid(g_lora_dio0_pin) ? AKITA_LORA_IRQ_IDLE_WAIT_MS : AKITA_LORA_POLL_INTERVAL_MS;
+        TickType_t wait;
+
+        if (scheduled_ms < wait_ms) {
+            wait_ms = scheduled_ms;
+        }
+
+        wait = pdMS_TO_TICKS(wait_ms);
+        (void) ulTaskNotifyTake(pdTRUE, wait > 0 ? wait : 1);
+        xSemaphoreTake(g_lora_lock, portMAX_DELAY);
+        scheduled_ms = g_lora_ready ? akita_lora_service() : AKITA_AIRTIME_WAIT_NONE;
+        xSemaphoreGive(g_lora_lock);
+    }
+}
+
+static esp_err_t akita_lora_create_runtime(void) {
+    if (g_lora_lock == NULL) {
+        g_lora_lock = xSemaphoreCreateMutex();
+        akita_sx127x_init(&g_lora_radio, akita_lora_transfer, NULL);
+    }
+    if (g_lora_tx_queue == NULL) {
+        g_lora_tx_queue = xQueueCreate(AKITA_LORA_TX_QUEUE_DEPTH, sizeof(akita_lora_tx_request_t));
+    }
+    if (g_lora_rx_queue == NULL) {
+        g_lora_rx_queue = xQueueCreate(AKITA_LORA_RX_QUEUE_DEPTH, sizeof(akita_lora_packet_t));
+    }
+    if (g_lora_lock == NULL || g_lora_tx_queue == NULL || g_lora_rx_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (g_lora_task == NULL &&
+        xTaskCreate(akita_lora_task, "akita_lora", AKITA_LORA_TASK_STACK_SIZE, NULL, AKITA_LORA_TASK_PRIORITY, &g_lora_task) != pdPASS) {
+        g_lora_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+static void akita_lora_release_hardware(void) {
+    esp_err_t err;
+
+    g_lora_ready = false;
+    akita_sx127x_release(&g_lora_radio);
+
+    if (akita_lora_pin_is_valid(g_lora_dio0_pin)) {
+        gpio_intr_disable((gpio_num_t) g_lora_dio0_pin);
+        gpio_isr_handler_remove((gpio_num_t) g_lora_dio0_pin);
+        g_lora_dio0_pin = AKITA_INVALID_PIN;
+    }
+
+    if (g_lora_spi != NULL) {
+        err = spi_bus_remove_device(g_lora_spi);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "LoRa SPI device removal failed: %s", esp_err_to_name(err));
+        }
+        g_lora_spi = NULL;
+    }
+
+    if (g_lora_spi_bus_initialized) {
+        err = spi_bus_free(AKITA_LORA_SPI_HOST);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "LoRa SPI bus free failed: %s", esp_err_to_name(err));
+        }
+        g_lora_spi_bus_initialized = false;
+    }
+
+    if (g_lora_tx_queue != NULL) {
+        xQueueReset(g_lora_tx_queue);
+    }
+    if (g_lora_rx_queue != NULL) {
+        xQueueReset(g_lora_rx_queue);
+    }
+}
+
+static esp_err_t akita_lora_reset(const akita_runtime_config_t *config) {
+    if (!akita_lora_pin_is_valid(config->lora_reset_pin)) {
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_ERROR(gpio_reset_pin((gpio_num_t) config->lora_reset_pin), TAG, "LoRa reset pin reset failed");
+    ESP_RETURN_ON_ERROR(gpio_set_direction((gpio_num_t) config->lora_reset_pin, GPIO_MODE_OUTPUT), TAG, "LoRa reset pin direction failed");
+    ESP_RETURN_ON_ERROR(gpio_set_level((gpio_num_t) config->lora_reset_pin, 0), TAG, "LoRa reset pin assert failed");
+    vTaskDelay(pdMS_TO_TICKS(10));
+    ESP_RETURN_ON_ERROR(gpio_set_level((gpio_num_t) config->lora_reset_pin, 1), TAG, "LoRa reset pin release failed");
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return ESP_OK;
+}
+
+static esp_err_t akita_lora_attach_dio0(int32_t pin) {
+    gpio_config_t io_config = {0};
+    esp_err_t err;
+
+    if (!akita_lora_pin_is_valid(pin)) {
+        ESP_LOGW(TAG, "LoRa DIO0 pin is not configured; polling radio IRQ flags every %d ms", AKITA_LORA_POLL_INTERVAL_MS);
+        return ESP_OK;
+    }
+
+    io_config.pin_bit_mask = 1ULL << (uint32_t) pin;
+    io_config.mode = GPIO_MODE_INPUT;
+    io_config.intr_type = GPIO_INTR_POSEDGE;
+    ESP_RETURN_ON_ERROR(gpio_config(&io_config), TAG, "LoRa DIO0 pin config failed");
+
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+
+    ESP_RETURN_ON_ERROR(gpio_isr_handler_add((gpio_num_t) pin, akita_lora_dio0_isr, NULL), TAG, "LoRa DIO0 ISR attach failed");
+    g_lora_dio0_pin = pin;
+    return ESP_OK;
+}
+
+esp_err_t akita_lora_start(const akita_runtime_config_t *config) {
+    spi_bus_config_t bus_config = {0};
+    spi_device_interface_config_t device_config = {0};
+    esp_err_t ret = ESP_OK;
+
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!akita_lora_pin_is_valid(config->lora_sck_pin) ||
+        !akita_lora_pin_is_valid(config->lora_miso_pin) ||
+        !akita_lora_pin_is_valid(config->lora_mosi_pin) ||
+        !akita_lora_pin_is_valid(config->lora_cs_pin) ||
+        config->lora_frequency_hz == 0U) {
+        ESP_LOGW(TAG, "LoRa transport selected, but pins or frequency are not configured");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_RETURN_ON_ERROR(akita_lora_create_runtime(), TAG, "LoRa task and queue allocation failed");
+
+    xSemaphoreTake(g_lora_lock, portMAX_DELAY);
+    akita_lora_release_hardware();
+
+    bus_config.mosi_io_num = config->lora_mosi_pin;
+    bus_config.miso_io_num = config->lora_miso_pin;
+    bus_config.sclk_io_num = config->lora_sck_pin;
+    bus_config.quadwp_io_num = -1;
+    bus_config.quadhd_io_num = -1;
+    bus_config.max_transfer_sz = AKITA_LORA_MAX_PAYLOAD_LEN + 1U;
+
+    device_config.clock_speed_hz = AKITA_LORA_SPI_CLOCK_HZ;
+    device_config.mode = 0;
+    device_config.spics_io_num = config->lora_cs_pin;
+    device_config.queue_size = 1;
+
+    ESP_GOTO_ON_ERROR(spi_bus_initialize(AKITA_LORA_SPI_HOST, &bus_config, SPI_DMA_CH_AUTO), fail, TAG, "LoRa SPI bus init failed");
+    g_lora_spi_bus_initialized = true;
+    ESP_GOTO_ON_ERROR(spi_bus_add_device(AKITA_LORA_SPI_HOST, &device_config, &g_lora_spi), fail, TAG, "LoRa SPI device add failed");
+    ESP_GOTO_ON_ERROR(akita_lora_reset(config), fail, TAG, "LoRa reset failed");
+    ESP_GOTO_ON_ERROR(akita_sx127x_configure(&g_lora_radio, config), fail, TAG, "LoRa radio configuration failed");
+    ESP_GOTO_ON_ERROR(akita_lora_attach_dio0(config->lora_dio0_pin), fail, TAG, "LoRa DIO0 setup failed");
+
+    g_lora_radio.stats.irq_driven = akita_lora_pin_is_valid(g_lora_dio0_pin);
+    g_lora_ready = true;
+    xSemaphoreGive(g_lora_lock);
+    xTaskNotifyGive(g_lora_task);
+    return ESP_OK;
+
+fail:
+    akita_lora_release_hardware();
+    xSemaphoreGive(g_lora_lock);
+    return ret;
+}
+
+void akita_lora_stop(void) {
+    if (g_lora_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(g_lora_lock, portMAX_DELAY);
+    akita_lora_release_hardware();
+    xSemaphoreGive(g_lora_lock);
+}
+
+bool akita_lora_ready(void) {
+    return g_lora_ready;
+}
+
+esp_err_t akita_lora_send(akita_message_class_t message_class, const uint8_t *payload, size_t payload_len) {
+    akita_lora_tx_request_t request;
+    bool queued;
+
+    if (payload == NULL || payload_len == 0U || message_class >= AKITA_MESSAGE_CLASS_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (payload_len > AKITA_LORA_MAX_PAYLOAD_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (!g_lora_ready || g_lora_tx_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    request.message_class = message_class;
+    request.packet.length = (uint8_t) payload_len;
+    memcpy(request.packet.data, payload, payload_len);
+    queued = xQueueSend(g_lora_tx_queue, &request, 0) == pdTRUE;
+
+    /* The radio task writes the same counters while it services the scheduler. */
+    xSemaphoreTake(g_lora_lock, portMAX_DELAY);
+    if (queued) {
+        ++g_lora_radio.stats.tx_queued;
+    } else {
+        ++g_lora_radio.stats.tx_dropped;
+    }
+    xSemaphoreGive(g_lora_lock);
+    if (!queued) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xTaskNotifyGive(g_lora_task);
+    return ESP_OK;
+}
+
+bool akita_lora_receive(akita_lora_packet_t *packet) {
+    if (packet == NULL || g_lora_rx_queue == NULL) {
+        return false;
+    }
+
+    return xQueueReceive(g_lora_rx_queue, packet, 0) == pdTRUE;
+}
+
+void akita_lora_link_feedback(const akita_link_quality_t *downlink, int8_t uplink_snr_quarter_db) {
+    if (downlink == NULL || g_lora_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(g_lora_lock, portMAX_DELAY);
+    if (akita_sx127x_link_feedback(&g_lora_radio, downlink, uplink_snr_quarter_db) && g_lora_ready) {
+        xTaskNotifyGive(g_lora_task);
+    }
+    xSemaphoreGive(g_lora_lock);
+}
+
+void akita_lora_get_stats(akita_lora_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+
+    if (g_lora_lock == NULL) {
+        *stats = g_lora_radio.stats;
+        return;
+    }
+
+    xSemaphoreTake(g_lora_lock, portMAX_DELAY);
+    akita_sx127x_get_stats(&g_lora_radio, (uint64_t) (esp_timer_get_time() / 1000LL), stats);
+    stats->tx_backlog += g_lora_tx_queue != NULL ? (uint32_t) uxQueueMessagesWaiting(g_lora_tx_queue) : 0U;
+    xSemaphoreGive(g_lora_lock);
+}
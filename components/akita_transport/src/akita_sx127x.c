@@ -0,0 +1,327 @@
+#include "akita_sx127x.h"
+
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+#define AKITA_SX127X_PA_BOOST 0x80
+#define AKITA_SX127X_PA_BOOST_MIN_DBM 2
+#define AKITA_SX127X_MODEM_AGC_AUTO 0x04
+#define AKITA_SX127X_MODEM_LDRO 0x08
+#define AKITA_SX127X_PA_DAC_DISABLE 0x04
+
+static const char *TAG = "akita_sx127x";
+
+static esp_err_t akita_sx127x_write_register(akita_sx127x_t *radio, uint8_t address, uint8_t value) {
+    const uint8_t tx_data[2] = { (uint8_t) (address | 0x80U), value };
+    return radio->transfer(radio->context, tx_data, NULL, sizeof(tx_data));
+}
+
+static esp_err_t akita_sx127x_read_register(akita_sx127x_t *radio, uint8_t address, uint8_t *value) {
+    const uint8_t tx_data[2] = { (uint8_t) (address & 0x7FU), 0x00 };
+    uint8_t rx_data[2] = {0};
+
+    ESP_RETURN_ON_ERROR(radio->transfer(radio->context, tx_data, rx_data, sizeof(tx_data)), TAG, "LoRa register read failed");
+    *value = rx_data[1];
+    return ESP_OK;
+}
+
+static esp_err_t akita_sx127x_write_fifo(akita_sx127x_t *radio, const uint8_t *payload, size_t payload_len) {
+    radio->burst_tx[0] = (uint8_t) (AKITA_SX127X_REG_FIFO | 0x80U);
+    memcpy(radio->burst_tx + 1U, payload, payload_len);
+    return radio->transfer(radio->context, radio->burst_tx, NULL, payload_len + 1U);
+}
+
+static esp_err_t akita_sx127x_read_fifo(akita_sx127x_t *radio, uint8_t *payload, size_t payload_len) {
+    memset(radio->burst_tx, 0, payload_len + 1U);
+    radio->burst_tx[0] = (uint8_t) (AKITA_SX127X_REG_FIFO & 0x7FU);
+    ESP_RETURN_ON_ERROR(
+        radio->transfer(radio->context, radio->burst_tx, radio->burst_rx, payload_len + 1U),
+        TAG,
+        "LoRa FIFO read failed"
+    );
+    memcpy(payload, radio->burst_rx + 1U, payload_len);
+    return ESP_OK;
+}
+
+static esp_err_t akita_sx127x_enter_rx(akita_sx127x_t *radio) {
+    radio->tx_busy = false;
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_DIO_MAPPING_1, AKITA_SX127X_DIO0_RX_DONE), TAG, "LoRa RX DIO mapping failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_IRQ_FLAGS, 0xFF), TAG, "LoRa IRQ clear before RX failed");
+    ESP_RETURN_ON_ERROR(
+        akita_sx127x_write_register(radio, AKITA_SX127X_REG_OP_MODE, AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_RX_CONTINUOUS),
+        TAG,
+        "LoRa RX continuous mode failed"
+    );
+    return ESP_OK;
+}
+
+static esp_err_t akita_sx127x_start_tx(akita_sx127x_t *radio, const akita_airtime_slot_t *slot, int64_t now_us) {
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_OP_MODE, AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_STDBY), TAG, "LoRa standby before TX failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_IRQ_FLAGS, 0xFF), TAG, "LoRa IRQ clear before TX failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_FIFO_ADDR_PTR, 0x00), TAG, "LoRa FIFO pointer reset failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_fifo(radio, slot->data, slot->length), TAG, "LoRa FIFO write failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_PAYLOAD_LENGTH, slot->length), TAG, "LoRa payload length write failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_DIO_MAPPING_1, AKITA_SX127X_DIO0_TX_DONE), TAG, "LoRa TX DIO mapping failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_OP_MODE, AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_TX), TAG, "LoRa TX mode failed");
+
+    radio->tx_busy = true;
+    radio->tx_deadline_us = now_us + (int64_t) slot->airtime_us + ((int64_t) AKITA_SX127X_TX_GRACE_MS * 1000LL);
+    return ESP_OK;
+}
+
+static void akita_sx127x_harvest_rx(akita_sx127x_t *radio, akita_sx127x_receive_t on_receive, void *context) {
+    akita_lora_packet_t packet;
+    uint8_t current_addr = 0;
+    uint8_t byte_count = 0;
+    uint8_t packet_snr = 0;
+    uint8_t packet_rssi = 0;
+
+    if (akita_sx127x_read_register(radio, AKITA_SX127X_REG_FIFO_RX_CURRENT_ADDR, &current_addr) != ESP_OK ||
+        akita_sx127x_read_register(radio, AKITA_SX127X_REG_RX_NB_BYTES, &byte_count) != ESP_OK ||
+        akita_sx127x_read_register(radio, AKITA_SX127X_REG_PKT_SNR_VALUE, &packet_snr) != ESP_OK ||
+        akita_sx127x_read_register(radio, AKITA_SX127X_REG_PKT_RSSI_VALUE, &packet_rssi) != ESP_OK ||
+        byte_count == 0U) {
+        return;
+    }
+
+    packet.link.snr_quarter_db = (int8_t) packet_snr;
+    packet.link.rssi_dbm = (int16_t) ((radio->frequency_hz >= AKITA_SX127X_LF_LIMIT_HZ ? AKITA_SX127X_RSSI_OFFSET_HF : AKITA_SX127X_RSSI_OFFSET_LF) +
+                                      (int16_t) packet_rssi);
+    if (packet.link.snr_quarter_db < 0) {
+        packet.link.rssi_dbm = (int16_t) (packet.link.rssi_dbm + (packet.link.snr_quarter_db / 4));
+    }
+
+    if (akita_sx127x_write_register(radio, AKITA_SX127X_REG_FIFO_ADDR_PTR, current_addr) != ESP_OK ||
+        akita_sx127x_read_fifo(radio, packet.data, byte_count) != ESP_OK) {
+        return;
+    }
+
+    packet.length = byte_count;
+    ++radio->stats.rx_frames;
+    if (on_receive == NULL || !on_receive(context, &packet)) {
+        ++radio->stats.rx_dropped;
+    }
+}
+
+static esp_err_t akita_sx127x_write_modem(akita_sx127x_t *radio, const akita_lora_modem_t *modem, int8_t tx_power_dbm) {
+    uint8_t bandwidth_code = 0;
+    uint8_t modem_config_1;
+    uint8_t modem_config_2;
+    uint8_t modem_config_3;
+    uint8_t pa_config;
+
+    if (!akita_airtime_bandwidth_code(modem->bandwidth_hz, &bandwidth_code) || akita_airtime_us(modem, 1U) == 0U) {
+        ESP_LOGE(TAG, "Unsupported LoRa modem settings SF%u BW %lu Hz CR 4/%u", modem->spreading_factor, (unsigned long) modem->bandwidth_hz, modem->coding_rate);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    modem_config_1 = (uint8_t) ((bandwidth_code << 4) | ((modem->coding_rate - 4U) << 1) | (modem->implicit_header ? 0x01U : 0x00U));
+    modem_config_2 = (uint8_t) ((modem->spreading_factor << 4) | (modem->crc_on ? 0x04U : 0x00U));
+    modem_config_3 = (uint8_t) (AKITA_SX127X_MODEM_AGC_AUTO | (akita_airtime_low_data_rate(modem) ? AKITA_SX127X_MODEM_LDRO : 0x00U));
+    pa_config = (uint8_t) (AKITA_SX127X_PA_BOOST | (uint8_t) (tx_power_dbm - AKITA_SX127X_PA_BOOST_MIN_DBM));
+
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_PA_CONFIG, pa_config), TAG, "LoRa PA config failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_MODEM_CONFIG_1, modem_config_1), TAG, "LoRa modem config1 failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_MODEM_CONFIG_2, modem_config_2), TAG, "LoRa modem config2 failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_MODEM_CONFIG_3, modem_config_3), TAG, "LoRa modem config3 failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_PREAMBLE_MSB, (uint8_t) (modem->preamble_len >> 8)), TAG, "LoRa preamble MSB failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_PREAMBLE_LSB, (uint8_t) modem->preamble_len), TAG, "LoRa preamble LSB failed");
+
+    radio->modem = *modem;
+    radio->tx_power_dbm = tx_power_dbm;
+    akita_airtime_scheduler_configure(&radio->scheduler, radio->region, radio->frequency_hz, modem);
+    return ESP_OK;
+}
+
+static esp_err_t akita_sx127x_set_frequency(akita_sx127x_t *radio, uint32_t frequency_hz) {
+    uint32_t frf_value = (uint32_t) (((double) frequency_hz) / AKITA_SX127X_FREQUENCY_STEP_HZ);
+
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_FRF_MSB, (uint8_t) (frf_value >> 16)), TAG, "LoRa FRF MSB write failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_FRF_MID, (uint8_t) (frf_value >> 8)), TAG, "LoRa FRF MID write failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_FRF_LSB, (uint8_t) frf_value), TAG, "LoRa FRF LSB write failed");
+    return ESP_OK;
+}
+
+static void akita_sx127x_apply_adr(akita_sx127x_t *radio) {
+    akita_lora_modem_t modem = radio->modem;
+    esp_err_t err;
+
+    radio->modem_pending = false;
+    modem.spreading_factor = radio->adr.current.spreading_factor;
+    modem.bandwidth_hz = radio->adr.current.bandwidth_hz;
+
+    err = akita_sx127x_write_register(radio, AKITA_SX127X_REG_OP_MODE, AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_STDBY);
+    if (err == ESP_OK) {
+        err = akita_sx127x_write_modem(radio, &modem, radio->adr.current.tx_power_dbm);
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "LoRa ADR modem update failed: %s", esp_err_to_name(err));
+    } else {
+        ESP_LOGI(
+            TAG,
+            "LoRa ADR moved to SF%u BW %lu Hz at %d dBm",
+            modem.spreading_factor,
+            (unsigned long) modem.bandwidth_hz,
+            radio->adr.current.tx_power_dbm
+        );
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(akita_sx127x_enter_rx(radio));
+}
+
+void akita_sx127x_init(akita_sx127x_t *radio, akita_sx127x_transfer_t transfer, void *context) {
+    if (radio == NULL) {
+        return;
+    }
+
+    memset(radio, 0, sizeof(*radio));
+    radio->transfer = transfer;
+    radio->context = context;
+    akita_airtime_scheduler_init(&radio->scheduler);
+}
+
+esp_err_t akita_sx127x_configure(akita_sx127x_t *radio, const akita_runtime_config_t *config) {
+    akita_adr_setting_t base = {
+        .spreading_factor = config->lora_spreading_factor,
+        .bandwidth_hz = config->lora_bandwidth_hz,
+        .tx_power_dbm = config->lora_tx_power_dbm,
+    };
+    akita_lora_modem_t modem;
+    uint8_t version = 0;
+
+    radio->region = config->lora_region;
+    radio->frequency_hz = config->lora_frequency_hz;
+    radio->adr_enabled = config->lora_adr_enabled;
+    radio->modem_pending = false;
+    akita_adr_init(&radio->adr, &base, akita_airtime_resolve_region(config->lora_region, config->lora_frequency_hz));
+    akita_airtime_modem_from_config(config, &modem);
+
+    ESP_RETURN_ON_ERROR(akita_sx127x_read_register(radio, AKITA_SX127X_REG_VERSION, &version), TAG, "LoRa version read failed");
+
+    if (version == 0x00U || version == 0xFFU) {
+        ESP_LOGE(TAG, "No SX127x radio detected (version 0x%02x)", version);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (version != AKITA_SX127X_EXPECTED_VERSION) {
+        ESP_LOGW(TAG, "Unexpected SX127x version 0x%02x while configuring LoRa transport", version);
+    }
+
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_OP_MODE, AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_SLEEP), TAG, "LoRa sleep mode failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_FIFO_TX_BASE_ADDR, 0x00), TAG, "LoRa TX base setup failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_FIFO_RX_BASE_ADDR, 0x00), TAG, "LoRa RX base setup failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_set_frequency(radio, config->lora_frequency_hz), TAG, "LoRa frequency setup failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_OCP, 0x2B), TAG, "LoRa OCP config failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_LNA, 0x23), TAG, "LoRa LNA config failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_modem(radio, &modem, config->lora_tx_power_dbm), TAG, "LoRa modem setup failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_DETECTION_OPTIMIZE, 0xC3), TAG, "LoRa detect optimize failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_DETECTION_THRESHOLD, 0x0A), TAG, "LoRa detect threshold failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_SYNC_WORD, 0x12), TAG, "LoRa sync word failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_PA_DAC, AKITA_SX127X_PA_DAC_DISABLE), TAG, "LoRa PA DAC failed");
+    ESP_RETURN_ON_ERROR(akita_sx127x_write_register(radio, AKITA_SX127X_REG_OP_MODE, AKITA_SX127X_MODE_LONG_RANGE | AKITA_SX127X_MODE_STDBY), TAG, "LoRa standby mode failed");
+
+    ESP_LOGI(
+        TAG,
+        "LoRa SF%u BW %lu Hz CR 4/%u, region %s, duty cycle %u permille, ADR %s",
+        modem.spreading_factor,
+        (unsigned long) modem.bandwidth_hz,
+        modem.coding_rate,
+        akita_airtime_region_name(radio->scheduler.region),
+        radio->scheduler.band->duty_cycle_permille,
+        radio->adr_enabled ? "on" : "off"
+    );
+    return akita_sx127x_enter_rx(radio);
+}
+
+void akita_sx127x_release(akita_sx127x_t *radio) {
+    /* Queued frames are discarded, but airtime history survives a restart. */
+    radio->tx_busy = false;
+    radio->scheduler.slot_count = 0;
+}
+
+uint32_t akita_sx127x_service(akita_sx127x_t *radio, int64_t now_us, akita_sx127x_receive_t on_receive, void *context) {
+    akita_airtime_slot_t slot;
+    uint64_t now_ms = (uint64_t) (now_us / 1000LL);
+    uint32_t wait_ms = AKITA_AIRTIME_WAIT_NONE;
+    uint8_t irq_flags = 0;
+
+    if (akita_sx127x_read_register(radio, AKITA_SX127X_REG_IRQ_FLAGS, &irq_flags) != ESP_OK) {
+        return wait_ms;
+    }
+
+    if (irq_flags != 0U) {
+        (void) akita_sx127x_write_register(radio, AKITA_SX127X_REG_IRQ_FLAGS, irq_flags);
+    }
+
+    if (radio->tx_busy && (irq_flags & AKITA_SX127X_IRQ_TX_DONE) != 0U) {
+        ++radio->stats.tx_done;
+        ESP_ERROR_CHECK_WITHOUT_ABORT(akita_sx127x_enter_rx(radio));
+    } else if (radio->tx_busy && now_us >= radio->tx_deadline_us) {
+        ++radio->stats.tx_timeouts;
+        ESP_LOGW(TAG, "LoRa TX did not complete within %d ms of its expected airtime", AKITA_SX127X_TX_GRACE_MS);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(akita_sx127x_enter_rx(radio));
+    }
+
+    if (!radio->tx_busy && (irq_flags & AKITA_SX127X_IRQ_RX_DONE) != 0U) {
+        if ((irq_flags & AKITA_SX127X_IRQ_PAYLOAD_CRC_ERROR) != 0U) {
+            ++radio->stats.rx_crc_errors;
+        } else {
+            akita_sx127x_harvest_rx(radio, on_receive, context);
+        }
+    }
+
+    if (!radio->tx_busy && radio->modem_pending) {
+        akita_sx127x_apply_adr(radio);
+    }
+
+    if (!radio->tx_busy && akita_airtime_scheduler_next(&radio->scheduler, now_ms, &slot, &wait_ms)) {
+        if (akita_sx127x_start_tx(radio, &slot, now_us) != ESP_OK) {
+            ++radio->stats.tx_errors;
+            ESP_ERROR_CHECK_WITHOUT_ABORT(akita_sx127x_enter_rx(radio));
+        } else {
+            akita_airtime_scheduler_commit(&radio->scheduler, now_ms, slot.airtime_us);
+            if (radio->adr_enabled && akita_adr_on_uplink(&radio->adr)) {
+                radio->modem_pending = true;
+            }
+        }
+    }
+
+    return wait_ms;
+}
+
+bool akita_sx127x_link_feedback(akita_sx127x_t *radio, const akita_link_quality_t *downlink, int8_t uplink_snr_quarter_db) {
+    int8_t snr_quarter_db = uplink_snr_quarter_db != AKITA_LORA_SNR_UNKNOWN ? uplink_snr_quarter_db : downlink->snr_quarter_db;
+
+    radio->last_link = *downlink;
+    if (radio->adr_enabled && akita_adr_on_feedback(&radio->adr, snr_quarter_db)) {
+        radio->modem_pending = true;
+    }
+    return radio->modem_pending;
+}
+
+void akita_sx127x_get_stats(akita_sx127x_t *radio, uint64_t now_ms, akita_lora_stats_t *stats) {
+    const akita_airtime_counters_t *counters = &radio->scheduler.counters;
+    uint64_t used_us = akita_airtime_scheduler_used_us(&radio->scheduler, now_ms);
+    uint64_t budget_us = akita_airtime_scheduler_budget_us(&radio->scheduler);
+
+    *stats = radio->stats;
+    stats->tx_dropped += counters->dropped_budget + counters->dropped_overflow + counters->dropped_stale;
+    stats->tx_deferred = counters->deferred;
+    stats->tx_coalesced = counters->coalesced;
+    stats->tx_backlog = (uint32_t) radio->scheduler.slot_count;
+    stats->max_frame_len = (uint8_t) akita_airtime_max_payload(&radio->modem, radio->scheduler.band->dwell_limit_us);
+    stats->airtime_used_ms = (uint32_t) (used_us / 1000U);
+    stats->airtime_remaining_ms = budget_us > used_us ? (uint32_t) ((budget_us - used_us) / 1000U) : 0U;
+    stats->airtime_total_ms = (uint32_t) (radio->scheduler.total_airtime_us / 1000U);
+    stats->duty_cycle_permille = radio->scheduler.band->duty_cycle_permille;
+    stats->region = radio->scheduler.region;
+    stats->spreading_factor = radio->modem.spreading_factor;
+    stats->bandwidth_hz = radio->modem.bandwidth_hz;
+    stats->tx_power_dbm = radio->tx_power_dbm;
+    stats->last_link = radio->last_link;
+    stats->adr_steps_faster = radio->adr.steps_faster;
+    stats->adr_steps_slower = radio->adr.steps_slower;
+    stats->adr_enabled = radio->adr_enabled;
+}
@@ -0,0 +1,394 @@
+#include "akita_transport.h"
+
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "akita_bridge.h"
+#include "akita_metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define AKITA_TRANSPORT_HTTP_TIMEOUT_MS 8000
+#define AKITA_TRANSPORT_HTTP_HOST_MAX_LEN 80
+#define AKITA_TRANSPORT_HTTP_HEADER_MAX_LEN 256
+#define AKITA_TRANSPORT_BRIDGE_MODE_MAX_LEN 16
+#define AKITA_TRANSPORT_BRIDGE_ERROR_MAX_LEN 64
+#define AKITA_TRANSPORT_RNS_PING_INTERVAL_MS 5000U
+
+/*
+ * The host's network stands in for the WiFi link: it is always up, so the IP endpoints behave as they do on a
+ * node with a station connection. There is no radio, so LoRa and the gateway report themselves unavailable.
+ */
+static const char *TAG = "akita_transport";
+static bool g_rns_bridge_ready;
+static bool g_transport_ready;
+static bool g_wifi_transport_enabled;
+static uint32_t g_rns_bridge_sequence;
+static akita_transport_endpoint_t g_endpoint_type;
+static char g_rns_bridge_mode[AKITA_TRANSPORT_BRIDGE_MODE_MAX_LEN] = "inactive";
+static char g_rns_bridge_last_error[AKITA_TRANSPORT_BRIDGE_ERROR_MAX_LEN];
+static SemaphoreHandle_t g_transport_lock;
+static uint64_t g_rns_next_ping_ms;
+static akita_link_scheduler_t g_link_scheduler;
+
+static void akita_transport_copy_string(char *destination, size_t destination_size, const char *source) {
+    if (destination == NULL || destination_size == 0U) {
+        return;
+    }
+
+    snprintf(destination, destination_size, "%s", source != NULL ? source : "");
+}
+
+static uint64_t akita_transport_now_ms(void) {
+    return (uint64_t) (esp_timer_get_time() / 1000ULL);
+}
+
+static void akita_transport_lock(void) {
+    if (g_transport_lock == NULL) {
+        g_transport_lock = xSemaphoreCreateMutex();
+    }
+    if (g_transport_lock != NULL) {
+        xSemaphoreTake(g_transport_lock, portMAX_DELAY);
+    }
+}
+
+static void akita_transport_unlock(void) {
+    if (g_transport_lock != NULL) {
+        xSemaphoreGive(g_transport_lock);
+    }
+}
+
+static bool akita_transport_wifi_ready(void) {
+    if (g_endpoint_type == AKITA_TRANSPORT_ENDPOINT_RNS_UDP) {
+        return g_wifi_transport_enabled && g_rns_bridge_ready;
+    }
+
+    return g_wifi_transport_enabled && g_endpoint_type != AKITA_TRANSPORT_ENDPOINT_NONE;
+}
+
+static void akita_transport_set_rns_bridge_state(bool ready, const char *mode, const char *last_error) {
+    g_rns_bridge_ready = ready;
+    akita_transport_copy_string(g_rns_bridge_mode, sizeof(g_rns_bridge_mode), mode);
+    akita_transport_copy_string(g_rns_bridge_last_error, sizeof(g_rns_bridge_last_error), last_error);
+    g_transport_ready = akita_transport_wifi_ready();
+}
+
+/* Plain HTTP/1.0 POST; the node's TLS stack is not part of this build, so https endpoints are refused. */
+static esp_err_t akita_transport_publish_http(const char *endpoint, const char *payload) {
+    struct addrinfo hints = {0};
+    struct addrinfo *result = NULL;
+    struct timeval timeout = {
+        .tv_sec = AKITA_TRANSPORT_HTTP_TIMEOUT_MS / 1000,
+        .tv_usec = (AKITA_TRANSPORT_HTTP_TIMEOUT_MS % 1000) * 1000,
+    };
+    char host[AKITA_TRANSPORT_HTTP_HOST_MAX_LEN];
+    char header[AKITA_TRANSPORT_HTTP_HEADER_MAX_LEN];
+    char status_line[32] = "";
+    const char *authority;
+    const char *path;
+    const char *port;
+    size_t payload_len = strlen(payload);
+    size_t host_len;
+    int socket_fd;
+    int status_code = 0;
+    int written;
+    ssize_t received;
+
+    if (strncasecmp(endpoint, "http://", 7) != 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    authority = endpoint + 7;
+    path = strchr(authority, '/');
+    host_len = path != NULL ? (size_t) (path - authority) : strlen(authority);
+    if (host_len == 0U || host_len >= sizeof(host)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(host, authority, host_len);
+    host[host_len] = '\0';
+    if (path == NULL) {
+        path = "/";
+    }
+
+    written = snprintf(
+        header,
+        sizeof(header),
+        "POST %s HTTP/1.0\r\nHost: %s\r\nContent-Type: application/json\r\nUser-Agent: akita-carnode/linux\r\n"
+        "Content-Length: %u\r\n\r\n",
+        path,
+        host,
+        (unsigned) payload_len
+    );
+    if (written < 0 || (size_t) written >= sizeof(header)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    port = strrchr(host, ':');
+    if (port != NULL) {
+        host[port - host] = '\0';
+        ++port;
+    } else {
+        port = "80";
+    }
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &result) != 0 || result == NULL) {
+        return ESP_FAIL;
+    }
+
+    socket_fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (socket_fd < 0) {
+        freeaddrinfo(result);
+        return ESP_FAIL;
+    }
+
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        connect(socket_fd, result->ai_addr, result->ai_addrlen) != 0 ||
+        send(socket_fd, header, (size_t) written, 0) != written ||
+        send(socket_fd, payload, payload_len, 0) != (ssize_t) payload_len) {
+        freeaddrinfo(result);
+        close(socket_fd);
+        return ESP_FAIL;
+    }
+    freeaddrinfo(result);
+
+    received = recv(socket_fd, status_line, sizeof(status_line) - 1U, 0);
+    close(socket_fd);
+    if (received <= 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    status_line[received] = '\0';
+    if (sscanf(status_line, "HTTP/%*s %d", &status_code) != 1 || status_code < 200 || status_code >= 300) {
+        ESP_LOGW(TAG, "HTTP uplink returned status %d", status_code);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t akita_transport_exchange_rns(const akita_runtime_config_t *config, const char *kind, const char *payload,
+                                              const char *default_mode) {
+    char response[AKITA_BRIDGE_RNS_RESPONSE_MAX_LEN];
+    char message[AKITA_TRANSPORT_BRIDGE_ERROR_MAX_LEN];
+    char mode[AKITA_TRANSPORT_BRIDGE_MODE_MAX_LEN];
+    esp_err_t err;
+
+    err = akita_bridge_exchange_rns(config, kind, payload, ++g_rns_bridge_sequence, response, sizeof(response));
+    if (err != ESP_OK) {
+        akita_transport_set_rns_bridge_state(false, "error", esp_err_to_name(err));
+        return err;
+    }
+
+    if (!akita_bridge_rns_response_ok(response)) {
+        if (!akita_bridge_json_extract_string(response, "message", message, sizeof(message))) {
+            akita_transport_copy_string(message, sizeof(message), "bridge_error");
+        }
+        ESP_LOGW(TAG, "Reticulum bridge answered %s with: %s", kind, response);
+        akita_transport_set_rns_bridge_state(false, "error", message);
+        return ESP_FAIL;
+    }
+
+    if (!akita_bridge_json_extract_string(response, "mode", mode, sizeof(mode))) {
+        akita_transport_copy_string(mode, sizeof(mode), default_mode);
+    }
+    akita_transport_set_rns_bridge_state(true, mode, "");
+    return ESP_OK;
+}
+
+static void akita_transport_record_link(size_t payload_len, esp_err_t result, uint32_t latency_ms) {
+    akita_transport_lock();
+    akita_link_record(&g_link_scheduler, AKITA_LINK_WIFI, payload_len, result == ESP_OK, latency_ms, akita_transport_now_ms());
+    akita_transport_unlock();
+}
+
+esp_err_t akita_transport_init(const akita_runtime_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    akita_transport_lock();
+    akita_link_scheduler_init(&g_link_scheduler);
+    akita_transport_unlock();
+
+    g_endpoint_type = akita_bridge_endpoint_type(config->telemetry_endpoint);
+    g_wifi_transport_enabled = config->transport_mode == AKITA_TRANSPORT_WIFI || config->transport_mode == AKITA_TRANSPORT_AUTO;
+    g_rns_next_ping_ms = 0;
+    akita_transport_set_rns_bridge_state(false, g_endpoint_type == AKITA_TRANSPORT_ENDPOINT_RNS_UDP ? "waiting" : "inactive", "");
+
+    if (config->transport_mode == AKITA_TRANSPORT_NONE) {
+        ESP_LOGI(TAG, "Transport disabled; telemetry will stay local");
+        return ESP_OK;
+    }
+    if (!g_wifi_transport_enabled) {
+        ESP_LOGW(TAG, "LoRa is not available on the Linux target");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (g_endpoint_type == AKITA_TRANSPORT_ENDPOINT_NONE) {
+        ESP_LOGW(TAG, "Unsupported telemetry endpoint: %s", config->telemetry_endpoint);
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Publishing telemetry to %s over the host network", config->telemetry_endpoint);
+    return ESP_OK;
+}
+
+esp_err_t akita_transport_publish(const akita_runtime_config_t *config, const char *payload) {
+    akita_transport_endpoint_t endpoint_type;
+    int64_t started_us;
+    esp_err_t err;
+
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->transport_mode != AKITA_TRANSPORT_WIFI && config->transport_mode != AKITA_TRANSPORT_AUTO) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    endpoint_type = akita_bridge_endpoint_type(config->telemetry_endpoint);
+    if (endpoint_type == AKITA_TRANSPORT_ENDPOINT_NONE) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (payload == NULL || payload[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_endpoint_type = endpoint_type;
+
+    started_us = esp_timer_get_time();
+    AKITA_METRIC_BEGIN(span);
+    switch (endpoint_type) {
+        case AKITA_TRANSPORT_ENDPOINT_HTTP:
+            err = akita_transport_publish_http(config->telemetry_endpoint, payload);
+            AKITA_METRIC_END(span, AKITA_METRIC_PUBLISH_HTTP, err == ESP_OK);
+            break;
+        case AKITA_TRANSPORT_ENDPOINT_UDP:
+            err = akita_bridge_publish_udp(config->telemetry_endpoint, payload);
+            AKITA_METRIC_END(span, AKITA_METRIC_PUBLISH_UDP, err == ESP_OK);
+            break;
+        case AKITA_TRANSPORT_ENDPOINT_RNS_UDP:
+            err = akita_transport_exchange_rns(config, "telemetry", payload, "ok");
+            AKITA_METRIC_END(span, AKITA_METRIC_PUBLISH_RNS_UDP, err == ESP_OK);
+            break;
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    akita_transport_record_link(strlen(payload), err, (uint32_t) ((esp_timer_get_time() - started_us) / 1000));
+    return err;
+}
+
+esp_err_t akita_transport_publish_frame(
+    const akita_runtime_config_t *config,
+    akita_message_class_t message_class,
+    const uint8_t *frame,
+    size_t frame_len
+) {
+    (void) config;
+    (void) message_class;
+    (void) frame;
+    (void) frame_len;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+akita_link_id_t akita_transport_select_link(
+    const akita_runtime_config_t *config,
+    akita_message_class_t message_class,
+    const size_t payload_len[AKITA_LINK_COUNT],
+    uint8_t exclude_mask
+) {
+    akita_link_id_t link;
+
+    if (config == NULL || payload_len == NULL) {
+        return AKITA_LINK_NONE;
+    }
+
+    if (config->transport_mode == AKITA_TRANSPORT_WIFI) {
+        return (payload_len[AKITA_LINK_WIFI] > 0U && (exclude_mask & (1U << AKITA_LINK_WIFI)) == 0U) ? AKITA_LINK_WIFI
+                                                                                                     : AKITA_LINK_NONE;
+    }
+    if (config->transport_mode != AKITA_TRANSPORT_AUTO) {
+        return AKITA_LINK_NONE;
+    }
+
+    akita_transport_lock();
+    akita_link_set_up(&g_link_scheduler, AKITA_LINK_WIFI, akita_transport_wifi_ready(), 0U);
+    akita_link_set_up(&g_link_scheduler, AKITA_LINK_LORA, false, 0U);
+    link = akita_link_select(&g_link_scheduler, message_class, payload_len, exclude_mask, akita_transport_now_ms());
+    akita_transport_unlock();
+    return link;
+}
+
+size_t akita_transport_take_frame(uint8_t *buffer, size_t buffer_size, akita_link_quality_t *link) {
+    (void) buffer;
+    (void) buffer_size;
+    (void) link;
+    return 0;
+}
+
+void akita_transport_report_link(const akita_link_quality_t *link, int8_t uplink_snr_quarter_db) {
+    (void) link;
+    (void) uplink_snr_quarter_db;
+}
+
+bool akita_transport_ready(void) {
+    return g_transport_ready;
+}
+
+void akita_transport_poll(const akita_runtime_config_t *config) {
+    uint64_t now_ms = akita_transport_now_ms();
+    esp_err_t err;
+
+    if (config != NULL && g_wifi_transport_enabled && g_endpoint_type == AKITA_TRANSPORT_ENDPOINT_RNS_UDP &&
+        now_ms >= g_rns_next_ping_ms) {
+        err = akita_transport_exchange_rns(config, "ping", NULL, "bridge_ready");
+        g_rns_next_ping_ms = now_ms + (err == ESP_OK ? (AKITA_TRANSPORT_RNS_PING_INTERVAL_MS * 3U)
+                                                    : AKITA_TRANSPORT_RNS_PING_INTERVAL_MS);
+    }
+}
+
+void akita_transport_get_status(akita_transport_status_t *status) {
+    if (status == NULL) {
+        return;
+    }
+
+    akita_transport_lock();
+    memset(status, 0, sizeof(*status));
+    status->transport_ready = g_transport_ready;
+    status->bridge_ready = g_rns_bridge_ready;
+    status->wifi_connected = g_wifi_transport_enabled;
+    akita_link_set_up(&g_link_scheduler, AKITA_LINK_WIFI, akita_transport_wifi_ready(), 0U);
+    status->active_link = g_link_scheduler.active;
+    status->link_switchovers = g_link_scheduler.switchovers;
+    status->links[AKITA_LINK_WIFI] = g_link_scheduler.links[AKITA_LINK_WIFI].stats;
+    status->links[AKITA_LINK_LORA] = g_link_scheduler.links[AKITA_LINK_LORA].stats;
+    akita_transport_copy_string(status->bridge_mode, sizeof(status->bridge_mode), g_rns_bridge_mode);
+    akita_transport_copy_string(status->bridge_last_error, sizeof(status->bridge_last_error), g_rns_bridge_last_error);
+    akita_transport_unlock();
+}
+
+const char *akita_transport_name(const akita_runtime_config_t *config) {
+    if (config == NULL) {
+        return "unknown";
+    }
+
+    switch (config->transport_mode) {
+        case AKITA_TRANSPORT_WIFI:
+            return "wifi";
+        case AKITA_TRANSPORT_LORA:
+            return "lora";
+        case AKITA_TRANSPORT_AUTO:
+            return "auto";
+        default:
+            return "none";
+    }
+}
@@ -2,10 +2,29 @@
 #include "esp_log.h"
 #include "akita_app.h"
 #include "nvs_flash.h"
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <stdio.h>
+
+#include "esp_private/partition_linux.h"
+#endif
 
 static const char *TAG = "akita_main";
 
+#if CONFIG_IDF_TARGET_LINUX
+/* Keeps the emulated flash in a named file so configuration and trips survive between runs. */
+static void akita_use_flash_file(void) {
+    esp_partition_file_mmap_ctrl_t *flash = esp_partition_get_file_mmap_ctrl_input();
+
+    snprintf(flash->flash_file_name, sizeof(flash->flash_file_name), "%s", CONFIG_AKITA_LINUX_FLASH_PATH);
+    flash->remove_dump = false;
+}
+#endif
+
 void app_main(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    akita_use_flash_file();
+#endif
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
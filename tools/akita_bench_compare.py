@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import sys
+from pathlib import Path
+
+
+SUITES = ("akita_micro_bench", "akita_capture_replay")
+
+
+def load(path: Path) -> dict:
+    """Returns the cases of an akita_micro_bench or akita_capture_replay result by name."""
+    result = json.loads(path.read_text(encoding="utf-8"))
+    if result.get("suite") not in SUITES:
+        raise ValueError(f"{path}: not an akita_micro_bench or akita_capture_replay result")
+    return {case["name"]: case for case in result["cases"]}
+
+
+def compare(baseline: dict, current: dict, max_slowdown: float, max_stack_growth: int) -> tuple[list[str], list[str]]:
+    """Returns a report line per case and the cases that regressed."""
+    lines = []
+    regressions = []
+    for name, case in current.items():
+        before = baseline.get(name)
+        if before is None:
+            lines.append(f"{name:24} {case['ns_per_op']:10.1f} ns/op  new")
+            continue
+        ratio = case["ns_per_op"] / before["ns_per_op"] if before["ns_per_op"] > 0 else 1.0
+        stack_growth = case.get("stack_bytes", 0) - before.get("stack_bytes", 0)
+        slow = ratio > 1.0 + max_slowdown
+        deep = stack_growth > max_stack_growth
+        # The same capture must parse to the same fixes and readings on every build.
+        changed = "digest" in case and "digest" in before and case["digest"] != before["digest"]
+        lines.append(
+            f"{name:24} {before['ns_per_op']:10.1f} -> {case['ns_per_op']:10.1f} ns/op ({ratio - 1.0:+.1%})"
+            f"  stack {before.get('stack_bytes', 0)} -> {case.get('stack_bytes', 0)}"
+            f"{'  OUTPUT CHANGED' if changed else ''}{'  REGRESSED' if slow or deep or changed else ''}"
+        )
+        if slow or deep or changed:
+            regressions.append(name)
+    for name in baseline.keys() - current.keys():
+        lines.append(f"{name:24} missing from the current run")
+        regressions.append(name)
+    return lines, regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare two akita_micro_bench or akita_capture_replay JSON results")
+    parser.add_argument("baseline", type=Path)
+    parser.add_argument("current", type=Path)
+    parser.add_argument("--max-slowdown", type=float, default=0.10, help="Allowed ns/op increase as a fraction (default 0.10)")
+    parser.add_argument("--max-stack-growth", type=int, default=0, help="Allowed stack growth in bytes (default 0)")
+    args = parser.parse_args()
+
+    try:
+        lines, regressions = compare(load(args.baseline), load(args.current), args.max_slowdown, args.max_stack_growth)
+    except (OSError, ValueError, KeyError) as error:
+        print(error, file=sys.stderr)
+        return 2
+
+    print("\n".join(lines))
+    if regressions:
+        print(f"regressed: {', '.join(regressions)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
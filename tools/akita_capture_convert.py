@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import struct
+import sys
+import urllib.request
+from pathlib import Path
+
+
+# Mirrors components/akita_common/include/akita_capture.h.
+CAPTURE_MAGIC = b"AKCP"
+CAPTURE_VERSION = 1
+CAPTURE_END = 0xFF
+SOURCE_MASK = 0x0F
+FLAG_FORCE = 0x10
+GPS_UART, GPS_PPS, OBD_TX, OBD_RX = range(1, 5)
+SOURCE_NAMES = {GPS_UART: "gps_uart", GPS_PPS: "gps_pps", OBD_TX: "obd_tx", OBD_RX: "obd_rx"}
+
+HEADER = struct.Struct("<4sHHQI")
+
+
+def _varint(data: bytes, offset: int) -> tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+        if shift >= 64:
+            raise ValueError("capture varint too long")
+
+
+def parse(data: bytes) -> tuple[dict, list[dict]]:
+    """Returns the header and every whole record; a record cut short ends the list like erased flash does."""
+    if len(data) < HEADER.size:
+        raise ValueError("capture is truncated")
+    magic, version, _, start_us, gps_baud = HEADER.unpack_from(data)
+    if magic != CAPTURE_MAGIC:
+        raise ValueError("not an akita capture")
+    if version != CAPTURE_VERSION:
+        raise ValueError(f"unsupported capture version {version}")
+
+    records = []
+    offset = HEADER.size
+    at_us = start_us
+    while offset < len(data) and data[offset] != CAPTURE_END:
+        tag = data[offset]
+        try:
+            zigzag, cursor = _varint(data, offset + 1)
+            length, cursor = _varint(data, cursor)
+        except IndexError:
+            break
+        if cursor + length > len(data):
+            break
+        at_us += (zigzag >> 1) ^ -(zigzag & 1)
+        records.append({"source": tag & SOURCE_MASK, "flags": tag & ~SOURCE_MASK & 0xFF, "at_us": at_us, "data": data[cursor : cursor + length]})
+        offset = cursor + length
+    return {"start_us": start_us, "gps_baud": gps_baud, "length": offset}, records
+
+
+def summarize(header: dict, records: list[dict]) -> dict:
+    sources = {name: {"records": 0, "bytes": 0} for name in SOURCE_NAMES.values()}
+    for record in records:
+        entry = sources.setdefault(SOURCE_NAMES.get(record["source"], f"source_{record['source']}"), {"records": 0, "bytes": 0})
+        entry["records"] += 1
+        entry["bytes"] += len(record["data"])
+    last_us = max((record["at_us"] for record in records), default=header["start_us"])
+    return {
+        "gps_baud": header["gps_baud"],
+        "records": len(records),
+        "bytes": header["length"],
+        "span_s": round((last_us - header["start_us"]) / 1e6, 3),
+        "sources": sources,
+    }
+
+
+def to_nmea(records: list[dict]) -> bytes:
+    """The GPS bytes as the UART delivered them, for the NMEA corpus or the Linux GPS source."""
+    return b"".join(record["data"] for record in records if record["source"] == GPS_UART)
+
+
+def _exchange(command: str, reply: bytes) -> str:
+    return command + "\t" + reply.decode("ascii", "replace").replace("\r", "\\r")
+
+
+def to_elm(records: list[dict]) -> str:
+    """The ELM327 exchanges in the corpus format: command, a tab, then the reply with \\r written out."""
+    lines = ["# ELM327 exchanges from a capture: command<TAB>adapter reply with \\r written out."]
+    command = None
+    reply = b""
+    for record in records:
+        if record["source"] == OBD_TX:
+            if command is not None:
+                lines.append(_exchange(command, reply))
+            command = record["data"].decode("ascii", "replace").strip()
+            reply = b""
+        elif record["source"] == OBD_RX and command is not None:
+            reply += record["data"]
+    if command is not None:
+        lines.append(_exchange(command, reply))
+    return "\n".join(lines) + "\n"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Summarize a CarNode capture or extract its GPS and OBD streams")
+    parser.add_argument("input", nargs="?", type=Path, help="Capture from GET /api/capture")
+    parser.add_argument("--fetch", metavar="URL", help="GET the capture from a node, e.g. http://192.168.4.1/api/capture")
+    parser.add_argument("--save", type=Path, help="Write the fetched capture to this file")
+    parser.add_argument("--nmea", type=Path, help="Write the GPS bytes to this file")
+    parser.add_argument("--elm", type=Path, help="Write the ELM327 exchanges to this file")
+    args = parser.parse_args()
+
+    if args.fetch:
+        with urllib.request.urlopen(args.fetch, timeout=60) as response:
+            data = response.read()
+    elif args.input:
+        data = args.input.read_bytes()
+    else:
+        parser.error("give a capture file or --fetch")
+
+    try:
+        header, records = parse(data)
+    except ValueError as error:
+        print(f"{args.fetch or args.input}: {error}", file=sys.stderr)
+        return 1
+
+    if args.save:
+        args.save.write_bytes(data[: header["length"]])
+    if args.nmea:
+        args.nmea.write_bytes(to_nmea(records))
+    if args.elm:
+        args.elm.write_text(to_elm(records), encoding="utf-8")
+    print(json.dumps(summarize(header, records), indent=2))
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
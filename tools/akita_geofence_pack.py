@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import struct
+import sys
+import urllib.request
+import zlib
+from pathlib import Path
+
+
+# Mirrors components/akita_core/include/akita_geofence.h.
+GEOFENCE_MAGIC = 0x46474B41
+GEOFENCE_VERSION = 1
+GEOFENCE_MAX_FENCES = 1024
+GEOFENCE_MAX_VERTICES = 64
+GEOFENCE_FLAG_ALERT = 0x01
+GEOFENCE_PARTITION_SIZE = 0x10000
+
+HEADER = struct.Struct("<IHHIIII")
+RECORD = struct.Struct("<IiiiiIHHBBH")
+VERTEX = struct.Struct("<HH")
+
+
+def _ring(feature: dict) -> list[tuple[int, int]]:
+    geometry = feature.get("geometry") or {}
+    if geometry.get("type") != "Polygon":
+        raise ValueError("geofences must be GeoJSON Polygons")
+    rings = geometry.get("coordinates") or []
+    if len(rings) != 1:
+        raise ValueError("geofence polygons cannot have holes")
+
+    points = [(round(lat * 1e6), round(lon * 1e6)) for lon, lat, *_ in rings[0]]
+    if len(points) > 1 and points[0] == points[-1]:
+        points.pop()
+    if not 3 <= len(points) <= GEOFENCE_MAX_VERTICES:
+        raise ValueError(f"geofences need 3 to {GEOFENCE_MAX_VERTICES} corners, got {len(points)}")
+    return points
+
+
+def pack_geofences(collection: dict) -> bytes:
+    features = collection.get("features") or []
+    if len(features) > GEOFENCE_MAX_FENCES:
+        raise ValueError(f"at most {GEOFENCE_MAX_FENCES} geofences fit the index")
+
+    records = []
+    vertices = []
+    for feature in features:
+        properties = feature.get("properties") or {}
+        fence_id = int(properties.get("id", 0))
+        if not 0 < fence_id < 1 << 32:
+            raise ValueError("every geofence needs a non-zero 32 bit id")
+        points = _ring(feature)
+
+        min_lat = min(lat for lat, _ in points)
+        max_lat = max(lat for lat, _ in points)
+        min_lon = min(lon for _, lon in points)
+        max_lon = max(lon for _, lon in points)
+        shift = 0
+        while (max_lat - min_lat) >> shift > 0xFFFF or (max_lon - min_lon) >> shift > 0xFFFF:
+            shift += 1
+
+        flags = GEOFENCE_FLAG_ALERT if properties.get("alert") else 0
+        records.append(
+            RECORD.pack(
+                fence_id,
+                min_lat,
+                min_lon,
+                max_lat,
+                max_lon,
+                len(vertices),
+                len(points),
+                int(properties.get("dwell_s", 0)),
+                flags,
+                shift,
+                0,
+            )
+        )
+        vertices.extend(VERTEX.pack((lat - min_lat) >> shift, (lon - min_lon) >> shift) for lat, lon in points)
+
+    body = b"".join(records) + b"".join(vertices)
+    size = HEADER.size + len(body)
+    if size > GEOFENCE_PARTITION_SIZE:
+        raise ValueError(f"image is {size} bytes; the geofence partition holds {GEOFENCE_PARTITION_SIZE}")
+    header = HEADER.pack(GEOFENCE_MAGIC, GEOFENCE_VERSION, len(records), len(vertices), size, zlib.crc32(body), 0)
+    return header + body
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Pack GeoJSON polygons into a CarNode geofence image")
+    parser.add_argument("geojson", type=Path, help="FeatureCollection of Polygons with id, and optional dwell_s and alert")
+    parser.add_argument("--output", type=Path, help="Write the image to this file")
+    parser.add_argument("--upload", metavar="URL", help="POST the image to a node, e.g. http://192.168.4.1/api/geofences")
+    args = parser.parse_args()
+
+    try:
+        image = pack_geofences(json.loads(args.geojson.read_text(encoding="utf-8")))
+    except (OSError, ValueError) as error:
+        print(f"{args.geojson}: {error}", file=sys.stderr)
+        return 1
+
+    if args.output:
+        args.output.write_bytes(image)
+    if args.upload:
+        request = urllib.request.Request(
+            args.upload, data=image, method="POST", headers={"Content-Type": "application/octet-stream"}
+        )
+        with urllib.request.urlopen(request, timeout=30) as response:
+            print(response.read().decode("utf-8", "replace"))
+    if not args.output and not args.upload:
+        print(f"{len(image)} byte image, {len(image) * 100 // GEOFENCE_PARTITION_SIZE}% of the partition")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
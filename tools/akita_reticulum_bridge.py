@@ -5,13 +5,48 @@ import json
 import socket
 import string
 import sys
+import threading
 import time
 from pathlib import Path
 
+from akita_telemetry_schema import TELEMETRY_FIELDS
+
 
 BRIDGE_PROTOCOL = "akita-rns-udp-v2"
 SUPPORTED_BRIDGE_PROTOCOLS = {"akita-rns-udp-v1", BRIDGE_PROTOCOL}
 
+FRAME_VERSION = 1
+FRAME_HEADER_LEN = 4
+FRAME_TYPE_MASK = 0x07
+FRAME_ACK_REQUEST = 0x08
+FRAME_TYPE_KEYFRAME = 0
+FRAME_TYPE_DELTA = 1
+FRAME_TYPE_ACK = 2
+FRAME_TYPE_FRAGMENT = 3
+FRAME_TYPE_NACK = 4
+FRAME_TYPE_EVENT = 5
+FRAME_EVENT_HAS_VALUE = 0x80
+FRAME_EVENT_NODE = 0
+FRAME_EVENT_RULE = 1
+FRAME_EVENT_GEOFENCE = 2
+# Keyframes kept per node; the firmware only builds deltas against one this recent (AKITA_FRAME_KEYFRAME_HISTORY).
+FRAME_KEYFRAME_HISTORY = 4
+FRAGMENT_HEADER_LEN = FRAME_HEADER_LEN + 2
+FRAGMENT_MAX_MESSAGE_LEN = 1024
+FRAGMENT_TIMEOUT_SECONDS = 20.0
+BRIDGE_DATAGRAM_MAX_LEN = 2048
+FRAME_FIELD_COUNT = 1 + max(field["wire"] for field in TELEMETRY_FIELDS if field["frame"] != "flag")
+BOARD_NAMES = {
+    0: "Generic ESP32-S3",
+    1: "Generic ESP32-C6",
+    2: "Generic ESP32-C5",
+    3: "Heltec LoRa 32 V2",
+}
+# Same layout as the firmware's status histograms: bucket k counts latencies below 2^(k + 4) us.
+LATENCY_BUCKETS = 24
+LATENCY_BUCKET_SHIFT = 4
+LATENCY_STAGES = ("sample", "queue", "node_to_bridge", "bridge", "delivery")
+
 
 def load_rns(reticulum_path: str | None):
     if reticulum_path:
@@ -30,6 +65,269 @@ def load_rns(reticulum_path: str | None):
         raise
 
 
+def read_varint(frame: bytes, offset: int) -> tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(frame) or shift > 63:
+            raise ValueError("Truncated varint in telemetry frame")
+        byte = frame[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, offset
+        shift += 7
+
+
+def unzigzag(value: int) -> int:
+    return (value >> 1) ^ -(value & 1)
+
+
+class AkitaFrameDecoder:
+    """Decodes binary LoRa telemetry frames back into the firmware JSON payload shape."""
+
+    def __init__(self):
+        self.keyframes = {}
+
+    @staticmethod
+    def frame_type(frame: bytes) -> int:
+        if len(frame) < FRAME_HEADER_LEN:
+            raise ValueError("Telemetry frame is shorter than its header")
+        if (frame[0] >> 4) != FRAME_VERSION:
+            raise ValueError(f"Unsupported telemetry frame version {frame[0] >> 4}")
+        return frame[0] & FRAME_TYPE_MASK
+
+    @staticmethod
+    def node_tag(frame: bytes) -> int:
+        return frame[1] | (frame[2] << 8)
+
+    def decode(self, frame: bytes) -> dict:
+        frame_type = self.frame_type(frame)
+        node_tag = self.node_tag(frame)
+        sequence = frame[3]
+
+        if frame_type == FRAME_TYPE_KEYFRAME:
+            if len(frame) < FRAME_HEADER_LEN + 2:
+                raise ValueError("Truncated keyframe")
+            board = frame[4]
+            id_len = frame[5]
+            offset = 6 + id_len
+            if offset > len(frame):
+                raise ValueError("Truncated keyframe vehicle ID")
+            vehicle_id = frame[6:offset].decode("utf-8", errors="replace")
+            timestamp_ms, offset = read_varint(frame, offset)
+            values = [0] * FRAME_FIELD_COUNT
+            for index in range(FRAME_FIELD_COUNT):
+                if offset >= len(frame):
+                    raise ValueError(f"Keyframe ends after {index} of {FRAME_FIELD_COUNT} fields")
+                raw, offset = read_varint(frame, offset)
+                values[index] = unzigzag(raw)
+            history = self.keyframes.setdefault(node_tag, {})
+            history.pop(sequence, None)
+            if len(history) >= FRAME_KEYFRAME_HISTORY:
+                del history[next(iter(history))]
+            history[sequence] = {
+                "board": board,
+                "vehicle_id": vehicle_id,
+                "timestamp_ms": timestamp_ms,
+                "values": values,
+            }
+            return self.payload(vehicle_id, board, timestamp_ms, values)
+
+        if frame_type == FRAME_TYPE_DELTA:
+            if len(frame) < FRAME_HEADER_LEN + 1:
+                raise ValueError("Truncated delta frame")
+            reference = self.keyframes.get(node_tag, {}).get(frame[4])
+            if reference is None:
+                raise ValueError(
+                    f"Delta frame from node {node_tag:04x} references unknown keyframe {frame[4]}"
+                )
+            mask, offset = read_varint(frame, 5)
+            elapsed_ms, offset = read_varint(frame, offset)
+            values = list(reference["values"])
+            for index in range(FRAME_FIELD_COUNT):
+                if mask & (1 << index):
+                    raw, offset = read_varint(frame, offset)
+                    values[index] += unzigzag(raw)
+            return self.payload(
+                reference["vehicle_id"],
+                reference["board"],
+                reference["timestamp_ms"] + elapsed_ms,
+                values,
+            )
+
+        if frame_type == FRAME_TYPE_EVENT:
+            if len(frame) < FRAME_HEADER_LEN + 1:
+                raise ValueError("Truncated event frame")
+            reference = self.keyframes.get(node_tag, {}).get(frame[4])
+            if reference is None:
+                raise ValueError(
+                    f"Event frame from node {node_tag:04x} references unknown keyframe {frame[4]}"
+                )
+            elapsed_ms, offset = read_varint(frame, 5)
+            if offset + 2 > len(frame):
+                raise ValueError("Truncated event frame")
+            source = frame[offset] & ~FRAME_EVENT_HAS_VALUE
+            has_value = bool(frame[offset] & FRAME_EVENT_HAS_VALUE)
+            event_id, offset = read_varint(frame, offset + 2)
+            value = None
+            if has_value:
+                raw, offset = read_varint(frame, offset)
+                value = unzigzag(raw) / 100
+            if offset >= len(frame) or offset + 1 + frame[offset] > len(frame):
+                raise ValueError("Truncated event frame name")
+            name = frame[offset + 1 : offset + 1 + frame[offset]].decode("utf-8", errors="replace")
+            payload = self.payload(
+                reference["vehicle_id"],
+                reference["board"],
+                reference["timestamp_ms"] + elapsed_ms,
+                reference["values"],
+            )
+            payload["event"] = name
+            if source == FRAME_EVENT_GEOFENCE:
+                payload["geofence"] = {"id": event_id, "inside_ms": round(value * 1000) if value is not None else 0}
+            else:
+                if value is not None:
+                    payload["event_value"] = value
+                if source == FRAME_EVENT_RULE:
+                    payload["rule_id"] = event_id
+            return payload
+
+        raise ValueError(f"Telemetry frame type {frame_type} does not carry telemetry")
+
+    @staticmethod
+    def field_value(field: dict, raw: int):
+        if field["frame"] == "scale":
+            return raw / field["frame_param"]
+        if field["frame"] == "div":
+            return raw * field["frame_param"]
+        return raw
+
+    @classmethod
+    def payload(cls, vehicle_id: str, board: int, timestamp_ms: int, values: list[int]) -> dict:
+        payload = {
+            "node_id": vehicle_id,
+            "timestamp_ms": timestamp_ms,
+            "board": BOARD_NAMES.get(board, "Unknown board"),
+        }
+        for field in TELEMETRY_FIELDS:
+            if field["frame"] == "flag":
+                value = bool(values[0] & (1 << field["wire"]))
+            else:
+                value = cls.field_value(field, values[field["wire"]])
+            payload.setdefault(field["group"], {})[field["name"]] = value
+        return payload
+
+
+class AkitaFragmentReassembler:
+    """Rebuilds fragmented LoRa messages and names the fragments still missing."""
+
+    def __init__(self, timeout_seconds: float = FRAGMENT_TIMEOUT_SECONDS, clock=time.monotonic):
+        self.timeout_seconds = timeout_seconds
+        self.clock = clock
+        self.pending = {}
+        self.completed = {}
+
+    def expire(self, now: float):
+        for table in (self.pending, self.completed):
+            for key in [key for key, entry in table.items() if now - entry["updated"] >= self.timeout_seconds]:
+                del table[key]
+
+    def push(self, frame: bytes) -> tuple[bytes | None, list[int], bytes | None]:
+        """Returns the reassembled message (or None), the missing fragment indices, and a NACK frame if one is due."""
+        if len(frame) <= FRAGMENT_HEADER_LEN:
+            raise ValueError("Truncated fragment frame")
+        index = frame[4] >> 4
+        count = (frame[4] & 0x0F) + 1
+        chunk_len = frame[5]
+        data = frame[FRAGMENT_HEADER_LEN:]
+        if index >= count or chunk_len == 0 or len(data) > chunk_len or (index + 1 < count and len(data) != chunk_len):
+            raise ValueError("Malformed fragment frame")
+        if index * chunk_len + len(data) > FRAGMENT_MAX_MESSAGE_LEN:
+            raise ValueError("Fragmented message exceeds the maximum message length")
+
+        now = self.clock()
+        self.expire(now)
+        key = (AkitaFrameDecoder.node_tag(frame), frame[3])
+        if key in self.completed:
+            self.completed[key]["updated"] = now
+            return None, [], None
+
+        entry = self.pending.get(key)
+        if entry is None or entry["count"] != count or entry["chunk_len"] != chunk_len:
+            entry = {"count": count, "chunk_len": chunk_len, "parts": {}}
+            self.pending[key] = entry
+        entry["updated"] = now
+        entry["parts"][index] = data
+
+        if len(entry["parts"]) == count:
+            del self.pending[key]
+            self.completed[key] = {"updated": now}
+            return b"".join(entry["parts"][part] for part in range(count)), [], None
+
+        # Fragments go out back to back, so a gap below the newest index is a loss.
+        newest = max(entry["parts"])
+        missing = [part for part in range(count) if part not in entry["parts"]]
+        lost = [part for part in missing if part < newest]
+        if index + 1 == count:
+            lost = missing
+        if not lost:
+            return None, missing, None
+        mask = sum(1 << part for part in lost)
+        nack = bytes(
+            [
+                (FRAME_VERSION << 4) | FRAME_TYPE_NACK,
+                frame[1],
+                frame[2],
+                frame[3],
+                mask & 0xFF,
+                mask >> 8,
+            ]
+        )
+        return None, missing, nack
+
+
+class LatencyHistogram:
+    def __init__(self):
+        self.count = 0
+        self.total_us = 0
+        self.max_us = 0
+        self.buckets = [0] * LATENCY_BUCKETS
+
+    def add(self, latency_us: int):
+        latency_us = max(0, int(latency_us))
+        bucket = min(LATENCY_BUCKETS - 1, (latency_us >> LATENCY_BUCKET_SHIFT).bit_length())
+        self.count += 1
+        self.total_us += latency_us
+        self.max_us = max(self.max_us, latency_us)
+        self.buckets[bucket] += 1
+
+    def percentile(self, percent: int) -> int:
+        if self.count == 0:
+            return 0
+        target = (self.count * percent + 99) // 100
+        seen = 0
+        for bucket, count in enumerate(self.buckets):
+            seen += count
+            if count and seen >= target:
+                return min(1 << (bucket + LATENCY_BUCKET_SHIFT), self.max_us)
+        return self.max_us
+
+    def report(self) -> dict:
+        last = len(self.buckets)
+        while last > 0 and self.buckets[last - 1] == 0:
+            last -= 1
+        return {
+            "n": self.count,
+            "mean_us": self.total_us // self.count if self.count else 0,
+            "p50_us": self.percentile(50),
+            "p90_us": self.percentile(90),
+            "p99_us": self.percentile(99),
+            "max_us": self.max_us,
+            "buckets": self.buckets[:last],
+        }
+
+
 class AkitaReticulumBridge:
     def __init__(
         self,
@@ -64,6 +362,12 @@ class AkitaReticulumBridge:
             self.app_name,
             *self.aspects,
         )
+        self.frame_decoder = AkitaFrameDecoder()
+        self.fragment_reassembler = AkitaFragmentReassembler()
+        # Receipts are proven on Reticulum's own threads, so the histograms are shared with them.
+        self.latency_lock = threading.Lock()
+        self.latency = {stage: LatencyHistogram() for stage in LATENCY_STAGES}
+        self.received_at = (time.time(), time.monotonic())
 
     def log(self, message: str, level=None):
         if level is None:
@@ -118,6 +422,38 @@ class AkitaReticulumBridge:
             *self.aspects,
         )
 
+    def record_latency(self, stage: str, latency_us):
+        with self.latency_lock:
+            self.latency[stage].add(latency_us)
+
+    def latency_report(self) -> dict:
+        with self.latency_lock:
+            return {stage: histogram.report() for stage, histogram in self.latency.items()}
+
+    def trace_payload(self, payload_value):
+        """Adds the node's own stages, and its hop to the bridge when the node clock is on UTC."""
+        if not isinstance(payload_value, dict) or not isinstance(payload_value.get("trace"), dict):
+            return
+        trace = payload_value["trace"]
+        try:
+            acquired_ms = int(trace["acquired_ms"])
+            queued_ms = int(trace["queued_ms"])
+            encoded_ms = int(trace["encoded_ms"])
+        except (KeyError, TypeError, ValueError):
+            return
+        self.record_latency("sample", (queued_ms - acquired_ms) * 1000)
+        self.record_latency("queue", (encoded_ms - queued_ms) * 1000)
+        if "utc_ms" in payload_value:
+            self.record_latency("node_to_bridge", self.received_at[0] * 1e6 - encoded_ms * 1000)
+
+    def packet_sent(self, receipt):
+        sent = time.monotonic()
+        self.record_latency("bridge", (sent - self.received_at[1]) * 1e6)
+        if receipt is not None and hasattr(receipt, "set_delivery_callback"):
+            receipt.set_delivery_callback(
+                lambda _receipt: self.record_latency("delivery", (time.monotonic() - sent) * 1e6)
+            )
+
     def payload_bytes(self, payload_value) -> bytes:
         return json.dumps(payload_value, separators=(",", ":")).encode("utf-8")
 
@@ -138,6 +474,7 @@ class AkitaReticulumBridge:
                 receipt = self.rns.Packet(destination, payload).send()
                 if receipt is None:
                     raise RuntimeError("Packet send did not return a receipt")
+                self.packet_sent(receipt)
                 return destination, attempt
             except Exception as exc:
                 last_error = exc
@@ -180,9 +517,13 @@ class AkitaReticulumBridge:
         request = str(envelope.get("kind", "telemetry") or "telemetry")
         sequence = envelope.get("sequence")
 
+        self.received_at = (time.time(), time.monotonic())
         if bridge_protocol not in SUPPORTED_BRIDGE_PROTOCOLS:
             raise ValueError("Unsupported bridge envelope")
 
+        if request == "report":
+            return self.bridge_response("ok", request, sequence=sequence, mode="latency", latency=self.latency_report())
+
         if request == "ping":
             return self.bridge_response(
                 "ok",
@@ -193,13 +534,109 @@ class AkitaReticulumBridge:
                 aspects=self.aspects,
             )
 
+        if request == "frame":
+            frame_hex = str(envelope.get("frame", "") or "")
+            try:
+                frame = bytes.fromhex(frame_hex)
+            except ValueError as exc:
+                raise ValueError("Frame envelope must carry a hex-encoded frame") from exc
+            if AkitaFrameDecoder.frame_type(frame) != FRAME_TYPE_FRAGMENT:
+                return self.forward_payload(
+                    envelope,
+                    request,
+                    sequence,
+                    self.frame_decoder.decode(frame),
+                    frame_bytes=len(frame),
+                )
+
+            message, missing, nack = self.fragment_reassembler.push(frame)
+            if message is None:
+                fields = {"mode": "fragment_pending" if missing else "fragment_duplicate", "missing": missing}
+                if nack is not None:
+                    fields["nack"] = nack.hex()
+                return self.bridge_response("ok", request, sequence=sequence, **fields)
+            if message[:1] == b"{":
+                payload_value = json.loads(message.decode("utf-8"))
+            else:
+                payload_value = self.frame_decoder.decode(message)
+            return self.forward_payload(
+                envelope,
+                request,
+                sequence,
+                payload_value,
+                frame_bytes=len(message),
+                fragments=(frame[4] & 0x0F) + 1,
+            )
+
+        if request == "frames":
+            return self.handle_gateway_batch(envelope, request, sequence)
+
         if request != "telemetry":
             raise ValueError(f"Unsupported bridge request type: {request}")
 
+        return self.forward_payload(envelope, request, sequence, envelope.get("payload"))
+
+    def handle_gateway_batch(self, envelope: dict, request: str, sequence) -> dict:
+        """Forwards frames a LoRa gateway heard and returns the ACK/NACK frames it should transmit."""
+        batch = envelope.get("payload")
+        if not isinstance(batch, dict) or not isinstance(batch.get("frames"), list):
+            raise ValueError("Gateway envelope must carry a frames list")
+        gateway = str(batch.get("gateway", "") or "")
+        forwarded = 0
+        pending = 0
+        errors = 0
+        downlinks = []
+
+        for entry in batch["frames"]:
+            try:
+                frame = bytes.fromhex(str(entry.get("frame", "") or ""))
+                link = {"gateway": gateway, "rssi": entry.get("rssi"), "snr": entry.get("snr_qdb", 0) / 4}
+                frame_type = AkitaFrameDecoder.frame_type(frame)
+                if frame_type == FRAME_TYPE_FRAGMENT:
+                    message, _, nack = self.fragment_reassembler.push(frame)
+                    if nack is not None:
+                        downlinks.append(nack.hex())
+                    if message is None:
+                        pending += 1
+                        continue
+                    payload_value = (
+                        json.loads(message.decode("utf-8")) if message[:1] == b"{" else self.frame_decoder.decode(message)
+                    )
+                elif frame_type in (FRAME_TYPE_KEYFRAME, FRAME_TYPE_DELTA, FRAME_TYPE_EVENT):
+                    payload_value = self.frame_decoder.decode(frame)
+                    if frame_type == FRAME_TYPE_KEYFRAME and frame[0] & FRAME_ACK_REQUEST:
+                        # Echo the uplink SNR so the node's ADR sees this gateway's link margin.
+                        snr_qdb = int(entry.get("snr_qdb", 0))
+                        ack = bytes([(FRAME_VERSION << 4) | FRAME_TYPE_ACK, frame[1], frame[2], frame[3], snr_qdb & 0xFF])
+                        downlinks.append(ack.hex())
+                else:
+                    # ACKs and NACKs between other nodes are not telemetry.
+                    continue
+                if isinstance(payload_value, dict):
+                    payload_value["link"] = link
+                self.forward_payload(envelope, request, sequence, payload_value)
+                forwarded += 1
+            except Exception as exc:
+                errors += 1
+                self.log(f"Gateway {gateway or 'unknown'} frame rejected: {exc}", self.rns.LOG_WARNING)
+
+        return self.bridge_response(
+            "ok",
+            request,
+            sequence=sequence,
+            mode="gateway",
+            forwarded=forwarded,
+            pending=pending,
+            errors=errors,
+            downlinks=downlinks,
+        )
+
+    def forward_payload(self, envelope: dict, request: str, sequence, payload_value, **extra) -> dict:
         destination_hash = self.validate_destination(
             str(envelope.get("destination", self.default_destination) or self.default_destination)
         )
-        payload = self.payload_bytes(envelope.get("payload"))
+        payload = self.payload_bytes(payload_value)
+        self.trace_payload(payload_value)
 
         if destination_hash:
             destination, attempts = self.deliver_directed(destination_hash, payload)
@@ -215,9 +652,10 @@ class AkitaReticulumBridge:
                 destination=destination.hexhash,
                 bytes=len(payload),
                 attempts=attempts,
+                **extra,
             )
 
-        self.rns.Packet(self.broadcast_destination, payload).send()
+        self.packet_sent(self.rns.Packet(self.broadcast_destination, payload).send())
         self.log(
             f"Broadcast {len(payload)} bytes on {self.rns.prettyhexrep(self.broadcast_destination.hash)}",
             self.rns.LOG_INFO,
@@ -229,6 +667,7 @@ class AkitaReticulumBridge:
             mode="broadcast",
             destination=self.broadcast_destination.hexhash,
             bytes=len(payload),
+            **extra,
         )
 
 
@@ -336,7 +775,7 @@ def main() -> int:
         address = None
         envelope = None
         try:
-            data, address = sock.recvfrom(4096)
+            data, address = sock.recvfrom(BRIDGE_DATAGRAM_MAX_LEN)
             envelope = json.loads(data.decode("utf-8"))
             if not isinstance(envelope, dict):
                 raise ValueError("Bridge envelope must be a JSON object")
@@ -344,6 +783,10 @@ def main() -> int:
             sock.sendto(json.dumps(response, separators=(",", ":")).encode("utf-8"), address)
         except KeyboardInterrupt:
             print("")
+            bridge.log(
+                "Latency report " + json.dumps(bridge.latency_report(), separators=(",", ":")),
+                bridge.rns.LOG_INFO,
+            )
             return 0
         except Exception as exc:
             source = "unknown peer"
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+
+import argparse
+import re
+import sys
+from pathlib import Path
+
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+SCHEMA_HEADER = REPO_ROOT / "components" / "akita_common" / "include" / "akita_telemetry_schema.h"
+SCHEMA_MODULE = Path(__file__).resolve().parent / "akita_telemetry_schema.py"
+
+FIELD_PATTERN = re.compile(
+    r"X\(\s*(?P<group>\w+)\s*,\s*(?P<id>\w+)\s*,\s*\"(?P<name>[^\"]*)\"\s*,\s*\"(?P<short_key>[^\"]*)\"\s*,"
+    r"\s*(?P<type>\w+)\s*,\s*(?P<decimals>\d+)\s*,\s*(?P<frame>\w+)\(\s*(?P<wire>\d+)\s*(?:,\s*(?P<param>\d+)\s*)?\)\s*,"
+    r"\s*(?P<member>[\w.]+)\s*\)"
+)
+
+
+def parse_schema(header_text: str) -> list[dict]:
+    fields = []
+    for match in FIELD_PATTERN.finditer(header_text):
+        fields.append(
+            {
+                "group": match.group("group").lower(),
+                "id": match.group("id"),
+                "name": match.group("name"),
+                "short_key": match.group("short_key"),
+                "type": match.group("type").lower(),
+                "decimals": int(match.group("decimals")),
+                "frame": match.group("frame").lower(),
+                "wire": int(match.group("wire")),
+                "frame_param": int(match.group("param") or 1),
+                "member": match.group("member"),
+            }
+        )
+
+    if not fields:
+        raise ValueError("No telemetry fields found in schema header")
+    seen = {("field", 0): "FLAGS"}
+    for field in fields:
+        key = ("flag" if field["frame"] == "flag" else "field", field["wire"])
+        if key in seen:
+            raise ValueError(f"{field['id']} reuses frame {key[0]} {key[1]} of {seen[key]}")
+        seen[key] = field["id"]
+    return fields
+
+
+def render_module(fields: list[dict]) -> str:
+    lines = [
+        "# Generated by tools/akita_schema_gen.py from",
+        "# components/akita_common/include/akita_telemetry_schema.h. Do not edit.",
+        "",
+        "TELEMETRY_FIELDS = (",
+    ]
+    for field in fields:
+        entries = ", ".join(f"{key!r}: {value!r}" for key, value in field.items())
+        lines.append(f"    {{{entries}}},")
+    lines.append(")")
+    return "\n".join(lines).replace("'", '"') + "\n"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Generate the bridge telemetry decoder spec from the firmware schema")
+    parser.add_argument("--check", action="store_true", help="Fail if the generated module is out of date")
+    args = parser.parse_args()
+
+    rendered = render_module(parse_schema(SCHEMA_HEADER.read_text(encoding="utf-8")))
+    current = SCHEMA_MODULE.read_text(encoding="utf-8") if SCHEMA_MODULE.exists() else ""
+
+    if args.check:
+        if rendered != current:
+            print(f"{SCHEMA_MODULE.name} is out of date; run {Path(__file__).name}", file=sys.stderr)
+            return 1
+        return 0
+
+    if rendered != current:
+        SCHEMA_MODULE.write_text(rendered, encoding="utf-8")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,21 @@
+# Generated by tools/akita_schema_gen.py from
+# components/akita_common/include/akita_telemetry_schema.h. Do not edit.
+
+TELEMETRY_FIELDS = (
+    {"group": "obd", "id": "OBD_CONNECTED", "name": "connected", "short_key": "c", "type": "bool", "decimals": 0, "frame": "flag", "wire": 0, "frame_param": 1, "member": "obd.connected"},
+    {"group": "obd", "id": "OBD_RPM", "name": "rpm", "short_key": "r", "type": "fixed", "decimals": 1, "frame": "scale", "wire": 1, "frame_param": 4, "member": "obd.rpm"},
+    {"group": "obd", "id": "OBD_SPEED", "name": "speed_kmh", "short_key": "s", "type": "fixed", "decimals": 1, "frame": "scale", "wire": 2, "frame_param": 1, "member": "obd.speed_kmh"},
+    {"group": "obd", "id": "OBD_COOLANT", "name": "coolant_c", "short_key": "k", "type": "fixed", "decimals": 1, "frame": "scale", "wire": 3, "frame_param": 1, "member": "obd.coolant_c"},
+    {"group": "gps", "id": "GPS_FIX", "name": "fix", "short_key": "f", "type": "bool", "decimals": 0, "frame": "flag", "wire": 1, "frame_param": 1, "member": "gps.fix"},
+    {"group": "gps", "id": "GPS_LAT", "name": "lat", "short_key": "la", "type": "fixed", "decimals": 6, "frame": "scale", "wire": 4, "frame_param": 1000000, "member": "gps.latitude"},
+    {"group": "gps", "id": "GPS_LON", "name": "lon", "short_key": "lo", "type": "fixed", "decimals": 6, "frame": "scale", "wire": 5, "frame_param": 1000000, "member": "gps.longitude"},
+    {"group": "gps", "id": "GPS_ALT", "name": "alt_m", "short_key": "", "type": "fixed", "decimals": 1, "frame": "scale", "wire": 6, "frame_param": 10, "member": "gps.altitude_m"},
+    {"group": "gps", "id": "GPS_SPEED", "name": "speed_kmh", "short_key": "v", "type": "fixed", "decimals": 1, "frame": "scale", "wire": 7, "frame_param": 10, "member": "gps.speed_kmh"},
+    {"group": "gps", "id": "GPS_SATS", "name": "sats", "short_key": "s", "type": "uint", "decimals": 0, "frame": "raw", "wire": 8, "frame_param": 1, "member": "gps.satellites"},
+    {"group": "system", "id": "CONFIG_PORTAL_READY", "name": "config_portal_ready", "short_key": "", "type": "bool", "decimals": 0, "frame": "flag", "wire": 2, "frame_param": 1, "member": "system.config_portal_ready"},
+    {"group": "system", "id": "TRANSPORT_READY", "name": "transport_ready", "short_key": "", "type": "bool", "decimals": 0, "frame": "flag", "wire": 3, "frame_param": 1, "member": "system.transport_ready"},
+    {"group": "system", "id": "WIFI_READY", "name": "wifi_ready", "short_key": "", "type": "bool", "decimals": 0, "frame": "flag", "wire": 4, "frame_param": 1, "member": "system.wifi_ready"},
+    {"group": "system", "id": "LORA_READY", "name": "lora_ready", "short_key": "", "type": "bool", "decimals": 0, "frame": "flag", "wire": 5, "frame_param": 1, "member": "system.lora_ready"},
+    {"group": "system", "id": "WIFI_RSSI", "name": "wifi_rssi", "short_key": "q", "type": "int", "decimals": 0, "frame": "raw", "wire": 9, "frame_param": 1, "member": "system.wifi_rssi"},
+    {"group": "system", "id": "FREE_HEAP", "name": "free_heap", "short_key": "h", "type": "uint", "decimals": 0, "frame": "div", "wire": 10, "frame_param": 1024, "member": "system.free_heap"},
+)
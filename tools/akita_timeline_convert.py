@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import re
+import struct
+import sys
+import urllib.request
+from pathlib import Path
+
+
+# Mirrors components/akita_common/include/akita_timeline.h.
+TIMELINE_MAGIC = b"AKTL"
+TIMELINE_VERSION = 1
+TIMELINE_FLAG_TRIGGER = 0x01
+TYPE_BEGIN, TYPE_END, TYPE_COMPLETE, TYPE_INSTANT, TYPE_COUNTER, TYPE_SYNC = range(6)
+
+HEADER = struct.Struct("<4sHHIIHH")
+CORE = struct.Struct("<HHI")
+EVENT = struct.Struct("<IIiHBB")
+
+_PHASES = {TYPE_BEGIN: "B", TYPE_END: "E", TYPE_COMPLETE: "X", TYPE_INSTANT: "i", TYPE_COUNTER: "C"}
+_LOG_LINE = re.compile(r"akita-timeline: (begin|end|[0-9a-f]+)\s*$")
+
+
+def dump_from_log(text: str) -> bytes:
+    """Returns the last complete dump printed on the console."""
+    dump = None
+    lines = None
+    for line in text.splitlines():
+        match = _LOG_LINE.search(line)
+        if not match:
+            continue
+        if match.group(1) == "begin":
+            lines = []
+        elif match.group(1) == "end":
+            if lines is not None:
+                dump = bytes.fromhex("".join(lines))
+            lines = None
+        elif lines is not None:
+            lines.append(match.group(1))
+    if dump is None:
+        raise ValueError("no complete akita-timeline dump in the log")
+    return dump
+
+
+def _string(data: bytes, offset: int) -> tuple[str, int]:
+    length = data[offset]
+    return data[offset + 1 : offset + 1 + length].decode("utf-8", "replace"), offset + 1 + length
+
+
+def convert(data: bytes) -> dict:
+    if len(data) < HEADER.size:
+        raise ValueError("timeline dump is truncated")
+    magic, version, cores, cycles_per_us, _, name_count, task_count = HEADER.unpack_from(data)
+    if magic != TIMELINE_MAGIC:
+        raise ValueError("not an akita timeline dump")
+    if version != TIMELINE_VERSION:
+        raise ValueError(f"unsupported timeline version {version}")
+    if cycles_per_us == 0:
+        raise ValueError("timeline dump has no cycle rate")
+
+    try:
+        offset = HEADER.size
+        names = []
+        for _ in range(name_count):
+            name, offset = _string(data, offset)
+            names.append(name)
+        tasks = {}
+        for _ in range(task_count):
+            (handle,) = struct.unpack_from("<I", data, offset)
+            name, offset = _string(data, offset + 4)
+            if handle:
+                tasks[handle] = name
+
+        events = []
+        threads = {}
+        for _ in range(cores):
+            core, _, count = CORE.unpack_from(data, offset)
+            offset += CORE.size
+            sync = None
+            for cycles, task, value, name_id, kind, flags in EVENT.iter_unpack(data[offset : offset + count * EVENT.size]):
+                if kind == TYPE_SYNC:
+                    sync = ((task << 32) | (value & 0xFFFFFFFF), cycles)
+                    continue
+                # Cycle counts only mean something next to a sync point from the same core.
+                if sync is None or kind not in _PHASES:
+                    continue
+                delta = ((cycles - sync[1] + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+                tid = task or core
+                threads.setdefault(tid, tasks.get(task, f"core {core}"))
+                event = {
+                    "name": names[name_id] if name_id < len(names) else f"event_{name_id}",
+                    "ph": _PHASES[kind],
+                    "ts": sync[0] + delta / cycles_per_us,
+                    "pid": 1,
+                    "tid": tid,
+                }
+                if kind == TYPE_COUNTER:
+                    event["args"] = {"value": value}
+                elif kind == TYPE_COMPLETE:
+                    event["dur"] = (value & 0xFFFFFFFF) / cycles_per_us
+                    event["args"] = {"core": core}
+                elif kind == TYPE_INSTANT:
+                    event["s"] = "g" if flags & TIMELINE_FLAG_TRIGGER else "t"
+                    event["args"] = {"core": core, "value": value}
+                else:
+                    event["args"] = {"core": core}
+                events.append(event)
+            offset += count * EVENT.size
+    except (IndexError, struct.error) as error:
+        raise ValueError("timeline dump is truncated") from error
+    if offset > len(data):
+        raise ValueError("timeline dump is truncated")
+
+    events.sort(key=lambda event: event["ts"])
+    metadata = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "akita-carnode"}}]
+    metadata += [
+        {"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}} for tid, name in sorted(threads.items())
+    ]
+    return {"traceEvents": metadata + events, "displayTimeUnit": "ms"}
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Convert a CarNode timeline dump to Chrome trace JSON for Perfetto")
+    parser.add_argument("input", nargs="?", type=Path, help="Binary dump from GET /api/trace, or a console log")
+    parser.add_argument("--fetch", metavar="URL", help="GET the dump from a node, e.g. http://192.168.4.1/api/trace")
+    parser.add_argument("--output", type=Path, help="Write the trace JSON to this file instead of stdout")
+    args = parser.parse_args()
+
+    if args.fetch:
+        with urllib.request.urlopen(args.fetch, timeout=30) as response:
+            data = response.read()
+    elif args.input:
+        data = args.input.read_bytes()
+    else:
+        parser.error("give a dump file or --fetch")
+
+    try:
+        if not data.startswith(TIMELINE_MAGIC):
+            data = dump_from_log(data.decode("utf-8", "replace"))
+        trace = convert(data)
+    except ValueError as error:
+        print(f"{args.fetch or args.input}: {error}", file=sys.stderr)
+        return 1
+
+    text = json.dumps(trace)
+    if args.output:
+        args.output.write_text(text, encoding="utf-8")
+    else:
+        print(text)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
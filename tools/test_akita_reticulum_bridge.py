@@ -1,10 +1,30 @@
 #!/usr/bin/env python3
 
 import json
+import time
 import unittest
+import zlib
 from unittest.mock import patch
 
-from akita_reticulum_bridge import BRIDGE_PROTOCOL, AkitaReticulumBridge
+import akita_bench_compare
+import akita_capture_convert
+import akita_geofence_pack
+import akita_schema_gen
+import akita_timeline_convert
+from akita_reticulum_bridge import (
+    BRIDGE_PROTOCOL,
+    AkitaFragmentReassembler,
+    AkitaFrameDecoder,
+    AkitaReticulumBridge,
+    FRAME_KEYFRAME_HISTORY,
+)
+from akita_telemetry_schema import TELEMETRY_FIELDS
+
+KEYFRAME_HEX = "1810e200030c416b6974614361724e6f6465c0c40756e43200b001b8cfa82bc9b09848fe0a081200a802"
+DELTA_HEX = "1110e20100b6099e4eee596cb4128c22ac0803"
+SECOND_DELTA_HEX = "1110e20200fe09c29c019c637a04a22b885134c00903"
+# Rule 2 ("coolant_hot" at 104.5) fired 250 ms after KEYFRAME_HEX; bench/frame_check.c pins the same bytes.
+EVENT_HEX = "1510e20100fa01810002a4a3010b636f6f6c616e745f686f74"
 
 
 class FakePacket:
@@ -16,6 +36,23 @@ class FakePacket:
         return object()
 
 
+class FakeReceipt:
+    def __init__(self):
+        self.callback = None
+
+    def set_delivery_callback(self, callback):
+        self.callback = callback
+
+
+class FakeReceiptPacket(FakePacket):
+    receipts = []
+
+    def send(self):
+        receipt = FakeReceipt()
+        FakeReceiptPacket.receipts.append(receipt)
+        return receipt
+
+
 class FakeDestination:
     IN = "in"
     OUT = "out"
@@ -34,6 +71,7 @@ class FakeDestination:
 
 class FakeRNS:
     LOG_INFO = 3
+    LOG_WARNING = 2
     LOG_ERROR = 1
 
     class Reticulum:
@@ -84,6 +122,15 @@ class FakeRNS:
         return value.hex()
 
 
+def fragment_frames(message: bytes, chunk_len: int, message_id: int = 7) -> list[str]:
+    count = (len(message) + chunk_len - 1) // chunk_len
+    return [
+        (bytes([0x13, 0x10, 0xE2, message_id, (index << 4) | (count - 1), chunk_len])
+         + message[index * chunk_len:(index + 1) * chunk_len]).hex()
+        for index in range(count)
+    ]
+
+
 def make_bridge(**overrides):
     FakeRNS.Transport.paths = set()
     kwargs = dict(
@@ -166,11 +213,506 @@ class BridgeTests(unittest.TestCase):
         self.assertEqual(response["mode"], "directed")
         self.assertEqual(response["attempts"], 1)
 
+    def test_report_carries_trace_stages(self):
+        bridge = make_bridge()
+        encoded_ms = int(time.time() * 1000) - 40
+        bridge.handle_envelope(
+            {
+                "bridge": BRIDGE_PROTOCOL,
+                "kind": "telemetry",
+                "payload": {
+                    "utc_ms": encoded_ms - 60,
+                    "trace": {"id": 1, "acquired_ms": encoded_ms - 60, "queued_ms": encoded_ms - 10, "encoded_ms": encoded_ms},
+                },
+            }
+        )
+        # Without utc_ms the node's stamps are uptime and cannot be compared with the bridge clock.
+        bridge.handle_envelope(
+            {
+                "bridge": BRIDGE_PROTOCOL,
+                "kind": "telemetry",
+                "payload": {"trace": {"id": 2, "acquired_ms": 900, "queued_ms": 1000, "encoded_ms": 1001}},
+            }
+        )
+        response = bridge.handle_envelope({"bridge": BRIDGE_PROTOCOL, "kind": "report", "sequence": 4})
+        latency = response["latency"]
+        self.assertEqual(response["mode"], "latency")
+        self.assertEqual(latency["sample"]["n"], 2)
+        self.assertEqual(latency["sample"]["max_us"], 100000)
+        self.assertEqual(latency["queue"]["mean_us"], 5500)
+        self.assertEqual(latency["node_to_bridge"]["n"], 1)
+        self.assertGreaterEqual(latency["node_to_bridge"]["max_us"], 40000)
+        self.assertEqual(latency["bridge"]["n"], 2)
+        self.assertEqual(latency["delivery"]["n"], 0)
+
+    def test_directed_receipt_records_delivery(self):
+        destination = "ab" * 16
+        FakeRNS.Transport.paths.add(bytes.fromhex(destination))
+        FakeReceiptPacket.receipts = []
+        bridge = make_bridge()
+        with patch.object(FakeRNS, "Destination", FakeDestination), patch.object(FakeRNS, "Packet", FakeReceiptPacket):
+            bridge.handle_envelope(
+                {"bridge": BRIDGE_PROTOCOL, "kind": "telemetry", "destination": destination, "payload": {"ok": True}}
+            )
+        self.assertEqual(bridge.latency_report()["delivery"]["n"], 0)
+        FakeReceiptPacket.receipts[0].callback(FakeReceiptPacket.receipts[0])
+        report = bridge.latency_report()
+        self.assertEqual(report["delivery"]["n"], 1)
+        self.assertEqual(sum(report["delivery"]["buckets"]), 1)
+
     def test_unsupported_request_type(self):
         bridge = make_bridge()
         with self.assertRaises(ValueError):
             bridge.handle_envelope({"bridge": BRIDGE_PROTOCOL, "kind": "shutdown"})
 
 
+class FrameDecoderTests(unittest.TestCase):
+    def test_keyframe_restores_payload_shape(self):
+        payload = AkitaFrameDecoder().decode(bytes.fromhex(KEYFRAME_HEX))
+        self.assertEqual(payload["node_id"], "AkitaCarNode")
+        self.assertEqual(payload["timestamp_ms"], 123456)
+        self.assertEqual(payload["board"], "Heltec LoRa 32 V2")
+        self.assertEqual(payload["obd"]["rpm"], 812.5)
+        self.assertEqual(payload["obd"]["coolant_c"], 88.0)
+        self.assertAlmostEqual(payload["gps"]["lat"], 45.421532, places=5)
+        self.assertAlmostEqual(payload["gps"]["lon"], -75.697189, places=5)
+        self.assertEqual(payload["gps"]["alt_m"], 70.3)
+        self.assertEqual(payload["gps"]["sats"], 9)
+        self.assertTrue(payload["system"]["lora_ready"])
+        self.assertTrue(payload["system"]["transport_ready"])
+        self.assertFalse(payload["system"]["wifi_ready"])
+        self.assertEqual(payload["system"]["free_heap"], 148 * 1024)
+
+    def test_deltas_apply_against_keyframe(self):
+        decoder = AkitaFrameDecoder()
+        decoder.decode(bytes.fromhex(KEYFRAME_HEX))
+        first = decoder.decode(bytes.fromhex(DELTA_HEX))
+        self.assertEqual(first["timestamp_ms"], 133470)
+        self.assertEqual(first["obd"]["rpm"], 2250.25)
+        self.assertEqual(first["obd"]["speed_kmh"], 54.0)
+        self.assertAlmostEqual(first["gps"]["lat"], 45.42271, places=5)
+        self.assertEqual(first["gps"]["speed_kmh"], 53.8)
+        self.assertEqual(first["gps"]["alt_m"], 70.3)
+
+        second = decoder.decode(bytes.fromhex(SECOND_DELTA_HEX))
+        self.assertEqual(second["timestamp_ms"], 143490)
+        self.assertEqual(second["obd"]["rpm"], 2400.0)
+        self.assertEqual(second["obd"]["coolant_c"], 90.0)
+        self.assertAlmostEqual(second["gps"]["lon"], -75.691999, places=5)
+        self.assertEqual(second["gps"]["alt_m"], 72.9)
+
+    def test_delta_against_earlier_acked_keyframe(self):
+        # The node keeps building deltas against the keyframe it last saw acknowledged while newer ones go unacked.
+        decoder = AkitaFrameDecoder()
+        keyframe = bytearray.fromhex(KEYFRAME_HEX)
+        decoder.decode(bytes(keyframe))
+        for sequence in range(1, FRAME_KEYFRAME_HISTORY):
+            keyframe[3] = sequence
+            decoder.decode(bytes(keyframe))
+        self.assertEqual(decoder.decode(bytes.fromhex(DELTA_HEX))["obd"]["rpm"], 2250.25)
+
+        keyframe[3] = FRAME_KEYFRAME_HISTORY
+        decoder.decode(bytes(keyframe))
+        with self.assertRaises(ValueError):
+            decoder.decode(bytes.fromhex(DELTA_HEX))
+
+    def test_event_frame_carries_rule_and_keyframe_readings(self):
+        decoder = AkitaFrameDecoder()
+        decoder.decode(bytes.fromhex(KEYFRAME_HEX))
+        payload = decoder.decode(bytes.fromhex(EVENT_HEX))
+        self.assertEqual(payload["event"], "coolant_hot")
+        self.assertEqual(payload["event_value"], 104.5)
+        self.assertEqual(payload["rule_id"], 2)
+        self.assertEqual(payload["timestamp_ms"], 123456 + 250)
+        self.assertEqual(payload["obd"]["rpm"], 812.5)
+
+    def test_geofence_event_frame_carries_fence(self):
+        decoder = AkitaFrameDecoder()
+        decoder.decode(bytes.fromhex(KEYFRAME_HEX))
+        name = b"geofence_dwell"
+        # Fence 300, dwell after 90.25 s inside.
+        frame = bytes.fromhex("1510e2010000") + bytes([0x82, 0x02, 0xAC, 0x02, 0x82, 0x8D, 0x01, len(name)]) + name
+        payload = decoder.decode(frame)
+        self.assertEqual(payload["event"], "geofence_dwell")
+        self.assertEqual(payload["geofence"], {"id": 300, "inside_ms": 90250})
+        self.assertNotIn("event_value", payload)
+
+    def test_event_without_keyframe_is_rejected(self):
+        with self.assertRaises(ValueError):
+            AkitaFrameDecoder().decode(bytes.fromhex(EVENT_HEX))
+
+    def test_delta_without_keyframe_is_rejected(self):
+        with self.assertRaises(ValueError):
+            AkitaFrameDecoder().decode(bytes.fromhex(DELTA_HEX))
+
+    def test_truncated_keyframe_is_rejected(self):
+        keyframe = bytes.fromhex(KEYFRAME_HEX)
+        with self.assertRaises(ValueError):
+            AkitaFrameDecoder().decode(keyframe[:-2])
+
+    def test_unknown_version_is_rejected(self):
+        with self.assertRaises(ValueError):
+            AkitaFrameDecoder().decode(bytes.fromhex("2810e200"))
+
+    def test_frame_envelope_forwards_decoded_json(self):
+        bridge = make_bridge()
+        bridge.handle_envelope({"bridge": BRIDGE_PROTOCOL, "kind": "frame", "frame": KEYFRAME_HEX})
+        response = bridge.handle_envelope(
+            {"bridge": BRIDGE_PROTOCOL, "kind": "frame", "sequence": 4, "frame": DELTA_HEX}
+        )
+        self.assertEqual(response["status"], "ok")
+        self.assertEqual(response["request"], "frame")
+        self.assertEqual(response["frame_bytes"], len(DELTA_HEX) // 2)
+        self.assertGreater(response["bytes"], response["frame_bytes"])
+
+    def test_frame_envelope_rejects_bad_hex(self):
+        bridge = make_bridge()
+        with self.assertRaises(ValueError):
+            bridge.handle_envelope({"bridge": BRIDGE_PROTOCOL, "kind": "frame", "frame": "zz"})
+
+
+class FragmentTests(unittest.TestCase):
+    def frame_request(self, bridge, frame_hex):
+        return bridge.handle_envelope({"bridge": BRIDGE_PROTOCOL, "kind": "frame", "frame": frame_hex})
+
+    def test_fragmented_keyframe_is_forwarded_once_complete(self):
+        bridge = make_bridge()
+        frames = fragment_frames(bytes.fromhex(KEYFRAME_HEX), 15)
+        self.assertEqual(len(frames), 3)
+        self.assertEqual(self.frame_request(bridge, frames[0])["mode"], "fragment_pending")
+        self.assertEqual(self.frame_request(bridge, frames[1])["missing"], [2])
+        response = self.frame_request(bridge, frames[2])
+        self.assertEqual(response["mode"], "broadcast")
+        self.assertEqual(response["fragments"], 3)
+        self.assertEqual(response["frame_bytes"], len(KEYFRAME_HEX) // 2)
+        self.assertEqual(bridge.frame_decoder.keyframes[0xE210][0]["vehicle_id"], "AkitaCarNode")
+        self.assertEqual(self.frame_request(bridge, frames[2])["mode"], "fragment_duplicate")
+
+    def test_gap_produces_selective_nack(self):
+        bridge = make_bridge()
+        frames = fragment_frames(bytes.fromhex(KEYFRAME_HEX), 10)
+        self.assertEqual(len(frames), 5)
+        self.frame_request(bridge, frames[0])
+        response = self.frame_request(bridge, frames[2])
+        self.assertEqual(response["nack"], "1410e207" + "0200")
+        response = self.frame_request(bridge, frames[4])
+        self.assertEqual(response["missing"], [1, 3])
+        self.assertEqual(response["nack"], "1410e207" + "0a00")
+        self.frame_request(bridge, frames[1])
+        self.assertEqual(self.frame_request(bridge, frames[3])["mode"], "broadcast")
+
+    def test_incomplete_message_expires(self):
+        now = [100.0]
+        reassembler = AkitaFragmentReassembler(timeout_seconds=20.0, clock=lambda: now[0])
+        frames = [bytes.fromhex(frame) for frame in fragment_frames(bytes.fromhex(KEYFRAME_HEX), 15)]
+        reassembler.push(frames[0])
+        now[0] += 21.0
+        reassembler.push(frames[1])
+        message, missing, nack = reassembler.push(frames[2])
+        self.assertIsNone(message)
+        self.assertEqual(missing, [0])
+        self.assertEqual(nack[4], 0x01)
+
+    def test_malformed_fragment_is_rejected(self):
+        bridge = make_bridge()
+        frame = fragment_frames(bytes.fromhex(KEYFRAME_HEX), 15)[0]
+        with self.assertRaises(ValueError):
+            self.frame_request(bridge, frame[:-2])
+
+
+class GatewayTests(unittest.TestCase):
+    def batch_request(self, bridge, frames, rssi=-97, snr_qdb=-22):
+        entries = [{"frame": frame, "rssi": rssi, "snr_qdb": snr_qdb, "age_ms": 40} for frame in frames]
+        return bridge.handle_envelope(
+            {
+                "bridge": BRIDGE_PROTOCOL,
+                "kind": "frames",
+                "sequence": 9,
+                "payload": {"gateway": "Gateway-1", "frames": entries},
+            }
+        )
+
+    def test_batch_forwards_frames_with_link_quality(self):
+        bridge = make_bridge()
+        with patch.object(bridge, "payload_bytes", wraps=bridge.payload_bytes) as payload_bytes:
+            response = self.batch_request(bridge, [KEYFRAME_HEX, DELTA_HEX])
+        self.assertEqual(response["mode"], "gateway")
+        self.assertEqual(response["forwarded"], 2)
+        self.assertEqual(response["errors"], 0)
+        self.assertEqual(payload_bytes.call_count, 2)
+        payload = payload_bytes.call_args.args[0]
+        self.assertEqual(payload["obd"]["rpm"], 2250.25)
+        self.assertEqual(payload["link"], {"gateway": "Gateway-1", "rssi": -97, "snr": -5.5})
+
+    def test_batch_forwards_event_frames(self):
+        bridge = make_bridge()
+        with patch.object(bridge, "payload_bytes", wraps=bridge.payload_bytes) as payload_bytes:
+            response = self.batch_request(bridge, [KEYFRAME_HEX, EVENT_HEX])
+        self.assertEqual(response["forwarded"], 2)
+        self.assertEqual(payload_bytes.call_args.args[0]["event"], "coolant_hot")
+
+    def test_keyframe_ack_request_returns_downlink_with_snr(self):
+        bridge = make_bridge()
+        response = self.batch_request(bridge, [KEYFRAME_HEX, DELTA_HEX])
+        self.assertEqual(response["downlinks"], ["1210e200ea"])
+
+    def test_fragments_reassemble_across_batches_and_nack_gaps(self):
+        bridge = make_bridge()
+        frames = fragment_frames(bytes.fromhex(KEYFRAME_HEX), 10)
+        response = self.batch_request(bridge, [frames[0], frames[2]])
+        self.assertEqual(response["pending"], 2)
+        self.assertEqual(response["downlinks"], ["1410e2070200"])
+        response = self.batch_request(bridge, [frames[1], frames[3], frames[4]])
+        self.assertEqual(response["forwarded"], 1)
+        self.assertEqual(response["pending"], 2)
+
+    def test_bad_frame_counts_as_error_without_failing_batch(self):
+        bridge = make_bridge()
+        response = self.batch_request(bridge, ["zz", DELTA_HEX, KEYFRAME_HEX, "1210e200ea"])
+        self.assertEqual(response["status"], "ok")
+        self.assertEqual(response["errors"], 2)
+        self.assertEqual(response["forwarded"], 1)
+
+    def test_batch_without_frames_is_rejected(self):
+        bridge = make_bridge()
+        with self.assertRaises(ValueError):
+            bridge.handle_envelope({"bridge": BRIDGE_PROTOCOL, "kind": "frames", "payload": {"gateway": "x"}})
+
+
+class SchemaTests(unittest.TestCase):
+    def test_generated_spec_matches_firmware_schema(self):
+        header = akita_schema_gen.SCHEMA_HEADER.read_text(encoding="utf-8")
+        rendered = akita_schema_gen.render_module(akita_schema_gen.parse_schema(header))
+        self.assertEqual(rendered, akita_schema_gen.SCHEMA_MODULE.read_text(encoding="utf-8"))
+
+    def test_frame_wire_ids_are_pinned(self):
+        # Released wire ids never move; a new field takes an unused flag bit or field index.
+        wire_ids = {field["id"]: (field["frame"] == "flag", field["wire"]) for field in TELEMETRY_FIELDS}
+        self.assertEqual(
+            wire_ids,
+            {
+                "OBD_CONNECTED": (True, 0),
+                "OBD_RPM": (False, 1),
+                "OBD_SPEED": (False, 2),
+                "OBD_COOLANT": (False, 3),
+                "GPS_FIX": (True, 1),
+                "GPS_LAT": (False, 4),
+                "GPS_LON": (False, 5),
+                "GPS_ALT": (False, 6),
+                "GPS_SPEED": (False, 7),
+                "GPS_SATS": (False, 8),
+                "CONFIG_PORTAL_READY": (True, 2),
+                "TRANSPORT_READY": (True, 3),
+                "WIFI_READY": (True, 4),
+                "LORA_READY": (True, 5),
+                "WIFI_RSSI": (False, 9),
+                "FREE_HEAP": (False, 10),
+            },
+        )
+
+    def test_reused_wire_id_is_rejected(self):
+        header = akita_schema_gen.SCHEMA_HEADER.read_text(encoding="utf-8")
+        with self.assertRaises(ValueError):
+            akita_schema_gen.parse_schema(header.replace("SCALE(2, 1), obd.speed_kmh", "SCALE(1, 1), obd.speed_kmh"))
+
+    def test_keyframe_covers_every_schema_field(self):
+        payload = AkitaFrameDecoder().decode(bytes.fromhex(KEYFRAME_HEX))
+        for field in TELEMETRY_FIELDS:
+            self.assertIn(field["name"], payload[field["group"]])
+
+
+def _square(fence_id, lat, lon, size, **properties):
+    ring = [[lon, lat], [lon + size, lat], [lon + size, lat + size], [lon, lat + size], [lon, lat]]
+    return {
+        "type": "Feature",
+        "properties": {"id": fence_id, **properties},
+        "geometry": {"type": "Polygon", "coordinates": [ring]},
+    }
+
+
+class GeofencePackTests(unittest.TestCase):
+    def test_image_layout_matches_firmware(self):
+        collection = {"features": [_square(7, 45.5, -73.56, 0.002, dwell_s=300), _square(9, 45.6, -73.5, 1.0, alert=True)]}
+        image = akita_geofence_pack.pack_geofences(collection)
+        magic, version, fences, vertices, size, crc, _ = akita_geofence_pack.HEADER.unpack_from(image)
+
+        self.assertEqual(akita_geofence_pack.HEADER.size, 24)
+        self.assertEqual(akita_geofence_pack.RECORD.size, 32)
+        self.assertEqual((magic, version, fences, vertices, size), (0x46474B41, 1, 2, 8, len(image)))
+        self.assertEqual(crc, zlib.crc32(image[24:]))
+
+        depot = akita_geofence_pack.RECORD.unpack_from(image, 24)
+        zone = akita_geofence_pack.RECORD.unpack_from(image, 56)
+        self.assertEqual(depot[:5], (7, 45500000, -73560000, 45502000, -73558000))
+        self.assertEqual(depot[5:10], (0, 4, 300, 0, 0))
+        # A degree across does not fit 16 bit offsets at full resolution, so it is stored at 16 microdegrees.
+        self.assertEqual(zone[0], 9)
+        self.assertEqual(zone[8:10], (akita_geofence_pack.GEOFENCE_FLAG_ALERT, 4))
+        self.assertEqual(akita_geofence_pack.VERTEX.unpack_from(image, 88 + 1 * 4), (0, 2000))
+        self.assertEqual(akita_geofence_pack.VERTEX.unpack_from(image, 88 + 6 * 4), (62500, 62500))
+
+    def test_invalid_fences_are_rejected(self):
+        with self.assertRaises(ValueError):
+            akita_geofence_pack.pack_geofences({"features": [_square(0, 45.5, -73.56, 0.002)]})
+        hole = _square(3, 45.5, -73.56, 0.002)
+        hole["geometry"]["coordinates"].append(hole["geometry"]["coordinates"][0])
+        with self.assertRaises(ValueError):
+            akita_geofence_pack.pack_geofences({"features": [hole]})
+        with self.assertRaises(ValueError):
+            akita_geofence_pack.pack_geofences({"features": [_square(3, 45.5, -73.56, 0.002)] * 1025})
+
+
+def _timeline_dump() -> bytes:
+    convert = akita_timeline_convert
+    names = ["main_poll", "main_stall", "outbox_depth", "gps_ingest"]
+    tasks = [(0x3FC0, "akita_main"), (0x3FD0, "akita_uplink")]
+    core0 = [
+        (100, 0x3FC0, 0, 0, convert.TYPE_BEGIN, 0),
+        (0xFFFFFFF0, 0, 5_000_000, 0, convert.TYPE_SYNC, 0),
+        (0x000000E0, 0x3FC0, 0, 0, convert.TYPE_BEGIN, 0),
+        (0xFFFFFF00, 0x3FC0, 480, 3, convert.TYPE_COMPLETE, 0),
+        (0x000001D0, 0x3FC0, 0, 0, convert.TYPE_END, 0),
+        (0x000002C0, 0x3FC0, 250, 1, convert.TYPE_INSTANT, convert.TIMELINE_FLAG_TRIGGER),
+    ]
+    core1 = [
+        (1000, 0, 5_000_010, 0, convert.TYPE_SYNC, 0),
+        (1240, 0, 4, 2, convert.TYPE_COUNTER, 0),
+    ]
+    data = convert.HEADER.pack(b"AKTL", 1, 2, 240, 512, len(names), len(tasks))
+    data += b"".join(bytes([len(name)]) + name.encode() for name in names)
+    data += b"".join(handle.to_bytes(4, "little") + bytes([len(name)]) + name.encode() for handle, name in tasks)
+    for core, events in enumerate((core0, core1)):
+        data += convert.CORE.pack(core, 0, len(events))
+        data += b"".join(convert.EVENT.pack(*event) for event in events)
+    return data
+
+
+class TimelineConvertTests(unittest.TestCase):
+    def test_dump_converts_to_chrome_trace(self):
+        trace = akita_timeline_convert.convert(_timeline_dump())
+        metadata = [event for event in trace["traceEvents"] if event["ph"] == "M"]
+        events = [event for event in trace["traceEvents"] if event["ph"] != "M"]
+
+        self.assertEqual(akita_timeline_convert.EVENT.size, 16)
+        self.assertEqual({event["args"]["name"] for event in metadata}, {"akita-carnode", "akita_main", "core 1"})
+        # The begin before the first sync point cannot be placed and is dropped; the cycle counter wraps after it.
+        self.assertEqual([(event["ph"], event["name"], event["ts"]) for event in events], [
+            ("X", "gps_ingest", 4_999_999.0),
+            ("B", "main_poll", 5_000_001.0),
+            ("E", "main_poll", 5_000_002.0),
+            ("i", "main_stall", 5_000_003.0),
+            ("C", "outbox_depth", 5_000_011.0),
+        ])
+        self.assertEqual(events[0]["dur"], 2.0)
+        self.assertEqual(events[1]["tid"], 0x3FC0)
+        self.assertEqual((events[3]["s"], events[3]["args"]["value"]), ("g", 250))
+        self.assertEqual((events[4]["tid"], events[4]["args"]), (1, {"value": 4}))
+
+    def test_console_log_and_bad_dumps(self):
+        dump = _timeline_dump()
+        hex_text = dump.hex()
+        lines = ["I (120) akita: noise", "akita-timeline: begin"]
+        lines += [f"akita-timeline: {hex_text[index:index + 96]}" for index in range(0, len(hex_text), 96)]
+        lines += ["akita-timeline: end", "akita-timeline: begin", "akita-timeline: 414b"]
+
+        self.assertEqual(akita_timeline_convert.dump_from_log("\n".join(lines)), dump)
+        with self.assertRaises(ValueError):
+            akita_timeline_convert.dump_from_log("akita-timeline: begin\n")
+        with self.assertRaises(ValueError):
+            akita_timeline_convert.convert(dump[:-4])
+        with self.assertRaises(ValueError):
+            akita_timeline_convert.convert(b"XXXX" + dump[4:])
+
+
+class BenchCompareTests(unittest.TestCase):
+    def test_slowdown_and_stack_growth_regress(self):
+        baseline = {
+            "nmea_feed": {"name": "nmea_feed", "ns_per_op": 500.0, "stack_bytes": 1848},
+            "payload_json": {"name": "payload_json", "ns_per_op": 400.0, "stack_bytes": 1064},
+            "form_lookup": {"name": "form_lookup", "ns_per_op": 12000.0, "stack_bytes": 2360},
+        }
+        current = {
+            "nmea_feed": {"name": "nmea_feed", "ns_per_op": 540.0, "stack_bytes": 1848},
+            "payload_json": {"name": "payload_json", "ns_per_op": 380.0, "stack_bytes": 1128},
+            "form_lookup": {"name": "form_lookup", "ns_per_op": 14000.0, "stack_bytes": 2360},
+        }
+
+        lines, regressions = akita_bench_compare.compare(baseline, current, 0.10, 0)
+        self.assertEqual(len(lines), 3)
+        self.assertEqual(regressions, ["payload_json", "form_lookup"])
+        _, regressions = akita_bench_compare.compare(baseline, current, 0.20, 64)
+        self.assertEqual(regressions, [])
+
+    def test_dropped_case_regresses(self):
+        baseline = {"obd_parse_response": {"name": "obd_parse_response", "ns_per_op": 120.0, "stack_bytes": 480}}
+        _, regressions = akita_bench_compare.compare(baseline, {}, 0.10, 0)
+        self.assertEqual(regressions, ["obd_parse_response"])
+
+    def test_changed_replay_digest_regresses(self):
+        baseline = {"replay_gps": {"name": "replay_gps", "ns_per_op": 650.0, "digest": "62fbdd8e31ab64ce"}}
+        same = {"replay_gps": {"name": "replay_gps", "ns_per_op": 640.0, "digest": "62fbdd8e31ab64ce"}}
+        changed = {"replay_gps": {"name": "replay_gps", "ns_per_op": 600.0, "digest": "0000000000000001"}}
+
+        _, regressions = akita_bench_compare.compare(baseline, same, 0.10, 0)
+        self.assertEqual(regressions, [])
+        lines, regressions = akita_bench_compare.compare(baseline, changed, 0.10, 0)
+        self.assertEqual(regressions, ["replay_gps"])
+        self.assertIn("OUTPUT CHANGED", lines[0])
+
+
+def _varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _capture(records, start_us=1_000_000, gps_baud=9600):
+    data = bytearray(akita_capture_convert.HEADER.pack(b"AKCP", 1, 0, start_us, gps_baud))
+    last_us = start_us
+    for tag, at_us, payload in records:
+        delta = at_us - last_us
+        data += bytes([tag]) + _varint((delta << 1) ^ (delta >> 63)) + _varint(len(payload)) + payload
+        last_us = at_us
+    return bytes(data)
+
+
+class CaptureConvertTests(unittest.TestCase):
+    def test_parses_records_and_extracts_streams(self):
+        data = _capture(
+            [
+                (1, 1_064_000, b"$GPRMC,140231.00,V"),
+                (2, 1_000_000, b""),
+                (3, 1_070_000, b"010C\r"),
+                (4, 1_110_000, b"410C0B"),
+                (4 | 0x10, 1_115_000, b"B8\r\r>"),
+                (1, 1_164_000, b",,,*74\r\n"),
+            ]
+        ) + b"\xff" * 8
+
+        header, records = akita_capture_convert.parse(data)
+        self.assertEqual(header["gps_baud"], 9600)
+        self.assertEqual(header["length"], len(data) - 8)
+        self.assertEqual([record["at_us"] for record in records], [1_064_000, 1_000_000, 1_070_000, 1_110_000, 1_115_000, 1_164_000])
+        self.assertEqual(records[4]["flags"], akita_capture_convert.FLAG_FORCE)
+        self.assertEqual(akita_capture_convert.to_nmea(records), b"$GPRMC,140231.00,V,,,*74\r\n")
+        self.assertEqual(akita_capture_convert.to_elm(records).splitlines()[1], "010C\t410C0BB8\\r\\r>")
+        summary = akita_capture_convert.summarize(header, records)
+        self.assertEqual(summary["records"], 6)
+        self.assertEqual(summary["sources"]["obd_rx"], {"records": 2, "bytes": 11})
+        self.assertEqual(summary["span_s"], 0.164)
+
+    def test_stops_at_a_record_cut_short(self):
+        data = _capture([(1, 1_000_100, b"$GPGGA"), (1, 1_000_200, b"$GPRMC,140231")])
+
+        header, records = akita_capture_convert.parse(data[:-3])
+        self.assertEqual(len(records), 1)
+        self.assertEqual(header["length"], akita_capture_convert.HEADER.size + 4 + 6)
+        with self.assertRaises(ValueError):
+            akita_capture_convert.parse(b"AKTL" + data[4:])
+
+
 if __name__ == "__main__":
     raise SystemExit(unittest.main())